@@ -106,6 +106,18 @@ inline bool IsYUV444Format(NV_ENC_BUFFER_FORMAT dwFormat)
        return false;
 }
 
+// 10-bit formats (P010 / YUV444_10BIT) use 16 bits per sample (NVENC 7.0 API)
+inline bool IsYUV10BitFormat(NV_ENC_BUFFER_FORMAT dwFormat)
+{
+#if NVENCAPI_MAJOR_VERSION >= 7
+   if (dwFormat == NV_ENC_BUFFER_FORMAT_YUV420_10BIT || dwFormat == NV_ENC_BUFFER_FORMAT_YUV444_10BIT)
+   {
+       return true;
+   }
+#endif
+   return false;
+}
+
 
 inline void CvtToTiled16x16(unsigned char *tile, unsigned char *src, 
                             unsigned int width, unsigned int height, 
@@ -22,6 +22,8 @@
 #ifndef _NV_OSAL_NV_THREADING_CLASSES_H
 #define _NV_OSAL_NV_THREADING_CLASSES_H
 
+#include <atomic>
+
 #include <threads/NvThreading.h>
 
 //! Mutex class.
@@ -585,6 +587,247 @@ U32 CNvQueue<T, L>::GetCount()
     return m_uCount;
 }
 
+//! Lock-free single-producer/single-consumer ring with the \e CNvQueue interface.
+//! Use it in place of \e CNvQueue where exactly one thread adds and exactly one
+//! thread removes (they may be the same thread): an Add() or Remove() is then a
+//! load and a store of the ring indices, which live on separate cache lines, and
+//! no mutex or semaphore. A thread only blocks (on a \e CNvEvent) when the ring
+//! is genuinely full or empty, and the other side only signals that event when a
+//! thread is waiting on it.
+template<class T, U32 L>
+class CNvRing {
+public:
+    //! Create a ring of size \e uSize.
+    CNvRing(U32 uSize = L);
+
+    ~CNvRing();
+
+    //! Add an element to the ring (producer thread only). This call will block
+    //! for up to \e uTimeoutMs if the ring is full.
+    //! \retval true The item was added to the ring.
+    //! \retval false The item was not added to the ring (timeout).
+    bool Add(const T&, U32 uTimeoutMs = INvThreading::NV_TIMEOUT_INFINITE);
+
+    //! Remove an item from the ring (consumer thread only). This call will block
+    //! for up to \e uTimeoutMs or until a new item arrives in the ring.
+    //! \retval true An item was removed from the ring.
+    //! \retval false A timeout occured and no item was removed.
+    bool Remove(T&, U32 uTimeoutMs = 0);
+
+    //! Peek at the item at the head of the ring (consumer thread only).
+    //! \retval true There was something at the head.
+    //! \retval false The ring is empty.
+    bool Peek(T&);
+
+    //! Pop the first item off the ring (consumer thread only).
+    //! \retval true An item was popped of the front of the ring.
+    //! \retval false The ring is empty.
+    bool Pop();
+
+    //! Clear all items in the ring (consumer thread only).
+    void Clear();
+
+    //! Get the number of items in the ring. The same warning as for
+    //! \e CNvQueue::GetCount() applies: useful only for logging, debugging
+    //! and throttling heuristics.
+    U32 GetCount();
+
+private:
+    enum { CACHE_LINE_SIZE = 64 };
+
+    CNvRing(const CNvRing&);
+    CNvRing& operator=(const CNvRing&);
+
+    bool WaitNotFull(U32 uWriteIndex, U32 uTimeoutMs);
+    bool WaitNotEmpty(U32 uReadIndex, U32 uTimeoutMs);
+
+    // read-only after construction
+    T* m_pBuffer;
+    U32 m_uSize;
+    U32 m_uMask;        // slots - 1 (the slot count is m_uSize rounded up to a power of two)
+
+    CNvEvent m_EventNotFull;
+    CNvEvent m_EventNotEmpty;
+
+    char m_Pad0[CACHE_LINE_SIZE];
+
+    // written by the producer
+    std::atomic<U32> m_uWriteIndex;
+    U32 m_uReadIndexCache; // producer's last view of m_uReadIndex
+
+    char m_Pad1[CACHE_LINE_SIZE];
+
+    // written by the consumer
+    std::atomic<U32> m_uReadIndex;
+    U32 m_uWriteIndexCache; // consumer's last view of m_uWriteIndex
+
+    char m_Pad2[CACHE_LINE_SIZE];
+
+    // written only on the (rare) blocking path
+    std::atomic<bool> m_bProducerWaiting;
+    std::atomic<bool> m_bConsumerWaiting;
+
+    char m_Pad3[CACHE_LINE_SIZE];
+};
+
+template<class T, U32 L>
+CNvRing<T, L>::CNvRing(U32 uSize) :
+    m_uSize(uSize),
+    m_EventNotFull(false, false),
+    m_EventNotEmpty(false, false),
+    m_uWriteIndex(0),
+    m_uReadIndexCache(0),
+    m_uReadIndex(0),
+    m_uWriteIndexCache(0),
+    m_bProducerWaiting(false),
+    m_bConsumerWaiting(false)
+{
+    assert(m_uSize);
+    U32 uSlots = 1;
+    while (uSlots < m_uSize) {
+        uSlots <<= 1;
+    }
+    m_uMask = uSlots - 1;
+    m_pBuffer = new T[uSlots];
+}
+
+template<class T, U32 L>
+CNvRing<T, L>::~CNvRing()
+{
+    delete[] m_pBuffer;
+}
+
+// The index counters run freely (they are not wrapped at m_uSize), so
+// uWrite - uRead is the item count even across the 2^32 wrap-around.
+//
+// Blocking: the waiting side raises its flag, then re-checks the index; the
+// other side publishes the index, then checks the flag. A full fence between
+// the store and the load on both sides means at least one of them sees the
+// other, so a wake-up is never lost. A stale (auto-reset) signal only costs a
+// re-check.
+
+template<class T, U32 L>
+bool CNvRing<T, L>::WaitNotFull(U32 uWriteIndex, U32 uTimeoutMs)
+{
+    for (;;) {
+        m_bProducerWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_uReadIndexCache = m_uReadIndex.load(std::memory_order_acquire);
+        if (uWriteIndex - m_uReadIndexCache < m_uSize || !m_EventNotFull.Wait(uTimeoutMs)) {
+            break;
+        }
+    }
+    m_bProducerWaiting.store(false, std::memory_order_relaxed);
+    m_uReadIndexCache = m_uReadIndex.load(std::memory_order_acquire);
+    return uWriteIndex - m_uReadIndexCache < m_uSize;
+}
+
+template<class T, U32 L>
+bool CNvRing<T, L>::WaitNotEmpty(U32 uReadIndex, U32 uTimeoutMs)
+{
+    for (;;) {
+        m_bConsumerWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_uWriteIndexCache = m_uWriteIndex.load(std::memory_order_acquire);
+        if (m_uWriteIndexCache != uReadIndex || !m_EventNotEmpty.Wait(uTimeoutMs)) {
+            break;
+        }
+    }
+    m_bConsumerWaiting.store(false, std::memory_order_relaxed);
+    m_uWriteIndexCache = m_uWriteIndex.load(std::memory_order_acquire);
+    return m_uWriteIndexCache != uReadIndex;
+}
+
+template<class T, U32 L>
+bool CNvRing<T, L>::Add(const T& Item, U32 uTimeoutMs)
+{
+    const U32 uWriteIndex = m_uWriteIndex.load(std::memory_order_relaxed);
+
+    if (uWriteIndex - m_uReadIndexCache >= m_uSize) {
+        m_uReadIndexCache = m_uReadIndex.load(std::memory_order_acquire);
+        if (uWriteIndex - m_uReadIndexCache >= m_uSize) {
+            if (uTimeoutMs == 0 || !WaitNotFull(uWriteIndex, uTimeoutMs)) {
+                return false;
+            }
+        }
+    }
+
+    m_pBuffer[uWriteIndex & m_uMask] = Item;
+    m_uWriteIndex.store(uWriteIndex + 1, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_bConsumerWaiting.load(std::memory_order_relaxed)) {
+        m_EventNotEmpty.Set();
+    }
+
+    return true;
+}
+
+template<class T, U32 L>
+bool CNvRing<T, L>::Remove(T& Item, U32 uTimeoutMs)
+{
+    if (!Peek(Item)) {
+        const U32 uReadIndex = m_uReadIndex.load(std::memory_order_relaxed);
+        if (uTimeoutMs == 0 || !WaitNotEmpty(uReadIndex, uTimeoutMs)) {
+            return false;
+        }
+        Item = m_pBuffer[uReadIndex & m_uMask];
+    }
+
+    return Pop();
+}
+
+template<class T, U32 L>
+bool CNvRing<T, L>::Peek(T& Item)
+{
+    const U32 uReadIndex = m_uReadIndex.load(std::memory_order_relaxed);
+
+    if (m_uWriteIndexCache == uReadIndex) {
+        m_uWriteIndexCache = m_uWriteIndex.load(std::memory_order_acquire);
+        if (m_uWriteIndexCache == uReadIndex) {
+            return false;
+        }
+    }
+
+    Item = m_pBuffer[uReadIndex & m_uMask];
+    return true;
+}
+
+template<class T, U32 L>
+bool CNvRing<T, L>::Pop()
+{
+    const U32 uReadIndex = m_uReadIndex.load(std::memory_order_relaxed);
+
+    if (m_uWriteIndexCache == uReadIndex) {
+        m_uWriteIndexCache = m_uWriteIndex.load(std::memory_order_acquire);
+        if (m_uWriteIndexCache == uReadIndex) {
+            return false;
+        }
+    }
+
+    m_uReadIndex.store(uReadIndex + 1, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_bProducerWaiting.load(std::memory_order_relaxed)) {
+        m_EventNotFull.Set();
+    }
+
+    return true;
+}
+
+template<class T, U32 L>
+void CNvRing<T, L>::Clear()
+{
+    while (Pop()) {
+    }
+}
+
+template<class T, U32 L>
+U32 CNvRing<T, L>::GetCount()
+{
+    return m_uWriteIndex.load(std::memory_order_acquire) - m_uReadIndex.load(std::memory_order_acquire);
+}
+
 //! Worker thread class that binds a thread and a single queue.
 template<class T, U32 L>
 class CNvWorkerThread : private CNvThread {
@@ -72,7 +72,11 @@
 #include "guidutil2.h"
 
 #include <cuda.h>
-#include "crepackyuv.h"  // _convert_YUV420toNV12(), _convert_YUV444toY444, ...
+#include "crepackyuv_mt.h"  // _convert_YUV420toNV12(), _convert_YUV444toY444, ...
+#include "cnvenctelemetry.h"
+#include "clookahead.h"
+#include "cnvenctwopass.h"
+#include "cspillcache.h"
 
 #define MAX_ENCODERS 16
 
@@ -82,6 +86,11 @@
 
 #define MAX_INPUT_QUEUE  32
 #define MAX_OUTPUT_QUEUE 32
+
+// bitstream-buffer pool (see CNvEncoder::CalculateMaxFrameSize)
+#define BITSTREAM_POOL_MIN_SIZE  (256*1024) // smallest bitstream-buffer (bytes)
+#define BITSTREAM_POOL_ALIGN     (64*1024)  // bitstream-buffer sizes are rounded up to a multiple of this
+#define BITSTREAM_POOL_HEADROOM  4          // grow the pool when a frame fills more than 3/4 of its buffer
 #define SET_VER(configStruct, type) {configStruct.version = type##_VER;}
 
 // {00000000-0000-0000-0000-000000000000}
@@ -106,6 +115,7 @@ typedef void * HANDLE;
 #define FILE_BEGIN               SEEK_SET
 #define INVALID_SET_FILE_POINTER (-1)
 #define S_OK                     (0)
+#define S_FALSE                  (1)
 #define E_FAIL                   (-1)
 #endif
 
@@ -177,6 +187,7 @@ typedef struct {
 	int value_NV_ENC_CAPS_SUPPORT_LOSSLESS_ENCODE;
 	int value_NV_ENC_CAPS_SUPPORT_SAO;
 	int value_NV_ENC_CAPS_SUPPORT_MEONLY_MODE;
+	int value_NV_ENC_CAPS_SUPPORT_10BIT_ENCODE; // NVENC 7.0 API (always 0 with older SDK)
 } nv_enc_caps_s;
 
 typedef struct {
@@ -323,7 +334,9 @@ typedef enum { // updated for NVENC SDK 5.0 (Dec 2014)
     NV_ENC_H264_PROFILE_STEREO  = 128,
 	NV_ENC_H264_PROFILE_HIGH_444 = 244,
 	NV_ENC_H264_PROFILE_CONSTRAINED_HIGH = 257,
-	NV_ENC_HEVC_PROFILE_MAIN     = 300
+	NV_ENC_HEVC_PROFILE_MAIN     = 300,
+	NV_ENC_HEVC_PROFILE_MAIN10   = 301,
+	NV_ENC_HEVC_PROFILE_FREXT    = 302
 } enum_NV_ENC_H264_PROFILE;
 
 const guid_desc codecprofile_names[] =  // updated for NVENC SDK 5.0 (Dec 2014)
@@ -337,6 +350,11 @@ const guid_desc codecprofile_names[] =  // updated for NVENC SDK 5.0 (Dec 2014)
     { NV_ENC_H264_PROFILE_HIGH_444_GUID,        "H.264 444 Profile", NV_ENC_H264_PROFILE_HIGH_444 }, // NVENC 4.0 API
     { NV_ENC_H264_PROFILE_CONSTRAINED_HIGH_GUID,"H.264 Constrained High Profile", NV_ENC_H264_PROFILE_CONSTRAINED_HIGH },
 	{ NV_ENC_HEVC_PROFILE_MAIN_GUID,            "H.265 Main Profile", NV_ENC_HEVC_PROFILE_MAIN } // NVENC 5.0 API
+#if NVENCAPI_MAJOR_VERSION >= 7
+	,
+	{ NV_ENC_HEVC_PROFILE_MAIN10_GUID,          "H.265 Main10 Profile", NV_ENC_HEVC_PROFILE_MAIN10 }, // NVENC 7.0 API
+	{ NV_ENC_HEVC_PROFILE_FREXT_GUID,           "H.265 FREXT Profile", NV_ENC_HEVC_PROFILE_FREXT } // NVENC 7.0 API
+#endif
 };
 
 const guid_desc preset_names[] =  // updated for NVENC SDK 4.0 (Aug 2014)
@@ -643,6 +661,7 @@ struct EncodeConfig
     //NV_ENC_BUFFER_FORMAT      chromaFormatIDC;// chroma format (typo, wrong typedef?)
 	cudaVideoChromaFormat     chromaFormatIDC;// chroma format
 	unsigned int              separateColourPlaneFlag; // (for YUV444 only)
+	unsigned int              pixelBitDepthMinus8; // 0=8bit, 2=10bit (H.265 only, requires NVENC 7.0 API)
     unsigned int              output_sei_BufferPeriod;
     NV_ENC_MV_PRECISION       mvPrecision; // 1=FULL_PEL, 2=HALF_PEL, 3= QUARTER_PEL
     int                       output_sei_PictureTime;
@@ -685,6 +704,9 @@ struct EncodeConfig
 	// CPU control flags
 	bool					  CPU_enableAVX; // allow repacker to use AVX-instructions
 	bool					  CPU_enableAVX2;// allow repacker to use AVX2-instructions
+	bool					  CPU_enableAVX512;// allow repacker to use AVX512(BW+VL)-instructions
+	unsigned int              CPU_numThreads;// #threads for repacker (0=auto, 1=single-threaded)
+	unsigned int              CPU_lookahead; // (#frames) CPU lookahead: scene-cut IDRs + complexity hints (0=off, EncodeFramePPro only)
 
 	void print(string &stringout) const;
 };
@@ -715,6 +737,34 @@ struct EncodeOutputBuffer
     void             *pBitstreamBufferPtr;
     bool             bEOSFlag;
     bool             bDynResChangeFlag;
+    U64              qwSubmitTime;   // NvQueryPerformanceCounter() when queued to the output-thread (completion latency)
+    unsigned int     *pSliceOffsets; // reportSliceOffsets: NV_ENC_LOCK_BITSTREAM::sliceOffsets, preallocated by AllocateIOBuffers()
+    unsigned int     dwMaxSlices;    // #entries in pSliceOffsets
+    U64              qwConvertTicks; // (telemetry) input-surface lock + pixel-format conversion of its picture
+    U64              qwSubmitTicks;  // (telemetry) nvEncEncodePicture() of its picture
+};
+
+// per-frame completion latency: from the nvEncEncodePicture() which made a bitstream-buffer
+// pending, until its bitstream was available to the output-thread (all times in microseconds)
+struct EncodeCompletionStats
+{
+    unsigned int     frames;
+    double           total_us;
+    double           max_us;
+    double           last_us;
+};
+
+// bitstream-buffer pool: size, and utilization (coded frame size / bitstream-buffer size)
+struct EncodeBitstreamPoolStats
+{
+    unsigned int     buffers;           // #bitstream-buffers
+    unsigned int     initial_size;      // bytes, from CNvEncoder::CalculateMaxFrameSize()
+    unsigned int     buffer_size;       // bytes, current size (the pool only grows)
+    unsigned int     grow_count;        // #times buffer_size was raised
+    unsigned int     frames;
+    unsigned int     peak_frame_bytes;  // largest coded frame
+    double           peak_utilization;  // 0.0 .. 1.0
+    double           total_utilization; // summed over the frames (average = total_utilization / frames)
 };
 
 struct EncoderThreadData
@@ -723,6 +773,16 @@ struct EncoderThreadData
     EncodeInputSurfaceInfo  *pInputBfr;
 };
 
+// a converted frame held back by the CPU lookahead, until its scene-cut decision
+struct EncodeLookaheadFrame
+{
+    EncodeInputSurfaceInfo  *pInputBfr;
+    EncodeOutputBuffer      *pOutputBfr;
+    NV_ENC_PIC_STRUCT        pictureStruct;
+};
+
+#define LOOKAHEAD_HINT_HISTORY 64 // lookahead hints kept for GetLookaheadHint() (> frames in flight)
+
 #define DYN_DOWNSCALE 1
 #define DYN_UPSCALE   2
 
@@ -745,6 +805,10 @@ struct EncodeFrameConfig
 	bool         ppro_pixelformat_is_yuyv422;// yuv 4:2:2 8bit (16bpp)
 	bool         ppro_pixelformat_is_yuv444; // yuv 4:4:4 8bit (32bpp)
 	bool         ppro_pixelformat_is_rgb444f;// rgba 32float  (128bpp)
+	bool         ppro_pixelformat_is_rgb444_8u; // bgra 8bit  (32bpp)
+	bool         ppro_pixelformat_is_rgb444_16u;// bgra 16bit (64bpp, 0-32768)
+	bool         ppro_pixelformat_is_v410;   // yuv 4:4:4 10bit (32bpp)
+	bool         ppro_pixelformat_is_v210;   // yuv 4:2:2 10bit (v210: 128 bits per 6 pixels)
 };
 
 struct FrameThreadData
@@ -820,8 +884,8 @@ public: // temp-hack
     EncodeConfig                                         m_stEncoderInput;
     EncodeInputSurfaceInfo                               m_stInputSurface[MAX_INPUT_QUEUE];
     EncodeOutputBuffer                                   m_stBitstreamBuffer[MAX_OUTPUT_QUEUE];
-    CNvQueue<EncodeInputSurfaceInfo*, MAX_INPUT_QUEUE>   m_stInputSurfQueue;
-    CNvQueue<EncodeOutputBuffer*, MAX_OUTPUT_QUEUE>      m_stOutputSurfQueue;
+    CNvRing<EncodeInputSurfaceInfo*, MAX_INPUT_QUEUE>    m_stInputSurfQueue;
+    CNvRing<EncodeOutputBuffer*, MAX_OUTPUT_QUEUE>       m_stOutputSurfQueue;
     unsigned int                                         m_dwMaxSurfCount;
     unsigned int                                         m_dwCurrentSurfIdx;
     unsigned int                                         m_dwFrameWidth;
@@ -836,10 +900,58 @@ public: // temp-hack
     unsigned char                                        m_pUserData[128];
     NV_ENC_SEQUENCE_PARAM_PAYLOAD                        m_spspps;
     EncodeOutputBuffer                                   m_stEOSOutputBfr; 
-    CNvQueue<EncoderThreadData, MAX_OUTPUT_QUEUE>        m_pEncodeFrameQueue;
+    CNvRing<EncoderThreadData, MAX_OUTPUT_QUEUE>         m_pEncodeFrameQueue;
+
+	// info about the bitstream-buffer currently being passed to m_fwrite_callback
+	//  (lets the callback (i.e. an MP4 muxer) timestamp the access-unit.)
+	int64_t                                              m_lastOutputTimeStamp; // outputTimeStamp (display frame#), -1 = unknown
+	NV_ENC_PIC_TYPE                                      m_lastOutputPicType;
 
 public:
     virtual void                                         UseExternalCudaContext(const CUcontext context, const unsigned int deviceID);
+
+	// UseSoftwareEncodeAPI() - CNvEncoder objects constructed after this call (with enable=true) are bound to
+	//   the software stand-in for the NVENC driver (cnvencsim.h) instead of nvEncodeAPI64.dll, and never
+	//   touch CUDA.  For benchmarking the encoder's host-side pipeline on machines without an NVIDIA GPU.
+	static void                                          UseSoftwareEncodeAPI(const bool enable);
+
+	// GetCompletionStats() - completion latency of the frames written out so far (safe to call while encoding)
+	void                                                 GetCompletionStats(EncodeCompletionStats &stats) const;
+
+	// CalculateMaxFrameSize() - worst-case size (bytes) of one coded frame, from the rate-control mode,
+	//   vbvBufferSize, level and resolution of the EncodeConfig.  This is the initial size of the bitstream-buffers.
+	static unsigned int                                  CalculateMaxFrameSize(const EncodeConfig &config);
+	// CalculateMaxSliceCount() - most slices a coded frame of the EncodeConfig can have (sliceMode/sliceModeData)
+	static unsigned int                                  CalculateMaxSliceCount(const EncodeConfig &config);
+	void                                                 GetBitstreamPoolStats(EncodeBitstreamPoolStats &stats) const;
+
+	// GetTelemetry() - per-frame records (picture type, size, QP, pipeline timing) and histograms of the
+	//   current (or last) encode-job, written by the output-thread.  Reset by InitializeEncoderCodec().
+	const CNvEncTelemetry &                              GetTelemetry() const { return m_Telemetry; }
+
+	// CalculateLookaheadDepth() - #frames the CPU lookahead holds back: CPU_lookahead, limited by
+	//   the input-surfaces left over (MAX_INPUT_QUEUE) after the B-frames and the output pipeline
+	static unsigned int                                  CalculateLookaheadDepth(const EncodeConfig &config);
+	// GetLookaheadHint() - scene-cut decision and complexity hint of a recently submitted frame
+	//   (display frame#, the last LOOKAHEAD_HINT_HISTORY frames), e.g. for bitrate shaping with
+	//   ReconfigureEncoder().  false if the lookahead is off, or the frame isn't (or no longer) known.
+	bool                                                 GetLookaheadHint(const unsigned int dwFrameNum, lookahead_hint_t &hint) const;
+
+	// GetTwoPass() - two-pass bitrate allocation.  While it is active (BeginPass1() or Plan()), the
+	//   output-thread passes each coded frame to it.  The caller drives pass 2 with ReconfigureEncoder().
+	CNvEncTwoPass &                                      GetTwoPass() { return m_TwoPass; }
+	// SetTwoPassAnalysisConfig() - pass 1: constant QP (TWOPASS_PASS1_QP)
+	static void                                          SetTwoPassAnalysisConfig(EncodeConfig &config);
+	// SetTwoPassSegmentConfig() - pass 2: a segment's settings (for ReconfigureEncoder()).  constQP: the
+	//   segment's QP, otherwise its bitrate (and the segment's QP as the initial QP)
+	static void                                          SetTwoPassSegmentConfig(EncodeConfig &config, const twopass_rate_t &rate);
+
+	// SetSpillCache() - while cache->IsRecording(), EncodeFramePPro() writes each converted input-surface
+	//   to it (two-pass export: pass 1.)  NULL = none.  The caller owns the cache.
+	void                                                 SetSpillCache(CSpillCache *cache) { m_pSpillCache = cache; }
+	// EncodeSpilledFrame() - encode the next frame played back by the spill cache, instead of a rendered
+	//   frame (pEncodeFrame: only the field-mode is used.)  S_FALSE = the cache has no frame left: render it.
+	HRESULT                                              EncodeSpilledFrame(const EncodeFrameConfig *pEncodeFrame);
     virtual HRESULT                                      OpenEncodeSession(const EncodeConfig encodeConfig, const unsigned int deviceID, NVENCSTATUS &nvencstatus);
 
 	// QueryEncodeSession() : opens a new encode-session to get its capabilities and return it to the caller.
@@ -853,6 +965,9 @@ public:
 	void                                                 set_color_metadata(const CNvEncoder_color_s c); // should be called at same time as InitializeEncoderCodec
 	//virtual HRESULT                                      EncodeFrame(EncodeFrameConfig *pEncodeFrame, bool bFlush = false) = 0;
 	virtual HRESULT                                      EncodeFramePPro(EncodeFrameConfig *pEncodeFrame, const bool bFlush) = 0;
+	// ReconfigureEncoder() - new rate-control settings (bitrate, VBV, constQP/initial QP) for the following
+	//   frames.  Resets the encoder: the next frame starts a new GOP.
+	virtual HRESULT                                      ReconfigureEncoder(EncodeConfig EncoderReConfig) = 0;
     virtual HRESULT                                      EncodeCudaMemFrame(EncodeFrameConfig *pEncodeFrame, CUdeviceptr oFrame[], const unsigned int oFrame_pitch, bool bFlush=false) = 0;
     virtual HRESULT                                      DestroyEncoder() = 0;
    
@@ -884,7 +999,7 @@ public:
 	// the fwrite_callback() is a caller supplied function that implements receives the compressed bitstream
 	// from the output of the nvEncode-API. (Typically, this data is written to a file.)
 	void                                                 Register_fwrite_callback( fwrite_callback_t callback );
-	CRepackyuv                                           m_Repackyuv;
+	CRepackyuvMT                                         m_Repackyuv;
 
 protected:
 #if defined (NV_WINDOWS) // Windows uses Direct3D or CUDA to access NVENC
@@ -895,17 +1010,40 @@ protected:
     HRESULT                                              InitCuda(unsigned int deviceID = 0);
     HRESULT                                              AllocateIOBuffers(unsigned int dwInputWidth, unsigned int dwInputHeight, unsigned int maxFrmCnt);
     HRESULT                                              ReleaseIOBuffers();
+    HRESULT                                              AllocateBitstreamBuffer(EncodeOutputBuffer *pOutputBfr, const unsigned int dwSize);
+    void                                                 ReleaseBitstreamBuffer(EncodeOutputBuffer *pOutputBfr);
+    void                                                 UpdateBitstreamPool(EncodeOutputBuffer *pOutputBfr, const unsigned int dwFrameBytes);
+    NVENCSTATUS                                          EncodePicture(EncodeOutputBuffer *pOutputBfr); // nvEncEncodePicture(m_stEncodePicParams)
+
+    // SubmitPicture() - (EncodeFramePPro) set up m_stEncodePicParams for a converted input-surface, encode it,
+    //   and queue its bitstream-buffer(s) to the output-thread.  pHint = the lookahead's decision (NULL = no lookahead)
+    virtual HRESULT                                      SubmitPicture(EncodeInputSurfaceInfo *pInput, EncodeOutputBuffer *pOutputBitstream,
+                                                             const NV_ENC_PIC_STRUCT pictureStruct, const lookahead_hint_t *pHint) = 0;
+    // QueueLookahead() - hold back an analyzed frame, and submit the frames which are decided
+    HRESULT                                              QueueLookahead(EncodeInputSurfaceInfo *pInput, EncodeOutputBuffer *pOutputBitstream, const NV_ENC_PIC_STRUCT pictureStruct);
+    HRESULT                                              DrainLookahead(const bool bAll); // submit the decided (bAll: all held back) frames
+    void                                                 StoreLookaheadHint(const unsigned int dwFrameNum, const lookahead_hint_t &hint);
+    // AcquireSurfaces() - (input-thread) the input-surface and bitstream-buffer for the next frame: the spare
+    //   pair if there is one, otherwise the next free pair from the queues (waits for the output-thread)
+    void                                                 AcquireSurfaces(EncodeInputSurfaceInfo *&pInput, EncodeOutputBuffer *&pOutputBitstream);
+    // GetSpillLayout() - the planes of a locked input-surface, as the spill cache stores them
+    void                                                 GetSpillLayout(const EncodeInputSurfaceInfo *pInput, unsigned char *pInputSurface,
+                                                             const unsigned int lockedPitch, spill_layout_t &layout, uint8_t *planes[SPILL_CACHE_MAX_PLANES]) const;
+    // SpillInputSurface() - (EncodeFramePPro) record the converted surface, if the spill cache is recording
+    void                                                 SpillInputSurface(const EncodeInputSurfaceInfo *pInput, unsigned char *pInputSurface, const unsigned int lockedPitch);
 
     unsigned char*                                       LockInputBuffer(void * hInputSurface, unsigned int *pLockedPitch);
     HRESULT                                              UnlockInputBuffer(void * hInputSurface);
 	unsigned int                                         GetCodecType(const GUID &encodeGUID) const;
 	GUID                                                 GetCodecGUID(const NvEncodeCompressionStd codec) const;
     unsigned int                                         GetCodecProfile(const GUID &encodeGUID) const;
+	NV_ENC_BUFFER_FORMAT                                 GetInputBufferFormat(const EncodeConfig &config) const;
 //  HRESULT                                              GetPresetConfig(int iPresetIdx);
 
     HRESULT                                              FlushEncoder();
     HRESULT                                              ReleaseEncoderResources();
     HRESULT                                              WaitForCompletion();
+    void                                                 RecordCompletion(const EncodeOutputBuffer *pOutputBfr);
 
     NV_ENC_REGISTER_RESOURCE                             m_RegisteredResource;
     nv_enc_caps_s                                        m_nv_enc_caps; // capabilities of currently initialized encoder
@@ -929,10 +1067,43 @@ protected:
 	//   Full_scale vs limited_scale,  Bt709 vs Bt601,  etc.
 	CNvEncoder_color_s                                   m_color_metadata;// color metadata
 
+	// completion latency (written by the output-thread)
+	CNvMutex                                             m_CompletionStatsMutex;
+	EncodeCompletionStats                                m_stCompletionStats;
+	U64                                                  m_qwPerfFrequency; // NvQueryPerformanceFrequency()
+
+	// bitstream-buffer pool (m_stBitstreamBuffer[]): a buffer smaller than m_stBitstreamPool.buffer_size
+	// is re-allocated when the output-thread is done with it (in-flight buffers are never touched)
+	CNvMutex                                             m_BitstreamPoolMutex;
+	EncodeBitstreamPoolStats                             m_stBitstreamPool;
+	unsigned int                                         m_dwBitstreamPoolLimit; // the pool never grows beyond this (uncompressed frame)
+
+	// per-frame telemetry (written by the output-thread, in CopyBitstreamData())
+	CNvEncTelemetry                                      m_Telemetry;
+	double                                               TicksToUs(const U64 qwTicks) const;
+
+	// two-pass stats (pass 1) and the bytes coded against the plan (pass 2), in CopyBitstreamData()
+	CNvEncTwoPass                                        m_TwoPass;
+
+	// CPU lookahead (EncodeFramePPro only): analyzed frames wait in m_LookaheadQueue for their decision.
+	//   m_stLookaheadHints[] is written by the input-thread and read by the output-thread (a frame's entry
+	//   is written before its bitstream-buffer is queued, and isn't reused while it is in flight)
+	CLookahead                                           m_Lookahead;
+	CNvRing<EncodeLookaheadFrame, MAX_INPUT_QUEUE>       m_LookaheadQueue;
+	lookahead_hint_t                                     m_stLookaheadHints[LOOKAHEAD_HINT_HISTORY]; // by display frame#
+
+	// spill cache (two-pass export): converted surfaces of pass 1, played back in pass 2 (not owned)
+	CSpillCache                                         *m_pSpillCache;
+	// the surfaces of a frame the spill cache couldn't play back: kept by the input-thread for the next frame
+	//   (m_stInputSurfQueue and m_stOutputSurfQueue are single-producer: only the output-thread adds to them)
+	EncodeInputSurfaceInfo                              *m_pSpareInput;
+	EncodeOutputBuffer                                  *m_pSpareOutput;
+
 public:
     NV_ENCODE_API_FUNCTION_LIST*                         m_pEncodeAPI;
     HINSTANCE                                            m_hinstLib;
     bool                                                 m_bEncodeAPIFound;
+    bool                                                 m_bSoftwareEncodeAPI; // m_pEncodeAPI is the software stand-in (NvEncodeAPICreateInstance_sim)
 
 	const static uint32_t MAX_QP = 51; // H264/HEVC qunatization (QP) : maximum allowed value
 };// class CNvEncoder
@@ -944,6 +1115,8 @@ public:
     :   CNvThread("Encoder Output Thread")
     ,   m_pOwner(pOwner)
     ,   m_dwMaxQueuedSamples(dwMaxQueuedSamples)
+    ,   m_dwPendingSamples(0)
+    ,   m_evIdle(true, true) // manual-reset, signalled (nothing pending)
     {
         // Empty constructor
     }
@@ -954,15 +1127,36 @@ public:
 
     bool QueueSample(EncoderThreadData &sThreadData);
     int GetCurrentQCount()                      { return m_pEncoderQueue.GetCount(); }
-    bool IsIdle()                               { return m_pEncoderQueue.GetCount() == 0; }
+    bool IsIdle()                               { return m_evIdle.Wait(0); }
     bool IsQueueFull()                          { return m_pEncoderQueue.GetCount() >= m_dwMaxQueuedSamples; }
 
+    // WaitIdle() - blocks until every queued sample has been written out (not just dequeued)
+    bool WaitIdle(U32 uTimeoutMs)               { return m_evIdle.Wait(uTimeoutMs); }
+
 protected:
+    void CompleteSample();
+
     CNvEncoder* const m_pOwner;
-    CNvQueue<EncoderThreadData, MAX_OUTPUT_QUEUE> m_pEncoderQueue;
+    CNvRing<EncoderThreadData, MAX_OUTPUT_QUEUE>  m_pEncoderQueue;
     U32 m_dwMaxQueuedSamples;
+    CNvMutex m_PendingMutex;
+    U32 m_dwPendingSamples; // queued, and not yet written out by CopyBitstreamData()
+    CNvEvent m_evIdle;      // set while m_dwPendingSamples == 0
 };
 
+// level limits (kbit/sec, 0 = unconstrained)
+uint32_t
+NVENC_Calculate_H264_MaxKBitRate( 
+	const NV_ENC_LEVEL level, 
+	const enum_NV_ENC_H264_PROFILE profile
+);
+
+uint32_t
+NVENC_Calculate_HEVC_MaxKBitRate(
+	const NV_ENC_LEVEL level,
+	const NV_ENC_LEVEL tier
+);
+
 // NVEncodeAPI entry point
 #if defined(NV_WINDOWS)
 typedef NVENCSTATUS (__stdcall *MYPROC)(NV_ENCODE_API_FUNCTION_LIST*); 
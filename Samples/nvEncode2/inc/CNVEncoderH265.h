@@ -25,6 +25,7 @@ protected:
     unsigned int                                         m_dwIDRPeriod;
     unsigned int                                         m_dwNumRefFrames[2];
     unsigned int                                         m_dwFrameNumInGOP;
+    unsigned int                                         m_dwIDRFrameNum; // (enablePTD == 0) frame# of the last IDR
     unsigned int                                         m_uMaxHeight;
     unsigned int                                         m_uMaxWidth;
     unsigned int                                         m_uCurHeight;
@@ -39,6 +40,9 @@ public:
 	virtual HRESULT                                      EncodeFramePPro(EncodeFrameConfig *pEncodeFrame, const bool bFlush);
     virtual HRESULT                                      EncodeCudaMemFrame(EncodeFrameConfig *pEncodeFrame, CUdeviceptr oFrame[], const unsigned int oFrame_pitch, bool bFlush=false);
     virtual HRESULT                                      DestroyEncoder();
+protected:
+    virtual HRESULT                                      SubmitPicture(EncodeInputSurfaceInfo *pInput, EncodeOutputBuffer *pOutputBitstream,
+                                                             const NV_ENC_PIC_STRUCT pictureStruct, const lookahead_hint_t *pHint);
 };
 
 #endif
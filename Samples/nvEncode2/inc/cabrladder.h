@@ -0,0 +1,91 @@
+#ifndef _cabrladder__h
+#define _cabrladder__h
+
+#include "stdint.h"
+#include <emmintrin.h> // SSE2 compiler intrinsics
+
+// CAbrLadder : the rungs of an adaptive-bitrate ladder, and the downscale pyramid which feeds them
+//
+//   One rendered (or decoded) frame feeds an encoder-session per rung.  Rung 0 is the source
+//   itself; each lower rung is downscaled from the rung above it (not from the source), so the
+//   rungs form a pyramid and each one reads the smallest picture that can make it.  The ratio
+//   between two neighbouring rungs is at most 2:1, so every output sample is the area-weighted
+//   average of at most 3x3 input samples.
+//
+//   Plan() picks the standard streaming ladder below the source: 2/3, 1/2, 1/3, 1/4 and 1/6
+//   of its height (2160p: 1440p, 1080p, 720p, 540p, 360p), and shares the bitrate out
+//   as (pixels)^ABR_LADDER_RATE_EXPONENT, so the small rungs get more bits per pixel.
+//
+//   Input and output are YUV 4:2:0 planar, 8 bits (the Adobe YUV_420_..._PLANAR_8u formats.)
+//   Every buffer is allocated by Init(), Downscale() never allocates.
+//   Single-threaded (the caller's input-thread.)
+//
+//   Users: the Premiere exporter and nvencbench -ladder.  Not main2: it decodes with CUVID into
+//   CUDA device memory and hands NVENC the device pointers (EncodeCudaMemFrame), and each of its
+//   encoders runs its own decoder.  Feeding this host-side pyramid would cost a download of every
+//   frame; main2 would need a CUDA downscaler instead.
+
+#define ABR_LADDER_MAX_RUNGS       6       // including rung 0 (the source)
+#define ABR_LADDER_MIN_HEIGHT      144     // Plan() stops above this
+#define ABR_LADDER_RATE_EXPONENT   0.75    // bitrate ~ (width * height)^exponent
+#define ABR_LADDER_WEIGHT_BITS     8       // resampling weights: Q8 (vertical, then horizontal)
+
+typedef struct {
+	uint32_t width;     // even
+	uint32_t height;    // even
+	uint32_t avg_bps;
+	uint32_t peak_bps;  // (0 = none)
+} abr_rung_t;
+
+class CAbrLadder
+{
+public:
+	CAbrLadder();
+	~CAbrLadder();
+
+	// Plan() - the ladder for a (width x height) source encoded at avg_bps/peak_bps.
+	//   rungs[0] = the source.  returns #rungs (1 .. max_rungs, fewer if the source is small)
+	static uint32_t Plan(const uint32_t width, const uint32_t height, const uint32_t avg_bps,
+		const uint32_t peak_bps, const uint32_t max_rungs, abr_rung_t rungs[ABR_LADDER_MAX_RUNGS]);
+
+	// Init() - allocate the planes of rungs[1 .. count-1] (rungs[0] is the caller's frame)
+	bool Init(const abr_rung_t *rungs, const uint32_t count);
+	void Release();
+
+	uint32_t GetRungCount() const { return m_count; };
+	const abr_rung_t &GetRung(const uint32_t rung) const { return m_rungs[rung]; };
+
+	// Downscale() - build rungs 1 .. count-1 from a source frame (the Y, U, V planes of rung 0)
+	void Downscale(const uint8_t * const src[3], const uint32_t src_stride[3]);
+
+	// the planes of rung 1 .. count-1 (valid until the next Downscale())
+	uint8_t *GetPlane(const uint32_t rung, const uint32_t plane) const { return m_planes[rung][plane]; };
+	uint32_t GetStride(const uint32_t rung, const uint32_t plane) const { return m_strides[rung][plane]; };
+
+protected:
+	// one axis of a resampler: output sample i = sum(weight[j] * input[first + j]), j < taps
+	typedef struct {
+		uint32_t first;
+		uint32_t taps;      // 1..3
+		uint16_t weight[3]; // Q8, sum = 1 << ABR_LADDER_WEIGHT_BITS
+	} abr_taps_t;
+
+	typedef struct {
+		abr_taps_t *h;      // [output width]
+		abr_taps_t *v;      // [output height]
+	} abr_scaler_t;
+
+	static void _make_taps(const uint32_t src_size, const uint32_t dst_size, abr_taps_t *taps);
+	void _scale_plane(const uint8_t *src, const uint32_t src_stride, const uint32_t src_w,
+		uint8_t *dst, const uint32_t dst_stride, const uint32_t dst_w, const uint32_t dst_h,
+		const abr_scaler_t &scaler);
+
+	uint32_t     m_count;
+	abr_rung_t   m_rungs[ABR_LADDER_MAX_RUNGS];
+	uint8_t     *m_planes[ABR_LADDER_MAX_RUNGS][3];
+	uint32_t     m_strides[ABR_LADDER_MAX_RUNGS][3];  // multiple of 16 bytes
+	abr_scaler_t m_scalers[ABR_LADDER_MAX_RUNGS][2];  // [rung][luma, chroma] (from the rung above)
+	uint16_t    *m_rows;                              // 8 vertically filtered rows (Q8), interleaved: [x][8]
+};
+
+#endif // _cabrladder__h
@@ -0,0 +1,110 @@
+#ifndef _casyncrender__h
+#define _casyncrender__h
+
+#include "stdint.h"
+
+#include <include/NvTypes.h>
+#include <threads/NvThreadingClasses.h>
+
+// CAsyncRender : pipelined front-end for a renderer which completes frames asynchronously
+//
+//   The host (Premiere's sequence-render suite, or a stand-in) renders the frames on its own
+//   threads, and calls Complete() as each one is done, in any order.  CAsyncRender keeps up to
+//   <window> frames queued with the host (including the one the caller is working on), puts the
+//   completions back into frame-order, and hands them out one at a time: Next() waits for the
+//   next frame, the caller converts and encodes it, and Release() gives the frame back to the
+//   host, which frees its window-slot for the next QueueRender().  So the host renders the
+//   frames ahead while the encoder works, instead of the two taking turns.
+//
+//   Next()/Release()/Begin()/End() run on the caller's thread, Complete() on any thread
+//   (also from inside QueueRender(), if the host has the frame already.)
+
+#define ASYNCRENDER_MAX_WINDOW      16      // frames in flight
+#define ASYNCRENDER_DEFAULT_WINDOW  4
+#define ASYNCRENDER_TIMEOUT_MS      60000   // Next()/End() give up on a frame the host never completes
+
+// the host's renderer (implemented over the Adobe suites by the exporter)
+class IAsyncRenderHost
+{
+public:
+	virtual ~IAsyncRenderHost() { };
+
+	// QueueRender() - start rendering frame# (0 .. frame_count-1).  false = the host can't queue it
+	//   (Next() then returns it with status ASYNCRENDER_STATUS_NOT_QUEUED)
+	virtual bool QueueRender(const uint32_t frame) = 0;
+
+	// ReleaseFrame() - dispose a frame passed to Complete()
+	virtual void ReleaseFrame(void *handle) = 0;
+};
+
+#define ASYNCRENDER_STATUS_NOT_QUEUED   (-1)
+
+typedef struct {
+	uint32_t frame;     // frame#
+	void    *handle;    // the host's rendered frame (NULL if the render failed)
+	int32_t  status;    // the host's return-value (0 = no error)
+} asyncrender_frame_t;
+
+typedef struct {
+	uint32_t queued;        // #QueueRender() calls
+	uint32_t max_inflight;  // most frames queued and not yet released
+	uint32_t waits;         // #times Next() had to wait (the render is the bottleneck)
+	double   wait_us;       // total time Next() waited
+} asyncrender_stats_t;
+
+class CAsyncRender
+{
+public:
+	CAsyncRender();
+	~CAsyncRender();
+
+	// Begin() - render frames [first_frame, frame_count) with up to window frames in flight
+	//   (1 .. ASYNCRENDER_MAX_WINDOW), and queue the first window.
+	bool Begin(IAsyncRenderHost *host, const uint32_t first_frame, const uint32_t frame_count, const uint32_t window);
+
+	// Next() - wait for the next frame (in frame-order).  false = no frames left, or the host
+	//   didn't complete the frame within timeout_ms.
+	bool Next(asyncrender_frame_t &frame, const uint32_t timeout_ms = ASYNCRENDER_TIMEOUT_MS);
+
+	// Release() - done with the frame returned by Next(): dispose it, and queue the next one
+	void Release(const asyncrender_frame_t &frame);
+
+	// End() - stop queueing, wait for the frames still with the host, and dispose them.  A frame the
+	//   host completes after End() gave up on it is still disposed through the host, until Detach().
+	void End();
+
+	// Detach() - (after End()) the host calls Complete() no more (its completion-callback is
+	//   unregistered): forget the host, which the caller may now destroy.
+	void Detach();
+
+	// [any thread] the host finished rendering a frame (status 0 = ok)
+	void Complete(const uint32_t frame, void *handle, const int32_t status);
+
+	bool     IsActive() const { return m_host != NULL; };
+	uint32_t GetWindow() const { return m_window; };
+	const asyncrender_stats_t &GetStats() const { return m_stats; };
+
+protected:
+	typedef struct {
+		bool     done;
+		void    *handle;
+		int32_t  status;
+	} asyncrender_slot_t;
+
+	asyncrender_slot_t &_slot(const uint32_t frame) { return m_slots[frame % m_window]; };
+	void _queue_window();     // queue frames until the window is full
+
+	IAsyncRenderHost   *m_host;
+	IAsyncRenderHost   *m_disposer;    // (m_lock) ReleaseFrame() for late completions, until Detach()
+	uint32_t            m_window;
+	uint32_t            m_frame_count;
+	uint32_t            m_next_queue;  // next frame to QueueRender()
+	uint32_t            m_next_out;    // next frame for Next() (held by the caller until Release())
+
+	CNvMutex            m_lock;        // m_slots
+	CNvEvent            m_completed;   // (auto-reset) Complete() was called
+	asyncrender_slot_t  m_slots[ASYNCRENDER_MAX_WINDOW];
+	asyncrender_stats_t m_stats;
+};
+
+#endif // _casyncrender__h
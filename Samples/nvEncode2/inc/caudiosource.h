@@ -0,0 +1,87 @@
+#ifndef _caudiosource__h
+#define _caudiosource__h
+
+#include "stdint.h"
+#include <stdio.h>
+#include <vector>
+
+// 64-bit file-offsets (used by all of the built-in muxers)
+#if defined(_MSC_VER)
+#define mux_fseek64 _fseeki64
+#define mux_ftell64 _ftelli64
+#else
+#define mux_fseek64 fseeko
+#define mux_ftell64 ftello
+#endif
+
+// CAudioSource : reader for the audio-file which the exporter renders before muxing
+//
+//   (1) *.WAV : 16-bit integer PCM (WAVE_FORMAT_PCM or WAVE_FORMAT_EXTENSIBLE)
+//   (2) *.M4A : AAC audio in an MPEG-4 container (as written by NeroAacEnc)
+//
+//   After OpenWav()/OpenM4a(), the public members describe the audio-stream.
+//   The built-in muxers either copy the stream wholesale (MP4: chunk-tables),
+//   or pull it one frame at a time with ReadFrame() to interleave it with the video (TS).
+//
+//   The FILE handle belongs to the caller.
+
+typedef enum _audio_source_codec_t {
+	AUDIO_SOURCE_NONE = 0,
+	AUDIO_SOURCE_PCM  = 1, // 16-bit little-endian PCM
+	AUDIO_SOURCE_AAC  = 2  // raw AAC frames (no ADTS-header)
+} audio_source_codec_t;
+
+class CAudioSource
+{
+public:
+	typedef std::vector<uint8_t> bytes_t;
+
+	CAudioSource();
+
+	bool OpenWav(FILE *wav);
+	bool OpenM4a(FILE *m4a);
+
+	// ReadFrame() - read the next frame of audio (in file-order)
+	//   AAC : exactly one AAC access-unit
+	//   PCM : up to max_pcm_frames PCM-frames (1 PCM-frame == 1 sample of all channels)
+	//
+	//   *time : timestamp of the frame (in timescale units)
+	//   returns false at end-of-stream (or on a read-error)
+	bool ReadFrame(bytes_t &frame, uint64_t *time, const uint32_t max_pcm_frames);
+
+	// timestamp of the frame ReadFrame() returns next (in timescale units)
+	uint64_t NextTime() const;
+	bool Eof() const;
+
+	// estimated bitrate of the stream (bits/sec)
+	uint32_t GetBitRate() const;
+
+	audio_source_codec_t codec;
+	uint32_t sample_rate;
+	uint16_t channels;
+	uint16_t bits_per_sample; // PCM only
+	uint16_t block_align;     // PCM only (bytes per PCM-frame)
+	uint32_t channel_mask;    // PCM only: WAVE_FORMAT_EXTENSIBLE speaker-positions (0 = not given)
+	uint32_t timescale;       // timestamp units/sec (PCM: == sample_rate)
+	uint64_t duration;        // (in timescale units)
+
+	// PCM: location of the 'data' chunk
+	uint64_t data_offset;
+	uint64_t data_size;
+
+	// AAC: sample-tables of the first sound-track
+	bytes_t  stsd;            // complete 'stsd' box (mp4a + esds)
+	bytes_t  stts;            // complete 'stts' box
+	bytes_t  asc;             // AudioSpecificConfig (from the esds DecoderSpecificInfo)
+	std::vector<uint32_t> sample_size;
+	std::vector<uint64_t> sample_offset; // file-offset of each sample
+	std::vector<uint64_t> sample_time;   // decode-time of each sample (in timescale units)
+	std::vector<uint64_t> chunk_offset;  // file-offset of each chunk
+	std::vector<uint32_t> chunk_samples; // #samples in each chunk
+
+protected:
+	FILE    *m_fp;
+	uint64_t m_next; // AAC: next sample#, PCM: next PCM-frame#
+};
+
+#endif // _caudiosource__h
@@ -0,0 +1,126 @@
+#ifndef _cfilewriter__h
+#define _cfilewriter__h
+
+#include "stdint.h"
+#include <stddef.h>
+#include <atomic>
+
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+#include <windows.h>
+#endif
+
+#include <include/NvTypes.h>
+#include <threads/NvThreadingClasses.h>
+
+// CFileWriter : asynchronous, batched writer for the encoder's output file
+//
+//   Write() only copies the bytes into the current (page-aligned) buffer.  A full
+//   buffer is handed to the writer-thread, which writes it out with one large
+//   aligned write, while the caller fills the next buffer.  So the encoder's
+//   output-thread never waits for the disk, unless all of the buffers are still
+//   queued for writing (backpressure: then Write() blocks until one is free).
+//
+//   The file is opened for unbuffered I/O where possible (Windows: FILE_FLAG_NO_BUFFERING
+//   and overlapped WriteFile, up to FILEWRITER_MAX_INFLIGHT writes outstanding.
+//   Linux: O_DIRECT and pwrite.)  If the file-system refuses unbuffered I/O, the
+//   file is opened with the normal page-cache instead.  The last (partial) buffer
+//   is padded to the alignment, and the file is truncated to its real size by Close().
+//
+//   Write() must be called from one thread at a time (it's the fwrite_callback.)
+
+#define FILEWRITER_ALIGN          4096        // buffer/offset alignment of unbuffered I/O (covers 512e and 4Kn sectors)
+#define FILEWRITER_BUFFER_SIZE    (16 << 20)  // default buffer size (bytes)
+#define FILEWRITER_BUFFER_COUNT   4           // default #buffers
+#define FILEWRITER_MAX_BUFFERS    16
+#define FILEWRITER_MAX_INFLIGHT   2           // (Windows) overlapped writes outstanding
+
+typedef struct {
+	uint64_t bytes;       // #bytes passed to Write()
+	uint64_t writes;      // #writes issued by the writer-thread
+	uint64_t stalls;      // #times Write() had to wait for a free buffer
+	double   stall_us;    // total time Write() waited for a free buffer
+	bool     unbuffered;  // file was opened for unbuffered I/O
+	bool     preallocated;// the preallocation succeeded
+} filewriter_stats_t;
+
+class CFileWriter : protected CNvThread
+{
+public:
+	CFileWriter();
+	~CFileWriter();
+
+	// Create (or truncate) the file, and start the writer-thread.
+	//   prealloc_bytes : expected file size (0 = unknown), reserved up-front to avoid fragmentation
+	bool Open(
+		const char    *filename,
+		const uint64_t prealloc_bytes = 0,
+		const uint32_t buffer_size    = FILEWRITER_BUFFER_SIZE,
+		const uint32_t buffer_count   = FILEWRITER_BUFFER_COUNT
+	);
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+	bool Open(
+		const wchar_t *filename,
+		const uint64_t prealloc_bytes = 0,
+		const uint32_t buffer_size    = FILEWRITER_BUFFER_SIZE,
+		const uint32_t buffer_count   = FILEWRITER_BUFFER_COUNT
+	);
+#endif
+
+	bool IsOpen() const { return m_open; };
+
+	// Write() - append size bytes
+	//   returns #bytes consumed (size), or 0 on error  (same convention as fwrite.)
+	size_t Write(const void *data, const size_t size);
+
+	// Write out the remaining data, wait for the writer-thread and close the file.
+	//   returns false if any write failed.
+	bool Close();
+
+	void GetStats(filewriter_stats_t &stats) const { stats = m_stats; };
+
+protected:
+	typedef struct {
+		uint32_t index;   // buffer#
+		uint32_t size;    // #bytes to write (multiple of FILEWRITER_ALIGN when unbuffered)
+		uint64_t offset;  // file offset
+		bool     quit;    // sentinel: no more buffers
+	} filewriter_block_t;
+
+	virtual bool ThreadFunc(); // the writer-thread
+
+	bool _open_handle(const void *filename, const bool wide);
+	bool _start(const uint64_t prealloc_bytes, const uint32_t buffer_size, const uint32_t buffer_count);
+	void _submit_current();    // hand m_buffer[m_current] to the writer-thread
+	bool _next_buffer();       // get a free buffer (blocks if none)
+	bool _issue(const filewriter_block_t &block);
+	bool _complete_oldest();
+	void _release();
+
+	bool      m_open;
+	bool      m_unbuffered;
+	std::atomic<bool> m_io_error;
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+	HANDLE    m_handle;
+	OVERLAPPED m_overlapped[FILEWRITER_MAX_BUFFERS];
+	uint32_t  m_inflight[FILEWRITER_MAX_INFLIGHT];
+	uint32_t  m_inflight_count;
+#else
+	int       m_fd;
+#endif
+
+	uint8_t  *m_buffer[FILEWRITER_MAX_BUFFERS];
+	uint32_t  m_buffer_count;
+	uint32_t  m_buffer_size;
+
+	// [caller] the buffer being filled
+	uint32_t  m_current;
+	uint32_t  m_fill;
+	uint64_t  m_offset;  // file offset of m_buffer[m_current]
+
+	CNvRing<uint32_t, FILEWRITER_MAX_BUFFERS>           m_free;   // writer-thread -> caller
+	CNvRing<filewriter_block_t, FILEWRITER_MAX_BUFFERS> m_queued; // caller -> writer-thread
+
+	filewriter_stats_t m_stats;
+};
+
+#endif // _cfilewriter__h
@@ -0,0 +1,99 @@
+#ifndef _clookahead__h
+#define _clookahead__h
+
+#include "stdint.h"
+#include <emmintrin.h> // SSE2 compiler intrinsics
+
+// CLookahead : CPU lookahead analysis of the frames waiting to be encoded
+//
+//   Analyze() is called while the converted luma plane is still in the cache (right after
+//   CRepackyuv wrote it into the input-surface.)  It downsamples the plane into a thumbnail
+//   of 8x8-block averages (SSE2 _mm_sad_epu8), measures the mean 8x8-block standard-deviation
+//   (spatial activity), and the thumbnail SAD to the previous two frames (temporal change.)
+//
+//   The encoder holds back <depth> analyzed frames.  Decide() then returns the verdict on the
+//   oldest one, with the frames behind it in view:
+//     scene-cut  : the frame differs strongly from the previous two frames, and the next frame
+//                  doesn't return to the previous picture (a flash or a single-frame glitch is not a cut)
+//     complexity : its estimated coding cost, relative to the average cost of the lookahead window
+//                  (1.0 = average, >1.0 = harder than the frames around it.)  The cost estimate is
+//                  the smaller of its spatial activity (intra) and its temporal change (inter.)
+//
+//   Every buffer is allocated by Init(), Analyze()/Decide() never allocate.
+//   Single-threaded (the encoder's input-thread only.)
+
+#define LOOKAHEAD_MAX_DEPTH         16      // frames held back (limited by MAX_INPUT_QUEUE)
+#define LOOKAHEAD_BLOCK             8       // thumbnail pixel = average of an 8x8 luma-block
+#define LOOKAHEAD_SCENECUT_MIN      10.0f   // scene-cut: thumbnail SAD (mean per pixel, 0..255) must exceed this,
+#define LOOKAHEAD_SCENECUT_RATIO    4.0f    //   and this multiple of the average SAD of the recent frames
+#define LOOKAHEAD_FLASH_RATIO       0.5f    // the next frame is within this fraction of the SAD of the previous one: a flash
+#define LOOKAHEAD_MIN_CUT_DISTANCE  4       // (#frames) minimum distance between two scene-cuts
+
+typedef struct {
+	uint32_t frame;        // analysis order (0 = first frame analyzed since Reset())
+	float    sad;          // thumbnail SAD to the previous frame (mean per thumbnail-pixel, 0..255)
+	float    activity;     // mean 8x8-block standard-deviation of the luma (0..255)
+	float    cost;         // estimated coding cost (activity for a scene-cut, else min(activity, sad))
+	float    window_cost;  // average cost of the lookahead window (this frame .. the newest analyzed)
+	float    complexity;   // cost / window_cost  (always 1.0 with depth 0)
+	bool     scene_cut;    // the frame should be coded as an IDR
+} lookahead_hint_t;
+
+class CLookahead
+{
+public:
+	CLookahead();
+	~CLookahead();
+
+	// Init() - allocate the thumbnails for a (width x height) luma plane, and Reset().
+	//   depth = #frames held back for the decisions (0 = decide each frame as it is analyzed, without flash-detection)
+	bool Init(const uint32_t width, const uint32_t height, const uint32_t depth);
+	void Release();
+	void Reset();   // start a new sequence (the next frame analyzed is frame 0)
+
+	bool     IsEnabled() const { return m_thumb_size != 0; };
+	uint32_t GetDepth() const  { return m_depth; };
+	uint32_t Pending() const   { return m_analyzed - m_decided; }; // analyzed, but not yet decided
+
+	// Analyze() - append a frame.  luma = 8-bit (bytes_per_sample 1) or MSB-aligned 16-bit
+	//   (bytes_per_sample 2: P010/YUV444_10BIT) luma plane of (width x height), pitch in bytes.
+	//   Call Decide() first if Pending() > depth.
+	void Analyze(const uint8_t *luma, const uint32_t pitch, const uint32_t bytes_per_sample = 1);
+
+	// Decide() - the verdict on the oldest pending frame.  false if no frame is pending.
+	bool Decide(lookahead_hint_t &hint);
+
+protected:
+	typedef struct {
+		float sad1;      // thumbnail SAD to frame-1
+		float sad2;      // thumbnail SAD to frame-2
+		float activity;
+	} lookahead_stats_t;
+
+	uint8_t *_thumb(const uint32_t frame) const { return m_thumbs + (frame % m_slots) * m_thumb_size; };
+	float    _downsample(const uint8_t *luma, const uint32_t pitch, const uint32_t bytes_per_sample, uint8_t *thumb); // returns the activity
+	void     _block_row(const uint8_t *rows, const uint32_t pitch, uint8_t *thumb_row, double &std_total) const;
+	float    _sad(const uint8_t *a, const uint8_t *b) const;
+	float    _cost(const lookahead_stats_t &stats, const bool scene_cut) const;
+
+	uint32_t m_width;        // luma-plane
+	uint32_t m_height;
+	uint32_t m_depth;
+
+	uint32_t m_thumb_w;      // thumbnail (width/8 x height/8 pixels)
+	uint32_t m_thumb_h;
+	uint32_t m_thumb_pitch;  // multiple of 16 bytes (the padding is 0 in every thumbnail)
+	uint32_t m_thumb_size;   // bytes per thumbnail (0 = not initialized)
+	uint32_t m_slots;        // depth + 3 : frame-2, frame-1 (decided), and depth+1 pending frames
+	uint8_t *m_thumbs;       // [m_slots] thumbnails
+	lookahead_stats_t m_stats[LOOKAHEAD_MAX_DEPTH + 3];
+	uint8_t *m_row8;         // (bytes_per_sample 2) one block-row of the luma plane, reduced to 8-bit
+	uint32_t m_row8_pitch;
+
+	uint32_t m_analyzed;     // #frames analyzed
+	uint32_t m_decided;      // #frames decided
+	uint32_t m_last_cut;     // frame# of the last scene-cut (frame 0 counts as one)
+	float    m_avg_sad;      // running average SAD of the frames which weren't scene-cuts
+};
+
+#endif // _clookahead__h
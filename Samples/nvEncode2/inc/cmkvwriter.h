@@ -0,0 +1,140 @@
+#ifndef _cmkvwriter__h
+#define _cmkvwriter__h
+
+#include "stdint.h"
+#include <stdio.h>
+#include <vector>
+
+#include "caudiosource.h"
+
+// CMkvWriter : streaming Matroska (MKV) muxer for the NVENC elementary stream
+//
+//   The encoder's Annex-B output (the bytes which CNvEncoder passes to its
+//   fwrite_callback) is fed to WriteBitstream() one access-unit at a time.
+//   Each access-unit is converted to length-prefixed NAL units and written out
+//   immediately as a SimpleBlock.  Only the cue-points are kept in memory.
+//
+//   File layout:
+//     EBML | Segment { SeekHead | Info | Tracks | Cluster ... | Cues }
+//
+//   The SeekHead, the segment-size, the Info/Duration and the cluster-sizes are
+//   patched in place (the header is written with fixed-size placeholders), so
+//   the file is complete as soon as Close() returns.
+//
+//   Audio must be attached (AddPcmTrack/AddAacTrack) before the first video
+//   access-unit: the audio-file is read back frame by frame and interleaved with
+//   the video, in the same clusters.
+//
+//   A cluster starts at every sync-sample (IDR/IRAP), or after MKV_CLUSTER_MAX_MSEC;
+//   every video sync-sample gets a cue-point.
+//
+//   The SPS/PPS (and VPS for HEVC) NAL-units that NVENC emits at the start of the
+//   stream are moved into the CodecPrivate (avcC/hvcC).  Parameter-sets which
+//   arrive after the first sample (i.e. dynamic resolution change) are kept in-band.
+
+typedef enum _mkv_video_codec_t {
+	MKV_VIDEO_NONE = 0, // audio-only file
+	MKV_VIDEO_AVC  = 1, // H.264  (V_MPEG4/ISO/AVC)
+	MKV_VIDEO_HEVC = 2  // H.265  (V_MPEGH/ISO/HEVC)
+} mkv_video_codec_t;
+
+class CMkvWriter
+{
+public:
+	CMkvWriter();
+	~CMkvWriter();
+
+	// Start a new Matroska file.  (fp must be opened in binary mode "wb")
+	bool Open(
+		FILE                   *fp,
+		const mkv_video_codec_t codec,
+		const uint32_t          width,
+		const uint32_t          height,
+		const uint32_t          frameRateNum,
+		const uint32_t          frameRateDen
+	);
+
+	bool IsOpen() const { return m_fp != NULL; };
+
+	// Attach the audio (before the first WriteBitstream()).
+	//   The FILE handle must stay open until Close().
+	bool AddPcmTrack(FILE *wav); // 16-bit PCM *.WAV file (A_PCM/INT/LIT)
+	bool AddAacTrack(FILE *m4a); // *.M4A file (AAC audio in an MPEG-4 container, as written by NeroAacEnc)
+
+	// WriteBitstream() - append one block of NVENC (Annex-B) output
+	//
+	//   pts : presentation frame# of the access-unit (NV_ENC_LOCK_BITSTREAM::outputTimeStamp),
+	//         or -1 if not known (then presentation-order == decode-order is assumed.)
+	//
+	//   returns #bytes consumed (size), or 0 on error  (same convention as fwrite.)
+	size_t WriteBitstream(const uint8_t data[], const size_t size, const int64_t pts);
+
+	// Finish the file: write out the remaining audio and the Cues, patch the SeekHead/Duration.
+	//   The FILE handle is not closed; the caller owns it.
+	bool Close();
+
+	uint32_t GetNumVideoFrames() const { return m_frame_count; };
+
+protected:
+	typedef std::vector<uint8_t> bytes_t;
+
+	typedef struct {
+		uint64_t time;             // (msec)
+		uint64_t cluster_position; // cluster-offset, relative to the segment-data
+		uint8_t  track;
+	} mkv_cue_t;
+
+	FILE             *m_fp;
+	mkv_video_codec_t m_codec;
+	uint32_t          m_width;
+	uint32_t          m_height;
+	uint32_t          m_rate_num;   // video frame-rate
+	uint32_t          m_rate_den;
+	bool              m_io_error;
+	uint64_t          m_pos;        // current write-position in m_fp
+	bool              m_header_written;// EBML, Segment, SeekHead-placeholder, Info, Tracks are written
+
+	// file-offsets of the elements which are patched by Close()
+	uint64_t          m_segment_data; // start of the Segment's payload
+	uint64_t          m_seekhead_pos;
+	uint64_t          m_info_pos;
+	uint64_t          m_duration_pos; // payload of Info/Duration
+	uint64_t          m_tracks_pos;
+
+	// current cluster
+	bool              m_cluster_open;
+	uint64_t          m_cluster_pos;  // file-offset of the Cluster element
+	uint64_t          m_cluster_time; // (msec)
+
+	uint32_t          m_frame_count;  // #video access-units written (decode-order)
+	int64_t           m_pts_base;     // pts of the first access-unit
+	uint64_t          m_video_end;    // (msec) end of the last presented video-frame
+
+	// parameter-sets for the CodecPrivate
+	std::vector<bytes_t> m_vps;
+	std::vector<bytes_t> m_sps;
+	std::vector<bytes_t> m_pps;
+
+	// audio
+	CAudioSource      m_audio;
+	uint32_t          m_pcm_frames;   // PCM: #PCM-frames per block
+	uint64_t          m_audio_end;    // (msec) end of the audio written so far
+
+	std::vector<mkv_cue_t> m_cues;
+
+	bytes_t           m_au;           // scratch: the access-unit being converted to length-prefixed NALs
+	bytes_t           m_frame;        // scratch: audio-frame
+
+	bool _write(const void *data, const size_t size);
+	bool _patch(const uint64_t offset, const void *data, const size_t size);
+	bool _write_header(const bool with_video);
+	void _build_tracks(bytes_t &b, const bool with_video) const;
+	bool _start_cluster(const uint64_t time);
+	bool _end_cluster();
+	bool _write_block(const uint8_t track, const uint64_t time, const bool keyframe, const uint8_t data[], const size_t size);
+	bool _write_audio_until(const uint64_t time);
+	void _add_parameter_set(std::vector<bytes_t> &list, const uint8_t nal[], const size_t size);
+	uint64_t _frame_time(const int64_t frames) const;
+};
+
+#endif // _cmkvwriter__h
@@ -0,0 +1,144 @@
+#ifndef _cmp4writer__h
+#define _cmp4writer__h
+
+#include "stdint.h"
+#include <stdio.h>
+#include <vector>
+
+// CMp4Writer : streaming ISO-BMFF (MP4) muxer for the NVENC elementary stream
+//
+//   The encoder's Annex-B output (the bytes which CNvEncoder passes to its
+//   fwrite_callback) is fed to WriteBitstream() one access-unit at a time.
+//   Each access-unit is converted to length-prefixed NAL units and appended
+//   to the output file as soon as it arrives.  Only the sample-tables
+//   (sizes, chunk-offsets, sync-samples, composition-offsets) are kept in memory.
+//
+//   Two output layouts are supported:
+//
+//   (1) regular MP4  : ftyp | mdat (samples, written while encoding) | moov
+//       The 'moov' is written by Close().  Optional audio-tracks (PCM or AAC)
+//       can be added to the same mdat with AddPcmTrack()/AddAacTrack() before Close().
+//
+//   (2) fragmented MP4 : ftyp | moov (init-segment) | { moof | mdat } ...
+//       A fragment is written out at every sync-sample (IDR/IRAP), so the
+//       beginning of the file can be consumed (uploaded) before the
+//       encode is finished.  Fragmented-mode is video-only.
+//
+//   The SPS/PPS (and VPS for HEVC) NAL-units that NVENC emits at the start of the
+//   stream are moved into the avcC/hvcC sample-description.  Parameter-sets which
+//   arrive after the first sample (i.e. dynamic resolution change) are kept in-band.
+
+typedef enum _mp4_video_codec_t {
+	MP4_VIDEO_AVC  = 0, // H.264  ('avc1' sample-entry)
+	MP4_VIDEO_HEVC = 1  // H.265  ('hvc1' sample-entry)
+} mp4_video_codec_t;
+
+class CMp4Writer
+{
+public:
+	CMp4Writer();
+	~CMp4Writer();
+
+	// Start a new MP4 file.  (fp must be opened in binary mode "wb")
+	//   The video timescale is frameRateNum, each video-sample lasts frameRateDen ticks.
+	bool Open(
+		FILE                   *fp,
+		const mp4_video_codec_t codec,
+		const uint32_t          width,
+		const uint32_t          height,
+		const uint32_t          frameRateNum,
+		const uint32_t          frameRateDen,
+		const bool              fragmented
+	);
+
+	bool IsOpen() const { return m_fp != NULL; };
+	bool IsFragmented() const { return m_fragmented; };
+
+	// WriteBitstream() - append one block of NVENC (Annex-B) output
+	//
+	//   pts : presentation frame# of the access-unit (NV_ENC_LOCK_BITSTREAM::outputTimeStamp),
+	//         or -1 if not known (then presentation-order == decode-order is assumed.)
+	//
+	//   returns #bytes consumed (size), or 0 on error  (same convention as fwrite.)
+	size_t WriteBitstream(const uint8_t data[], const size_t size, const int64_t pts);
+
+	// Append an audio-track, copying the audio-samples into the mdat.
+	//   (regular MP4 only; must be called after the last WriteBitstream() and before Close()
+	bool AddPcmTrack(FILE *wav); // 16-bit PCM *.WAV file (WAVE_FORMAT_PCM or WAVE_FORMAT_EXTENSIBLE)
+	bool AddAacTrack(FILE *m4a); // *.M4A file (AAC audio in an MPEG-4 container, as written by NeroAacEnc)
+
+	// Finish the file: fix up the mdat-size and write the 'moov' (or the final fragment.)
+	//   The FILE handle is not closed; the caller owns it.
+	bool Close();
+
+	uint32_t GetNumVideoSamples() const { return static_cast<uint32_t>(m_video.sample_size.size()) + m_frag_count; };
+
+protected:
+	typedef std::vector<uint8_t> bytes_t;
+
+	// sample-tables for one track
+	typedef struct {
+		uint32_t track_ID;
+		uint32_t timescale;
+		uint64_t duration;     // (in timescale units)
+		uint32_t sample_delta; // video: constant sample-duration
+		uint32_t const_sample_size; // !0 : all samples have this size (PCM)
+		uint32_t const_sample_count;// #samples (if const_sample_size != 0)
+		std::vector<uint32_t> sample_size;
+		std::vector<uint32_t> sync_sample;  // 1-based sample#s of the sync-samples
+		std::vector<int64_t>  pts;          // video: presentation frame#
+		std::vector<uint64_t> chunk_offset;
+		std::vector<uint32_t> chunk_samples;// #samples in each chunk
+		bytes_t  stsd;         // complete 'stsd' box
+		bytes_t  stts;         // complete 'stts' box (audio-tracks only)
+	} mp4_track_t;
+
+	FILE             *m_fp;
+	mp4_video_codec_t m_codec;
+	uint32_t          m_width;
+	uint32_t          m_height;
+	bool              m_fragmented;
+	bool              m_io_error;
+	uint64_t          m_pos;        // current write-position in m_fp
+	uint64_t          m_mdat_start; // file-offset of the 'mdat' header
+	bool              m_header_written;// ftyp/mdat (or the init-segment) is written
+	uint32_t          m_chunk_max;  // max #video-samples per chunk (about 1 second)
+	int64_t           m_pts_base;   // pts of the first sample
+	uint32_t          m_pts_delay;  // composition delay (in frames) caused by B-frames
+	bool              m_inband_ps;  // parameter-sets were found after the first sample
+
+	mp4_track_t           m_video;
+	std::vector<mp4_track_t> m_audio;
+
+	// parameter-sets for the avcC/hvcC
+	std::vector<bytes_t>  m_vps;
+	std::vector<bytes_t>  m_sps;
+	std::vector<bytes_t>  m_pps;
+
+	bytes_t               m_au;     // scratch: the access-unit being converted to length-prefixed NALs
+
+	// fragmented-mode state
+	bytes_t               m_frag_data; // buffered samples of the current fragment
+	uint32_t              m_frag_seq;  // mfhd sequence_number
+	uint32_t              m_frag_count;// #samples already written out in earlier fragments
+
+	bool _write(const void *data, const size_t size);
+	bool _write_header();
+	bool _write_sample(const bool is_sync, const int64_t pts);
+	bool _flush_fragment();
+	void _add_parameter_set(std::vector<bytes_t> &list, const uint8_t nal[], const size_t size);
+
+	void _build_ftyp(bytes_t &b) const;
+	void _build_moov(bytes_t &b) const;
+	void _build_video_trak(bytes_t &b) const;
+	void _build_audio_trak(bytes_t &b, const mp4_track_t &t) const;
+	void _build_video_stsd(bytes_t &b) const;
+	void _build_avcC(bytes_t &b) const;
+	void _build_hvcC(bytes_t &b) const;
+	void _build_stbl_tables(bytes_t &b, const mp4_track_t &t) const;
+	int64_t _composition_offset(const uint32_t decode_idx, const int64_t pts) const;
+
+	bool _copy_file_range(FILE *src, const uint64_t offset, const uint64_t size);
+};
+
+#endif // _cmp4writer__h
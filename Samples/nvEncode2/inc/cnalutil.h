@@ -0,0 +1,45 @@
+#ifndef _cnalutil__h
+#define _cnalutil__h
+
+#include "stdint.h"
+#include <stdio.h>
+#include <vector>
+
+// cnalutil : H.264/H.265 NAL-unit helpers shared by the built-in muxers (MP4, TS, MKV)
+//
+//   The encoder's output is an Annex-B byte-stream (start-code prefixed NAL-units).
+//   The MP4 and Matroska muxers store the parameter-sets (SPS/PPS/VPS) out-of-band,
+//   in an AVCDecoderConfigurationRecord ('avcC') or HEVCDecoderConfigurationRecord ('hvcC').
+
+// nal_find_start_code() - returns a pointer to the next Annex-B start-code (00 00 01), or end
+const uint8_t *
+nal_find_start_code(const uint8_t *p, const uint8_t *end);
+
+// nal_is_random_access() - the NAL-unit type starts a random-access point (a sync-sample / keyframe)
+//   H.264 : IDR (5)
+//   H.265 : IRAP = BLA/IDR/CRA (16..21); 22..23 are reserved IRAP types, not keyframes
+bool
+nal_is_random_access(const bool hevc, const unsigned type);
+
+// nal_build_avc_config() - append an AVCDecoderConfigurationRecord (ISO/IEC 14496-15 5.3.3)
+//   lengthSizeMinusOne = 3 (4-byte NAL-unit lengths)
+//   returns false if there is no usable SPS (nothing is appended then)
+bool
+nal_build_avc_config(
+	std::vector<uint8_t> &b,
+	const std::vector<std::vector<uint8_t> > &sps,
+	const std::vector<std::vector<uint8_t> > &pps
+);
+
+// nal_build_hevc_config() - append an HEVCDecoderConfigurationRecord (ISO/IEC 14496-15 8.3.3)
+//   lengthSizeMinusOne = 3 (4-byte NAL-unit lengths)
+//   returns false if there is no usable SPS (nothing is appended then)
+bool
+nal_build_hevc_config(
+	std::vector<uint8_t> &b,
+	const std::vector<std::vector<uint8_t> > &vps,
+	const std::vector<std::vector<uint8_t> > &sps,
+	const std::vector<std::vector<uint8_t> > &pps
+);
+
+#endif // _cnalutil__h
@@ -0,0 +1,67 @@
+#ifndef _cnvencsim__h
+#define _cnvencsim__h
+
+#include "stdint.h"
+
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+#include <windows.h>
+#endif
+#include "nvEncodeAPI.h"
+
+// NvEncSim : software stand-in for the NVENC driver (nvEncodeAPI64.dll)
+//
+//   NvEncodeAPICreateInstance_sim() fills an NV_ENCODE_API_FUNCTION_LIST with a
+//   host-memory implementation of the NVENC session API.  A CNvEncoder which is
+//   constructed after CNvEncoder::UseSoftwareEncodeAPI(true) is bound to it, so the
+//   encoder's queueing, pixel-format conversion and bitstream read-back code runs
+//   (and can be timed) on a machine without an NVIDIA GPU or CUDA context.
+//
+//   Emulated:
+//     - encode sessions, and the codec/profile/preset/input-format/caps queries
+//       (H.264 and HEVC)
+//     - input buffers: pitched host-memory planes (Lock/UnlockInputBuffer).
+//       Registered/mapped resources are accepted, but their memory is never read.
+//     - bitstream buffers, sync-mode (blocking LockBitstream) and async-mode
+//       completion-events
+//     - the encode engine: one thread which encodes the submitted pictures in
+//       coding-order, each one taking <latency_us>.  (So, like the hardware, the
+//       engine alone is limited to 1e6/latency_us pictures per second.)
+//     - picture-type decision (enablePTD): IDR every idrPeriod, P every frameIntervalP,
+//       and B-frames are held back and returned as NV_ENC_ERR_NEED_MORE_INPUT, so the
+//       output buffers are filled in coding-order like the hardware does.
+//
+//   The output is Annex-B shaped (parameter-sets on IDR pictures, one slice NAL-unit
+//   per picture, padded to the configured size) but it is NOT decodable video.
+
+#define NVENCSIM_DEVICE_NAME "NVENC software stand-in"
+
+typedef struct {
+	uint32_t latency_us;  // encode time per picture (microseconds)
+	uint32_t frame_bytes; // size of a P/B-picture (0 = derive from the rate-control averageBitRate)
+	uint32_t idr_scale;   // I/IDR-picture size = frame_bytes * idr_scale
+	bool     read_input;  // engine reads the whole input surface (emulates the upload DMA's memory traffic)
+} nvencsim_config_t;
+
+// pipeline timing, accumulated over all pictures since NvEncSim_ResetStats()
+//   (all times are in microseconds, summed over the pictures)
+typedef struct {
+	uint64_t frames;        // #pictures read back (UnlockBitstream)
+	uint64_t bytes;         // #bitstream bytes read back
+	double   convert_us;    // LockInputBuffer   -> UnlockInputBuffer (host pixel-format conversion)
+	double   submit_us;     // UnlockInputBuffer -> EncodePicture
+	double   queue_us;      // EncodePicture     -> engine start (reorder-delay + waiting behind earlier pictures)
+	double   encode_us;     // engine start      -> completion
+	double   drain_us;      // completion        -> LockBitstream (output-thread wakeup)
+	double   write_us;      // LockBitstream     -> UnlockBitstream (fwrite_callback)
+	uint32_t max_in_flight; // most pictures submitted but not yet read back
+	uint32_t overflows;     // pictures truncated to a too-small bitstream-buffer
+} nvencsim_stats_t;
+
+void NvEncSim_SetConfig(const nvencsim_config_t &config);// takes effect for the next picture
+void NvEncSim_GetConfig(nvencsim_config_t &config);
+void NvEncSim_ResetStats();
+void NvEncSim_GetStats(nvencsim_stats_t &stats);
+
+NVENCSTATUS NVENCAPI NvEncodeAPICreateInstance_sim(NV_ENCODE_API_FUNCTION_LIST *functionList);
+
+#endif // _cnvencsim__h
@@ -0,0 +1,114 @@
+#ifndef _cnvenctelemetry__h
+#define _cnvenctelemetry__h
+
+#include "stdint.h"
+#include <stdio.h>
+#include <atomic>
+
+// CNvEncTelemetry : per-frame records and histograms of one encode-job
+//
+//   CNvEncoder::CopyBitstreamData() (the output-thread) calls Record() once per coded frame.
+//   The records go into a fixed-size ring, which keeps the newest TELEMETRY_DEFAULT_RECORDS
+//   frames: Record() never allocates or locks, and a reader (GetRecords(), WriteCSV(),
+//   WriteJSON()) may run while the encoder is still writing.  Records which were overwritten
+//   while they were being read are dropped.  The summary and the histograms cover every frame
+//   of the job; read them (GetSummary()) after the encoder was flushed.
+//
+//   Times are in microseconds.  The rolling bitrate is measured over the last second
+//   (frame-rate) of frames, in output order.
+
+#define TELEMETRY_DEFAULT_RECORDS  (1 << 16) // ~36 minutes at 30 fps
+#define TELEMETRY_MIN_RECORDS      1024      // (>= the rolling-bitrate window)
+#define TELEMETRY_BITRATE_BINS     32        // rolling bitrate: 1/8 of the target bitrate per bin, the last bin counts the rest
+#define TELEMETRY_GOP_BINS         256       // GOP-size: exact #frames 0..254, the last bin counts longer GOPs
+#define TELEMETRY_INTERVAL_BINS    24        // output interval: bin n = [2^n, 2^(n+1)) usec (bin 0 from 0), the last bin counts the rest
+
+typedef struct {
+	uint32_t frame;         // output order (0 = first frame written)
+	uint32_t bytes;         // coded size
+	int64_t  timestamp;     // outputTimeStamp (display frame#), -1 = unknown
+	double   time_us;       // when the frame was written (since the job's first frame)
+	float    rolling_kbps;  // bitrate of the last second of frames (0 until a whole second was written)
+	float    queue_us;      // queued to the output-thread .. picked up by the output-thread
+	float    convert_us;    // input-surface lock + pixel-format conversion (+ lookahead analysis) + unlock
+	float    submit_us;     // nvEncEncodePicture()
+	float    lock_us;       // completion-event wait + nvEncLockBitstream() (or nvEncGetEncodeStats())
+	float    write_us;      // fwrite_callback
+	uint8_t  pic_type;      // NV_ENC_PIC_TYPE
+	uint8_t  avg_qp;        // frameAvgQP (0 = not reported)
+	uint8_t  scene_cut;     // the CPU lookahead forced an IDR
+	float    complexity;    // CPU lookahead complexity hint (1.0 = average of its window, 0 = no lookahead)
+} nvenc_frame_record_t;
+
+typedef struct {
+	uint64_t frames;
+	uint64_t bytes;
+	double   elapsed_us;          // first .. last frame written
+	uint32_t pic_types[8];        // #frames of each NV_ENC_PIC_TYPE (P, B, I, IDR, BI, skipped, intra-refresh, unknown)
+	uint64_t qp_total;            // sum of avg_qp over qp_frames
+	uint32_t qp_frames;           // #frames which reported frameAvgQP
+	uint32_t scene_cuts;          // #IDRs forced by the CPU lookahead
+	uint32_t target_bps;          // EncodeConfig bitrate (0 = constQP)
+	double   max_rolling_bps;
+	uint32_t max_rolling_frame;
+	double   max_interval_us;     // longest gap between two frames written (the worst stall)
+	uint32_t max_interval_frame;  // the frame which ended it
+
+	uint32_t bitrate_bin_bps;     // width of a bitrate_hist[] bin
+	uint32_t bitrate_hist[TELEMETRY_BITRATE_BINS];
+	uint32_t gop_hist[TELEMETRY_GOP_BINS];           // (includes the last, unfinished GOP)
+	uint32_t interval_hist[TELEMETRY_INTERVAL_BINS];
+} nvenc_telemetry_summary_t;
+
+class CNvEncTelemetry
+{
+public:
+	CNvEncTelemetry();
+	~CNvEncTelemetry();
+
+	// Reset() - start a new job: clears the records and histograms.
+	//   (Allocates the ring on the first call, or if the capacity changes.)
+	bool Reset(
+		const uint32_t fps_num,
+		const uint32_t fps_den,
+		const uint32_t target_bps,   // 0 = unknown (constQP)
+		const uint32_t capacity = TELEMETRY_DEFAULT_RECORDS
+	);
+
+	// Record() - [output-thread only] append a frame, rec.frame and rec.rolling_kbps are filled in.
+	//   rec.time_us must be an absolute time (e.g. from NvQueryPerformanceCounter), the
+	//   job's first frame becomes time 0.
+	void Record(nvenc_frame_record_t &rec);
+
+	// GetRecords() - copy the newest (up to max_records) records, oldest first.  returns #records copied.
+	uint32_t GetRecords(nvenc_frame_record_t *records, const uint32_t max_records) const;
+	uint32_t GetRecordCount() const;
+
+	void GetSummary(nvenc_telemetry_summary_t &summary) const;
+
+	// export the job: WriteCSV() writes one line per record,
+	//   WriteJSON() writes the summary, the histograms and the records.
+	bool WriteCSV(FILE *fp) const;
+	bool WriteJSON(FILE *fp) const;
+
+	static const char *PicTypeName(const uint8_t pic_type);
+
+protected:
+	bool _read(const uint64_t index, nvenc_frame_record_t &rec) const; // false if it was overwritten
+	uint64_t _first() const;                                            // oldest readable index
+
+	nvenc_frame_record_t *m_ring;
+	uint32_t              m_capacity; // power of 2
+	std::atomic<uint64_t> m_written;  // #records written (the ring index of the next one)
+
+	// [output-thread]
+	double                m_t0_us;
+	double                m_last_us;
+	uint32_t              m_window;       // rolling-bitrate window (#frames)
+	uint64_t              m_window_bytes;
+	double                m_fps;
+	uint32_t              m_gop_frames;   // frames in the current GOP
+	nvenc_telemetry_summary_t m_summary;
+};
+
+#endif // _cnvenctelemetry__h
@@ -0,0 +1,119 @@
+#ifndef _cnvenctwopass__h
+#define _cnvenctwopass__h
+
+#include "stdint.h"
+#include <stdio.h>
+#include <atomic>
+#include <vector>
+
+#include "cnvenctelemetry.h" // nvenc_frame_record_t
+
+// CNvEncTwoPass : whole-sequence bitrate allocation from a first (constant-QP) pass
+//
+//   Pass 1 encodes the sequence at constant QP.  CNvEncoder::CopyBitstreamData() (the
+//   output-thread) hands every coded frame to Record(), which appends its size, QP and
+//   lookahead complexity to the stats file (text, one line per frame.)  At constant QP,
+//   the coded size is the measure of how hard a frame is.
+//
+//   Plan() reads the stats file back and divides the sequence into segments, which start
+//   on a pass-1 IDR (a segment is at least TWOPASS_SEGMENT_MIN_SECONDS long; without an IDR
+//   it is cut at TWOPASS_SEGMENT_MAX_SECONDS.)  The target size of the whole sequence is
+//   then shared out over the segments: bytes ~ (pass-1 bytes)^TWOPASS_QCOMP, so the hard
+//   segments get more bits than the easy ones, but not as many more as at constant QP.
+//   Each segment gets a bitrate and the QP estimated to code it at that size.
+//
+//   In pass 2, the caller asks NextFrame() before it submits each frame; at the first frame
+//   of a segment it returns the segment's settings (for CNvEncoder::ReconfigureEncoder().)
+//   Record() counts the bytes coded so far against the plan, and the settings of the next
+//   segment correct the difference, and how far the encoder strays from the bitrates it is
+//   given (by at most +-TWOPASS_MAX_CORRECTION.)
+//
+//   Record() runs on the output-thread, everything else on the caller's (input) thread.
+
+#define TWOPASS_SEGMENT_MIN_SECONDS  4      // a segment ends at the first pass-1 IDR after this ...
+#define TWOPASS_SEGMENT_MAX_SECONDS  20     // ... or here (the reconfiguration starts a new GOP anyway)
+#define TWOPASS_QCOMP                0.6f   // bytes ~ complexity^qcomp (1.0 = constant QP, 0.0 = constant bitrate)
+#define TWOPASS_MIN_RATE_RATIO       0.25f  // segment bitrate limits, relative to the target bitrate
+#define TWOPASS_MAX_RATE_RATIO       4.0f
+#define TWOPASS_MAX_CORRECTION       0.5f   // the feedback changes a segment's bitrate by at most +-50%
+#define TWOPASS_QP_PER_DOUBLING      6.0f   // halving the QP-step (-6 QP) doubles the coded size
+#define TWOPASS_PASS1_QP             24     // pass 1: P-frame QP (the I/B-frame QPs keep their offsets)
+#define TWOPASS_STATS_VERSION        1
+
+typedef struct {
+	uint32_t first_frame;   // display frame#
+	uint32_t frames;
+	uint64_t pass1_bytes;   // coded size at the pass-1 QP
+	double   target_bytes;  // pass-2 allocation
+	uint32_t avg_bps;       // target_bytes as a bitrate
+	int      qp;            // estimated P-frame QP for target_bytes
+} twopass_segment_t;
+
+typedef struct {
+	uint32_t segment;       // index of the segment which starts at this frame
+	uint32_t avg_bps;       // corrected bitrate
+	uint32_t peak_bps;      // (0 = no peak)
+	int      qp;            // corrected QP estimate (P-frame)
+	float    correction;    // avg_bps / the planned bitrate
+} twopass_rate_t;
+
+class CNvEncTwoPass
+{
+public:
+	CNvEncTwoPass();
+
+	// pass 1
+	// BeginPass1() - start writing the stats of a sequence encoded at constant QP (qp = P-frame QP)
+	bool BeginPass1(FILE *stats, const uint32_t fps_num, const uint32_t fps_den, const int qp);
+	bool EndPass1();    // (after the encoder was flushed)  false if a write failed
+
+	// pass 2
+	// Plan() - read the stats (from the start of the file) and share out target_bps over the
+	//   sequence.  peak_bps = upper limit of a segment's bitrate (0 = none.)  false if the stats
+	//   are unreadable, or from a different frame-rate.
+	bool Plan(FILE *stats, const uint32_t target_bps, const uint32_t peak_bps);
+
+	// NextFrame() - call before submitting each frame of pass 2.  true if the frame starts a
+	//   segment: reconfigure the encoder with rate.
+	bool NextFrame(twopass_rate_t &rate);
+
+	void End();         // back to single-pass (Record() ignores the frames)
+
+	// [output-thread] pass 1: append the frame to the stats file,
+	//   pass 2: count its bytes against the plan.
+	void Record(const nvenc_frame_record_t &rec);
+
+	int      GetPass() const { return m_pass; }; // 0 = inactive
+	uint32_t GetSegmentCount() const { return static_cast<uint32_t>(m_segments.size()); };
+	const twopass_segment_t &GetSegment(const uint32_t index) const { return m_segments[index]; };
+	uint64_t GetTargetBytes() const { return static_cast<uint64_t>(m_target_bytes); };
+	uint64_t GetCodedBytes() const { return m_coded_bytes.load(std::memory_order_acquire); };
+	uint32_t GetPass1Frames() const { return static_cast<uint32_t>(m_frame_plan.size()); };
+
+protected:
+	void     _segment(const std::vector<uint8_t> &idr);
+	uint32_t _segment_of(const uint32_t frame) const;
+	void     _allocate(const double min_bytes_per_frame, const double max_bytes_per_frame);
+	int      _qp_for(const double pass1_bytes, const double target_bytes) const;
+
+	int      m_pass;
+	FILE    *m_stats;
+	bool     m_write_error;
+	uint32_t m_fps_num;
+	uint32_t m_fps_den;
+	int      m_pass1_qp;
+
+	// pass 2
+	std::vector<float>             m_frame_plan;   // [display frame#] pass-1 size, then (after Plan()) the planned size
+	std::vector<twopass_segment_t> m_segments;
+	double                         m_target_bytes;
+	uint32_t                       m_peak_bps;
+	uint32_t                       m_next_frame;   // display frame# of the next NextFrame()
+	uint32_t                       m_next_segment;
+	std::atomic<uint64_t>          m_coded_bytes;  // [output-thread] pass-2 bytes coded so far
+	std::vector<float>             m_applied;      // [segment] correction given by NextFrame() (set before its frames are submitted)
+	std::atomic<uint64_t>          m_planned_done; // [output-thread] their planned size
+	std::atomic<uint64_t>          m_requested_done; // [output-thread] their planned size x the correction in force
+};
+
+#endif // _cnvenctwopass__h
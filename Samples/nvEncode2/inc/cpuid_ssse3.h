@@ -6,4 +6,5 @@
 bool get_cpuinfo_has_sse3(); // SSE3        (Prescott 2004), haddps
 bool get_cpuinfo_has_ssse3();// Streaming SSE3 (Conroe 2006), haddpw, shuffle_epi8
 bool get_cpuinfo_has_avx();  // Intel-AVX   (Sandy Bridge 2011)
-bool get_cpuinfo_has_avx2(); // Intel-AVX2  (Haswell 2013)
\ No newline at end of file
+bool get_cpuinfo_has_avx2(); // Intel-AVX2  (Haswell 2013)
+bool get_cpuinfo_has_avx512();//Intel-AVX512 F+BW+VL (Skylake-SP 2017)
\ No newline at end of file
@@ -7,6 +7,12 @@
 #include <tmmintrin.h> // Visual Studio 2005 SSSE3 compiler intrinsics
 #include <immintrin.h> // Visual Studio 2010 AVX compiler intrinsics
 
+// AVX-512 compiler intrinsics are only available in Visual Studio 2017 (15.3) or later.
+// Older compilers build without the AVX-512 functions (and never select them at runtime.)
+#if (defined(_MSC_VER) && (_MSC_VER >= 1911)) || (defined(__AVX512BW__) && defined(__AVX512VL__))
+#define CREPACKYUV_ENABLE_AVX512
+#endif
+
 class CRepackyuv
 {
 
@@ -15,6 +21,7 @@ protected:
 	bool    m_cpu_has_avx;  // flag: CPU supports AVX256 instructions (Intel Sandy Bridge 2011)
 	bool    m_cpu_has_avx2; // flag: CPU supports AVX2   instructions (Intel Haswell      2013)
 	bool    m_cpu_has_ssse3;// flag: CPU supports Streaming SSE3 instructions (Intel Conroe 2006)
+	bool    m_cpu_has_avx512;//flag: CPU supports AVX-512 F/BW/VL instructions (Intel Skylake-SP 2017)
 
 	// SSE2 shuffle-mask values for the format-conversion functions
 	//  yuv444 : for converting 32bpp packed-pixel 4:4:4 
@@ -135,6 +142,16 @@ public:
 		unsigned char  dest_uv[]   // pointer to output UV-plane
 		);
 
+	void convert_VUYAtoNV12(  // convert packed-pixel(VUYA/VUYX 4:4:4) into 2-plane(NV12)
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance: #pixels from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_444[],  // pointer to input (VUYA packed) surface [1 pixel per 32bits]
+		const uint32_t dst_stride, // distance: #pixels from scanline(x) to scanline(x+1) [units of uint8_t]
+		unsigned char  dest_y[],   // pointer to output Y-plane
+		unsigned char  dest_uv[]   // pointer to output UV-plane
+		);
+
 protected:
 	void _convert_YUV420toNV12_avx2( // convert planar(YV12) into planar(NV12)
 		const uint32_t width,      // X-dimension (#pixels)
@@ -226,6 +243,37 @@ protected:
 		__m256i dest_uv[]  // pointer to output U-plane
 		);
 
+	void _convert_VUYAtoNV12( // convert packed-pixel(VUYA) into 2-plane(NV12), columns x_begin .. width-1
+		const uint32_t x_begin,    // first column (#pixels): must be even#
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance: #pixels from scanline(x) to scanline(x+1) [units of uint32_t]
+		const uint32_t src_444[],  // pointer to input (VUYA packed) surface
+		const uint32_t dst_stride, // distance: #pixels from scanline(x) to scanline(x+1) [units of uint8_t]
+		unsigned char  dest_y[],   // pointer to output Y-plane
+		unsigned char  dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_VUYAtoNV12_ssse3( // convert packed-pixel(VUYA) into 2-plane(NV12)
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 16
+		const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		const __m128i  src_444[],  // pointer to input (VUYA packed) surface
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		__m128i dest_y[],   // pointer to output Y-plane
+		__m128i dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_VUYAtoNV12_avx2( // convert packed-pixel(VUYA) into 2-plane(NV12)
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 32
+		const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		const __m256i  src_444[],  // pointer to input (VUYA packed) surface
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		__m256i dest_y[],   // pointer to output Y-plane
+		__m256i dest_uv[]   // pointer to output UV-plane
+		);
+
 public:
 	void convert_RGBFtoY444( // convert packed(RGB f32) into packed(YUV 8bpp)
 		const bool     use_bt709,     // color-space select
@@ -252,7 +300,353 @@ public:
 		uint8_t dest_uv[]   // pointer to output UV-plane
 	);
 
+	// 10-bit converters:
+	//    The output samples are 16-bit little-endian words, with the 10-bit value
+	//    stored in the upper bits [15:6] (lower 6 bits are zero.)  This is the
+	//    layout of NV_ENC_BUFFER_FORMAT_YUV420_10BIT (P010) and YUV444_10BIT.
+	//    Like the 8-bit RGBF converters, these flip the image vertically.
+	void convert_RGBFtoP010( // convert packed(RGB f32) into 2-plane(P010)
+		const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+		const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane  (16 bits per pixel)
+		uint8_t dest_uv[]   // pointer to output UV-plane (16 bits per U/V sample)
+	);
+
+	void convert_RGBFtoY444_16( // convert packed(RGB f32) into planar(YUV 4:4:4, 16bpc)
+		const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+		const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane (16 bits per pixel)
+		uint8_t dest_u[],   // pointer to output U-plane (16 bits per pixel)
+		uint8_t dest_v[]    // pointer to output V-plane (16 bits per pixel)
+	);
+
+	void convert_V410toP010( // convert packed(v410 4:4:4 10bpc) into 2-plane(P010)
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_v410[], // source v410 plane (32 bits per pixel: V[31:22] Y[21:12] U[11:2])
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane  (16 bits per pixel)
+		uint8_t dest_uv[]   // pointer to output UV-plane (16 bits per U/V sample)
+	);
+
+	// v210 (4:2:2 10bpc packed) converters:
+	//    6 pixels in 4 little-endian 32-bit words, three 10-bit samples per word
+	//    (bits 31:30 unused), rows padded to 128 bytes by the host.  The chroma of
+	//    scanlines (y) and (y+1) is averaged into one NV12/P010 chroma row.
+	//    Like the 8-bit 4:2:2 converter, the image is not flipped.
+	void convert_V210toNV12( // convert packed(v210 4:2:2 10bpc) into 2-plane(NV12)
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_v210[], // source v210 plane (128 bits per 6 pixels)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_uv[]   // pointer to output UV-plane
+	);
+
+	void convert_V210toP010( // convert packed(v210 4:2:2 10bpc) into 2-plane(P010)
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_v210[], // source v210 plane (128 bits per 6 pixels)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane  (16 bits per pixel)
+		uint8_t dest_uv[]   // pointer to output UV-plane (16 bits per U/V sample)
+	);
+
+	// 8/16-bit integer RGB converters:
+	//    Packed BGRA/BGRX, 8 bits (0-255) or 16 bits (0-32768, Premiere's 16u range) per channel.
+	//    The color-space conversion is done in 16-bit fixed point, with coefficients derived
+	//    from the RGB32f matrices above, so the output is within +/-2 of convert_RGBFto*() (the
+	//    fixed-point rounding differs; not bit-identical.)  The alpha channel is ignored.
+	//    Like the RGBF converters, these flip the image vertically.
+	void convert_RGBtoNV12( // convert packed(RGB 8u/16u) into 2-plane(NV12)
+		const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+		const bool     use_fullscale, // true=PC/full scale, false=video(16-235)
+		const bool     src_16u,       // source: true=16 bits per channel, false=8 bits per channel
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_rgb[],  // source BGRA plane (32 or 64 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_uv[]   // pointer to output UV-plane
+	);
+
+	void convert_RGBtoY444( // convert packed(RGB 8u/16u) into planar(YUV 4:4:4)
+		const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+		const bool     use_fullscale, // true=PC/full scale, false=video(16-235)
+		const bool     src_16u,       // source: true=16 bits per channel, false=8 bits per channel
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_rgb[],  // source BGRA plane (32 or 64 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_u[],   // pointer to output U-plane
+		uint8_t dest_v[]    // pointer to output V-plane
+	);
+
 protected:
+	// fixed-point RGB->YUV coefficients for the 8u/16u converters
+	//   Y/U/V = (B*k[0] + G*k[1] + R*k[2]) >> shift, for 8u samples (0-255)
+	//   or 16u samples pre-shifted >> 2 (0-8192, so two of them still fit an int16)
+	typedef struct {
+		int16_t  k[3][3];   // [SELECT_COLOR_Y/U/V][B, G, R]
+		uint32_t shift;     // #fraction bits
+		bool     src_16u;
+		uint8_t  offset_y;  // 16 (video-scale) or 0 (full-scale)
+	} rgb2yuv_int_coeff_t;
+
+	void _get_rgb2yuv_int_coeff(
+		const bool use_bt709,
+		const bool use_fullscale,
+		const bool src_16u,
+		rgb2yuv_int_coeff_t &coeff
+		) const;
+
+	void _convert_RGBtoNV12( // convert packed(RGB 8u/16u) into 2-plane(NV12), columns x_begin .. width-1
+		const rgb2yuv_int_coeff_t &coeff,
+		const uint32_t x_begin,    // first column (#pixels): must be even#
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_rgb[],  // source BGRA plane
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_RGBtoNV12_ssse3( // convert packed(RGB 8u/16u) into 2-plane(NV12)
+		const rgb2yuv_int_coeff_t &coeff,
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 16
+		const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		const __m128i  src_rgb[],  // source BGRA plane (4 pixels (8u) or 2 pixels (16u) per __m128i)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		__m128i dest_y[],   // pointer to output Y-plane
+		__m128i dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_RGBtoNV12_avx2( // convert packed(RGB 8u/16u) into 2-plane(NV12)
+		const rgb2yuv_int_coeff_t &coeff,
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 32
+		const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		const __m256i  src_rgb[],  // source BGRA plane (8 pixels (8u) or 4 pixels (16u) per __m256i)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		__m256i dest_y[],   // pointer to output Y-plane
+		__m256i dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_RGBtoY444( // convert packed(RGB 8u/16u) into planar(YUV 4:4:4), columns x_begin .. width-1
+		const rgb2yuv_int_coeff_t &coeff,
+		const uint32_t x_begin,    // first column (#pixels)
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_rgb[],  // source BGRA plane
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_u[],   // pointer to output U-plane
+		uint8_t dest_v[]    // pointer to output V-plane
+		);
+
+	void _convert_RGBtoY444_ssse3( // convert packed(RGB 8u/16u) into planar(YUV 4:4:4)
+		const rgb2yuv_int_coeff_t &coeff,
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 16
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		const __m128i  src_rgb[],  // source BGRA plane
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		__m128i dest_y[],   // pointer to output Y-plane
+		__m128i dest_u[],   // pointer to output U-plane
+		__m128i dest_v[]    // pointer to output V-plane
+		);
+
+	void _convert_RGBtoY444_avx2( // convert packed(RGB 8u/16u) into planar(YUV 4:4:4)
+		const rgb2yuv_int_coeff_t &coeff,
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 32
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		const __m256i  src_rgb[],  // source BGRA plane
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		__m256i dest_y[],   // pointer to output Y-plane
+		__m256i dest_u[],   // pointer to output U-plane
+		__m256i dest_v[]    // pointer to output V-plane
+		);
+
+	void _convert_RGBFtoP010( // convert packed(RGB f32) into 2-plane(P010), columns x_begin .. width-1
+		const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+		const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+		const uint32_t x_begin,    // first column (#pixels): must be even#
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_RGBFtoP010_ssse3( // convert packed(RGB f32) into 2-plane(P010)
+		const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+		const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 8
+		const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128]
+		const __m128   src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		__m128i dest_y[],   // pointer to output Y-plane
+		__m128i dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_RGBFtoP010_avx2( // convert packed(RGB f32) into 2-plane(P010)
+		const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+		const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 16
+		const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256]
+		const __m256   src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		__m256i dest_y[],   // pointer to output Y-plane
+		__m256i dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_RGBFtoY444_16( // convert packed(RGB f32) into planar(YUV 4:4:4, 16bpc), columns x_begin .. width-1
+		const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+		const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+		const uint32_t x_begin,    // first column (#pixels)
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_u[],   // pointer to output U-plane
+		uint8_t dest_v[]    // pointer to output V-plane
+		);
+
+	void _convert_RGBFtoY444_16_ssse3( // convert packed(RGB f32) into planar(YUV 4:4:4, 16bpc)
+		const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+		const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 8
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128]
+		const __m128   src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		__m128i dest_y[],   // pointer to output Y-plane
+		__m128i dest_u[],   // pointer to output U-plane
+		__m128i dest_v[]    // pointer to output V-plane
+		);
+
+	void _convert_RGBFtoY444_16_avx2( // convert packed(RGB f32) into planar(YUV 4:4:4, 16bpc)
+		const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+		const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 16
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256]
+		const __m256   src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		__m256i dest_y[],   // pointer to output Y-plane
+		__m256i dest_u[],   // pointer to output U-plane
+		__m256i dest_v[]    // pointer to output V-plane
+		);
+
+	void _convert_V410toP010( // convert packed(v410) into 2-plane(P010), columns x_begin .. width-1
+		const uint32_t x_begin,    // first column (#pixels): must be even#
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_v410[], // source v410 plane (32 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_V410toP010_ssse3( // convert packed(v410) into 2-plane(P010)
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 8
+		const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		const __m128i  src_v410[], // source v410 plane (32 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		__m128i dest_y[],   // pointer to output Y-plane
+		__m128i dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_V410toP010_avx2( // convert packed(v410) into 2-plane(P010)
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 16
+		const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		const __m256i  src_v410[], // source v410 plane (32 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		__m256i dest_y[],   // pointer to output Y-plane
+		__m256i dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_V210to420( // convert packed(v210) into 2-plane(NV12 or P010), columns x_begin .. width-1
+		const bool     p010,       // output: true=P010, false=NV12
+		const uint32_t x_begin,    // first column (#pixels): must be multiple of 6
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_v210[], // source v210 plane
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_V210toNV12_ssse3( // convert packed(v210) into 2-plane(NV12)
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 48
+		const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		const __m128i  src_v210[], // source v210 plane (one 6-pixel group per __m128i)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		__m128i dest_y[],   // pointer to output Y-plane
+		__m128i dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_V210toNV12_avx2( // convert packed(v210) into 2-plane(NV12)
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 96
+		const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		const __m256i  src_v210[], // source v210 plane (two 6-pixel groups per __m256i)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		__m256i dest_y[],   // pointer to output Y-plane
+		__m256i dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_V210toP010_ssse3( // convert packed(v210) into 2-plane(P010)
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 24
+		const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		const __m128i  src_v210[], // source v210 plane (one 6-pixel group per __m128i)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+		__m128i dest_y[],   // pointer to output Y-plane
+		__m128i dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_V210toP010_avx2( // convert packed(v210) into 2-plane(P010)
+		const uint32_t width,      // X-dimension (#pixels): must be multiple of 48
+		const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		const __m256i  src_v210[], // source v210 plane (two 6-pixel groups per __m256i)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+		__m256i dest_y[],   // pointer to output Y-plane
+		__m256i dest_uv[]   // pointer to output UV-plane
+		);
+
 	void _convert_RGBFtoY444_ssse3( // convert packed(RGB f32) into packed(YUV 8bpp)
 		const bool     use_bt709,     // color-space select
 		const bool     use_fullscale, // true=PC/full scale, false=video(16-235)
@@ -328,6 +722,73 @@ protected:
 		__m256i dest_uv[]   // pointer to output UV-plane
 		);
 
+#ifdef CREPACKYUV_ENABLE_AVX512
+	// AVX-512 versions of the converters:
+	//    The AVX-512 functions use unaligned loads/stores, and mask-registers
+	//    for the partial-vector at the right-edge of each scanline, so (unlike
+	//    the SSE/AVX functions) they have no address-alignment or framesize
+	//    requirements, and need no scalar tail-loop.
+	//    All strides are in units of uint8_t.
+	//    The RGBF kernels are bit-identical to the AVX2 kernels (not to the
+	//    SSSE3/AVX ones, which already differ from AVX2 in the last bit.)
+	void _convert_YUV420toNV12_avx512( // convert planar(YV12) into planar(NV12)
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint8_t * const src_yuv[3],
+		const uint32_t src_stride[3], // stride for src_yuv[3] [units of uint8_t]
+		uint8_t dest_nv12_luma[], uint8_t dest_nv12_chroma[],
+		const uint32_t dstStride // stride [units of uint8_t]
+		);
+
+	void _convert_YUV444toY444_avx512( // convert packed-pixel(Y444) into planar(4:4:4)
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_444[],  // pointer to input (YUV444 packed) surface
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_u[],   // pointer to output U-plane
+		uint8_t dest_v[]    // pointer to output V-plane
+		);
+
+	void _convert_YUV422toNV12_avx512( // convert packed-pixel(Y422) into 2-plane(NV12)
+		const bool     mode_uyvy,  // chroma-order: true=UYVY, false=YUYV
+		const uint32_t width,      // X-dimension (#pixels): must be even#
+		const uint32_t height,     // Y-dimension (#pixels): must be even#
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_422[],  // pointer to input (YUV422 packed) surface
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_uv[]   // pointer to output UV-plane
+		);
+
+	void _convert_RGBFtoY444_avx512( // convert packed(RGB f32) into planar(YUV 8bpp)
+		const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+		const bool     use_fullscale, // true=PC/full scale, false=video(16-235)
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_u[],   // pointer to output U-plane
+		uint8_t dest_v[]    // pointer to output V-plane
+		);
+
+	void _convert_RGBFtoNV12_avx512( // convert packed(RGB f32) into 2-plane(NV12)
+		const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+		const bool     use_fullscale, // true=PC/full scale, false=video(16-235)
+		const uint32_t width,      // X-dimension (#pixels): must be even#
+		const uint32_t height,     // Y-dimension (#pixels): must be even#
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_uv[]   // pointer to output UV-plane
+		);
+
+#endif // CREPACKYUV_ENABLE_AVX512
+
 protected:
 	typedef enum {
 		SELECT_COLOR_Y = 0,
@@ -400,6 +861,7 @@ protected:
 
 	bool m_allow_avx;  // allow AVX  (Intel Sandy Bridge 2011)
 	bool m_allow_avx2; // allow AVX2 (Intel Haswell 2013)
+	bool m_allow_avx512;//allow AVX-512 F/BW/VL (Intel Skylake-SP 2017)
 
 public:
 	CRepackyuv();
@@ -407,8 +869,10 @@ public:
 
 	bool get_cpu_allow_avx() const { return m_allow_avx; };
 	bool get_cpu_allow_avx2() const { return m_allow_avx2; };
+	bool get_cpu_allow_avx512() const { return m_allow_avx512; };
 	bool set_cpu_allow_avx(bool flag); // sets control-flag, allow_avx
 	bool set_cpu_allow_avx2(bool flag);// sets control-flag, allow_avx2
+	bool set_cpu_allow_avx512(bool flag);// sets control-flag, allow_avx512
 };
 
 #endif // #ifndef _crepackyuv__h
\ No newline at end of file
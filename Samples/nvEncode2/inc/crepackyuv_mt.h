@@ -0,0 +1,110 @@
+#ifndef _crepackyuv_mt__h
+#define _crepackyuv_mt__h
+
+#include "stdint.h"
+#include <include/NvTypes.h>
+#include <threads/NvThreadingClasses.h>
+#include "crepackyuv.h"
+
+// CRepackyuvMT : multi-threaded front-end for CRepackyuv
+//
+//   The frame is split into horizontal row-bands.  Each band starts on an
+//   even scanline and covers an even number of scanlines, so every band owns
+//   complete chroma row-pairs (NV12 UV-row y>>1 is written by exactly one band.)
+//   The bands are handed to a persistent pool of worker threads, and the
+//   calling thread converts the first band itself.
+//
+//   Each band is converted by the single-threaded CRepackyuv dispatcher, so
+//   it selects the same SSSE3/AVX/AVX2/AVX512 kernel as the whole frame would, and
+//   the output is bit-identical to the single-threaded path.
+
+#define REPACKYUV_MAX_THREADS    64  // upper limit of worker-pool size (including caller)
+#define REPACKYUV_MIN_BAND_ROWS  32  // don't split the frame into bands smaller than this
+
+class CRepackyuvMT;
+
+// per-band timing report (filled in by the most recent convert_*_mt() call)
+typedef struct {
+	uint32_t row_start;   // first source scanline of the band
+	uint32_t row_count;   // #scanlines in the band
+	uint32_t thread_idx;  // 0 = calling thread, 1..N = worker thread
+	double   elapsed_us;  // conversion time for this band (microseconds)
+} repackyuv_band_stats_t;
+
+class CRepackyuvWorkerThread : public CNvThread
+{
+public:
+	CRepackyuvWorkerThread(CRepackyuvMT *pOwner, const uint32_t thread_idx);
+	virtual ~CRepackyuvWorkerThread();
+
+	void Dispatch(const uint32_t band_idx);// assign a band and wake up the thread
+	void WaitDone();                       // block until the assigned band is finished
+
+protected:
+	virtual bool ThreadFunc();
+
+	CRepackyuvMT     *m_pOwner;
+	uint32_t          m_thread_idx;
+	volatile bool     m_bHasWork;
+	volatile uint32_t m_band_idx;
+	CNvEvent          m_evDone;  // signalled when the assigned band is finished
+};
+
+class CRepackyuvMT : public CRepackyuv
+{
+	friend class CRepackyuvWorkerThread;
+
+public:
+	CRepackyuvMT();
+	~CRepackyuvMT();
+
+	// Set the #threads (including the calling thread) used by the convert_*_mt() functions.
+	//   0 = auto (one thread per CPU core), 1 = single-threaded
+	uint32_t set_num_threads(const uint32_t num_threads);// returns actual #threads
+	uint32_t get_num_threads() const { return m_num_threads; };
+
+	// timing of the bands from the most recent conversion
+	uint32_t get_band_stats(const repackyuv_band_stats_t **p_stats) const;
+
+	void convert_RGBFtoNV12_mt( // multi-threaded convert_RGBFtoNV12()
+		const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+		const bool     use_fullscale, // true=PC/full scale, false=video(16-235)
+		const uint32_t width,      // X-dimension (#pixels)
+		const uint32_t height,     // Y-dimension (#pixels)
+		const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+		const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+		uint8_t dest_y[],   // pointer to output Y-plane
+		uint8_t dest_uv[]   // pointer to output UV-plane
+	);
+
+protected:
+	// describes the conversion currently being executed by the pool
+	typedef struct {
+		bool     use_bt709;
+		bool     use_fullscale;
+		uint32_t width;
+		uint32_t height;
+		uint32_t src_stride;
+		const uint8_t *src_rgb;
+		uint32_t dst_stride;
+		uint8_t *dest_y;
+		uint8_t *dest_uv;
+	} rgbf_nv12_job_t;
+
+	void _create_workers(const uint32_t num_workers);
+	void _destroy_workers();
+	uint32_t _split_bands(const uint32_t height); // returns #bands
+	void _run_band(const uint32_t band_idx, const uint32_t thread_idx);
+
+	uint32_t                m_num_threads;
+	uint32_t                m_num_workers;
+	CRepackyuvWorkerThread *m_workers[REPACKYUV_MAX_THREADS];
+
+	rgbf_nv12_job_t         m_job;
+	uint32_t                m_num_bands;
+	repackyuv_band_stats_t  m_band_stats[REPACKYUV_MAX_THREADS];
+	double                  m_us_per_tick;// QueryPerformanceCounter tick-period (microseconds)
+};
+
+#endif // #ifndef _crepackyuv_mt__h
@@ -0,0 +1,112 @@
+#ifndef _cspillcache__h
+#define _cspillcache__h
+
+#include "stdint.h"
+#include <stdio.h>
+
+// CSpillCache : converted input-surfaces of one encode, spilled to a scratch file and played back
+//
+//   A two-pass export renders the sequence twice.  In pass 1, CNvEncoder::EncodeFramePPro()
+//   hands each frame to Write() right after the pixel-format conversion, while the surface
+//   is still locked (NV12, P010, YUV444 or YUV444_10: the payload NVENC reads.)  In pass 2,
+//   CNvEncoder::EncodeSpilledFrame() reads the frames back into the input-surfaces, in the
+//   same order, instead of rendering and converting them again.
+//
+//   Each frame is stored without the surface padding (width x rows of each plane), and
+//   optionally compressed with a byte-oriented LZ77 in the LZ4 block layout (4-byte minimum
+//   match, 64 KB window, no entropy coding): fast enough to keep up with the render, and it
+//   still shrinks flat graphics and letterboxing.  A frame which doesn't shrink is stored as is.
+//
+//   The file never grows beyond the disk budget.  The first frame which doesn't fit (or fails
+//   to write) ends the recording: the frames before it are played back, the caller renders
+//   the rest again.
+//
+//   Single-threaded (the encoder's input-thread.)
+
+#define SPILL_CACHE_MAX_PLANES      3
+#define SPILL_CACHE_MAGIC           0x4C495053  // 'SPIL'
+#define SPILL_CACHE_HASH_BITS       14      // match-finder: 16K entries
+#define SPILL_CACHE_MIN_MATCH       4
+#define SPILL_CACHE_MAX_OFFSET      65535
+#define SPILL_CACHE_LAST_LITERALS   5       // a frame ends with at least this many literals ...
+#define SPILL_CACHE_MATCH_LIMIT     12      // ... and no match starts in its last 12 bytes
+#define SPILL_CACHE_SKIP_TRIGGER    6       // the match-finder speeds up through incompressible data
+
+// the planes of a surface: plane p is rows[p] x row_bytes[p] (no padding)
+typedef struct {
+	uint32_t planes;
+	uint32_t row_bytes[SPILL_CACHE_MAX_PLANES];
+	uint32_t rows[SPILL_CACHE_MAX_PLANES];
+} spill_layout_t;
+
+typedef struct {
+	uint32_t frames;        // frames recorded
+	uint32_t played;        // frames read back
+	uint64_t raw_bytes;     // payload before compression
+	uint64_t file_bytes;    // written to the scratch file (headers included)
+	bool     full;          // the recording ended early (disk budget, or a write failed)
+	double   write_us;      // compress + fwrite
+	double   read_us;       // fread + decompress
+} spill_stats_t;
+
+class CSpillCache
+{
+public:
+	CSpillCache();
+	~CSpillCache();
+
+	// Begin() - start recording to fp (opened "w+b" by the caller, who also deletes it.)
+	//   budget_bytes = largest file size (0 = no limit)
+	bool Begin(FILE *fp, const uint64_t budget_bytes, const bool compress);
+
+	// Write() - record a frame (plane p at planes[p], pitch bytes per row.)  false = the frame
+	//   wasn't recorded, and neither is any later one (the recording is full, or not active)
+	bool Write(const uint8_t * const planes[SPILL_CACHE_MAX_PLANES], const uint32_t pitch, const spill_layout_t &layout);
+
+	// Rewind() - end of the recording: play the frames back from the start.  false if nothing was recorded
+	bool Rewind();
+
+	// Read() - the next recorded frame, into planes[] (pitch bytes per row).  false at the end of
+	//   the recording, or if the frame is unreadable or has another layout (the caller renders it.)
+	bool Read(uint8_t * const planes[SPILL_CACHE_MAX_PLANES], const uint32_t pitch, const spill_layout_t &layout);
+
+	void End();     // stop recording/playing (frees the buffers; the caller closes the file)
+
+	bool IsRecording() const { return m_state == SPILL_RECORD; };
+	bool IsPlaying() const { return m_state == SPILL_PLAY; };
+	uint32_t GetRemaining() const { return (m_state == SPILL_PLAY) ? m_stats.frames - m_stats.played : 0; };
+	const spill_stats_t &GetStats() const { return m_stats; };
+
+	// Compress()/Decompress() - one block, in the LZ4 block layout.  dst must hold CompressBound(size)
+	//   bytes.  Decompress() returns the decoded size, or 0 if src is corrupt or doesn't fit dst.
+	static uint32_t CompressBound(const uint32_t size) { return size + size / 255 + 16; };
+	uint32_t Compress(const uint8_t *src, const uint32_t size, uint8_t *dst);
+	static uint32_t Decompress(const uint8_t *src, const uint32_t size, uint8_t *dst, const uint32_t dst_size);
+
+protected:
+	enum { SPILL_IDLE, SPILL_RECORD, SPILL_PLAY };
+
+	// frame header (file)
+	typedef struct {
+		uint32_t magic;         // SPILL_CACHE_MAGIC
+		uint32_t layout_hash;   // the frame's spill_layout_t
+		uint32_t raw_bytes;
+		uint32_t stored_bytes;  // == raw_bytes: stored as is
+	} spill_header_t;
+
+	static uint32_t _layout_bytes(const spill_layout_t &layout);
+	static uint32_t _layout_hash(const spill_layout_t &layout);
+	bool _reserve(const uint32_t raw_bytes);
+
+	int           m_state;
+	FILE         *m_fp;
+	uint64_t      m_budget;
+	bool          m_compress;
+	uint8_t      *m_raw;         // one frame, planes packed
+	uint8_t      *m_packed;      // one frame, compressed (CompressBound())
+	uint32_t      m_capacity;    // raw bytes m_raw holds
+	uint32_t     *m_hash;        // match-finder: position+1 of the last 4-byte sequence per hash (0 = none)
+	spill_stats_t m_stats;
+};
+
+#endif // _cspillcache__h
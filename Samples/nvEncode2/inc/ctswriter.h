@@ -0,0 +1,136 @@
+#ifndef _ctswriter__h
+#define _ctswriter__h
+
+#include "stdint.h"
+#include <stdio.h>
+#include <vector>
+
+#include "caudiosource.h"
+
+// CTsWriter : streaming MPEG-2 transport-stream muxer for the NVENC elementary stream
+//
+//   The encoder's Annex-B output (the bytes which CNvEncoder passes to its
+//   fwrite_callback) is fed to WriteBitstream() one access-unit at a time, and
+//   is packetized (PES -> 188-byte TS packets) and written out immediately.
+//
+//   Audio must be attached (AddPcmTrack/AddAacTrack) before the first video
+//   access-unit: the audio-file is read back frame by frame and interleaved with
+//   the video as the mux-clock passes each audio-frame's presentation time.
+//
+//   Timing model (27MHz mux-clock, written into the PCR):
+//     - video access-unit n is decoded at DTS(n) = T0 + n * frame_duration
+//     - its packets leave the mux no earlier than DTS(n) - vbv_delay, and are
+//       spaced at the mux-rate (peak video bitrate + audio + overhead).  If an
+//       access-unit is too large to reach the decoder by its DTS at that rate, its
+//       packets are squeezed closer together (the PCR never runs past the DTS.)
+//     - PCR is sent at least every 40msec, PAT/PMT every 100msec.
+//
+//   Stream layout (same PIDs as TSMUXER):  PMT 0x0100, video 0x1011, audio 0x1100
+//     video : H.264 (stream_type 0x1B) or H.265 (0x24), with access-unit delimiters;
+//             the SPS/PPS(/VPS) are repeated in front of every IDR.
+//     audio : AAC (ADTS, stream_type 0x0F) or 16-bit LPCM (Blu-ray LPCM, stream_type 0x80)
+
+typedef enum _ts_video_codec_t {
+	TS_VIDEO_NONE = 0, // audio-only transport stream
+	TS_VIDEO_AVC  = 1, // H.264
+	TS_VIDEO_HEVC = 2  // H.265
+} ts_video_codec_t;
+
+class CTsWriter
+{
+public:
+	CTsWriter();
+	~CTsWriter();
+
+	// Start a new transport stream.  (fp must be opened in binary mode "wb")
+	//   maxBitRate    : peak video bitrate (bits/sec), 0 if unknown (i.e. constQP)
+	//   vbvBufferSize : decoder buffer size (bits), 0 if unknown
+	//   reorderDelay  : max #frames an access-unit is decoded ahead of its presentation (#B-frames)
+	bool Open(
+		FILE                  *fp,
+		const ts_video_codec_t codec,
+		const uint32_t         frameRateNum,
+		const uint32_t         frameRateDen,
+		const uint32_t         maxBitRate,
+		const uint32_t         vbvBufferSize,
+		const uint32_t         reorderDelay
+	);
+
+	bool IsOpen() const { return m_fp != NULL; };
+
+	// Attach the audio (before the first WriteBitstream()).
+	//   The FILE handle must stay open until Close().
+	bool AddPcmTrack(FILE *wav); // 16-bit PCM *.WAV: 48/96KHz, mono/stereo/5.1
+	bool AddAacTrack(FILE *m4a); // *.M4A file (AAC audio in an MPEG-4 container, as written by NeroAacEnc)
+
+	// WriteBitstream() - append one block of NVENC (Annex-B) output
+	//
+	//   pts : presentation frame# of the access-unit (NV_ENC_LOCK_BITSTREAM::outputTimeStamp),
+	//         or -1 if not known (then presentation-order == decode-order is assumed.)
+	//
+	//   returns #bytes consumed (size), or 0 on error  (same convention as fwrite.)
+	size_t WriteBitstream(const uint8_t data[], const size_t size, const int64_t pts);
+
+	// Finish the stream: write out the remaining audio.
+	//   The FILE handle is not closed; the caller owns it.
+	bool Close();
+
+	uint32_t GetNumVideoFrames() const { return m_frame_count; };
+
+protected:
+	typedef std::vector<uint8_t> bytes_t;
+
+	FILE            *m_fp;
+	ts_video_codec_t m_codec;
+	bool             m_io_error;
+	bool             m_started;      // PSI/mux-rate are set up (first packet was written)
+	uint32_t         m_rate_num;     // video frame-rate
+	uint32_t         m_rate_den;
+	uint32_t         m_max_bitrate;
+	uint32_t         m_reorder_delay;
+	uint64_t         m_vbv_delay;    // (27MHz) time an access-unit may spend in the decoder buffer
+	uint64_t         m_t0;           // (90KHz) presentation time of the first video frame and audio sample
+
+	// mux-clock (27MHz)
+	uint64_t         m_clock;        // departure time of the next packet
+	uint64_t         m_packet_ticks; // packet-spacing at the nominal mux-rate
+	uint64_t         m_spacing;      // packet-spacing currently in use
+	uint64_t         m_last_pcr;
+	uint64_t         m_last_psi;
+	bool             m_pcr_sent;
+	bool             m_pcr_due;      // the next packet on the PCR-PID must carry a PCR
+	uint32_t         m_packets_since_pcr;
+	bool             m_psi_sent;
+
+	uint16_t         m_pcr_pid;
+	uint8_t          m_cc[4];        // continuity-counters: PAT, PMT, video, audio
+
+	uint32_t         m_frame_count;  // #video access-units written (decode-order)
+	int64_t          m_pts_base;     // pts of the first access-unit
+	bytes_t          m_ps;           // most recent out-of-band parameter-sets (SPS/PPS/VPS)
+
+	// audio
+	CAudioSource     m_audio;
+	uint8_t          m_audio_stream_type;
+	uint8_t          m_adts[7];      // AAC: ADTS-header template
+	uint8_t          m_lpcm_hdr[4];  // LPCM: Blu-ray audio-data-header template
+	uint32_t         m_lpcm_frames;  // LPCM: #PCM-frames per PES
+
+	bytes_t          m_video_pes;    // scratch: PES-packets being written
+	bytes_t          m_audio_pes;
+	bytes_t          m_frame;        // scratch: audio-frame
+
+	void _start();
+	void _emit(const uint8_t packet[]);
+	void _write_psi();
+	void _write_pcr_packet();
+	void _set_clock(const uint64_t t);
+	size_t _write_packet(const uint16_t pid, const bool pusi, const uint8_t payload[], const size_t size, const bool rai);
+	void _write_pes(const uint16_t pid, const uint8_t pes[], const size_t size, const bool rai);
+	uint64_t _audio_due() const;
+	void _write_due_audio(const uint64_t until);
+	bool _write_audio_frame();
+	uint64_t _video_time(const int64_t frames) const;
+};
+
+#endif // _ctswriter__h
@@ -57,6 +57,7 @@ void XCODEAPI NvDbgPrint(const char *pszFormat, ...);
 void XCODEAPI NvSleep(U32 mSec);
 bool XCODEAPI NvQueryPerformanceFrequency(U64 *freq);
 bool XCODEAPI NvQueryPerformanceCounter(U64 *counter);
+double XCODEAPI NvQueryPerformanceMicrosecs(); // NvQueryPerformanceCounter() scaled to microseconds
 
 #define RPRINTF(_exp_) NvDbgPrint _exp_
 
@@ -33,6 +33,7 @@
 #include "xcodeutil.h"
 
 #include "guidutil2.h"
+#include "cnvencsim.h"  // NvEncodeAPICreateInstance_sim()
 
 #if defined (NV_WINDOWS)
   #include <d3dx9.h>
@@ -63,11 +64,18 @@ inline BOOL Is64Bit()
     return (sizeof(void *)!=sizeof(DWORD));
 }
 
+static bool g_bUseSoftwareEncodeAPI = false; // see CNvEncoder::UseSoftwareEncodeAPI()
+
+void CNvEncoder::UseSoftwareEncodeAPI(const bool enable)
+{
+	g_bUseSoftwareEncodeAPI = enable;
+}
+
 
 CNvEncoder::CNvEncoder() :
     m_privateData(NULL), m_hEncoder(NULL), m_deviceID(0), m_dwEncodeGUIDCount(0), m_stEncodeGUIDArray(NULL), m_dwInputFmtCount(0), m_pAvailableSurfaceFmts(NULL),
     m_bEncoderInitialized(0), m_dwMaxSurfCount(0), m_dwCurrentSurfIdx(0), m_dwFrameWidth(0), m_dwFrameHeight(0),
-    m_bEncodeAPIFound(false), m_pEncodeAPI(NULL), m_cuContext(NULL), m_pEncoderThread(NULL), m_bAsyncModeEncoding(true),
+    m_bEncodeAPIFound(false), m_bSoftwareEncodeAPI(false), m_pEncodeAPI(NULL), m_cuContext(NULL), m_pEncoderThread(NULL), m_bAsyncModeEncoding(true),
     m_fOutput(NULL), m_fInput(NULL), m_dwCodecProfileGUIDCount(0), m_stCodecProfileGUIDArray(NULL), 
 	m_dwCodecPresetGUIDCount(0), m_stCodecPresetGUIDArray(NULL), m_uRefCount(0)
 #if defined (NV_WINDOWS)
@@ -75,12 +83,18 @@ CNvEncoder::CNvEncoder() :
 #endif
 {
 	m_fwrite_callback        = NULL;
+	m_pSpillCache            = NULL;
+	m_pSpareInput            = NULL;
+	m_pSpareOutput           = NULL;
+	m_lastOutputTimeStamp    = -1;
+	m_lastOutputPicType      = NV_ENC_PIC_TYPE_UNKNOWN;
     m_dwInputFormat          = NV_ENC_BUFFER_FORMAT_NV12;
     memset(&m_stInitEncParams,   0, sizeof(m_stInitEncParams));
     memset(&m_stEncoderInput,    0, sizeof(m_stEncoderInput));
     memset(&m_stInputSurface,    0, sizeof(m_stInputSurface));
     memset(&m_stBitstreamBuffer, 0, sizeof(m_stBitstreamBuffer));
     memset(&m_spspps, 0, sizeof(m_spspps));
+    memset(&m_stEOSOutputBfr, 0, sizeof(m_stEOSOutputBfr));
     SET_VER(m_stInitEncParams, NV_ENC_INITIALIZE_PARAMS);
     memset(&m_stEncodeConfig, 0, sizeof(m_stEncodeConfig));
     SET_VER(m_stEncodeConfig, NV_ENC_CONFIG);
@@ -101,9 +115,29 @@ CNvEncoder::CNvEncoder() :
 
 	m_useExternalContext = false;
 
+    memset(&m_stCompletionStats, 0, sizeof(m_stCompletionStats));
+    memset(&m_stBitstreamPool, 0, sizeof(m_stBitstreamPool));
+    m_dwBitstreamPoolLimit = 0;
+    m_qwPerfFrequency = 0;
+    NvQueryPerformanceFrequency(&m_qwPerfFrequency);
+
     NVENCSTATUS nvStatus;
     MYPROC nvEncodeAPICreateInstance; // function pointer to create instance in nvEncodeAPI
 
+    if (g_bUseSoftwareEncodeAPI)
+    {
+        // software stand-in: no driver library, and no CUDA context (InitCuda() is skipped)
+        m_hinstLib           = NULL;
+        m_bSoftwareEncodeAPI = true;
+        m_useExternalContext = true;
+        m_pEncodeAPI = new NV_ENCODE_API_FUNCTION_LIST;
+        memset(m_pEncodeAPI, 0, sizeof(NV_ENCODE_API_FUNCTION_LIST));
+        m_pEncodeAPI->version = NV_ENCODE_API_FUNCTION_LIST_VER;
+        nvStatus = NvEncodeAPICreateInstance_sim(m_pEncodeAPI);
+        m_bEncodeAPIFound = (nvStatus == NV_ENC_SUCCESS);
+        return;
+    }
+
 #if defined (NV_WINDOWS)
     if (Is64Bit())
     {
@@ -159,7 +193,6 @@ CNvEncoder::CNvEncoder() :
 #endif
         throw((const char *)("CNvEncoder::CNvEncoder() was unable to load nvEncoder Library"));
     }
-    memset(&m_stEOSOutputBfr, 0, sizeof(m_stEOSOutputBfr));
 }
 
 
@@ -266,6 +299,19 @@ unsigned int CNvEncoder::GetCodecProfile(const GUID &encodeProfileGUID) const
     return 0;
 }
 
+// GetInputBufferFormat() - NVENC input-surface format for the selected chroma-format
+//   and bit-depth.  10-bit input (P010 / YUV444_10BIT) is only available for H.265,
+//   and requires the NVENC 7.0 API.
+NV_ENC_BUFFER_FORMAT CNvEncoder::GetInputBufferFormat(const EncodeConfig &config) const
+{
+	const bool is_444 = (config.chromaFormatIDC == cudaVideoChromaFormat_444);
+#if NVENCAPI_MAJOR_VERSION >= 7
+	if ( config.pixelBitDepthMinus8 && (config.codec == NV_ENC_H265) )
+		return is_444 ? NV_ENC_BUFFER_FORMAT_YUV444_10BIT : NV_ENC_BUFFER_FORMAT_YUV420_10BIT;
+#endif
+	return is_444 ? NV_ENC_BUFFER_FORMAT_YUV444 : NV_ENC_BUFFER_FORMAT_NV12;
+}
+
 #if defined (NV_WINDOWS)
 HRESULT CNvEncoder::InitD3D9(unsigned int deviceID)
 {
@@ -456,7 +502,40 @@ HRESULT CNvEncoder::AllocateIOBuffers(unsigned int dwInputWidth, unsigned int dw
     m_dwMaxSurfCount = maxFrmCnt;
     NVENCSTATUS status = NV_ENC_SUCCESS;
 
-    printf(" > CNvEncoder::AllocateIOBuffers() = Size (%dx%d @ %d frames)\n", dwInputWidth, dwInputHeight, maxFrmCnt);
+    // bitstream-buffer pool: size the buffers for the worst-case coded frame of this EncodeConfig
+    const unsigned int dwBitstreamSize = CalculateMaxFrameSize(m_stEncoderInput);
+    {
+        EncodeConfig stUncompressed = m_stEncoderInput;
+        stUncompressed.rateControl = NV_ENC_PARAMS_RC_CONSTQP; // (no rate-limit)
+        m_dwBitstreamPoolLimit = CalculateMaxFrameSize(stUncompressed);
+
+        CNvAutoMutex lock(m_BitstreamPoolMutex);
+        memset(&m_stBitstreamPool, 0, sizeof(m_stBitstreamPool));
+        m_stBitstreamPool.buffers      = maxFrmCnt;
+        m_stBitstreamPool.initial_size = dwBitstreamSize;
+        m_stBitstreamPool.buffer_size  = dwBitstreamSize;
+    }
+
+    // per-frame telemetry: a new job
+    m_Telemetry.Reset(m_stEncoderInput.frameRateNum, m_stEncoderInput.frameRateDen,
+        (m_stEncoderInput.rateControl == NV_ENC_PARAMS_RC_CONSTQP) ? 0 : m_stEncoderInput.avgBitRate);
+
+    // CPU lookahead: the thumbnails cover the luma plane converted by EncodeFramePPro()
+    m_Lookahead.Release();
+    for (unsigned int i = 0; i < LOOKAHEAD_HINT_HISTORY; i++)
+    {
+        memset(&m_stLookaheadHints[i], 0, sizeof(m_stLookaheadHints[i]));
+        m_stLookaheadHints[i].frame = ~0u; // (no frame)
+    }
+    if (m_stEncoderInput.CPU_lookahead && CalculateLookaheadDepth(m_stEncoderInput))
+    {
+        if (m_Lookahead.Init(dwInputWidth, dwInputHeight, CalculateLookaheadDepth(m_stEncoderInput)))
+            printf(" > CNvEncoder::AllocateIOBuffers() = CPU lookahead %u frames\n", m_Lookahead.GetDepth());
+    }
+
+    printf(" > CNvEncoder::AllocateIOBuffers() = Size (%dx%d @ %d frames), bitstream-buffers %u KB\n", dwInputWidth, dwInputHeight, maxFrmCnt, dwBitstreamSize / 1024);
+    m_pSpareInput  = NULL; // (every surface goes to the queues below)
+    m_pSpareOutput = NULL;
     for (unsigned int i = 0; i < m_dwMaxSurfCount; i++)
     {
         m_stInputSurface[i].dwWidth  = dwInputWidth;
@@ -478,16 +557,17 @@ HRESULT CNvEncoder::AllocateIOBuffers(unsigned int dwInputWidth, unsigned int dw
 
                 // (1) Allocate Cuda buffer. We will use this to hold the input YUV data.
 				unsigned row_count;
+				m_stInputSurface[i].bufferFmt = GetInputBufferFormat(m_stEncoderInput);
 				if ( m_stEncoderInput.chromaFormatIDC == cudaVideoChromaFormat_420 ) {
-					m_stInputSurface[i].bufferFmt = NV_ENC_BUFFER_FORMAT_NV12;
-					row_count = dwInputHeight*3/2; // enough rows for NV12 frame
+					row_count = dwInputHeight*3/2; // enough rows for NV12 (or P010) frame
 				}
 				else {
 					// YUV 4:4:4
-					m_stInputSurface[i].bufferFmt = NV_ENC_BUFFER_FORMAT_YUV444;
 					row_count = dwInputHeight*3; // enough rows for YUV444 frame
 				}
-                result = cuMemAllocPitch(&devPtrDevice, (size_t *)&m_stInputSurface[i].dwCuPitch, dwInputWidth, row_count, 16);
+				// 10-bit formats store each sample in 16 bits
+				const unsigned bytes_per_sample = IsYUV10BitFormat(m_stInputSurface[i].bufferFmt) ? 2 : 1;
+                result = cuMemAllocPitch(&devPtrDevice, (size_t *)&m_stInputSurface[i].dwCuPitch, dwInputWidth * bytes_per_sample, row_count, 16);
                 m_stInputSurface[i].pExtAlloc      = (void*)devPtrDevice;
 				cuMemsetD8( devPtrDevice, 128, m_stInputSurface[i].dwCuPitch*row_count);// clear the memory
 
@@ -563,10 +643,7 @@ HRESULT CNvEncoder::AllocateIOBuffers(unsigned int dwInputWidth, unsigned int dw
             stAllocInputSurface.bufferFmt          = m_dwInputFormat;
 #endif
 
-			if (m_stEncoderInput.chromaFormatIDC == cudaVideoChromaFormat_420)
-				stAllocInputSurface.bufferFmt = NV_ENC_BUFFER_FORMAT_NV12;
-			else
-				stAllocInputSurface.bufferFmt = NV_ENC_BUFFER_FORMAT_YUV444;
+			stAllocInputSurface.bufferFmt = GetInputBufferFormat(m_stEncoderInput);
 
             status = m_pEncodeAPI->nvEncCreateInputBuffer(m_hEncoder, &stAllocInputSurface);
             checkNVENCErrors(status);
@@ -580,22 +657,16 @@ HRESULT CNvEncoder::AllocateIOBuffers(unsigned int dwInputWidth, unsigned int dw
         m_stInputSurfQueue.Add(&m_stInputSurface[i]);
 
         //Allocate output surface
-        m_stBitstreamBuffer[i].dwSize = 4*1024*1024;
-        NV_ENC_CREATE_BITSTREAM_BUFFER stAllocBitstream;
-        memset(&stAllocBitstream, 0, sizeof(stAllocBitstream));
-        SET_VER(stAllocBitstream, NV_ENC_CREATE_BITSTREAM_BUFFER);
-        stAllocBitstream.size                      =  m_stBitstreamBuffer[i].dwSize;
-        stAllocBitstream.memoryHeap                = NV_ENC_MEMORY_HEAP_SYSMEM_CACHED;
+        AllocateBitstreamBuffer(&m_stBitstreamBuffer[i], dwBitstreamSize);
 
-        status = m_pEncodeAPI->nvEncCreateBitstreamBuffer(m_hEncoder, &stAllocBitstream);
-        checkNVENCErrors(status);
-
-        m_stBitstreamBuffer[i].hBitstreamBuffer    = stAllocBitstream.bitstreamBuffer;
-        m_stBitstreamBuffer[i].pBitstreamBufferPtr = stAllocBitstream.bitstreamBufferPtr;
-
-        // TODO : need to fix the ucode to set the bitstream position
-        if (m_stEncoderInput.outBandSPSPPS == 0)
-            m_stBitstreamBuffer[i].pBitstreamBufferPtr = NULL;
+        // the output-thread reads the slice-offsets into this array, so it doesn't allocate per frame
+        delete_array(m_stBitstreamBuffer[i].pSliceOffsets);
+        m_stBitstreamBuffer[i].dwMaxSlices = 0;
+        if (m_stInitEncParams.reportSliceOffsets)
+        {
+            m_stBitstreamBuffer[i].dwMaxSlices   = CalculateMaxSliceCount(m_stEncoderInput);
+            m_stBitstreamBuffer[i].pSliceOffsets = new unsigned int[m_stBitstreamBuffer[i].dwMaxSlices];
+        }
 
         NV_ENC_EVENT_PARAMS nvEventParams = {0};
         SET_VER(nvEventParams, NV_ENC_EVENT_PARAMS);
@@ -630,6 +701,199 @@ HRESULT CNvEncoder::AllocateIOBuffers(unsigned int dwInputWidth, unsigned int dw
 }
 
 
+HRESULT CNvEncoder::AllocateBitstreamBuffer(EncodeOutputBuffer *pOutputBfr, const unsigned int dwSize)
+{
+    NV_ENC_CREATE_BITSTREAM_BUFFER stAllocBitstream;
+    memset(&stAllocBitstream, 0, sizeof(stAllocBitstream));
+    SET_VER(stAllocBitstream, NV_ENC_CREATE_BITSTREAM_BUFFER);
+    stAllocBitstream.size                      = dwSize;
+    stAllocBitstream.memoryHeap                = NV_ENC_MEMORY_HEAP_SYSMEM_CACHED;
+
+    NVENCSTATUS status = m_pEncodeAPI->nvEncCreateBitstreamBuffer(m_hEncoder, &stAllocBitstream);
+    checkNVENCErrors(status);
+    if (status != NV_ENC_SUCCESS)
+        return E_FAIL;
+
+    // (when re-allocating, the old buffer is only released once the new one exists)
+    ReleaseBitstreamBuffer(pOutputBfr);
+
+    pOutputBfr->dwSize              = dwSize;
+    pOutputBfr->hBitstreamBuffer    = stAllocBitstream.bitstreamBuffer;
+    pOutputBfr->pBitstreamBufferPtr = stAllocBitstream.bitstreamBufferPtr;
+
+    // TODO : need to fix the ucode to set the bitstream position
+    if (m_stEncoderInput.outBandSPSPPS == 0)
+        pOutputBfr->pBitstreamBufferPtr = NULL;
+
+    return S_OK;
+}
+
+
+void CNvEncoder::ReleaseBitstreamBuffer(EncodeOutputBuffer *pOutputBfr)
+{
+    if (pOutputBfr->hBitstreamBuffer)
+        m_pEncodeAPI->nvEncDestroyBitstreamBuffer(m_hEncoder, pOutputBfr->hBitstreamBuffer);
+
+    pOutputBfr->hBitstreamBuffer    = NULL;
+    pOutputBfr->pBitstreamBufferPtr = NULL;
+    pOutputBfr->dwSize              = 0;
+}
+
+
+// UpdateBitstreamPool() - called by the output-thread after it has read back a frame from pOutputBfr
+//   (and before pOutputBfr goes back to m_stOutputSurfQueue)
+void CNvEncoder::UpdateBitstreamPool(EncodeOutputBuffer *pOutputBfr, const unsigned int dwFrameBytes)
+{
+    unsigned int dwPoolSize;
+    {
+        CNvAutoMutex lock(m_BitstreamPoolMutex);
+        EncodeBitstreamPoolStats &pool = m_stBitstreamPool;
+        const double utilization = pOutputBfr->dwSize ? static_cast<double>(dwFrameBytes) / pOutputBfr->dwSize : 0.0;
+
+        pool.frames++;
+        pool.total_utilization += utilization;
+        if (utilization > pool.peak_utilization)
+            pool.peak_utilization = utilization;
+        if (dwFrameBytes > pool.peak_frame_bytes)
+            pool.peak_frame_bytes = dwFrameBytes;
+
+        // this frame came close to overflowing its buffer: grow the pool (to twice the frame)
+        if ((dwFrameBytes > pOutputBfr->dwSize - pOutputBfr->dwSize / BITSTREAM_POOL_HEADROOM) &&
+            (pool.buffer_size < m_dwBitstreamPoolLimit))
+        {
+            uint64_t qwSize = static_cast<uint64_t>(dwFrameBytes) * 2;
+            if (qwSize < static_cast<uint64_t>(pool.buffer_size) * 2)
+                qwSize = static_cast<uint64_t>(pool.buffer_size) * 2;
+            qwSize = (qwSize + BITSTREAM_POOL_ALIGN - 1) & ~static_cast<uint64_t>(BITSTREAM_POOL_ALIGN - 1);
+            if (qwSize > m_dwBitstreamPoolLimit)
+                qwSize = m_dwBitstreamPoolLimit;
+
+            pool.buffer_size = static_cast<unsigned int>(qwSize);
+            pool.grow_count++;
+            my_printf("CNvEncoder::UpdateBitstreamPool() frame %u bytes, bitstream-buffers grow to %u KB\n", dwFrameBytes, pool.buffer_size / 1024);
+        }
+        dwPoolSize = pool.buffer_size;
+    }
+
+    if (pOutputBfr->dwSize < dwPoolSize)
+        AllocateBitstreamBuffer(pOutputBfr, dwPoolSize);
+}
+
+
+// EncodePicture() - submit m_stEncodePicParams.  If NVENC rejects the bitstream-buffer as too small,
+//   grow it to the pool-limit and submit the picture again (rather than dropping the frame.)
+NVENCSTATUS CNvEncoder::EncodePicture(EncodeOutputBuffer *pOutputBfr)
+{
+    U64 qwStart = 0, qwEnd = 0;
+    NvQueryPerformanceCounter(&qwStart);
+    NVENCSTATUS nvStatus = m_pEncodeAPI->nvEncEncodePicture(m_hEncoder, &m_stEncodePicParams);
+
+    if ((nvStatus == NV_ENC_ERR_NOT_ENOUGH_BUFFER) && pOutputBfr && (pOutputBfr->dwSize < m_dwBitstreamPoolLimit))
+    {
+        {
+            CNvAutoMutex lock(m_BitstreamPoolMutex);
+            if (m_stBitstreamPool.buffer_size < m_dwBitstreamPoolLimit) {
+                m_stBitstreamPool.buffer_size = m_dwBitstreamPoolLimit;
+                m_stBitstreamPool.grow_count++;
+            }
+        }
+
+        if (AllocateBitstreamBuffer(pOutputBfr, m_dwBitstreamPoolLimit) == S_OK)
+        {
+            m_stEncodePicParams.outputBitstream = pOutputBfr->hBitstreamBuffer;
+            nvStatus = m_pEncodeAPI->nvEncEncodePicture(m_hEncoder, &m_stEncodePicParams);
+        }
+    }
+
+    NvQueryPerformanceCounter(&qwEnd);
+    if (pOutputBfr)
+        pOutputBfr->qwSubmitTicks = qwEnd - qwStart;
+    return nvStatus;
+}
+
+
+void CNvEncoder::GetBitstreamPoolStats(EncodeBitstreamPoolStats &stats) const
+{
+    CNvAutoMutex lock(m_BitstreamPoolMutex);
+    stats = m_stBitstreamPool;
+}
+
+
+unsigned int CNvEncoder::CalculateMaxSliceCount(const EncodeConfig &config)
+{
+    const unsigned int width  = (config.maxWidth  > config.width)  ? config.maxWidth  : config.width;
+    const unsigned int height = (config.maxHeight > config.height) ? config.maxHeight : config.height;
+
+    // a slice holds at least one 16x16 macroblock (or HEVC CTB, which is no smaller), whatever the sliceMode
+    const unsigned int dwMBRows = (height + 15) / 16;
+    const unsigned int dwMBs    = ((width + 15) / 16) * dwMBRows;
+    const unsigned int dwData   = (config.sliceModeData > 0) ? static_cast<unsigned int>(config.sliceModeData) : 1;
+
+    unsigned int dwSlices;
+    switch (config.sliceMode)
+    {
+        case 0:  dwSlices = (dwMBs + dwData - 1) / dwData;    break; // sliceModeData = MBs per slice
+        case 2:  dwSlices = (dwMBRows + dwData - 1) / dwData; break; // sliceModeData = MB-rows per slice
+        case 3:  dwSlices = dwData;                           break; // sliceModeData = #slices per picture
+        default: dwSlices = dwMBs;                            break; // 1: sliceModeData = bytes per slice
+    }
+
+    if (dwSlices > dwMBs)
+        dwSlices = dwMBs;
+    return dwSlices ? dwSlices : 1;
+}
+
+
+unsigned int CNvEncoder::CalculateMaxFrameSize(const EncodeConfig &config)
+{
+    const uint64_t width  = (config.maxWidth  > config.width)  ? config.maxWidth  : config.width;
+    const uint64_t height = (config.maxHeight > config.height) ? config.maxHeight : config.height;
+
+    // uncompressed frame: a coded frame is never larger than this (plus slice/parameter-set overhead),
+    //  since the encoder falls back to PCM-coding.  This is also the bound for lossless and ConstQP encoding.
+    uint64_t qwSamples = width * height;
+    qwSamples = (config.chromaFormatIDC == cudaVideoChromaFormat_444) ? (qwSamples * 3) : (qwSamples * 3 / 2);
+    uint64_t qwMaxBytes = qwSamples * (8 + config.pixelBitDepthMinus8) / 8;
+    qwMaxBytes += qwMaxBytes / 8 + BITSTREAM_POOL_MIN_SIZE;
+
+    const bool bLossless = (config.qpPrimeYZeroTransformBypassFlag != 0);
+    if (!bLossless && (config.rateControl != NV_ENC_PARAMS_RC_CONSTQP))
+    {
+        // rate-controlled: a frame doesn't exceed the VBV (HRD) buffer.
+        uint64_t qwVbvBytes = 0;
+        if (config.vbvBufferSize)
+        {
+            // 2x headroom: with a small VBV, the rate-control overshoots on scene-changes and the first IDR
+            qwVbvBytes = (static_cast<uint64_t>(config.vbvBufferSize) / 8) * 2;
+        }
+        else
+        {
+            // vbvBufferSize 0 (auto): NVENC sizes the VBV for ~1 second at the peak bitrate,
+            // which it clamps to the level's max bitrate
+            const uint32_t kbps = (config.codec == NV_ENC_H265) ?
+                NVENC_Calculate_HEVC_MaxKBitRate(static_cast<NV_ENC_LEVEL>(config.level), static_cast<NV_ENC_LEVEL>(config.tier)) :
+                NVENC_Calculate_H264_MaxKBitRate(static_cast<NV_ENC_LEVEL>(config.level), static_cast<enum_NV_ENC_H264_PROFILE>(config.profile));
+
+            uint64_t qwBitRate = (config.peakBitRate > config.avgBitRate) ? config.peakBitRate : config.avgBitRate;
+            if (!qwBitRate || (kbps && (static_cast<uint64_t>(kbps) * 1000 < qwBitRate)))
+                qwBitRate = static_cast<uint64_t>(kbps) * 1000;
+            qwVbvBytes = qwBitRate / 8;
+        }
+
+        if (qwVbvBytes && (qwVbvBytes + BITSTREAM_POOL_MIN_SIZE < qwMaxBytes))
+            qwMaxBytes = qwVbvBytes + BITSTREAM_POOL_MIN_SIZE;
+    }
+
+    if (qwMaxBytes < BITSTREAM_POOL_MIN_SIZE)
+        qwMaxBytes = BITSTREAM_POOL_MIN_SIZE;
+    qwMaxBytes = (qwMaxBytes + BITSTREAM_POOL_ALIGN - 1) & ~static_cast<uint64_t>(BITSTREAM_POOL_ALIGN - 1);
+    if (qwMaxBytes > 0xFFF00000ULL)
+        qwMaxBytes = 0xFFF00000ULL;
+
+    return static_cast<unsigned int>(qwMaxBytes);
+}
+
+
 HRESULT CNvEncoder::ReleaseIOBuffers()
 {
 	if ( m_hEncoder == NULL )
@@ -674,8 +938,9 @@ HRESULT CNvEncoder::ReleaseIOBuffers()
             m_pEncodeAPI->nvEncDestroyInputBuffer(m_hEncoder, m_stInputSurface[i].hInputSurface);
             m_stInputSurface[i].hInputSurface = NULL;
         }
-        m_pEncodeAPI->nvEncDestroyBitstreamBuffer(m_hEncoder, m_stBitstreamBuffer[i].hBitstreamBuffer);
-        m_stBitstreamBuffer[i].hBitstreamBuffer = NULL;
+        ReleaseBitstreamBuffer(&m_stBitstreamBuffer[i]);
+        delete_array(m_stBitstreamBuffer[i].pSliceOffsets);
+        m_stBitstreamBuffer[i].dwMaxSlices = 0;
 
         NV_ENC_EVENT_PARAMS nvEventParams = {0};
         SET_VER(nvEventParams, NV_ENC_EVENT_PARAMS);
@@ -698,6 +963,8 @@ HRESULT CNvEncoder::ReleaseIOBuffers()
 #endif
         m_stEOSOutputBfr.hOutputEvent  = NULL;
     }
+
+    m_Lookahead.Release();
     return S_OK;
 }
 
@@ -736,6 +1003,12 @@ HRESULT CNvEncoder::CopyBitstreamData(EncoderThreadData stThreadData)
     NVENCSTATUS nvStatus = NV_ENC_SUCCESS;
     HRESULT hr = S_OK;
 
+    // telemetry: when the output-thread picked up the buffer, got its bitstream, and wrote it out
+    U64 qwDequeued = 0, qwLockStart = 0, qwLocked = 0, qwWritten = 0;
+    nvenc_frame_record_t stRecord;
+    memset(&stRecord, 0, sizeof(stRecord));
+    NvQueryPerformanceCounter(&qwDequeued);
+
     if (stThreadData.pOutputBfr->hBitstreamBuffer == NULL && stThreadData.pOutputBfr->bEOSFlag == false)
     {
         return E_FAIL;
@@ -759,6 +1032,7 @@ HRESULT CNvEncoder::CopyBitstreamData(EncoderThreadData stThreadData)
         nvStatus = NV_ENC_SUCCESS;
     }
 
+    NvQueryPerformanceCounter(&qwLockStart);
     if (stThreadData.pOutputBfr->bWaitOnEvent == true)
     {
         if (!stThreadData.pOutputBfr->hOutputEvent)
@@ -785,9 +1059,7 @@ HRESULT CNvEncoder::CopyBitstreamData(EncoderThreadData stThreadData)
     memset(&lockBitstreamData, 0, sizeof(lockBitstreamData));
     SET_VER(lockBitstreamData, NV_ENC_LOCK_BITSTREAM);
 
-    if(m_stInitEncParams.reportSliceOffsets)
-        lockBitstreamData.sliceOffsets = new unsigned int[m_stEncoderInput.sliceModeData];
-
+    lockBitstreamData.sliceOffsets = stThreadData.pOutputBfr->pSliceOffsets; // NULL unless reportSliceOffsets
     lockBitstreamData.outputBitstream = stThreadData.pOutputBfr->hBitstreamBuffer;
     lockBitstreamData.doNotWait = false;
 
@@ -796,9 +1068,19 @@ HRESULT CNvEncoder::CopyBitstreamData(EncoderThreadData stThreadData)
         nvStatus = m_pEncodeAPI->nvEncLockBitstream(m_hEncoder, &lockBitstreamData);
         if (nvStatus == NV_ENC_SUCCESS)
         {
+            NvQueryPerformanceCounter(&qwLocked);
+            RecordCompletion(stThreadData.pOutputBfr);
+            m_lastOutputTimeStamp = static_cast<int64_t>(lockBitstreamData.outputTimeStamp);
+            m_lastOutputPicType = lockBitstreamData.pictureType;
             (*m_fwrite_callback)(lockBitstreamData.bitstreamBufferPtr, 1, lockBitstreamData.bitstreamSizeInBytes, m_fOutput, m_privateData);
+            NvQueryPerformanceCounter(&qwWritten);
+            stRecord.bytes     = lockBitstreamData.bitstreamSizeInBytes;
+            stRecord.timestamp = m_lastOutputTimeStamp;
+            stRecord.pic_type  = static_cast<uint8_t>(lockBitstreamData.pictureType);
+            stRecord.avg_qp    = static_cast<uint8_t>(lockBitstreamData.frameAvgQP < 255 ? lockBitstreamData.frameAvgQP : 255);
             nvStatus = m_pEncodeAPI->nvEncUnlockBitstream(m_hEncoder, stThreadData.pOutputBfr->hBitstreamBuffer);
             checkNVENCErrors(nvStatus);
+            UpdateBitstreamPool(stThreadData.pOutputBfr, lockBitstreamData.bitstreamSizeInBytes);
         }
     }
     else
@@ -808,7 +1090,39 @@ HRESULT CNvEncoder::CopyBitstreamData(EncoderThreadData stThreadData)
         SET_VER(stEncodeStats, NV_ENC_STAT);
         stEncodeStats.outputBitStream = stThreadData.pOutputBfr->hBitstreamBuffer;
         nvStatus = m_pEncodeAPI->nvEncGetEncodeStats(m_hEncoder, &stEncodeStats);
+        NvQueryPerformanceCounter(&qwLocked);
+        RecordCompletion(stThreadData.pOutputBfr);
+        m_lastOutputTimeStamp = -1; // NV_ENC_STAT doesn't report the timestamp
+        m_lastOutputPicType = static_cast<NV_ENC_PIC_TYPE>(stEncodeStats.picType);
         (*m_fwrite_callback)(stThreadData.pOutputBfr->pBitstreamBufferPtr, 1, stEncodeStats.bitStreamSize, m_fOutput, m_privateData);
+        NvQueryPerformanceCounter(&qwWritten);
+        UpdateBitstreamPool(stThreadData.pOutputBfr, stEncodeStats.bitStreamSize);
+        stRecord.bytes     = stEncodeStats.bitStreamSize;
+        stRecord.timestamp = -1;
+        stRecord.pic_type  = static_cast<uint8_t>(stEncodeStats.picType);
+        stRecord.avg_qp    = 0; // (NV_ENC_STAT doesn't report it)
+    }
+
+    if (qwWritten)
+    {
+        // per-frame telemetry (lock-free, no allocation)
+        const EncodeOutputBuffer *pOutputBfr = stThreadData.pOutputBfr;
+        stRecord.time_us    = TicksToUs(qwWritten);
+        stRecord.queue_us   = pOutputBfr->qwSubmitTime ? static_cast<float>(TicksToUs(qwDequeued - pOutputBfr->qwSubmitTime)) : 0.0f;
+        stRecord.convert_us = static_cast<float>(TicksToUs(pOutputBfr->qwConvertTicks));
+        stRecord.submit_us  = static_cast<float>(TicksToUs(pOutputBfr->qwSubmitTicks));
+        stRecord.lock_us    = static_cast<float>(TicksToUs(qwLocked - qwLockStart));
+        stRecord.write_us   = static_cast<float>(TicksToUs(qwWritten - qwLocked));
+
+        lookahead_hint_t stHint;
+        if ((stRecord.timestamp >= 0) && GetLookaheadHint(static_cast<unsigned int>(stRecord.timestamp), stHint))
+        {
+            stRecord.scene_cut  = stHint.scene_cut ? 1 : 0;
+            stRecord.complexity = stHint.complexity;
+        }
+        m_Telemetry.Record(stRecord);
+        if (m_TwoPass.GetPass())
+            m_TwoPass.Record(stRecord);
     }
 
     if (!m_stOutputSurfQueue.Add(stThreadData.pOutputBfr))
@@ -821,9 +1135,6 @@ HRESULT CNvEncoder::CopyBitstreamData(EncoderThreadData stThreadData)
         assert(0);
     }
 
-    if(lockBitstreamData.sliceOffsets)
-        delete(lockBitstreamData.sliceOffsets);
-
     if (nvStatus != NV_ENC_SUCCESS)
         hr = E_FAIL;
 
@@ -1019,6 +1330,14 @@ HRESULT CNvEncoder::FlushEncoder()
 {
     NVENCSTATUS nvStatus = NV_ENC_SUCCESS;
     HRESULT hr = S_OK;
+
+    // submit the frames held back by the CPU lookahead (the end of the sequence decides them)
+    if (m_Lookahead.IsEnabled())
+    {
+        hr = DrainLookahead(true);
+        m_Lookahead.Reset();
+    }
+
     memset(&m_stEncodePicParams, 0, sizeof(m_stEncodePicParams));
     SET_VER(m_stEncodePicParams, NV_ENC_PIC_PARAMS);
     // This EOS even signals indicates that all frames in the NVENC input queue have been flushed to the 
@@ -1135,24 +1454,268 @@ HRESULT CNvEncoder::WaitForCompletion()
 {
     if (m_pEncoderThread)
     {
-        bool bIdle = false;
-
-        do {
-            m_pEncoderThread->ThreadLock();
-            bIdle = m_pEncoderThread->IsIdle();
-            m_pEncoderThread->ThreadUnlock();
-            if (!bIdle)
-            {
-                m_pEncoderThread->ThreadTrigger();
-                NvSleep(1);
-            }
-        } while (!bIdle);
+        // the output-thread signals when it has written out the last queued bitstream-buffer
+        m_pEncoderThread->WaitIdle(INFINITE);
     }
 
     return S_OK;
 }
 
 
+void CNvEncoder::RecordCompletion(const EncodeOutputBuffer *pOutputBfr)
+{
+    U64 qwNow = 0;
+    NvQueryPerformanceCounter(&qwNow);
+    if (!m_qwPerfFrequency || !pOutputBfr->qwSubmitTime)
+        return;
+
+    const double us = static_cast<double>(qwNow - pOutputBfr->qwSubmitTime) * 1000000.0 / static_cast<double>(m_qwPerfFrequency);
+
+    CNvAutoMutex lock(m_CompletionStatsMutex);
+    m_stCompletionStats.frames++;
+    m_stCompletionStats.total_us += us;
+    m_stCompletionStats.last_us   = us;
+    if (us > m_stCompletionStats.max_us)
+        m_stCompletionStats.max_us = us;
+}
+
+
+double CNvEncoder::TicksToUs(const U64 qwTicks) const
+{
+    return m_qwPerfFrequency ? static_cast<double>(qwTicks) * 1000000.0 / static_cast<double>(m_qwPerfFrequency) : 0.0;
+}
+
+
+void CNvEncoder::GetCompletionStats(EncodeCompletionStats &stats) const
+{
+    CNvAutoMutex lock(m_CompletionStatsMutex);
+    stats = m_stCompletionStats;
+}
+
+
+unsigned int CNvEncoder::CalculateLookaheadDepth(const EncodeConfig &config)
+{
+    // the encoder needs numBFrames + 4 + 1 input-surfaces of its own (see InitializeEncoderCodec())
+    const unsigned int dwPipeline = config.numBFrames + 4 + 1;
+    unsigned int dwDepth = (config.CPU_lookahead < LOOKAHEAD_MAX_DEPTH) ? config.CPU_lookahead : LOOKAHEAD_MAX_DEPTH;
+
+    if (dwPipeline >= MAX_INPUT_QUEUE)
+        return 0;
+    if (dwDepth > MAX_INPUT_QUEUE - dwPipeline)
+        dwDepth = MAX_INPUT_QUEUE - dwPipeline;
+    return dwDepth;
+}
+
+
+bool CNvEncoder::GetLookaheadHint(const unsigned int dwFrameNum, lookahead_hint_t &hint) const
+{
+    const lookahead_hint_t &stHint = m_stLookaheadHints[dwFrameNum % LOOKAHEAD_HINT_HISTORY];
+    if (!m_Lookahead.IsEnabled() || (stHint.frame != dwFrameNum))
+        return false;
+
+    hint = stHint;
+    return true;
+}
+
+
+void CNvEncoder::StoreLookaheadHint(const unsigned int dwFrameNum, const lookahead_hint_t &hint)
+{
+    lookahead_hint_t &stHint = m_stLookaheadHints[dwFrameNum % LOOKAHEAD_HINT_HISTORY];
+    stHint = hint;
+    stHint.frame = dwFrameNum; // (the lookahead counts from its last Reset(): key the hint by display frame#)
+}
+
+
+HRESULT CNvEncoder::QueueLookahead(EncodeInputSurfaceInfo *pInput, EncodeOutputBuffer *pOutputBitstream, const NV_ENC_PIC_STRUCT pictureStruct)
+{
+    EncodeLookaheadFrame stFrame;
+    stFrame.pInputBfr     = pInput;
+    stFrame.pOutputBfr    = pOutputBitstream;
+    stFrame.pictureStruct = pictureStruct;
+
+    // (never blocks: the lookahead holds at most depth+1 frames)
+    if (!m_LookaheadQueue.Add(stFrame, 0))
+    {
+        assert(0);
+        return E_FAIL;
+    }
+    return DrainLookahead(false);
+}
+
+
+HRESULT CNvEncoder::DrainLookahead(const bool bAll)
+{
+    HRESULT hr = S_OK;
+    const unsigned int dwHoldBack = bAll ? 0 : m_Lookahead.GetDepth();
+
+    while (m_Lookahead.Pending() > dwHoldBack)
+    {
+        lookahead_hint_t stHint;
+        EncodeLookaheadFrame stFrame;
+
+        m_Lookahead.Decide(stHint);
+        if (!m_LookaheadQueue.Remove(stFrame, 0))
+        {
+            assert(0);
+            return E_FAIL;
+        }
+
+        if (SubmitPicture(stFrame.pInputBfr, stFrame.pOutputBfr, stFrame.pictureStruct, &stHint) != S_OK)
+            hr = E_FAIL;
+    }
+    return hr;
+}
+
+
+void CNvEncoder::AcquireSurfaces(EncodeInputSurfaceInfo *&pInput, EncodeOutputBuffer *&pOutputBitstream)
+{
+    if (m_pSpareInput)
+    {
+        pInput           = m_pSpareInput;
+        pOutputBitstream = m_pSpareOutput;
+        m_pSpareInput    = NULL;
+        m_pSpareOutput   = NULL;
+        return;
+    }
+
+    if (!m_stInputSurfQueue.Remove(pInput, INFINITE))
+    {
+        assert(0);
+    }
+
+    if (!m_stOutputSurfQueue.Remove(pOutputBitstream, INFINITE))
+    {
+        assert(0);
+    }
+}
+
+
+void CNvEncoder::GetSpillLayout(const EncodeInputSurfaceInfo *pInput, unsigned char *pInputSurface,
+    const unsigned int lockedPitch, spill_layout_t &layout, uint8_t *planes[SPILL_CACHE_MAX_PLANES]) const
+{
+    // (the layout EncodeFramePPro() converts into: the chroma plane(s) start at the 32-aligned height)
+    const unsigned int dwSurfHeight = (pInput->dwHeight + 0x1f) & ~0x1f;
+    const unsigned int dwRowBytes   = pInput->dwWidth * (IsYUV10BitFormat(pInput->bufferFmt) ? 2 : 1);
+
+    memset(&layout, 0, sizeof(layout));
+    memset(planes, 0, sizeof(uint8_t *) * SPILL_CACHE_MAX_PLANES);
+    layout.planes       = (m_stEncoderInput.chromaFormatIDC == cudaVideoChromaFormat_444) ? 3 : 2;
+    layout.row_bytes[0] = dwRowBytes;
+    layout.rows[0]      = pInput->dwHeight;
+    planes[0]           = pInputSurface;
+    for (unsigned int p = 1; p < layout.planes; p++)
+    {
+        layout.row_bytes[p] = dwRowBytes; // (NV12/P010: interleaved UV, half the rows)
+        layout.rows[p]      = (layout.planes == 3) ? pInput->dwHeight : (pInput->dwHeight + 1) / 2;
+        planes[p]           = pInputSurface + p * dwSurfHeight * lockedPitch;
+    }
+}
+
+
+void CNvEncoder::SpillInputSurface(const EncodeInputSurfaceInfo *pInput, unsigned char *pInputSurface, const unsigned int lockedPitch)
+{
+    if (!m_pSpillCache || !m_pSpillCache->IsRecording())
+        return;
+
+    spill_layout_t layout;
+    uint8_t *planes[SPILL_CACHE_MAX_PLANES];
+    GetSpillLayout(pInput, pInputSurface, lockedPitch, layout, planes);
+    m_pSpillCache->Write(planes, lockedPitch, layout); // (when the cache is full, the frame is rendered again)
+}
+
+
+HRESULT CNvEncoder::EncodeSpilledFrame(const EncodeFrameConfig *pEncodeFrame)
+{
+    if (!pEncodeFrame || !m_pSpillCache || !m_pSpillCache->GetRemaining())
+        return S_FALSE;
+
+    EncodeInputSurfaceInfo  *pInput;
+    EncodeOutputBuffer      *pOutputBitstream;
+    AcquireSurfaces(pInput, pOutputBitstream);
+
+    // the cache replaces the render and the pixel-format conversion
+    unsigned int lockedPitch = 0;
+    spill_layout_t layout;
+    uint8_t *planes[SPILL_CACHE_MAX_PLANES];
+    U64 qwReadStart = 0, qwReadEnd = 0; // (telemetry: counted as the conversion)
+
+    NvQueryPerformanceCounter(&qwReadStart);
+    unsigned char *pInputSurface = LockInputBuffer(pInput->hInputSurface, &lockedPitch);
+    GetSpillLayout(pInput, pInputSurface, lockedPitch, layout, planes);
+    const bool bPlayed = m_pSpillCache->Read(planes, lockedPitch, layout);
+    if (bPlayed && m_Lookahead.IsEnabled())
+    {
+        m_Lookahead.Analyze(pInputSurface, lockedPitch, IsYUV10BitFormat(pInput->bufferFmt) ? 2 : 1);
+    }
+    UnlockInputBuffer(pInput->hInputSurface);
+    NvQueryPerformanceCounter(&qwReadEnd);
+
+    if (!bPlayed)
+    {
+        // nothing was submitted: keep the surfaces for the next frame (only the output-thread adds to the queues)
+        m_pSpareInput  = pInput;
+        m_pSpareOutput = pOutputBitstream;
+        return S_FALSE;
+    }
+    pOutputBitstream->qwConvertTicks = qwReadEnd - qwReadStart;
+
+    const NV_ENC_PIC_STRUCT pictureStruct = pEncodeFrame->fieldPicflag ?
+        (pEncodeFrame->topField ? NV_ENC_PIC_STRUCT_FIELD_TOP_BOTTOM : NV_ENC_PIC_STRUCT_FIELD_BOTTOM_TOP) :
+        NV_ENC_PIC_STRUCT_FRAME;
+
+    if (m_Lookahead.IsEnabled())
+        return QueueLookahead(pInput, pOutputBitstream, pictureStruct);
+
+    return SubmitPicture(pInput, pOutputBitstream, pictureStruct, NULL);
+}
+
+
+static unsigned int _twopass_qp(const int iQP)
+{
+    return (iQP < 0) ? 0 : (iQP > 51) ? 51 : static_cast<unsigned int>(iQP);
+}
+
+
+void CNvEncoder::SetTwoPassAnalysisConfig(EncodeConfig &config)
+{
+    const int iOffsetI = static_cast<int>(config.qpI) - static_cast<int>(config.qpP);
+    const int iOffsetB = static_cast<int>(config.qpB) - static_cast<int>(config.qpP);
+
+    config.rateControl = NV_ENC_PARAMS_RC_CONSTQP;
+    config.qpP         = TWOPASS_PASS1_QP;
+    config.qpI         = _twopass_qp(TWOPASS_PASS1_QP + iOffsetI);
+    config.qpB         = _twopass_qp(TWOPASS_PASS1_QP + iOffsetB);
+    config.avgBitRate  = 0;
+    config.peakBitRate = 0;
+}
+
+
+void CNvEncoder::SetTwoPassSegmentConfig(EncodeConfig &config, const twopass_rate_t &rate)
+{
+    if (config.rateControl == NV_ENC_PARAMS_RC_CONSTQP)
+    {
+        const int iOffsetI = static_cast<int>(config.qpI) - static_cast<int>(config.qpP);
+        const int iOffsetB = static_cast<int>(config.qpB) - static_cast<int>(config.qpP);
+        config.qpP = _twopass_qp(rate.qp);
+        config.qpI = _twopass_qp(rate.qp + iOffsetI);
+        config.qpB = _twopass_qp(rate.qp + iOffsetB);
+        return;
+    }
+
+    const int iOffsetI = static_cast<int>(config.initial_qpI) - static_cast<int>(config.initial_qpP);
+    const int iOffsetB = static_cast<int>(config.initial_qpB) - static_cast<int>(config.initial_qpP);
+    config.avgBitRate = rate.avg_bps;
+    if (config.peakBitRate && config.peakBitRate < rate.avg_bps)
+        config.peakBitRate = rate.avg_bps;
+
+    // the reset restarts the rate-control: start it at the QP estimated for the segment
+    config.initial_qp_ena = true;
+    config.initial_qpP    = _twopass_qp(rate.qp);
+    config.initial_qpI    = _twopass_qp(rate.qp + iOffsetI);
+    config.initial_qpB    = _twopass_qp(rate.qp + iOffsetB);
+}
+
+
 // Encoder thread
 bool CNvEncoderThread::ThreadFunc()
 {
@@ -1160,6 +1723,7 @@ bool CNvEncoderThread::ThreadFunc()
     while (m_pEncoderQueue.Remove(stThreadData, 0))
     {
         m_pOwner->CopyBitstreamData(stThreadData);
+        CompleteSample();
     }
     return false;
 }
@@ -1167,12 +1731,31 @@ bool CNvEncoderThread::ThreadFunc()
 
 bool CNvEncoderThread::QueueSample(EncoderThreadData &sThreadData)
 {
+    {
+        CNvAutoMutex lock(m_PendingMutex);
+        if (m_dwPendingSamples++ == 0)
+            m_evIdle.Reset();
+    }
+
+    // the picture was just (successfully) submitted to NVENC: start its completion-latency clock
+    NvQueryPerformanceCounter(&sThreadData.pOutputBfr->qwSubmitTime);
+
     bool bIsEnqueued = m_pEncoderQueue.Add(sThreadData);
+    if (!bIsEnqueued)
+        CompleteSample();
     ThreadTrigger();
     return bIsEnqueued;
 }
 
 
+void CNvEncoderThread::CompleteSample()
+{
+    CNvAutoMutex lock(m_PendingMutex);
+    if (m_dwPendingSamples && --m_dwPendingSamples == 0)
+        m_evIdle.Set();
+}
+
+
 // GetPresetConfig():
 //    Gets the requested NVENC preset and stores it in this.m_stPresetConfig 
 //    Note, if requested preset is 'default' (0), then allow any preset to be returned.
@@ -1500,18 +2083,13 @@ HRESULT CNvEncoder::OpenEncodeSession(const EncodeConfig encodeConfig, const uns
         }
         else  {
             bool bFmtFound = false;
-			bool bFound_420 = false;
-			bool bFound_444 = false;
+			const NV_ENC_BUFFER_FORMAT requested_fmt = GetInputBufferFormat(encodeConfig);
 			unsigned int idx;
             for (idx = 0; idx < m_dwInputFmtCount; idx++)
             {
                 // check if this HW-codec supports the requested (framebuffer) InputFormat 
-                bFound_420 = encodeConfig.chromaFormatIDC == cudaVideoChromaFormat_420 &&
-						(m_pAvailableSurfaceFmts[idx] == NV_ENC_BUFFER_FORMAT_NV12);
-
-				bFound_444 = encodeConfig.chromaFormatIDC == cudaVideoChromaFormat_444 &&
-                        (m_pAvailableSurfaceFmts[idx] == NV_ENC_BUFFER_FORMAT_YUV444);
-				if ( bFound_420 || bFound_444 )
+				//   (NV12, YUV444, or their 10-bit counterparts)
+				if ( m_pAvailableSurfaceFmts[idx] == requested_fmt )
 				{
 		            m_dwInputFormat = m_pAvailableSurfaceFmts[idx];
 					bFmtFound = true;
@@ -1546,6 +2124,8 @@ HRESULT CNvEncoder::OpenEncodeSession(const EncodeConfig encodeConfig, const uns
 	//                      is allowed to use
 	m_Repackyuv.set_cpu_allow_avx(m_stEncoderInput.CPU_enableAVX);
 	m_Repackyuv.set_cpu_allow_avx2(m_stEncoderInput.CPU_enableAVX2);
+	m_Repackyuv.set_cpu_allow_avx512(m_stEncoderInput.CPU_enableAVX512);
+	m_Repackyuv.set_num_threads(m_stEncoderInput.CPU_numThreads);
 
     return hr;
 }
@@ -1776,6 +2356,7 @@ CNvEncoder::initEncoderConfig(EncodeConfig *p_nvEncoderConfig) // used by Adobe
 //		p_nvEncoderConfig->chromaFormatIDC = NV_ENC_BUFFER_FORMAT_NV12;  // 1 = YUV4:2:0, 3 = YUV4:4:4
 		p_nvEncoderConfig->chromaFormatIDC = cudaVideoChromaFormat_420;  // 1 = YUV4:2:0, 3 = YUV4:4:4
 		p_nvEncoderConfig->separateColourPlaneFlag = 0;
+		p_nvEncoderConfig->pixelBitDepthMinus8 = 0; // 8-bit
         p_nvEncoderConfig->output_sei_BufferPeriod = 0;
         p_nvEncoderConfig->mvPrecision      = NV_ENC_MV_PRECISION_QUARTER_PEL;
         p_nvEncoderConfig->output_sei_PictureTime  = 0;
@@ -1811,6 +2392,9 @@ CNvEncoder::initEncoderConfig(EncodeConfig *p_nvEncoderConfig) // used by Adobe
 
 		p_nvEncoderConfig->CPU_enableAVX    = true;
 		p_nvEncoderConfig->CPU_enableAVX2   = true;
+		p_nvEncoderConfig->CPU_enableAVX512 = true;
+		p_nvEncoderConfig->CPU_numThreads   = 0; // auto (one repacker thread per CPU core)
+		p_nvEncoderConfig->CPU_lookahead    = 0; // no lookahead (scene-cuts are left to NVENC)
 	}
 }
 
@@ -1881,6 +2465,9 @@ CNvEncoder::_QueryEncoderCaps( const GUID &codecGUID, nv_enc_caps_s &nv_enc_caps
 	QUERY_CAPS(NV_ENC_CAPS_SUPPORT_LOSSLESS_ENCODE );
 	QUERY_CAPS(NV_ENC_CAPS_SUPPORT_SAO);
 	QUERY_CAPS(NV_ENC_CAPS_SUPPORT_MEONLY_MODE);
+#if NVENCAPI_MAJOR_VERSION >= 7
+	QUERY_CAPS(NV_ENC_CAPS_SUPPORT_10BIT_ENCODE); // NVENC 7.0
+#endif
 	return S_OK;
 }
 
@@ -2112,6 +2699,11 @@ void EncodeConfig::print( string &stringout ) const {
 	PRINT_DEC(separateColourPlaneFlag)
 	os << endl;
 
+	if (codec_is_hevc) {
+		PRINT_DEC(pixelBitDepthMinus8)
+		os << endl;
+	}
+
 	PRINT_DEC(output_sei_BufferPeriod)
 	os << ",   ";
 
@@ -2196,6 +2788,12 @@ void EncodeConfig::print( string &stringout ) const {
 	PRINT_DEC(CPU_enableAVX)
 	os << ", ";
 	PRINT_DEC(CPU_enableAVX2)
+	os << ", ";
+	PRINT_DEC(CPU_enableAVX512)
+	os << ", ";
+	PRINT_DEC(CPU_numThreads)
+	os << ", ";
+	PRINT_DEC(CPU_lookahead)
 	os << endl;
 
 	stringout = os.str();
@@ -2216,3 +2814,104 @@ void CNvEncoder::set_color_metadata(const CNvEncoder_color_s c)
 {
 	m_color_metadata = c;
 }
+
+uint32_t NVENC_Calculate_H264_MaxKBitRate( 
+	const NV_ENC_LEVEL level, 
+	const enum_NV_ENC_H264_PROFILE profile
+)
+{
+	if ( level == NV_ENC_LEVEL_AUTOSELECT )
+		return 0; // unconstrained
+
+	// workaround -
+	// -----------
+	// NVENC SDK 2.0 Beta, Geforce 314.14 driver
+	//    For some reason, the NVENC's high-profile bitrate-constraints appear 
+	//    to follow the values for baseline/main profile.
+	// Note, this is still true as of NVENC SDK 3 (Geforce 334.89 WHQL driver)
+	//
+	// Updated for NVENC SDK 5.0 (Dec 2014)
+
+
+	if ( (profile >= NV_ENC_H264_PROFILE_BASELINE) &&
+	    (profile < NV_ENC_H264_PROFILE_HIGH) ) 
+		switch( level ) {
+			case NV_ENC_LEVEL_H264_1  : return 64;
+			case NV_ENC_LEVEL_H264_1b : return 128;
+			case NV_ENC_LEVEL_H264_11 : return 192;
+			case NV_ENC_LEVEL_H264_12 : return 384;
+			case NV_ENC_LEVEL_H264_13 : return 768;
+			case NV_ENC_LEVEL_H264_2  : return 2000;
+			case NV_ENC_LEVEL_H264_21 : return 4000;
+			case NV_ENC_LEVEL_H264_22 : return 4000;
+			case NV_ENC_LEVEL_H264_3  : return 10000;
+			case NV_ENC_LEVEL_H264_31 : return 14000;
+			case NV_ENC_LEVEL_H264_32 : return 20000;
+			case NV_ENC_LEVEL_H264_4  : return 20000;
+			case NV_ENC_LEVEL_H264_41 : return 50000;
+			case NV_ENC_LEVEL_H264_42 : return 50000;
+			case NV_ENC_LEVEL_H264_5  : return 135000;
+			case NV_ENC_LEVEL_H264_51 : return 240000;
+			case NV_ENC_LEVEL_H264_52 : return 240000;
+		    default                   : return 0; // unconstrained
+		}
+
+	if ( (profile >= NV_ENC_H264_PROFILE_HIGH) &&
+         (profile <= NV_ENC_H264_PROFILE_CONSTRAINED_HIGH) ) 
+		switch( level ) {
+			case NV_ENC_LEVEL_H264_1  : return 64;
+			case NV_ENC_LEVEL_H264_1b : return 128;
+			case NV_ENC_LEVEL_H264_11 : return 192;
+			case NV_ENC_LEVEL_H264_12 : return 384;
+			case NV_ENC_LEVEL_H264_13 : return 768;  // should be 960
+			case NV_ENC_LEVEL_H264_2  : return 2000; // should be 2500
+			case NV_ENC_LEVEL_H264_21 : return 4000; // should be 5000
+			case NV_ENC_LEVEL_H264_22 : return 4000; // should be 5000
+			case NV_ENC_LEVEL_H264_3  : return 10000;// should be 12500
+			case NV_ENC_LEVEL_H264_31 : return 14000;// should be 17500
+			case NV_ENC_LEVEL_H264_32 : return 20000;// should be 25000
+			case NV_ENC_LEVEL_H264_4  : return 24000;// should be 25000
+			case NV_ENC_LEVEL_H264_41 : return 60000;// should be 62500
+			case NV_ENC_LEVEL_H264_42 : return 60000;// should be 62500
+			case NV_ENC_LEVEL_H264_5  : return 160000;// should be 168750
+			case NV_ENC_LEVEL_H264_51 : return 280000;// should be 300000
+			case NV_ENC_LEVEL_H264_52 : return 280000;// should be 300000
+			default                   : return 0; // unconstrained
+		}
+
+	return 0; // unconstrained
+}
+
+uint32_t NVENC_Calculate_HEVC_MaxKBitRate(
+	const NV_ENC_LEVEL level,
+	const NV_ENC_LEVEL tier
+	)
+{
+	const bool main_tier = (tier == NV_ENC_TIER_HEVC_MAIN);
+
+	switch (level) {
+		case NV_ENC_LEVEL_HEVC_1:  return 128;
+		case NV_ENC_LEVEL_HEVC_2:  return 1500;
+		case NV_ENC_LEVEL_HEVC_21: return 3000;
+		case NV_ENC_LEVEL_HEVC_3:  return 6000;
+		case NV_ENC_LEVEL_HEVC_31: return 10000;
+		case NV_ENC_LEVEL_HEVC_4:  return main_tier ? 
+			                              12000  :  30000;
+		case NV_ENC_LEVEL_HEVC_41: return main_tier ?
+			                              20000  :  50000;
+		case NV_ENC_LEVEL_HEVC_5:  return main_tier ?
+			                              25000  : 100000;
+		case NV_ENC_LEVEL_HEVC_51: return main_tier ?
+			                              40000  : 160000;
+		case NV_ENC_LEVEL_HEVC_52: return main_tier ?
+			                              60000  : 240000;
+		case NV_ENC_LEVEL_HEVC_6:  return main_tier ?
+			                              60000  : 240000;
+		case NV_ENC_LEVEL_HEVC_61: return main_tier ?
+			                              120000 : 480000;
+		case NV_ENC_LEVEL_HEVC_62: return main_tier ?
+			                              240000 : 800000;
+	} // switch (level)
+	
+	return 0; // default : unconstrained
+}
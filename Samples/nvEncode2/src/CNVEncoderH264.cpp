@@ -13,6 +13,7 @@
 #include <include/videoFormats.h>
 #include <CNVEncoderH264.h>
 #include <xcodeutil.h>
+#include <cnvencsim.h>  // NVENCSIM_DEVICE_NAME
 
 #include <helper_cuda_drvapi.h>    // helper file for CUDA Driver API calls and error checking
 #include <include/helper_nvenc.h>
@@ -43,6 +44,7 @@ CNvEncoderH264::CNvEncoderH264()
     m_uCurHeight = 0;
     m_uCurWidth = 0;
     m_dwFrameNumInGOP = 0;
+    m_dwIDRFrameNum = 0;
 	memset( (void *) &m_sei_user_payload, 0, sizeof(m_sei_user_payload) );
 }
 
@@ -74,6 +76,11 @@ HRESULT CNvEncoderH264::InitializeEncoderCodec(void * const p)
     NVENCSTATUS nvStatus = NV_ENC_SUCCESS;
     bool bMVCEncoding    = m_stEncoderInput.profile == NV_ENC_H264_PROFILE_STEREO ? true : false;
     m_bAsyncModeEncoding = ((m_stEncoderInput.syncMode==0) ? true : false);
+    m_dwFrameNumInGOP    = 0; // a new sequence: the display frame#s (outputTimeStamp) restart
+    m_dwIDRFrameNum      = 0;
+#if !defined (NV_WINDOWS)
+    m_bAsyncModeEncoding = false; // NVENC completion-events are Windows-only: the output-thread blocks in nvEncLockBitstream()
+#endif
 	string            s; // text-buffer
 	ostringstream   oss; // text-buffer to generate encoder-settings
 
@@ -120,8 +127,12 @@ HRESULT CNvEncoderH264::InitializeEncoderCodec(void * const p)
     CUresult        cuResult = CUDA_SUCCESS;
     CUdevice        cuDevice = 0;
 	char            gpu_name[100];
-	checkCudaErrors(cuDeviceGet(&cuDevice, m_deviceID));
-	checkCudaErrors(cuDeviceGetName(gpu_name, 100, cuDevice));
+	if (m_bSoftwareEncodeAPI)
+		strcpy(gpu_name, NVENCSIM_DEVICE_NAME);
+	else {
+		checkCudaErrors(cuDeviceGet(&cuDevice, m_deviceID));
+		checkCudaErrors(cuDeviceGetName(gpu_name, 100, cuDevice));
+	}
 
 	// Get the Geforce driver-version using NVAPI -
 	//   NVENC functionality is a hardware+firmware implementation, so it is important
@@ -446,7 +457,7 @@ HRESULT CNvEncoderH264::InitializeEncoderCodec(void * const p)
 
         unsigned int dwPicHeight = m_uMaxHeight;
         int numMBs = ((m_dwFrameWidth + 15)/16) * ((dwPicHeight + 15)/16);
-        int NumIOBuffers = m_stEncoderInput.numBFrames + 4 + 1;
+        int NumIOBuffers = m_stEncoderInput.numBFrames + 4 + 1 + CalculateLookaheadDepth(m_stEncoderInput); // (+ the frames held back by the CPU lookahead)
 		/*
 		if ( numMBs < 8160)   // less than 1920x1088
 			NumIOBuffers = m_stEncoderInput.numBFrames + 4 + 1;
@@ -504,6 +515,9 @@ HRESULT CNvEncoderH264::InitializeEncoderCodec(void * const p)
 HRESULT
 CNvEncoderH264::ReconfigureEncoder(EncodeConfig EncoderReConfig)
 {
+    // the frames held back by the CPU lookahead were taken with the old settings: submit them first
+    DrainLookahead(true);
+
     // Initialize the Encoder
     memcpy(&m_stEncoderInput ,&EncoderReConfig, sizeof(EncoderReConfig));
     m_stInitEncParams.encodeHeight        =  EncoderReConfig.height;
@@ -519,11 +533,23 @@ CNvEncoderH264::ReconfigureEncoder(EncodeConfig EncoderReConfig)
     m_stInitEncParams.encodeConfig->frameFieldMode              = EncoderReConfig.FieldEncoding ? NV_ENC_PARAMS_FRAME_FIELD_MODE_FIELD : NV_ENC_PARAMS_FRAME_FIELD_MODE_FRAME ;
     m_stInitEncParams.encodeConfig->rcParams.vbvBufferSize      = EncoderReConfig.vbvBufferSize;
     m_stInitEncParams.encodeConfig->rcParams.vbvInitialDelay    = EncoderReConfig.vbvInitialDelay;
+    m_stInitEncParams.encodeConfig->rcParams.rateControlMode    = (NV_ENC_PARAMS_RC_MODE)EncoderReConfig.rateControl;
+    m_stInitEncParams.encodeConfig->rcParams.constQP.qpIntra    = EncoderReConfig.qpI;
+    m_stInitEncParams.encodeConfig->rcParams.constQP.qpInterP   = EncoderReConfig.qpP;
+    m_stInitEncParams.encodeConfig->rcParams.constQP.qpInterB   = EncoderReConfig.qpB;
+    m_stInitEncParams.encodeConfig->rcParams.enableInitialRCQP  = EncoderReConfig.initial_qp_ena;
+    m_stInitEncParams.encodeConfig->rcParams.initialRCQP.qpIntra  = EncoderReConfig.initial_qpI;
+    m_stInitEncParams.encodeConfig->rcParams.initialRCQP.qpInterP = EncoderReConfig.initial_qpP;
+    m_stInitEncParams.encodeConfig->rcParams.initialRCQP.qpInterB = EncoderReConfig.initial_qpB;
     m_stInitEncParams.encodeConfig->encodeCodecConfig.h264Config.disableSPSPPS = 0;
     memcpy( &m_stReInitEncParams.reInitEncodeParams, &m_stInitEncParams, sizeof(m_stInitEncParams));
     SET_VER(m_stReInitEncParams, NV_ENC_RECONFIGURE_PARAMS);
     m_stReInitEncParams.resetEncoder    = true;
     NVENCSTATUS nvStatus = m_pEncodeAPI->nvEncReconfigureEncoder(m_hEncoder, &m_stReInitEncParams);
+
+    // the reset starts a new GOP (without PTD, the next picture is the IDR)
+    if (nvStatus == NV_ENC_SUCCESS)
+        m_dwIDRFrameNum = m_dwFrameNumInGOP;
     return nvStatus;
 }
 
@@ -544,8 +570,6 @@ HRESULT CNvEncoderH264::EncodeFramePPro(
 	const bool bFlush
 )
 {
-    NVENCSTATUS nvStatus = NV_ENC_SUCCESS;
-    HRESULT hr = S_OK;
     NV_ENC_MAP_INPUT_RESOURCE mapRes = {0};
 
 	if (bFlush)
@@ -566,6 +590,9 @@ HRESULT CNvEncoderH264::EncodeFramePPro(
 	const bool input_yuv420 = pEncodeFrame->ppro_pixelformat_is_yuv420;
 	const bool input_yuv444 = pEncodeFrame->ppro_pixelformat_is_yuv444;
 	const bool input_rgb32f = pEncodeFrame->ppro_pixelformat_is_rgb444f;
+	const bool input_rgb8u  = pEncodeFrame->ppro_pixelformat_is_rgb444_8u;
+	const bool input_rgb16u = pEncodeFrame->ppro_pixelformat_is_rgb444_16u;
+	const bool input_v210 = pEncodeFrame->ppro_pixelformat_is_v210;
 	const bool flag_bt709 = (m_color_metadata.color_known && (!m_color_metadata.color)) ?
 		false :   // Bt601: only chosen if metadata is explicitly set to Bt601
 		true;     // for everything else, default to Bt709
@@ -575,16 +602,7 @@ HRESULT CNvEncoderH264::EncodeFramePPro(
 
     EncodeInputSurfaceInfo  *pInput;
     EncodeOutputBuffer      *pOutputBitstream;
-
-    if (!m_stInputSurfQueue.Remove(pInput, INFINITE))
-    {
-        assert(0);
-    }
-
-    if (!m_stOutputSurfQueue.Remove(pOutputBitstream, INFINITE))
-    {
-        assert(0);
-    }
+    AcquireSurfaces(pInput, pOutputBitstream);
 
     // encode width and height
     unsigned int dwWidth =  m_uMaxWidth; //m_stEncoderInput.width;
@@ -598,7 +616,9 @@ HRESULT CNvEncoderH264::EncodeFramePPro(
     unsigned char *pInputSurface = NULL;
     unsigned char *pInputSurfaceCh = NULL;
     unsigned int lockedPitch = dwSurfWidth;
+    U64 qwConvertStart = 0, qwConvertEnd = 0; // (telemetry)
     
+    NvQueryPerformanceCounter(&qwConvertStart);
     pInputSurface = LockInputBuffer(pInput->hInputSurface, &lockedPitch);
     pInputSurfaceCh = pInputSurface + (dwSurfHeight*lockedPitch);
 
@@ -634,12 +654,25 @@ HRESULT CNvEncoderH264::EncodeFramePPro(
 				pInputSurfaceCh + (dwSurfHeight*lockedPitch) // output V
 			);
 		}
+		else if (input_rgb8u || input_rgb16u) {
+			m_Repackyuv.convert_RGBtoY444( // integer (8/16-bit BGRA) version of converter
+				flag_bt709, // true = bt709, false=bt601
+				flag_fullrange,// true=PC/full scale, false=video scale (0-235)
+				input_rgb16u,  // true=16 bits per channel, false=8 bits per channel
+				dwWidth, dwHeight, pEncodeFrame->stride[0], // src stride (units of uint8_t)
+				pEncodeFrame->yuv[0],
+				lockedPitch,  // destStride (units of uint8_t)
+				pInputSurface,    // output Y
+				pInputSurfaceCh,  // output U
+				pInputSurfaceCh + (dwSurfHeight*lockedPitch) // output V
+			);
+		}
 	} // if ( m_stEncoderInput.chromaFormatIDC == cudaVideoChromaFormat_444 ) )
 
 	if (m_stEncoderInput.chromaFormatIDC == cudaVideoChromaFormat_420) {
 		
 		if (input_rgb32f) {
-			m_Repackyuv.convert_RGBFtoNV12( // SSE4.1 version of converter
+			m_Repackyuv.convert_RGBFtoNV12_mt( // multi-threaded SSE4.1 version of converter
 				flag_bt709, // true = bt709, false=bt601
 				flag_fullrange,// true=PC/full scale, false=video scale (0-235)
 				dwWidth, dwHeight, pEncodeFrame->stride[0], // src stride (units of _m128)
@@ -649,6 +682,18 @@ HRESULT CNvEncoderH264::EncodeFramePPro(
 				pInputSurfaceCh   // output UV
 			);
 		}
+		else if (input_rgb8u || input_rgb16u) {
+			m_Repackyuv.convert_RGBtoNV12( // integer (8/16-bit BGRA) version of converter
+				flag_bt709, // true = bt709, false=bt601
+				flag_fullrange,// true=PC/full scale, false=video scale (0-235)
+				input_rgb16u,  // true=16 bits per channel, false=8 bits per channel
+				dwWidth, dwHeight, pEncodeFrame->stride[0], // src stride (units of uint8_t)
+				pEncodeFrame->yuv[0],
+				lockedPitch,
+				pInputSurface,    // output Y
+				pInputSurfaceCh   // output UV
+			);
+		}
 		else if ( input_yuv420) {
 			// Note, PPro handed us YUV4:2:0 (YV12) data, and NVENC only accepts 
 			// 4:2:0 pixel-data in the NV12_planar format (2 planes.)
@@ -676,6 +721,26 @@ HRESULT CNvEncoderH264::EncodeFramePPro(
 			);
 
 		} ///////////////// if (input_yuv422)
+		else if (input_v210) {
+			// PPro handed us v210 (4:2:2 10bpc packed) data: unpack and downsample to NV12
+			m_Repackyuv.convert_V210toNV12(
+				dwWidth, dwHeight, pEncodeFrame->stride[0], // src stride (units of uint8_t)
+				pEncodeFrame->yuv[0], // source framebuffer (v210)
+				lockedPitch,
+				pInputSurface,    // output Y
+				pInputSurfaceCh   // output UV
+			);
+		} ///////////////// if (input_v210)
+		else if (input_yuv444) {
+			// PPro handed us VUYA (4:4:4 8bpc packed) data: downsample the chroma straight to NV12
+			m_Repackyuv.convert_VUYAtoNV12(
+				dwWidth, dwHeight, pEncodeFrame->stride[0], // src stride (units of uint8_t)
+				pEncodeFrame->yuv[0], // source framebuffer (VUYA)
+				lockedPitch,
+				pInputSurface,    // output Y
+				pInputSurfaceCh   // output UV
+			);
+		} ///////////////// if (input_yuv444)
 		else {
 			// TODO ERROR: if it wasn't YUV420, and not YUV422,
 			//  then PremierePro gave us something we can't handle.
@@ -684,7 +749,52 @@ HRESULT CNvEncoderH264::EncodeFramePPro(
 
 	} // if ( m_stEncoderInput.chromaFormatIDC == cudaVideoChromaFormat_420 )
 
+    // CPU lookahead: analyze the luma plane while it is still in the cache
+    if (m_Lookahead.IsEnabled())
+    {
+        m_Lookahead.Analyze(pInputSurface, lockedPitch);
+    }
+
+    // spill cache (two-pass export, pass 1): keep the converted frame for pass 2
+    SpillInputSurface(pInput, pInputSurface, lockedPitch);
+
     UnlockInputBuffer(pInput->hInputSurface);
+    NvQueryPerformanceCounter(&qwConvertEnd);
+    pOutputBitstream->qwConvertTicks = qwConvertEnd - qwConvertStart;
+
+	// Don't allow Dynamic Resolution Changing (not supported in PPro)
+	assert (!pEncodeFrame->dynResChangeFlag);
+
+    // Handling Dynamic Bitrate Change (don't need this for PPro)
+	assert( pEncodeFrame->dynBitrateChangeFlag != DYN_DOWNSCALE);
+
+    assert(pEncodeFrame->dynBitrateChangeFlag != DYN_UPSCALE);
+
+    const NV_ENC_PIC_STRUCT pictureStruct = pEncodeFrame->fieldPicflag ?
+		(pEncodeFrame->topField ? NV_ENC_PIC_STRUCT_FIELD_TOP_BOTTOM : NV_ENC_PIC_STRUCT_FIELD_BOTTOM_TOP) :
+		NV_ENC_PIC_STRUCT_FRAME;
+
+    // with the lookahead, the frame waits for its scene-cut decision
+    if (m_Lookahead.IsEnabled())
+        return QueueLookahead(pInput, pOutputBitstream, pictureStruct);
+
+    return SubmitPicture(pInput, pOutputBitstream, pictureStruct, NULL);
+}
+
+//
+//  SubmitPicture() - encode a frame converted by EncodeFramePPro()
+//
+//     pHint = the CPU lookahead's decision (NULL = no lookahead): a scene-cut is coded as an IDR
+HRESULT CNvEncoderH264::SubmitPicture(
+	EncodeInputSurfaceInfo *pInput,
+	EncodeOutputBuffer *pOutputBitstream,
+	const NV_ENC_PIC_STRUCT pictureStruct,
+	const lookahead_hint_t *pHint
+)
+{
+    NVENCSTATUS nvStatus = NV_ENC_SUCCESS;
+    HRESULT hr = S_OK;
+    const bool bSceneCut = pHint && pHint->scene_cut;
 
     memset(&m_stEncodePicParams, 0, sizeof(m_stEncodePicParams));
     SET_VER(m_stEncodePicParams, NV_ENC_PIC_PARAMS);
@@ -694,12 +804,10 @@ HRESULT CNvEncoderH264::EncodeFramePPro(
     m_stEncodePicParams.inputHeight = pInput->dwHeight;
     m_stEncodePicParams.outputBitstream = pOutputBitstream->hBitstreamBuffer;
     m_stEncodePicParams.completionEvent = m_bAsyncModeEncoding == true ? pOutputBitstream->hOutputEvent : NULL;
-    m_stEncodePicParams.pictureStruct = pEncodeFrame->fieldPicflag ?
-		(pEncodeFrame->topField ? NV_ENC_PIC_STRUCT_FIELD_TOP_BOTTOM : NV_ENC_PIC_STRUCT_FIELD_BOTTOM_TOP) :
-		NV_ENC_PIC_STRUCT_FRAME;
+    m_stEncodePicParams.pictureStruct = pictureStruct;
 //    m_stEncodePicParams.codecPicParams.h264PicParams.h264ExtPicParams.mvcPicParams.viewID = pEncodeFrame->viewId;    
     m_stEncodePicParams.encodePicFlags = 0;
-    m_stEncodePicParams.inputTimeStamp = 0;
+    m_stEncodePicParams.inputTimeStamp = m_dwFrameNumInGOP; // display frame#, returned as outputTimeStamp (MP4 muxer needs it for B-frame reordering)
     m_stEncodePicParams.inputDuration = 0;
 
 	// embed encoder-settings (text-string) into the encoded videostream
@@ -723,15 +831,18 @@ HRESULT CNvEncoderH264::EncodeFramePPro(
 	}
 
 	if (!m_stInitEncParams.enablePTD)
-		m_stEncodePicParams.pictureType = ((m_dwFrameNumInGOP % m_stEncoderInput.gopLength) == 0) ? NV_ENC_PIC_TYPE_IDR : NV_ENC_PIC_TYPE_P;
-
-	// Don't allow Dynamic Resolution Changing (not supported in PPro)
-	assert (!pEncodeFrame->dynResChangeFlag);
-
-    // Handling Dynamic Bitrate Change (don't need this for PPro)
-	assert( pEncodeFrame->dynBitrateChangeFlag != DYN_DOWNSCALE);
+	{
+		// an IDR every gopLength frames, the lookahead restarts the GOP on a scene-cut
+		if (bSceneCut || ((m_dwFrameNumInGOP - m_dwIDRFrameNum) % m_stEncoderInput.gopLength) == 0)
+			m_dwIDRFrameNum = m_dwFrameNumInGOP;
+		m_stEncodePicParams.pictureType = (m_dwIDRFrameNum == m_dwFrameNumInGOP) ? NV_ENC_PIC_TYPE_IDR : NV_ENC_PIC_TYPE_P;
+	}
+	else if (bSceneCut)
+		m_stEncodePicParams.encodePicFlags |= NV_ENC_PIC_FLAG_FORCEIDR;
 
-    assert(pEncodeFrame->dynBitrateChangeFlag != DYN_UPSCALE);
+	// (the output-thread adds the hint to the frame's telemetry)
+	if (pHint)
+		StoreLookaheadHint(m_dwFrameNumInGOP, *pHint);
 
     if ((m_bAsyncModeEncoding == false) && 
         (m_stInitEncParams.enablePTD == 1))
@@ -739,12 +850,12 @@ HRESULT CNvEncoderH264::EncodeFramePPro(
         EncoderThreadData stThreadData;
         stThreadData.pOutputBfr = pOutputBitstream;
         stThreadData.pInputBfr = pInput;
-        stThreadData.pOutputBfr->bDynResChangeFlag = pEncodeFrame->dynResChangeFlag == 1 ? 1 : 0;
+        stThreadData.pOutputBfr->bDynResChangeFlag = false;
         pOutputBitstream->bWaitOnEvent = false;
         m_pEncodeFrameQueue.Add(stThreadData);
     }
 
-    nvStatus = m_pEncodeAPI->nvEncEncodePicture(m_hEncoder, &m_stEncodePicParams);
+    nvStatus = EncodePicture(pOutputBitstream);
     
     m_dwFrameNumInGOP++;
     if ((m_bAsyncModeEncoding == false) && 
@@ -771,7 +882,7 @@ HRESULT CNvEncoderH264::EncodeFramePPro(
             stThreadData.pOutputBfr = pOutputBitstream;
             stThreadData.pInputBfr = pInput;
             pOutputBitstream->bWaitOnEvent = true;
-            stThreadData.pOutputBfr->bDynResChangeFlag = pEncodeFrame->dynResChangeFlag == 1 ? 1 : 0;
+            stThreadData.pOutputBfr->bDynResChangeFlag = false;
             // Queue o/p Sample
             if (!m_pEncoderThread->QueueSample(stThreadData))
             {
@@ -809,17 +920,7 @@ HRESULT CNvEncoderH264::EncodeCudaMemFrame(
 
     EncodeInputSurfaceInfo  *pInput;
     EncodeOutputBuffer      *pOutputBitstream;
-
-    if (!m_stInputSurfQueue.Remove(pInput, INFINITE))
-    {
-        assert(0);
-    }
-
-
-    if (!m_stOutputSurfQueue.Remove(pOutputBitstream, INFINITE))
-    {
-        assert(0);
-    }
+    AcquireSurfaces(pInput, pOutputBitstream);
 
     unsigned int lockedPitch = 0;
     // encode width and height
@@ -906,6 +1007,7 @@ HRESULT CNvEncoderH264::EncodeCudaMemFrame(
         printf("CNvEncoderH264::EncodeCudaMemFrame ERROR !useMappedResources\n");
         UnlockInputBuffer(pInput->hInputSurface);
     }
+    pOutputBitstream->qwConvertTicks = 0; // (the frame is already in GPU memory)
 
     memset(&m_stEncodePicParams, 0, sizeof(m_stEncodePicParams));
     SET_VER(m_stEncodePicParams, NV_ENC_PIC_PARAMS);
@@ -929,7 +1031,7 @@ HRESULT CNvEncoderH264::EncodeCudaMemFrame(
 
 //    m_stEncodePicParams.codecPicParams.h264PicParams.h264ExtPicParams.mvcPicParams.viewID = pEncodeFrame->viewId;    
     m_stEncodePicParams.encodePicFlags = 0;
-    m_stEncodePicParams.inputTimeStamp = 0;
+    m_stEncodePicParams.inputTimeStamp = m_dwFrameNumInGOP; // display frame#, returned as outputTimeStamp (MP4 muxer needs it for B-frame reordering)
     m_stEncodePicParams.inputDuration = 0;
 
 	// For H264-only: embed encoder-settings (text-string) into the encoded videostream
@@ -984,7 +1086,7 @@ HRESULT CNvEncoderH264::EncodeCudaMemFrame(
         m_pEncodeFrameQueue.Add(stThreadData);
     }
 
-	nvStatus = m_pEncodeAPI->nvEncEncodePicture(m_hEncoder, &m_stEncodePicParams);
+	nvStatus = EncodePicture(pOutputBitstream);
     
     m_dwFrameNumInGOP++;
     if ((m_bAsyncModeEncoding == false) && 
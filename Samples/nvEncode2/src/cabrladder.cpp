@@ -0,0 +1,281 @@
+#include <cstring>   // memset()
+#include <cmath>     // pow()
+#include <assert.h>
+
+#include "cabrladder.h"
+
+// the ladder below the source: fraction (numerator, denominator) of the source height
+static const uint32_t s_ladder_scale[ABR_LADDER_MAX_RUNGS][2] = {
+	{ 1, 1 }, { 2, 3 }, { 1, 2 }, { 1, 3 }, { 1, 4 }, { 1, 6 }
+};
+
+// nearest even number to value * num / den
+static inline uint32_t _scale_even(const uint32_t value, const uint32_t num, const uint32_t den)
+{
+	return static_cast<uint32_t>((static_cast<uint64_t>(value) * num + den) / (2 * den) * 2);
+}
+
+CAbrLadder::CAbrLadder() :
+	m_count(0), m_rows(NULL)
+{
+	memset(m_rungs, 0, sizeof(m_rungs));
+	memset(m_planes, 0, sizeof(m_planes));
+	memset(m_strides, 0, sizeof(m_strides));
+	memset(m_scalers, 0, sizeof(m_scalers));
+}
+
+CAbrLadder::~CAbrLadder()
+{
+	Release();
+}
+
+uint32_t CAbrLadder::Plan(const uint32_t width, const uint32_t height, const uint32_t avg_bps,
+	const uint32_t peak_bps, const uint32_t max_rungs, abr_rung_t rungs[ABR_LADDER_MAX_RUNGS])
+{
+	const double source_pixels = static_cast<double>(width) * height;
+	uint32_t count = 0;
+
+	rungs[count].width    = width;
+	rungs[count].height   = height;
+	rungs[count].avg_bps  = avg_bps;
+	rungs[count].peak_bps = peak_bps;
+	++count;
+
+	for (uint32_t r = 1; r < ABR_LADDER_MAX_RUNGS && count < max_rungs; ++r) {
+		abr_rung_t &rung = rungs[count];
+		rung.width  = _scale_even(width, s_ladder_scale[r][0], s_ladder_scale[r][1]);
+		rung.height = _scale_even(height, s_ladder_scale[r][0], s_ladder_scale[r][1]);
+		if (rung.height < ABR_LADDER_MIN_HEIGHT || rung.width < 2)
+			break;
+
+		const double share = pow(static_cast<double>(rung.width) * rung.height / source_pixels, ABR_LADDER_RATE_EXPONENT);
+		rung.avg_bps  = static_cast<uint32_t>(avg_bps * share);
+		rung.peak_bps = static_cast<uint32_t>(peak_bps * share);
+		++count;
+	}
+	return count;
+}
+
+bool CAbrLadder::Init(const abr_rung_t *rungs, const uint32_t count)
+{
+	Release();
+	if (!count || count > ABR_LADDER_MAX_RUNGS)
+		return false;
+
+	// each rung is made from the one above it: a downscale of at most 2:1
+	for (uint32_t r = 1; r < count; ++r) {
+		const abr_rung_t &above = rungs[r - 1];
+		if (!rungs[r].width || !rungs[r].height || (rungs[r].width & 1) || (rungs[r].height & 1) ||
+			rungs[r].width > above.width || rungs[r].height > above.height ||
+			2 * rungs[r].width < above.width || 2 * rungs[r].height < above.height)
+			return false;
+	}
+
+	m_count = count;
+	memcpy(m_rungs, rungs, count * sizeof(abr_rung_t));
+	// (+2 columns: a tap of weight 0 may read past the row)
+	m_rows = static_cast<uint16_t *>(_mm_malloc((rungs[0].width + 2) * 8 * sizeof(uint16_t), 16));
+	memset(m_rows, 0, (rungs[0].width + 2) * 8 * sizeof(uint16_t));
+
+	for (uint32_t r = 1; r < count; ++r) {
+		const abr_rung_t &above = m_rungs[r - 1];
+		const abr_rung_t &rung  = m_rungs[r];
+
+		for (uint32_t p = 0; p < 3; ++p) {
+			const uint32_t w = p ? rung.width / 2 : rung.width;
+			const uint32_t h = p ? rung.height / 2 : rung.height;
+			m_strides[r][p] = (w + 15) & ~15;
+			m_planes[r][p]  = new uint8_t[m_strides[r][p] * h];
+		}
+
+		for (uint32_t c = 0; c < 2; ++c) {
+			// (the source's chroma planes round up, if it has an odd size)
+			const uint32_t src_w = c ? (above.width + 1) / 2 : above.width;
+			const uint32_t src_h = c ? (above.height + 1) / 2 : above.height;
+			const uint32_t dst_w = c ? rung.width / 2 : rung.width;
+			const uint32_t dst_h = c ? rung.height / 2 : rung.height;
+			m_scalers[r][c].h = new abr_taps_t[dst_w];
+			m_scalers[r][c].v = new abr_taps_t[dst_h];
+			_make_taps(src_w, dst_w, m_scalers[r][c].h);
+			_make_taps(src_h, dst_h, m_scalers[r][c].v);
+		}
+	}
+	return true;
+}
+
+void CAbrLadder::Release()
+{
+	for (uint32_t r = 0; r < ABR_LADDER_MAX_RUNGS; ++r) {
+		for (uint32_t p = 0; p < 3; ++p) {
+			delete [] m_planes[r][p];
+			m_planes[r][p]  = NULL;
+			m_strides[r][p] = 0;
+		}
+		for (uint32_t c = 0; c < 2; ++c) {
+			delete [] m_scalers[r][c].h;
+			delete [] m_scalers[r][c].v;
+			m_scalers[r][c].h = NULL;
+			m_scalers[r][c].v = NULL;
+		}
+	}
+	_mm_free(m_rows);
+	m_rows  = NULL;
+	m_count = 0;
+}
+
+void CAbrLadder::Downscale(const uint8_t * const src[3], const uint32_t src_stride[3])
+{
+	for (uint32_t r = 1; r < m_count; ++r) {
+		const abr_rung_t &above = m_rungs[r - 1];
+		const abr_rung_t &rung  = m_rungs[r];
+
+		for (uint32_t p = 0; p < 3; ++p) {
+			const uint8_t *s   = (r == 1) ? src[p] : m_planes[r - 1][p];
+			const uint32_t ss  = (r == 1) ? src_stride[p] : m_strides[r - 1][p];
+			const uint32_t sw  = p ? (above.width + 1) / 2 : above.width;
+			const uint32_t dw  = p ? rung.width / 2 : rung.width;
+			const uint32_t dh  = p ? rung.height / 2 : rung.height;
+			_scale_plane(s, ss, sw, m_planes[r][p], m_strides[r][p], dw, dh, m_scalers[r][p ? 1 : 0]);
+		}
+	}
+}
+
+// _make_taps() - area-weighted (box) downscale of src_size samples to dst_size:
+//   output sample i covers the input interval [i, i+1) * src_size / dst_size
+void CAbrLadder::_make_taps(const uint32_t src_size, const uint32_t dst_size, abr_taps_t *taps)
+{
+	const uint32_t one = 1 << ABR_LADDER_WEIGHT_BITS;
+
+	for (uint32_t i = 0; i < dst_size; ++i) {
+		// in units of 1/dst_size input samples
+		const uint64_t start = static_cast<uint64_t>(i) * src_size;
+		const uint64_t end   = start + src_size;
+		abr_taps_t &t = taps[i];
+
+		t.first = static_cast<uint32_t>(start / dst_size);
+		t.taps  = 0;
+		uint32_t total = 0, largest = 0;
+		for (uint64_t j = t.first; j * dst_size < end && t.taps < 3; ++j) {
+			const uint64_t lo = (j * dst_size > start) ? j * dst_size : start;
+			const uint64_t hi = ((j + 1) * dst_size < end) ? (j + 1) * dst_size : end;
+			const uint32_t w  = static_cast<uint32_t>(((hi - lo) * one + src_size / 2) / src_size);
+			t.weight[t.taps] = static_cast<uint16_t>(w);
+			if (w > t.weight[largest])
+				largest = t.taps;
+			total += w;
+			t.taps++;
+		}
+		t.weight[largest] = static_cast<uint16_t>(t.weight[largest] + one - total); // (the rounding error)
+		for (uint32_t j = t.taps; j < 3; ++j)
+			t.weight[j] = 0;
+	}
+}
+
+// _transpose8x8() - 8 vectors of 8 x 16-bit: rows <-> columns
+static inline void _transpose8x8(__m128i r[8])
+{
+	const __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+	const __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+	const __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+	const __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+	const __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+	const __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+	const __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+	const __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+	const __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+	const __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+	const __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+	const __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+	const __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+	const __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+	const __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+	const __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+	r[0] = _mm_unpacklo_epi64(b0, b4);
+	r[1] = _mm_unpackhi_epi64(b0, b4);
+	r[2] = _mm_unpacklo_epi64(b1, b5);
+	r[3] = _mm_unpackhi_epi64(b1, b5);
+	r[4] = _mm_unpacklo_epi64(b2, b6);
+	r[5] = _mm_unpackhi_epi64(b2, b6);
+	r[6] = _mm_unpacklo_epi64(b3, b7);
+	r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+// _scale_plane() - 8 output rows at a time:
+//   vertical pass: 8 samples of each of the 8 rows (Q8 weights x 8-bit samples fit in 16 bits),
+//     transposed into m_rows, so that one 16-byte load holds input column x of all 8 rows
+//   horizontal pass: each output column is the same weighted sum for all 8 rows
+//     (_mm_mulhi_epu16 by weight << 7 = Q8 x Q8 >> 9), 8 columns are transposed back into rows
+void CAbrLadder::_scale_plane(const uint8_t *src, const uint32_t src_stride, const uint32_t src_w,
+	uint8_t *dst, const uint32_t dst_stride, const uint32_t dst_w, const uint32_t dst_h,
+	const abr_scaler_t &scaler)
+{
+	const __m128i zero  = _mm_setzero_si128();
+	const int     shift = 2 * ABR_LADDER_WEIGHT_BITS - 9;   // Q8 x Q8 = Q16, _mm_mulhi_epu16 took 9 bits
+	const __m128i round = _mm_set1_epi16(1 << (shift - 1));
+	__m128i r[8];
+
+	for (uint32_t y0 = 0; y0 < dst_h; y0 += 8) {
+		const uint32_t n = (dst_h - y0 < 8) ? dst_h - y0 : 8;  // (the last block repeats its last row)
+		const uint8_t *rows[8][3];
+		__m128i vweight[8][3];
+		const abr_taps_t *vtaps[8];
+		for (uint32_t k = 0; k < 8; ++k) {
+			const abr_taps_t &v = scaler.v[y0 + ((k < n) ? k : n - 1)];
+			vtaps[k] = &v;
+			for (uint32_t j = 0; j < 3; ++j) {
+				rows[k][j]    = src + static_cast<size_t>(v.first + ((j < v.taps) ? j : 0)) * src_stride;
+				vweight[k][j] = _mm_set1_epi16(static_cast<short>(v.weight[j])); // (0 for an unused tap)
+			}
+		}
+
+		// vertical
+		uint32_t x = 0;
+		for (; x + 8 <= src_w; x += 8) {
+			for (uint32_t k = 0; k < 8; ++k) {
+				const __m128i s0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(rows[k][0] + x)), zero);
+				const __m128i s1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(rows[k][1] + x)), zero);
+				const __m128i s2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(rows[k][2] + x)), zero);
+				r[k] = _mm_add_epi16(_mm_add_epi16(
+					_mm_mullo_epi16(s0, vweight[k][0]),
+					_mm_mullo_epi16(s1, vweight[k][1])),
+					_mm_mullo_epi16(s2, vweight[k][2]));
+			}
+			_transpose8x8(r);
+			for (uint32_t i = 0; i < 8; ++i)
+				_mm_store_si128((__m128i *)(m_rows + (x + i) * 8), r[i]);
+		}
+		for (; x < src_w; ++x) {
+			for (uint32_t k = 0; k < 8; ++k) {
+				const abr_taps_t &v = *vtaps[k];
+				m_rows[x * 8 + k] = static_cast<uint16_t>(
+					v.weight[0] * rows[k][0][x] + v.weight[1] * rows[k][1][x] + v.weight[2] * rows[k][2][x]);
+			}
+		}
+
+		// horizontal (an unused tap has weight 0, m_rows is padded for its load)
+		uint16_t column[8];
+		for (uint32_t i = 0; i < dst_w; i += 8) {
+			const uint32_t columns = (dst_w - i < 8) ? dst_w - i : 8;
+			for (uint32_t c = 0; c < columns; ++c) {
+				const abr_taps_t &h = scaler.h[i + c];
+				const uint16_t *in = m_rows + h.first * 8;
+				const __m128i sum = _mm_add_epi16(_mm_add_epi16(
+					_mm_mulhi_epu16(_mm_load_si128((const __m128i *)(in     )), _mm_set1_epi16(static_cast<short>(h.weight[0] << 7))),
+					_mm_mulhi_epu16(_mm_load_si128((const __m128i *)(in +  8)), _mm_set1_epi16(static_cast<short>(h.weight[1] << 7)))),
+					_mm_mulhi_epu16(_mm_load_si128((const __m128i *)(in + 16)), _mm_set1_epi16(static_cast<short>(h.weight[2] << 7))));
+				r[c] = _mm_srli_epi16(_mm_add_epi16(sum, round), shift);
+			}
+			if (columns == 8) {
+				_transpose8x8(r);
+				for (uint32_t k = 0; k < n; ++k)
+					_mm_storel_epi64((__m128i *)(dst + static_cast<size_t>(y0 + k) * dst_stride + i), _mm_packus_epi16(r[k], r[k]));
+				continue;
+			}
+			for (uint32_t c = 0; c < columns; ++c) {
+				_mm_storeu_si128((__m128i *)column, r[c]);
+				for (uint32_t k = 0; k < n; ++k)
+					dst[static_cast<size_t>(y0 + k) * dst_stride + i + c] = static_cast<uint8_t>(column[k]);
+			}
+		}
+	}
+}
@@ -0,0 +1,169 @@
+#include <cstring>   // memset()
+
+#include "casyncrender.h"
+#include "xcodeutil.h"  // NvQueryPerformanceMicrosecs()
+
+CAsyncRender::CAsyncRender() :
+	m_host(NULL),
+	m_disposer(NULL),
+	m_window(1),
+	m_frame_count(0),
+	m_next_queue(0),
+	m_next_out(0),
+	m_completed(false, false) // auto-reset
+{
+	memset( (void *)m_slots, 0, sizeof(m_slots) );
+	memset( (void *)&m_stats, 0, sizeof(m_stats) );
+}
+
+CAsyncRender::~CAsyncRender()
+{
+	End();
+	Detach();
+}
+
+bool CAsyncRender::Begin(IAsyncRenderHost *host, const uint32_t first_frame, const uint32_t frame_count, const uint32_t window)
+{
+	End();
+	if (!host || !window || window > ASYNCRENDER_MAX_WINDOW)
+		return false;
+
+	m_lock.Acquire();
+	m_disposer    = host;
+	m_lock.Release();
+	m_host        = host;
+	m_window      = window;
+	m_frame_count = frame_count;
+	m_next_queue  = first_frame;
+	m_next_out    = first_frame;
+	memset( (void *)m_slots, 0, sizeof(m_slots) );
+	memset( (void *)&m_stats, 0, sizeof(m_stats) );
+	m_completed.Reset();
+
+	_queue_window();
+	return true;
+}
+
+// _queue_window() - queue frames with the host until <window> frames are in flight
+void CAsyncRender::_queue_window()
+{
+	while (m_next_queue < m_frame_count && (m_next_queue - m_next_out) < m_window) {
+		const uint32_t frame = m_next_queue;
+
+		m_lock.Acquire();
+		asyncrender_slot_t &slot = _slot(frame);
+		slot.done   = false;
+		slot.handle = NULL;
+		slot.status = 0;
+		++m_next_queue; // (before QueueRender(): the host may complete the frame right away)
+		m_lock.Release();
+
+		++m_stats.queued;
+		if ((m_next_queue - m_next_out) > m_stats.max_inflight)
+			m_stats.max_inflight = m_next_queue - m_next_out;
+
+		if (!m_host->QueueRender(frame))
+			Complete(frame, NULL, ASYNCRENDER_STATUS_NOT_QUEUED);
+	}
+}
+
+void CAsyncRender::Complete(const uint32_t frame, void *handle, const int32_t status)
+{
+	m_lock.Acquire();
+	if (frame < m_next_out || frame >= m_next_queue) {
+		// not in flight (a duplicate, or End() gave up on it): nothing waits for it
+		if (handle && m_disposer)
+			m_disposer->ReleaseFrame(handle);
+		m_lock.Release();
+		return;
+	}
+
+	asyncrender_slot_t &slot = _slot(frame);
+	slot.handle = handle;
+	slot.status = status;
+	slot.done   = true;
+	m_lock.Release();
+
+	m_completed.Set();
+}
+
+bool CAsyncRender::Next(asyncrender_frame_t &frame, const uint32_t timeout_ms)
+{
+	if (!m_host || m_next_out >= m_next_queue)
+		return false;
+
+	bool waited = false;
+	double t_wait = 0.0, waited_us = 0.0;
+	for (;;) {
+		m_lock.Acquire();
+		const asyncrender_slot_t &slot = _slot(m_next_out);
+		if (slot.done) {
+			frame.frame  = m_next_out;
+			frame.handle = slot.handle;
+			frame.status = slot.status;
+			m_lock.Release();
+			break;
+		}
+		m_lock.Release();
+
+		// the render is behind the encoder: wait for the host
+		if (!waited) {
+			waited = true;
+			t_wait = NvQueryPerformanceMicrosecs();
+			++m_stats.waits;
+		}
+		waited_us = NvQueryPerformanceMicrosecs() - t_wait;
+		if (waited_us >= timeout_ms * 1000.0)
+			break;
+		m_completed.Wait(timeout_ms - static_cast<uint32_t>(waited_us / 1000.0));
+	}
+
+	if (waited)
+		m_stats.wait_us += NvQueryPerformanceMicrosecs() - t_wait;
+	return !waited || waited_us < timeout_ms * 1000.0;
+}
+
+void CAsyncRender::Release(const asyncrender_frame_t &frame)
+{
+	if (!m_host || frame.frame != m_next_out)
+		return;
+
+	if (frame.handle)
+		m_host->ReleaseFrame(frame.handle);
+
+	m_lock.Acquire();
+	asyncrender_slot_t &slot = _slot(frame.frame);
+	slot.done   = false;
+	slot.handle = NULL;
+	++m_next_out;
+	m_lock.Release();
+
+	_queue_window();
+}
+
+void CAsyncRender::End()
+{
+	if (!m_host)
+		return;
+
+	// stop queueing, and collect what the host still has
+	m_frame_count = m_next_queue;
+	asyncrender_frame_t frame;
+	while (m_next_out < m_next_queue) {
+		if (!Next(frame))
+			break; // (the host lost the frame: if it arrives before Detach(), Complete() disposes it)
+		Release(frame);
+	}
+
+	m_lock.Acquire();
+	m_next_out = m_next_queue;
+	m_lock.Release();
+	m_host = NULL;
+}
+
+void CAsyncRender::Detach()
+{
+	m_lock.Acquire();
+	m_disposer = NULL;
+	m_lock.Release();
+}
@@ -0,0 +1,403 @@
+#include <cstring>   // memcmp()
+
+#include "caudiosource.h"
+
+////////////////////
+//
+// MPEG-4 box-parsing helpers
+//
+
+static uint32_t get32(const uint8_t p[])
+{
+	return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+		(static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+static uint64_t get64(const uint8_t p[])
+{
+	return (static_cast<uint64_t>(get32(p)) << 32) | get32(p + 4);
+}
+
+static uint32_t get32le(const uint8_t p[])
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// find_box() - search [data, data+size) for the child-box 'fourcc'
+//   returns the box's payload (the bytes after the box-header), or NULL if not found
+//   (optionally, the complete box is returned in box / box_size)
+static const uint8_t *
+find_box(const uint8_t data[], const size_t size, const char fourcc[], size_t *payload_size,
+	const uint8_t **box = NULL, size_t *box_size = NULL)
+{
+	size_t pos = 0;
+	while (pos + 8 <= size) {
+		uint64_t bsize = get32(data + pos);
+		size_t hdr = 8;
+		if (bsize == 1) {
+			if (pos + 16 > size)
+				return NULL;
+			bsize = get64(data + pos + 8);
+			hdr = 16;
+		}
+		else if (bsize == 0)
+			bsize = size - pos; // box extends to end of the container
+
+		if (bsize < hdr || bsize > size - pos)
+			return NULL; // malformed
+
+		if (memcmp(data + pos + 4, fourcc, 4) == 0) {
+			*payload_size = static_cast<size_t>(bsize) - hdr;
+			if (box) {
+				*box = data + pos;
+				*box_size = static_cast<size_t>(bsize);
+			}
+			return data + pos + hdr;
+		}
+		pos += static_cast<size_t>(bsize);
+	}
+	return NULL;
+}
+
+// find_descriptor() - search an MPEG-4 descriptor-list for the descriptor 'tag'
+//   (descriptor-sizes are coded in 1..4 bytes, 7 bits each)
+static const uint8_t *
+find_descriptor(const uint8_t data[], const size_t size, const uint8_t tag, size_t *payload_size)
+{
+	size_t pos = 0;
+	while (pos + 2 <= size) {
+		const uint8_t this_tag = data[pos++];
+		size_t len = 0;
+		for (unsigned i = 0; i < 4 && pos < size; ++i) {
+			const uint8_t b = data[pos++];
+			len = (len << 7) | (b & 0x7F);
+			if (!(b & 0x80))
+				break;
+		}
+		if (len > size - pos)
+			return NULL;
+		if (this_tag == tag) {
+			*payload_size = len;
+			return data + pos;
+		}
+		pos += len;
+	}
+	return NULL;
+}
+
+////////////////////
+//
+// CAudioSource
+//
+
+CAudioSource::CAudioSource() :
+	codec(AUDIO_SOURCE_NONE), sample_rate(0), channels(0), bits_per_sample(0), block_align(0), channel_mask(0),
+	timescale(0), duration(0), data_offset(0), data_size(0), m_fp(NULL), m_next(0)
+{
+}
+
+bool CAudioSource::OpenWav(FILE *wav)
+{
+	if (wav == NULL)
+		return false;
+
+	// Parse the RIFF/WAVE header: we need the 'fmt ' and 'data' chunks
+	uint8_t hdr[40];
+	if (mux_fseek64(wav, 0, SEEK_SET) != 0 || fread(hdr, 1, 12, wav) != 12 ||
+		memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVE", 4) != 0)
+		return false;
+
+	uint16_t format = 0;
+	uint64_t pos = 12;
+	data_offset = 0;
+	channel_mask = 0;
+	while (data_offset == 0 && fread(hdr, 1, 8, wav) == 8) {
+		const uint32_t chunk_size = get32le(hdr + 4);
+		pos += 8;
+
+		if (memcmp(hdr, "fmt ", 4) == 0) {
+			const size_t n = (chunk_size < sizeof(hdr)) ? chunk_size : sizeof(hdr);
+			if (n < 16 || fread(hdr, 1, n, wav) != n)
+				return false;
+			format          = hdr[0] | (hdr[1] << 8);
+			channels        = hdr[2] | (hdr[3] << 8);
+			sample_rate     = get32le(hdr + 4);
+			block_align     = hdr[12] | (hdr[13] << 8);
+			bits_per_sample = hdr[14] | (hdr[15] << 8);
+			if (format == 0xFFFE && n >= 26) { // WAVE_FORMAT_EXTENSIBLE: SubFormat GUID starts with the format-tag
+				channel_mask = get32le(hdr + 20);
+				format = hdr[24] | (hdr[25] << 8);
+			}
+		}
+		else if (memcmp(hdr, "data", 4) == 0) {
+			data_offset = pos;
+			data_size = chunk_size;
+			break;
+		}
+
+		pos += chunk_size + (chunk_size & 1); // chunks are word-aligned
+		if (mux_fseek64(wav, pos, SEEK_SET) != 0)
+			return false;
+	}
+
+	if (format != 1 || bits_per_sample != 16 || channels == 0 || block_align == 0 || sample_rate == 0 || data_offset == 0)
+		return false; // only 16-bit integer PCM is supported
+
+	// A header which was never finalized (size 0 or 0xFFFFFFFF): use the rest of the file
+	if (mux_fseek64(wav, 0, SEEK_END) == 0) {
+		const int64_t file_size = mux_ftell64(wav);
+		if (file_size > 0 && (data_size == 0 || data_size == 0xFFFFFFFF || data_offset + data_size > static_cast<uint64_t>(file_size)))
+			data_size = static_cast<uint64_t>(file_size) - data_offset;
+	}
+
+	codec     = AUDIO_SOURCE_PCM;
+	timescale = sample_rate;
+	duration  = data_size / block_align;
+	m_fp      = wav;
+	m_next    = 0;
+	return true;
+}
+
+bool CAudioSource::OpenM4a(FILE *m4a)
+{
+	if (m4a == NULL)
+		return false;
+
+	// Read the source file's 'moov' into memory
+	bytes_t moov;
+	uint8_t hdr[16];
+	uint64_t pos = 0;
+	if (mux_fseek64(m4a, 0, SEEK_SET) != 0)
+		return false;
+	while (moov.empty() && fread(hdr, 1, 8, m4a) == 8) {
+		uint64_t size = get32(hdr);
+		uint64_t hdr_size = 8;
+		if (size == 1) {
+			if (fread(hdr + 8, 1, 8, m4a) != 8)
+				return false;
+			size = get64(hdr + 8);
+			hdr_size = 16;
+		}
+		if (size < hdr_size)
+			return false; // size==0 (box to end-of-file) is only legal for a trailing mdat
+
+		if (memcmp(hdr + 4, "moov", 4) == 0) {
+			moov.resize(static_cast<size_t>(size - hdr_size));
+			if (moov.empty() || fread(&moov[0], 1, moov.size(), m4a) != moov.size())
+				return false;
+		}
+		pos += size;
+		if (mux_fseek64(m4a, pos, SEEK_SET) != 0)
+			return false;
+	}
+	if (moov.empty())
+		return false;
+
+	// Locate the first sound-track: moov/trak/mdia/{hdlr,mdhd,minf/stbl}
+	const uint8_t *mdia = NULL, *stbl = NULL, *mdhd = NULL;
+	size_t mdia_size = 0, stbl_size = 0, mdhd_size = 0;
+	{
+		size_t offset = 0;
+		while (stbl == NULL && offset < moov.size()) {
+			const uint8_t *box;
+			size_t box_size, trak_size;
+			const uint8_t *trak = find_box(&moov[offset], moov.size() - offset, "trak", &trak_size, &box, &box_size);
+			if (trak == NULL)
+				break;
+			offset = (box - &moov[0]) + box_size;
+
+			size_t hdlr_size, minf_size;
+			mdia = find_box(trak, trak_size, "mdia", &mdia_size);
+			const uint8_t *hdlr = mdia ? find_box(mdia, mdia_size, "hdlr", &hdlr_size) : NULL;
+			if (hdlr == NULL || hdlr_size < 12 || memcmp(hdlr + 8, "soun", 4) != 0)
+				continue;
+
+			mdhd = find_box(mdia, mdia_size, "mdhd", &mdhd_size);
+			const uint8_t *minf = find_box(mdia, mdia_size, "minf", &minf_size);
+			stbl = minf ? find_box(minf, minf_size, "stbl", &stbl_size) : NULL;
+		}
+	}
+	if (stbl == NULL || mdhd == NULL || mdhd_size < 24)
+		return false;
+
+	if (mdhd[0] == 1) {
+		if (mdhd_size < 32)
+			return false;
+		timescale = get32(mdhd + 20);
+		duration = get64(mdhd + 24);
+	}
+	else {
+		timescale = get32(mdhd + 12);
+		duration = get32(mdhd + 16);
+	}
+
+	// The sample-description (mp4a + esds) and the sample-durations are kept unchanged
+	const uint8_t *box;
+	size_t box_size, size;
+	const uint8_t *stsd_payload = find_box(stbl, stbl_size, "stsd", &size, &box, &box_size);
+	if (stsd_payload == NULL || size < 8 + 36)
+		return false;
+	stsd.assign(box, box + box_size);
+
+	// AudioSampleEntry 'mp4a' -> 'esds' -> ES_Descriptor -> DecoderConfigDescriptor -> DecoderSpecificInfo
+	{
+		const uint8_t *entry = stsd_payload + 8;
+		const size_t entry_size = size - 8;
+		if (memcmp(entry + 4, "mp4a", 4) != 0)
+			return false; // not AAC
+		channels = static_cast<uint16_t>((entry[24] << 8) | entry[25]);
+		sample_rate = get32(entry + 32) >> 16;
+
+		const unsigned version = (entry[16] << 8) | entry[17];
+		const size_t fields = 8 + 28 + ((version == 1) ? 16 : (version == 2) ? 36 : 0);
+		size_t esds_size, es_size, dc_size, dsi_size;
+		const uint8_t *esds = (fields < entry_size) ? find_box(entry + fields, entry_size - fields, "esds", &esds_size) : NULL;
+		const uint8_t *es = (esds && esds_size > 4) ? find_descriptor(esds + 4, esds_size - 4, 0x03, &es_size) : NULL;
+		if (es == NULL || es_size < 3)
+			return false;
+
+		size_t skip = 3; // ES_ID, flags
+		if (es[2] & 0x80) skip += 2;                           // dependsOn_ES_ID
+		if ((es[2] & 0x40) && skip < es_size) skip += 1 + es[skip]; // URL
+		if (es[2] & 0x20) skip += 2;                           // OCR_ES_Id
+		const uint8_t *dc = (skip < es_size) ? find_descriptor(es + skip, es_size - skip, 0x04, &dc_size) : NULL;
+		const uint8_t *dsi = (dc && dc_size > 13) ? find_descriptor(dc + 13, dc_size - 13, 0x05, &dsi_size) : NULL;
+		if (dsi == NULL || dsi_size < 2)
+			return false;
+		asc.assign(dsi, dsi + dsi_size);
+	}
+
+	if (!find_box(stbl, stbl_size, "stts", &size, &box, &box_size))
+		return false;
+	stts.assign(box, box + box_size);
+
+	// sample-sizes
+	const uint8_t *stsz = find_box(stbl, stbl_size, "stsz", &size);
+	if (stsz == NULL || size < 12)
+		return false;
+	const uint32_t const_size = get32(stsz + 4);
+	const uint32_t sample_count = get32(stsz + 8);
+	if (const_size == 0 && size < 12 + static_cast<uint64_t>(sample_count) * 4)
+		return false;
+	sample_size.resize(sample_count);
+	for (uint32_t i = 0; i < sample_count; ++i)
+		sample_size[i] = const_size ? const_size : get32(stsz + 12 + i * 4);
+
+	// sample-times (expanded from the stts run-lengths)
+	if (stts.size() < 16)
+		return false;
+	{
+		const uint32_t entries = get32(&stts[12]);
+		if (stts.size() < 16 + static_cast<uint64_t>(entries) * 8)
+			return false;
+		uint64_t t = 0;
+		sample_time.clear();
+		for (uint32_t e = 0; e < entries && sample_time.size() < sample_count; ++e) {
+			const uint32_t count = get32(&stts[16 + e * 8]);
+			const uint32_t delta = get32(&stts[16 + e * 8 + 4]);
+			for (uint32_t i = 0; i < count && sample_time.size() < sample_count; ++i, t += delta)
+				sample_time.push_back(t);
+		}
+		if (sample_time.size() != sample_count)
+			return false;
+	}
+
+	// chunk-offsets
+	const uint8_t *stco = find_box(stbl, stbl_size, "stco", &size);
+	const bool co64 = (stco == NULL);
+	if (co64)
+		stco = find_box(stbl, stbl_size, "co64", &size);
+	if (stco == NULL || size < 8)
+		return false;
+	const uint32_t chunk_count = get32(stco + 4);
+	if (size < 8 + static_cast<uint64_t>(chunk_count) * (co64 ? 8 : 4))
+		return false;
+	chunk_offset.clear();
+	for (uint32_t i = 0; i < chunk_count; ++i)
+		chunk_offset.push_back(co64 ? get64(stco + 8 + i * 8) : get32(stco + 8 + i * 4));
+
+	// sample-to-chunk: expand into #samples for every chunk
+	const uint8_t *stsc = find_box(stbl, stbl_size, "stsc", &size);
+	if (stsc == NULL || size < 8)
+		return false;
+	const uint32_t stsc_count = get32(stsc + 4);
+	if (size < 8 + static_cast<uint64_t>(stsc_count) * 12)
+		return false;
+	chunk_samples.assign(chunk_count, 0);
+	for (uint32_t e = 0; e < stsc_count; ++e) {
+		const uint32_t first = get32(stsc + 8 + e * 12);
+		const uint32_t last = (e + 1 < stsc_count) ? get32(stsc + 8 + (e + 1) * 12) : (chunk_count + 1);
+		const uint32_t per_chunk = get32(stsc + 8 + e * 12 + 4);
+		for (uint32_t c = first; c < last && c <= chunk_count; ++c)
+			if (c >= 1)
+				chunk_samples[c - 1] = per_chunk;
+	}
+
+	// file-offset of every sample
+	sample_offset.clear();
+	for (uint32_t c = 0; c < chunk_count; ++c) {
+		uint64_t offset = chunk_offset[c];
+		for (uint32_t i = 0; i < chunk_samples[c] && sample_offset.size() < sample_count; ++i) {
+			sample_offset.push_back(offset);
+			offset += sample_size[sample_offset.size() - 1];
+		}
+	}
+	if (sample_offset.size() != sample_count)
+		return false; // inconsistent sample-tables
+
+	codec  = AUDIO_SOURCE_AAC;
+	m_fp   = m4a;
+	m_next = 0;
+	return true;
+}
+
+bool CAudioSource::Eof() const
+{
+	switch (codec) {
+	case AUDIO_SOURCE_PCM: return m_next >= duration;
+	case AUDIO_SOURCE_AAC: return m_next >= sample_size.size();
+	default:               return true;
+	}
+}
+
+uint64_t CAudioSource::NextTime() const
+{
+	if (codec == AUDIO_SOURCE_AAC)
+		return (m_next < sample_time.size()) ? sample_time[static_cast<size_t>(m_next)] : duration;
+	return m_next; // PCM: timestamp == PCM-frame#
+}
+
+bool CAudioSource::ReadFrame(bytes_t &frame, uint64_t *time, const uint32_t max_pcm_frames)
+{
+	if (Eof())
+		return false;
+
+	uint64_t offset, size;
+	*time = NextTime();
+	if (codec == AUDIO_SOURCE_AAC) {
+		offset = sample_offset[static_cast<size_t>(m_next)];
+		size = sample_size[static_cast<size_t>(m_next)];
+		++m_next;
+	}
+	else {
+		const uint64_t n = (duration - m_next < max_pcm_frames) ? (duration - m_next) : max_pcm_frames;
+		offset = data_offset + m_next * block_align;
+		size = n * block_align;
+		m_next += n;
+	}
+
+	frame.resize(static_cast<size_t>(size));
+	return size == 0 || (mux_fseek64(m_fp, offset, SEEK_SET) == 0 &&
+		fread(&frame[0], 1, frame.size(), m_fp) == frame.size());
+}
+
+uint32_t CAudioSource::GetBitRate() const
+{
+	if (codec == AUDIO_SOURCE_PCM)
+		return sample_rate * block_align * 8;
+
+	uint64_t total = 0;
+	for (size_t i = 0; i < sample_size.size(); ++i)
+		total += sample_size[i];
+	return (duration && timescale) ? static_cast<uint32_t>(total * 8 * timescale / duration) : 0;
+}
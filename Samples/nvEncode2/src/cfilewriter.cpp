@@ -0,0 +1,374 @@
+#include <cstring>   // memcpy(), memset()
+#include <cstdlib>
+
+#include "cfilewriter.h"
+#include "xcodeutil.h"  // NvQueryPerformanceMicrosecs()
+
+#if !defined(WIN32) && !defined(_WIN32) && !defined(WIN64)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static uint8_t *_filewriter_alloc(const size_t size)
+{
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+	return static_cast<uint8_t *>(VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+#else
+	void *p = NULL;
+	return (posix_memalign(&p, FILEWRITER_ALIGN, size) == 0) ? static_cast<uint8_t *>(p) : NULL;
+#endif
+}
+
+static void _filewriter_free(uint8_t *p)
+{
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+	if (p)
+		VirtualFree(p, 0, MEM_RELEASE);
+#else
+	free(p);
+#endif
+}
+
+CFileWriter::CFileWriter() :
+	CNvThread("CFileWriter", INvThreading::NV_THREAD_PRIORITY_NORMAL, true), // one-shot: ThreadFunc() runs until the sentinel
+	m_open(false),
+	m_unbuffered(false),
+	m_io_error(false),
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+	m_handle(INVALID_HANDLE_VALUE),
+	m_inflight_count(0),
+#else
+	m_fd(-1),
+#endif
+	m_buffer_count(0),
+	m_buffer_size(0),
+	m_current(0),
+	m_fill(0),
+	m_offset(0),
+	m_free(FILEWRITER_MAX_BUFFERS),
+	m_queued(FILEWRITER_MAX_BUFFERS + 1) // (+ the sentinel)
+{
+	memset(m_buffer, 0, sizeof(m_buffer));
+	memset(&m_stats, 0, sizeof(m_stats));
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+	memset(m_overlapped, 0, sizeof(m_overlapped));
+#endif
+}
+
+CFileWriter::~CFileWriter()
+{
+	if (m_open)
+		Close();
+	_release();
+}
+
+bool CFileWriter::Open(const char *filename, const uint64_t prealloc_bytes, const uint32_t buffer_size, const uint32_t buffer_count)
+{
+	if (m_open || !filename || !_open_handle(filename, false))
+		return false;
+	return _start(prealloc_bytes, buffer_size, buffer_count);
+}
+
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+bool CFileWriter::Open(const wchar_t *filename, const uint64_t prealloc_bytes, const uint32_t buffer_size, const uint32_t buffer_count)
+{
+	if (m_open || !filename || !_open_handle(filename, true))
+		return false;
+	return _start(prealloc_bytes, buffer_size, buffer_count);
+}
+#endif
+
+bool CFileWriter::_open_handle(const void *filename, const bool wide)
+{
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+	// unbuffered first; network shares and some filters refuse FILE_FLAG_NO_BUFFERING
+	const DWORD flags[2] = {
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN
+	};
+	for (int i = 0; i < 2 && m_handle == INVALID_HANDLE_VALUE; ++i) {
+		m_handle = wide ?
+			CreateFileW(static_cast<const wchar_t *>(filename), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, flags[i], NULL) :
+			CreateFileA(static_cast<const char *>(filename), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, flags[i], NULL);
+		m_unbuffered = (i == 0);
+	}
+	return m_handle != INVALID_HANDLE_VALUE;
+#else
+	(void)wide;
+	const char *name = static_cast<const char *>(filename);
+	m_unbuffered = false;
+#if defined(O_DIRECT)
+	m_fd = open(name, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0666);
+	m_unbuffered = (m_fd >= 0);
+	if (m_fd < 0 && errno != EINVAL) // EINVAL: the file-system doesn't do O_DIRECT (i.e. tmpfs)
+		return false;
+#endif
+	if (m_fd < 0)
+		m_fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	return m_fd >= 0;
+#endif
+}
+
+bool CFileWriter::_start(const uint64_t prealloc_bytes, const uint32_t buffer_size, const uint32_t buffer_count)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_stats.unbuffered = m_unbuffered;
+
+	m_buffer_size  = (buffer_size < FILEWRITER_ALIGN) ? FILEWRITER_ALIGN : (buffer_size & ~(FILEWRITER_ALIGN - 1));
+	m_buffer_count = (buffer_count < 2) ? 2 : (buffer_count > FILEWRITER_MAX_BUFFERS) ? FILEWRITER_MAX_BUFFERS : buffer_count;
+	m_io_error     = false;
+
+	for (uint32_t i = 0; i < m_buffer_count; ++i) {
+		m_buffer[i] = _filewriter_alloc(m_buffer_size);
+		if (!m_buffer[i]) {
+			_release();
+			return false;
+		}
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+		memset(&m_overlapped[i], 0, sizeof(m_overlapped[i]));
+		m_overlapped[i].hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+#endif
+		if (i)
+			m_free.Add(i);
+	}
+
+	// reserve the disk-space (a hint: failure is not an error)
+	if (prealloc_bytes) {
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+		FILE_ALLOCATION_INFO alloc;
+		alloc.AllocationSize.QuadPart = static_cast<LONGLONG>(prealloc_bytes);
+		m_stats.preallocated = SetFileInformationByHandle(m_handle, FileAllocationInfo, &alloc, sizeof(alloc)) != FALSE;
+
+		// If the process holds SE_MANAGE_VOLUME_NAME, also skip the zero-fill of the reserved
+		// clusters.  The file is truncated to its real size in Close().
+		if (m_stats.preallocated) {
+			FILE_END_OF_FILE_INFO eof;
+			eof.EndOfFile.QuadPart = static_cast<LONGLONG>(prealloc_bytes);
+			if (SetFileInformationByHandle(m_handle, FileEndOfFileInfo, &eof, sizeof(eof))
+				&& !SetFileValidData(m_handle, static_cast<LONGLONG>(prealloc_bytes)))
+			{
+				eof.EndOfFile.QuadPart = 0;
+				SetFileInformationByHandle(m_handle, FileEndOfFileInfo, &eof, sizeof(eof));
+			}
+		}
+#elif defined(__linux) && defined(FALLOC_FL_KEEP_SIZE)
+		m_stats.preallocated = fallocate(m_fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(prealloc_bytes)) == 0;
+#endif
+	}
+
+	m_current = 0;
+	m_fill    = 0;
+	m_offset  = 0;
+	m_open    = true;
+	ThreadStart();
+	return true;
+}
+
+size_t CFileWriter::Write(const void *data, const size_t size)
+{
+	if (!m_open || m_io_error)
+		return 0;
+
+	const uint8_t *src = static_cast<const uint8_t *>(data);
+	size_t left = size;
+	while (left) {
+		size_t n = m_buffer_size - m_fill;
+		if (n > left)
+			n = left;
+		memcpy(m_buffer[m_current] + m_fill, src, n);
+		m_fill += static_cast<uint32_t>(n);
+		src    += n;
+		left   -= n;
+
+		if (m_fill == m_buffer_size) {
+			_submit_current();
+			if (!_next_buffer())
+				return 0;
+		}
+	}
+
+	m_stats.bytes += size;
+	return m_io_error ? 0 : size;
+}
+
+bool CFileWriter::Close()
+{
+	if (!m_open)
+		return false;
+
+	// the last buffer: unbuffered I/O only writes whole sectors, so pad it (and truncate below)
+	const uint64_t file_size = m_offset + m_fill;
+	if (m_fill) {
+		if (m_unbuffered) {
+			const uint32_t padded = (m_fill + FILEWRITER_ALIGN - 1) & ~(FILEWRITER_ALIGN - 1);
+			memset(m_buffer[m_current] + m_fill, 0, padded - m_fill);
+			m_fill = padded;
+		}
+		_submit_current();
+	}
+
+	filewriter_block_t sentinel;
+	memset(&sentinel, 0, sizeof(sentinel));
+	sentinel.quit = true;
+	m_queued.Add(sentinel);
+	ThreadQuit(); // waits for the writer-thread
+
+	bool ok = !m_io_error;
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+	FILE_END_OF_FILE_INFO eof;
+	eof.EndOfFile.QuadPart = static_cast<LONGLONG>(file_size);
+	ok = (SetFileInformationByHandle(m_handle, FileEndOfFileInfo, &eof, sizeof(eof)) != FALSE) && ok;
+	CloseHandle(m_handle);
+	m_handle = INVALID_HANDLE_VALUE;
+#else
+	ok = (ftruncate(m_fd, static_cast<off_t>(file_size)) == 0) && ok;
+	ok = (close(m_fd) == 0) && ok;
+	m_fd = -1;
+#endif
+
+	m_open = false;
+	_release();
+	return ok;
+}
+
+void CFileWriter::_submit_current()
+{
+	filewriter_block_t block;
+	block.index  = m_current;
+	block.size   = m_fill;
+	block.offset = m_offset;
+	block.quit   = false;
+	m_queued.Add(block); // never blocks: there are more slots than buffers
+
+	m_offset += m_fill;
+	m_fill    = 0;
+}
+
+bool CFileWriter::_next_buffer()
+{
+	if (m_free.Remove(m_current, 0))
+		return true;
+
+	// backpressure: every buffer is queued (or being written)
+	const double t = NvQueryPerformanceMicrosecs();
+	const bool ok = m_free.Remove(m_current, INvThreading::NV_TIMEOUT_INFINITE);
+	m_stats.stalls++;
+	m_stats.stall_us += NvQueryPerformanceMicrosecs() - t;
+	return ok;
+}
+
+// ThreadFunc() - the writer-thread: writes the queued buffers in order, until the sentinel
+bool CFileWriter::ThreadFunc()
+{
+	filewriter_block_t block;
+	for (;;) {
+		bool queued = m_queued.Remove(block, 0);
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+		while (!queued && m_inflight_count) { // nothing new to write: complete the outstanding writes
+			_complete_oldest();
+			queued = m_queued.Remove(block, 0);
+		}
+#endif
+		if (!queued)
+			m_queued.Remove(block, INvThreading::NV_TIMEOUT_INFINITE);
+
+		if (block.quit)
+			break;
+		if (!_issue(block))
+			m_io_error = true;
+	}
+
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+	while (m_inflight_count)
+		_complete_oldest();
+#endif
+	return false;
+}
+
+bool CFileWriter::_issue(const filewriter_block_t &block)
+{
+	m_stats.writes++;
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+	if (m_inflight_count == FILEWRITER_MAX_INFLIGHT)
+		_complete_oldest();
+
+	OVERLAPPED &ov = m_overlapped[block.index];
+	ResetEvent(ov.hEvent);
+	ov.Offset     = static_cast<DWORD>(block.offset);
+	ov.OffsetHigh = static_cast<DWORD>(block.offset >> 32);
+	if (!WriteFile(m_handle, m_buffer[block.index], block.size, NULL, &ov) && GetLastError() != ERROR_IO_PENDING) {
+		m_free.Add(block.index);
+		return false;
+	}
+	m_inflight[m_inflight_count++] = block.index;
+	return true;
+#else
+	const uint8_t *p = m_buffer[block.index];
+	uint32_t left    = block.size;
+	off_t offset     = static_cast<off_t>(block.offset);
+	bool ok = true;
+	while (left && ok) {
+		const ssize_t n = pwrite(m_fd, p, left, offset);
+		if (n < 0 && errno == EINTR)
+			continue;
+		ok = (n > 0);
+		if (ok) {
+			p      += n;
+			left   -= static_cast<uint32_t>(n);
+			offset += n;
+		}
+	}
+	m_free.Add(block.index);
+	return ok;
+#endif
+}
+
+bool CFileWriter::_complete_oldest()
+{
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+	if (!m_inflight_count)
+		return true;
+
+	const uint32_t index = m_inflight[0];
+	--m_inflight_count;
+	memmove(&m_inflight[0], &m_inflight[1], m_inflight_count * sizeof(m_inflight[0]));
+
+	DWORD written = 0;
+	const bool ok = GetOverlappedResult(m_handle, &m_overlapped[index], &written, TRUE) != FALSE;
+	if (!ok)
+		m_io_error = true;
+	m_free.Add(index);
+	return ok;
+#else
+	return true;
+#endif
+}
+
+void CFileWriter::_release()
+{
+	uint32_t index;
+	while (m_free.Remove(index, 0))
+		;
+	for (uint32_t i = 0; i < FILEWRITER_MAX_BUFFERS; ++i) {
+		_filewriter_free(m_buffer[i]);
+		m_buffer[i] = NULL;
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+		if (m_overlapped[i].hEvent)
+			CloseHandle(m_overlapped[i].hEvent);
+		m_overlapped[i].hEvent = NULL;
+#endif
+	}
+	m_buffer_count = 0;
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+	if (m_handle != INVALID_HANDLE_VALUE && !m_open) {
+		CloseHandle(m_handle);
+		m_handle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (m_fd >= 0 && !m_open) {
+		close(m_fd);
+		m_fd = -1;
+	}
+#endif
+}
@@ -0,0 +1,219 @@
+#include <cstring>   // memset()
+#include <cmath>     // sqrtf()
+#include <assert.h>
+
+#include "clookahead.h"
+
+CLookahead::CLookahead() :
+	m_width(0), m_height(0), m_depth(0),
+	m_thumb_w(0), m_thumb_h(0), m_thumb_pitch(0), m_thumb_size(0), m_slots(0),
+	m_thumbs(NULL), m_row8(NULL), m_row8_pitch(0)
+{
+	memset(m_stats, 0, sizeof(m_stats));
+	Reset();
+}
+
+CLookahead::~CLookahead()
+{
+	Release();
+}
+
+bool CLookahead::Init(const uint32_t width, const uint32_t height, const uint32_t depth)
+{
+	Release();
+
+	const uint32_t thumb_w = width / LOOKAHEAD_BLOCK;  // (a partial block at the right/bottom edge is ignored)
+	const uint32_t thumb_h = height / LOOKAHEAD_BLOCK;
+	if (!thumb_w || !thumb_h)
+		return false;
+
+	m_width       = width;
+	m_height      = height;
+	m_depth       = (depth > LOOKAHEAD_MAX_DEPTH) ? LOOKAHEAD_MAX_DEPTH : depth;
+	m_thumb_w     = thumb_w;
+	m_thumb_h     = thumb_h;
+	m_thumb_pitch = (thumb_w + 15) & ~15;
+	m_slots       = m_depth + 3;
+	m_row8_pitch  = (thumb_w * LOOKAHEAD_BLOCK + 15) & ~15;
+
+	m_thumbs = new uint8_t[m_slots * m_thumb_pitch * thumb_h];
+	m_row8   = new uint8_t[m_row8_pitch * LOOKAHEAD_BLOCK];
+	memset(m_thumbs, 0, m_slots * m_thumb_pitch * thumb_h);
+	m_thumb_size = m_thumb_pitch * thumb_h;
+
+	Reset();
+	return true;
+}
+
+void CLookahead::Release()
+{
+	delete [] m_thumbs;
+	delete [] m_row8;
+	m_thumbs     = NULL;
+	m_row8       = NULL;
+	m_thumb_size = 0;
+}
+
+void CLookahead::Reset()
+{
+	m_analyzed = 0;
+	m_decided  = 0;
+	m_last_cut = 0;
+	m_avg_sad  = 0;
+}
+
+void CLookahead::Analyze(const uint8_t *luma, const uint32_t pitch, const uint32_t bytes_per_sample)
+{
+	assert(IsEnabled());
+	assert(Pending() <= m_depth); // (else the thumbnail of a pending frame would be overwritten)
+
+	const uint32_t frame = m_analyzed;
+	uint8_t *thumb = _thumb(frame);
+	lookahead_stats_t &stats = m_stats[frame % m_slots];
+
+	stats.activity = _downsample(luma, pitch, bytes_per_sample, thumb);
+	stats.sad1 = (frame >= 1) ? _sad(thumb, _thumb(frame - 1)) : 0;
+	stats.sad2 = (frame >= 2) ? _sad(thumb, _thumb(frame - 2)) : stats.sad1;
+	++m_analyzed;
+}
+
+bool CLookahead::Decide(lookahead_hint_t &hint)
+{
+	if (!Pending())
+		return false;
+
+	const uint32_t frame = m_decided;
+	const lookahead_stats_t &stats = m_stats[frame % m_slots];
+	const float threshold = (LOOKAHEAD_SCENECUT_RATIO * m_avg_sad > LOOKAHEAD_SCENECUT_MIN) ?
+		LOOKAHEAD_SCENECUT_RATIO * m_avg_sad : LOOKAHEAD_SCENECUT_MIN;
+
+	// a scene-cut differs from both of the previous frames (a frame which returns to
+	// frame-2 is the end of a flash) ...
+	bool scene_cut = (frame > 0) &&
+		(frame - m_last_cut >= LOOKAHEAD_MIN_CUT_DISTANCE) &&
+		(stats.sad1 > threshold) && (stats.sad2 > threshold);
+
+	// ... and the next frame doesn't return to the previous picture (then this one is the flash)
+	if (scene_cut && (frame + 1 < m_analyzed)) {
+		const lookahead_stats_t &next = m_stats[(frame + 1) % m_slots];
+		if (next.sad2 < LOOKAHEAD_FLASH_RATIO * stats.sad1)
+			scene_cut = false;
+	}
+
+	if (scene_cut)
+		m_last_cut = frame;
+	else if ((frame > 0) && (stats.sad1 <= threshold))
+		m_avg_sad = (frame == 1) ? stats.sad1 : (0.9f * m_avg_sad + 0.1f * stats.sad1);
+
+	// complexity: relative to the frames in the lookahead window (the pending frames are
+	// costed without their scene-cut decision)
+	const float cost = _cost(stats, scene_cut || (frame == 0));
+	float window_cost = cost;
+	for (uint32_t f = frame + 1; f < m_analyzed; ++f)
+		window_cost += _cost(m_stats[f % m_slots], false);
+	window_cost /= (m_analyzed - frame);
+
+	hint.frame       = frame;
+	hint.sad         = stats.sad1;
+	hint.activity    = stats.activity;
+	hint.cost        = cost;
+	hint.window_cost = window_cost;
+	hint.complexity  = cost / window_cost;
+	hint.scene_cut   = scene_cut;
+
+	++m_decided;
+	return true;
+}
+
+float CLookahead::_cost(const lookahead_stats_t &stats, const bool scene_cut) const
+{
+	const float cost = (scene_cut || (stats.sad1 > stats.activity)) ? stats.activity : stats.sad1;
+	return (cost < 1.0f) ? 1.0f : cost; // (a static, flat picture still costs something)
+}
+
+float CLookahead::_downsample(const uint8_t *luma, const uint32_t pitch, const uint32_t bytes_per_sample, uint8_t *thumb)
+{
+	double std_total = 0;
+
+	for (uint32_t by = 0; by < m_thumb_h; ++by) {
+		const uint8_t *rows = luma + by * LOOKAHEAD_BLOCK * pitch;
+
+		if (bytes_per_sample == 1) {
+			_block_row(rows, pitch, thumb + by * m_thumb_pitch, std_total);
+			continue;
+		}
+
+		// 16-bit (MSB-aligned) samples: keep the upper 8 bits
+		for (uint32_t r = 0; r < LOOKAHEAD_BLOCK; ++r) {
+			const uint8_t *src = rows + r * pitch;
+			uint8_t *dst = m_row8 + r * m_row8_pitch;
+			for (uint32_t x = 0; x < m_thumb_w * LOOKAHEAD_BLOCK; x += 8) {
+				const __m128i w = _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src + 2 * x)), 8);
+				_mm_storel_epi64((__m128i *)(dst + x), _mm_packus_epi16(w, w));
+			}
+		}
+		_block_row(m_row8, m_row8_pitch, thumb + by * m_thumb_pitch, std_total);
+	}
+
+	return static_cast<float>(std_total / (m_thumb_w * m_thumb_h));
+}
+
+// _block_row() - one row of 8x8 blocks: the average (thumbnail pixel) and the standard-deviation of each block
+//   _mm_sad_epu8 against 0 sums 8 pixels per 64-bit lane, _mm_madd_epi16 sums the squares
+void CLookahead::_block_row(const uint8_t *rows, const uint32_t pitch, uint8_t *thumb_row, double &std_total) const
+{
+	const __m128i zero = _mm_setzero_si128();
+	uint32_t sum[2];
+	uint32_t sumsq[2];
+
+	for (uint32_t bx = 0; bx < m_thumb_w; bx += 2) {
+		const uint32_t x = bx * LOOKAHEAD_BLOCK;
+		const uint32_t blocks = (bx + 1 < m_thumb_w) ? 2 : 1;
+		__m128i acc_sum = zero;
+		__m128i acc_sq0 = zero;
+		__m128i acc_sq1 = zero;
+
+		for (uint32_t r = 0; r < LOOKAHEAD_BLOCK; ++r) {
+			const __m128i v = (blocks == 2) ?
+				_mm_loadu_si128((const __m128i *)(rows + r * pitch + x)) :
+				_mm_loadl_epi64((const __m128i *)(rows + r * pitch + x));
+			const __m128i lo = _mm_unpacklo_epi8(v, zero);
+			const __m128i hi = _mm_unpackhi_epi8(v, zero);
+			acc_sum = _mm_add_epi64(acc_sum, _mm_sad_epu8(v, zero));
+			acc_sq0 = _mm_add_epi32(acc_sq0, _mm_madd_epi16(lo, lo));
+			acc_sq1 = _mm_add_epi32(acc_sq1, _mm_madd_epi16(hi, hi));
+		}
+
+		// horizontal sums of the squares
+		acc_sq0 = _mm_add_epi32(acc_sq0, _mm_srli_si128(acc_sq0, 8));
+		acc_sq0 = _mm_add_epi32(acc_sq0, _mm_srli_si128(acc_sq0, 4));
+		acc_sq1 = _mm_add_epi32(acc_sq1, _mm_srli_si128(acc_sq1, 8));
+		acc_sq1 = _mm_add_epi32(acc_sq1, _mm_srli_si128(acc_sq1, 4));
+		sum[0]   = static_cast<uint32_t>(_mm_cvtsi128_si32(acc_sum));
+		sum[1]   = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(acc_sum, 8)));
+		sumsq[0] = static_cast<uint32_t>(_mm_cvtsi128_si32(acc_sq0));
+		sumsq[1] = static_cast<uint32_t>(_mm_cvtsi128_si32(acc_sq1));
+
+		for (uint32_t b = 0; b < blocks; ++b) {
+			// variance = E[x^2] - E[x]^2  (64 pixels per block)
+			const float mean = sum[b] * (1.0f / 64);
+			const float var  = sumsq[b] * (1.0f / 64) - mean * mean;
+			thumb_row[bx + b] = static_cast<uint8_t>((sum[b] + 32) >> 6);
+			std_total += (var > 0) ? sqrtf(var) : 0;
+		}
+	}
+}
+
+// _sad() - mean absolute difference of two thumbnails (the zero padding adds nothing)
+float CLookahead::_sad(const uint8_t *a, const uint8_t *b) const
+{
+	__m128i acc = _mm_setzero_si128();
+	for (uint32_t i = 0; i < m_thumb_size; i += 16)
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(
+			_mm_loadu_si128((const __m128i *)(a + i)),
+			_mm_loadu_si128((const __m128i *)(b + i))));
+
+	const uint32_t total = static_cast<uint32_t>(_mm_cvtsi128_si32(acc)) +
+		static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+	return static_cast<float>(total) / (m_thumb_w * m_thumb_h);
+}
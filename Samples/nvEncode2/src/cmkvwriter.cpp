@@ -0,0 +1,628 @@
+#include <cstring>   // memcpy(), memcmp()
+
+#include "cmkvwriter.h"
+#include "cnalutil.h"
+
+#define MKV_TIMESTAMP_SCALE     1000000 // (nsec) == 1msec block-timestamps
+#define MKV_CLUSTER_MAX_MSEC    5000    // a cluster is closed after 5sec, even without a sync-sample
+#define MKV_BLOCK_MAX_OFFSET    32767   // (msec) limit of the int16 block-timestamp, relative to the cluster
+#define MKV_SEEKHEAD_RESERVED   96      // bytes reserved (as Void) for the SeekHead
+#define MKV_PCM_BLOCK_MSEC      20      // PCM: audio per SimpleBlock
+
+#define MKV_TRACK_VIDEO         1
+#define MKV_TRACK_AUDIO         2
+
+// EBML/Matroska element-IDs (the IDs include their length-marker bits)
+#define EBML_ID_HEADER          0x1A45DFA3
+#define EBML_ID_VERSION         0x4286
+#define EBML_ID_READ_VERSION    0x42F7
+#define EBML_ID_MAX_ID_LENGTH   0x42F2
+#define EBML_ID_MAX_SIZE_LENGTH 0x42F3
+#define EBML_ID_DOCTYPE         0x4282
+#define EBML_ID_DOCTYPE_VERSION 0x4287
+#define EBML_ID_DOCTYPE_READ    0x4285
+#define EBML_ID_VOID            0xEC
+
+#define MKV_ID_SEGMENT          0x18538067
+#define MKV_ID_SEEKHEAD         0x114D9B74
+#define MKV_ID_SEEK             0x4DBB
+#define MKV_ID_SEEK_ID          0x53AB
+#define MKV_ID_SEEK_POSITION    0x53AC
+#define MKV_ID_INFO             0x1549A966
+#define MKV_ID_TIMESTAMP_SCALE  0x2AD7B1
+#define MKV_ID_DURATION         0x4489
+#define MKV_ID_MUXING_APP       0x4D80
+#define MKV_ID_WRITING_APP      0x5741
+#define MKV_ID_TRACKS           0x1654AE6B
+#define MKV_ID_TRACK_ENTRY      0xAE
+#define MKV_ID_TRACK_NUMBER     0xD7
+#define MKV_ID_TRACK_UID        0x73C5
+#define MKV_ID_TRACK_TYPE       0x83
+#define MKV_ID_FLAG_LACING      0x9C
+#define MKV_ID_LANGUAGE         0x22B59C
+#define MKV_ID_CODEC_ID         0x86
+#define MKV_ID_CODEC_PRIVATE    0x63A2
+#define MKV_ID_DEFAULT_DURATION 0x23E383
+#define MKV_ID_VIDEO            0xE0
+#define MKV_ID_PIXEL_WIDTH      0xB0
+#define MKV_ID_PIXEL_HEIGHT     0xBA
+#define MKV_ID_AUDIO            0xE1
+#define MKV_ID_SAMPLING_FREQ    0xB5
+#define MKV_ID_CHANNELS         0x9F
+#define MKV_ID_BIT_DEPTH        0x6264
+#define MKV_ID_CLUSTER          0x1F43B675
+#define MKV_ID_TIMESTAMP        0xE7
+#define MKV_ID_SIMPLEBLOCK      0xA3
+#define MKV_ID_CUES             0x1C53BB6B
+#define MKV_ID_CUE_POINT        0xBB
+#define MKV_ID_CUE_TIME         0xB3
+#define MKV_ID_CUE_TRACK_POS    0xB7
+#define MKV_ID_CUE_TRACK        0xF7
+#define MKV_ID_CUE_CLUSTER_POS  0xF1
+
+#define MKV_MUXING_APP          "nvenc_export"
+
+////////////////////
+//
+// EBML-building helpers
+//
+//   Master-elements are assembled in a memory buffer (payload first), then
+//   appended with the minimal size-field.  Elements which are patched later
+//   (Segment, Cluster) use a fixed 8-byte size-field instead.
+//
+
+static void put_be(std::vector<uint8_t> &b, const uint64_t v, const unsigned bytes)
+{
+	for (unsigned i = bytes; i > 0; --i)
+		b.push_back(static_cast<uint8_t>(v >> (8 * (i - 1))));
+}
+
+static void ebml_id(std::vector<uint8_t> &b, const uint32_t id)
+{
+	put_be(b, id, (id > 0xFFFFFF) ? 4 : (id > 0xFFFF) ? 3 : (id > 0xFF) ? 2 : 1);
+}
+
+// ebml_size() - minimal-length vint (all-ones is reserved for 'unknown size')
+static void ebml_size(std::vector<uint8_t> &b, const uint64_t size)
+{
+	unsigned len = 1;
+	while (len < 8 && size >= (1ULL << (7 * len)) - 1)
+		++len;
+	put_be(b, size | (1ULL << (7 * len)), len);
+}
+
+// ebml_size8() - fixed 8-byte size-field (for sizes patched in later)
+static void ebml_size8(std::vector<uint8_t> &b, const uint64_t size)
+{
+	put_be(b, size | (1ULL << 56), 8);
+}
+
+static void ebml_uint(std::vector<uint8_t> &b, const uint32_t id, const uint64_t v)
+{
+	unsigned len = 1;
+	while (len < 8 && (v >> (8 * len)) != 0)
+		++len;
+	ebml_id(b, id);
+	ebml_size(b, len);
+	put_be(b, v, len);
+}
+
+static void ebml_float(std::vector<uint8_t> &b, const uint32_t id, const double v)
+{
+	uint64_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	ebml_id(b, id);
+	ebml_size(b, 8);
+	put_be(b, bits, 8);
+}
+
+static void ebml_binary(std::vector<uint8_t> &b, const uint32_t id, const uint8_t data[], const size_t size)
+{
+	ebml_id(b, id);
+	ebml_size(b, size);
+	b.insert(b.end(), data, data + size);
+}
+
+static void ebml_string(std::vector<uint8_t> &b, const uint32_t id, const char *s)
+{
+	ebml_binary(b, id, reinterpret_cast<const uint8_t *>(s), strlen(s));
+}
+
+static void ebml_master(std::vector<uint8_t> &b, const uint32_t id, const std::vector<uint8_t> &payload)
+{
+	ebml_id(b, id);
+	ebml_size(b, payload.size());
+	b.insert(b.end(), payload.begin(), payload.end());
+}
+
+// ebml_void() - Void element of exactly 'size' bytes (size >= 2)
+static void ebml_void(std::vector<uint8_t> &b, const size_t size)
+{
+	const size_t payload = (size - 2 < 127) ? (size - 2) : (size - 9);
+	ebml_id(b, EBML_ID_VOID);
+	if (size - 2 < 127)
+		ebml_size(b, payload);
+	else
+		ebml_size8(b, payload);
+	b.insert(b.end(), payload, 0);
+}
+
+////////////////////
+//
+// CMkvWriter
+//
+
+CMkvWriter::CMkvWriter() :
+	m_fp(NULL), m_codec(MKV_VIDEO_NONE), m_width(0), m_height(0), m_rate_num(0), m_rate_den(1),
+	m_io_error(false), m_pos(0), m_header_written(false), m_segment_data(0), m_seekhead_pos(0),
+	m_info_pos(0), m_duration_pos(0), m_tracks_pos(0), m_cluster_open(false), m_cluster_pos(0),
+	m_cluster_time(0), m_frame_count(0), m_pts_base(0), m_video_end(0),
+	m_pcm_frames(0), m_audio_end(0)
+{
+}
+
+CMkvWriter::~CMkvWriter()
+{
+	// the FILE handles belong to the caller
+}
+
+bool CMkvWriter::Open(
+	FILE                   *fp,
+	const mkv_video_codec_t codec,
+	const uint32_t          width,
+	const uint32_t          height,
+	const uint32_t          frameRateNum,
+	const uint32_t          frameRateDen
+) {
+	if (fp == NULL || (codec != MKV_VIDEO_NONE && (frameRateNum == 0 || frameRateDen == 0)))
+		return false;
+
+	m_fp = fp;
+	m_codec = codec;
+	m_width = width;
+	m_height = height;
+	m_rate_num = frameRateNum;
+	m_rate_den = frameRateDen;
+	m_io_error = false;
+	m_pos = mux_ftell64(fp);
+	m_header_written = false;
+	m_cluster_open = false;
+	m_frame_count = 0;
+	m_pts_base = 0;
+	m_video_end = 0;
+	m_audio_end = 0;
+	m_vps.clear();
+	m_sps.clear();
+	m_pps.clear();
+	m_cues.clear();
+	m_au.clear();
+	return true;
+}
+
+bool CMkvWriter::AddPcmTrack(FILE *wav)
+{
+	if (m_fp == NULL || m_header_written || !m_audio.OpenWav(wav))
+		return false;
+
+	m_pcm_frames = m_audio.sample_rate * MKV_PCM_BLOCK_MSEC / 1000;
+	if (m_pcm_frames == 0)
+		m_pcm_frames = 1;
+	return true;
+}
+
+bool CMkvWriter::AddAacTrack(FILE *m4a)
+{
+	if (m_fp == NULL || m_header_written || !m_audio.OpenM4a(m4a))
+		return false;
+
+	return true;
+}
+
+bool CMkvWriter::_write(const void *data, const size_t size)
+{
+	if (m_io_error)
+		return false;
+
+	if (size && fwrite(data, 1, size, m_fp) != size) {
+		m_io_error = true;
+		return false;
+	}
+	m_pos += size;
+	return true;
+}
+
+// _patch() - overwrite already written bytes, then continue at the end of the file
+bool CMkvWriter::_patch(const uint64_t offset, const void *data, const size_t size)
+{
+	if (m_io_error)
+		return false;
+
+	if (mux_fseek64(m_fp, offset, SEEK_SET) != 0
+		|| fwrite(data, 1, size, m_fp) != size
+		|| mux_fseek64(m_fp, m_pos, SEEK_SET) != 0)
+	{
+		m_io_error = true;
+		return false;
+	}
+	return true;
+}
+
+void CMkvWriter::_add_parameter_set(std::vector<bytes_t> &list, const uint8_t nal[], const size_t size)
+{
+	for (size_t i = 0; i < list.size(); ++i)
+		if (list[i].size() == size && memcmp(&list[i][0], nal, size) == 0)
+			return; // already have it
+
+	list.push_back(bytes_t(nal, nal + size));
+}
+
+// _frame_time() - presentation time of 'frames' video-frames (msec)
+uint64_t CMkvWriter::_frame_time(const int64_t frames) const
+{
+	return (static_cast<uint64_t>(frames) * 1000 * m_rate_den + m_rate_num / 2) / m_rate_num;
+}
+
+// _write_header() - EBML header, Segment (size patched by Close), SeekHead placeholder, Info, Tracks
+bool CMkvWriter::_write_header(const bool with_video)
+{
+	bytes_t b, payload;
+
+	ebml_uint(payload, EBML_ID_VERSION, 1);
+	ebml_uint(payload, EBML_ID_READ_VERSION, 1);
+	ebml_uint(payload, EBML_ID_MAX_ID_LENGTH, 4);
+	ebml_uint(payload, EBML_ID_MAX_SIZE_LENGTH, 8);
+	ebml_string(payload, EBML_ID_DOCTYPE, "matroska");
+	ebml_uint(payload, EBML_ID_DOCTYPE_VERSION, 4);
+	ebml_uint(payload, EBML_ID_DOCTYPE_READ, 2);
+	ebml_master(b, EBML_ID_HEADER, payload);
+
+	ebml_id(b, MKV_ID_SEGMENT);
+	ebml_size8(b, 0);
+	m_segment_data = m_pos + b.size();
+
+	m_seekhead_pos = m_pos + b.size();
+	ebml_void(b, MKV_SEEKHEAD_RESERVED);
+
+	// Info (the Duration is the first child, so its offset is known)
+	payload.clear();
+	ebml_float(payload, MKV_ID_DURATION, 0.0);
+	ebml_uint(payload, MKV_ID_TIMESTAMP_SCALE, MKV_TIMESTAMP_SCALE);
+	ebml_string(payload, MKV_ID_MUXING_APP, MKV_MUXING_APP);
+	ebml_string(payload, MKV_ID_WRITING_APP, MKV_MUXING_APP);
+	m_info_pos = m_pos + b.size();
+	ebml_master(b, MKV_ID_INFO, payload);
+	m_duration_pos = m_pos + b.size() - payload.size() + 3; // (after the 2-byte ID, 1-byte size)
+
+	payload.clear();
+	_build_tracks(payload, with_video);
+	m_tracks_pos = m_pos + b.size();
+	ebml_master(b, MKV_ID_TRACKS, payload);
+
+	m_header_written = true;
+	return _write(&b[0], b.size());
+}
+
+void CMkvWriter::_build_tracks(bytes_t &b, const bool with_video) const
+{
+	bytes_t entry, sub;
+
+	// video (omitted if not a single access-unit was written)
+	if (with_video) {
+		const bool is_hevc = (m_codec == MKV_VIDEO_HEVC);
+
+		ebml_uint(entry, MKV_ID_TRACK_NUMBER, MKV_TRACK_VIDEO);
+		ebml_uint(entry, MKV_ID_TRACK_UID, MKV_TRACK_VIDEO);
+		ebml_uint(entry, MKV_ID_TRACK_TYPE, 1);
+		ebml_uint(entry, MKV_ID_FLAG_LACING, 0);
+		ebml_string(entry, MKV_ID_LANGUAGE, "und");
+		ebml_string(entry, MKV_ID_CODEC_ID, is_hevc ? "V_MPEGH/ISO/HEVC" : "V_MPEG4/ISO/AVC");
+
+		const bool ok = is_hevc ?
+			nal_build_hevc_config(sub, m_vps, m_sps, m_pps) :
+			nal_build_avc_config(sub, m_sps, m_pps);
+		if (ok)
+			ebml_binary(entry, MKV_ID_CODEC_PRIVATE, &sub[0], sub.size());
+
+		ebml_uint(entry, MKV_ID_DEFAULT_DURATION,
+			static_cast<uint64_t>(m_rate_den) * 1000000000ULL / m_rate_num);
+
+		sub.clear();
+		ebml_uint(sub, MKV_ID_PIXEL_WIDTH, m_width);
+		ebml_uint(sub, MKV_ID_PIXEL_HEIGHT, m_height);
+		ebml_master(entry, MKV_ID_VIDEO, sub);
+
+		ebml_master(b, MKV_ID_TRACK_ENTRY, entry);
+	}
+
+	// audio
+	if (m_audio.codec != AUDIO_SOURCE_NONE) {
+		const bool is_aac = (m_audio.codec == AUDIO_SOURCE_AAC);
+
+		entry.clear();
+		ebml_uint(entry, MKV_ID_TRACK_NUMBER, MKV_TRACK_AUDIO);
+		ebml_uint(entry, MKV_ID_TRACK_UID, MKV_TRACK_AUDIO);
+		ebml_uint(entry, MKV_ID_TRACK_TYPE, 2);
+		ebml_uint(entry, MKV_ID_FLAG_LACING, 0);
+		ebml_string(entry, MKV_ID_LANGUAGE, "und");
+		ebml_string(entry, MKV_ID_CODEC_ID, is_aac ? "A_AAC" : "A_PCM/INT/LIT");
+		if (is_aac && !m_audio.asc.empty())
+			ebml_binary(entry, MKV_ID_CODEC_PRIVATE, &m_audio.asc[0], m_audio.asc.size());
+
+		sub.clear();
+		ebml_float(sub, MKV_ID_SAMPLING_FREQ, static_cast<double>(m_audio.sample_rate));
+		ebml_uint(sub, MKV_ID_CHANNELS, m_audio.channels);
+		if (!is_aac)
+			ebml_uint(sub, MKV_ID_BIT_DEPTH, m_audio.bits_per_sample);
+		ebml_master(entry, MKV_ID_AUDIO, sub);
+
+		ebml_master(b, MKV_ID_TRACK_ENTRY, entry);
+	}
+}
+
+bool CMkvWriter::_start_cluster(const uint64_t time)
+{
+	if (m_cluster_open && !_end_cluster())
+		return false;
+
+	bytes_t b;
+	ebml_id(b, MKV_ID_CLUSTER);
+	ebml_size8(b, 0);
+	ebml_uint(b, MKV_ID_TIMESTAMP, time);
+
+	m_cluster_pos = m_pos;
+	m_cluster_time = time;
+	m_cluster_open = true;
+	return _write(&b[0], b.size());
+}
+
+// _end_cluster() - patch the size of the current cluster
+bool CMkvWriter::_end_cluster()
+{
+	m_cluster_open = false;
+
+	bytes_t b;
+	ebml_size8(b, m_pos - (m_cluster_pos + 4 + 8));
+	return _patch(m_cluster_pos + 4, &b[0], b.size());
+}
+
+bool CMkvWriter::_write_block(const uint8_t track, const uint64_t time, const bool keyframe,
+	const uint8_t data[], const size_t size)
+{
+	const int64_t offset = static_cast<int64_t>(time) - static_cast<int64_t>(m_cluster_time);
+
+	bytes_t b;
+	ebml_id(b, MKV_ID_SIMPLEBLOCK);
+	ebml_size(b, size + 4);
+	b.push_back(static_cast<uint8_t>(0x80 | track)); // track-number (1-byte vint)
+	put_be(b, static_cast<uint16_t>(offset), 2);
+	b.push_back(keyframe ? 0x80 : 0x00);
+
+	return _write(&b[0], b.size()) && _write(data, size);
+}
+
+// _write_audio_until() - write the audio-frames which start before 'time' (msec)
+bool CMkvWriter::_write_audio_until(const uint64_t time)
+{
+	while (!m_audio.Eof() && !m_io_error) {
+		const uint64_t next = m_audio.NextTime() * 1000 / m_audio.timescale;
+		if (next >= time)
+			break;
+
+		uint64_t t;
+		if (!m_audio.ReadFrame(m_frame, &t, m_pcm_frames))
+			break;
+		t = t * 1000 / m_audio.timescale;
+
+		// Audio-only: a cluster (and a cue-point) every MKV_CLUSTER_MAX_MSEC.
+		// With video, the clusters follow the video; a new one is only needed
+		// if the block-timestamp would overflow.
+		if (m_codec == MKV_VIDEO_NONE || m_frame_count == 0) {
+			if (!m_cluster_open || t >= m_cluster_time + MKV_CLUSTER_MAX_MSEC) {
+				if (!_start_cluster(t))
+					return false;
+				mkv_cue_t cue = { t, m_cluster_pos - m_segment_data, MKV_TRACK_AUDIO };
+				m_cues.push_back(cue);
+			}
+		}
+		else if (!m_cluster_open || t > m_cluster_time + MKV_BLOCK_MAX_OFFSET) {
+			if (!_start_cluster(t))
+				return false;
+		}
+
+		if (!_write_block(MKV_TRACK_AUDIO, t, true, &m_frame[0], m_frame.size()))
+			return false;
+
+		const uint64_t frame_end = m_audio.Eof() ?
+			(m_audio.duration * 1000 / m_audio.timescale) :
+			(m_audio.NextTime() * 1000 / m_audio.timescale);
+		if (frame_end > m_audio_end)
+			m_audio_end = frame_end;
+	}
+	return !m_io_error;
+}
+
+size_t CMkvWriter::WriteBitstream(const uint8_t data[], const size_t size, const int64_t pts)
+{
+	if (m_fp == NULL || m_io_error || m_codec == MKV_VIDEO_NONE)
+		return 0;
+
+	const bool is_hevc = (m_codec == MKV_VIDEO_HEVC);
+	const bool first_sample = (m_frame_count == 0);
+	bool has_vcl = false;
+	bool is_sync = false;
+
+	const uint8_t *end = data + size;
+	const uint8_t *p = nal_find_start_code(data, end);
+	while (p < end) {
+		const uint8_t *nal = p + 3;
+		p = nal_find_start_code(nal, end);
+
+		// strip trailing_zero_8bits (and the leading zero of a 4-byte start-code)
+		const uint8_t *nal_end = p;
+		while (nal_end > nal && nal_end[-1] == 0)
+			--nal_end;
+		const size_t nal_size = nal_end - nal;
+		if (nal_size == 0)
+			continue;
+
+		std::vector<bytes_t> *ps_list = NULL; // parameter-set list for this NAL
+		if (is_hevc) {
+			const unsigned type = (nal[0] >> 1) & 0x3F;
+			if (type == 35)
+				continue; // drop access-unit-delimiter
+			if (type == 32) ps_list = &m_vps;
+			else if (type == 33) ps_list = &m_sps;
+			else if (type == 34) ps_list = &m_pps;
+			else if (type < 32) {
+				has_vcl = true;
+				if (nal_is_random_access(true, type))
+					is_sync = true;
+			}
+		}
+		else {
+			const unsigned type = nal[0] & 0x1F;
+			if (type == 9)
+				continue; // drop access-unit-delimiter
+			if (type == 7) ps_list = &m_sps;
+			else if (type == 8) ps_list = &m_pps;
+			else if (type >= 1 && type <= 5) {
+				has_vcl = true;
+				if (nal_is_random_access(false, type))
+					is_sync = true;
+			}
+		}
+
+		if (ps_list) {
+			// Parameter-sets before the first sample go into the CodecPrivate.
+			// Later ones are kept in-band, unless they are an exact copy.
+			if (first_sample && !has_vcl) {
+				_add_parameter_set(*ps_list, nal, nal_size);
+				continue;
+			}
+
+			bool known = false;
+			for (size_t i = 0; !known && i < ps_list->size(); ++i)
+				known = ((*ps_list)[i].size() == nal_size) && memcmp(&(*ps_list)[i][0], nal, nal_size) == 0;
+			if (known)
+				continue;
+		}
+
+		// append as length-prefixed NAL (4-byte, as declared in the avcC/hvcC)
+		put_be(m_au, nal_size, 4);
+		m_au.insert(m_au.end(), nal, nal_end);
+	}
+
+	// A write without any slice-data (i.e. the SPS/PPS header written at encoder
+	// init) doesn't produce a block.  Any non-VCL NALs stay queued in m_au and are
+	// prepended to the next access-unit.
+	if (!has_vcl)
+		return size;
+
+	if (first_sample) {
+		m_pts_base = (pts >= 0) ? pts : 0;
+		if (!_write_header(true))
+			return 0;
+	}
+
+	const int64_t frames = ((pts >= 0) ? pts : m_frame_count) - m_pts_base;
+	const uint64_t time = _frame_time(frames > 0 ? frames : 0);
+
+	// A new cluster at every sync-sample (or when the cluster gets too long);
+	// the audio that belongs before it is written into the previous cluster.
+	const bool long_cluster = m_cluster_open && time >= m_cluster_time + MKV_CLUSTER_MAX_MSEC;
+	if (!m_cluster_open || is_sync || long_cluster) {
+		if (!_write_audio_until(time) || !_start_cluster(time))
+			return 0;
+		if (is_sync) {
+			mkv_cue_t cue = { time, m_cluster_pos - m_segment_data, MKV_TRACK_VIDEO };
+			m_cues.push_back(cue);
+		}
+	}
+	else if (!_write_audio_until(m_video_end))
+		return 0;
+
+	if (!_write_block(MKV_TRACK_VIDEO, time, is_sync, &m_au[0], m_au.size()))
+		return 0;
+	m_au.clear();
+
+	const uint64_t frame_end = _frame_time((frames > 0 ? frames : 0) + 1);
+	if (frame_end > m_video_end)
+		m_video_end = frame_end;
+
+	++m_frame_count;
+	return size;
+}
+
+bool CMkvWriter::Close()
+{
+	if (m_fp == NULL)
+		return false;
+
+	if (!m_header_written)
+		_write_header(false); // audio-only (or empty) file
+
+	// The remaining audio (the video has ended, or there is no video)
+	_write_audio_until(UINT64_MAX);
+	if (m_cluster_open)
+		_end_cluster();
+
+	// Cues
+	const uint64_t cues_pos = m_pos;
+	if (!m_cues.empty()) {
+		bytes_t b, payload, point, pos;
+		for (size_t i = 0; i < m_cues.size(); ++i) {
+			point.clear();
+			pos.clear();
+			ebml_uint(point, MKV_ID_CUE_TIME, m_cues[i].time);
+			ebml_uint(pos, MKV_ID_CUE_TRACK, m_cues[i].track);
+			ebml_uint(pos, MKV_ID_CUE_CLUSTER_POS, m_cues[i].cluster_position);
+			ebml_master(point, MKV_ID_CUE_TRACK_POS, pos);
+			ebml_master(payload, MKV_ID_CUE_POINT, point);
+		}
+		ebml_master(b, MKV_ID_CUES, payload);
+		_write(&b[0], b.size());
+	}
+
+	// SeekHead (into the reserved Void, the rest stays Void)
+	{
+		const struct { uint32_t id; uint64_t pos; } entries[] = {
+			{ MKV_ID_INFO,   m_info_pos },
+			{ MKV_ID_TRACKS, m_tracks_pos },
+			{ MKV_ID_CUES,   cues_pos }
+		};
+		const size_t num_entries = m_cues.empty() ? 2 : 3;
+
+		bytes_t b, payload, seek, id;
+		for (size_t i = 0; i < num_entries; ++i) {
+			seek.clear();
+			id.clear();
+			ebml_id(id, entries[i].id);
+			ebml_binary(seek, MKV_ID_SEEK_ID, &id[0], id.size());
+			ebml_uint(seek, MKV_ID_SEEK_POSITION, entries[i].pos - m_segment_data);
+			ebml_master(payload, MKV_ID_SEEK, seek);
+		}
+		ebml_master(b, MKV_ID_SEEKHEAD, payload);
+		ebml_void(b, MKV_SEEKHEAD_RESERVED - b.size());
+		_patch(m_seekhead_pos, &b[0], b.size());
+	}
+
+	// Duration (msec), Segment-size
+	{
+		const uint64_t duration = (m_video_end > m_audio_end) ? m_video_end : m_audio_end;
+		const double d = static_cast<double>(duration);
+		uint64_t bits;
+		memcpy(&bits, &d, sizeof(bits));
+
+		bytes_t b;
+		put_be(b, bits, 8);
+		_patch(m_duration_pos, &b[0], b.size());
+
+		b.clear();
+		ebml_size8(b, m_pos - m_segment_data);
+		_patch(m_segment_data - 8, &b[0], b.size());
+	}
+
+	const bool ok = !m_io_error && fflush(m_fp) == 0;
+	m_fp = NULL;
+	return ok;
+}
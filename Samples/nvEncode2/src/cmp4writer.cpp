@@ -0,0 +1,986 @@
+#include <cstring>   // memcpy(), memcmp()
+
+#include "cmp4writer.h"
+#include "caudiosource.h"
+#include "cnalutil.h"
+
+#define MP4_MOVIE_TIMESCALE      1000   // mvhd/tkhd time-units (milliseconds)
+#define MP4_COPY_BLOCK_SIZE      (1 << 20)
+
+#define MP4_SAMPLE_FLAGS_SYNC    0x02000000 // sample_depends_on=2 (I-frame)
+#define MP4_SAMPLE_FLAGS_NONSYNC 0x01010000 // sample_depends_on=1, sample_is_non_sync_sample=1
+
+// 'chan' (QuickTime AudioChannelLayout) layout-tags
+#define MP4_CHAN_USE_BITMAP      (1u << 16)   // mChannelBitmap = the WAVE speaker-mask (same bit order)
+#define MP4_CHAN_DISCRETE        (147u << 16) // DiscreteInOrder | #channels (no speaker-positions)
+
+////////////////////
+//
+// box-building helpers
+//
+//   All boxes are assembled in a memory buffer, and the box-size is
+//   patched in after the box-contents are complete.
+//
+
+static void put8(std::vector<uint8_t> &b, const uint32_t v)
+{
+	b.push_back(static_cast<uint8_t>(v));
+}
+
+static void put16(std::vector<uint8_t> &b, const uint32_t v)
+{
+	put8(b, v >> 8);
+	put8(b, v);
+}
+
+static void put24(std::vector<uint8_t> &b, const uint32_t v)
+{
+	put8(b, v >> 16);
+	put16(b, v);
+}
+
+static void put32(std::vector<uint8_t> &b, const uint32_t v)
+{
+	put16(b, v >> 16);
+	put16(b, v);
+}
+
+static void put64(std::vector<uint8_t> &b, const uint64_t v)
+{
+	put32(b, static_cast<uint32_t>(v >> 32));
+	put32(b, static_cast<uint32_t>(v));
+}
+
+static void put_fourcc(std::vector<uint8_t> &b, const char fourcc[])
+{
+	b.insert(b.end(), fourcc, fourcc + 4);
+}
+
+static void put_bytes(std::vector<uint8_t> &b, const uint8_t data[], const size_t size)
+{
+	b.insert(b.end(), data, data + size);
+}
+
+static size_t box_begin(std::vector<uint8_t> &b, const char fourcc[])
+{
+	const size_t offset = b.size();
+	put32(b, 0); // size (patched by box_end)
+	put_fourcc(b, fourcc);
+	return offset;
+}
+
+static size_t fullbox_begin(std::vector<uint8_t> &b, const char fourcc[], const uint32_t version, const uint32_t flags)
+{
+	const size_t offset = box_begin(b, fourcc);
+	put8(b, version);
+	put24(b, flags);
+	return offset;
+}
+
+static void box_end(std::vector<uint8_t> &b, const size_t offset)
+{
+	const uint32_t size = static_cast<uint32_t>(b.size() - offset);
+	b[offset + 0] = static_cast<uint8_t>(size >> 24);
+	b[offset + 1] = static_cast<uint8_t>(size >> 16);
+	b[offset + 2] = static_cast<uint8_t>(size >> 8);
+	b[offset + 3] = static_cast<uint8_t>(size);
+}
+
+static void put_matrix(std::vector<uint8_t> &b) // unity transformation matrix
+{
+	static const uint32_t m[9] = { 0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000 };
+	for (unsigned i = 0; i < 9; ++i)
+		put32(b, m[i]);
+}
+
+////////////////////
+//
+// CMp4Writer
+//
+
+CMp4Writer::CMp4Writer() :
+	m_fp(NULL), m_codec(MP4_VIDEO_AVC), m_width(0), m_height(0), m_fragmented(false),
+	m_io_error(false), m_pos(0), m_mdat_start(0), m_header_written(false), m_chunk_max(1),
+	m_pts_base(0), m_pts_delay(0), m_inband_ps(false), m_frag_seq(0), m_frag_count(0)
+{
+}
+
+CMp4Writer::~CMp4Writer()
+{
+	// the FILE handle belongs to the caller; if Close() was never called
+	// the file is simply left incomplete.
+}
+
+bool CMp4Writer::Open(
+	FILE                   *fp,
+	const mp4_video_codec_t codec,
+	const uint32_t          width,
+	const uint32_t          height,
+	const uint32_t          frameRateNum,
+	const uint32_t          frameRateDen,
+	const bool              fragmented)
+{
+	if (fp == NULL || frameRateNum == 0 || frameRateDen == 0)
+		return false;
+
+	m_fp = fp;
+	m_codec = codec;
+	m_width = width;
+	m_height = height;
+	m_fragmented = fragmented;
+	m_io_error = false;
+	m_header_written = false;
+	m_pts_base = 0;
+	m_pts_delay = 0;
+	m_inband_ps = false;
+	m_frag_seq = 0;
+	m_frag_count = 0;
+
+	const int64_t pos = mux_ftell64(fp);
+	m_pos = (pos > 0) ? static_cast<uint64_t>(pos) : 0;
+	m_mdat_start = m_pos;
+
+	m_video = mp4_track_t();
+	m_video.track_ID = 1;
+	m_video.timescale = frameRateNum;
+	m_video.sample_delta = frameRateDen;
+	m_audio.clear();
+	m_vps.clear();
+	m_sps.clear();
+	m_pps.clear();
+	m_au.clear();
+	m_frag_data.clear();
+
+	// chunk = about 1 second of video
+	m_chunk_max = (frameRateNum + frameRateDen - 1) / frameRateDen;
+	if (m_chunk_max < 1)
+		m_chunk_max = 1;
+
+	return true;
+}
+
+bool CMp4Writer::_write(const void *data, const size_t size)
+{
+	if (m_io_error)
+		return false;
+
+	if (size && fwrite(data, 1, size, m_fp) != size) {
+		m_io_error = true;
+		return false;
+	}
+	m_pos += size;
+	return true;
+}
+
+void CMp4Writer::_add_parameter_set(std::vector<bytes_t> &list, const uint8_t nal[], const size_t size)
+{
+	for (size_t i = 0; i < list.size(); ++i)
+		if (list[i].size() == size && memcmp(&list[i][0], nal, size) == 0)
+			return; // already have it
+
+	list.push_back(bytes_t(nal, nal + size));
+}
+
+size_t CMp4Writer::WriteBitstream(const uint8_t data[], const size_t size, const int64_t pts)
+{
+	if (m_fp == NULL || m_io_error)
+		return 0;
+
+	const bool is_hevc = (m_codec == MP4_VIDEO_HEVC);
+	const bool first_sample = (GetNumVideoSamples() == 0);
+	bool has_vcl = false;
+	bool is_sync = false;
+
+	const uint8_t *end = data + size;
+	const uint8_t *p = nal_find_start_code(data, end);
+	while (p < end) {
+		const uint8_t *nal = p + 3;
+		p = nal_find_start_code(nal, end);
+
+		// strip trailing_zero_8bits (and the leading zero of a 4-byte start-code)
+		const uint8_t *nal_end = p;
+		while (nal_end > nal && nal_end[-1] == 0)
+			--nal_end;
+		const size_t nal_size = nal_end - nal;
+		if (nal_size == 0)
+			continue;
+
+		std::vector<bytes_t> *ps_list = NULL; // parameter-set list for this NAL
+		if (is_hevc) {
+			const unsigned type = (nal[0] >> 1) & 0x3F;
+			if (type == 35)
+				continue; // drop access-unit-delimiter
+			if (type == 32) ps_list = &m_vps;
+			else if (type == 33) ps_list = &m_sps;
+			else if (type == 34) ps_list = &m_pps;
+			else if (type < 32) {
+				has_vcl = true;
+				if (nal_is_random_access(true, type))
+					is_sync = true;
+			}
+		}
+		else {
+			const unsigned type = nal[0] & 0x1F;
+			if (type == 9)
+				continue; // drop access-unit-delimiter
+			if (type == 7) ps_list = &m_sps;
+			else if (type == 8) ps_list = &m_pps;
+			else if (type >= 1 && type <= 5) {
+				has_vcl = true;
+				if (nal_is_random_access(false, type))
+					is_sync = true;
+			}
+		}
+
+		if (ps_list) {
+			// Parameter-sets before the first sample go into the sample-description.
+			// Later ones (i.e. dynamic resolution change) are kept in-band, unless
+			// they are an exact copy of the ones already in the sample-description.
+			if (first_sample && !has_vcl) {
+				_add_parameter_set(*ps_list, nal, nal_size);
+				continue;
+			}
+
+			bool known = false;
+			for (size_t i = 0; !known && i < ps_list->size(); ++i)
+				known = ((*ps_list)[i].size() == nal_size) && memcmp(&(*ps_list)[i][0], nal, nal_size) == 0;
+			if (known)
+				continue;
+			m_inband_ps = true;
+		}
+
+		// append as length-prefixed NAL (lengthSizeMinusOne = 3)
+		put32(m_au, static_cast<uint32_t>(nal_size));
+		put_bytes(m_au, nal, nal_size);
+	}
+
+	// A write without any slice-data (i.e. the SPS/PPS header written at encoder
+	// init) doesn't produce a sample.  Any non-VCL NALs stay queued in m_au and are
+	// prepended to the next sample.
+	if (!has_vcl)
+		return size;
+
+	if (!_write_sample(is_sync, pts))
+		return 0;
+
+	return size;
+}
+
+bool CMp4Writer::_write_header()
+{
+	bytes_t b;
+	_build_ftyp(b);
+
+	if (m_fragmented) {
+		// init-segment: ftyp + moov (with empty sample-tables and 'mvex')
+		_build_moov(b);
+		m_header_written = true;
+		return _write(&b[0], b.size());
+	}
+
+	// regular MP4: ftyp + mdat-header. The mdat-size is fixed up by Close().
+	m_mdat_start = m_pos + b.size();
+	put32(b, 1); // size==1 : 64-bit largesize follows
+	put_fourcc(b, "mdat");
+	put64(b, 0);
+	m_header_written = true;
+	return _write(&b[0], b.size());
+}
+
+bool CMp4Writer::_write_sample(const bool is_sync, const int64_t pts)
+{
+	const uint32_t decode_idx = GetNumVideoSamples();
+	const int64_t  sample_pts = (pts >= 0) ? pts : decode_idx;
+
+	if (decode_idx == 0)
+		m_pts_base = sample_pts;
+
+	if (m_fragmented) {
+		// a new fragment starts at every sync-sample
+		if (is_sync && !m_video.sample_size.empty() && !_flush_fragment())
+			return false;
+
+		m_frag_data.insert(m_frag_data.end(), m_au.begin(), m_au.end());
+	}
+	else {
+		if (!m_header_written && !_write_header())
+			return false;
+
+		if (m_video.chunk_samples.empty() || m_video.chunk_samples.back() >= m_chunk_max) {
+			m_video.chunk_offset.push_back(m_pos);
+			m_video.chunk_samples.push_back(0);
+		}
+		++m_video.chunk_samples.back();
+
+		if (!_write(&m_au[0], m_au.size()))
+			return false;
+	}
+
+	if (is_sync)
+		m_video.sync_sample.push_back(static_cast<uint32_t>(m_video.sample_size.size() + 1));
+	m_video.sample_size.push_back(static_cast<uint32_t>(m_au.size()));
+	m_video.pts.push_back(sample_pts);
+	m_au.clear();
+	return true;
+}
+
+int64_t CMp4Writer::_composition_offset(const uint32_t decode_idx, const int64_t pts) const
+{
+	// (in frames) presentation-time - decode-time, shifted by the B-frame delay
+	// so that the first presented frame has composition-time 'delay'
+	return (pts - m_pts_base) - static_cast<int64_t>(decode_idx) + m_pts_delay;
+}
+
+bool CMp4Writer::_flush_fragment()
+{
+	const uint32_t count = static_cast<uint32_t>(m_video.sample_size.size());
+	if (count == 0)
+		return true;
+
+	if (!m_header_written) {
+		// The first fragment determines the B-frame delay (signalled in the init-segment's edit-list)
+		int64_t delay = 0;
+		for (uint32_t i = 0; i < count; ++i) {
+			const int64_t d = static_cast<int64_t>(i) - (m_video.pts[i] - m_pts_base);
+			if (d > delay)
+				delay = d;
+		}
+		m_pts_delay = static_cast<uint32_t>(delay);
+
+		if (!_write_header())
+			return false;
+	}
+
+	const bool large_mdat = (m_frag_data.size() + 8) > 0xFFFFFFFFull;
+	const uint32_t delta = m_video.sample_delta;
+
+	bytes_t b;
+	const size_t moof = box_begin(b, "moof");
+	{
+		const size_t mfhd = fullbox_begin(b, "mfhd", 0, 0);
+		put32(b, ++m_frag_seq);
+		box_end(b, mfhd);
+
+		const size_t traf = box_begin(b, "traf");
+		const size_t tfhd = fullbox_begin(b, "tfhd", 0, 0x020000); // default-base-is-moof
+		put32(b, m_video.track_ID);
+		box_end(b, tfhd);
+
+		const size_t tfdt = fullbox_begin(b, "tfdt", 1, 0);
+		put64(b, static_cast<uint64_t>(m_frag_count) * delta); // baseMediaDecodeTime
+		box_end(b, tfdt);
+
+		// data-offset | sample-duration | sample-size | sample-flags | sample-composition-time-offset
+		const size_t trun = fullbox_begin(b, "trun", 1, 0x000F01);
+		put32(b, count);
+		const size_t data_offset_pos = b.size();
+		put32(b, 0); // data_offset (patched below)
+		size_t sync_idx = 0;
+		for (uint32_t i = 0; i < count; ++i) {
+			const bool sync = (sync_idx < m_video.sync_sample.size()) && (m_video.sync_sample[sync_idx] == i + 1);
+			if (sync)
+				++sync_idx;
+			put32(b, delta);
+			put32(b, m_video.sample_size[i]);
+			put32(b, sync ? MP4_SAMPLE_FLAGS_SYNC : MP4_SAMPLE_FLAGS_NONSYNC);
+			put32(b, static_cast<uint32_t>(_composition_offset(m_frag_count + i, m_video.pts[i]) * delta));
+		}
+		box_end(b, trun);
+		box_end(b, traf);
+		box_end(b, moof);
+
+		// data_offset is relative to the start of the moof: skip moof + mdat-header
+		const uint32_t data_offset = static_cast<uint32_t>(b.size() - moof) + (large_mdat ? 16 : 8);
+		b[data_offset_pos + 0] = static_cast<uint8_t>(data_offset >> 24);
+		b[data_offset_pos + 1] = static_cast<uint8_t>(data_offset >> 16);
+		b[data_offset_pos + 2] = static_cast<uint8_t>(data_offset >> 8);
+		b[data_offset_pos + 3] = static_cast<uint8_t>(data_offset);
+	}
+
+	if (large_mdat) {
+		put32(b, 1);
+		put_fourcc(b, "mdat");
+		put64(b, m_frag_data.size() + 16);
+	}
+	else {
+		put32(b, static_cast<uint32_t>(m_frag_data.size() + 8));
+		put_fourcc(b, "mdat");
+	}
+
+	if (!_write(&b[0], b.size()) || !_write(m_frag_data.empty() ? NULL : &m_frag_data[0], m_frag_data.size()))
+		return false;
+
+	m_frag_count += count;
+	m_frag_data.clear();
+	m_video.sample_size.clear();
+	m_video.sync_sample.clear();
+	m_video.pts.clear();
+
+	fflush(m_fp); // let the fragment reach the disk (and any reader of the growing file)
+	return true;
+}
+
+bool CMp4Writer::_copy_file_range(FILE *src, const uint64_t offset, const uint64_t size)
+{
+	if (mux_fseek64(src, offset, SEEK_SET) != 0)
+		return false;
+
+	std::vector<uint8_t> buffer(static_cast<size_t>(size < MP4_COPY_BLOCK_SIZE ? size : MP4_COPY_BLOCK_SIZE));
+	uint64_t remaining = size;
+	while (remaining) {
+		const size_t n = static_cast<size_t>(remaining < buffer.size() ? remaining : buffer.size());
+		if (fread(&buffer[0], 1, n, src) != n)
+			return false;
+		if (!_write(&buffer[0], n))
+			return false;
+		remaining -= n;
+	}
+	return true;
+}
+
+bool CMp4Writer::AddPcmTrack(FILE *wav)
+{
+	if (m_fp == NULL || m_fragmented || wav == NULL)
+		return false;
+
+	if (!m_header_written && !_write_header())
+		return false;
+
+	// Parse the RIFF/WAVE header
+	CAudioSource src;
+	if (!src.OpenWav(wav))
+		return false;
+
+	const uint32_t sample_rate = src.sample_rate;
+	const uint16_t channels    = src.channels;
+	const uint16_t bits        = src.bits_per_sample;
+	const uint16_t block_align = src.block_align;
+
+	mp4_track_t t = mp4_track_t();
+	t.track_ID = static_cast<uint32_t>(m_audio.size()) + 2;
+	t.timescale = sample_rate;
+	t.const_sample_size = block_align; // 1 sample == 1 PCM-frame (all channels)
+	t.const_sample_count = static_cast<uint32_t>(src.duration);
+	t.duration = t.const_sample_count;
+
+	// sample-description: 'sowt' (little-endian 16-bit PCM)
+	//   The version-0 sound description stores the sample-rate as 16.16 fixed-point, and is only
+	//   defined for mono/stereo: rates above 65535Hz (i.e. 96kHz) and more than 2 channels (5.1)
+	//   need a version-2 'lpcm' description, which names the speakers in a 'chan' box.
+	const size_t stsd = fullbox_begin(t.stsd, "stsd", 0, 0);
+	put32(t.stsd, 1);
+	if (sample_rate <= 0xFFFF && channels <= 2) {
+		const size_t entry = box_begin(t.stsd, "sowt");
+		put32(t.stsd, 0); put16(t.stsd, 0); // reserved
+		put16(t.stsd, 1);        // data_reference_index
+		put16(t.stsd, 0);        // version
+		put16(t.stsd, 0);        // revision
+		put32(t.stsd, 0);        // vendor
+		put16(t.stsd, channels);
+		put16(t.stsd, bits);
+		put16(t.stsd, 0);        // compression ID
+		put16(t.stsd, 0);        // packet size
+		put32(t.stsd, sample_rate << 16);
+		box_end(t.stsd, entry);
+	}
+	else {
+		const size_t entry = box_begin(t.stsd, "lpcm");
+		put32(t.stsd, 0); put16(t.stsd, 0); // reserved
+		put16(t.stsd, 1);        // data_reference_index
+		put16(t.stsd, 2);        // version
+		put16(t.stsd, 0);        // revision
+		put32(t.stsd, 0);        // vendor
+		put16(t.stsd, 3);        // always3
+		put16(t.stsd, 16);       // always16
+		put16(t.stsd, 0xFFFE);   // alwaysMinus2
+		put16(t.stsd, 0);        // always0
+		put32(t.stsd, 0x00010000);// always65536
+		put32(t.stsd, 72);       // sizeOfStructOnly
+		double rate = sample_rate;
+		uint64_t rate_bits;
+		memcpy(&rate_bits, &rate, sizeof(rate_bits));
+		put64(t.stsd, rate_bits);// audioSampleRate (float64)
+		put32(t.stsd, channels);
+		put32(t.stsd, 0x7F000000);
+		put32(t.stsd, bits);     // constBitsPerChannel
+		put32(t.stsd, 0x0C);     // formatSpecificFlags: signed-integer | packed (little-endian)
+		put32(t.stsd, block_align);// constBytesPerAudioPacket
+		put32(t.stsd, 1);        // constLPCMFramesPerAudioPacket
+		if (channels > 2) {
+			const size_t chan = fullbox_begin(t.stsd, "chan", 0, 0);
+			put32(t.stsd, src.channel_mask ? MP4_CHAN_USE_BITMAP : (MP4_CHAN_DISCRETE | channels)); // mChannelLayoutTag
+			put32(t.stsd, src.channel_mask); // mChannelBitmap
+			put32(t.stsd, 0);        // mNumberChannelDescriptions
+			box_end(t.stsd, chan);
+		}
+		box_end(t.stsd, entry);
+	}
+	box_end(t.stsd, stsd);
+
+	// copy the PCM data in 1-second chunks
+	for (uint32_t s = 0; s < t.const_sample_count; ) {
+		const uint32_t n = (t.const_sample_count - s < sample_rate) ? (t.const_sample_count - s) : sample_rate;
+		t.chunk_offset.push_back(m_pos);
+		t.chunk_samples.push_back(n);
+		if (!_copy_file_range(wav, src.data_offset + static_cast<uint64_t>(s) * block_align, static_cast<uint64_t>(n) * block_align))
+			return false;
+		s += n;
+	}
+
+	m_audio.push_back(t);
+	return true;
+}
+
+bool CMp4Writer::AddAacTrack(FILE *m4a)
+{
+	if (m_fp == NULL || m_fragmented || m4a == NULL)
+		return false;
+
+	if (!m_header_written && !_write_header())
+		return false;
+
+	// Read the sample-tables of the source file's sound-track
+	CAudioSource src;
+	if (!src.OpenM4a(m4a))
+		return false;
+
+	// The sample-description (mp4a + esds) and the sample-durations are copied unchanged
+	mp4_track_t t = mp4_track_t();
+	t.track_ID = static_cast<uint32_t>(m_audio.size()) + 2;
+	t.timescale = src.timescale;
+	t.duration = src.duration;
+	t.stsd = src.stsd;
+	t.stts = src.stts;
+	t.sample_size = src.sample_size;
+	t.chunk_samples = src.chunk_samples;
+
+	// Copy the audio-samples, one chunk at a time
+	uint32_t s = 0;
+	for (size_t c = 0; c < src.chunk_offset.size(); ++c) {
+		uint64_t chunk_bytes = 0;
+		for (uint32_t i = 0; i < t.chunk_samples[c] && s + i < t.sample_size.size(); ++i)
+			chunk_bytes += t.sample_size[s + i];
+		s += t.chunk_samples[c];
+
+		t.chunk_offset.push_back(m_pos);
+		if (!_copy_file_range(m4a, src.chunk_offset[c], chunk_bytes))
+			return false;
+	}
+
+	m_audio.push_back(t);
+	return true;
+}
+
+bool CMp4Writer::Close()
+{
+	if (m_fp == NULL)
+		return false;
+
+	bool ok = true;
+	if (m_fragmented) {
+		ok = _flush_fragment();
+	}
+	else {
+		if (!m_header_written)
+			ok = _write_header(); // (empty movie)
+
+		// B-frame delay: the largest amount any frame is decoded ahead of its presentation
+		int64_t delay = 0;
+		for (uint32_t i = 0; i < m_video.pts.size(); ++i) {
+			const int64_t d = static_cast<int64_t>(i) - (m_video.pts[i] - m_pts_base);
+			if (d > delay)
+				delay = d;
+		}
+		m_pts_delay = static_cast<uint32_t>(delay);
+
+		// fix up the mdat's 64-bit largesize
+		if (ok && !m_io_error) {
+			bytes_t b;
+			put64(b, m_pos - m_mdat_start);
+			const uint64_t end_pos = m_pos;
+			ok = mux_fseek64(m_fp, m_mdat_start + 8, SEEK_SET) == 0 &&
+				fwrite(&b[0], 1, b.size(), m_fp) == b.size() &&
+				mux_fseek64(m_fp, end_pos, SEEK_SET) == 0;
+		}
+
+		bytes_t moov;
+		_build_moov(moov);
+		ok = ok && _write(&moov[0], moov.size());
+	}
+
+	// the avcC/hvcC can't be built without the parameter-sets
+	if (GetNumVideoSamples() && (m_sps.empty() || m_pps.empty() || (m_codec == MP4_VIDEO_HEVC && m_vps.empty())))
+		ok = false;
+
+	fflush(m_fp);
+	ok = ok && !m_io_error;
+	m_fp = NULL;
+	return ok;
+}
+
+////////////////////
+//
+// box-builders
+//
+
+void CMp4Writer::_build_ftyp(bytes_t &b) const
+{
+	const size_t ftyp = box_begin(b, "ftyp");
+	put_fourcc(b, "isom");  // major_brand
+	put32(b, 0x200);        // minor_version
+	put_fourcc(b, "isom");
+	put_fourcc(b, "iso2");
+	if (m_fragmented)
+		put_fourcc(b, "iso6");
+	put_fourcc(b, (m_codec == MP4_VIDEO_HEVC) ? "hvc1" : "avc1");
+	put_fourcc(b, "mp41");
+	box_end(b, ftyp);
+}
+
+void CMp4Writer::_build_moov(bytes_t &b) const
+{
+	const bool has_video = GetNumVideoSamples() || !m_sps.empty();
+
+	// movie-duration (milliseconds) = longest track
+	uint64_t duration = 0;
+	if (!m_fragmented) {
+		if (has_video)
+			duration = static_cast<uint64_t>(m_video.sample_size.size()) * m_video.sample_delta * MP4_MOVIE_TIMESCALE / m_video.timescale;
+		for (size_t i = 0; i < m_audio.size(); ++i) {
+			const uint64_t d = m_audio[i].duration * MP4_MOVIE_TIMESCALE / m_audio[i].timescale;
+			if (d > duration)
+				duration = d;
+		}
+	}
+
+	const size_t moov = box_begin(b, "moov");
+
+	const size_t mvhd = fullbox_begin(b, "mvhd", 0, 0);
+	put32(b, 0);                   // creation_time
+	put32(b, 0);                   // modification_time
+	put32(b, MP4_MOVIE_TIMESCALE);
+	put32(b, static_cast<uint32_t>(duration));
+	put32(b, 0x00010000);          // rate 1.0
+	put16(b, 0x0100);              // volume 1.0
+	put16(b, 0); put64(b, 0);      // reserved
+	put_matrix(b);
+	for (unsigned i = 0; i < 6; ++i)
+		put32(b, 0);               // pre_defined
+	put32(b, static_cast<uint32_t>(m_audio.size()) + 2); // next_track_ID
+	box_end(b, mvhd);
+
+	if (has_video)
+		_build_video_trak(b);
+
+	for (size_t i = 0; i < m_audio.size(); ++i)
+		_build_audio_trak(b, m_audio[i]);
+
+	if (m_fragmented) {
+		const size_t mvex = box_begin(b, "mvex");
+		const size_t trex = fullbox_begin(b, "trex", 0, 0);
+		put32(b, m_video.track_ID);
+		put32(b, 1);                     // default_sample_description_index
+		put32(b, m_video.sample_delta);  // default_sample_duration
+		put32(b, 0);                     // default_sample_size
+		put32(b, MP4_SAMPLE_FLAGS_NONSYNC);// default_sample_flags
+		box_end(b, trex);
+		box_end(b, mvex);
+	}
+
+	box_end(b, moov);
+}
+
+// trak-header boxes shared by the video and audio tracks: tkhd, (edts), mdia/mdhd, hdlr
+static void
+put_track_header(std::vector<uint8_t> &b, const uint32_t track_ID, const bool is_video,
+	const uint64_t track_duration, const uint32_t width, const uint32_t height)
+{
+	const size_t tkhd = fullbox_begin(b, "tkhd", 0, 0x000003); // track_enabled | track_in_movie
+	put32(b, 0);                   // creation_time
+	put32(b, 0);                   // modification_time
+	put32(b, track_ID);
+	put32(b, 0);                   // reserved
+	put32(b, static_cast<uint32_t>(track_duration));
+	put64(b, 0);                   // reserved
+	put16(b, 0);                   // layer
+	put16(b, 0);                   // alternate_group
+	put16(b, is_video ? 0 : 0x0100);// volume
+	put16(b, 0);                   // reserved
+	put_matrix(b);
+	put32(b, width << 16);
+	put32(b, height << 16);
+	box_end(b, tkhd);
+}
+
+static void
+put_media_header(std::vector<uint8_t> &b, const uint32_t timescale, const uint64_t duration, const bool is_video)
+{
+	const bool v1 = duration > 0xFFFFFFFFull;
+	const size_t mdhd = fullbox_begin(b, "mdhd", v1 ? 1 : 0, 0);
+	if (v1) {
+		put64(b, 0);
+		put64(b, 0);
+		put32(b, timescale);
+		put64(b, duration);
+	}
+	else {
+		put32(b, 0);
+		put32(b, 0);
+		put32(b, timescale);
+		put32(b, static_cast<uint32_t>(duration));
+	}
+	put16(b, 0x55C4);              // language 'und'
+	put16(b, 0);
+	box_end(b, mdhd);
+
+	const size_t hdlr = fullbox_begin(b, "hdlr", 0, 0);
+	put32(b, 0);                   // pre_defined
+	put_fourcc(b, is_video ? "vide" : "soun");
+	put32(b, 0); put32(b, 0); put32(b, 0);
+	const char *name = is_video ? "VideoHandler" : "SoundHandler";
+	put_bytes(b, reinterpret_cast<const uint8_t *>(name), strlen(name) + 1);
+	box_end(b, hdlr);
+}
+
+static void
+put_dinf(std::vector<uint8_t> &b)
+{
+	const size_t dinf = box_begin(b, "dinf");
+	const size_t dref = fullbox_begin(b, "dref", 0, 0);
+	put32(b, 1);
+	const size_t url = fullbox_begin(b, "url ", 0, 1); // self-contained
+	box_end(b, url);
+	box_end(b, dref);
+	box_end(b, dinf);
+}
+
+void CMp4Writer::_build_video_trak(bytes_t &b) const
+{
+	const uint32_t count = static_cast<uint32_t>(m_video.sample_size.size());
+	const uint32_t delta = m_video.sample_delta;
+	const uint64_t media_duration = m_fragmented ? 0 : static_cast<uint64_t>(count) * delta;
+	const uint64_t track_duration = m_fragmented ? 0 : media_duration * MP4_MOVIE_TIMESCALE / m_video.timescale;
+
+	const size_t trak = box_begin(b, "trak");
+	put_track_header(b, m_video.track_ID, true, track_duration, m_width, m_height);
+
+	// With B-frames the first frame is presented 'delay' frames after it is decoded:
+	// the edit-list skips over that initial gap so presentation starts at time 0.
+	if (m_pts_delay) {
+		const size_t edts = box_begin(b, "edts");
+		const size_t elst = fullbox_begin(b, "elst", 0, 0);
+		put32(b, 1);
+		put32(b, static_cast<uint32_t>(track_duration)); // segment_duration
+		put32(b, m_pts_delay * delta);  // media_time
+		put32(b, 0x00010000);           // media_rate 1.0
+		box_end(b, elst);
+		box_end(b, edts);
+	}
+
+	const size_t mdia = box_begin(b, "mdia");
+	put_media_header(b, m_video.timescale, media_duration, true);
+
+	const size_t minf = box_begin(b, "minf");
+	const size_t vmhd = fullbox_begin(b, "vmhd", 0, 1);
+	put16(b, 0);                   // graphicsmode
+	put16(b, 0); put16(b, 0); put16(b, 0); // opcolor
+	box_end(b, vmhd);
+	put_dinf(b);
+
+	const size_t stbl = box_begin(b, "stbl");
+	_build_video_stsd(b);
+
+	if (m_fragmented) {
+		// the samples are described by the fragments: empty tables
+		const size_t stts = fullbox_begin(b, "stts", 0, 0); put32(b, 0); box_end(b, stts);
+		const size_t stsc = fullbox_begin(b, "stsc", 0, 0); put32(b, 0); box_end(b, stsc);
+		const size_t stsz = fullbox_begin(b, "stsz", 0, 0); put32(b, 0); put32(b, 0); box_end(b, stsz);
+		const size_t stco = fullbox_begin(b, "stco", 0, 0); put32(b, 0); box_end(b, stco);
+	}
+	else {
+		// sample-durations: constant frame-rate
+		const size_t stts = fullbox_begin(b, "stts", 0, 0);
+		put32(b, count ? 1 : 0);
+		if (count) {
+			put32(b, count);
+			put32(b, delta);
+		}
+		box_end(b, stts);
+
+		// composition-offsets (only needed if there are B-frames, or pts are not in decode-order)
+		bool need_ctts = false;
+		for (uint32_t i = 0; !need_ctts && i < count; ++i)
+			need_ctts = (_composition_offset(i, m_video.pts[i]) != 0);
+		if (need_ctts) {
+			bytes_t entries;
+			uint32_t entry_count = 0;
+			for (uint32_t i = 0; i < count; ) {
+				const int64_t offset = _composition_offset(i, m_video.pts[i]);
+				uint32_t run = 1;
+				while (i + run < count && _composition_offset(i + run, m_video.pts[i + run]) == offset)
+					++run;
+				put32(entries, run);
+				put32(entries, static_cast<uint32_t>(offset * delta));
+				++entry_count;
+				i += run;
+			}
+			const size_t ctts = fullbox_begin(b, "ctts", 0, 0);
+			put32(b, entry_count);
+			b.insert(b.end(), entries.begin(), entries.end());
+			box_end(b, ctts);
+		}
+
+		// sync-samples (omitted if every sample is a sync-sample)
+		if (m_video.sync_sample.size() != count) {
+			const size_t stss = fullbox_begin(b, "stss", 0, 0);
+			put32(b, static_cast<uint32_t>(m_video.sync_sample.size()));
+			for (size_t i = 0; i < m_video.sync_sample.size(); ++i)
+				put32(b, m_video.sync_sample[i]);
+			box_end(b, stss);
+		}
+
+		_build_stbl_tables(b, m_video);
+	}
+
+	box_end(b, stbl);
+	box_end(b, minf);
+	box_end(b, mdia);
+	box_end(b, trak);
+}
+
+void CMp4Writer::_build_audio_trak(bytes_t &b, const mp4_track_t &t) const
+{
+	const size_t trak = box_begin(b, "trak");
+	put_track_header(b, t.track_ID, false, t.duration * MP4_MOVIE_TIMESCALE / t.timescale, 0, 0);
+
+	const size_t mdia = box_begin(b, "mdia");
+	put_media_header(b, t.timescale, t.duration, false);
+
+	const size_t minf = box_begin(b, "minf");
+	const size_t smhd = fullbox_begin(b, "smhd", 0, 0);
+	put16(b, 0);                   // balance
+	put16(b, 0);                   // reserved
+	box_end(b, smhd);
+	put_dinf(b);
+
+	const size_t stbl = box_begin(b, "stbl");
+	b.insert(b.end(), t.stsd.begin(), t.stsd.end());
+
+	if (!t.stts.empty())
+		b.insert(b.end(), t.stts.begin(), t.stts.end());
+	else {
+		// PCM: every sample (PCM-frame) lasts 1 tick of the sample-rate
+		const size_t stts = fullbox_begin(b, "stts", 0, 0);
+		put32(b, 1);
+		put32(b, t.const_sample_count);
+		put32(b, 1);
+		box_end(b, stts);
+	}
+
+	_build_stbl_tables(b, t);
+
+	box_end(b, stbl);
+	box_end(b, minf);
+	box_end(b, mdia);
+	box_end(b, trak);
+}
+
+// stsc, stsz, stco/co64
+void CMp4Writer::_build_stbl_tables(bytes_t &b, const mp4_track_t &t) const
+{
+	// sample-to-chunk (run-length coded)
+	bytes_t entries;
+	uint32_t entry_count = 0;
+	for (size_t c = 0; c < t.chunk_samples.size(); ++c)
+		if (c == 0 || t.chunk_samples[c] != t.chunk_samples[c - 1]) {
+			put32(entries, static_cast<uint32_t>(c + 1)); // first_chunk
+			put32(entries, t.chunk_samples[c]);          // samples_per_chunk
+			put32(entries, 1);                           // sample_description_index
+			++entry_count;
+		}
+	const size_t stsc = fullbox_begin(b, "stsc", 0, 0);
+	put32(b, entry_count);
+	b.insert(b.end(), entries.begin(), entries.end());
+	box_end(b, stsc);
+
+	// sample-sizes
+	const size_t stsz = fullbox_begin(b, "stsz", 0, 0);
+	if (t.const_sample_size) {
+		put32(b, t.const_sample_size);
+		put32(b, t.const_sample_count);
+	}
+	else {
+		put32(b, 0);
+		put32(b, static_cast<uint32_t>(t.sample_size.size()));
+		for (size_t i = 0; i < t.sample_size.size(); ++i)
+			put32(b, t.sample_size[i]);
+	}
+	box_end(b, stsz);
+
+	// chunk-offsets: 32-bit unless the file has grown beyond 4GB
+	bool use_co64 = false;
+	for (size_t c = 0; !use_co64 && c < t.chunk_offset.size(); ++c)
+		use_co64 = (t.chunk_offset[c] > 0xFFFFFFFFull);
+
+	const size_t stco = fullbox_begin(b, use_co64 ? "co64" : "stco", 0, 0);
+	put32(b, static_cast<uint32_t>(t.chunk_offset.size()));
+	for (size_t c = 0; c < t.chunk_offset.size(); ++c)
+		if (use_co64)
+			put64(b, t.chunk_offset[c]);
+		else
+			put32(b, static_cast<uint32_t>(t.chunk_offset[c]));
+	box_end(b, stco);
+}
+
+void CMp4Writer::_build_video_stsd(bytes_t &b) const
+{
+	const bool is_hevc = (m_codec == MP4_VIDEO_HEVC);
+
+	// Parameter-sets in the samples are not allowed with 'hvc1'; use 'hev1' then.
+	const char *fourcc = is_hevc ? (m_inband_ps ? "hev1" : "hvc1") : "avc1";
+	const char *compressor = is_hevc ? "NVENC HEVC" : "NVENC H.264";
+
+	const size_t stsd = fullbox_begin(b, "stsd", 0, 0);
+	put32(b, 1);
+
+	const size_t entry = box_begin(b, fourcc);
+	put32(b, 0); put16(b, 0);      // reserved
+	put16(b, 1);                   // data_reference_index
+	put16(b, 0);                   // pre_defined
+	put16(b, 0);                   // reserved
+	put32(b, 0); put32(b, 0); put32(b, 0); // pre_defined
+	put16(b, m_width);
+	put16(b, m_height);
+	put32(b, 0x00480000);          // horizresolution 72dpi
+	put32(b, 0x00480000);          // vertresolution  72dpi
+	put32(b, 0);                   // reserved
+	put16(b, 1);                   // frame_count
+	uint8_t name[32] = { 0 };
+	name[0] = static_cast<uint8_t>(strlen(compressor));
+	memcpy(name + 1, compressor, name[0]);
+	put_bytes(b, name, sizeof(name));// compressorname
+	put16(b, 0x0018);              // depth
+	put16(b, 0xFFFF);              // pre_defined = -1
+
+	if (is_hevc)
+		_build_hvcC(b);
+	else
+		_build_avcC(b);
+
+	box_end(b, entry);
+	box_end(b, stsd);
+}
+
+void CMp4Writer::_build_avcC(bytes_t &b) const
+{
+	const size_t avcC = box_begin(b, "avcC");
+	nal_build_avc_config(b, m_sps, m_pps); // (if no SPS was received, Close() reports the error)
+	box_end(b, avcC);
+}
+
+void CMp4Writer::_build_hvcC(bytes_t &b) const
+{
+	const size_t hvcC = box_begin(b, "hvcC");
+	nal_build_hevc_config(b, m_vps, m_sps, m_pps); // (if no SPS was received, Close() reports the error)
+	box_end(b, hvcC);
+}
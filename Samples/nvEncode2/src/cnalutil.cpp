@@ -0,0 +1,244 @@
+#include "cnalutil.h"
+
+////////////////////
+//
+// byte-writers (big-endian)
+//
+
+static void put8(std::vector<uint8_t> &b, const uint32_t v)
+{
+	b.push_back(static_cast<uint8_t>(v));
+}
+
+static void put16(std::vector<uint8_t> &b, const uint32_t v)
+{
+	put8(b, v >> 8);
+	put8(b, v);
+}
+
+static void put32(std::vector<uint8_t> &b, const uint32_t v)
+{
+	put16(b, v >> 16);
+	put16(b, v);
+}
+
+static void put_nal(std::vector<uint8_t> &b, const std::vector<uint8_t> &nal) // 16-bit length + NAL
+{
+	put16(b, static_cast<uint32_t>(nal.size()));
+	b.insert(b.end(), nal.begin(), nal.end());
+}
+
+////////////////////
+//
+// nal_bitreader : reads the RBSP of a NAL-unit (emulation-prevention bytes are removed)
+//
+
+class nal_bitreader
+{
+public:
+	nal_bitreader(const uint8_t nal[], const size_t size) : m_bitpos(0), m_error(false)
+	{
+		unsigned zeros = 0;
+		for (size_t i = 0; i < size; ++i) {
+			if (zeros >= 2 && nal[i] == 0x03) {
+				zeros = 0; // drop emulation_prevention_three_byte
+				continue;
+			}
+			m_rbsp.push_back(nal[i]);
+			zeros = (nal[i] == 0) ? (zeros + 1) : 0;
+		}
+	}
+
+	uint32_t u(const unsigned bits) // read 'bits' (<= 32) bits, msb first
+	{
+		uint32_t v = 0;
+		for (unsigned i = 0; i < bits; ++i) {
+			const size_t byte = m_bitpos >> 3;
+			if (byte >= m_rbsp.size()) {
+				m_error = true;
+				return 0;
+			}
+			v = (v << 1) | ((m_rbsp[byte] >> (7 - (m_bitpos & 7))) & 1);
+			++m_bitpos;
+		}
+		return v;
+	}
+
+	uint32_t ue() // unsigned Exp-Golomb
+	{
+		unsigned leading_zeros = 0;
+		while (!m_error && u(1) == 0)
+			if (++leading_zeros > 31) {
+				m_error = true;
+				return 0;
+			}
+		return ((1u << leading_zeros) - 1) + u(leading_zeros);
+	}
+
+	void skip(const unsigned bits)
+	{
+		m_bitpos += bits;
+		if ((m_bitpos >> 3) > m_rbsp.size())
+			m_error = true;
+	}
+
+	bool error() const { return m_error; };
+
+protected:
+	std::vector<uint8_t> m_rbsp;
+	size_t               m_bitpos;
+	bool                 m_error;
+};
+
+// nal_find_start_code() - returns a pointer to the next Annex-B start-code (00 00 01), or end
+const uint8_t *
+nal_find_start_code(const uint8_t *p, const uint8_t *end)
+{
+	for (; p + 3 <= end; ++p)
+		if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+			return p;
+	return end;
+}
+
+bool
+nal_is_random_access(const bool hevc, const unsigned type)
+{
+	return hevc ? (type >= 16 && type <= 21) : (type == 5);
+}
+
+////////////////////
+//
+// decoder configuration-records
+//
+
+bool
+nal_build_avc_config(
+	std::vector<uint8_t> &b,
+	const std::vector<std::vector<uint8_t> > &sps_list,
+	const std::vector<std::vector<uint8_t> > &pps_list
+) {
+	if (sps_list.empty() || sps_list[0].size() < 4)
+		return false; // no SPS received
+
+	const std::vector<uint8_t> &sps = sps_list[0];
+	const uint8_t profile_idc = sps[1];
+	put8(b, 1);                    // configurationVersion
+	put8(b, profile_idc);          // AVCProfileIndication
+	put8(b, sps[2]);               // profile_compatibility
+	put8(b, sps[3]);               // AVCLevelIndication
+	put8(b, 0xFC | 3);             // lengthSizeMinusOne = 3
+	put8(b, 0xE0 | static_cast<uint32_t>(sps_list.size()));
+	for (size_t i = 0; i < sps_list.size(); ++i)
+		put_nal(b, sps_list[i]);
+	put8(b, static_cast<uint32_t>(pps_list.size()));
+	for (size_t i = 0; i < pps_list.size(); ++i)
+		put_nal(b, pps_list[i]);
+
+	// High-profiles carry the chroma-format and bit-depth in the avcC
+	switch (profile_idc) {
+		case 100: case 110: case 122: case 244: case 44:
+		case 83: case 86: case 118: case 128: case 138: case 139: case 134: case 135:
+		{
+			nal_bitreader br(&sps[1], sps.size() - 1);
+			br.skip(24);               // profile_idc, constraint_flags, level_idc
+			br.ue();                   // seq_parameter_set_id
+			const uint32_t chroma_format_idc = br.ue();
+			if (chroma_format_idc == 3)
+				br.u(1);               // separate_colour_plane_flag
+			const uint32_t bit_depth_luma_minus8 = br.ue();
+			const uint32_t bit_depth_chroma_minus8 = br.ue();
+
+			put8(b, 0xFC | (chroma_format_idc & 3));
+			put8(b, 0xF8 | (bit_depth_luma_minus8 & 7));
+			put8(b, 0xF8 | (bit_depth_chroma_minus8 & 7));
+			put8(b, 0);                // numOfSequenceParameterSetExt
+			break;
+		}
+		default:
+			break;
+	}
+	return true;
+}
+
+bool
+nal_build_hevc_config(
+	std::vector<uint8_t> &b,
+	const std::vector<std::vector<uint8_t> > &vps_list,
+	const std::vector<std::vector<uint8_t> > &sps_list,
+	const std::vector<std::vector<uint8_t> > &pps_list
+) {
+	if (sps_list.empty() || sps_list[0].size() < 3)
+		return false; // no SPS received
+
+	// parse the SPS (skip the 2-byte NAL-unit header)
+	const std::vector<uint8_t> &sps = sps_list[0];
+	nal_bitreader br(&sps[2], sps.size() - 2);
+	br.u(4);                                   // sps_video_parameter_set_id
+	const uint32_t max_sub_layers_minus1 = br.u(3);
+	const uint32_t temporal_id_nesting = br.u(1);
+
+	// profile_tier_level( 1, sps_max_sub_layers_minus1 )
+	const uint32_t profile_space = br.u(2);
+	const uint32_t tier_flag = br.u(1);
+	const uint32_t profile_idc = br.u(5);
+	const uint32_t compatibility_flags = br.u(32);
+	const uint32_t constraint_hi = br.u(32);   // progressive/interlaced/non-packed/frame-only + 44 reserved bits
+	const uint32_t constraint_lo = br.u(16);
+	const uint32_t level_idc = br.u(8);
+
+	bool sub_layer_profile_present[8] = { false };
+	bool sub_layer_level_present[8] = { false };
+	for (uint32_t i = 0; i < max_sub_layers_minus1; ++i) {
+		sub_layer_profile_present[i] = br.u(1) != 0;
+		sub_layer_level_present[i] = br.u(1) != 0;
+	}
+	if (max_sub_layers_minus1 > 0)
+		for (uint32_t i = max_sub_layers_minus1; i < 8; ++i)
+			br.u(2);                           // reserved_zero_2bits
+	for (uint32_t i = 0; i < max_sub_layers_minus1; ++i) {
+		if (sub_layer_profile_present[i])
+			br.skip(88);
+		if (sub_layer_level_present[i])
+			br.skip(8);
+	}
+
+	br.ue();                                   // sps_seq_parameter_set_id
+	const uint32_t chroma_format_idc = br.ue();
+	if (chroma_format_idc == 3)
+		br.u(1);                               // separate_colour_plane_flag
+	br.ue();                                   // pic_width_in_luma_samples
+	br.ue();                                   // pic_height_in_luma_samples
+	if (br.u(1)) {                             // conformance_window_flag
+		br.ue(); br.ue(); br.ue(); br.ue();
+	}
+	const uint32_t bit_depth_luma_minus8 = br.ue();
+	const uint32_t bit_depth_chroma_minus8 = br.ue();
+
+	put8(b, 1);                                // configurationVersion
+	put8(b, (profile_space << 6) | (tier_flag << 5) | profile_idc);
+	put32(b, compatibility_flags);
+	put32(b, constraint_hi);
+	put16(b, constraint_lo);
+	put8(b, level_idc);
+	put16(b, 0xF000);                          // min_spatial_segmentation_idc = 0
+	put8(b, 0xFC);                             // parallelismType = 0 (unknown)
+	put8(b, 0xFC | (chroma_format_idc & 3));
+	put8(b, 0xF8 | (bit_depth_luma_minus8 & 7));
+	put8(b, 0xF8 | (bit_depth_chroma_minus8 & 7));
+	put16(b, 0);                               // avgFrameRate (unspecified)
+	put8(b, (0 << 6) |                         // constantFrameRate (unknown)
+		(((max_sub_layers_minus1 + 1) & 7) << 3) |
+		(temporal_id_nesting << 2) |
+		3);                                    // lengthSizeMinusOne = 3
+
+	const std::vector<std::vector<uint8_t> > *arrays[3] = { &vps_list, &sps_list, &pps_list };
+	const uint32_t nal_types[3] = { 32, 33, 34 };
+	put8(b, 3);                                // numOfArrays
+	for (unsigned a = 0; a < 3; ++a) {
+		put8(b, 0x80 | nal_types[a]);          // array_completeness=1, NAL_unit_type
+		put16(b, static_cast<uint32_t>(arrays[a]->size()));
+		for (size_t i = 0; i < arrays[a]->size(); ++i)
+			put_nal(b, (*arrays[a])[i]);
+	}
+	return true;
+}
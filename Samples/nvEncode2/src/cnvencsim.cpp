@@ -0,0 +1,1219 @@
+#include <cstring>   // memset(), memcmp()
+#include <cstdlib>
+#include <vector>
+
+#include "cnvencsim.h"
+#include "xcodeutil.h"  // NvQueryPerformanceMicrosecs(), NvSleep()
+#include <threads/NvThreadingClasses.h>
+
+#define NVENCSIM_MAGIC_SESSION  0x4E534553 // handle-types (sanity check of the client's pointers)
+#define NVENCSIM_MAGIC_INPUT    0x4E53494E
+#define NVENCSIM_MAGIC_OUTPUT   0x4E534F55
+#define NVENCSIM_MAGIC_RESOURCE 0x4E535245
+
+#define NVENCSIM_ENGINE_QUEUE   64     // max #pictures queued to the engine
+#define NVENCSIM_MAX_PENDING    256    // max #output-buffers (and held B-pictures) waiting for a coded picture
+#define NVENCSIM_SPIN_US        2000   // engine yields (instead of sleeping) for the last 2 msec of a picture
+#define NVENCSIM_FILL_BYTE      0x55   // payload filler (contains no start-code emulation)
+#define NVENCSIM_MIN_BYTES      64
+
+static inline bool _guid_equal(const GUID &a, const GUID &b)
+{
+	return memcmp(&a, &b, sizeof(GUID)) == 0;
+}
+
+//
+// global configuration and statistics (shared by all sessions)
+//
+
+static nvencsim_config_t g_config = {
+	2500,  // latency_us
+	0,     // frame_bytes
+	4,     // idr_scale
+	true   // read_input
+};
+
+static nvencsim_stats_t g_stats;
+static uint32_t         g_in_flight = 0;
+
+// _mutex() - guards g_config, g_stats, g_in_flight, and the sessions' list of bitstream-buffers
+//   (CNvEncoder re-allocates bitstream-buffers on its output-thread)
+//   (constructed on first use: the threading-instance it needs is itself a static object)
+static CNvMutex &_mutex()
+{
+	static CNvMutex mutex;
+	return mutex;
+}
+
+void NvEncSim_SetConfig(const nvencsim_config_t &config)
+{
+	CNvAutoMutex lock(_mutex());
+	g_config = config;
+}
+
+void NvEncSim_GetConfig(nvencsim_config_t &config)
+{
+	CNvAutoMutex lock(_mutex());
+	config = g_config;
+}
+
+void NvEncSim_ResetStats()
+{
+	CNvAutoMutex lock(_mutex());
+	memset( (void *)&g_stats, 0, sizeof(g_stats) );
+	g_stats.max_in_flight = g_in_flight;
+}
+
+void NvEncSim_GetStats(nvencsim_stats_t &stats)
+{
+	CNvAutoMutex lock(_mutex());
+	stats = g_stats;
+}
+
+//
+// handle-types
+//
+
+typedef struct {
+	uint32_t             magic;
+	uint32_t             width;
+	uint32_t             height;
+	uint32_t             pitch;
+	NV_ENC_BUFFER_FORMAT format;
+	uint8_t             *data;     // host memory, or NULL (mapped resource: not read)
+	size_t               size;
+	double               t_lock;   // last LockInputBuffer()
+	double               t_unlock; // last UnlockInputBuffer()
+} nvencsim_input_t;
+
+typedef struct {
+	uint32_t             magic;
+	nvencsim_input_t     mapped;   // handed out by nvEncMapInputResource()
+} nvencsim_resource_t;
+
+typedef struct {
+	uint32_t             magic;
+	uint8_t             *data;
+	uint32_t             capacity;
+	uint32_t             size;         // [engine] #bytes of the coded picture
+	uint32_t             header_size;  // [engine] #bytes of NAL-headers written at the start of data[]
+	NV_ENC_PIC_TYPE      pic_type;     // [engine]
+	uint64_t             timestamp;    // [engine] outputTimeStamp
+	uint32_t             frame_idx;    // [engine]
+	CNvEvent            *done;         // manual-reset, set by the engine when the picture is complete
+
+	// pipeline timestamps (usec), see nvencsim_stats_t
+	double               t_lock_in, t_unlock_in, t_submit, t_start, t_done, t_lock;
+} nvencsim_output_t;
+
+// one coded picture (or EOS), in coding-order
+typedef struct {
+	nvencsim_input_t    *input;          // NULL = EOS
+	nvencsim_output_t   *output;
+	void                *completionEvent;
+	NV_ENC_PIC_TYPE      pic_type;
+	uint64_t             timestamp;
+	uint32_t             frame_idx;
+	bool                 hevc;
+	uint32_t             frame_bytes;    // P-picture size derived from the session's rate-control
+	double               t_lock_in;
+	double               t_unlock_in;
+	double               t_submit;
+} nvencsim_job_t;
+
+// a submitted picture whose output-buffer has not been assigned yet (B-frame reordering)
+typedef struct {
+	nvencsim_input_t    *input;
+	uint64_t             timestamp;
+	uint32_t             frame_idx;
+	double               t_lock_in;
+	double               t_unlock_in;
+	double               t_submit;
+} nvencsim_held_t;
+
+typedef struct {
+	nvencsim_output_t   *output;
+	void                *completionEvent;
+} nvencsim_pending_t;
+
+class CNvEncSimEngine;
+
+typedef struct {
+	uint32_t                          magic;
+	bool                              initialized;
+	NV_ENC_INITIALIZE_PARAMS          init;
+	NV_ENC_CONFIG                     config;
+	uint32_t                          frame_count;  // #pictures submitted (display-order)
+	uint32_t                          idr_frame;    // frame# of the last IDR
+	CNvRing<nvencsim_pending_t, NVENCSIM_MAX_PENDING> pending; // output-buffers waiting for a coded picture (submission-order)
+	CNvRing<nvencsim_held_t, NVENCSIM_MAX_PENDING>    held;    // B-pictures waiting for their next anchor
+	std::vector<nvencsim_input_t *>   inputs;
+	std::vector<nvencsim_output_t *>  outputs;
+	std::vector<nvencsim_resource_t *> resources;
+	CNvEncSimEngine                  *engine;
+} nvencsim_session_t;
+
+//
+// CNvEncSimEngine - the 'hardware': encodes the queued pictures one at a time
+//
+
+class CNvEncSimEngine : public CNvThread
+{
+public:
+	CNvEncSimEngine() : CNvThread("CNvEncSimEngine"), m_jobs(NVENCSIM_ENGINE_QUEUE) {}
+	virtual ~CNvEncSimEngine() {}
+
+	bool Submit(const nvencsim_job_t &job)
+	{
+		bool bIsEnqueued = m_jobs.Add(job);
+		ThreadTrigger();
+		return bIsEnqueued;
+	}
+
+protected:
+	CNvQueue<nvencsim_job_t, NVENCSIM_ENGINE_QUEUE> m_jobs;
+
+	virtual bool ThreadFunc()
+	{
+		nvencsim_job_t job;
+		while (m_jobs.Remove(job, 0))
+			_encode(job);
+		return false;
+	}
+
+	void _encode(const nvencsim_job_t &job);
+};
+
+static void _signal_completion_event(void *completionEvent)
+{
+#if defined(WIN32) || defined(_WIN32) || defined(WIN64)
+	if (completionEvent)
+		SetEvent( (HANDLE)completionEvent );
+#else
+	(void)completionEvent; // completion-events are Win32 event-handles
+#endif
+}
+
+// _write_headers() - write the Annex-B NAL-unit headers of a picture, returns #bytes
+static uint32_t _write_headers(uint8_t *p, const bool hevc, const NV_ENC_PIC_TYPE pic_type)
+{
+	static const uint8_t h264_sps[] = { 0,0,0,1, 0x67, 0x64,0x00,0x28, 0x55,0x55,0x55,0x55,0x55 };
+	static const uint8_t h264_pps[] = { 0,0,0,1, 0x68, 0x55,0x55,0x55 };
+	static const uint8_t hevc_vps[] = { 0,0,0,1, 0x40,0x01, 0x55,0x55,0x55,0x55,0x55,0x55 };
+	static const uint8_t hevc_sps[] = { 0,0,0,1, 0x42,0x01, 0x55,0x55,0x55,0x55,0x55,0x55,0x55,0x55 };
+	static const uint8_t hevc_pps[] = { 0,0,0,1, 0x44,0x01, 0x55,0x55,0x55 };
+
+	const bool idr = (pic_type == NV_ENC_PIC_TYPE_IDR);
+	uint32_t n = 0;
+
+#define _APPEND(a) memcpy(p + n, a, sizeof(a)), n += sizeof(a)
+	if (hevc) {
+		if (idr) {
+			_APPEND(hevc_vps);
+			_APPEND(hevc_sps);
+			_APPEND(hevc_pps);
+		}
+		const uint8_t slice[] = { 0,0,0,1,
+			(uint8_t)(idr ? 0x26 :                              // IDR_W_RADL
+				(pic_type == NV_ENC_PIC_TYPE_I) ? 0x2A : 0x02), // CRA, TRAIL_R
+			0x01 };
+		_APPEND(slice);
+	}
+	else {
+		if (idr) {
+			_APPEND(h264_sps);
+			_APPEND(h264_pps);
+		}
+		const uint8_t slice[] = { 0,0,0,1,
+			(uint8_t)(idr ? 0x65 :                              // IDR slice
+				(pic_type == NV_ENC_PIC_TYPE_B) ? 0x01 : 0x41) };// non-reference B, reference I/P
+		_APPEND(slice);
+	}
+#undef _APPEND
+
+	return n;
+}
+
+void CNvEncSimEngine::_encode(const nvencsim_job_t &job)
+{
+	nvencsim_config_t config;
+	NvEncSim_GetConfig(config);
+
+	if (!job.input) {
+		// EOS: all previously queued pictures are complete
+		_signal_completion_event(job.completionEvent);
+		return;
+	}
+
+	const double t_start = NvQueryPerformanceMicrosecs();
+	nvencsim_output_t *out = job.output;
+
+	// emulate the upload of the input-surface (memory traffic)
+	if (config.read_input && job.input->data) {
+		const uint64_t *p = reinterpret_cast<const uint64_t *>(job.input->data);
+		const size_t    n = job.input->size / sizeof(uint64_t);
+		uint64_t sum = 0;
+		for (size_t i = 0; i < n; ++i)
+			sum += p[i];
+		volatile uint64_t sink = sum;
+		(void)sink;
+	}
+
+	// coded picture: NAL-headers, then the (pre-filled) payload
+	const uint32_t header_size = _write_headers(out->data, job.hevc, job.pic_type);
+	if (header_size < out->header_size)
+		memset(out->data + header_size, NVENCSIM_FILL_BYTE, out->header_size - header_size);
+	out->header_size = header_size;
+
+	uint32_t bytes = config.frame_bytes ? config.frame_bytes : job.frame_bytes;
+	if (job.pic_type == NV_ENC_PIC_TYPE_IDR || job.pic_type == NV_ENC_PIC_TYPE_I)
+		bytes *= config.idr_scale ? config.idr_scale : 1;
+	if (bytes < header_size + NVENCSIM_MIN_BYTES)
+		bytes = header_size + NVENCSIM_MIN_BYTES;
+	if (bytes > out->capacity) {
+		bytes = out->capacity; // truncated, like the hardware
+		CNvAutoMutex lock(_mutex());
+		g_stats.overflows++;
+	}
+
+	// encode time
+	const double deadline = t_start + static_cast<double>(config.latency_us);
+	for (double remain = deadline - NvQueryPerformanceMicrosecs(); remain > 0.0; remain = deadline - NvQueryPerformanceMicrosecs())
+		NvSleep( (remain > NVENCSIM_SPIN_US) ? 1 : 0 );
+
+	out->size        = bytes;
+	out->pic_type    = job.pic_type;
+	out->timestamp   = job.timestamp;
+	out->frame_idx   = job.frame_idx;
+	out->t_lock_in   = job.t_lock_in;
+	out->t_unlock_in = job.t_unlock_in;
+	out->t_submit    = job.t_submit;
+	out->t_start     = t_start;
+	out->t_done      = NvQueryPerformanceMicrosecs();
+	out->done->Set();
+
+	_signal_completion_event(job.completionEvent);
+}
+
+//
+// session helpers
+//
+
+static nvencsim_session_t *_session(void *encoder)
+{
+	nvencsim_session_t *s = reinterpret_cast<nvencsim_session_t *>(encoder);
+	return (s && s->magic == NVENCSIM_MAGIC_SESSION) ? s : NULL;
+}
+
+static bool _is_codec(const GUID &encodeGUID)
+{
+	return _guid_equal(encodeGUID, NV_ENC_CODEC_H264_GUID) || _guid_equal(encodeGUID, NV_ENC_CODEC_HEVC_GUID);
+}
+
+static bool _is_hevc(const nvencsim_session_t *s)
+{
+	return _guid_equal(s->init.encodeGUID, NV_ENC_CODEC_HEVC_GUID);
+}
+
+// size of a P-picture, derived from the rate-control settings
+static uint32_t _derived_frame_bytes(const nvencsim_session_t *s)
+{
+	const uint32_t bitrate = s->config.rcParams.averageBitRate;
+	if (bitrate && s->init.frameRateNum && s->init.frameRateDen)
+		return static_cast<uint32_t>( (static_cast<uint64_t>(bitrate) * s->init.frameRateDen) / (8ULL * s->init.frameRateNum) );
+
+	return (s->init.encodeWidth * s->init.encodeHeight) / 50;
+}
+
+// _queue_picture() - pass one picture (in coding-order) to the engine
+static NVENCSTATUS _queue_picture(nvencsim_session_t *s, const nvencsim_held_t &pic, const NV_ENC_PIC_TYPE pic_type)
+{
+	nvencsim_pending_t next;
+	if (!s->pending.Remove(next, 0))
+		return NV_ENC_ERR_NOT_ENOUGH_BUFFER;
+
+	nvencsim_job_t job;
+	job.input           = pic.input;
+	job.output          = next.output;
+	job.completionEvent = next.completionEvent;
+	job.pic_type        = pic_type;
+	job.timestamp       = pic.timestamp;
+	job.frame_idx       = pic.frame_idx;
+	job.hevc            = _is_hevc(s);
+	job.frame_bytes     = _derived_frame_bytes(s);
+	job.t_lock_in       = pic.t_lock_in;
+	job.t_unlock_in     = pic.t_unlock_in;
+	job.t_submit        = pic.t_submit;
+
+	return s->engine->Submit(job) ? NV_ENC_SUCCESS : NV_ENC_ERR_ENCODER_BUSY;
+}
+
+// _flush_held() - code the held-back B-pictures as P-pictures (next picture is an IDR, or EOS)
+static NVENCSTATUS _flush_held(nvencsim_session_t *s)
+{
+	NVENCSTATUS nvStatus = NV_ENC_SUCCESS;
+	nvencsim_held_t pic;
+	while (nvStatus == NV_ENC_SUCCESS && s->held.Remove(pic, 0))
+		nvStatus = _queue_picture(s, pic, NV_ENC_PIC_TYPE_P);
+	return nvStatus;
+}
+
+static uint32_t _idr_period(const nvencsim_session_t *s)
+{
+	const uint32_t idrPeriod = _is_hevc(s) ?
+		s->config.encodeCodecConfig.hevcConfig.idrPeriod :
+		s->config.encodeCodecConfig.h264Config.idrPeriod;
+
+	return idrPeriod ? idrPeriod : s->config.gopLength;
+}
+
+// _decide_pic_type() - picture-type decision (enablePTD)
+static NV_ENC_PIC_TYPE _decide_pic_type(const nvencsim_session_t *s, const uint32_t encodePicFlags)
+{
+	const uint32_t idr_period = _idr_period(s);
+	const uint32_t gop        = s->config.gopLength;
+	const uint32_t pos        = s->frame_count - s->idr_frame; // position in the IDR-period
+	const uint32_t interval_p = (s->config.frameIntervalP > 1) ? static_cast<uint32_t>(s->config.frameIntervalP) : 1;
+
+	if (s->frame_count == 0 || (encodePicFlags & NV_ENC_PIC_FLAG_FORCEIDR))
+		return NV_ENC_PIC_TYPE_IDR;
+	if (idr_period && idr_period != NVENC_INFINITE_GOPLENGTH && pos >= idr_period)
+		return NV_ENC_PIC_TYPE_IDR;
+	if (encodePicFlags & NV_ENC_PIC_FLAG_FORCEINTRA)
+		return NV_ENC_PIC_TYPE_I;
+	if (gop && gop != NVENC_INFINITE_GOPLENGTH && (pos % gop) == 0)
+		return NV_ENC_PIC_TYPE_I;
+
+	return ((pos % interval_p) == 0) ? NV_ENC_PIC_TYPE_P : NV_ENC_PIC_TYPE_B;
+}
+
+static uint32_t _bytes_per_sample(const NV_ENC_BUFFER_FORMAT fmt)
+{
+	switch (fmt) {
+		case NV_ENC_BUFFER_FORMAT_ARGB:
+		case NV_ENC_BUFFER_FORMAT_ARGB10:
+		case NV_ENC_BUFFER_FORMAT_AYUV:
+			return 4;
+#if NVENCAPI_MAJOR_VERSION >= 7
+		case NV_ENC_BUFFER_FORMAT_YUV420_10BIT:
+		case NV_ENC_BUFFER_FORMAT_YUV444_10BIT:
+			return 2;
+#endif
+		default:
+			return 1;
+	}
+}
+
+// #rows of the buffer (all planes, in units of the luma-pitch)
+static uint32_t _buffer_rows(const NV_ENC_BUFFER_FORMAT fmt, const uint32_t height)
+{
+	switch (fmt) {
+		case NV_ENC_BUFFER_FORMAT_YUV444:
+#if NVENCAPI_MAJOR_VERSION >= 7
+		case NV_ENC_BUFFER_FORMAT_YUV444_10BIT:
+#endif
+			return height * 3;
+		case NV_ENC_BUFFER_FORMAT_ARGB:
+		case NV_ENC_BUFFER_FORMAT_ARGB10:
+		case NV_ENC_BUFFER_FORMAT_AYUV:
+			return height;
+		default: // NV12, YV12, IYUV, YUV420_10BIT
+			return height + (height + 1) / 2;
+	}
+}
+
+//
+// NV_ENCODE_API_FUNCTION_LIST
+//
+
+static NVENCSTATUS NVENCAPI _sim_OpenEncodeSessionEx(NV_ENC_OPEN_ENCODE_SESSION_EX_PARAMS *openSessionExParams, void **encoder)
+{
+	if (!openSessionExParams || !encoder)
+		return NV_ENC_ERR_INVALID_PTR;
+
+	nvencsim_session_t *s = new nvencsim_session_t;
+	s->magic       = NVENCSIM_MAGIC_SESSION;
+	s->initialized = false;
+	s->frame_count = 0;
+	s->idr_frame   = 0;
+	s->engine      = NULL;
+	memset( (void *)&s->init,   0, sizeof(s->init) );
+	memset( (void *)&s->config, 0, sizeof(s->config) );
+
+	*encoder = s;
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_OpenEncodeSession(void *device, uint32_t deviceType, void **encoder)
+{
+	NV_ENC_OPEN_ENCODE_SESSION_EX_PARAMS params;
+	memset( (void *)&params, 0, sizeof(params) );
+	params.device     = device;
+	params.deviceType = static_cast<NV_ENC_DEVICE_TYPE>(deviceType);
+	return _sim_OpenEncodeSessionEx(&params, encoder);
+}
+
+static NVENCSTATUS NVENCAPI _sim_GetEncodeGUIDCount(void *encoder, uint32_t *encodeGUIDCount)
+{
+	if (!_session(encoder)) return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!encodeGUIDCount)   return NV_ENC_ERR_INVALID_PTR;
+	*encodeGUIDCount = 2;
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_GetEncodeGUIDs(void *encoder, GUID *GUIDs, uint32_t guidArraySize, uint32_t *GUIDCount)
+{
+	if (!_session(encoder))    return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!GUIDs || !GUIDCount)  return NV_ENC_ERR_INVALID_PTR;
+
+	const GUID list[] = { NV_ENC_CODEC_H264_GUID, NV_ENC_CODEC_HEVC_GUID };
+	uint32_t n = 0;
+	for (; n < guidArraySize && n < sizeof(list)/sizeof(list[0]); ++n)
+		GUIDs[n] = list[n];
+	*GUIDCount = n;
+	return NV_ENC_SUCCESS;
+}
+
+static uint32_t _profile_list(const GUID &encodeGUID, GUID list[8])
+{
+	uint32_t n = 0;
+	if (_guid_equal(encodeGUID, NV_ENC_CODEC_H264_GUID)) {
+		list[n++] = NV_ENC_H264_PROFILE_BASELINE_GUID;
+		list[n++] = NV_ENC_H264_PROFILE_MAIN_GUID;
+		list[n++] = NV_ENC_H264_PROFILE_HIGH_GUID;
+		list[n++] = NV_ENC_H264_PROFILE_HIGH_444_GUID;
+		list[n++] = NV_ENC_H264_PROFILE_PROGRESSIVE_HIGH_GUID;
+		list[n++] = NV_ENC_H264_PROFILE_CONSTRAINED_HIGH_GUID;
+	}
+	else if (_guid_equal(encodeGUID, NV_ENC_CODEC_HEVC_GUID)) {
+		list[n++] = NV_ENC_HEVC_PROFILE_MAIN_GUID;
+	}
+	return n;
+}
+
+static NVENCSTATUS NVENCAPI _sim_GetEncodeProfileGUIDCount(void *encoder, GUID encodeGUID, uint32_t *encodeProfileGUIDCount)
+{
+	if (!_session(encoder))       return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!encodeProfileGUIDCount)  return NV_ENC_ERR_INVALID_PTR;
+	if (!_is_codec(encodeGUID))   return NV_ENC_ERR_UNSUPPORTED_PARAM;
+
+	GUID list[8];
+	*encodeProfileGUIDCount = _profile_list(encodeGUID, list);
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_GetEncodeProfileGUIDs(void *encoder, GUID encodeGUID, GUID *profileGUIDs, uint32_t guidArraySize, uint32_t *GUIDCount)
+{
+	if (!_session(encoder))            return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!profileGUIDs || !GUIDCount)   return NV_ENC_ERR_INVALID_PTR;
+	if (!_is_codec(encodeGUID))        return NV_ENC_ERR_UNSUPPORTED_PARAM;
+
+	GUID list[8];
+	const uint32_t count = _profile_list(encodeGUID, list);
+	uint32_t n = 0;
+	for (; n < guidArraySize && n < count; ++n)
+		profileGUIDs[n] = list[n];
+	*GUIDCount = n;
+	return NV_ENC_SUCCESS;
+}
+
+static const NV_ENC_BUFFER_FORMAT g_input_formats[] = {
+	NV_ENC_BUFFER_FORMAT_NV12,
+	NV_ENC_BUFFER_FORMAT_YV12,
+	NV_ENC_BUFFER_FORMAT_IYUV,
+	NV_ENC_BUFFER_FORMAT_YUV444,
+	NV_ENC_BUFFER_FORMAT_ARGB,
+	NV_ENC_BUFFER_FORMAT_AYUV
+};
+
+static NVENCSTATUS NVENCAPI _sim_GetInputFormatCount(void *encoder, GUID encodeGUID, uint32_t *inputFmtCount)
+{
+	if (!_session(encoder))     return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!inputFmtCount)         return NV_ENC_ERR_INVALID_PTR;
+	if (!_is_codec(encodeGUID)) return NV_ENC_ERR_UNSUPPORTED_PARAM;
+
+	*inputFmtCount = sizeof(g_input_formats) / sizeof(g_input_formats[0]);
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_GetInputFormats(void *encoder, GUID encodeGUID, NV_ENC_BUFFER_FORMAT *inputFmts, uint32_t inputFmtArraySize, uint32_t *inputFmtCount)
+{
+	if (!_session(encoder))          return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!inputFmts || !inputFmtCount) return NV_ENC_ERR_INVALID_PTR;
+	if (!_is_codec(encodeGUID))      return NV_ENC_ERR_UNSUPPORTED_PARAM;
+
+	uint32_t n = 0;
+	for (; n < inputFmtArraySize && n < sizeof(g_input_formats) / sizeof(g_input_formats[0]); ++n)
+		inputFmts[n] = g_input_formats[n];
+	*inputFmtCount = n;
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_GetEncodeCaps(void *encoder, GUID encodeGUID, NV_ENC_CAPS_PARAM *capsParam, int *capsVal)
+{
+	if (!_session(encoder))       return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!capsParam || !capsVal)   return NV_ENC_ERR_INVALID_PTR;
+	if (!_is_codec(encodeGUID))   return NV_ENC_ERR_UNSUPPORTED_PARAM;
+
+	const bool hevc = _guid_equal(encodeGUID, NV_ENC_CODEC_HEVC_GUID);
+	int v = 0;
+	switch (capsParam->capsToQuery) {
+		case NV_ENC_CAPS_NUM_MAX_BFRAMES:                v = hevc ? 0 : 4; break;
+		case NV_ENC_CAPS_SUPPORTED_RATECONTROL_MODES:
+			v = NV_ENC_PARAMS_RC_CONSTQP | NV_ENC_PARAMS_RC_VBR | NV_ENC_PARAMS_RC_CBR | NV_ENC_PARAMS_RC_VBR_MINQP |
+				NV_ENC_PARAMS_RC_2_PASS_QUALITY | NV_ENC_PARAMS_RC_2_PASS_FRAMESIZE_CAP | NV_ENC_PARAMS_RC_2_PASS_VBR;
+			break;
+		case NV_ENC_CAPS_SUPPORT_FIELD_ENCODING:         v = hevc ? 0 : 1; break;
+		case NV_ENC_CAPS_SUPPORT_MONOCHROME:             v = 0; break;
+		case NV_ENC_CAPS_SUPPORT_FMO:                    v = 0; break;
+		case NV_ENC_CAPS_SUPPORT_QPELMV:                 v = 1; break;
+		case NV_ENC_CAPS_SUPPORT_BDIRECT_MODE:           v = hevc ? 0 : 1; break;
+		case NV_ENC_CAPS_SUPPORT_CABAC:                  v = hevc ? 0 : 1; break;
+		case NV_ENC_CAPS_SUPPORT_ADAPTIVE_TRANSFORM:     v = hevc ? 0 : 1; break;
+		case NV_ENC_CAPS_NUM_MAX_TEMPORAL_LAYERS:        v = 0; break;
+		case NV_ENC_CAPS_SUPPORT_HIERARCHICAL_PFRAMES:   v = 0; break;
+		case NV_ENC_CAPS_SUPPORT_HIERARCHICAL_BFRAMES:   v = 0; break;
+		case NV_ENC_CAPS_LEVEL_MAX:                      v = hevc ? NV_ENC_LEVEL_HEVC_62 : NV_ENC_LEVEL_H264_51; break;
+		case NV_ENC_CAPS_LEVEL_MIN:                      v = hevc ? NV_ENC_LEVEL_HEVC_1  : NV_ENC_LEVEL_H264_1;  break;
+		case NV_ENC_CAPS_SEPARATE_COLOUR_PLANE:          v = 0; break;
+		case NV_ENC_CAPS_WIDTH_MAX:                      v = 4096; break;
+		case NV_ENC_CAPS_HEIGHT_MAX:                     v = 4096; break;
+		case NV_ENC_CAPS_SUPPORT_TEMPORAL_SVC:           v = 0; break;
+		case NV_ENC_CAPS_SUPPORT_DYN_RES_CHANGE:         v = 1; break;
+		case NV_ENC_CAPS_SUPPORT_DYN_BITRATE_CHANGE:     v = 1; break;
+		case NV_ENC_CAPS_SUPPORT_DYN_FORCE_CONSTQP:      v = 1; break;
+		case NV_ENC_CAPS_SUPPORT_DYN_RCMODE_CHANGE:      v = 0; break;
+		case NV_ENC_CAPS_SUPPORT_SUBFRAME_READBACK:      v = 0; break;
+		case NV_ENC_CAPS_SUPPORT_CONSTRAINED_ENCODING:   v = 0; break;
+		case NV_ENC_CAPS_SUPPORT_INTRA_REFRESH:          v = 0; break;
+		case NV_ENC_CAPS_SUPPORT_CUSTOM_VBV_BUF_SIZE:    v = 1; break;
+		case NV_ENC_CAPS_SUPPORT_DYNAMIC_SLICE_MODE:     v = 0; break;
+		case NV_ENC_CAPS_SUPPORT_REF_PIC_INVALIDATION:   v = 0; break;
+		case NV_ENC_CAPS_PREPROC_SUPPORT:                v = 0; break;
+		case NV_ENC_CAPS_ASYNC_ENCODE_SUPPORT:           v = 1; break;
+		case NV_ENC_CAPS_MB_NUM_MAX:                     v = (4096 / 16) * (4096 / 16); break;
+		case NV_ENC_CAPS_MB_PER_SEC_MAX:                 v = (4096 / 16) * (4096 / 16) * 60; break;
+		case NV_ENC_CAPS_SUPPORT_YUV444_ENCODE:          v = 1; break;
+		case NV_ENC_CAPS_SUPPORT_LOSSLESS_ENCODE:        v = 1; break;
+		case NV_ENC_CAPS_SUPPORT_SAO:                    v = hevc ? 1 : 0; break;
+		case NV_ENC_CAPS_SUPPORT_MEONLY_MODE:            v = 0; break;
+		default:
+			return NV_ENC_ERR_UNSUPPORTED_PARAM;
+	}
+
+	*capsVal = v;
+	return NV_ENC_SUCCESS;
+}
+
+static uint32_t _preset_list(GUID list[16])
+{
+	uint32_t n = 0;
+	list[n++] = NV_ENC_PRESET_DEFAULT_GUID;
+	list[n++] = NV_ENC_PRESET_HP_GUID;
+	list[n++] = NV_ENC_PRESET_HQ_GUID;
+	list[n++] = NV_ENC_PRESET_BD_GUID;
+	list[n++] = NV_ENC_PRESET_LOW_LATENCY_DEFAULT_GUID;
+	list[n++] = NV_ENC_PRESET_LOW_LATENCY_HQ_GUID;
+	list[n++] = NV_ENC_PRESET_LOW_LATENCY_HP_GUID;
+	list[n++] = NV_ENC_PRESET_LOSSLESS_DEFAULT_GUID;
+	list[n++] = NV_ENC_PRESET_LOSSLESS_HP_GUID;
+	return n;
+}
+
+static NVENCSTATUS NVENCAPI _sim_GetEncodePresetCount(void *encoder, GUID encodeGUID, uint32_t *encodePresetGUIDCount)
+{
+	if (!_session(encoder))       return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!encodePresetGUIDCount)   return NV_ENC_ERR_INVALID_PTR;
+	if (!_is_codec(encodeGUID))   return NV_ENC_ERR_UNSUPPORTED_PARAM;
+
+	GUID list[16];
+	*encodePresetGUIDCount = _preset_list(list);
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_GetEncodePresetGUIDs(void *encoder, GUID encodeGUID, GUID *presetGUIDs, uint32_t guidArraySize, uint32_t *encodePresetGUIDCount)
+{
+	if (!_session(encoder))                      return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!presetGUIDs || !encodePresetGUIDCount)  return NV_ENC_ERR_INVALID_PTR;
+	if (!_is_codec(encodeGUID))                  return NV_ENC_ERR_UNSUPPORTED_PARAM;
+
+	GUID list[16];
+	const uint32_t count = _preset_list(list);
+	uint32_t n = 0;
+	for (; n < guidArraySize && n < count; ++n)
+		presetGUIDs[n] = list[n];
+	*encodePresetGUIDCount = n;
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_GetEncodePresetConfig(void *encoder, GUID encodeGUID, GUID presetGUID, NV_ENC_PRESET_CONFIG *presetConfig)
+{
+	if (!_session(encoder))      return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!presetConfig)           return NV_ENC_ERR_INVALID_PTR;
+	if (!_is_codec(encodeGUID))  return NV_ENC_ERR_UNSUPPORTED_PARAM;
+
+	GUID list[16];
+	const uint32_t count = _preset_list(list);
+	bool found = false;
+	for (uint32_t i = 0; i < count; ++i)
+		found |= _guid_equal(presetGUID, list[i]);
+	if (!found)
+		return NV_ENC_ERR_UNSUPPORTED_PARAM;
+
+	NV_ENC_CONFIG &cfg = presetConfig->presetCfg;
+	const uint32_t version = cfg.version;
+	memset( (void *)&cfg, 0, sizeof(cfg) );
+	cfg.version        = version;
+	cfg.profileGUID    = NV_ENC_CODEC_PROFILE_AUTOSELECT_GUID;
+	cfg.gopLength      = 30;
+	cfg.frameIntervalP = 1;
+	cfg.frameFieldMode = NV_ENC_PARAMS_FRAME_FIELD_MODE_FRAME;
+	cfg.mvPrecision    = NV_ENC_MV_PRECISION_QUARTER_PEL;
+	cfg.rcParams.rateControlMode  = NV_ENC_PARAMS_RC_CONSTQP;
+	cfg.rcParams.constQP.qpInterP = 28;
+	cfg.rcParams.constQP.qpInterB = 31;
+	cfg.rcParams.constQP.qpIntra  = 25;
+	if (_guid_equal(encodeGUID, NV_ENC_CODEC_HEVC_GUID)) {
+		cfg.encodeCodecConfig.hevcConfig.idrPeriod       = cfg.gopLength;
+		cfg.encodeCodecConfig.hevcConfig.chromaFormatIDC = 1;
+	}
+	else {
+		cfg.encodeCodecConfig.h264Config.idrPeriod       = cfg.gopLength;
+		cfg.encodeCodecConfig.h264Config.chromaFormatIDC = 1;
+	}
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_InitializeEncoder(void *encoder, NV_ENC_INITIALIZE_PARAMS *createEncodeParams)
+{
+	nvencsim_session_t *s = _session(encoder);
+	if (!s)                  return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!createEncodeParams) return NV_ENC_ERR_INVALID_PTR;
+	if (s->initialized)      return NV_ENC_ERR_INVALID_CALL;
+	if (!_is_codec(createEncodeParams->encodeGUID) ||
+		!createEncodeParams->encodeWidth || !createEncodeParams->encodeHeight)
+		return NV_ENC_ERR_INVALID_PARAM;
+
+	s->init = *createEncodeParams;
+	if (createEncodeParams->encodeConfig)
+		s->config = *createEncodeParams->encodeConfig;
+	else {
+		NV_ENC_PRESET_CONFIG preset;
+		memset( (void *)&preset, 0, sizeof(preset) );
+		_sim_GetEncodePresetConfig(encoder, s->init.encodeGUID, NV_ENC_PRESET_DEFAULT_GUID, &preset);
+		s->config = preset.presetCfg;
+	}
+	s->init.encodeConfig = &s->config;
+
+	s->engine = new CNvEncSimEngine();
+	s->engine->ThreadStart();
+	s->initialized = true;
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_ReconfigureEncoder(void *encoder, NV_ENC_RECONFIGURE_PARAMS *reInitEncodeParams)
+{
+	nvencsim_session_t *s = _session(encoder);
+	if (!s)                  return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!reInitEncodeParams) return NV_ENC_ERR_INVALID_PTR;
+	if (!s->initialized)     return NV_ENC_ERR_ENCODER_NOT_INITIALIZED;
+
+	// the new settings only change the derived picture-size and the picture-type decision
+	s->init = reInitEncodeParams->reInitEncodeParams;
+	if (reInitEncodeParams->reInitEncodeParams.encodeConfig)
+		s->config = *reInitEncodeParams->reInitEncodeParams.encodeConfig;
+	s->init.encodeConfig = &s->config;
+	if (reInitEncodeParams->forceIDR)
+		s->idr_frame = s->frame_count; // (approximation: next picture is the IDR)
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_CreateInputBuffer(void *encoder, NV_ENC_CREATE_INPUT_BUFFER *createInputBufferParams)
+{
+	nvencsim_session_t *s = _session(encoder);
+	if (!s)                       return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!createInputBufferParams) return NV_ENC_ERR_INVALID_PTR;
+
+	const NV_ENC_CREATE_INPUT_BUFFER &p = *createInputBufferParams;
+	if (!p.width || !p.height)
+		return NV_ENC_ERR_INVALID_PARAM;
+
+	nvencsim_input_t *in = new nvencsim_input_t;
+	in->magic    = NVENCSIM_MAGIC_INPUT;
+	in->width    = p.width;
+	in->height   = p.height;
+	in->format   = p.bufferFmt;
+	in->pitch    = (p.width * _bytes_per_sample(p.bufferFmt) + 255) & ~255; // 256-byte aligned rows, like the driver
+	in->size     = static_cast<size_t>(in->pitch) * _buffer_rows(p.bufferFmt, p.height);
+	in->data     = static_cast<uint8_t *>(calloc(in->size, 1));
+	in->t_lock   = 0.0;
+	in->t_unlock = 0.0;
+	if (!in->data) {
+		delete in;
+		return NV_ENC_ERR_OUT_OF_MEMORY;
+	}
+
+	s->inputs.push_back(in);
+	createInputBufferParams->inputBuffer = in;
+	return NV_ENC_SUCCESS;
+}
+
+static void _free_input(nvencsim_input_t *in)
+{
+	in->magic = 0;
+	free(in->data);
+	delete in;
+}
+
+static NVENCSTATUS NVENCAPI _sim_DestroyInputBuffer(void *encoder, NV_ENC_INPUT_PTR inputBuffer)
+{
+	nvencsim_session_t *s = _session(encoder);
+	if (!s)
+		return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+
+	for (std::vector<nvencsim_input_t *>::iterator it = s->inputs.begin(); it != s->inputs.end(); ++it) {
+		if (*it == inputBuffer) {
+			_free_input(*it);
+			s->inputs.erase(it);
+			return NV_ENC_SUCCESS;
+		}
+	}
+	return NV_ENC_ERR_INVALID_PTR;
+}
+
+static NVENCSTATUS NVENCAPI _sim_CreateBitstreamBuffer(void *encoder, NV_ENC_CREATE_BITSTREAM_BUFFER *createBitstreamBufferParams)
+{
+	nvencsim_session_t *s = _session(encoder);
+	if (!s)                           return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!createBitstreamBufferParams) return NV_ENC_ERR_INVALID_PTR;
+	if (!createBitstreamBufferParams->size)
+		return NV_ENC_ERR_INVALID_PARAM;
+
+	nvencsim_output_t *out = new nvencsim_output_t;
+	memset( (void *)out, 0, sizeof(*out) );
+	out->magic    = NVENCSIM_MAGIC_OUTPUT;
+	out->capacity = createBitstreamBufferParams->size;
+	out->data     = static_cast<uint8_t *>(malloc(out->capacity));
+	if (!out->data) {
+		delete out;
+		return NV_ENC_ERR_OUT_OF_MEMORY;
+	}
+	memset(out->data, NVENCSIM_FILL_BYTE, out->capacity); // the payload; the engine only writes the NAL-headers
+	out->done = new CNvEvent(true, false); // manual-reset, not signalled
+
+	CNvAutoMutex lock(_mutex());
+	s->outputs.push_back(out);
+	createBitstreamBufferParams->bitstreamBuffer    = out;
+	createBitstreamBufferParams->bitstreamBufferPtr = out->data;
+	return NV_ENC_SUCCESS;
+}
+
+static void _free_output(nvencsim_output_t *out)
+{
+	out->magic = 0;
+	delete out->done;
+	free(out->data);
+	delete out;
+}
+
+static NVENCSTATUS NVENCAPI _sim_DestroyBitstreamBuffer(void *encoder, NV_ENC_OUTPUT_PTR bitstreamBuffer)
+{
+	nvencsim_session_t *s = _session(encoder);
+	if (!s)
+		return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+
+	CNvAutoMutex lock(_mutex());
+	for (std::vector<nvencsim_output_t *>::iterator it = s->outputs.begin(); it != s->outputs.end(); ++it) {
+		if (*it == bitstreamBuffer) {
+			_free_output(*it);
+			s->outputs.erase(it);
+			return NV_ENC_SUCCESS;
+		}
+	}
+	return NV_ENC_ERR_INVALID_PTR;
+}
+
+static nvencsim_input_t *_input(void *ptr)
+{
+	nvencsim_input_t *in = reinterpret_cast<nvencsim_input_t *>(ptr);
+	return (in && in->magic == NVENCSIM_MAGIC_INPUT) ? in : NULL;
+}
+
+static nvencsim_output_t *_output(void *ptr)
+{
+	nvencsim_output_t *out = reinterpret_cast<nvencsim_output_t *>(ptr);
+	return (out && out->magic == NVENCSIM_MAGIC_OUTPUT) ? out : NULL;
+}
+
+static NVENCSTATUS NVENCAPI _sim_LockInputBuffer(void *encoder, NV_ENC_LOCK_INPUT_BUFFER *lockInputBufferParams)
+{
+	if (!_session(encoder))     return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!lockInputBufferParams) return NV_ENC_ERR_INVALID_PTR;
+
+	nvencsim_input_t *in = _input(lockInputBufferParams->inputBuffer);
+	if (!in || !in->data)
+		return NV_ENC_ERR_INVALID_PTR;
+
+	in->t_lock = NvQueryPerformanceMicrosecs();
+	lockInputBufferParams->bufferDataPtr = in->data;
+	lockInputBufferParams->pitch         = in->pitch;
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_UnlockInputBuffer(void *encoder, NV_ENC_INPUT_PTR inputBuffer)
+{
+	if (!_session(encoder))
+		return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+
+	nvencsim_input_t *in = _input(inputBuffer);
+	if (!in)
+		return NV_ENC_ERR_INVALID_PTR;
+
+	in->t_unlock = NvQueryPerformanceMicrosecs();
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_EncodePicture(void *encoder, NV_ENC_PIC_PARAMS *encodePicParams)
+{
+	nvencsim_session_t *s = _session(encoder);
+	if (!s)                return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!encodePicParams)  return NV_ENC_ERR_INVALID_PTR;
+	if (!s->initialized)   return NV_ENC_ERR_ENCODER_NOT_INITIALIZED;
+
+	const double t_submit = NvQueryPerformanceMicrosecs();
+	NVENCSTATUS nvStatus  = NV_ENC_SUCCESS;
+
+	if (encodePicParams->encodePicFlags & NV_ENC_PIC_FLAG_EOS) {
+		// drain: held B-pictures are coded as P, then the EOS-event follows the last picture
+		nvStatus = _flush_held(s);
+
+		nvencsim_job_t job;
+		memset( (void *)&job, 0, sizeof(job) );
+		job.completionEvent = encodePicParams->completionEvent;
+		s->engine->Submit(job);
+		return nvStatus;
+	}
+
+	nvencsim_input_t  *in  = _input(encodePicParams->inputBuffer);
+	nvencsim_output_t *out = _output(encodePicParams->outputBitstream);
+	if (!in || !out)
+		return NV_ENC_ERR_INVALID_PTR;
+
+	out->done->Reset();
+	nvencsim_pending_t pending = { out, encodePicParams->completionEvent };
+	if (!s->pending.Add(pending, 0))
+		return NV_ENC_ERR_ENCODER_BUSY;
+
+	{
+		CNvAutoMutex lock(_mutex());
+		if (++g_in_flight > g_stats.max_in_flight)
+			g_stats.max_in_flight = g_in_flight;
+	}
+
+	nvencsim_held_t pic;
+	pic.input       = in;
+	pic.timestamp   = encodePicParams->inputTimeStamp;
+	pic.frame_idx   = s->frame_count;
+	pic.t_lock_in   = in->t_lock;
+	pic.t_unlock_in = in->t_unlock;
+	pic.t_submit    = t_submit;
+
+	if (!s->init.enablePTD) {
+		// client decides the picture-type, pictures are coded in submission-order
+		const NV_ENC_PIC_TYPE pic_type = (encodePicParams->encodePicFlags & NV_ENC_PIC_FLAG_FORCEIDR) ?
+			NV_ENC_PIC_TYPE_IDR : encodePicParams->pictureType;
+		++s->frame_count;
+		return _queue_picture(s, pic, pic_type);
+	}
+
+	const NV_ENC_PIC_TYPE pic_type = _decide_pic_type(s, encodePicParams->encodePicFlags);
+	if (pic_type == NV_ENC_PIC_TYPE_IDR) {
+		nvStatus = _flush_held(s); // an IDR closes the GOP: nothing may reference across it
+		s->idr_frame = s->frame_count;
+	}
+	++s->frame_count;
+
+	if (pic_type == NV_ENC_PIC_TYPE_B) {
+		return s->held.Add(pic, 0) ? NV_ENC_ERR_NEED_MORE_INPUT : NV_ENC_ERR_ENCODER_BUSY;
+	}
+
+	// anchor first, then the B-pictures which reference it
+	if (nvStatus == NV_ENC_SUCCESS)
+		nvStatus = _queue_picture(s, pic, pic_type);
+	nvencsim_held_t held_pic;
+	while (nvStatus == NV_ENC_SUCCESS && s->held.Remove(held_pic, 0))
+		nvStatus = _queue_picture(s, held_pic, NV_ENC_PIC_TYPE_B);
+	return nvStatus;
+}
+
+static NVENCSTATUS NVENCAPI _sim_LockBitstream(void *encoder, NV_ENC_LOCK_BITSTREAM *lockBitstreamBufferParams)
+{
+	if (!_session(encoder))         return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!lockBitstreamBufferParams) return NV_ENC_ERR_INVALID_PTR;
+
+	nvencsim_output_t *out = _output(lockBitstreamBufferParams->outputBitstream);
+	if (!out)
+		return NV_ENC_ERR_INVALID_PTR;
+
+	if (lockBitstreamBufferParams->doNotWait) {
+		if (!out->done->Wait(0))
+			return NV_ENC_ERR_LOCK_BUSY;
+	}
+	else
+		out->done->Wait((U32)INvThreading::NV_TIMEOUT_INFINITE);
+
+	out->t_lock = NvQueryPerformanceMicrosecs();
+
+	NV_ENC_LOCK_BITSTREAM &p = *lockBitstreamBufferParams;
+	p.frameIdx             = out->frame_idx;
+	p.hwEncodeStatus       = 0;
+	p.numSlices            = 1;
+	p.bitstreamSizeInBytes = out->size;
+	p.outputTimeStamp      = out->timestamp;
+	p.outputDuration       = 0;
+	p.bitstreamBufferPtr   = out->data;
+	p.pictureType          = out->pic_type;
+	p.pictureStruct        = NV_ENC_PIC_STRUCT_FRAME;
+	p.frameAvgQP           = 25;
+	p.frameSatd            = 0;
+	if (p.sliceOffsets)
+		p.sliceOffsets[0] = 0;
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_UnlockBitstream(void *encoder, NV_ENC_OUTPUT_PTR bitstreamBuffer)
+{
+	if (!_session(encoder))
+		return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+
+	nvencsim_output_t *out = _output(bitstreamBuffer);
+	if (!out)
+		return NV_ENC_ERR_INVALID_PTR;
+
+	const double t_unlock = NvQueryPerformanceMicrosecs();
+
+	CNvAutoMutex lock(_mutex());
+	if (g_in_flight)
+		--g_in_flight;
+	g_stats.frames++;
+	g_stats.bytes += out->size;
+	if (out->t_lock_in > 0.0 && out->t_unlock_in >= out->t_lock_in) {
+		g_stats.convert_us += out->t_unlock_in - out->t_lock_in;
+		g_stats.submit_us  += out->t_submit    - out->t_unlock_in;
+	}
+	g_stats.queue_us  += out->t_start - out->t_submit;
+	g_stats.encode_us += out->t_done  - out->t_start;
+	g_stats.drain_us  += out->t_lock  - out->t_done;
+	g_stats.write_us  += t_unlock     - out->t_lock;
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_GetEncodeStats(void *encoder, NV_ENC_STAT *encodeStats)
+{
+	if (!_session(encoder)) return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!encodeStats)       return NV_ENC_ERR_INVALID_PTR;
+
+	nvencsim_output_t *out = _output(encodeStats->outputBitStream);
+	if (!out)
+		return NV_ENC_ERR_INVALID_PTR;
+
+	out->done->Wait((U32)INvThreading::NV_TIMEOUT_INFINITE);
+	encodeStats->bitStreamSize       = out->size;
+	encodeStats->picType             = out->pic_type;
+	encodeStats->lastValidByteOffset = out->size;
+	encodeStats->sliceOffsets[0]     = 0;
+	encodeStats->picIdx              = out->frame_idx;
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_GetSequenceParams(void *encoder, NV_ENC_SEQUENCE_PARAM_PAYLOAD *sequenceParamPayload)
+{
+	nvencsim_session_t *s = _session(encoder);
+	if (!s)                    return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!sequenceParamPayload || !sequenceParamPayload->spsppsBuffer || !sequenceParamPayload->outSPSPPSPayloadSize)
+		return NV_ENC_ERR_INVALID_PTR;
+
+	uint8_t  headers[256];
+	uint32_t n = _write_headers(headers, _is_hevc(s), NV_ENC_PIC_TYPE_IDR);
+	n -= _is_hevc(s) ? 6 : 5; // without the slice NAL-unit
+	if (n > sequenceParamPayload->inBufferSize)
+		return NV_ENC_ERR_NOT_ENOUGH_BUFFER;
+
+	memcpy(sequenceParamPayload->spsppsBuffer, headers, n);
+	*sequenceParamPayload->outSPSPPSPayloadSize = n;
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_RegisterAsyncEvent(void *encoder, NV_ENC_EVENT_PARAMS *eventParams)
+{
+	if (!_session(encoder)) return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!eventParams)       return NV_ENC_ERR_INVALID_PTR;
+	return NV_ENC_SUCCESS; // any event-handle may be passed to nvEncEncodePicture()
+}
+
+static NVENCSTATUS NVENCAPI _sim_UnregisterAsyncEvent(void *encoder, NV_ENC_EVENT_PARAMS *eventParams)
+{
+	return _sim_RegisterAsyncEvent(encoder, eventParams);
+}
+
+static NVENCSTATUS NVENCAPI _sim_RegisterResource(void *encoder, NV_ENC_REGISTER_RESOURCE *registerResParams)
+{
+	nvencsim_session_t *s = _session(encoder);
+	if (!s)                 return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!registerResParams) return NV_ENC_ERR_INVALID_PTR;
+
+	nvencsim_resource_t *r = new nvencsim_resource_t;
+	memset( (void *)r, 0, sizeof(*r) );
+	r->magic         = NVENCSIM_MAGIC_RESOURCE;
+	r->mapped.magic  = NVENCSIM_MAGIC_INPUT;
+	r->mapped.width  = registerResParams->width;
+	r->mapped.height = registerResParams->height;
+	r->mapped.pitch  = registerResParams->pitch;
+	r->mapped.format = registerResParams->bufferFormat;
+	r->mapped.data   = NULL; // device memory: never touched by the emulation
+
+	s->resources.push_back(r);
+	registerResParams->registeredResource = r;
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_UnregisterResource(void *encoder, NV_ENC_REGISTERED_PTR registeredRes)
+{
+	nvencsim_session_t *s = _session(encoder);
+	if (!s)
+		return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+
+	for (std::vector<nvencsim_resource_t *>::iterator it = s->resources.begin(); it != s->resources.end(); ++it) {
+		if (*it == registeredRes) {
+			(*it)->magic = 0;
+			delete *it;
+			s->resources.erase(it);
+			return NV_ENC_SUCCESS;
+		}
+	}
+	return NV_ENC_ERR_RESOURCE_NOT_REGISTERED;
+}
+
+static NVENCSTATUS NVENCAPI _sim_MapInputResource(void *encoder, NV_ENC_MAP_INPUT_RESOURCE *mapInputResParams)
+{
+	if (!_session(encoder)) return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	if (!mapInputResParams) return NV_ENC_ERR_INVALID_PTR;
+
+	nvencsim_resource_t *r = reinterpret_cast<nvencsim_resource_t *>(mapInputResParams->registeredResource);
+	if (!r || r->magic != NVENCSIM_MAGIC_RESOURCE)
+		return NV_ENC_ERR_RESOURCE_NOT_REGISTERED;
+
+	mapInputResParams->mappedResource  = &r->mapped;
+	mapInputResParams->mappedBufferFmt = r->mapped.format;
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_UnmapInputResource(void *encoder, NV_ENC_INPUT_PTR mappedInputBuffer)
+{
+	if (!_session(encoder))
+		return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+	return _input(mappedInputBuffer) ? NV_ENC_SUCCESS : NV_ENC_ERR_RESOURCE_NOT_MAPPED;
+}
+
+static NVENCSTATUS NVENCAPI _sim_DestroyEncoder(void *encoder)
+{
+	nvencsim_session_t *s = _session(encoder);
+	if (!s)
+		return NV_ENC_ERR_INVALID_ENCODERDEVICE;
+
+	if (s->engine) {
+		s->engine->ThreadQuit();
+		delete s->engine;
+		s->engine = NULL;
+	}
+
+	{
+		CNvAutoMutex lock(_mutex());
+		g_in_flight = 0;
+	}
+
+	for (size_t i = 0; i < s->inputs.size(); ++i)
+		_free_input(s->inputs[i]);
+	for (size_t i = 0; i < s->outputs.size(); ++i)
+		_free_output(s->outputs[i]);
+	for (size_t i = 0; i < s->resources.size(); ++i) {
+		s->resources[i]->magic = 0;
+		delete s->resources[i];
+	}
+
+	s->magic = 0;
+	delete s;
+	return NV_ENC_SUCCESS;
+}
+
+static NVENCSTATUS NVENCAPI _sim_InvalidateRefFrames(void *encoder, uint64_t invalidRefFrameTimeStamp)
+{
+	(void)invalidRefFrameTimeStamp;
+	return _session(encoder) ? NV_ENC_ERR_UNIMPLEMENTED : NV_ENC_ERR_INVALID_ENCODERDEVICE;
+}
+
+static NVENCSTATUS NVENCAPI _sim_CreateMVBuffer(void *encoder, NV_ENC_CREATE_MV_BUFFER *createMVBufferParams)
+{
+	(void)createMVBufferParams;
+	return _session(encoder) ? NV_ENC_ERR_UNIMPLEMENTED : NV_ENC_ERR_INVALID_ENCODERDEVICE;
+}
+
+static NVENCSTATUS NVENCAPI _sim_DestroyMVBuffer(void *encoder, NV_ENC_OUTPUT_PTR MVBuffer)
+{
+	(void)MVBuffer;
+	return _session(encoder) ? NV_ENC_ERR_UNIMPLEMENTED : NV_ENC_ERR_INVALID_ENCODERDEVICE;
+}
+
+static NVENCSTATUS NVENCAPI _sim_RunMotionEstimationOnly(void *encoder, NV_ENC_MEONLY_PARAMS *MEOnlyParams)
+{
+	(void)MEOnlyParams;
+	return _session(encoder) ? NV_ENC_ERR_UNIMPLEMENTED : NV_ENC_ERR_INVALID_ENCODERDEVICE;
+}
+
+NVENCSTATUS NVENCAPI NvEncodeAPICreateInstance_sim(NV_ENCODE_API_FUNCTION_LIST *functionList)
+{
+	if (!functionList)
+		return NV_ENC_ERR_INVALID_PTR;
+	if (functionList->version != NV_ENCODE_API_FUNCTION_LIST_VER)
+		return NV_ENC_ERR_INVALID_VERSION;
+
+	NvEncSim_ResetStats(); // (also constructs the mutex, before the engine-threads exist)
+
+	functionList->nvEncOpenEncodeSession         = _sim_OpenEncodeSession;
+	functionList->nvEncGetEncodeGUIDCount        = _sim_GetEncodeGUIDCount;
+	functionList->nvEncGetEncodeProfileGUIDCount = _sim_GetEncodeProfileGUIDCount;
+	functionList->nvEncGetEncodeProfileGUIDs     = _sim_GetEncodeProfileGUIDs;
+	functionList->nvEncGetEncodeGUIDs            = _sim_GetEncodeGUIDs;
+	functionList->nvEncGetInputFormatCount       = _sim_GetInputFormatCount;
+	functionList->nvEncGetInputFormats           = _sim_GetInputFormats;
+	functionList->nvEncGetEncodeCaps             = _sim_GetEncodeCaps;
+	functionList->nvEncGetEncodePresetCount      = _sim_GetEncodePresetCount;
+	functionList->nvEncGetEncodePresetGUIDs      = _sim_GetEncodePresetGUIDs;
+	functionList->nvEncGetEncodePresetConfig     = _sim_GetEncodePresetConfig;
+	functionList->nvEncInitializeEncoder         = _sim_InitializeEncoder;
+	functionList->nvEncCreateInputBuffer         = _sim_CreateInputBuffer;
+	functionList->nvEncDestroyInputBuffer        = _sim_DestroyInputBuffer;
+	functionList->nvEncCreateBitstreamBuffer     = _sim_CreateBitstreamBuffer;
+	functionList->nvEncDestroyBitstreamBuffer    = _sim_DestroyBitstreamBuffer;
+	functionList->nvEncEncodePicture             = _sim_EncodePicture;
+	functionList->nvEncLockBitstream             = _sim_LockBitstream;
+	functionList->nvEncUnlockBitstream           = _sim_UnlockBitstream;
+	functionList->nvEncLockInputBuffer           = _sim_LockInputBuffer;
+	functionList->nvEncUnlockInputBuffer         = _sim_UnlockInputBuffer;
+	functionList->nvEncGetEncodeStats            = _sim_GetEncodeStats;
+	functionList->nvEncGetSequenceParams         = _sim_GetSequenceParams;
+	functionList->nvEncRegisterAsyncEvent        = _sim_RegisterAsyncEvent;
+	functionList->nvEncUnregisterAsyncEvent      = _sim_UnregisterAsyncEvent;
+	functionList->nvEncMapInputResource          = _sim_MapInputResource;
+	functionList->nvEncUnmapInputResource        = _sim_UnmapInputResource;
+	functionList->nvEncDestroyEncoder            = _sim_DestroyEncoder;
+	functionList->nvEncInvalidateRefFrames       = _sim_InvalidateRefFrames;
+	functionList->nvEncOpenEncodeSessionEx       = _sim_OpenEncodeSessionEx;
+	functionList->nvEncRegisterResource          = _sim_RegisterResource;
+	functionList->nvEncUnregisterResource        = _sim_UnregisterResource;
+	functionList->nvEncReconfigureEncoder        = _sim_ReconfigureEncoder;
+	functionList->nvEncCreateMVBuffer            = _sim_CreateMVBuffer;
+	functionList->nvEncDestroyMVBuffer           = _sim_DestroyMVBuffer;
+	functionList->nvEncRunMotionEstimationOnly   = _sim_RunMotionEstimationOnly;
+	return NV_ENC_SUCCESS;
+}
@@ -0,0 +1,300 @@
+#include <cstring>   // memset()
+#include <new>       // std::nothrow
+
+#include "cnvenctelemetry.h"
+
+CNvEncTelemetry::CNvEncTelemetry()
+:	m_ring(NULL)
+,	m_capacity(0)
+,	m_written(0)
+,	m_t0_us(0.0)
+,	m_last_us(0.0)
+,	m_window(0)
+,	m_window_bytes(0)
+,	m_fps(0.0)
+,	m_gop_frames(0)
+{
+	memset(&m_summary, 0, sizeof(m_summary));
+}
+
+CNvEncTelemetry::~CNvEncTelemetry()
+{
+	delete [] m_ring;
+}
+
+bool CNvEncTelemetry::Reset(
+	const uint32_t fps_num,
+	const uint32_t fps_den,
+	const uint32_t target_bps,
+	const uint32_t capacity
+)
+{
+	uint32_t ring_size = TELEMETRY_MIN_RECORDS;
+	while (ring_size < capacity && ring_size < (1u << 30))
+		ring_size <<= 1;
+
+	if (ring_size != m_capacity) {
+		delete [] m_ring;
+		m_ring = new (std::nothrow) nvenc_frame_record_t[ring_size];
+		m_capacity = m_ring ? ring_size : 0;
+	}
+	m_written.store(0, std::memory_order_release);
+
+	m_t0_us   = 0.0;
+	m_last_us = 0.0;
+	m_fps     = (fps_num && fps_den) ? static_cast<double>(fps_num) / static_cast<double>(fps_den) : 0.0;
+	m_window  = 0;
+	if (m_fps > 0.0) {
+		m_window = static_cast<uint32_t>(m_fps + 0.5);
+		if (m_window < 1)
+			m_window = 1;
+		if (m_window > TELEMETRY_MIN_RECORDS / 2)
+			m_window = TELEMETRY_MIN_RECORDS / 2;
+	}
+	m_window_bytes = 0;
+	m_gop_frames   = 0;
+
+	memset(&m_summary, 0, sizeof(m_summary));
+	m_summary.target_bps      = target_bps;
+	m_summary.bitrate_bin_bps = target_bps >= 8 ? target_bps / 8 : 4000000; // constQP: 4 Mbps bins
+
+	return m_ring != NULL;
+}
+
+void CNvEncTelemetry::Record(nvenc_frame_record_t &rec)
+{
+	nvenc_telemetry_summary_t &s = m_summary;
+	const uint64_t n = m_written.load(std::memory_order_relaxed);
+
+	if (n == 0) {
+		m_t0_us   = rec.time_us;
+		m_last_us = rec.time_us;
+	}
+	rec.frame = static_cast<uint32_t>(n);
+
+	// throughput: the gap since the previous frame was written
+	const double interval_us = rec.time_us - m_last_us;
+	m_last_us    = rec.time_us;
+	rec.time_us -= m_t0_us;
+	if (n > 0) {
+		uint32_t bin = 0;
+		for (uint64_t v = static_cast<uint64_t>(interval_us); v > 1 && bin < TELEMETRY_INTERVAL_BINS - 1; v >>= 1)
+			++bin;
+		s.interval_hist[bin]++;
+		if (interval_us > s.max_interval_us) {
+			s.max_interval_us    = interval_us;
+			s.max_interval_frame = rec.frame;
+		}
+	}
+
+	// rolling bitrate: the frame leaving the window is still in the ring (m_window < m_capacity)
+	rec.rolling_kbps = 0.0f;
+	if (m_window && m_ring) {
+		m_window_bytes += rec.bytes;
+		if (n >= m_window)
+			m_window_bytes -= m_ring[(n - m_window) & (m_capacity - 1)].bytes;
+
+		if (n + 1 >= m_window) {
+			const double bps = static_cast<double>(m_window_bytes) * 8.0 * m_fps / m_window;
+			uint32_t bin = static_cast<uint32_t>(bps / s.bitrate_bin_bps);
+			if (bin >= TELEMETRY_BITRATE_BINS)
+				bin = TELEMETRY_BITRATE_BINS - 1;
+			s.bitrate_hist[bin]++;
+			if (bps > s.max_rolling_bps) {
+				s.max_rolling_bps   = bps;
+				s.max_rolling_frame = rec.frame;
+			}
+			rec.rolling_kbps = static_cast<float>(bps / 1000.0);
+		}
+	}
+
+	// GOP-size: an I/IDR-picture closes the previous GOP
+	if (rec.pic_type == 2 || rec.pic_type == 3) { // NV_ENC_PIC_TYPE_I, NV_ENC_PIC_TYPE_IDR
+		if (m_gop_frames)
+			s.gop_hist[m_gop_frames < TELEMETRY_GOP_BINS ? m_gop_frames : TELEMETRY_GOP_BINS - 1]++;
+		m_gop_frames = 0;
+	}
+	++m_gop_frames;
+
+	s.frames++;
+	s.bytes += rec.bytes;
+	s.elapsed_us = rec.time_us;
+	s.pic_types[rec.pic_type < 7 ? rec.pic_type : 7]++;
+	if (rec.avg_qp) {
+		s.qp_total += rec.avg_qp;
+		s.qp_frames++;
+	}
+	s.scene_cuts += rec.scene_cut ? 1 : 0;
+
+	// publish: a reader only looks at records below m_written
+	if (m_ring)
+		m_ring[n & (m_capacity - 1)] = rec;
+	m_written.store(n + 1, std::memory_order_release);
+}
+
+uint64_t CNvEncTelemetry::_first() const
+{
+	const uint64_t written = m_written.load(std::memory_order_acquire);
+	// (the slot of m_written is the one being overwritten next, so it can't be read)
+	return (written >= m_capacity) ? written - m_capacity + 1 : 0;
+}
+
+bool CNvEncTelemetry::_read(const uint64_t index, nvenc_frame_record_t &rec) const
+{
+	rec = m_ring[index & (m_capacity - 1)];
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	// did the output-thread reach this slot (again) while it was being copied?
+	return m_written.load(std::memory_order_relaxed) - index < m_capacity;
+}
+
+uint32_t CNvEncTelemetry::GetRecordCount() const
+{
+	if (!m_ring)
+		return 0;
+	const uint64_t first = _first();
+	return static_cast<uint32_t>(m_written.load(std::memory_order_acquire) - first);
+}
+
+uint32_t CNvEncTelemetry::GetRecords(nvenc_frame_record_t *records, const uint32_t max_records) const
+{
+	if (!m_ring || !records)
+		return 0;
+
+	const uint64_t written = m_written.load(std::memory_order_acquire);
+	uint64_t first = _first();
+	if (written - first > max_records)
+		first = written - max_records;
+
+	uint32_t count = 0;
+	for (uint64_t i = first; i < written; ++i) {
+		if (_read(i, records[count]))
+			++count;
+	}
+	return count;
+}
+
+void CNvEncTelemetry::GetSummary(nvenc_telemetry_summary_t &summary) const
+{
+	summary = m_summary;
+	if (m_gop_frames) // the last GOP
+		summary.gop_hist[m_gop_frames < TELEMETRY_GOP_BINS ? m_gop_frames : TELEMETRY_GOP_BINS - 1]++;
+}
+
+const char *CNvEncTelemetry::PicTypeName(const uint8_t pic_type)
+{
+	static const char *names[] = { "P", "B", "I", "IDR", "BI", "skipped", "intra-refresh", "unknown" };
+	return names[pic_type < 7 ? pic_type : 7];
+}
+
+static void _telemetry_write_record(FILE *fp, const nvenc_frame_record_t &r, const char *fmt)
+{
+	fprintf(fp, fmt,
+		r.frame, r.time_us / 1000.0, static_cast<long long>(r.timestamp), CNvEncTelemetry::PicTypeName(r.pic_type),
+		r.bytes, r.avg_qp, r.rolling_kbps, r.queue_us, r.convert_us, r.submit_us, r.lock_us, r.write_us,
+		r.scene_cut, r.complexity);
+}
+
+bool CNvEncTelemetry::WriteCSV(FILE *fp) const
+{
+	if (!fp)
+		return false;
+
+	fprintf(fp, "frame,time_ms,timestamp,pic_type,bytes,avg_qp,rolling_kbps,queue_us,convert_us,submit_us,lock_us,write_us,scene_cut,complexity\n");
+	if (m_ring) {
+		const uint64_t written = m_written.load(std::memory_order_acquire);
+		nvenc_frame_record_t r;
+		for (uint64_t i = _first(); i < written; ++i) {
+			if (_read(i, r))
+				_telemetry_write_record(fp, r, "%u,%.3f,%lld,%s,%u,%u,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%u,%.3f\n");
+		}
+	}
+	return ferror(fp) == 0;
+}
+
+bool CNvEncTelemetry::WriteJSON(FILE *fp) const
+{
+	if (!fp)
+		return false;
+
+	nvenc_telemetry_summary_t s;
+	GetSummary(s);
+	const double elapsed_s = s.elapsed_us / 1000000.0;
+
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"frames\": %llu,\n", static_cast<unsigned long long>(s.frames));
+	fprintf(fp, "  \"bytes\": %llu,\n", static_cast<unsigned long long>(s.bytes));
+	fprintf(fp, "  \"elapsed_sec\": %.3f,\n", elapsed_s);
+	fprintf(fp, "  \"throughput_fps\": %.2f,\n", elapsed_s > 0.0 ? (s.frames - 1) / elapsed_s : 0.0);
+	fprintf(fp, "  \"frame_rate\": %.3f,\n", m_fps);
+	fprintf(fp, "  \"target_bitrate_bps\": %u,\n", s.target_bps);
+	fprintf(fp, "  \"avg_bitrate_bps\": %.0f,\n", (m_fps > 0.0 && s.frames) ? s.bytes * 8.0 * m_fps / s.frames : 0.0);
+	fprintf(fp, "  \"max_rolling_bitrate_bps\": %.0f,\n", s.max_rolling_bps);
+	fprintf(fp, "  \"max_rolling_bitrate_frame\": %u,\n", s.max_rolling_frame);
+	fprintf(fp, "  \"avg_qp\": %.2f,\n", s.qp_frames ? static_cast<double>(s.qp_total) / s.qp_frames : 0.0);
+	fprintf(fp, "  \"scene_cuts\": %u,\n", s.scene_cuts);
+	fprintf(fp, "  \"max_interval_us\": %.1f,\n", s.max_interval_us);
+	fprintf(fp, "  \"max_interval_frame\": %u,\n", s.max_interval_frame);
+
+	fprintf(fp, "  \"picture_types\": {");
+	for (uint32_t t = 0; t < 8; ++t)
+		fprintf(fp, "%s\"%s\": %u", t ? ", " : " ", PicTypeName(static_cast<uint8_t>(t)), s.pic_types[t]);
+	fprintf(fp, " },\n");
+
+	fprintf(fp, "  \"histograms\": {\n");
+	fprintf(fp, "    \"rolling_bitrate\": { \"bin_bps\": %u, \"counts\": [", s.bitrate_bin_bps);
+	for (uint32_t b = 0; b < TELEMETRY_BITRATE_BINS; ++b)
+		fprintf(fp, "%s%u", b ? ", " : "", s.bitrate_hist[b]);
+	fprintf(fp, "] },\n");
+
+	fprintf(fp, "    \"gop_size\": {");
+	bool first = true;
+	for (uint32_t g = 1; g < TELEMETRY_GOP_BINS; ++g) {
+		if (!s.gop_hist[g])
+			continue;
+		if (g == TELEMETRY_GOP_BINS - 1)
+			fprintf(fp, "%s\"%u+\": %u", first ? " " : ", ", g, s.gop_hist[g]);
+		else
+			fprintf(fp, "%s\"%u\": %u", first ? " " : ", ", g, s.gop_hist[g]);
+		first = false;
+	}
+	fprintf(fp, " },\n");
+
+	fprintf(fp, "    \"output_interval_us\": [");
+	first = true;
+	for (uint32_t b = 0; b < TELEMETRY_INTERVAL_BINS; ++b) {
+		if (!s.interval_hist[b])
+			continue;
+		if (b == TELEMETRY_INTERVAL_BINS - 1)
+			fprintf(fp, "%s{ \"from\": %u, \"to\": null, \"count\": %u }", first ? " " : ", ", 1u << b, s.interval_hist[b]);
+		else
+			fprintf(fp, "%s{ \"from\": %u, \"to\": %u, \"count\": %u }", first ? " " : ", ", b ? 1u << b : 0u, 2u << b, s.interval_hist[b]);
+		first = false;
+	}
+	fprintf(fp, " ]\n");
+	fprintf(fp, "  },\n");
+
+	fprintf(fp, "  \"records\": [\n");
+	if (m_ring) {
+		const uint64_t written = m_written.load(std::memory_order_acquire);
+		nvenc_frame_record_t r;
+		first = true;
+		for (uint64_t i = _first(); i < written; ++i) {
+			if (!_read(i, r))
+				continue;
+			if (!first)
+				fprintf(fp, ",\n");
+			_telemetry_write_record(fp, r,
+				"    { \"frame\": %u, \"time_ms\": %.3f, \"timestamp\": %lld, \"pic_type\": \"%s\", \"bytes\": %u, \"avg_qp\": %u, "
+				"\"rolling_kbps\": %.1f, \"queue_us\": %.1f, \"convert_us\": %.1f, \"submit_us\": %.1f, \"lock_us\": %.1f, \"write_us\": %.1f, "
+				"\"scene_cut\": %u, \"complexity\": %.3f }");
+			first = false;
+		}
+		if (!first)
+			fprintf(fp, "\n");
+	}
+	fprintf(fp, "  ]\n");
+	fprintf(fp, "}\n");
+
+	return ferror(fp) == 0;
+}
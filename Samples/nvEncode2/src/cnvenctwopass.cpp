@@ -0,0 +1,295 @@
+#include <cstring>   // memset()
+#include <cmath>     // pow(), log()
+
+#include "cnvenctwopass.h"
+
+CNvEncTwoPass::CNvEncTwoPass()
+:	m_pass(0)
+,	m_stats(NULL)
+,	m_write_error(false)
+,	m_fps_num(0)
+,	m_fps_den(0)
+,	m_pass1_qp(0)
+,	m_target_bytes(0.0)
+,	m_peak_bps(0)
+,	m_next_frame(0)
+,	m_next_segment(0)
+,	m_coded_bytes(0)
+,	m_planned_done(0)
+,	m_requested_done(0)
+{
+}
+
+bool CNvEncTwoPass::BeginPass1(FILE *stats, const uint32_t fps_num, const uint32_t fps_den, const int qp)
+{
+	End();
+	if (!stats || !fps_num || !fps_den)
+		return false;
+
+	m_stats       = stats;
+	m_fps_num     = fps_num;
+	m_fps_den     = fps_den;
+	m_pass1_qp    = qp;
+	m_write_error = false;
+
+	fprintf(m_stats, "# nvenc two-pass stats (pass 1, constant QP)\n");
+	fprintf(m_stats, "version,%u\n", TWOPASS_STATS_VERSION);
+	fprintf(m_stats, "fps,%u,%u\n", fps_num, fps_den);
+	fprintf(m_stats, "qp,%d\n", qp);
+	fprintf(m_stats, "frame,pic_type,bytes,avg_qp,scene_cut,complexity\n");
+	m_pass = 1;
+	return ferror(m_stats) == 0;
+}
+
+bool CNvEncTwoPass::EndPass1()
+{
+	if (m_pass != 1)
+		return false;
+
+	if (fflush(m_stats) != 0 || ferror(m_stats))
+		m_write_error = true;
+	m_pass  = 0;
+	m_stats = NULL;
+	return !m_write_error;
+}
+
+void CNvEncTwoPass::End()
+{
+	m_pass  = 0;
+	m_stats = NULL;
+}
+
+void CNvEncTwoPass::Record(const nvenc_frame_record_t &rec)
+{
+	const uint32_t frame = (rec.timestamp >= 0) ? static_cast<uint32_t>(rec.timestamp) : rec.frame;
+
+	if (m_pass == 1) {
+		if (fprintf(m_stats, "%u,%u,%u,%u,%u,%.3f\n", frame, rec.pic_type, rec.bytes,
+				rec.avg_qp, rec.scene_cut, rec.complexity) < 0)
+			m_write_error = true;
+	}
+	else if (m_pass == 2) {
+		// (a frame pass 1 didn't see is on plan)
+		double planned = rec.bytes, requested = rec.bytes;
+		if (frame < m_frame_plan.size()) {
+			planned   = m_frame_plan[frame];
+			requested = planned * m_applied[_segment_of(frame)];
+		}
+		m_coded_bytes.fetch_add(rec.bytes, std::memory_order_release);
+		m_planned_done.fetch_add(static_cast<uint64_t>(planned + 0.5), std::memory_order_release);
+		m_requested_done.fetch_add(static_cast<uint64_t>(requested + 0.5), std::memory_order_release);
+	}
+}
+
+bool CNvEncTwoPass::Plan(FILE *stats, const uint32_t target_bps, const uint32_t peak_bps)
+{
+	const uint32_t fps_num = m_fps_num; // (0: accept the stats' frame-rate)
+	const uint32_t fps_den = m_fps_den;
+	std::vector<uint8_t> idr;
+	char line[256];
+	int  version = 0;
+
+	End();
+	m_frame_plan.clear();
+	m_segments.clear();
+	if (!stats || !target_bps || fseek(stats, 0, SEEK_SET) != 0)
+		return false;
+
+	while (fgets(line, sizeof(line), stats)) {
+		unsigned frame, pic_type, bytes, a, b;
+
+		if (line[0] >= '0' && line[0] <= '9') {
+			if (sscanf(line, "%u,%u,%u", &frame, &pic_type, &bytes) != 3)
+				return false;
+			if (frame >= m_frame_plan.size()) {
+				m_frame_plan.resize(frame + 1, 0.0f);
+				idr.resize(frame + 1, 0);
+			}
+			m_frame_plan[frame] += static_cast<float>(bytes);
+			idr[frame] = (pic_type == 3) ? 1 : 0; // NV_ENC_PIC_TYPE_IDR
+		}
+		else if (sscanf(line, "version,%u", &a) == 1)
+			version = static_cast<int>(a);
+		else if (sscanf(line, "fps,%u,%u", &a, &b) == 2) {
+			m_fps_num = a;
+			m_fps_den = b;
+		}
+		else if (sscanf(line, "qp,%u", &a) == 1)
+			m_pass1_qp = static_cast<int>(a);
+	}
+
+	if (version != TWOPASS_STATS_VERSION || m_frame_plan.empty() || !m_fps_num || !m_fps_den ||
+		(fps_num && (static_cast<uint64_t>(fps_num) * m_fps_den != static_cast<uint64_t>(m_fps_num) * fps_den)))
+	{
+		m_frame_plan.clear();
+		return false;
+	}
+
+	const double fps = static_cast<double>(m_fps_num) / m_fps_den;
+	const double target_bpf = target_bps / 8.0 / fps;             // bytes per frame
+	double max_bpf = TWOPASS_MAX_RATE_RATIO * target_bpf;
+	if (peak_bps && peak_bps / 8.0 / fps < max_bpf)
+		max_bpf = peak_bps / 8.0 / fps;
+
+	m_target_bytes = target_bpf * m_frame_plan.size();
+	m_peak_bps     = peak_bps;
+	_segment(idr);
+	_allocate(TWOPASS_MIN_RATE_RATIO * target_bpf, max_bpf);
+
+	// each frame's planned size: its share of the segment's allocation
+	for (size_t s = 0; s < m_segments.size(); ++s) {
+		const twopass_segment_t &seg = m_segments[s];
+		const double scale = seg.pass1_bytes ? seg.target_bytes / seg.pass1_bytes : 0.0;
+		for (uint32_t f = seg.first_frame; f < seg.first_frame + seg.frames; ++f)
+			m_frame_plan[f] = static_cast<float>(seg.pass1_bytes ? m_frame_plan[f] * scale : seg.target_bytes / seg.frames);
+	}
+
+	m_applied.assign(m_segments.size(), 1.0f);
+	m_next_frame   = 0;
+	m_next_segment = 0;
+	m_coded_bytes.store(0, std::memory_order_release);
+	m_planned_done.store(0, std::memory_order_release);
+	m_requested_done.store(0, std::memory_order_release);
+	m_pass = 2;
+	return true;
+}
+
+// _segment_of() - index of the segment which contains frame
+uint32_t CNvEncTwoPass::_segment_of(const uint32_t frame) const
+{
+	uint32_t lo = 0, hi = static_cast<uint32_t>(m_segments.size());
+	while (hi - lo > 1) {
+		const uint32_t mid = (lo + hi) / 2;
+		if (m_segments[mid].first_frame <= frame)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+// _segment() - cut the sequence at the pass-1 IDRs
+void CNvEncTwoPass::_segment(const std::vector<uint8_t> &idr)
+{
+	const double   fps = static_cast<double>(m_fps_num) / m_fps_den;
+	const uint32_t min_frames = static_cast<uint32_t>(TWOPASS_SEGMENT_MIN_SECONDS * fps + 0.5);
+	const uint32_t max_frames = static_cast<uint32_t>(TWOPASS_SEGMENT_MAX_SECONDS * fps + 0.5);
+	twopass_segment_t seg;
+
+	memset(&seg, 0, sizeof(seg));
+	for (uint32_t f = 0; f < m_frame_plan.size(); ++f) {
+		if (seg.frames && ((seg.frames >= min_frames && idr[f]) || seg.frames >= max_frames)) {
+			m_segments.push_back(seg);
+			memset(&seg, 0, sizeof(seg));
+			seg.first_frame = f;
+		}
+		seg.frames++;
+		seg.pass1_bytes += static_cast<uint64_t>(m_frame_plan[f]);
+	}
+	m_segments.push_back(seg);
+}
+
+// _allocate() - share out m_target_bytes: bytes per frame ~ (pass-1 bytes per frame)^qcomp,
+//   within [min_bytes_per_frame, max_bytes_per_frame].  A segment which hits a limit keeps it,
+//   the others share out the rest again.
+void CNvEncTwoPass::_allocate(const double min_bytes_per_frame, const double max_bytes_per_frame)
+{
+	const size_t n = m_segments.size();
+	const double fps = static_cast<double>(m_fps_num) / m_fps_den;
+	std::vector<double> weight(n);
+	std::vector<uint8_t> limited(n, 0);
+
+	for (size_t s = 0; s < n; ++s) {
+		const double bpf = static_cast<double>(m_segments[s].pass1_bytes) / m_segments[s].frames;
+		weight[s] = pow(bpf > 1.0 ? bpf : 1.0, TWOPASS_QCOMP);
+	}
+
+	for (size_t pass = 0; pass <= n; ++pass) {
+		double budget = m_target_bytes;
+		double weights = 0.0;
+		for (size_t s = 0; s < n; ++s) {
+			if (limited[s])
+				budget -= m_segments[s].target_bytes;
+			else
+				weights += weight[s] * m_segments[s].frames;
+		}
+		if (weights <= 0.0)
+			break;
+
+		bool changed = false;
+		const double k = (budget > 0.0 ? budget : 0.0) / weights;
+		for (size_t s = 0; s < n; ++s) {
+			if (limited[s])
+				continue;
+			double bpf = k * weight[s];
+			if (bpf < min_bytes_per_frame || bpf > max_bytes_per_frame) {
+				bpf = (bpf < min_bytes_per_frame) ? min_bytes_per_frame : max_bytes_per_frame;
+				limited[s] = 1;
+				changed = true;
+			}
+			m_segments[s].target_bytes = bpf * m_segments[s].frames;
+		}
+		if (!changed)
+			break;
+	}
+
+	for (size_t s = 0; s < n; ++s) {
+		twopass_segment_t &seg = m_segments[s];
+		seg.avg_bps = static_cast<uint32_t>(seg.target_bytes * 8.0 * fps / seg.frames + 0.5);
+		seg.qp      = _qp_for(static_cast<double>(seg.pass1_bytes), seg.target_bytes);
+	}
+}
+
+// _qp_for() - the QP which codes pass1_bytes (at m_pass1_qp) as target_bytes
+int CNvEncTwoPass::_qp_for(const double pass1_bytes, const double target_bytes) const
+{
+	if (pass1_bytes <= 0.0 || target_bytes <= 0.0)
+		return m_pass1_qp;
+
+	const double qp = m_pass1_qp + TWOPASS_QP_PER_DOUBLING * log(pass1_bytes / target_bytes) / log(2.0);
+	return (qp < 0.0) ? 0 : (qp > 51.0) ? 51 : static_cast<int>(qp + 0.5);
+}
+
+bool CNvEncTwoPass::NextFrame(twopass_rate_t &rate)
+{
+	if (m_pass != 2)
+		return false;
+
+	const uint32_t frame = m_next_frame++;
+	if (m_next_segment >= m_segments.size() || frame != m_segments[m_next_segment].first_frame)
+		return false;
+
+	// feedback: share out the difference between the bytes coded so far and their plan
+	//   over the rest of the sequence, scaled by how closely the encoder followed the
+	//   bitrates it was given (response)
+	const twopass_segment_t &seg = m_segments[m_next_segment];
+	const double coded     = static_cast<double>(m_coded_bytes.load(std::memory_order_acquire));
+	const double planned   = static_cast<double>(m_planned_done.load(std::memory_order_acquire));
+	const double requested = static_cast<double>(m_requested_done.load(std::memory_order_acquire));
+	double response = 1.0;
+	if (coded > 0.0 && requested > 0.0) {
+		response = coded / requested;
+		response = (response < 0.5) ? 0.5 : (response > 2.0) ? 2.0 : response;
+	}
+	double correction = 1.0;
+	if (m_target_bytes - planned > 0.0)
+		correction = (m_target_bytes - coded) / ((m_target_bytes - planned) * response);
+	if (correction < 1.0 - TWOPASS_MAX_CORRECTION)
+		correction = 1.0 - TWOPASS_MAX_CORRECTION;
+	if (correction > 1.0 + TWOPASS_MAX_CORRECTION)
+		correction = 1.0 + TWOPASS_MAX_CORRECTION;
+
+	double avg_bps = seg.avg_bps * correction;
+	if (m_peak_bps && avg_bps > m_peak_bps)
+		avg_bps = m_peak_bps;
+
+	const double qp = seg.qp - TWOPASS_QP_PER_DOUBLING * log(correction) / log(2.0);
+
+	rate.segment    = m_next_segment++;
+	rate.avg_bps    = static_cast<uint32_t>(avg_bps + 0.5);
+	rate.peak_bps   = m_peak_bps;
+	rate.qp         = (qp < 0.0) ? 0 : (qp > 51.0) ? 51 : static_cast<int>(qp + 0.5);
+	rate.correction = seg.avg_bps ? static_cast<float>(avg_bps / seg.avg_bps) : 1.0f;
+	m_applied[rate.segment] = rate.correction;
+	return true;
+}
@@ -58,12 +58,19 @@ public:
 	static bool INVPCID(void) { return CPU_Rep.f_7_EBX_[10]; }
 	static bool RTM(void) { return CPU_Rep.isIntel_ && CPU_Rep.f_7_EBX_[11]; }
 	static bool AVX512F(void) { return CPU_Rep.f_7_EBX_[16]; }
+	static bool AVX512DQ(void) { return CPU_Rep.f_7_EBX_[17]; }
 	static bool RDSEED(void) { return CPU_Rep.f_7_EBX_[18]; }
 	static bool ADX(void) { return CPU_Rep.f_7_EBX_[19]; }
 	static bool AVX512PF(void) { return CPU_Rep.f_7_EBX_[26]; }
 	static bool AVX512ER(void) { return CPU_Rep.f_7_EBX_[27]; }
 	static bool AVX512CD(void) { return CPU_Rep.f_7_EBX_[28]; }
 	static bool SHA(void) { return CPU_Rep.f_7_EBX_[29]; }
+	static bool AVX512BW(void) { return CPU_Rep.f_7_EBX_[30]; }
+	static bool AVX512VL(void) { return CPU_Rep.f_7_EBX_[31]; }
+
+	// OS support: the OS must save/restore the opmask and ZMM registers
+	//    XCR0 bits 1,2 (SSE, AVX state), bits 5,6,7 (opmask, ZMM0-15 upper, ZMM16-31)
+	static bool OS_AVX512(void) { return (CPU_Rep.xcr0_ & 0xE6) == 0xE6; }
 
 	static bool PREFETCHWT1(void) { return CPU_Rep.f_7_ECX_[0]; }
 
@@ -97,6 +104,7 @@ private:
 			f_7_ECX_{ 0 },
 			f_81_ECX_{ 0 },
 			f_81_EDX_{ 0 },
+			xcr0_{ 0 },
 			data_{},
 			extdata_{}
 		{
@@ -144,6 +152,12 @@ private:
 				f_7_ECX_ = data_[7][2];
 			}
 
+			// read the OS-enabled register-state (XCR0), if the OS supports XGETBV
+			if (f_1_ECX_[27])
+			{
+				xcr0_ = _xgetbv(0);
+			}
+
 			// Calling __cpuid with 0x80000000 as the function_id argument
 			// gets the number of the highest valid extended ID.
 			__cpuid(cpui.data(), 0x80000000);
@@ -187,6 +201,7 @@ private:
 		std::bitset<32> f_7_ECX_;
 		std::bitset<32> f_81_ECX_;
 		std::bitset<32> f_81_EDX_;
+		unsigned __int64 xcr0_;
 		std::vector<std::array<int, 4>> data_;
 		std::vector<std::array<int, 4>> extdata_;
 	};
@@ -218,3 +233,10 @@ get_cpuinfo_has_avx2()
 {
 	return InstructionSet::AVX2();
 }
+
+bool
+get_cpuinfo_has_avx512()
+{
+	return InstructionSet::AVX512F() && InstructionSet::AVX512BW() &&
+		InstructionSet::AVX512VL() && InstructionSet::OS_AVX512();
+}
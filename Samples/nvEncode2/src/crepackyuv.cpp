@@ -251,9 +251,15 @@ CRepackyuv::CRepackyuv()
 	m_cpu_has_ssse3 = get_cpuinfo_has_ssse3();
 	m_cpu_has_avx   = get_cpuinfo_has_avx();
 	m_cpu_has_avx2  = get_cpuinfo_has_avx2();
+#ifdef CREPACKYUV_ENABLE_AVX512
+	m_cpu_has_avx512= get_cpuinfo_has_avx512();
+#else
+	m_cpu_has_avx512= false; // compiler doesn't support AVX-512 intrinsics
+#endif
 
 	m_allow_avx  = m_cpu_has_avx;
 	m_allow_avx2 = m_cpu_has_avx2;
+	m_allow_avx512 = m_cpu_has_avx512;
 
 	_avx_init(); // setup constants/masks for AVX-versions of functions
 }
@@ -643,6 +649,19 @@ void CRepackyuv::convert_YUV420toNV12(
 	//  (same value is used for both Y-plane and UV-plane)
 	)
 {
+#ifdef CREPACKYUV_ENABLE_AVX512
+	if (m_cpu_has_avx512 && m_allow_avx512) {
+		// AVX-512 version has no alignment requirements
+		_convert_YUV420toNV12_avx512(
+			width, height,
+			src_yuv, src_stride,
+			dest_nv12_luma, dest_nv12_chroma,
+			dstStride
+		);
+		return;
+	}
+#endif // CREPACKYUV_ENABLE_AVX512
+
 	bool is_xmm_aligned = true;   // are addresses 16-byte aligned?
 
 	// Check address-alignment of source_yuv plane(s)
@@ -1075,6 +1094,18 @@ void CRepackyuv::convert_YUV444toY444( // convert packed-pixel(Y444) into planar
 	unsigned char  dest_v[]    // pointer to output V-plane
 	)
 {
+#ifdef CREPACKYUV_ENABLE_AVX512
+	if (m_cpu_has_avx512 && m_allow_avx512) {
+		// AVX-512 version has no alignment requirements
+		_convert_YUV444toY444_avx512(
+			width, height,
+			src_stride, src_444,
+			dst_stride, dest_y, dest_u, dest_v
+		);
+		return;
+	}
+#endif // CREPACKYUV_ENABLE_AVX512
+
 	bool is_xmm_aligned = m_cpu_has_ssse3;// are addresses 16-byte aligned?
 
 	// Check address-alignment of source_yuv plane(s)
@@ -1311,6 +1342,255 @@ void CRepackyuv::_convert_YUV444toY444_avx2( // convert packed-pixel(Y444) into
 	} // for y
 }
 
+void CRepackyuv::convert_VUYAtoNV12(  // convert packed-pixel(VUYA/VUYX 4:4:4) into 2-plane(NV12)
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance: #pixels from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_444[],  // pointer to input (VUYA packed) surface [1 pixel per 32bits]
+	const uint32_t dst_stride, // distance: #pixels from scanline(x) to scanline(x+1) [units of uint8_t]
+	unsigned char  dest_y[],   // pointer to output Y-plane
+	unsigned char  dest_uv[]   // pointer to output UV-plane
+	)
+{
+	bool is_xmm_aligned = m_cpu_has_ssse3;// are addresses 16-byte aligned?
+
+	// Check address-alignment of all planes
+	if (reinterpret_cast<uint64_t>(src_444) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_y) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_uv) & 0xF)
+		is_xmm_aligned = false;
+
+	if (src_stride & 0xF)
+		is_xmm_aligned = false;
+	else if (dst_stride & 0xF)
+		is_xmm_aligned = false;
+
+	if (height & 0x1)  // must have an even# scanlines
+		is_xmm_aligned = false;
+
+	bool is_avx256_aligned = is_xmm_aligned && m_cpu_has_avx2 && m_allow_avx2;
+	if (is_avx256_aligned) {
+		if (reinterpret_cast<uint64_t>(src_444) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_y) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_uv) & 0x1F)
+			is_avx256_aligned = false;
+
+		if (src_stride & 0x1F)
+			is_avx256_aligned = false;
+		else if (dst_stride & 0x1F)
+			is_avx256_aligned = false;
+	}
+
+	// The SIMD versions convert whole blocks (AVX2: 32 pixels, SSSE3: 16 pixels),
+	// the rest of each scanline is converted by the non-SSE version.
+	uint32_t x_begin = 0;
+	if (is_avx256_aligned && width >= 32) {
+		x_begin = width & ~0x1F;
+		_convert_VUYAtoNV12_avx2( // AVX2 version of converter
+			x_begin, height,
+			src_stride >> 5, // src stride (units of _m256i)
+			reinterpret_cast<__m256i const *>(src_444),
+			dst_stride >> 5, // dst stride (units of _m256i)
+			reinterpret_cast<__m256i *>(dest_y),  // output Y
+			reinterpret_cast<__m256i *>(dest_uv)  // output UV
+		);
+	}
+	else if (is_xmm_aligned && width >= 16) {
+		x_begin = width & ~0xF;
+		_convert_VUYAtoNV12_ssse3( // SSSE3 version of converter
+			x_begin, height,
+			src_stride >> 4, // src stride (units of _m128i)
+			reinterpret_cast<__m128i const *>(src_444),
+			dst_stride >> 4, // dst stride (units of _m128i)
+			reinterpret_cast<__m128i *>(dest_y),  // output Y
+			reinterpret_cast<__m128i *>(dest_uv)  // output UV
+		);
+	}
+
+	if (x_begin < width)
+		_convert_VUYAtoNV12(  // non-SSE version (slow)
+			x_begin, width, height,
+			src_stride >> 2, // src stride (units of uint32_t)
+			reinterpret_cast<uint32_t const *>(src_444),
+			dst_stride,
+			dest_y,   // output Y
+			dest_uv   // output UV
+		);
+}
+
+void CRepackyuv::_convert_VUYAtoNV12( // convert packed-pixel(VUYA) into 2-plane(NV12), columns x_begin .. width-1
+	const uint32_t x_begin,    // first column (#pixels): must be even#
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance: #pixels from scanline(x) to scanline(x+1) [units of uint32_t]
+	const uint32_t src_444[],  // pointer to input (VUYA packed) surface
+	const uint32_t dst_stride, // distance: #pixels from scanline(x) to scanline(x+1) [units of uint8_t]
+	unsigned char  dest_y[],   // pointer to output Y-plane
+	unsigned char  dest_uv[]   // pointer to output UV-plane
+	)
+{
+	// input format: VUYA (or VUYX), 32 bits per pixel
+	//  Byte# -->
+	//     0    1    2    3    4    5    6    7
+	//    ____ ____ ____ ____ ____ ____ ____ ____
+	//   | V0 | U0 | Y0 | A0 | V1 | U1 | Y1 | A1 | ...
+	//
+	// The chroma of each 2x2 block of pixels is averaged (box filter).
+	// Like the YUV444 converter, this flips the image vertically.
+	for (uint32_t y = 0; y < height; y += 2) {
+		// (an odd# of scanlines: the last one is its own pair)
+		const uint32_t yp1 = (y + 1 < height) ? y + 1 : y;
+		const uint32_t *src_row[2] = { src_444 + src_stride * y, src_444 + src_stride * yp1 };
+		unsigned char *dst_row_y[2] = {
+			dest_y + dst_stride * (height - 1 - y),  // scanline (#y)
+			dest_y + dst_stride * (height - 1 - yp1) // scanline (#y+1)
+		};
+		unsigned char *dst_row_uv = dest_uv + dst_stride * ((height - 1 - y) >> 1);
+
+		for (uint32_t x = x_begin; x < width; x += 2) {
+			// (an odd# of pixels: the last one is its own pair)
+			const uint32_t xp1 = (x + 1 < width) ? x + 1 : x;
+			uint32_t u = 2, v = 2; // rounding offset for div/4 operation
+
+			for (uint32_t i = 0; i < 2; ++i) {
+				const uint32_t p0 = src_row[i][x];
+				const uint32_t p1 = src_row[i][xp1];
+
+				dst_row_y[i][x] = static_cast<unsigned char>(p0 >> 16);
+				dst_row_y[i][xp1] = static_cast<unsigned char>(p1 >> 16);
+
+				u += ((p0 >> 8) & 0xFF) + ((p1 >> 8) & 0xFF);
+				v += (p0 & 0xFF) + (p1 & 0xFF);
+			}
+
+			dst_row_uv[x] = static_cast<unsigned char>(u >> 2);
+			dst_row_uv[x + 1] = static_cast<unsigned char>(v >> 2);
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_VUYAtoNV12_ssse3( // convert packed-pixel(VUYA) into 2-plane(NV12)
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 16
+	const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	const __m128i  src_444[],  // pointer to input (VUYA packed) surface
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	__m128i dest_y[],   // pointer to output Y-plane
+	__m128i dest_uv[]   // pointer to output UV-plane
+	)
+{
+	// Each source register holds 4 pixels: V0 U0 Y0 A0 | V1 U1 Y1 A1 | ...
+	//   shuffle -> U0 U1 V0 V1 U2 U3 V2 V3 | Y0 Y1 Y2 Y3 | 0 0 0 0
+	//   maddubs (x1 for bytes 0..7) -> 16-bit  U0+U1  V0+V1  U2+U3  V2+V3  0 0 0 0
+	const __m128i shuffle_vuya = _mm_setr_epi8(1, 5, 0, 4, 9, 13, 8, 12, 2, 6, 10, 14, -1, -1, -1, -1);
+	const __m128i ones_uv = _mm_setr_epi8(1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i round_uv = _mm_set1_epi16(2);// rounding offset for div/4 operation
+
+	__m128i s[2][4], uv16[2][2];
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		const __m128i *src_ptr = src_444 + (y * src_stride); // scanline (scanline #y)
+		const __m128i *src_ptr_yp1 = src_ptr + src_stride;   // scanline (scanline #y+1)
+
+		// Destination pointers (the image is flipped vertically)
+		__m128i *dst_ptr_y = dest_y + (height - 1 - y) * dst_stride;// scanline (#y)
+		__m128i *dst_ptr_y_yp1 = dst_ptr_y - dst_stride;            // scanline (#y+1)
+		__m128i *dst_ptr_uv = dest_uv + ((height - 1 - y) >> 1) * dst_stride;
+
+		for (uint32_t x = 0; x < width; x += 16) {
+			// In each iteration, process 16 source pixels (in 4 groups of 4)
+			//   from scanline #y and #(y+1)
+			for (uint32_t i = 0; i < 4; ++i) {
+				s[0][i] = _mm_shuffle_epi8(_mm_load_si128(src_ptr++), shuffle_vuya);
+				s[1][i] = _mm_shuffle_epi8(_mm_load_si128(src_ptr_yp1++), shuffle_vuya);
+			}
+
+			// Luma: gather dword#2 of each group -> Y0..Y15
+			for (uint32_t j = 0; j < 2; ++j) {
+				_mm_store_si128(j ? dst_ptr_y_yp1++ : dst_ptr_y++, _mm_unpacklo_epi64(
+					_mm_unpackhi_epi32(s[j][0], s[j][1]),
+					_mm_unpackhi_epi32(s[j][2], s[j][3])));
+			}
+
+			// Chroma: sum the horizontal pairs, then scanline#(y) and (y+1)
+			for (uint32_t j = 0; j < 2; ++j) {
+				uv16[0][j] = _mm_unpacklo_epi64(
+					_mm_maddubs_epi16(s[0][2 * j], ones_uv), _mm_maddubs_epi16(s[0][2 * j + 1], ones_uv));
+				uv16[1][j] = _mm_unpacklo_epi64(
+					_mm_maddubs_epi16(s[1][2 * j], ones_uv), _mm_maddubs_epi16(s[1][2 * j + 1], ones_uv));
+				uv16[0][j] = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(uv16[0][j], uv16[1][j]), round_uv), 2);
+			}
+			_mm_store_si128(dst_ptr_uv++, _mm_packus_epi16(uv16[0][0], uv16[0][1]));
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_VUYAtoNV12_avx2( // convert packed-pixel(VUYA) into 2-plane(NV12)
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 32
+	const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	const __m256i  src_444[],  // pointer to input (VUYA packed) surface
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	__m256i dest_y[],   // pointer to output Y-plane
+	__m256i dest_uv[]   // pointer to output UV-plane
+	)
+{
+	// (same as the SSSE3 version, in each 128-bit lane)
+	const __m256i shuffle_vuya = _mm256_setr_epi8(
+		1, 5, 0, 4, 9, 13, 8, 12, 2, 6, 10, 14, -1, -1, -1, -1,
+		1, 5, 0, 4, 9, 13, 8, 12, 2, 6, 10, 14, -1, -1, -1, -1);
+	const __m256i ones_uv = _mm256_setr_epi8(
+		1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0,
+		1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i round_uv = _mm256_set1_epi16(2);// rounding offset for div/4 operation
+
+	// The unpack/pack ops work per 128-bit lane: the 4-pixel groups come out as
+	//   lane 0: pixels 0-3, 8-11, 16-19, 24-27   lane 1: pixels 4-7, 12-15, 20-23, 28-31
+	const __m256i permc_groups = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+	__m256i s[2][4], uv16[2][2];
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		const __m256i *src_ptr = src_444 + (y * src_stride); // scanline (scanline #y)
+		const __m256i *src_ptr_yp1 = src_ptr + src_stride;   // scanline (scanline #y+1)
+
+		// Destination pointers (the image is flipped vertically)
+		__m256i *dst_ptr_y = dest_y + (height - 1 - y) * dst_stride;// scanline (#y)
+		__m256i *dst_ptr_y_yp1 = dst_ptr_y - dst_stride;            // scanline (#y+1)
+		__m256i *dst_ptr_uv = dest_uv + ((height - 1 - y) >> 1) * dst_stride;
+
+		for (uint32_t x = 0; x < width; x += 32) {
+			// In each iteration, process 32 source pixels (in 4 groups of 8)
+			//   from scanline #y and #(y+1)
+			for (uint32_t i = 0; i < 4; ++i) {
+				s[0][i] = _mm256_shuffle_epi8(_mm256_load_si256(src_ptr++), shuffle_vuya);
+				s[1][i] = _mm256_shuffle_epi8(_mm256_load_si256(src_ptr_yp1++), shuffle_vuya);
+			}
+
+			for (uint32_t j = 0; j < 2; ++j) {
+				_mm256_store_si256(j ? dst_ptr_y_yp1++ : dst_ptr_y++, _mm256_permutevar8x32_epi32(
+					_mm256_unpacklo_epi64(
+						_mm256_unpackhi_epi32(s[j][0], s[j][1]),
+						_mm256_unpackhi_epi32(s[j][2], s[j][3])), permc_groups));
+			}
+
+			for (uint32_t j = 0; j < 2; ++j) {
+				uv16[0][j] = _mm256_unpacklo_epi64(
+					_mm256_maddubs_epi16(s[0][2 * j], ones_uv), _mm256_maddubs_epi16(s[0][2 * j + 1], ones_uv));
+				uv16[1][j] = _mm256_unpacklo_epi64(
+					_mm256_maddubs_epi16(s[1][2 * j], ones_uv), _mm256_maddubs_epi16(s[1][2 * j + 1], ones_uv));
+				uv16[0][j] = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(uv16[0][j], uv16[1][j]), round_uv), 2);
+			}
+			_mm256_store_si256(dst_ptr_uv++, _mm256_permutevar8x32_epi32(
+				_mm256_packus_epi16(uv16[0][0], uv16[0][1]), permc_groups));
+		} // for x
+	} // for y
+}
+
 void CRepackyuv::convert_YUV422toNV12(  // convert packed-pixel(Y422) into 2-plane(NV12)
 	const bool     mode_uyvy,  // chroma-order: true=UYVY, false=YUYV
 	const uint32_t width,      // X-dimension (#pixels)
@@ -1322,6 +1602,19 @@ void CRepackyuv::convert_YUV422toNV12(  // convert packed-pixel(Y422) into 2-pla
 	unsigned char  dest_uv[]   // pointer to output UV-plane
 	)
 {
+#ifdef CREPACKYUV_ENABLE_AVX512
+	if (m_cpu_has_avx512 && m_allow_avx512 && !(height & 0x1) && !(width & 0x1)) {
+		// AVX-512 version has no alignment requirements
+		_convert_YUV422toNV12_avx512(
+			mode_uyvy, // chroma-order: true=UYVY, false=YUYV
+			width, height,
+			src_stride, src_422,
+			dst_stride, dest_y, dest_uv
+		);
+		return;
+	}
+#endif // CREPACKYUV_ENABLE_AVX512
+
 	bool is_xmm_aligned = m_cpu_has_ssse3;// are addresses 16-byte aligned?
 
 	// Check address-alignment of source_yuv plane(s)
@@ -1728,6 +2021,19 @@ void CRepackyuv::convert_RGBFtoY444( // convert packed(RGB f32) into packed(YUV
 	uint8_t dest_v[]    // pointer to output V-plane
 )
 {
+#ifdef CREPACKYUV_ENABLE_AVX512
+	if (m_cpu_has_avx512 && m_allow_avx512) {
+		// AVX-512 version has no alignment requirements
+		_convert_RGBFtoY444_avx512(
+			use_bt709, use_fullscale,
+			width, height,
+			src_stride, src_rgb,
+			dst_stride, dest_y, dest_u, dest_v
+		);
+		return;
+	}
+#endif // CREPACKYUV_ENABLE_AVX512
+
 	bool is_xmm_aligned = m_cpu_has_ssse3;// are addresses 16-byte aligned?
 
 	// Check address-alignment of source_yuv plane(s)
@@ -2311,6 +2617,19 @@ void CRepackyuv::convert_RGBFtoNV12( // convert packed(RGB f32) into packed(YUV
 	uint8_t dest_uv[]   // pointer to output UV-plane
 	)
 {
+#ifdef CREPACKYUV_ENABLE_AVX512
+	if (m_cpu_has_avx512 && m_allow_avx512 && !(height & 0x1) && !(width & 0x1)) {
+		// AVX-512 version has no alignment requirements
+		_convert_RGBFtoNV12_avx512(
+			use_bt709, use_fullscale,
+			width, height,
+			src_stride, src_rgb,
+			dst_stride, dest_y, dest_uv
+		);
+		return;
+	}
+#endif // CREPACKYUV_ENABLE_AVX512
+
 	bool is_xmm_aligned = m_cpu_has_ssse3;// are addresses 16-byte aligned?
 
 	// Check address-alignment of source_yuv plane(s)
@@ -3099,7 +3418,69 @@ bool CRepackyuv::set_cpu_allow_avx2(bool flag) {// sets control-flag, allow_avx2
 	}
 }
 
-void CRepackyuv::_convert_RGBFtoNV12_avx2( // convert packed(RGB f32) into packed(YUV f32)
+bool CRepackyuv::set_cpu_allow_avx512(bool flag) {// sets control-flag, allow_avx512
+
+	if (m_cpu_has_avx512) {
+		m_allow_avx512 = flag;
+		return flag;
+	}
+	else {
+		return false;
+	}
+}
+
+// _avx2_rgbf_to_yuvf(): convert 8 packed RGBf32 pixels into planar Y/U/V (float)
+//
+//   The 4 source registers are transposed (4x4, within each 128-bit lane),
+//   so each output register holds one channel of 8 pixels in the order
+//        pixel# {0, 2, 4, 6 | 1, 3, 5, 7}
+//   (even pixels in the low lane, odd pixels in the high lane.)
+//
+//   The sum is evaluated in the same order as the hadd-based versions
+//        ((c0*p0 + c1*p1) + (c2*p2 + c3*p3))
+//   so the output is bit-identical to the previous (hadd-based) AVX2 kernel.
+//   (The SSSE3/AVX kernels can still differ from AVX2 in the last bit.)
+static inline void _avx2_rgbf_to_yuvf(
+	const __m256 coeff[12], // {Y: c0..c3, U: c0..c3, V: c0..c3}
+	const __m256 src[4],    // 8 RGBf32 pixels (2 pixels per register)
+	__m256 &out_y, __m256 &out_u, __m256 &out_v
+	)
+{
+	const __m256 t0 = _mm256_unpacklo_ps(src[0], src[1]);// c0 c0 c1 c1 {pixels 0,2 | 1,3}
+	const __m256 t1 = _mm256_unpackhi_ps(src[0], src[1]);// c2 c2 c3 c3 {pixels 0,2 | 1,3}
+	const __m256 t2 = _mm256_unpacklo_ps(src[2], src[3]);// c0 c0 c1 c1 {pixels 4,6 | 5,7}
+	const __m256 t3 = _mm256_unpackhi_ps(src[2], src[3]);// c2 c2 c3 c3 {pixels 4,6 | 5,7}
+
+	const __m256 p0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));// channel#0
+	const __m256 p1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));// channel#1
+	const __m256 p2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));// channel#2
+	const __m256 p3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));// channel#3 (alpha)
+
+	out_y = _mm256_add_ps(
+		_mm256_add_ps(_mm256_mul_ps(p0, coeff[0]), _mm256_mul_ps(p1, coeff[1])),
+		_mm256_add_ps(_mm256_mul_ps(p2, coeff[2]), _mm256_mul_ps(p3, coeff[3]))
+	);
+	out_u = _mm256_add_ps(
+		_mm256_add_ps(_mm256_mul_ps(p0, coeff[4]), _mm256_mul_ps(p1, coeff[5])),
+		_mm256_add_ps(_mm256_mul_ps(p2, coeff[6]), _mm256_mul_ps(p3, coeff[7]))
+	);
+	out_v = _mm256_add_ps(
+		_mm256_add_ps(_mm256_mul_ps(p0, coeff[8]), _mm256_mul_ps(p1, coeff[9])),
+		_mm256_add_ps(_mm256_mul_ps(p2, coeff[10]), _mm256_mul_ps(p3, coeff[11]))
+	);
+}
+
+// _convert_RGBFtoNV12_avx2() : fused single-pass converter
+//
+//   Each iteration reads 32 pixels from scanline#y and #(y+1), and produces
+//   32 Y-pixels for each scanline and the 16 interleaved U/V-pairs for the
+//   chroma-row entirely in registers (no intermediate YUV444 buffer, and no
+//   separate chroma extraction pass.)
+//
+//   The output is written with non-temporal (streaming) stores: the NVENC
+//   input surface is only read back by the GPU, so there is no point in
+//   pulling it into the CPU cache (and evicting the source-pixels.)
+void CRepackyuv::_convert_RGBFtoNV12_avx2( // convert packed(RGB f32) into 2-plane(NV12)
 	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
 	const bool     use_fullscale, // true=PC/full scale, false=video(16-235)
 	const uint32_t width,      // X-dimension (#pixels): must be multiple of 16
@@ -3111,248 +3492,2420 @@ void CRepackyuv::_convert_RGBFtoNV12_avx2( // convert packed(RGB f32) into packe
 	__m256i dest_uv[]   // pointer to output UV-plane
 	)
 {
-	const uint32_t width_div_2 = (width + 1) >> 1;
-	const uint32_t width_div_16 = (width + 15) >> 4;
-	const __m256 zero = _mm256_setzero_ps();
 	const __m256 cmatrix_y = get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_Y);
 	const __m256 cmatrix_u = get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_U);
 	const __m256 cmatrix_v = get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_V);
-	
+
+	// broadcast each coefficient to all 8 lanes
+	__m256 coeff[12];
+	for (uint32_t i = 0; i < 4; ++i) {
+		const __m256i idx = _mm256_set1_epi32(i);
+		coeff[i    ] = _mm256_permutevar8x32_ps(cmatrix_y, idx);
+		coeff[i + 4] = _mm256_permutevar8x32_ps(cmatrix_u, idx);
+		coeff[i + 8] = _mm256_permutevar8x32_ps(cmatrix_v, idx);
+	}
+
 	const __m256i offset_y = use_fullscale ?
 		_mm256_setzero_si256() :  // for full-scale video range ( 0..255 )
-		_mm256_set_epi16(16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16);
+		_mm256_set1_epi16(16);
 
 	// The U/V-offset is +128.  Here the regvalue is scaled up by x4 to
-	// compensate for a divide-by-4 operation.
-	const __m256i offset_uv = _mm256_set_epi16(
-		512 + 2, 512 + 2, 512 + 2, 512 + 2,
-		512 + 2, 512 + 2, 512 + 2, 512 + 2,
-		512 + 2, 512 + 2, 512 + 2, 512 + 2,
-		512 + 2, 512 + 2, 512 + 2, 512 + 2
+	// compensate for a divide-by-4 operation (+2 is the rounding offset.)
+	const __m256i offset_uv = _mm256_set1_epi16(512 + 2);
+
+	// After packus_epi16, each 128-bit lane holds 8 'even' samples followed by
+	// 8 'odd' samples.  This shuffle interleaves them back into pixel-order.
+	const __m256i shuffle_interleave = _mm256_set_epi8(
+		15, 7, 14, 6, 13, 5, 12, 4, 11, 3, 10, 2, 9, 1, 8, 0,
+		15, 7, 14, 6, 13, 5, 12, 4, 11, 3, 10, 2, 9, 1, 8, 0
 	);
 
-	//m256_rgb32fyuv_offset0255 : m256_rgb32fyuv_offset16240;
-
-	const __m256i coffset256 = use_fullscale ? m256_rgb32fyuv_offset0255 : m256_rgb32fyuv_offset16240;
-	//const uint32_t dst_adjustment = dst_stride + width_div_16;
-	//const uint32_t src_adjustment = src_stride - width_div_2;
-
-	__m256 temp_y[2], temp_u[2], temp_v[2], temp_yu[2], temp_yuv[2];
-	__m256i temp_yuvi[2];// temp var for 32bit int SIMD-data
-	__m256  mm32[2][4]; // temp var for 32bit  float SIMD-data
-	__m256  mm32_y[2][4]; // temp var for 32bit  float SIMD-data
-	__m256  mm32_uv[2][8]; // temp var for 32bit  float SIMD-data
-
-	//__m256i temp_y2[2];
-
-	//__m256i mm16i[2][8];// temp var for 326bit int SIMD-data
-	__m256i pixels_y[2], pixels_y_yp1[2], pixels_uv, pixels, pixels_uv2[4];
-
-	const __m256 *src_ptr;    // source-pointer: scanline#y
-	const __m256 *src_ptr_yp1;// source-pointer: scanline#(y+1)
-	__m256i *dst_ptr_y;    // destination-pointer: y_plane (scanline #y)
-	__m256i *dst_ptr_y_yp1;// destination-pointer: y_plane (scanline #y+1)
-	__m256i *dst_ptr_uv;   // destination-pointer: uv_plane
-
-	// combine the Y-plane extraction with a permute4x64
-	//  (The value '7' selects a unused (zero'd) pixel)
-	const __m256i _permc_y[4] = {
-		_mm256_set_epi32(7, 7, 7, 7, 7, 7, 4, 0), // Write pixels 0,1 
-		_mm256_set_epi32(7, 7, 7, 7, 4, 0, 7, 7), // Write pixels 2,3
-		_mm256_set_epi32(7, 7, 4, 0, 7, 7, 7, 7), // Write pixels 4,5
-		_mm256_set_epi32(4, 0, 7, 7, 7, 7, 7, 7)  // Write pixels 6,7
-	};
-
-	// combine the UV-plane extraction with a permute4x64
-	//  (The value '7' selects a unused (zero'd) pixel)
-	const __m256i _permc_uv[2] = {
-		_mm256_set_epi32(7, 7, 7, 7, 6, 2, 5, 1), // [0-3] re-arrange to V1 V0 U1 U0
-		_mm256_set_epi32(6, 2, 5, 1, 7, 7, 7, 7)  // [4-7] re-arrange to V3 V2 U3 U2
-	};
+	__m256 yf[2], uf[2], vf[2], u_sum, v_sum;
+	__m256i y32[2][4];// Y-pixels (32bit int), scanline #y and #(y+1)
+	__m256i uv32[4];  // U/V-pixels (32bit int), chroma-row
+	__m256i pixels[2];
 
 	for (uint32_t y = 0; y < height; y += 2) {
 		// Source-pointers: RGB32f-surface
-		src_ptr = src_rgb + (y * src_stride); // scanline (scanline #y)
-		src_ptr_yp1 = src_ptr + src_stride;       // scanline (scanline #y+1)
+		const __m256 *src_ptr = src_rgb + (y * src_stride); // scanline (scanline #y)
+		const __m256 *src_ptr_yp1 = src_ptr + src_stride;    // scanline (scanline #y+1)
 
-		// Destination pointer: Y-surface
-		dst_ptr_y = dest_y + (height - 1 - y) * dst_stride;// scanline (#y)
-		dst_ptr_y_yp1 = dst_ptr_y - dst_stride;            // scanline (#y+1) 
+		// Destination pointer: Y-surface (the image is flipped vertically)
+		__m256i *dst_ptr_y = dest_y + (height - 1 - y) * dst_stride;// scanline (#y)
+		__m256i *dst_ptr_y_yp1 = dst_ptr_y - dst_stride;            // scanline (#y+1) 
 
 		// Destination pointer: UV-surface
-		dst_ptr_uv = dest_uv + ((height - 1 - y) >> 1) * dst_stride;
+		__m256i *dst_ptr_uv = dest_uv + ((height - 1 - y) >> 1) * dst_stride;
 
-		//		for (uint32_t x = 0; x < width; x += 4, ++src_ptr, ++dst_ptr) {
-		for (uint32_t x = 0; x < width; x += 32, ++dst_ptr_uv) {
-			// In each iteration, process 32 source YUV-pixels (in 8 groups of 4):
-			//	Pixel# [x,y], [x+1,y], ... [x+15,y]
-			//
-			// This produces exactly 16 destination YUV-pixels
+		for (uint32_t x = 0; x < width; x += 32) {
+			// In each iteration, process up to 32 source pixels (in 4 groups of 8)
+			//   from scanline #y and #(y+1).  If the width is an odd multiple of 16,
+			//   the last iteration processes only 2 groups (16 pixels.)
+			const uint32_t num_groups = ((width - x) >= 32) ? 4 : 2;
 
 			for (uint32_t i = 0; i < 4; ++i) {
-				
-				mm32_y[0][i] = _mm256_setzero_ps();// zero
-				mm32_y[1][i] = _mm256_setzero_ps();// zero
+				if (i >= num_groups) {
+					y32[0][i] = _mm256_setzero_si256();
+					y32[1][i] = _mm256_setzero_si256();
+					uv32[i] = _mm256_setzero_si256();
+					continue;
+				}
 
-				for (uint32_t j = 0; j < 4; ++j, ++src_ptr, ++src_ptr_yp1) {
-					// process two RGBf32 pixels per iteration (each pixel is 4x32 bits)
-					// Input-format:
-					//     One RGBf pixel: Bits# 127:96 95:64 63:32 31:0
-					//                            Alpha Blue  Green Red
-					//
-					//     Each AVX256 register stores 2 RGBf pixels.
+				_avx2_rgbf_to_yuvf(coeff, src_ptr, yf[0], uf[0], vf[0]);
+				_avx2_rgbf_to_yuvf(coeff, src_ptr_yp1, yf[1], uf[1], vf[1]);
+				src_ptr += 4;
+				src_ptr_yp1 += 4;
+
+				y32[0][i] = _mm256_cvttps_epi32(_mm256_round_ps(yf[0], _MM_FROUND_NINT));
+				y32[1][i] = _mm256_cvttps_epi32(_mm256_round_ps(yf[1], _MM_FROUND_NINT));
+
+				// Handle (chroma) UV-plane:
+				//    (a) cut vertical resolution in half by summing scanline#(y) and (y+1)
+				//    (b) cut horizontal resolution in half by summing the even (low lane)
+				//        and odd (high lane) pixels
+				//  -> Float#7  6  5  4  3  2  1  0
+				//           V3 V2 V1 V0 U3 U2 U1 U0
+				u_sum = _mm256_add_ps(uf[0], uf[1]);
+				v_sum = _mm256_add_ps(vf[0], vf[1]);
+				uf[0] = _mm256_add_ps(
+					_mm256_permute2f128_ps(u_sum, v_sum, 0x20),
+					_mm256_permute2f128_ps(u_sum, v_sum, 0x31)
+				);
+				uv32[i] = _mm256_cvttps_epi32(_mm256_round_ps(uf[0], _MM_FROUND_NINT));
+			} // for i
 
-					// Output-format:
-					//   packed-pixel YUV (32bits per channel, 128bpp total):
-					// Byte #7  6  5  4  3  2  1  0
-					//       0  V1 U1 Y1 0  V0 U0 Y0
+			// Luma: pack 32bit -> 16bit, add offset, pack 16bit -> 8bit
+			//    low lane = pixels {0, 2, 4 .. 30}, high lane = pixels {1, 3, 5 .. 31}
+			for (uint32_t k = 0; k < 2; ++k) {
+				pixels[0] = _mm256_adds_epi16(_mm256_packs_epi32(y32[k][0], y32[k][1]), offset_y);
+				pixels[1] = _mm256_adds_epi16(_mm256_packs_epi32(y32[k][2], y32[k][3]), offset_y);
+				pixels[k] = _mm256_packus_epi16(pixels[0], pixels[1]);
+				pixels[k] = _mm256_permute4x64_epi64(pixels[k], _MM_SHUFFLE(3, 1, 2, 0));
+				y32[k][0] = _mm256_shuffle_epi8(pixels[k], shuffle_interleave);
+			}
 
-					// (1) process 2 RGBf32 pixels
-					temp_y[0] = _mm256_mul_ps(src_ptr[0], cmatrix_y); //pixel(x,y)
-					temp_u[0] = _mm256_mul_ps(src_ptr[0], cmatrix_u);
-					temp_v[0] = _mm256_mul_ps(src_ptr[0], cmatrix_v);
-					temp_y[1] = _mm256_mul_ps(src_ptr_yp1[0], cmatrix_y); //pixel(x,y+1)
-					temp_u[1] = _mm256_mul_ps(src_ptr_yp1[0], cmatrix_u);
-					temp_v[1] = _mm256_mul_ps(src_ptr_yp1[0], cmatrix_v);
+			// Chroma: pack 32bit -> 16bit, add offset, divide by 4, pack 16bit -> 8bit
+			//    low lane = U {0 .. 15}, high lane = V {0 .. 15}
+			pixels[0] = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_packs_epi32(uv32[0], uv32[1]), offset_uv), 2);
+			pixels[1] = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_packs_epi32(uv32[2], uv32[3]), offset_uv), 2);
+			pixels[0] = _mm256_packus_epi16(pixels[0], pixels[1]);
+			pixels[0] = _mm256_permute4x64_epi64(pixels[0], _MM_SHUFFLE(3, 1, 2, 0));
+			uv32[0] = _mm256_shuffle_epi8(pixels[0], shuffle_interleave);
+
+			if (num_groups == 4) {
+				_mm256_stream_si256(dst_ptr_y++, y32[0][0]);
+				_mm256_stream_si256(dst_ptr_y_yp1++, y32[1][0]);
+				_mm256_stream_si256(dst_ptr_uv++, uv32[0]);
+			}
+			else {
+				// 16 pixel remainder: only the low 128 bits are valid
+				_mm_stream_si128(reinterpret_cast<__m128i *>(dst_ptr_y), _mm256_castsi256_si128(y32[0][0]));
+				_mm_stream_si128(reinterpret_cast<__m128i *>(dst_ptr_y_yp1), _mm256_castsi256_si128(y32[1][0]));
+				_mm_stream_si128(reinterpret_cast<__m128i *>(dst_ptr_uv), _mm256_castsi256_si128(uv32[0]));
+			}
+		} // for x
+	} // for y
 
-					// temp_y   A7 A6 A5 A4 | A3 A2 A1 A0
-					//          Y1 Y1 Y1 Y1   Y0 Y0 Y0 Y0
+	_mm_sfence(); // make the streaming stores globally visible before returning
+}
 
-					// temp_u   B7 B6 B5 B4 | B3 B2 B1 B0
-					//          U1 U1 U1 U1   U0 U0 U0 U0
+////////////////////
+//
+// 10-bit converters (P010, YUV444 16bpc)
+//
+//   The output samples are 16-bit words with the 10-bit value in bits [15:6].
+//   The SSSE3 and AVX2 versions evaluate the color-matrix in the same order
+//   (see _avx2_rgbf_to_yuvf), so their output is bit-identical.
+//
+
+// _sse_rgbf_to_yuvf(): convert 4 packed RGBf32 pixels into planar Y/U/V (float)
+//   Each output register holds one channel of pixel# {0, 1, 2, 3}
+static inline void _sse_rgbf_to_yuvf(
+	const __m128 coeff[12], // {Y: c0..c3, U: c0..c3, V: c0..c3}
+	const __m128 src[4],    // 4 RGBf32 pixels (1 pixel per register)
+	__m128 &out_y, __m128 &out_u, __m128 &out_v
+	)
+{
+	__m128 p0 = src[0], p1 = src[1], p2 = src[2], p3 = src[3];
+	_MM_TRANSPOSE4_PS(p0, p1, p2, p3); // p0..p3 = channel#0..#3
 
-					// temp_v   C7 C6 C5 C4 | C3 C2 C1 C0
-					//          V1 V1 V1 V1   V0 V0 V0 V0
+	out_y = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(p0, coeff[0]), _mm_mul_ps(p1, coeff[1])),
+		_mm_add_ps(_mm_mul_ps(p2, coeff[2]), _mm_mul_ps(p3, coeff[3]))
+	);
+	out_u = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(p0, coeff[4]), _mm_mul_ps(p1, coeff[5])),
+		_mm_add_ps(_mm_mul_ps(p2, coeff[6]), _mm_mul_ps(p3, coeff[7]))
+	);
+	out_v = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(p0, coeff[8]), _mm_mul_ps(p1, coeff[9])),
+		_mm_add_ps(_mm_mul_ps(p2, coeff[10]), _mm_mul_ps(p3, coeff[11]))
+	);
+}
 
-					temp_yu[0] = _mm256_hadd_ps(temp_y[0], temp_u[0]);
-					temp_yu[1] = _mm256_hadd_ps(temp_y[1], temp_u[1]);
-					//  Y7 Y6 Y5 Y4 Y3 Y2 Y1 Y0 <HADD> U7 U6 U5 U4 U3 U2 U1 U0
-					//  UUUUUUUUUUUUUUU YYYYYYYYYYYYYY  UUUUUUUUUUUUUUU YYYYYYYYYYYYYYY
-					//  (U7+U6) (U4+U5) (Y6+Y7) (Y4+Y5) (U2+U3) (U0+U1) (Y2+Y3) (Y0+Y1)
+// _sse_pack_10bit(): pack 2x4 int32 samples into 8 P010-style 16-bit words
+//   (add offset, clamp to 0..1023, then shift into bits [15:6])
+static inline __m128i _sse_pack_10bit(const __m128i lo, const __m128i hi, const __m128i offset)
+{
+	__m128i w = _mm_adds_epi16(_mm_packs_epi32(lo, hi), offset);
+	w = _mm_min_epi16(_mm_max_epi16(w, _mm_setzero_si128()), _mm_set1_epi16(1023));
+	return _mm_slli_epi16(w, 6);
+}
 
-					//   Float#7    #6   #5     #4     #3    #2    #1    #0
-					//      B6_B7 B5_B4 A6_A7 A4_A5 B3_B2 B1_B0 A2_A3 A0_A1
-					//      33333 33333 11111 11111 22222 22222 00000 00000
-					//       U1     U1   Y1     Y1    U0   U0     Y0     Y0
+static inline __m256i _avx2_pack_10bit(const __m256i lo, const __m256i hi, const __m256i offset)
+{
+	__m256i w = _mm256_adds_epi16(_mm256_packs_epi32(lo, hi), offset);
+	w = _mm256_min_epi16(_mm256_max_epi16(w, _mm256_setzero_si256()), _mm256_set1_epi16(1023));
+	return _mm256_slli_epi16(w, 6);
+}
 
-					temp_v[0] = _mm256_hadd_ps(temp_v[0], zero);
-					temp_v[1] = _mm256_hadd_ps(temp_v[1], zero);
-					//   Float#7    #6   #5     #4     #3    #2    #1    #0
-					//        0     0    A6_A7  A4_A5   0    0    A2_A3  A0_A1
-					//                   11111  11111             0000   00000
-					//                    V1      V1                V0      V0
+// The 8-bit coefficient matrices are scaled to 0..255 (full) or 16..235 (video).
+// 10-bit full-scale is 0..1023, and 10-bit video-range is exactly 4x the 8-bit range.
+static inline float _rgbf_10bit_scale(const bool use_fullscale)
+{
+	return use_fullscale ? (1023.0f / 255.0f) : 4.0f;
+}
 
-					// mm32[][]
-					// Float#7  6  5  4  3  2  1  0
-					//       0  V1 U1 Y1 0  V0 U0 Y0
-					mm32[0][j] = _mm256_hadd_ps(temp_yu[0], temp_v[0]);
-					mm32[1][j] = _mm256_hadd_ps(temp_yu[1], temp_v[1]);
+// Scalar versions of the helpers above, for the non-SSE converters.
+//   _rgbf_pixel_to_yuvf() sums in the same order as _sse_rgbf_to_yuvf(), and
+//   _rgbf_round() rounds like cvtps_epi32, so the output matches the SIMD versions.
+static inline void _rgbf_pixel_to_yuvf(const float coeff[12], const float p[4], float yuv[3])
+{
+	for (uint32_t c = 0; c < 3; ++c)
+		yuv[c] = (p[0] * coeff[c * 4 + 0] + p[1] * coeff[c * 4 + 1]) +
+			(p[2] * coeff[c * 4 + 2] + p[3] * coeff[c * 4 + 3]);
+}
 
-					// Extract the y-bytes:  each iteration(j) gets 2 Y-samples
-					// Float#7  6  5  4  3  2  1  0
-					//       Y7 V6 Y5 Y4 Y3 Y2 Y1 Y0
-					temp_y[0] = _mm256_permutevar8x32_ps(mm32[0][j], _permc_y[j]);
-					temp_y[1] = _mm256_permutevar8x32_ps(mm32[1][j], _permc_y[j]);
-					mm32_y[0][i] = _mm256_or_ps(mm32_y[0][i], temp_y[0]);
-					mm32_y[1][i] = _mm256_or_ps(mm32_y[1][i], temp_y[1]);
-				} // for j
+static inline int32_t _rgbf_round(const float f)
+{
+	return _mm_cvtss_si32(_mm_set_ss(f)); // round to nearest
+}
 
-				// Extract U/V-plane:
-				//    Process pixels {x+0..x+15} (there are half as many UV pixels as Y pixels)
-				for (uint32_t k = 0; k < 2; ++k) {
-					// k == 0: scanline y
-					// k == 1: scanline y+1
-					for (uint32_t j = 0; j < 2; ++j) {
-						const uint32_t src_j = (j << 1) + 0;
-						const uint32_t dst_j = (i << 1) + j;
-						// pixels {x+0..x+3}: extract the U/V pixel-pair from mm32
-						mm32_uv[k][dst_j] = _mm256_permutevar8x32_ps(mm32[k][src_j + 0], _permc_uv[0]);
-
-						// pixels {x+4..x+7}: extract the U/V pixel-pair from mm32
-						temp_u[k] = _mm256_permutevar8x32_ps(mm32[k][src_j + 1], _permc_uv[1]);
-						mm32_uv[k][dst_j] = _mm256_or_ps(temp_u[k], mm32_uv[k][dst_j]);
-					} // for j
-				} // for k
-
-				// at this point:
-				// mm32_y[0][0..3] = Y-pixels (32bpp float), scanline#y     (total of 32 pixels)
-				//                   (each Y-pixel is 1 32bit float value)
-				// mm32_y[1][0..3] = Y-pixels (32bpp float), scanline#y+1   (total of 32 pixels)
-				// mm32_uv[0][0..7] = U/V-pixels (32bpp float), scanline#y  (total of 16 pixels)
-				//                   (each U/V-pixel is 2 32bit float values)
-				// mm32_uv[1][0..7] = U/V-pixels (32bpp float), scanline#y+1(total of 16 pixels)
-			} // for i
+static inline uint16_t _pack_10bit_sample(const int32_t x, const int32_t offset)
+{
+	int32_t w = (x < -32768) ? -32768 : ((x > 32767) ? 32767 : x); // (packs_epi32)
+	w += offset;
+	w = (w < 0) ? 0 : ((w > 1023) ? 1023 : w);
+	return static_cast<uint16_t>(w << 6);
+}
+
+void CRepackyuv::convert_RGBFtoP010( // convert packed(RGB f32) into 2-plane(P010)
+	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+	const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane  (16 bits per pixel)
+	uint8_t dest_uv[]   // pointer to output UV-plane (16 bits per U/V sample)
+	)
+{
+	bool is_xmm_aligned = m_cpu_has_ssse3;// are addresses 16-byte aligned?
+
+	// Check address-alignment of all planes
+	if (reinterpret_cast<uint64_t>(src_rgb) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_y) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_uv) & 0xF)
+		is_xmm_aligned = false;
+
+	if (src_stride & 0xF)
+		is_xmm_aligned = false;
+	else if (dst_stride & 0xF)
+		is_xmm_aligned = false;
+
+	if (height & 0x1)  // must have an even# scanlines
+		is_xmm_aligned = false;
+
+	bool is_avx256_aligned = is_xmm_aligned && m_cpu_has_avx2 && m_allow_avx2;
+	if (is_avx256_aligned) {
+		if (reinterpret_cast<uint64_t>(src_rgb) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_y) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_uv) & 0x1F)
+			is_avx256_aligned = false;
+
+		if (src_stride & 0x1F)
+			is_avx256_aligned = false;
+		else if (dst_stride & 0x1F)
+			is_avx256_aligned = false;
+	}
+
+	// The SIMD versions convert whole blocks (AVX2: 16 pixels, SSSE3: 8 pixels),
+	// the rest of each scanline is converted by the non-SSE version.
+	uint32_t x_begin = 0;
+	if (is_avx256_aligned && width >= 16) {
+		x_begin = width & ~0xF;
+		_convert_RGBFtoP010_avx2( //AVX2 version of converter
+			use_bt709, use_fullscale,
+			x_begin, height,
+			src_stride >> 5, // src stride (units of _m256)
+			reinterpret_cast<__m256 const *>(src_rgb),
+			dst_stride >> 5,  // dst stride (units of _m256i)
+			reinterpret_cast<__m256i *>(dest_y),    // output Y
+			reinterpret_cast<__m256i *>(dest_uv)   // output UV
+		);
+	}
+	else if (is_xmm_aligned && width >= 8) {
+		x_begin = width & ~0x7;
+		_convert_RGBFtoP010_ssse3( // SSSE3 version of converter
+			use_bt709, use_fullscale,
+			x_begin, height,
+			src_stride >> 4, // src stride (units of _m128)
+			reinterpret_cast<__m128 const *>(src_rgb),
+			dst_stride >> 4,  // dst stride (units of _m128i)
+			reinterpret_cast<__m128i *>(dest_y),    // output Y
+			reinterpret_cast<__m128i *>(dest_uv)   // output UV
+		);
+	}
+
+	if (x_begin < width)
+		_convert_RGBFtoP010(  // non-SSE version (slow)
+			use_bt709, use_fullscale,
+			x_begin, width, height,
+			src_stride, src_rgb,
+			dst_stride,
+			dest_y,   // output Y
+			dest_uv   // output UV
+		);
+}
+
+void CRepackyuv::_convert_RGBFtoP010( // convert packed(RGB f32) into 2-plane(P010), columns x_begin .. width-1
+	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+	const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+	const uint32_t x_begin,    // first column (#pixels): must be even#
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_uv[]   // pointer to output UV-plane
+	)
+{
+	// the (10-bit scaled) coefficients, in the same layout as the SIMD versions
+	const __m128 scale = _mm_set1_ps(_rgbf_10bit_scale(use_fullscale));
+	float coeff[12];
+	for (uint32_t c = 0; c < 3; ++c)
+		_mm_storeu_ps(coeff + c * 4, _mm_mul_ps(
+			get_rgb2yuv_coeff_matrix128(use_bt709, use_fullscale, static_cast<select_color_t>(c)), scale));
+
+	const int32_t offset_y = use_fullscale ? 0 : 64;
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		// (an odd# of scanlines: the last one is its own pair)
+		const uint32_t yp1 = (y + 1 < height) ? y + 1 : y;
+		const float *src_row[2] = {
+			reinterpret_cast<const float *>(src_rgb + src_stride * y),   // scanline #y
+			reinterpret_cast<const float *>(src_rgb + src_stride * yp1)  // scanline #y+1
+		};
+		uint16_t *dst_row_y[2] = {
+			reinterpret_cast<uint16_t *>(dest_y + dst_stride * (height - 1 - y)),  // scanline (#y)
+			reinterpret_cast<uint16_t *>(dest_y + dst_stride * (height - 1 - yp1)) // scanline (#y+1)
+		};
+		uint16_t *dst_row_uv = reinterpret_cast<uint16_t *>(dest_uv + dst_stride * ((height - 1 - y) >> 1));
+
+		for (uint32_t x = x_begin; x < width; x += 2) {
+			// (an odd# of pixels: the last one is its own pair)
+			const uint32_t xp1 = (x + 1 < width) ? x + 1 : x;
+			float yuv[2][2][3]; // [scanline][pixel][Y/U/V]
 
-			// extract y-plane
-			//    Process pixels {x+0..x+31}:
-			//       Convert from 32bit float into 8bpp integer (unsigned)
 			for (uint32_t i = 0; i < 2; ++i) {
-				// Each loop iteration, process 16 pixels from scanline#(y)
-				//                      and another 16 pixels from scanline#(y+1)
-				//                      (Total of 32 pixels)
+				_rgbf_pixel_to_yuvf(coeff, src_row[i] + x * 4, yuv[i][0]);
+				_rgbf_pixel_to_yuvf(coeff, src_row[i] + xp1 * 4, yuv[i][1]);
+				dst_row_y[i][x] = _pack_10bit_sample(_rgbf_round(yuv[i][0][0]), offset_y);
+				dst_row_y[i][xp1] = _pack_10bit_sample(_rgbf_round(yuv[i][1][0]), offset_y);
+			}
+
+			// Chroma: sum scanline#(y) and (y+1), then sum adjacent pixels
+			for (uint32_t c = 1; c < 3; ++c) {
+				const float sum = (yuv[0][0][c] + yuv[1][0][c]) + (yuv[0][1][c] + yuv[1][1][c]);
+				dst_row_uv[x + c - 1] = _pack_10bit_sample(_rgbf_round(sum * 0.25f), 512);
+			}
+		} // for x
+	} // for y
+}
 
-				// grab pixels x+0...x+15 (scanline y)
-				temp_y[0] = _mm256_round_ps(mm32_y[0][(i<<1)+0], _MM_FROUND_NINT);// pixels x..x+7
-				temp_y[1] = _mm256_round_ps(mm32_y[0][(i<<1)+1], _MM_FROUND_NINT);// pixels x+8..x+15
+void CRepackyuv::_convert_RGBFtoP010_ssse3( // convert packed(RGB f32) into 2-plane(P010)
+	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+	const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 8
+	const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128]
+	const __m128   src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	__m128i dest_y[],   // pointer to output Y-plane
+	__m128i dest_uv[]   // pointer to output UV-plane
+	)
+{
+	const __m128 cmatrix[3] = {
+		get_rgb2yuv_coeff_matrix128(use_bt709, use_fullscale, SELECT_COLOR_Y),
+		get_rgb2yuv_coeff_matrix128(use_bt709, use_fullscale, SELECT_COLOR_U),
+		get_rgb2yuv_coeff_matrix128(use_bt709, use_fullscale, SELECT_COLOR_V)
+	};
+	const __m128 scale = _mm_set1_ps(_rgbf_10bit_scale(use_fullscale));
+	const __m128 quarter = _mm_set1_ps(0.25f); // chroma is the average of 2x2 pixels
+
+	// broadcast each (10-bit scaled) coefficient to all 4 lanes
+	__m128 coeff[12];
+	for (uint32_t c = 0; c < 3; ++c) {
+		const __m128 m = _mm_mul_ps(cmatrix[c], scale);
+		coeff[c * 4 + 0] = _mm_shuffle_ps(m, m, _MM_SHUFFLE(0, 0, 0, 0));
+		coeff[c * 4 + 1] = _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1));
+		coeff[c * 4 + 2] = _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2));
+		coeff[c * 4 + 3] = _mm_shuffle_ps(m, m, _MM_SHUFFLE(3, 3, 3, 3));
+	}
 
-				pixels    = _mm256_cvttps_epi32(temp_y[0]);
-				pixels_uv = _mm256_cvttps_epi32(temp_y[1]);
+	const __m128i offset_y = _mm_set1_epi16(use_fullscale ? 0 : 64);
+	const __m128i offset_uv = _mm_set1_epi16(512);
 
-				pixels_y[i] = _mm256_packs_epi32(pixels, pixels_uv);// pixels x+0..x+15 (16bpp), scanline#y
-				// swap bits[191:128] <-> bits[127:64]
-				pixels_y[i] = _mm256_adds_epi16(pixels_y[i], offset_y);
+	__m128 yf[2], uf[2], vf[2], uv;
+	__m128i y32[2][2], uv32[2];
 
-				// grab pixels x+0..x+15 (scanline y+1)
-				temp_y[0] = _mm256_round_ps(mm32_y[1][(i<<1)+0], _MM_FROUND_NINT);
-				temp_y[1] = _mm256_round_ps(mm32_y[1][(i<<1)+1], _MM_FROUND_NINT);
+	for (uint32_t y = 0; y < height; y += 2) {
+		const __m128 *src_ptr = src_rgb + (y * src_stride); // scanline (scanline #y)
+		const __m128 *src_ptr_yp1 = src_ptr + src_stride;    // scanline (scanline #y+1)
 
-				pixels    = _mm256_cvttps_epi32(temp_y[0]);
-				pixels_uv = _mm256_cvttps_epi32(temp_y[1]);
+		// Destination pointers (the image is flipped vertically)
+		__m128i *dst_ptr_y = dest_y + (height - 1 - y) * dst_stride;// scanline (#y)
+		__m128i *dst_ptr_y_yp1 = dst_ptr_y - dst_stride;            // scanline (#y+1) 
+		__m128i *dst_ptr_uv = dest_uv + ((height - 1 - y) >> 1) * dst_stride;
 
-				pixels_y_yp1[i] = _mm256_packs_epi32(pixels, pixels_uv);// pixels x+0..x+15 (16bpp), scanline#y+1
-				
-				// Add offset (to normalize video-scale to 16-235)
-				pixels_y_yp1[i] = _mm256_adds_epi16(pixels_y_yp1[i], offset_y);
+		for (uint32_t x = 0; x < width; x += 8) {
+			// In each iteration, process 8 source pixels (in 2 groups of 4)
+			//   from scanline #y and #(y+1)
+			for (uint32_t i = 0; i < 2; ++i) {
+				_sse_rgbf_to_yuvf(coeff, src_ptr, yf[0], uf[0], vf[0]);
+				_sse_rgbf_to_yuvf(coeff, src_ptr_yp1, yf[1], uf[1], vf[1]);
+				src_ptr += 4;
+				src_ptr_yp1 += 4;
+
+				y32[0][i] = _mm_cvtps_epi32(yf[0]); // round to nearest
+				y32[1][i] = _mm_cvtps_epi32(yf[1]);
+
+				// Chroma: sum scanline#(y) and (y+1), then sum adjacent pixels
+				//  -> Float#3   2   1   0
+				//          V1  U1  V0  U0
+				uv = _mm_hadd_ps(_mm_add_ps(uf[0], uf[1]), _mm_add_ps(vf[0], vf[1]));
+				uv = _mm_shuffle_ps(uv, uv, _MM_SHUFFLE(3, 1, 2, 0));
+				uv32[i] = _mm_cvtps_epi32(_mm_mul_ps(uv, quarter));
 			} // for i
 
-			// Write the Y-pixels [x .. x+31], 
-			//    then advance -> +31 pixels to the right
-			temp_yuvi[0] = _mm256_packus_epi16(pixels_y[0], pixels_y[1]);// pack 16bit -> 8bit
-			temp_yuvi[1] = _mm256_packus_epi16(pixels_y_yp1[0], pixels_y_yp1[1]);
+			_mm_store_si128(dst_ptr_y++, _sse_pack_10bit(y32[0][0], y32[0][1], offset_y));
+			_mm_store_si128(dst_ptr_y_yp1++, _sse_pack_10bit(y32[1][0], y32[1][1], offset_y));
+			_mm_store_si128(dst_ptr_uv++, _sse_pack_10bit(uv32[0], uv32[1], offset_uv));
+		} // for x
+	} // for y
+}
 
-			// undo 2 back-to-back permute ops: packs_epi32 and packus_epi16
-			*dst_ptr_y++     = _mm256_permutevar8x32_epi32(temp_yuvi[0], m256_permc_pack2);
-			*dst_ptr_y_yp1++ = _mm256_permutevar8x32_epi32(temp_yuvi[1], m256_permc_pack2);
+void CRepackyuv::_convert_RGBFtoP010_avx2( // convert packed(RGB f32) into 2-plane(P010)
+	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+	const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 16
+	const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256]
+	const __m256   src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	__m256i dest_y[],   // pointer to output Y-plane
+	__m256i dest_uv[]   // pointer to output UV-plane
+	)
+{
+	const __m256 scale = _mm256_set1_ps(_rgbf_10bit_scale(use_fullscale));
+	const __m256 quarter = _mm256_set1_ps(0.25f); // chroma is the average of 2x2 pixels
+	const __m256 cmatrix[3] = {
+		_mm256_mul_ps(get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_Y), scale),
+		_mm256_mul_ps(get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_U), scale),
+		_mm256_mul_ps(get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_V), scale)
+	};
 
-			// Handle (chroma) UV-plane:
-			//    (a) cut resolution in half (horizontally and vertically)
-			//    (b) do this by taking the average of values from a 2x2 box:
-			//        (X,Y), (X+1,Y), (X,Y+1), (X+1,Y+1)
-			//        Then dividing the sum by 4.
-			//    (c) convert from 32bit-float to 8-bit int
-
-			for (uint32_t i = 0; i < 8; i+=2) {
-				// Cut the vertical chroma-resolution in half by 
-				// summing scanline#(y) and (y+1)
-				temp_u[0] = _mm256_add_ps(mm32_uv[0][i], mm32_uv[1][i]);
-				temp_u[1] = _mm256_add_ps(mm32_uv[0][i + 1], mm32_uv[1][i + 1]);
-
-				// cut horziontal chroma-resolution in half by hadd
-				temp_yu[0] = _mm256_hadd_ps(temp_u[0], temp_u[1]);
-				temp_yu[0] = _mm256_round_ps(temp_yu[0], _MM_FROUND_NINT);
-				pixels     = _mm256_cvttps_epi32(temp_yu[0]);
-				pixels_uv2[i >> 1] = _mm256_permute4x64_epi64(pixels, _MM_SHUFFLE(3, 1, 2, 0));
+	// broadcast each (10-bit scaled) coefficient to all 8 lanes
+	__m256 coeff[12];
+	for (uint32_t i = 0; i < 4; ++i) {
+		const __m256i idx = _mm256_set1_epi32(i);
+		coeff[i    ] = _mm256_permutevar8x32_ps(cmatrix[0], idx);
+		coeff[i + 4] = _mm256_permutevar8x32_ps(cmatrix[1], idx);
+		coeff[i + 8] = _mm256_permutevar8x32_ps(cmatrix[2], idx);
+	}
+
+	const __m256i offset_y = _mm256_set1_epi16(use_fullscale ? 0 : 64);
+	const __m256i offset_uv = _mm256_set1_epi16(512);
+
+	// After packs_epi32 + permute4x64, each 128-bit lane holds 4 'even' words
+	// followed by 4 'odd' words.  This shuffle interleaves them back into order.
+	const __m256i shuffle_interleave16 = _mm256_set_epi8(
+		15, 14, 7, 6, 13, 12, 5, 4, 11, 10, 3, 2, 9, 8, 1, 0,
+		15, 14, 7, 6, 13, 12, 5, 4, 11, 10, 3, 2, 9, 8, 1, 0
+	);
+
+	__m256 yf[2], uf[2], vf[2], u_sum, v_sum;
+	__m256i y32[2][2], uv32[2], pixels;
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		const __m256 *src_ptr = src_rgb + (y * src_stride); // scanline (scanline #y)
+		const __m256 *src_ptr_yp1 = src_ptr + src_stride;    // scanline (scanline #y+1)
+
+		// Destination pointers (the image is flipped vertically)
+		__m256i *dst_ptr_y = dest_y + (height - 1 - y) * dst_stride;// scanline (#y)
+		__m256i *dst_ptr_y_yp1 = dst_ptr_y - dst_stride;            // scanline (#y+1) 
+		__m256i *dst_ptr_uv = dest_uv + ((height - 1 - y) >> 1) * dst_stride;
+
+		for (uint32_t x = 0; x < width; x += 16) {
+			// In each iteration, process 16 source pixels (in 2 groups of 8)
+			//   from scanline #y and #(y+1)
+			for (uint32_t i = 0; i < 2; ++i) {
+				_avx2_rgbf_to_yuvf(coeff, src_ptr, yf[0], uf[0], vf[0]);
+				_avx2_rgbf_to_yuvf(coeff, src_ptr_yp1, yf[1], uf[1], vf[1]);
+				src_ptr += 4;
+				src_ptr_yp1 += 4;
+
+				y32[0][i] = _mm256_cvtps_epi32(yf[0]); // round to nearest
+				y32[1][i] = _mm256_cvtps_epi32(yf[1]);
+
+				// Chroma: sum scanline#(y) and (y+1), then sum the even (low lane)
+				//   and odd (high lane) pixels
+				//  -> Float#7  6  5  4  3  2  1  0
+				//           V3 V2 V1 V0 U3 U2 U1 U0
+				u_sum = _mm256_add_ps(uf[0], uf[1]);
+				v_sum = _mm256_add_ps(vf[0], vf[1]);
+				u_sum = _mm256_add_ps(
+					_mm256_permute2f128_ps(u_sum, v_sum, 0x20),
+					_mm256_permute2f128_ps(u_sum, v_sum, 0x31)
+				);
+				uv32[i] = _mm256_cvtps_epi32(_mm256_mul_ps(u_sum, quarter));
 			} // for i
 
-			for (uint32_t i = 0; i < 4; i+=2) {
-				pixels = _mm256_packs_epi32(pixels_uv2[i], pixels_uv2[i+1]);
-				pixels = _mm256_adds_epi16(pixels, offset_uv); // +128 and rounding offset
-				pixels_uv2[i >> 1] = _mm256_srai_epi16(pixels, 2); // re-normalize to 8-bit magnitude
+			for (uint32_t k = 0; k < 2; ++k) {
+				pixels = _avx2_pack_10bit(y32[k][0], y32[k][1], offset_y);
+				pixels = _mm256_permute4x64_epi64(pixels, _MM_SHUFFLE(3, 1, 2, 0));
+				y32[k][0] = _mm256_shuffle_epi8(pixels, shuffle_interleave16);
 			}
-			
-			pixels = _mm256_packus_epi16(pixels_uv2[0], pixels_uv2[1]);
-			// undo 2 back-to-back permute-operations: packs_eip32, and packus_epi16
-			*dst_ptr_uv = _mm256_permutevar8x32_epi32(pixels, m256_permc_pack2);// undo 2 permutes
+			pixels = _avx2_pack_10bit(uv32[0], uv32[1], offset_uv);
+			pixels = _mm256_permute4x64_epi64(pixels, _MM_SHUFFLE(3, 1, 2, 0));
+
+			_mm256_store_si256(dst_ptr_y++, y32[0][0]);
+			_mm256_store_si256(dst_ptr_y_yp1++, y32[1][0]);
+			_mm256_store_si256(dst_ptr_uv++, _mm256_shuffle_epi8(pixels, shuffle_interleave16));
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::convert_RGBFtoY444_16( // convert packed(RGB f32) into planar(YUV 4:4:4, 16bpc)
+	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+	const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane (16 bits per pixel)
+	uint8_t dest_u[],   // pointer to output U-plane (16 bits per pixel)
+	uint8_t dest_v[]    // pointer to output V-plane (16 bits per pixel)
+	)
+{
+	bool is_xmm_aligned = m_cpu_has_ssse3;// are addresses 16-byte aligned?
+
+	// Check address-alignment of all planes
+	if (reinterpret_cast<uint64_t>(src_rgb) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_y) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_u) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_v) & 0xF)
+		is_xmm_aligned = false;
+
+	if (src_stride & 0xF)
+		is_xmm_aligned = false;
+	else if (dst_stride & 0xF)
+		is_xmm_aligned = false;
+
+	bool is_avx256_aligned = is_xmm_aligned && m_cpu_has_avx2 && m_allow_avx2;
+	if (is_avx256_aligned) {
+		if (reinterpret_cast<uint64_t>(src_rgb) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_y) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_u) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_v) & 0x1F)
+			is_avx256_aligned = false;
+
+		if (src_stride & 0x1F)
+			is_avx256_aligned = false;
+		else if (dst_stride & 0x1F)
+			is_avx256_aligned = false;
+	}
+
+	// The SIMD versions convert whole blocks (AVX2: 16 pixels, SSSE3: 8 pixels),
+	// the rest of each scanline is converted by the non-SSE version.
+	uint32_t x_begin = 0;
+	if (is_avx256_aligned && width >= 16) {
+		x_begin = width & ~0xF;
+		_convert_RGBFtoY444_16_avx2( //AVX2 version of converter
+			use_bt709, use_fullscale,
+			x_begin, height,
+			src_stride >> 5, // src stride (units of _m256)
+			reinterpret_cast<__m256 const *>(src_rgb),
+			dst_stride >> 5,  // dst stride (units of _m256i)
+			reinterpret_cast<__m256i *>(dest_y),    // output Y
+			reinterpret_cast<__m256i *>(dest_u),    // output U
+			reinterpret_cast<__m256i *>(dest_v)     // output V
+		);
+	}
+	else if (is_xmm_aligned && width >= 8) {
+		x_begin = width & ~0x7;
+		_convert_RGBFtoY444_16_ssse3( // SSSE3 version of converter
+			use_bt709, use_fullscale,
+			x_begin, height,
+			src_stride >> 4, // src stride (units of _m128)
+			reinterpret_cast<__m128 const *>(src_rgb),
+			dst_stride >> 4,  // dst stride (units of _m128i)
+			reinterpret_cast<__m128i *>(dest_y),    // output Y
+			reinterpret_cast<__m128i *>(dest_u),    // output U
+			reinterpret_cast<__m128i *>(dest_v)     // output V
+		);
+	}
+
+	if (x_begin < width)
+		_convert_RGBFtoY444_16(  // non-SSE version (slow)
+			use_bt709, use_fullscale,
+			x_begin, width, height,
+			src_stride, src_rgb,
+			dst_stride,
+			dest_y,   // output Y
+			dest_u,   // output U
+			dest_v    // output V
+		);
+}
+
+void CRepackyuv::_convert_RGBFtoY444_16( // convert packed(RGB f32) into planar(YUV 4:4:4, 16bpc), columns x_begin .. width-1
+	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+	const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+	const uint32_t x_begin,    // first column (#pixels)
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_u[],   // pointer to output U-plane
+	uint8_t dest_v[]    // pointer to output V-plane
+	)
+{
+	// the (10-bit scaled) coefficients, in the same layout as the SIMD versions
+	const __m128 scale = _mm_set1_ps(_rgbf_10bit_scale(use_fullscale));
+	float coeff[12];
+	for (uint32_t c = 0; c < 3; ++c)
+		_mm_storeu_ps(coeff + c * 4, _mm_mul_ps(
+			get_rgb2yuv_coeff_matrix128(use_bt709, use_fullscale, static_cast<select_color_t>(c)), scale));
+
+	const int32_t offset_y = use_fullscale ? 0 : 64;
+
+	for (uint32_t y = 0; y < height; ++y) {
+		const float *src_row = reinterpret_cast<const float *>(src_rgb + src_stride * y);
+		const uint32_t dst_offset = dst_stride * (height - 1 - y); // (flipped vertically)
+		uint16_t *dst_row_y = reinterpret_cast<uint16_t *>(dest_y + dst_offset);
+		uint16_t *dst_row_u = reinterpret_cast<uint16_t *>(dest_u + dst_offset);
+		uint16_t *dst_row_v = reinterpret_cast<uint16_t *>(dest_v + dst_offset);
+		float yuv[3];
+
+		for (uint32_t x = x_begin; x < width; ++x) {
+			_rgbf_pixel_to_yuvf(coeff, src_row + x * 4, yuv);
+			dst_row_y[x] = _pack_10bit_sample(_rgbf_round(yuv[0]), offset_y);
+			dst_row_u[x] = _pack_10bit_sample(_rgbf_round(yuv[1]), 512);
+			dst_row_v[x] = _pack_10bit_sample(_rgbf_round(yuv[2]), 512);
+		}
+	}
+}
+
+void CRepackyuv::_convert_RGBFtoY444_16_ssse3( // convert packed(RGB f32) into planar(YUV 4:4:4, 16bpc)
+	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+	const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 8
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128]
+	const __m128   src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	__m128i dest_y[],   // pointer to output Y-plane
+	__m128i dest_u[],   // pointer to output U-plane
+	__m128i dest_v[]    // pointer to output V-plane
+	)
+{
+	const __m128 cmatrix[3] = {
+		get_rgb2yuv_coeff_matrix128(use_bt709, use_fullscale, SELECT_COLOR_Y),
+		get_rgb2yuv_coeff_matrix128(use_bt709, use_fullscale, SELECT_COLOR_U),
+		get_rgb2yuv_coeff_matrix128(use_bt709, use_fullscale, SELECT_COLOR_V)
+	};
+	const __m128 scale = _mm_set1_ps(_rgbf_10bit_scale(use_fullscale));
+
+	// broadcast each (10-bit scaled) coefficient to all 4 lanes
+	__m128 coeff[12];
+	for (uint32_t c = 0; c < 3; ++c) {
+		const __m128 m = _mm_mul_ps(cmatrix[c], scale);
+		coeff[c * 4 + 0] = _mm_shuffle_ps(m, m, _MM_SHUFFLE(0, 0, 0, 0));
+		coeff[c * 4 + 1] = _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1));
+		coeff[c * 4 + 2] = _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2));
+		coeff[c * 4 + 3] = _mm_shuffle_ps(m, m, _MM_SHUFFLE(3, 3, 3, 3));
+	}
+
+	const __m128i offset_y = _mm_set1_epi16(use_fullscale ? 0 : 64);
+	const __m128i offset_uv = _mm_set1_epi16(512);
+
+	__m128 yf, uf, vf;
+	__m128i y32[2], u32[2], v32[2];
+
+	for (uint32_t y = 0; y < height; ++y) {
+		const __m128 *src_ptr = src_rgb + (y * src_stride);
+
+		// Destination pointers (the image is flipped vertically)
+		const uint32_t dst_offset = (height - 1 - y) * dst_stride;
+		__m128i *dst_ptr_y = dest_y + dst_offset;
+		__m128i *dst_ptr_u = dest_u + dst_offset;
+		__m128i *dst_ptr_v = dest_v + dst_offset;
+
+		for (uint32_t x = 0; x < width; x += 8) {
+			// In each iteration, process 8 source pixels (in 2 groups of 4)
+			for (uint32_t i = 0; i < 2; ++i, src_ptr += 4) {
+				_sse_rgbf_to_yuvf(coeff, src_ptr, yf, uf, vf);
+				y32[i] = _mm_cvtps_epi32(yf); // round to nearest
+				u32[i] = _mm_cvtps_epi32(uf);
+				v32[i] = _mm_cvtps_epi32(vf);
+			}
+
+			_mm_store_si128(dst_ptr_y++, _sse_pack_10bit(y32[0], y32[1], offset_y));
+			_mm_store_si128(dst_ptr_u++, _sse_pack_10bit(u32[0], u32[1], offset_uv));
+			_mm_store_si128(dst_ptr_v++, _sse_pack_10bit(v32[0], v32[1], offset_uv));
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_RGBFtoY444_16_avx2( // convert packed(RGB f32) into planar(YUV 4:4:4, 16bpc)
+	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+	const bool     use_fullscale, // true=PC/full scale, false=video(64-940)
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 16
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256]
+	const __m256   src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	__m256i dest_y[],   // pointer to output Y-plane
+	__m256i dest_u[],   // pointer to output U-plane
+	__m256i dest_v[]    // pointer to output V-plane
+	)
+{
+	const __m256 scale = _mm256_set1_ps(_rgbf_10bit_scale(use_fullscale));
+	const __m256 cmatrix[3] = {
+		_mm256_mul_ps(get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_Y), scale),
+		_mm256_mul_ps(get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_U), scale),
+		_mm256_mul_ps(get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_V), scale)
+	};
+
+	// broadcast each (10-bit scaled) coefficient to all 8 lanes
+	__m256 coeff[12];
+	for (uint32_t i = 0; i < 4; ++i) {
+		const __m256i idx = _mm256_set1_epi32(i);
+		coeff[i    ] = _mm256_permutevar8x32_ps(cmatrix[0], idx);
+		coeff[i + 4] = _mm256_permutevar8x32_ps(cmatrix[1], idx);
+		coeff[i + 8] = _mm256_permutevar8x32_ps(cmatrix[2], idx);
+	}
+
+	const __m256i offset_y = _mm256_set1_epi16(use_fullscale ? 0 : 64);
+	const __m256i offset_uv = _mm256_set1_epi16(512);
+
+	// see _convert_RGBFtoP010_avx2()
+	const __m256i shuffle_interleave16 = _mm256_set_epi8(
+		15, 14, 7, 6, 13, 12, 5, 4, 11, 10, 3, 2, 9, 8, 1, 0,
+		15, 14, 7, 6, 13, 12, 5, 4, 11, 10, 3, 2, 9, 8, 1, 0
+	);
+
+	__m256 yf, uf, vf;
+	__m256i y32[2], u32[2], v32[2];
+
+	for (uint32_t y = 0; y < height; ++y) {
+		const __m256 *src_ptr = src_rgb + (y * src_stride);
+
+		// Destination pointers (the image is flipped vertically)
+		const uint32_t dst_offset = (height - 1 - y) * dst_stride;
+		__m256i *dst_ptr_y = dest_y + dst_offset;
+		__m256i *dst_ptr_u = dest_u + dst_offset;
+		__m256i *dst_ptr_v = dest_v + dst_offset;
+
+		for (uint32_t x = 0; x < width; x += 16) {
+			// In each iteration, process 16 source pixels (in 2 groups of 8)
+			for (uint32_t i = 0; i < 2; ++i, src_ptr += 4) {
+				_avx2_rgbf_to_yuvf(coeff, src_ptr, yf, uf, vf);
+				y32[i] = _mm256_cvtps_epi32(yf); // round to nearest
+				u32[i] = _mm256_cvtps_epi32(uf);
+				v32[i] = _mm256_cvtps_epi32(vf);
+			}
+
+			y32[0] = _mm256_permute4x64_epi64(_avx2_pack_10bit(y32[0], y32[1], offset_y), _MM_SHUFFLE(3, 1, 2, 0));
+			u32[0] = _mm256_permute4x64_epi64(_avx2_pack_10bit(u32[0], u32[1], offset_uv), _MM_SHUFFLE(3, 1, 2, 0));
+			v32[0] = _mm256_permute4x64_epi64(_avx2_pack_10bit(v32[0], v32[1], offset_uv), _MM_SHUFFLE(3, 1, 2, 0));
+
+			_mm256_store_si256(dst_ptr_y++, _mm256_shuffle_epi8(y32[0], shuffle_interleave16));
+			_mm256_store_si256(dst_ptr_u++, _mm256_shuffle_epi8(u32[0], shuffle_interleave16));
+			_mm256_store_si256(dst_ptr_v++, _mm256_shuffle_epi8(v32[0], shuffle_interleave16));
 		} // for x
 	} // for y
 }
+
+void CRepackyuv::convert_V410toP010( // convert packed(v410 4:4:4 10bpc) into 2-plane(P010)
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_v410[], // source v410 plane (32 bits per pixel: V[31:22] Y[21:12] U[11:2])
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane  (16 bits per pixel)
+	uint8_t dest_uv[]   // pointer to output UV-plane (16 bits per U/V sample)
+	)
+{
+	bool is_xmm_aligned = m_cpu_has_ssse3;// are addresses 16-byte aligned?
+
+	// Check address-alignment of all planes
+	if (reinterpret_cast<uint64_t>(src_v410) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_y) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_uv) & 0xF)
+		is_xmm_aligned = false;
+
+	if (src_stride & 0xF)
+		is_xmm_aligned = false;
+	else if (dst_stride & 0xF)
+		is_xmm_aligned = false;
+
+	if (height & 0x1)  // must have an even# scanlines
+		is_xmm_aligned = false;
+
+	bool is_avx256_aligned = is_xmm_aligned && m_cpu_has_avx2 && m_allow_avx2;
+	if (is_avx256_aligned) {
+		if (reinterpret_cast<uint64_t>(src_v410) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_y) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_uv) & 0x1F)
+			is_avx256_aligned = false;
+
+		if (src_stride & 0x1F)
+			is_avx256_aligned = false;
+		else if (dst_stride & 0x1F)
+			is_avx256_aligned = false;
+	}
+
+	// The SIMD versions convert whole blocks (AVX2: 16 pixels, SSSE3: 8 pixels),
+	// the rest of each scanline is converted by the non-SSE version.
+	uint32_t x_begin = 0;
+	if (is_avx256_aligned && width >= 16) {
+		x_begin = width & ~0xF;
+		_convert_V410toP010_avx2( //AVX2 version of converter
+			x_begin, height,
+			src_stride >> 5, // src stride (units of _m256i)
+			reinterpret_cast<__m256i const *>(src_v410),
+			dst_stride >> 5,  // dst stride (units of _m256i)
+			reinterpret_cast<__m256i *>(dest_y),    // output Y
+			reinterpret_cast<__m256i *>(dest_uv)   // output UV
+		);
+	}
+	else if (is_xmm_aligned && width >= 8) {
+		x_begin = width & ~0x7;
+		_convert_V410toP010_ssse3( // SSSE3 version of converter
+			x_begin, height,
+			src_stride >> 4, // src stride (units of _m128i)
+			reinterpret_cast<__m128i const *>(src_v410),
+			dst_stride >> 4,  // dst stride (units of _m128i)
+			reinterpret_cast<__m128i *>(dest_y),    // output Y
+			reinterpret_cast<__m128i *>(dest_uv)   // output UV
+		);
+	}
+
+	if (x_begin < width)
+		_convert_V410toP010( x_begin, width, height, src_stride, src_v410, dst_stride, dest_y, dest_uv );
+}
+
+void CRepackyuv::_convert_V410toP010( // convert packed(v410) into 2-plane(P010), columns x_begin .. width-1
+	const uint32_t x_begin,    // first column (#pixels): must be even#
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_v410[], // source v410 plane (32 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_uv[]   // pointer to output UV-plane
+	)
+{
+	for (uint32_t y = 0; y < height; y += 2) {
+		// (an odd# of scanlines: the last one is its own pair)
+		const uint32_t yp1 = (y + 1 < height) ? y + 1 : y;
+		const uint32_t *src_row[2] = {
+			reinterpret_cast<const uint32_t *>(src_v410 + src_stride * y),   // scanline #y
+			reinterpret_cast<const uint32_t *>(src_v410 + src_stride * yp1)  // scanline #y+1
+		};
+		uint16_t *dst_row_y[2] = {
+			reinterpret_cast<uint16_t *>(dest_y + dst_stride * (height - 1 - y)),  // scanline (#y)
+			reinterpret_cast<uint16_t *>(dest_y + dst_stride * (height - 1 - yp1)) // scanline (#y+1)
+		};
+		uint16_t *dst_row_uv = reinterpret_cast<uint16_t *>(dest_uv + dst_stride * ((height - 1 - y) >> 1));
+
+		for (uint32_t x = x_begin; x < width; x += 2) {
+			// (an odd# of pixels: the last one is its own pair)
+			const uint32_t xp1 = (x + 1 < width) ? x + 1 : x;
+			uint32_t u_sum = 0, v_sum = 0;
+
+			for (uint32_t i = 0; i < 2; ++i) {
+				const uint32_t p0 = src_row[i][x], p1 = src_row[i][xp1];
+				dst_row_y[i][x] = static_cast<uint16_t>(((p0 >> 12) & 0x3FF) << 6);
+				dst_row_y[i][xp1] = static_cast<uint16_t>(((p1 >> 12) & 0x3FF) << 6);
+				u_sum += ((p0 >> 2) & 0x3FF) + ((p1 >> 2) & 0x3FF);
+				v_sum += (p0 >> 22) + (p1 >> 22);
+			}
+
+			dst_row_uv[x] = static_cast<uint16_t>(((u_sum + 2) >> 2) << 6);
+			dst_row_uv[x + 1] = static_cast<uint16_t>(((v_sum + 2) >> 2) << 6);
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_V410toP010_ssse3( // convert packed(v410) into 2-plane(P010)
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 8
+	const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	const __m128i  src_v410[], // source v410 plane (32 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	__m128i dest_y[],   // pointer to output Y-plane
+	__m128i dest_uv[]   // pointer to output UV-plane
+	)
+{
+	// v410 pixel (32 bits):
+	//     Bits# 31:22  21:12  11:2  1:0
+	//             V      Y     U     x
+	const __m128i mask10 = _mm_set1_epi32(0x3FF);
+	const __m128i round_offset = _mm_set1_epi32(2);// rounding offset for div/4 operation
+
+	__m128i p[2], y32[2][2], u_sum, v_sum, uv32[2];
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		const __m128i *src_ptr = src_v410 + (y * src_stride); // scanline (scanline #y)
+		const __m128i *src_ptr_yp1 = src_ptr + src_stride;     // scanline (scanline #y+1)
+
+		// Destination pointers (the image is flipped vertically)
+		__m128i *dst_ptr_y = dest_y + (height - 1 - y) * dst_stride;// scanline (#y)
+		__m128i *dst_ptr_y_yp1 = dst_ptr_y - dst_stride;            // scanline (#y+1) 
+		__m128i *dst_ptr_uv = dest_uv + ((height - 1 - y) >> 1) * dst_stride;
+
+		for (uint32_t x = 0; x < width; x += 8) {
+			// In each iteration, process 8 source pixels (in 2 groups of 4)
+			//   from scanline #y and #(y+1)
+			for (uint32_t i = 0; i < 2; ++i) {
+				p[0] = _mm_load_si128(src_ptr++);
+				p[1] = _mm_load_si128(src_ptr_yp1++);
+
+				y32[0][i] = _mm_and_si128(_mm_srli_epi32(p[0], 12), mask10);
+				y32[1][i] = _mm_and_si128(_mm_srli_epi32(p[1], 12), mask10);
+
+				// Chroma: sum scanline#(y) and (y+1), then sum adjacent pixels
+				//  -> Int#3   2   1   0
+				//        V1  U1  V0  U0
+				u_sum = _mm_add_epi32(
+					_mm_and_si128(_mm_srli_epi32(p[0], 2), mask10),
+					_mm_and_si128(_mm_srli_epi32(p[1], 2), mask10)
+				);
+				v_sum = _mm_add_epi32(_mm_srli_epi32(p[0], 22), _mm_srli_epi32(p[1], 22));
+				uv32[i] = _mm_shuffle_epi32(_mm_hadd_epi32(u_sum, v_sum), _MM_SHUFFLE(3, 1, 2, 0));
+				uv32[i] = _mm_srli_epi32(_mm_add_epi32(uv32[i], round_offset), 2);
+			} // for i
+
+			_mm_store_si128(dst_ptr_y++, _mm_slli_epi16(_mm_packs_epi32(y32[0][0], y32[0][1]), 6));
+			_mm_store_si128(dst_ptr_y_yp1++, _mm_slli_epi16(_mm_packs_epi32(y32[1][0], y32[1][1]), 6));
+			_mm_store_si128(dst_ptr_uv++, _mm_slli_epi16(_mm_packs_epi32(uv32[0], uv32[1]), 6));
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_V410toP010_avx2( // convert packed(v410) into 2-plane(P010)
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 16
+	const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	const __m256i  src_v410[], // source v410 plane (32 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	__m256i dest_y[],   // pointer to output Y-plane
+	__m256i dest_uv[]   // pointer to output UV-plane
+	)
+{
+	const __m256i mask10 = _mm256_set1_epi32(0x3FF);
+	const __m256i round_offset = _mm256_set1_epi32(2);// rounding offset for div/4 operation
+
+	__m256i p[2], y32[2][2], u_sum, v_sum, uv32[2];
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		const __m256i *src_ptr = src_v410 + (y * src_stride); // scanline (scanline #y)
+		const __m256i *src_ptr_yp1 = src_ptr + src_stride;     // scanline (scanline #y+1)
+
+		// Destination pointers (the image is flipped vertically)
+		__m256i *dst_ptr_y = dest_y + (height - 1 - y) * dst_stride;// scanline (#y)
+		__m256i *dst_ptr_y_yp1 = dst_ptr_y - dst_stride;            // scanline (#y+1) 
+		__m256i *dst_ptr_uv = dest_uv + ((height - 1 - y) >> 1) * dst_stride;
+
+		for (uint32_t x = 0; x < width; x += 16) {
+			// In each iteration, process 16 source pixels (in 2 groups of 8)
+			//   from scanline #y and #(y+1)
+			for (uint32_t i = 0; i < 2; ++i) {
+				p[0] = _mm256_load_si256(src_ptr++);
+				p[1] = _mm256_load_si256(src_ptr_yp1++);
+
+				y32[0][i] = _mm256_and_si256(_mm256_srli_epi32(p[0], 12), mask10);
+				y32[1][i] = _mm256_and_si256(_mm256_srli_epi32(p[1], 12), mask10);
+
+				// Chroma (per 128-bit lane): V1 U1 V0 U0 | V3 U3 V2 U2
+				u_sum = _mm256_add_epi32(
+					_mm256_and_si256(_mm256_srli_epi32(p[0], 2), mask10),
+					_mm256_and_si256(_mm256_srli_epi32(p[1], 2), mask10)
+				);
+				v_sum = _mm256_add_epi32(_mm256_srli_epi32(p[0], 22), _mm256_srli_epi32(p[1], 22));
+				uv32[i] = _mm256_shuffle_epi32(_mm256_hadd_epi32(u_sum, v_sum), _MM_SHUFFLE(3, 1, 2, 0));
+				uv32[i] = _mm256_srli_epi32(_mm256_add_epi32(uv32[i], round_offset), 2);
+			} // for i
+
+			// packs_epi32 works per 128-bit lane; permute4x64 restores the pixel-order
+			_mm256_store_si256(dst_ptr_y++, _mm256_slli_epi16(_mm256_permute4x64_epi64(
+				_mm256_packs_epi32(y32[0][0], y32[0][1]), _MM_SHUFFLE(3, 1, 2, 0)), 6));
+			_mm256_store_si256(dst_ptr_y_yp1++, _mm256_slli_epi16(_mm256_permute4x64_epi64(
+				_mm256_packs_epi32(y32[1][0], y32[1][1]), _MM_SHUFFLE(3, 1, 2, 0)), 6));
+			_mm256_store_si256(dst_ptr_uv++, _mm256_slli_epi16(_mm256_permute4x64_epi64(
+				_mm256_packs_epi32(uv32[0], uv32[1]), _MM_SHUFFLE(3, 1, 2, 0)), 6));
+		} // for x
+	} // for y
+}
+
+////////////////////
+//
+// v210 (4:2:2 10bpc packed) -> NV12 / P010
+//
+//   A v210 group is 6 pixels in 4 little-endian 32-bit words:
+//
+//     Bits#     29:20  19:10   9:0
+//     word#0:    Cr0    Y0     Cb0
+//     word#1:    Y2     Cb2    Y1
+//     word#2:    Cb4    Y3     Cr2
+//     word#3:    Y5     Cr4    Y4
+//
+//   The SIMD versions unpack each group into 6 luma and 6 chroma (Cb Cr Cb Cr Cb Cr) 16-bit
+//   samples, in the lower 12 bytes of a register, then pack 4 groups (24 pixels) into 3 registers.
+//   Chroma is summed over scanlines (y) and (y+1) while it is still 11 bits.
+//
+//   rounding:  NV12 luma   = (Y + 2) >> 2            NV12 chroma = (C0 + C1 + 4) >> 3
+//              P010 luma   = Y << 6                  P010 chroma = ((C0 + C1 + 1) >> 1) << 6
+//   (the 8-bit results saturate at 255)
+
+// _v210_sample(): sample #i (0..11, in the order Cb0 Y0 Cr0 Y1 Cb2 Y2 Cr2 Y3 Cb4 Y4 Cr4 Y5) of a v210 group
+static inline uint32_t _v210_sample(const uint32_t group[4], const uint32_t i)
+{
+	return (group[i / 3] >> (10 * (i % 3))) & 0x3FF;
+}
+
+void CRepackyuv::convert_V210toNV12( // convert packed(v210 4:2:2 10bpc) into 2-plane(NV12)
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_v210[], // source v210 plane (128 bits per 6 pixels)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_uv[]   // pointer to output UV-plane
+	)
+{
+	bool is_xmm_aligned = m_cpu_has_ssse3;// are addresses 16-byte aligned?
+
+	// Check address-alignment of all planes
+	if (reinterpret_cast<uint64_t>(src_v210) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_y) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_uv) & 0xF)
+		is_xmm_aligned = false;
+
+	if (src_stride & 0xF)
+		is_xmm_aligned = false;
+	else if (dst_stride & 0xF)
+		is_xmm_aligned = false;
+
+	if (height & 0x1)  // must have an even# scanlines
+		is_xmm_aligned = false;
+
+	bool is_avx256_aligned = is_xmm_aligned && m_cpu_has_avx2 && m_allow_avx2;
+	if (is_avx256_aligned) {
+		if (reinterpret_cast<uint64_t>(src_v210) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_y) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_uv) & 0x1F)
+			is_avx256_aligned = false;
+
+		if (src_stride & 0x1F)
+			is_avx256_aligned = false;
+		else if (dst_stride & 0x1F)
+			is_avx256_aligned = false;
+	}
+
+	// The SIMD versions convert whole blocks (AVX2: 96 pixels, SSSE3: 48 pixels),
+	// the rest of each scanline is converted by the non-SSE version.
+	uint32_t x_begin = 0;
+	if (is_avx256_aligned && width >= 96) {
+		x_begin = width - (width % 96);
+		_convert_V210toNV12_avx2( // AVX2 version of converter
+			x_begin, height,
+			src_stride >> 5, // src stride (units of _m256i)
+			reinterpret_cast<__m256i const *>(src_v210),
+			dst_stride >> 5, // dst stride (units of _m256i)
+			reinterpret_cast<__m256i *>(dest_y),  // output Y
+			reinterpret_cast<__m256i *>(dest_uv)  // output UV
+		);
+	}
+	else if (is_xmm_aligned && width >= 48) {
+		x_begin = width - (width % 48);
+		_convert_V210toNV12_ssse3( // SSSE3 version of converter
+			x_begin, height,
+			src_stride >> 4, // src stride (units of _m128i)
+			reinterpret_cast<__m128i const *>(src_v210),
+			dst_stride >> 4, // dst stride (units of _m128i)
+			reinterpret_cast<__m128i *>(dest_y),  // output Y
+			reinterpret_cast<__m128i *>(dest_uv)  // output UV
+		);
+	}
+
+	if (x_begin < width)
+		_convert_V210to420( false, x_begin, width, height, src_stride, src_v210, dst_stride, dest_y, dest_uv );
+}
+
+void CRepackyuv::convert_V210toP010( // convert packed(v210 4:2:2 10bpc) into 2-plane(P010)
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_v210[], // source v210 plane (128 bits per 6 pixels)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane  (16 bits per pixel)
+	uint8_t dest_uv[]   // pointer to output UV-plane (16 bits per U/V sample)
+	)
+{
+	bool is_xmm_aligned = m_cpu_has_ssse3;// are addresses 16-byte aligned?
+
+	// Check address-alignment of all planes
+	if (reinterpret_cast<uint64_t>(src_v210) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_y) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_uv) & 0xF)
+		is_xmm_aligned = false;
+
+	if (src_stride & 0xF)
+		is_xmm_aligned = false;
+	else if (dst_stride & 0xF)
+		is_xmm_aligned = false;
+
+	if (height & 0x1)  // must have an even# scanlines
+		is_xmm_aligned = false;
+
+	bool is_avx256_aligned = is_xmm_aligned && m_cpu_has_avx2 && m_allow_avx2;
+	if (is_avx256_aligned) {
+		if (reinterpret_cast<uint64_t>(src_v210) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_y) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_uv) & 0x1F)
+			is_avx256_aligned = false;
+
+		if (src_stride & 0x1F)
+			is_avx256_aligned = false;
+		else if (dst_stride & 0x1F)
+			is_avx256_aligned = false;
+	}
+
+	// The SIMD versions convert whole blocks (AVX2: 48 pixels, SSSE3: 24 pixels),
+	// the rest of each scanline is converted by the non-SSE version.
+	uint32_t x_begin = 0;
+	if (is_avx256_aligned && width >= 48) {
+		x_begin = width - (width % 48);
+		_convert_V210toP010_avx2( // AVX2 version of converter
+			x_begin, height,
+			src_stride >> 5, // src stride (units of _m256i)
+			reinterpret_cast<__m256i const *>(src_v210),
+			dst_stride >> 5, // dst stride (units of _m256i)
+			reinterpret_cast<__m256i *>(dest_y),  // output Y
+			reinterpret_cast<__m256i *>(dest_uv)  // output UV
+		);
+	}
+	else if (is_xmm_aligned && width >= 24) {
+		x_begin = width - (width % 24);
+		_convert_V210toP010_ssse3( // SSSE3 version of converter
+			x_begin, height,
+			src_stride >> 4, // src stride (units of _m128i)
+			reinterpret_cast<__m128i const *>(src_v210),
+			dst_stride >> 4, // dst stride (units of _m128i)
+			reinterpret_cast<__m128i *>(dest_y),  // output Y
+			reinterpret_cast<__m128i *>(dest_uv)  // output UV
+		);
+	}
+
+	if (x_begin < width)
+		_convert_V210to420( true, x_begin, width, height, src_stride, src_v210, dst_stride, dest_y, dest_uv );
+}
+
+void CRepackyuv::_convert_V210to420( // convert packed(v210) into 2-plane(NV12 or P010), columns x_begin .. width-1
+	const bool     p010,       // output: true=P010, false=NV12
+	const uint32_t x_begin,    // first column (#pixels): must be multiple of 6
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_v210[], // source v210 plane
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_uv[]   // pointer to output UV-plane
+	)
+{
+	for (uint32_t y = 0; y < height; y += 2) {
+		// (an odd# of scanlines: the last one is its own pair)
+		const uint32_t yp1 = (y + 1 < height) ? y + 1 : y;
+		const uint32_t *src_row[2] = {
+			reinterpret_cast<const uint32_t *>(src_v210 + y * src_stride),   // scanline #y
+			reinterpret_cast<const uint32_t *>(src_v210 + yp1 * src_stride)  // scanline #y+1
+		};
+		uint8_t *dst_row_y[2] = { dest_y + y * dst_stride, dest_y + yp1 * dst_stride };
+		uint8_t *dst_row_uv = dest_uv + (y >> 1) * dst_stride;
+
+		for (uint32_t x = x_begin; x < width; ++x) {
+			const uint32_t group = (x / 6) * 4; // v210 group (offset in words)
+			const uint32_t k = x % 6;           // pixel# within the group
+
+			for (uint32_t i = 0; i < 2; ++i) {
+				const uint32_t luma = _v210_sample(src_row[i] + group, 2 * k + 1);
+				if (p010)
+					reinterpret_cast<uint16_t *>(dst_row_y[i])[x] = static_cast<uint16_t>(luma << 6);
+				else
+					dst_row_y[i][x] = static_cast<uint8_t>(((luma + 2) >> 2) > 255 ? 255 : ((luma + 2) >> 2));
+			}
+
+			if (k & 1)
+				continue;
+
+			// Chroma: (Cb,Cr) of pixels {x,x+1}, summed over scanline#(y) and (y+1)
+			const uint32_t cb = _v210_sample(src_row[0] + group, 2 * k) + _v210_sample(src_row[1] + group, 2 * k);
+			const uint32_t cr = _v210_sample(src_row[0] + group, 2 * k + 2) + _v210_sample(src_row[1] + group, 2 * k + 2);
+			if (p010) {
+				reinterpret_cast<uint16_t *>(dst_row_uv)[x] = static_cast<uint16_t>(((cb + 1) >> 1) << 6);
+				reinterpret_cast<uint16_t *>(dst_row_uv)[x + 1] = static_cast<uint16_t>(((cr + 1) >> 1) << 6);
+			}
+			else {
+				dst_row_uv[x] = static_cast<uint8_t>(((cb + 4) >> 3) > 255 ? 255 : ((cb + 4) >> 3));
+				dst_row_uv[x + 1] = static_cast<uint8_t>(((cr + 4) >> 3) > 255 ? 255 : ((cr + 4) >> 3));
+			}
+		} // for x
+	} // for y
+}
+
+// _ssse3_v210_unpack(): one v210 group -> luma {Y0..Y5}, chroma {Cb0 Cr0 Cb2 Cr2 Cb4 Cr4}
+//   (16-bit samples in words 0..5, words 6..7 are zero)
+static inline void _ssse3_v210_unpack(const __m128i group, __m128i &luma, __m128i &chroma)
+{
+	const __m128i mask10 = _mm_set1_epi32(0x3FF);
+	const __m128i mask10_hi = _mm_set1_epi32(0x3FF0000);
+
+	// 16-bit words:  lo = {Cb0 Y0 | Y1 Cb2 | Cr2 Y3 | Y4 Cr4}    hi = {Cr0 0 | Y2 0 | Cb4 0 | Y5 0}
+	const __m128i lo = _mm_or_si128(_mm_and_si128(group, mask10), _mm_and_si128(_mm_slli_epi32(group, 6), mask10_hi));
+	const __m128i hi = _mm_and_si128(_mm_srli_epi32(group, 20), mask10);
+
+	luma = _mm_or_si128(
+		_mm_shuffle_epi8(lo, _mm_setr_epi8(2, 3, 4, 5, -1, -1, 10, 11, 12, 13, -1, -1, -1, -1, -1, -1)),
+		_mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, -1, -1, 4, 5, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1))
+	);
+	chroma = _mm_or_si128(
+		_mm_shuffle_epi8(lo, _mm_setr_epi8(0, 1, -1, -1, 6, 7, 8, 9, -1, -1, 14, 15, -1, -1, -1, -1)),
+		_mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, 0, 1, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1, -1, -1))
+	);
+}
+
+// _ssse3_v210_pack4(): 4 unpacked groups (6 samples each) -> 3 registers of 8 samples
+static inline void _ssse3_v210_pack4(const __m128i g[4], __m128i out[3])
+{
+	out[0] = _mm_or_si128(g[0], _mm_slli_si128(g[1], 12));
+	out[1] = _mm_or_si128(_mm_srli_si128(g[1], 4), _mm_slli_si128(g[2], 8));
+	out[2] = _mm_or_si128(_mm_srli_si128(g[2], 8), _mm_slli_si128(g[3], 4));
+}
+
+void CRepackyuv::_convert_V210toNV12_ssse3( // convert packed(v210) into 2-plane(NV12)
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 48
+	const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	const __m128i  src_v210[], // source v210 plane (one 6-pixel group per __m128i)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	__m128i dest_y[],   // pointer to output Y-plane
+	__m128i dest_uv[]   // pointer to output UV-plane
+	)
+{
+	const __m128i round_y = _mm_set1_epi16(2);  // rounding offset for div/4 operation
+	const __m128i round_uv = _mm_set1_epi16(4); // rounding offset for div/8 operation
+
+	__m128i luma[2][8], chroma[8], c1, y16[2][6], uv16[6];
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		const __m128i *src_ptr = src_v210 + (y * src_stride); // scanline (scanline #y)
+		const __m128i *src_ptr_yp1 = src_ptr + src_stride;    // scanline (scanline #y+1)
+
+		__m128i *dst_ptr_y = dest_y + y * dst_stride;         // scanline (#y)
+		__m128i *dst_ptr_y_yp1 = dst_ptr_y + dst_stride;      // scanline (#y+1)
+		__m128i *dst_ptr_uv = dest_uv + (y >> 1) * dst_stride;
+
+		for (uint32_t x = 0; x < width; x += 48) {
+			// In each iteration, process 48 source pixels (8 groups)
+			//   from scanline #y and #(y+1)
+			for (uint32_t i = 0; i < 8; ++i) {
+				_ssse3_v210_unpack(_mm_load_si128(src_ptr++), luma[0][i], chroma[i]);
+				_ssse3_v210_unpack(_mm_load_si128(src_ptr_yp1++), luma[1][i], c1);
+				chroma[i] = _mm_add_epi16(chroma[i], c1);
+			}
+
+			for (uint32_t j = 0; j < 2; ++j) {
+				_ssse3_v210_pack4(&luma[0][j * 4], &y16[0][j * 3]);
+				_ssse3_v210_pack4(&luma[1][j * 4], &y16[1][j * 3]);
+				_ssse3_v210_pack4(&chroma[j * 4], &uv16[j * 3]);
+			}
+
+			// 10 -> 8 bits (packus_epi16 saturates 256 to 255)
+			for (uint32_t j = 0; j < 6; j += 2) {
+				_mm_store_si128(dst_ptr_y++, _mm_packus_epi16(
+					_mm_srli_epi16(_mm_add_epi16(y16[0][j], round_y), 2),
+					_mm_srli_epi16(_mm_add_epi16(y16[0][j + 1], round_y), 2)));
+				_mm_store_si128(dst_ptr_y_yp1++, _mm_packus_epi16(
+					_mm_srli_epi16(_mm_add_epi16(y16[1][j], round_y), 2),
+					_mm_srli_epi16(_mm_add_epi16(y16[1][j + 1], round_y), 2)));
+				_mm_store_si128(dst_ptr_uv++, _mm_packus_epi16(
+					_mm_srli_epi16(_mm_add_epi16(uv16[j], round_uv), 3),
+					_mm_srli_epi16(_mm_add_epi16(uv16[j + 1], round_uv), 3)));
+			}
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_V210toP010_ssse3( // convert packed(v210) into 2-plane(P010)
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 24
+	const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	const __m128i  src_v210[], // source v210 plane (one 6-pixel group per __m128i)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	__m128i dest_y[],   // pointer to output Y-plane
+	__m128i dest_uv[]   // pointer to output UV-plane
+	)
+{
+	const __m128i round_uv = _mm_set1_epi16(1); // rounding offset for div/2 operation
+
+	__m128i luma[2][4], chroma[4], c1, y16[2][3], uv16[3];
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		const __m128i *src_ptr = src_v210 + (y * src_stride); // scanline (scanline #y)
+		const __m128i *src_ptr_yp1 = src_ptr + src_stride;    // scanline (scanline #y+1)
+
+		__m128i *dst_ptr_y = dest_y + y * dst_stride;         // scanline (#y)
+		__m128i *dst_ptr_y_yp1 = dst_ptr_y + dst_stride;      // scanline (#y+1)
+		__m128i *dst_ptr_uv = dest_uv + (y >> 1) * dst_stride;
+
+		for (uint32_t x = 0; x < width; x += 24) {
+			// In each iteration, process 24 source pixels (4 groups)
+			//   from scanline #y and #(y+1)
+			for (uint32_t i = 0; i < 4; ++i) {
+				_ssse3_v210_unpack(_mm_load_si128(src_ptr++), luma[0][i], chroma[i]);
+				_ssse3_v210_unpack(_mm_load_si128(src_ptr_yp1++), luma[1][i], c1);
+				chroma[i] = _mm_add_epi16(chroma[i], c1);
+			}
+
+			_ssse3_v210_pack4(luma[0], y16[0]);
+			_ssse3_v210_pack4(luma[1], y16[1]);
+			_ssse3_v210_pack4(chroma, uv16);
+
+			for (uint32_t j = 0; j < 3; ++j) {
+				_mm_store_si128(dst_ptr_y++, _mm_slli_epi16(y16[0][j], 6));
+				_mm_store_si128(dst_ptr_y_yp1++, _mm_slli_epi16(y16[1][j], 6));
+				_mm_store_si128(dst_ptr_uv++, _mm_slli_epi16(
+					_mm_srli_epi16(_mm_add_epi16(uv16[j], round_uv), 1), 6));
+			}
+		} // for x
+	} // for y
+}
+
+// _avx2_v210_unpack(): two v210 groups (one per 128-bit lane) -> luma, chroma
+//   (same layout as _ssse3_v210_unpack, in each lane: 16-bit samples in words 0..5 of the lane)
+static inline void _avx2_v210_unpack(const __m256i group, __m256i &luma, __m256i &chroma)
+{
+	const __m256i mask10 = _mm256_set1_epi32(0x3FF);
+	const __m256i mask10_hi = _mm256_set1_epi32(0x3FF0000);
+
+	const __m256i lo = _mm256_or_si256(_mm256_and_si256(group, mask10), _mm256_and_si256(_mm256_slli_epi32(group, 6), mask10_hi));
+	const __m256i hi = _mm256_and_si256(_mm256_srli_epi32(group, 20), mask10);
+
+	luma = _mm256_or_si256(
+		_mm256_shuffle_epi8(lo, _mm256_setr_epi8(
+			2, 3, 4, 5, -1, -1, 10, 11, 12, 13, -1, -1, -1, -1, -1, -1,
+			2, 3, 4, 5, -1, -1, 10, 11, 12, 13, -1, -1, -1, -1, -1, -1)),
+		_mm256_shuffle_epi8(hi, _mm256_setr_epi8(
+			-1, -1, -1, -1, 4, 5, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1,
+			-1, -1, -1, -1, 4, 5, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1))
+	);
+	chroma = _mm256_or_si256(
+		_mm256_shuffle_epi8(lo, _mm256_setr_epi8(
+			0, 1, -1, -1, 6, 7, 8, 9, -1, -1, 14, 15, -1, -1, -1, -1,
+			0, 1, -1, -1, 6, 7, 8, 9, -1, -1, 14, 15, -1, -1, -1, -1)),
+		_mm256_shuffle_epi8(hi, _mm256_setr_epi8(
+			-1, -1, 0, 1, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1, -1, -1,
+			-1, -1, 0, 1, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1, -1, -1))
+	);
+}
+
+// _avx2_v210_pack4(): 4 unpacked registers (8 groups, 48 samples in dwords 0..2 and 4..6)
+//                     -> 3 registers of 16 samples
+static inline void _avx2_v210_pack4(const __m256i g[4], __m256i out[3])
+{
+	out[0] = _mm256_blend_epi32(
+		_mm256_permutevar8x32_epi32(g[0], _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 3)),
+		_mm256_permutevar8x32_epi32(g[1], _mm256_setr_epi32(3, 3, 3, 3, 3, 3, 0, 1)), 0xC0);
+	out[1] = _mm256_blend_epi32(
+		_mm256_permutevar8x32_epi32(g[1], _mm256_setr_epi32(2, 4, 5, 6, 3, 3, 3, 3)),
+		_mm256_permutevar8x32_epi32(g[2], _mm256_setr_epi32(3, 3, 3, 3, 0, 1, 2, 4)), 0xF0);
+	out[2] = _mm256_blend_epi32(
+		_mm256_permutevar8x32_epi32(g[2], _mm256_setr_epi32(5, 6, 3, 3, 3, 3, 3, 3)),
+		_mm256_permutevar8x32_epi32(g[3], _mm256_setr_epi32(3, 3, 0, 1, 2, 4, 5, 6)), 0xFC);
+}
+
+void CRepackyuv::_convert_V210toNV12_avx2( // convert packed(v210) into 2-plane(NV12)
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 96
+	const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	const __m256i  src_v210[], // source v210 plane (two 6-pixel groups per __m256i)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	__m256i dest_y[],   // pointer to output Y-plane
+	__m256i dest_uv[]   // pointer to output UV-plane
+	)
+{
+	const __m256i round_y = _mm256_set1_epi16(2);  // rounding offset for div/4 operation
+	const __m256i round_uv = _mm256_set1_epi16(4); // rounding offset for div/8 operation
+
+	__m256i luma[2][8], chroma[8], c1, y16[2][6], uv16[6];
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		const __m256i *src_ptr = src_v210 + (y * src_stride); // scanline (scanline #y)
+		const __m256i *src_ptr_yp1 = src_ptr + src_stride;    // scanline (scanline #y+1)
+
+		__m256i *dst_ptr_y = dest_y + y * dst_stride;         // scanline (#y)
+		__m256i *dst_ptr_y_yp1 = dst_ptr_y + dst_stride;      // scanline (#y+1)
+		__m256i *dst_ptr_uv = dest_uv + (y >> 1) * dst_stride;
+
+		for (uint32_t x = 0; x < width; x += 96) {
+			// In each iteration, process 96 source pixels (16 groups)
+			//   from scanline #y and #(y+1)
+			for (uint32_t i = 0; i < 8; ++i) {
+				_avx2_v210_unpack(_mm256_load_si256(src_ptr++), luma[0][i], chroma[i]);
+				_avx2_v210_unpack(_mm256_load_si256(src_ptr_yp1++), luma[1][i], c1);
+				chroma[i] = _mm256_add_epi16(chroma[i], c1);
+			}
+
+			for (uint32_t j = 0; j < 2; ++j) {
+				_avx2_v210_pack4(&luma[0][j * 4], &y16[0][j * 3]);
+				_avx2_v210_pack4(&luma[1][j * 4], &y16[1][j * 3]);
+				_avx2_v210_pack4(&chroma[j * 4], &uv16[j * 3]);
+			}
+
+			// 10 -> 8 bits (packus_epi16 saturates 256 to 255).
+			// packus_epi16 works per 128-bit lane; permute4x64 restores the pixel-order
+			for (uint32_t j = 0; j < 6; j += 2) {
+				_mm256_store_si256(dst_ptr_y++, _mm256_permute4x64_epi64(_mm256_packus_epi16(
+					_mm256_srli_epi16(_mm256_add_epi16(y16[0][j], round_y), 2),
+					_mm256_srli_epi16(_mm256_add_epi16(y16[0][j + 1], round_y), 2)), _MM_SHUFFLE(3, 1, 2, 0)));
+				_mm256_store_si256(dst_ptr_y_yp1++, _mm256_permute4x64_epi64(_mm256_packus_epi16(
+					_mm256_srli_epi16(_mm256_add_epi16(y16[1][j], round_y), 2),
+					_mm256_srli_epi16(_mm256_add_epi16(y16[1][j + 1], round_y), 2)), _MM_SHUFFLE(3, 1, 2, 0)));
+				_mm256_store_si256(dst_ptr_uv++, _mm256_permute4x64_epi64(_mm256_packus_epi16(
+					_mm256_srli_epi16(_mm256_add_epi16(uv16[j], round_uv), 3),
+					_mm256_srli_epi16(_mm256_add_epi16(uv16[j + 1], round_uv), 3)), _MM_SHUFFLE(3, 1, 2, 0)));
+			}
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_V210toP010_avx2( // convert packed(v210) into 2-plane(P010)
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 48
+	const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	const __m256i  src_v210[], // source v210 plane (two 6-pixel groups per __m256i)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	__m256i dest_y[],   // pointer to output Y-plane
+	__m256i dest_uv[]   // pointer to output UV-plane
+	)
+{
+	const __m256i round_uv = _mm256_set1_epi16(1); // rounding offset for div/2 operation
+
+	__m256i luma[2][4], chroma[4], c1, y16[2][3], uv16[3];
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		const __m256i *src_ptr = src_v210 + (y * src_stride); // scanline (scanline #y)
+		const __m256i *src_ptr_yp1 = src_ptr + src_stride;    // scanline (scanline #y+1)
+
+		__m256i *dst_ptr_y = dest_y + y * dst_stride;         // scanline (#y)
+		__m256i *dst_ptr_y_yp1 = dst_ptr_y + dst_stride;      // scanline (#y+1)
+		__m256i *dst_ptr_uv = dest_uv + (y >> 1) * dst_stride;
+
+		for (uint32_t x = 0; x < width; x += 48) {
+			// In each iteration, process 48 source pixels (8 groups)
+			//   from scanline #y and #(y+1)
+			for (uint32_t i = 0; i < 4; ++i) {
+				_avx2_v210_unpack(_mm256_load_si256(src_ptr++), luma[0][i], chroma[i]);
+				_avx2_v210_unpack(_mm256_load_si256(src_ptr_yp1++), luma[1][i], c1);
+				chroma[i] = _mm256_add_epi16(chroma[i], c1);
+			}
+
+			_avx2_v210_pack4(luma[0], y16[0]);
+			_avx2_v210_pack4(luma[1], y16[1]);
+			_avx2_v210_pack4(chroma, uv16);
+
+			for (uint32_t j = 0; j < 3; ++j) {
+				_mm256_store_si256(dst_ptr_y++, _mm256_slli_epi16(y16[0][j], 6));
+				_mm256_store_si256(dst_ptr_y_yp1++, _mm256_slli_epi16(y16[1][j], 6));
+				_mm256_store_si256(dst_ptr_uv++, _mm256_slli_epi16(
+					_mm256_srli_epi16(_mm256_add_epi16(uv16[j], round_uv), 1), 6));
+			}
+		} // for x
+	} // for y
+}
+
+////////////////////
+//
+// 8/16-bit integer RGB -> YUV converters
+//
+
+void CRepackyuv::_get_rgb2yuv_int_coeff(
+	const bool use_bt709,
+	const bool use_fullscale,
+	const bool src_16u,
+	rgb2yuv_int_coeff_t &coeff
+	) const
+{
+	// The float matrices hold {B, G, R, A} coefficients for samples 0.0 - 1.0, already scaled
+	// to the 8-bit output range (x255 full-scale, x220 video-scale.)  Rescale them for integer
+	// samples (0-255, or 0-8192 for 16u >> 2), with as many fraction bits as an int16 allows.
+	const double in_range = src_16u ? 8192.0 : 255.0;
+	float m[4];
+
+	coeff.src_16u  = src_16u;
+	coeff.shift    = src_16u ? 20 : 15;
+	coeff.offset_y = use_fullscale ? 0 : 16;
+
+	for (uint32_t c = 0; c < 3; ++c) {
+		_mm_storeu_ps(m, get_rgb2yuv_coeff_matrix128(use_bt709, use_fullscale, static_cast<select_color_t>(c)));
+		for (uint32_t i = 0; i < 3; ++i) {
+			const double k = m[i] * static_cast<double>(1 << coeff.shift) / in_range;
+			coeff.k[c][i] = static_cast<int16_t>(k >= 0.0 ? k + 0.5 : k - 0.5);
+		}
+	}
+}
+
+static inline uint8_t _rgb_int_clamp(const int32_t x)
+{
+	return static_cast<uint8_t>((x < 0) ? 0 : (x > 255) ? 255 : x);
+}
+
+// _rgb_int_pixel() - B/G/R of pixel #x (16u samples are shifted >> 2)
+static inline void _rgb_int_pixel(const uint8_t row[], const uint32_t x, const bool src_16u, int32_t bgr[3])
+{
+	if (src_16u) {
+		const uint16_t *p = reinterpret_cast<const uint16_t *>(row) + (x << 2);
+		for (uint32_t i = 0; i < 3; ++i)
+			bgr[i] = p[i] >> 2;
+	}
+	else {
+		const uint8_t *p = row + (x << 2);
+		for (uint32_t i = 0; i < 3; ++i)
+			bgr[i] = p[i];
+	}
+}
+
+static inline int32_t _rgb_int_dot(const int16_t k[3], const int32_t bgr[3])
+{
+	return k[0] * bgr[0] + k[1] * bgr[1] + k[2] * bgr[2];
+}
+
+void CRepackyuv::convert_RGBtoNV12( // convert packed(RGB 8u/16u) into 2-plane(NV12)
+	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+	const bool     use_fullscale, // true=PC/full scale, false=video(16-235)
+	const bool     src_16u,       // source: true=16 bits per channel, false=8 bits per channel
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_rgb[],  // source BGRA plane (32 or 64 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_uv[]   // pointer to output UV-plane
+	)
+{
+	rgb2yuv_int_coeff_t coeff;
+	_get_rgb2yuv_int_coeff(use_bt709, use_fullscale, src_16u, coeff);
+
+	bool is_xmm_aligned = m_cpu_has_ssse3;// are addresses 16-byte aligned?
+
+	// Check address-alignment of all planes
+	if (reinterpret_cast<uint64_t>(src_rgb) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_y) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_uv) & 0xF)
+		is_xmm_aligned = false;
+
+	if (src_stride & 0xF)
+		is_xmm_aligned = false;
+	else if (dst_stride & 0xF)
+		is_xmm_aligned = false;
+
+	if (height & 0x1)  // must have an even# scanlines
+		is_xmm_aligned = false;
+
+	bool is_avx256_aligned = is_xmm_aligned && m_cpu_has_avx2 && m_allow_avx2;
+	if (is_avx256_aligned) {
+		if (reinterpret_cast<uint64_t>(src_rgb) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_y) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_uv) & 0x1F)
+			is_avx256_aligned = false;
+
+		if (src_stride & 0x1F)
+			is_avx256_aligned = false;
+		else if (dst_stride & 0x1F)
+			is_avx256_aligned = false;
+	}
+
+	// The SIMD versions convert whole blocks (AVX2: 32 pixels, SSSE3: 16 pixels),
+	// the rest of each scanline is converted by the non-SSE version.
+	uint32_t x_begin = 0;
+	if (is_avx256_aligned && width >= 32) {
+		x_begin = width & ~0x1F;
+		_convert_RGBtoNV12_avx2( // AVX2 version of converter
+			coeff, x_begin, height,
+			src_stride >> 5, // src stride (units of _m256i)
+			reinterpret_cast<__m256i const *>(src_rgb),
+			dst_stride >> 5, // dst stride (units of _m256i)
+			reinterpret_cast<__m256i *>(dest_y),  // output Y
+			reinterpret_cast<__m256i *>(dest_uv)  // output UV
+		);
+	}
+	else if (is_xmm_aligned && width >= 16) {
+		x_begin = width & ~0xF;
+		_convert_RGBtoNV12_ssse3( // SSSE3 version of converter
+			coeff, x_begin, height,
+			src_stride >> 4, // src stride (units of _m128i)
+			reinterpret_cast<__m128i const *>(src_rgb),
+			dst_stride >> 4, // dst stride (units of _m128i)
+			reinterpret_cast<__m128i *>(dest_y),  // output Y
+			reinterpret_cast<__m128i *>(dest_uv)  // output UV
+		);
+	}
+
+	if (x_begin < width)
+		_convert_RGBtoNV12(  // non-SSE version (slow)
+			coeff, x_begin, width, height,
+			src_stride, src_rgb,
+			dst_stride,
+			dest_y,   // output Y
+			dest_uv   // output UV
+		);
+}
+
+void CRepackyuv::convert_RGBtoY444( // convert packed(RGB 8u/16u) into planar(YUV 4:4:4)
+	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+	const bool     use_fullscale, // true=PC/full scale, false=video(16-235)
+	const bool     src_16u,       // source: true=16 bits per channel, false=8 bits per channel
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_rgb[],  // source BGRA plane (32 or 64 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_u[],   // pointer to output U-plane
+	uint8_t dest_v[]    // pointer to output V-plane
+	)
+{
+	rgb2yuv_int_coeff_t coeff;
+	_get_rgb2yuv_int_coeff(use_bt709, use_fullscale, src_16u, coeff);
+
+	bool is_xmm_aligned = m_cpu_has_ssse3;// are addresses 16-byte aligned?
+
+	// Check address-alignment of all planes
+	if (reinterpret_cast<uint64_t>(src_rgb) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_y) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_u) & 0xF)
+		is_xmm_aligned = false;
+	else if (reinterpret_cast<uint64_t>(dest_v) & 0xF)
+		is_xmm_aligned = false;
+
+	if (src_stride & 0xF)
+		is_xmm_aligned = false;
+	else if (dst_stride & 0xF)
+		is_xmm_aligned = false;
+
+	bool is_avx256_aligned = is_xmm_aligned && m_cpu_has_avx2 && m_allow_avx2;
+	if (is_avx256_aligned) {
+		if (reinterpret_cast<uint64_t>(src_rgb) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_y) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_u) & 0x1F)
+			is_avx256_aligned = false;
+		else if (reinterpret_cast<uint64_t>(dest_v) & 0x1F)
+			is_avx256_aligned = false;
+
+		if (src_stride & 0x1F)
+			is_avx256_aligned = false;
+		else if (dst_stride & 0x1F)
+			is_avx256_aligned = false;
+	}
+
+	// The SIMD versions convert whole blocks (AVX2: 32 pixels, SSSE3: 16 pixels),
+	// the rest of each scanline is converted by the non-SSE version.
+	uint32_t x_begin = 0;
+	if (is_avx256_aligned && width >= 32) {
+		x_begin = width & ~0x1F;
+		_convert_RGBtoY444_avx2( // AVX2 version of converter
+			coeff, x_begin, height,
+			src_stride >> 5, // src stride (units of _m256i)
+			reinterpret_cast<__m256i const *>(src_rgb),
+			dst_stride >> 5, // dst stride (units of _m256i)
+			reinterpret_cast<__m256i *>(dest_y),  // output Y
+			reinterpret_cast<__m256i *>(dest_u),  // output U
+			reinterpret_cast<__m256i *>(dest_v)   // output V
+		);
+	}
+	else if (is_xmm_aligned && width >= 16) {
+		x_begin = width & ~0xF;
+		_convert_RGBtoY444_ssse3( // SSSE3 version of converter
+			coeff, x_begin, height,
+			src_stride >> 4, // src stride (units of _m128i)
+			reinterpret_cast<__m128i const *>(src_rgb),
+			dst_stride >> 4, // dst stride (units of _m128i)
+			reinterpret_cast<__m128i *>(dest_y),  // output Y
+			reinterpret_cast<__m128i *>(dest_u),  // output U
+			reinterpret_cast<__m128i *>(dest_v)   // output V
+		);
+	}
+
+	if (x_begin < width)
+		_convert_RGBtoY444(  // non-SSE version (slow)
+			coeff, x_begin, width, height,
+			src_stride, src_rgb,
+			dst_stride,
+			dest_y, dest_u, dest_v
+		);
+}
+
+void CRepackyuv::_convert_RGBtoNV12( // convert packed(RGB 8u/16u) into 2-plane(NV12), columns x_begin .. width-1
+	const rgb2yuv_int_coeff_t &coeff,
+	const uint32_t x_begin,    // first column (#pixels): must be even#
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_rgb[],  // source BGRA plane
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_uv[]   // pointer to output UV-plane
+	)
+{
+	const int32_t round_y = 1 << (coeff.shift - 1);
+	const int32_t round_uv = 1 << (coeff.shift + 1); // (sum of 4 pixels)
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		// (an odd# of scanlines: the last one is its own pair)
+		const uint32_t yp1 = (y + 1 < height) ? y + 1 : y;
+		const uint8_t *src_row[2] = { src_rgb + src_stride * y, src_rgb + src_stride * yp1 };
+		uint8_t *dst_row_y[2] = {
+			dest_y + dst_stride * (height - 1 - y),  // scanline (#y)
+			dest_y + dst_stride * (height - 1 - yp1) // scanline (#y+1)
+		};
+		uint8_t *dst_row_uv = dest_uv + dst_stride * ((height - 1 - y) >> 1);
+
+		for (uint32_t x = x_begin; x < width; x += 2) {
+			// (an odd# of pixels: the last one is its own pair)
+			const uint32_t xp1 = (x + 1 < width) ? x + 1 : x;
+			int32_t sum[3] = { 0, 0, 0 }, bgr[3];
+
+			for (uint32_t i = 0; i < 2; ++i) {
+				_rgb_int_pixel(src_row[i], x, coeff.src_16u, bgr);
+				dst_row_y[i][x] = _rgb_int_clamp(((_rgb_int_dot(coeff.k[SELECT_COLOR_Y], bgr) + round_y) >> coeff.shift) + coeff.offset_y);
+				for (uint32_t c = 0; c < 3; ++c)
+					sum[c] += bgr[c];
+
+				_rgb_int_pixel(src_row[i], xp1, coeff.src_16u, bgr);
+				dst_row_y[i][xp1] = _rgb_int_clamp(((_rgb_int_dot(coeff.k[SELECT_COLOR_Y], bgr) + round_y) >> coeff.shift) + coeff.offset_y);
+				for (uint32_t c = 0; c < 3; ++c)
+					sum[c] += bgr[c];
+			}
+
+			// the chroma of the 2x2 box: convert the sum of the 4 RGB pixels
+			dst_row_uv[x] = _rgb_int_clamp(((_rgb_int_dot(coeff.k[SELECT_COLOR_U], sum) + round_uv) >> (coeff.shift + 2)) + 128);
+			dst_row_uv[x + 1] = _rgb_int_clamp(((_rgb_int_dot(coeff.k[SELECT_COLOR_V], sum) + round_uv) >> (coeff.shift + 2)) + 128);
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_RGBtoY444( // convert packed(RGB 8u/16u) into planar(YUV 4:4:4), columns x_begin .. width-1
+	const rgb2yuv_int_coeff_t &coeff,
+	const uint32_t x_begin,    // first column (#pixels)
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_rgb[],  // source BGRA plane
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_u[],   // pointer to output U-plane
+	uint8_t dest_v[]    // pointer to output V-plane
+	)
+{
+	const int32_t round = 1 << (coeff.shift - 1);
+
+	for (uint32_t y = 0; y < height; ++y) {
+		const uint8_t *src_row = src_rgb + src_stride * y;
+		const uint32_t dst_offset = dst_stride * (height - 1 - y); // (flipped vertically)
+		int32_t bgr[3];
+
+		for (uint32_t x = x_begin; x < width; ++x) {
+			_rgb_int_pixel(src_row, x, coeff.src_16u, bgr);
+			dest_y[dst_offset + x] = _rgb_int_clamp(((_rgb_int_dot(coeff.k[SELECT_COLOR_Y], bgr) + round) >> coeff.shift) + coeff.offset_y);
+			dest_u[dst_offset + x] = _rgb_int_clamp(((_rgb_int_dot(coeff.k[SELECT_COLOR_U], bgr) + round) >> coeff.shift) + 128);
+			dest_v[dst_offset + x] = _rgb_int_clamp(((_rgb_int_dot(coeff.k[SELECT_COLOR_V], bgr) + round) >> coeff.shift) + 128);
+		}
+	}
+}
+
+// _ssse3_rgb_load4() - 4 source pixels into two registers of 2 pixels each, 16 bits per channel:
+//   B0 G0 R0 A0 B1 G1 R1 A1  (16u samples are shifted >> 2)
+static inline void _ssse3_rgb_load4(const __m128i *&src, const bool src_16u, __m128i &lo, __m128i &hi)
+{
+	if (src_16u) {
+		lo = _mm_srli_epi16(_mm_load_si128(src++), 2);
+		hi = _mm_srli_epi16(_mm_load_si128(src++), 2);
+	}
+	else {
+		const __m128i s = _mm_load_si128(src++);
+		lo = _mm_unpacklo_epi8(s, _mm_setzero_si128());
+		hi = _mm_unpackhi_epi8(s, _mm_setzero_si128());
+	}
+}
+
+// _ssse3_rgb_dot4() - {B, G, R, 0} x coefficients, for 4 pixels: 32-bit sums in pixel-order
+static inline __m128i _ssse3_rgb_dot4(const __m128i lo, const __m128i hi, const __m128i k)
+{
+	return _mm_hadd_epi32(_mm_madd_epi16(lo, k), _mm_madd_epi16(hi, k));
+}
+
+// _ssse3_rgb_scale8() - round and shift 8 fixed-point sums, and add the offset: 8 x int16
+static inline __m128i _ssse3_rgb_scale8(const __m128i d0, const __m128i d1,
+	const __m128i round, const __m128i shift, const __m128i offset)
+{
+	return _mm_add_epi16(_mm_packs_epi32(
+		_mm_sra_epi32(_mm_add_epi32(d0, round), shift),
+		_mm_sra_epi32(_mm_add_epi32(d1, round), shift)), offset);
+}
+
+static inline __m128i _ssse3_rgb_coeff(const int16_t k[3])
+{
+	return _mm_setr_epi16(k[0], k[1], k[2], 0, k[0], k[1], k[2], 0);
+}
+
+void CRepackyuv::_convert_RGBtoNV12_ssse3( // convert packed(RGB 8u/16u) into 2-plane(NV12)
+	const rgb2yuv_int_coeff_t &coeff,
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 16
+	const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	const __m128i  src_rgb[],  // source BGRA plane (4 pixels (8u) or 2 pixels (16u) per __m128i)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	__m128i dest_y[],   // pointer to output Y-plane
+	__m128i dest_uv[]   // pointer to output UV-plane
+	)
+{
+	const bool src_16u = coeff.src_16u;
+	const __m128i k_y = _ssse3_rgb_coeff(coeff.k[SELECT_COLOR_Y]);
+	const __m128i k_u = _ssse3_rgb_coeff(coeff.k[SELECT_COLOR_U]);
+	const __m128i k_v = _ssse3_rgb_coeff(coeff.k[SELECT_COLOR_V]);
+	const __m128i round_y = _mm_set1_epi32(1 << (coeff.shift - 1));
+	const __m128i round_uv = _mm_set1_epi32(1 << (coeff.shift + 1)); // (sum of 4 pixels)
+	const __m128i shift_y = _mm_cvtsi32_si128(coeff.shift);
+	const __m128i shift_uv = _mm_cvtsi32_si128(coeff.shift + 2);
+	const __m128i offset_y = _mm_set1_epi16(coeff.offset_y);
+	const __m128i offset_uv = _mm_set1_epi16(128);
+
+	__m128i lo[2][4], hi[2][4], d[4], u, v, uv[2];
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		const __m128i *src_ptr = src_rgb + (y * src_stride); // scanline (scanline #y)
+		const __m128i *src_ptr_yp1 = src_ptr + src_stride;   // scanline (scanline #y+1)
+
+		// Destination pointers (the image is flipped vertically)
+		__m128i *dst_ptr_y = dest_y + (height - 1 - y) * dst_stride;// scanline (#y)
+		__m128i *dst_ptr_y_yp1 = dst_ptr_y - dst_stride;            // scanline (#y+1)
+		__m128i *dst_ptr_uv = dest_uv + ((height - 1 - y) >> 1) * dst_stride;
+
+		for (uint32_t x = 0; x < width; x += 16) {
+			// In each iteration, process 16 source pixels (in 4 groups of 4)
+			//   from scanline #y and #(y+1)
+			for (uint32_t i = 0; i < 4; ++i) {
+				_ssse3_rgb_load4(src_ptr, src_16u, lo[0][i], hi[0][i]);
+				_ssse3_rgb_load4(src_ptr_yp1, src_16u, lo[1][i], hi[1][i]);
+			}
+
+			// Luma: one dot-product per pixel
+			for (uint32_t j = 0; j < 2; ++j) {
+				for (uint32_t i = 0; i < 4; ++i)
+					d[i] = _ssse3_rgb_dot4(lo[j][i], hi[j][i], k_y);
+				_mm_store_si128(j ? dst_ptr_y_yp1++ : dst_ptr_y++, _mm_packus_epi16(
+					_ssse3_rgb_scale8(d[0], d[1], round_y, shift_y, offset_y),
+					_ssse3_rgb_scale8(d[2], d[3], round_y, shift_y, offset_y)));
+			}
+
+			// Chroma: sum scanline#(y) and (y+1) in RGB (still fits int16),
+			//   then the horizontal pairs of dot-products -> the sum of the 2x2 box
+			for (uint32_t i = 0; i < 4; ++i) {
+				lo[0][i] = _mm_add_epi16(lo[0][i], lo[1][i]);
+				hi[0][i] = _mm_add_epi16(hi[0][i], hi[1][i]);
+			}
+			for (uint32_t j = 0; j < 2; ++j) {
+				u = _mm_hadd_epi32(
+					_ssse3_rgb_dot4(lo[0][2 * j], hi[0][2 * j], k_u),
+					_ssse3_rgb_dot4(lo[0][2 * j + 1], hi[0][2 * j + 1], k_u));
+				v = _mm_hadd_epi32(
+					_ssse3_rgb_dot4(lo[0][2 * j], hi[0][2 * j], k_v),
+					_ssse3_rgb_dot4(lo[0][2 * j + 1], hi[0][2 * j + 1], k_v));
+
+				// interleave U0 V0 U1 V1 ...
+				uv[j] = _ssse3_rgb_scale8(_mm_unpacklo_epi32(u, v), _mm_unpackhi_epi32(u, v),
+					round_uv, shift_uv, offset_uv);
+			}
+			_mm_store_si128(dst_ptr_uv++, _mm_packus_epi16(uv[0], uv[1]));
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_RGBtoY444_ssse3( // convert packed(RGB 8u/16u) into planar(YUV 4:4:4)
+	const rgb2yuv_int_coeff_t &coeff,
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 16
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	const __m128i  src_rgb[],  // source BGRA plane
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m128i]
+	__m128i dest_y[],   // pointer to output Y-plane
+	__m128i dest_u[],   // pointer to output U-plane
+	__m128i dest_v[]    // pointer to output V-plane
+	)
+{
+	const bool src_16u = coeff.src_16u;
+	const __m128i k[3] = {
+		_ssse3_rgb_coeff(coeff.k[SELECT_COLOR_Y]),
+		_ssse3_rgb_coeff(coeff.k[SELECT_COLOR_U]),
+		_ssse3_rgb_coeff(coeff.k[SELECT_COLOR_V])
+	};
+	const __m128i offset[3] = {
+		_mm_set1_epi16(coeff.offset_y), _mm_set1_epi16(128), _mm_set1_epi16(128)
+	};
+	const __m128i round = _mm_set1_epi32(1 << (coeff.shift - 1));
+	const __m128i shift = _mm_cvtsi32_si128(coeff.shift);
+
+	__m128i lo[4], hi[4], d[4];
+
+	for (uint32_t y = 0; y < height; ++y) {
+		const __m128i *src_ptr = src_rgb + (y * src_stride);
+		const uint32_t dst_offset = (height - 1 - y) * dst_stride; // (flipped vertically)
+		__m128i *dst_ptr[3] = { dest_y + dst_offset, dest_u + dst_offset, dest_v + dst_offset };
+
+		for (uint32_t x = 0; x < width; x += 16) {
+			// In each iteration, process 16 source pixels (in 4 groups of 4)
+			for (uint32_t i = 0; i < 4; ++i)
+				_ssse3_rgb_load4(src_ptr, src_16u, lo[i], hi[i]);
+
+			for (uint32_t c = 0; c < 3; ++c) {
+				for (uint32_t i = 0; i < 4; ++i)
+					d[i] = _ssse3_rgb_dot4(lo[i], hi[i], k[c]);
+				_mm_store_si128(dst_ptr[c]++, _mm_packus_epi16(
+					_ssse3_rgb_scale8(d[0], d[1], round, shift, offset[c]),
+					_ssse3_rgb_scale8(d[2], d[3], round, shift, offset[c])));
+			}
+		} // for x
+	} // for y
+}
+
+// _avx2_rgb_load8() - 8 source pixels into two registers, 16 bits per channel:
+//   lo = pixels 0,1 | 4,5   hi = pixels 2,3 | 6,7   (the per-lane order of the 8u unpack)
+static inline void _avx2_rgb_load8(const __m256i *&src, const bool src_16u, __m256i &lo, __m256i &hi)
+{
+	if (src_16u) {
+		const __m256i s0 = _mm256_load_si256(src++); // pixels 0-3
+		const __m256i s1 = _mm256_load_si256(src++); // pixels 4-7
+		lo = _mm256_srli_epi16(_mm256_permute2x128_si256(s0, s1, 0x20), 2);
+		hi = _mm256_srli_epi16(_mm256_permute2x128_si256(s0, s1, 0x31), 2);
+	}
+	else {
+		const __m256i s = _mm256_load_si256(src++);
+		lo = _mm256_unpacklo_epi8(s, _mm256_setzero_si256());
+		hi = _mm256_unpackhi_epi8(s, _mm256_setzero_si256());
+	}
+}
+
+// _avx2_rgb_dot8() - 32-bit sums for 8 pixels, in pixel-order
+static inline __m256i _avx2_rgb_dot8(const __m256i lo, const __m256i hi, const __m256i k)
+{
+	return _mm256_hadd_epi32(_mm256_madd_epi16(lo, k), _mm256_madd_epi16(hi, k));
+}
+
+static inline __m256i _avx2_rgb_scale16(const __m256i d0, const __m256i d1,
+	const __m256i round, const __m128i shift, const __m256i offset)
+{
+	return _mm256_add_epi16(_mm256_packs_epi32(
+		_mm256_sra_epi32(_mm256_add_epi32(d0, round), shift),
+		_mm256_sra_epi32(_mm256_add_epi32(d1, round), shift)), offset);
+}
+
+void CRepackyuv::_convert_RGBtoNV12_avx2( // convert packed(RGB 8u/16u) into 2-plane(NV12)
+	const rgb2yuv_int_coeff_t &coeff,
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 32
+	const uint32_t height,     // Y-dimension (#pixels): must be multiple of 2
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	const __m256i  src_rgb[],  // source BGRA plane (8 pixels (8u) or 4 pixels (16u) per __m256i)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	__m256i dest_y[],   // pointer to output Y-plane
+	__m256i dest_uv[]   // pointer to output UV-plane
+	)
+{
+	// (same as the SSSE3 version, in each 128-bit lane)
+	const bool src_16u = coeff.src_16u;
+	const __m256i k_y = _mm256_broadcastsi128_si256(_ssse3_rgb_coeff(coeff.k[SELECT_COLOR_Y]));
+	const __m256i k_u = _mm256_broadcastsi128_si256(_ssse3_rgb_coeff(coeff.k[SELECT_COLOR_U]));
+	const __m256i k_v = _mm256_broadcastsi128_si256(_ssse3_rgb_coeff(coeff.k[SELECT_COLOR_V]));
+	const __m256i round_y = _mm256_set1_epi32(1 << (coeff.shift - 1));
+	const __m256i round_uv = _mm256_set1_epi32(1 << (coeff.shift + 1)); // (sum of 4 pixels)
+	const __m128i shift_y = _mm_cvtsi32_si128(coeff.shift);
+	const __m128i shift_uv = _mm_cvtsi32_si128(coeff.shift + 2);
+	const __m256i offset_y = _mm256_set1_epi16(coeff.offset_y);
+	const __m256i offset_uv = _mm256_set1_epi16(128);
+
+	// The pack ops work per 128-bit lane: the 4-pixel groups come out as
+	//   lane 0: pixels 0-3, 8-11, 16-19, 24-27   lane 1: pixels 4-7, 12-15, 20-23, 28-31
+	const __m256i permc_groups = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+	__m256i lo[2][4], hi[2][4], d[4], u, v, uv[2];
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		const __m256i *src_ptr = src_rgb + (y * src_stride); // scanline (scanline #y)
+		const __m256i *src_ptr_yp1 = src_ptr + src_stride;   // scanline (scanline #y+1)
+
+		// Destination pointers (the image is flipped vertically)
+		__m256i *dst_ptr_y = dest_y + (height - 1 - y) * dst_stride;// scanline (#y)
+		__m256i *dst_ptr_y_yp1 = dst_ptr_y - dst_stride;            // scanline (#y+1)
+		__m256i *dst_ptr_uv = dest_uv + ((height - 1 - y) >> 1) * dst_stride;
+
+		for (uint32_t x = 0; x < width; x += 32) {
+			// In each iteration, process 32 source pixels (in 4 groups of 8)
+			//   from scanline #y and #(y+1)
+			for (uint32_t i = 0; i < 4; ++i) {
+				_avx2_rgb_load8(src_ptr, src_16u, lo[0][i], hi[0][i]);
+				_avx2_rgb_load8(src_ptr_yp1, src_16u, lo[1][i], hi[1][i]);
+			}
+
+			for (uint32_t j = 0; j < 2; ++j) {
+				for (uint32_t i = 0; i < 4; ++i)
+					d[i] = _avx2_rgb_dot8(lo[j][i], hi[j][i], k_y);
+				_mm256_store_si256(j ? dst_ptr_y_yp1++ : dst_ptr_y++, _mm256_permutevar8x32_epi32(
+					_mm256_packus_epi16(
+						_avx2_rgb_scale16(d[0], d[1], round_y, shift_y, offset_y),
+						_avx2_rgb_scale16(d[2], d[3], round_y, shift_y, offset_y)), permc_groups));
+			}
+
+			for (uint32_t i = 0; i < 4; ++i) {
+				lo[0][i] = _mm256_add_epi16(lo[0][i], lo[1][i]);
+				hi[0][i] = _mm256_add_epi16(hi[0][i], hi[1][i]);
+			}
+			for (uint32_t j = 0; j < 2; ++j) {
+				u = _mm256_hadd_epi32(
+					_avx2_rgb_dot8(lo[0][2 * j], hi[0][2 * j], k_u),
+					_avx2_rgb_dot8(lo[0][2 * j + 1], hi[0][2 * j + 1], k_u));
+				v = _mm256_hadd_epi32(
+					_avx2_rgb_dot8(lo[0][2 * j], hi[0][2 * j], k_v),
+					_avx2_rgb_dot8(lo[0][2 * j + 1], hi[0][2 * j + 1], k_v));
+
+				uv[j] = _avx2_rgb_scale16(_mm256_unpacklo_epi32(u, v), _mm256_unpackhi_epi32(u, v),
+					round_uv, shift_uv, offset_uv);
+			}
+			_mm256_store_si256(dst_ptr_uv++, _mm256_permutevar8x32_epi32(
+				_mm256_packus_epi16(uv[0], uv[1]), permc_groups));
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_RGBtoY444_avx2( // convert packed(RGB 8u/16u) into planar(YUV 4:4:4)
+	const rgb2yuv_int_coeff_t &coeff,
+	const uint32_t width,      // X-dimension (#pixels): must be multiple of 32
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	const __m256i  src_rgb[],  // source BGRA plane
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of __m256i]
+	__m256i dest_y[],   // pointer to output Y-plane
+	__m256i dest_u[],   // pointer to output U-plane
+	__m256i dest_v[]    // pointer to output V-plane
+	)
+{
+	const bool src_16u = coeff.src_16u;
+	const __m256i k[3] = {
+		_mm256_broadcastsi128_si256(_ssse3_rgb_coeff(coeff.k[SELECT_COLOR_Y])),
+		_mm256_broadcastsi128_si256(_ssse3_rgb_coeff(coeff.k[SELECT_COLOR_U])),
+		_mm256_broadcastsi128_si256(_ssse3_rgb_coeff(coeff.k[SELECT_COLOR_V]))
+	};
+	const __m256i offset[3] = {
+		_mm256_set1_epi16(coeff.offset_y), _mm256_set1_epi16(128), _mm256_set1_epi16(128)
+	};
+	const __m256i round = _mm256_set1_epi32(1 << (coeff.shift - 1));
+	const __m128i shift = _mm_cvtsi32_si128(coeff.shift);
+	const __m256i permc_groups = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+	__m256i lo[4], hi[4], d[4];
+
+	for (uint32_t y = 0; y < height; ++y) {
+		const __m256i *src_ptr = src_rgb + (y * src_stride);
+		const uint32_t dst_offset = (height - 1 - y) * dst_stride; // (flipped vertically)
+		__m256i *dst_ptr[3] = { dest_y + dst_offset, dest_u + dst_offset, dest_v + dst_offset };
+
+		for (uint32_t x = 0; x < width; x += 32) {
+			// In each iteration, process 32 source pixels (in 4 groups of 8)
+			for (uint32_t i = 0; i < 4; ++i)
+				_avx2_rgb_load8(src_ptr, src_16u, lo[i], hi[i]);
+
+			for (uint32_t c = 0; c < 3; ++c) {
+				for (uint32_t i = 0; i < 4; ++i)
+					d[i] = _avx2_rgb_dot8(lo[i], hi[i], k[c]);
+				_mm256_store_si256(dst_ptr[c]++, _mm256_permutevar8x32_epi32(
+					_mm256_packus_epi16(
+						_avx2_rgb_scale16(d[0], d[1], round, shift, offset[c]),
+						_avx2_rgb_scale16(d[2], d[3], round, shift, offset[c])), permc_groups));
+			}
+		} // for x
+	} // for y
+}
+
+#ifdef CREPACKYUV_ENABLE_AVX512
+
+////////////////////
+//
+// AVX-512 (F/BW/VL) versions of the converters
+//
+
+// mask with the lower n bits set (n <= 64)
+#define AVX512_MASK16(n) static_cast<__mmask16>( ((n) >= 16) ? 0xFFFFu : ((1u << (n)) - 1) )
+#define AVX512_MASK32(n) static_cast<__mmask32>( ((n) >= 32) ? 0xFFFFFFFFu : ((1u << (n)) - 1) )
+#define AVX512_MASK64(n) static_cast<__mmask64>( ((n) >= 64) ? ~0ULL : ((1ULL << (n)) - 1) )
+
+// _avx512_coeff(): broadcast float element #i of an RGB->YUV coefficient matrix
+//                  to all 16 lanes of a zmm register
+static inline __m512 _avx512_coeff(const __m256 cmatrix, const int i)
+{
+	return _mm512_permutexvar_ps(_mm512_set1_epi32(i), _mm512_castps256_ps512(cmatrix));
+}
+
+// _avx512_rgbf_to_yuvf(): convert 16 packed RGBf32 pixels into planar Y/U/V (float)
+//
+//   The sum is evaluated in the same order as the hadd-based SSE/AVX versions
+//        ((c0*p0 + c1*p1) + (c2*p2 + c3*p3))
+//   so the AVX-512 output is bit-identical to the AVX2 output.
+static inline void _avx512_rgbf_to_yuvf(
+	const __m512 coeff[12], // {Y: c0..c3, U: c0..c3, V: c0..c3}
+	const __m512 src[4],    // 16 RGBf32 pixels (4 pixels per register)
+	__m512 &out_y, __m512 &out_u, __m512 &out_v
+	)
+{
+	// de-interleave 4 registers of packed-pixels {c0 c1 c2 c3} into 4 planes
+	const __m512i idx_01 = _mm512_set_epi32(29, 25, 21, 17, 13, 9, 5, 1, 28, 24, 20, 16, 12, 8, 4, 0);
+	const __m512i idx_23 = _mm512_set_epi32(31, 27, 23, 19, 15, 11, 7, 3, 30, 26, 22, 18, 14, 10, 6, 2);
+	const __m512i idx_lo = _mm512_set_epi32(23, 22, 21, 20, 19, 18, 17, 16, 7, 6, 5, 4, 3, 2, 1, 0);
+	const __m512i idx_hi = _mm512_set_epi32(31, 30, 29, 28, 27, 26, 25, 24, 15, 14, 13, 12, 11, 10, 9, 8);
+
+	const __m512 c01_a = _mm512_permutex2var_ps(src[0], idx_01, src[1]);// c0 {pixels 0..7}, c1 {pixels 0..7}
+	const __m512 c23_a = _mm512_permutex2var_ps(src[0], idx_23, src[1]);// c2 {pixels 0..7}, c3 {pixels 0..7}
+	const __m512 c01_b = _mm512_permutex2var_ps(src[2], idx_01, src[3]);// c0 {pixels 8..15}, c1 {pixels 8..15}
+	const __m512 c23_b = _mm512_permutex2var_ps(src[2], idx_23, src[3]);// c2 {pixels 8..15}, c3 {pixels 8..15}
+
+	const __m512 p0 = _mm512_permutex2var_ps(c01_a, idx_lo, c01_b);// channel#0, pixels 0..15
+	const __m512 p1 = _mm512_permutex2var_ps(c01_a, idx_hi, c01_b);// channel#1
+	const __m512 p2 = _mm512_permutex2var_ps(c23_a, idx_lo, c23_b);// channel#2
+	const __m512 p3 = _mm512_permutex2var_ps(c23_a, idx_hi, c23_b);// channel#3 (alpha)
+
+	out_y = _mm512_add_ps(
+		_mm512_add_ps(_mm512_mul_ps(p0, coeff[0]), _mm512_mul_ps(p1, coeff[1])),
+		_mm512_add_ps(_mm512_mul_ps(p2, coeff[2]), _mm512_mul_ps(p3, coeff[3]))
+	);
+	out_u = _mm512_add_ps(
+		_mm512_add_ps(_mm512_mul_ps(p0, coeff[4]), _mm512_mul_ps(p1, coeff[5])),
+		_mm512_add_ps(_mm512_mul_ps(p2, coeff[6]), _mm512_mul_ps(p3, coeff[7]))
+	);
+	out_v = _mm512_add_ps(
+		_mm512_add_ps(_mm512_mul_ps(p0, coeff[8]), _mm512_mul_ps(p1, coeff[9])),
+		_mm512_add_ps(_mm512_mul_ps(p2, coeff[10]), _mm512_mul_ps(p3, coeff[11]))
+	);
+}
+
+// _avx512_yuvf_to_8bit(): convert 16 float samples into 16 unsigned 8-bit samples
+//    round -> int32 -> int16 (signed saturate) -> add offset (saturate) -> uint8 (saturate)
+//    (this is the same sequence of saturations as the AVX2 pack_epi32/adds_epi16/packus_epi16)
+static inline __m128i _avx512_yuvf_to_8bit(const __m512 yuvf, const __m256i offset)
+{
+	__m512i i32 = _mm512_cvttps_epi32(_mm512_roundscale_ps(yuvf, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+	__m256i i16 = _mm256_adds_epi16(_mm512_cvtsepi32_epi16(i32), offset);
+	return _mm256_cvtusepi16_epi8(_mm256_max_epi16(i16, _mm256_setzero_si256()));
+}
+
+void CRepackyuv::_convert_YUV420toNV12_avx512( // convert planar(YV12) into planar(NV12)
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint8_t * const src_yuv[3],
+	const uint32_t src_stride[3], // stride for src_yuv[3] [units of uint8_t]
+	uint8_t dest_nv12_luma[], uint8_t dest_nv12_chroma[],
+	const uint32_t dstStride // stride [units of uint8_t]
+	)
+{
+	const uint32_t half_height = (height + 1) >> 1;  // round_up( height / 2 )
+	const uint32_t half_width  = (width + 1) >> 1;   // round_up( width / 2 )
+
+	// copy the luma portion of the framebuffer: 64 pixels per zmm-register
+	for (uint32_t y = 0; y < height; ++y) {
+		const uint8_t *src_ptr = src_yuv[0] + y * src_stride[0];
+		uint8_t       *dst_ptr = dest_nv12_luma + y * dstStride;
+
+		for (uint32_t x = 0; x < width; x += 64) {
+			const __mmask64 m = AVX512_MASK64(width - x);
+			_mm512_mask_storeu_epi8(dst_ptr + x, m, _mm512_maskz_loadu_epi8(m, src_ptr + x));
+		} // for x
+	} // for y
+
+	// interleave the chroma portion of the framebuffer: 32 U/V-pairs per zmm-register
+	for (uint32_t y = 0; y < half_height; ++y) {
+		const uint8_t *src_u = src_yuv[1] + y * src_stride[1];
+		const uint8_t *src_v = src_yuv[2] + y * src_stride[2];
+		uint8_t       *dst_ptr = dest_nv12_chroma + y * dstStride;
+
+		for (uint32_t x = 0; x < half_width; x += 32) {
+			const uint32_t n = half_width - x;// #remaining U/V-pairs in this scanline
+			const __mmask32 m_src = AVX512_MASK32(n);
+			const __mmask64 m_dst = AVX512_MASK64(n << 1);
+
+			// zero-extend U, V into 16-bit words, then merge: word = (V << 8) | U
+			__m512i u16 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m_src, src_u + x));
+			__m512i v16 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m_src, src_v + x));
+			__m512i uv  = _mm512_or_si512(u16, _mm512_slli_epi16(v16, 8));
+
+			_mm512_mask_storeu_epi8(dst_ptr + (x << 1), m_dst, uv);
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_YUV444toY444_avx512( // convert packed-pixel(Y444) into planar(4:4:4)
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_444[],  // pointer to input (YUV444 packed) surface
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_u[],   // pointer to output U-plane
+	uint8_t dest_v[]    // pointer to output V-plane
+	)
+{
+	// source packed-pixel (32bpp):  byte#0 = V, byte#1 = U, byte#2 = Y, byte#3 = A
+	for (uint32_t y = 0; y < height; ++y) {
+		const uint8_t *src_ptr = src_444 + y * src_stride;
+		const uint32_t dst_offset = (height - 1 - y) * dst_stride;// invert the image vertically
+
+		for (uint32_t x = 0; x < width; x += 16) {
+			// process 16 pixels per iteration: (x .. x+15)
+			const __mmask16 m = AVX512_MASK16(width - x);
+			const __m512i in_444 = _mm512_maskz_loadu_epi32(m, src_ptr + (x << 2));
+
+			// truncate each 32-bit pixel to the selected 8-bit component
+			_mm_mask_storeu_epi8(dest_y + dst_offset + x, m, _mm512_cvtepi32_epi8(_mm512_srli_epi32(in_444, 16)));
+			_mm_mask_storeu_epi8(dest_u + dst_offset + x, m, _mm512_cvtepi32_epi8(_mm512_srli_epi32(in_444, 8)));
+			_mm_mask_storeu_epi8(dest_v + dst_offset + x, m, _mm512_cvtepi32_epi8(in_444));
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_YUV422toNV12_avx512( // convert packed-pixel(Y422) into 2-plane(NV12)
+	const bool     mode_uyvy,  // chroma-order: true=UYVY, false=YUYV
+	const uint32_t width,      // X-dimension (#pixels): must be even#
+	const uint32_t height,     // Y-dimension (#pixels): must be even#
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_422[],  // pointer to input (YUV422 packed) surface
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_uv[]   // pointer to output UV-plane
+	)
+{
+	// UYVY: the Y-samples are the odd bytes, the U/V-samples are the even bytes
+	// YUYV: the Y-samples are the even bytes, the U/V-samples are the odd bytes
+	const int shift_y  = mode_uyvy ? 8 : 0;
+	const int shift_uv = mode_uyvy ? 0 : 8;
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		const uint8_t *src_ptr_y   = src_422 + y * src_stride;// scanline #y
+		const uint8_t *src_ptr_yp1 = src_ptr_y + src_stride;  // scanline #y+1
+		uint8_t *dst_ptr_y   = dest_y + y * dst_stride;
+		uint8_t *dst_ptr_yp1 = dst_ptr_y + dst_stride;
+		uint8_t *dst_ptr_uv  = dest_uv + (y >> 1) * dst_stride;
+
+		for (uint32_t x = 0; x < width; x += 32) {
+			// process 32 pixels (64 bytes) per scanline per iteration: (x .. x+31)
+			const uint32_t n = width - x; // #remaining pixels in this scanline
+			const __mmask32 m_src = AVX512_MASK32(n);   // 16-bit units (1 pixel)
+			const __mmask32 m_dst = AVX512_MASK32(n);   // 8-bit units
+
+			const __m512i src0 = _mm512_maskz_loadu_epi16(m_src, src_ptr_y + (x << 1));
+			const __m512i src1 = _mm512_maskz_loadu_epi16(m_src, src_ptr_yp1 + (x << 1));
+
+			// luma: select 1 byte from each 16-bit word
+			_mm256_mask_storeu_epi8(dst_ptr_y + x, m_dst, _mm512_cvtepi16_epi8(_mm512_srli_epi16(src0, shift_y)));
+			_mm256_mask_storeu_epi8(dst_ptr_yp1 + x, m_dst, _mm512_cvtepi16_epi8(_mm512_srli_epi16(src1, shift_y)));
+
+			// chroma: the U/V bytes are already in NV12 order (U, V, U, V ...),
+			//    average scanlines (y) and (y+1)
+			const __m256i uv0 = _mm512_cvtepi16_epi8(_mm512_srli_epi16(src0, shift_uv));
+			const __m256i uv1 = _mm512_cvtepi16_epi8(_mm512_srli_epi16(src1, shift_uv));
+			_mm256_mask_storeu_epi8(dst_ptr_uv + x, m_dst, _mm256_avg_epu8(uv0, uv1));
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_RGBFtoY444_avx512( // convert packed(RGB f32) into planar(YUV 8bpp)
+	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+	const bool     use_fullscale, // true=PC/full scale, false=video(16-235)
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_u[],   // pointer to output U-plane
+	uint8_t dest_v[]    // pointer to output V-plane
+	)
+{
+	__m512 coeff[12];
+	for (int i = 0; i < 4; ++i) {
+		coeff[i]     = _avx512_coeff(get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_Y), i);
+		coeff[i + 4] = _avx512_coeff(get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_U), i);
+		coeff[i + 8] = _avx512_coeff(get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_V), i);
+	}
+
+	const __m256i offset_y  = _mm256_set1_epi16(use_fullscale ? 0 : 16);
+	const __m256i offset_uv = _mm256_set1_epi16(128);
+
+	__m512  src[4];
+	__m512  yf, uf, vf;
+
+	for (uint32_t y = 0; y < height; ++y) {
+		const float *src_ptr = reinterpret_cast<const float *>(src_rgb + y * src_stride);
+		const uint32_t dst_offset = (height - 1 - y) * dst_stride;// invert the image vertically
+
+		for (uint32_t x = 0; x < width; x += 16) {
+			// process 16 RGBf32 pixels per iteration (4 pixels per zmm register)
+			const uint32_t n = width - x; // #remaining pixels in this scanline
+			for (uint32_t i = 0; i < 4; ++i) {
+				const uint32_t n_i = (n > (i << 2)) ? (n - (i << 2)) : 0;// #valid pixels in src[i]
+				src[i] = _mm512_maskz_loadu_ps(AVX512_MASK16(n_i << 2), src_ptr + ((x + (i << 2)) << 2));
+			}
+
+			_avx512_rgbf_to_yuvf(coeff, src, yf, uf, vf);
+
+			const __mmask16 m = AVX512_MASK16(n);
+			_mm_mask_storeu_epi8(dest_y + dst_offset + x, m, _avx512_yuvf_to_8bit(yf, offset_y));
+			_mm_mask_storeu_epi8(dest_u + dst_offset + x, m, _avx512_yuvf_to_8bit(uf, offset_uv));
+			_mm_mask_storeu_epi8(dest_v + dst_offset + x, m, _avx512_yuvf_to_8bit(vf, offset_uv));
+		} // for x
+	} // for y
+}
+
+void CRepackyuv::_convert_RGBFtoNV12_avx512( // convert packed(RGB f32) into 2-plane(NV12)
+	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+	const bool     use_fullscale, // true=PC/full scale, false=video(16-235)
+	const uint32_t width,      // X-dimension (#pixels): must be even#
+	const uint32_t height,     // Y-dimension (#pixels): must be even#
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_uv[]   // pointer to output UV-plane
+	)
+{
+	__m512 coeff[12];
+	for (int i = 0; i < 4; ++i) {
+		coeff[i]     = _avx512_coeff(get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_Y), i);
+		coeff[i + 4] = _avx512_coeff(get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_U), i);
+		coeff[i + 8] = _avx512_coeff(get_rgb2yuv_coeff_matrix256(use_bt709, use_fullscale, SELECT_COLOR_V), i);
+	}
+
+	const __m256i offset_y = _mm256_set1_epi16(use_fullscale ? 0 : 16);
+
+	// The U/V-offset is +128.  Here the regvalue is scaled up by x4 to
+	// compensate for a divide-by-4 operation (+2 rounds the division.)
+	const __m256i offset_uv = _mm256_set1_epi16(512 + 2);
+
+	// gather the even / odd pixels' U and V into interleaved U/V-pairs:
+	//    even = { U0 V0 U2 V2 ... U14 V14 },  odd = { U1 V1 U3 V3 ... U15 V15 }
+	const __m512i idx_even = _mm512_set_epi32(30, 14, 28, 12, 26, 10, 24, 8, 22, 6, 20, 4, 18, 2, 16, 0);
+	const __m512i idx_odd  = _mm512_set_epi32(31, 15, 29, 13, 27, 11, 25, 9, 23, 7, 21, 5, 19, 3, 17, 1);
+
+	__m512  src[4];
+	__m512  yf[2], uf[2], vf[2];
+
+	for (uint32_t y = 0; y < height; y += 2) {
+		// Source-pointers: RGB32f-surface
+		const float *src_ptr     = reinterpret_cast<const float *>(src_rgb + y * src_stride);// scanline #y
+		const float *src_ptr_yp1 = reinterpret_cast<const float *>(src_rgb + (y + 1) * src_stride);// scanline #y+1
+
+		// Destination pointers (the image is inverted vertically)
+		uint8_t *dst_ptr_y     = dest_y + (height - 1 - y) * dst_stride;// scanline (#y)
+		uint8_t *dst_ptr_y_yp1 = dst_ptr_y - dst_stride;                 // scanline (#y+1)
+		uint8_t *dst_ptr_uv    = dest_uv + ((height - 1 - y) >> 1) * dst_stride;
+
+		for (uint32_t x = 0; x < width; x += 16) {
+			// process 16 RGBf32 pixels from each of scanlines #y and #y+1
+			//    -> 16 Y-pixels per scanline, and 8 U/V-pairs
+			const uint32_t n = width - x; // #remaining pixels in this scanline
+			const __mmask16 m = AVX512_MASK16(n);
+
+			for (uint32_t k = 0; k < 2; ++k) {
+				const float *p = (k == 0) ? src_ptr : src_ptr_yp1;
+				for (uint32_t i = 0; i < 4; ++i) {
+					const uint32_t n_i = (n > (i << 2)) ? (n - (i << 2)) : 0;// #valid pixels in src[i]
+					src[i] = _mm512_maskz_loadu_ps(AVX512_MASK16(n_i << 2), p + ((x + (i << 2)) << 2));
+				}
+				_avx512_rgbf_to_yuvf(coeff, src, yf[k], uf[k], vf[k]);
+			} // for k
+
+			_mm_mask_storeu_epi8(dst_ptr_y + x, m, _avx512_yuvf_to_8bit(yf[0], offset_y));
+			_mm_mask_storeu_epi8(dst_ptr_y_yp1 + x, m, _avx512_yuvf_to_8bit(yf[1], offset_y));
+
+			// Handle (chroma) UV-plane:
+			//    (a) sum scanline#(y) and (y+1)
+			//    (b) sum horizontal pixel-pairs (x) and (x+1)
+			//    (c) divide by 4, and convert from 32bit-float to 8-bit int
+			const __m512 sum_u = _mm512_add_ps(uf[0], uf[1]);
+			const __m512 sum_v = _mm512_add_ps(vf[0], vf[1]);
+			const __m512 sum_uv = _mm512_add_ps(
+				_mm512_permutex2var_ps(sum_u, idx_even, sum_v),
+				_mm512_permutex2var_ps(sum_u, idx_odd, sum_v)
+			);
+
+			__m512i i32 = _mm512_cvttps_epi32(_mm512_roundscale_ps(sum_uv, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+			__m256i i16 = _mm256_adds_epi16(_mm512_cvtsepi32_epi16(i32), offset_uv);// +128 and rounding offset
+			i16 = _mm256_srai_epi16(i16, 2); // re-normalize to 8-bit magnitude
+			_mm_mask_storeu_epi8(dst_ptr_uv + x, m, _mm256_cvtusepi16_epi8(_mm256_max_epi16(i16, _mm256_setzero_si256())));
+		} // for x
+	} // for y
+}
+
+#endif // CREPACKYUV_ENABLE_AVX512
@@ -0,0 +1,219 @@
+#include <cstring>   // memset()
+
+#include "crepackyuv_mt.h"
+#include "xcodeutil.h"  // GetCPUCoreCount(), NvQueryPerformanceCounter()
+
+////////////////////
+//
+// CRepackyuvWorkerThread
+//
+
+CRepackyuvWorkerThread::CRepackyuvWorkerThread(CRepackyuvMT *pOwner, const uint32_t thread_idx) :
+	CNvThread("CRepackyuvWorkerThread"),
+	m_pOwner(pOwner), m_thread_idx(thread_idx), m_bHasWork(false), m_band_idx(0),
+	m_evDone(false, false) // auto-reset, initially not signalled
+{
+}
+
+CRepackyuvWorkerThread::~CRepackyuvWorkerThread()
+{
+}
+
+void CRepackyuvWorkerThread::Dispatch(const uint32_t band_idx)
+{
+	m_band_idx = band_idx;
+	m_bHasWork = true;
+	ThreadTrigger();
+}
+
+void CRepackyuvWorkerThread::WaitDone()
+{
+	m_evDone.Wait((U32)INvThreading::NV_TIMEOUT_INFINITE);
+}
+
+bool CRepackyuvWorkerThread::ThreadFunc()
+{
+	if (m_bHasWork) {
+		m_bHasWork = false;
+		m_pOwner->_run_band(m_band_idx, m_thread_idx);
+		m_evDone.Set();
+	}
+
+	return false; // sleep until the next Dispatch()
+}
+
+////////////////////
+//
+// CRepackyuvMT
+//
+
+CRepackyuvMT::CRepackyuvMT() :
+	m_num_threads(1), m_num_workers(0), m_num_bands(0), m_us_per_tick(0.0)
+{
+	memset( (void *)m_workers, 0, sizeof(m_workers) );
+	memset( (void *)&m_job, 0, sizeof(m_job) );
+	memset( (void *)m_band_stats, 0, sizeof(m_band_stats) );
+
+	U64 freq = 0;
+	if (NvQueryPerformanceFrequency(&freq) && freq)
+		m_us_per_tick = 1000000.0 / static_cast<double>(freq);
+}
+
+CRepackyuvMT::~CRepackyuvMT()
+{
+	_destroy_workers();
+}
+
+uint32_t CRepackyuvMT::set_num_threads(const uint32_t num_threads)
+{
+	uint32_t n = num_threads;
+
+	if (n == 0) // auto: one thread per physical CPU core
+		n = GetCPUCoreCount();
+	if (n == 0)
+		n = 1;
+	if (n > REPACKYUV_MAX_THREADS)
+		n = REPACKYUV_MAX_THREADS;
+
+	if (n != m_num_threads) {
+		_destroy_workers();
+		_create_workers(n - 1); // the calling thread is the n-th thread
+		m_num_threads = n;
+	}
+
+	return m_num_threads;
+}
+
+uint32_t CRepackyuvMT::get_band_stats(const repackyuv_band_stats_t **p_stats) const
+{
+	if (p_stats)
+		*p_stats = m_band_stats;
+	return m_num_bands;
+}
+
+void CRepackyuvMT::_create_workers(const uint32_t num_workers)
+{
+	for (uint32_t i = 0; i < num_workers; ++i) {
+		m_workers[i] = new CRepackyuvWorkerThread(this, i + 1);
+		m_workers[i]->ThreadStart(true);
+	}
+	m_num_workers = num_workers;
+}
+
+void CRepackyuvMT::_destroy_workers()
+{
+	for (uint32_t i = 0; i < m_num_workers; ++i) {
+		if (m_workers[i] == NULL)
+			continue;
+		m_workers[i]->ThreadQuit();
+		delete m_workers[i];
+		m_workers[i] = NULL;
+	}
+	m_num_workers = 0;
+}
+
+// _split_bands() : divide the frame into row-bands of (nearly) equal height.
+//
+//   Every band starts on an even scanline, and (since height is even) has an
+//   even scanline-count, so NV12 chroma row-pairs are never split across bands.
+uint32_t CRepackyuvMT::_split_bands(const uint32_t height)
+{
+	const uint32_t row_pairs = height >> 1;
+	uint32_t num_bands = m_num_threads;
+
+	if (num_bands > height / REPACKYUV_MIN_BAND_ROWS)
+		num_bands = height / REPACKYUV_MIN_BAND_ROWS;
+	if (num_bands < 1)
+		num_bands = 1;
+
+	uint32_t row = 0;
+	for (uint32_t i = 0; i < num_bands; ++i) {
+		// distribute the leftover row-pairs to the first bands
+		uint32_t pairs = row_pairs / num_bands;
+		if (i < (row_pairs % num_bands))
+			++pairs;
+
+		m_band_stats[i].row_start  = row;
+		m_band_stats[i].row_count  = pairs << 1;
+		m_band_stats[i].thread_idx = 0;
+		m_band_stats[i].elapsed_us = 0.0;
+		row += pairs << 1;
+	}
+
+	m_num_bands = num_bands;
+	return num_bands;
+}
+
+void CRepackyuvMT::_run_band(const uint32_t band_idx, const uint32_t thread_idx)
+{
+	repackyuv_band_stats_t &band = m_band_stats[band_idx];
+	const uint32_t y0 = band.row_start;
+	const uint32_t h  = band.row_count;
+
+	// The RGBF->NV12 kernels flip the image vertically: source scanline #y is
+	// written to output scanline #(height-1-y).  So source rows [y0 .. y0+h)
+	// land in output rows [height-y0-h .. height-y0), and (since y0 and h are
+	// both even) output UV-rows [(height-y0-h)/2 .. (height-y0)/2).
+	const uint32_t dst_row = m_job.height - y0 - h;
+
+	U64 t_start = 0, t_end = 0;
+	NvQueryPerformanceCounter(&t_start);
+
+	CRepackyuv::convert_RGBFtoNV12(
+		m_job.use_bt709,
+		m_job.use_fullscale,
+		m_job.width, h,
+		m_job.src_stride,
+		m_job.src_rgb + (static_cast<size_t>(y0) * m_job.src_stride),
+		m_job.dst_stride,
+		m_job.dest_y  + (static_cast<size_t>(dst_row) * m_job.dst_stride),
+		m_job.dest_uv + (static_cast<size_t>(dst_row >> 1) * m_job.dst_stride)
+	);
+
+	NvQueryPerformanceCounter(&t_end);
+	band.thread_idx = thread_idx;
+	band.elapsed_us = static_cast<double>(t_end - t_start) * m_us_per_tick;
+}
+
+void CRepackyuvMT::convert_RGBFtoNV12_mt( // multi-threaded convert_RGBFtoNV12()
+	const bool     use_bt709,     // color-space select: false=bt601, true=bt709
+	const bool     use_fullscale, // true=PC/full scale, false=video(16-235)
+	const uint32_t width,      // X-dimension (#pixels)
+	const uint32_t height,     // Y-dimension (#pixels)
+	const uint32_t src_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	const uint8_t  src_rgb[],  // source RGB 32f plane (128 bits per pixel)
+	const uint32_t dst_stride, // distance from scanline(x) to scanline(x+1) [units of uint8_t]
+	uint8_t dest_y[],   // pointer to output Y-plane
+	uint8_t dest_uv[]   // pointer to output UV-plane
+	)
+{
+	m_job.use_bt709     = use_bt709;
+	m_job.use_fullscale = use_fullscale;
+	m_job.width         = width;
+	m_job.height        = height;
+	m_job.src_stride    = src_stride;
+	m_job.src_rgb       = src_rgb;
+	m_job.dst_stride    = dst_stride;
+	m_job.dest_y        = dest_y;
+	m_job.dest_uv       = dest_uv;
+
+	// odd-height frames can't be split on chroma row-pairs: convert as one band
+	const uint32_t num_bands = (height & 0x1) ? 1 : _split_bands(height);
+
+	if (num_bands <= 1 || m_num_workers == 0) {
+		m_num_bands = 1;
+		m_band_stats[0].row_start = 0;
+		m_band_stats[0].row_count = height;
+		_run_band(0, 0);
+		return;
+	}
+
+	// band#0 runs on the calling thread, bands#1..N on the worker-pool
+	for (uint32_t i = 1; i < num_bands; ++i)
+		m_workers[i - 1]->Dispatch(i);
+
+	_run_band(0, 0);
+
+	for (uint32_t i = 1; i < num_bands; ++i)
+		m_workers[i - 1]->WaitDone();
+}
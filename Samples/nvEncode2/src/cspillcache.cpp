@@ -0,0 +1,344 @@
+#include <cstring>   // memset(), memcpy()
+
+#include "cspillcache.h"
+#include "xcodeutil.h"  // NvQueryPerformanceMicrosecs()
+
+static inline uint32_t _read32(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v)); // (unaligned)
+	return v;
+}
+
+// _put_length() - the LZ4 length extension: 255, 255, ..., remainder
+static inline uint8_t *_put_length(uint8_t *op, uint32_t len)
+{
+	while (len >= 255) {
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = static_cast<uint8_t>(len);
+	return op;
+}
+
+// _put_sequence() - token, literals, and (if match_len) the offset and match length
+static inline uint8_t *_put_sequence(uint8_t *op, const uint8_t *literals, const uint32_t lit_len,
+	const uint32_t offset, const uint32_t match_len)
+{
+	const uint32_t ml = match_len ? match_len - SPILL_CACHE_MIN_MATCH : 0;
+	uint8_t *token = op++;
+
+	*token = static_cast<uint8_t>(((lit_len < 15) ? lit_len : 15) << 4);
+	if (lit_len >= 15)
+		op = _put_length(op, lit_len - 15);
+	memcpy(op, literals, lit_len);
+	op += lit_len;
+
+	if (match_len) {
+		*op++ = static_cast<uint8_t>(offset & 0xFF);
+		*op++ = static_cast<uint8_t>(offset >> 8);
+		*token |= static_cast<uint8_t>((ml < 15) ? ml : 15);
+		if (ml >= 15)
+			op = _put_length(op, ml - 15);
+	}
+	return op;
+}
+
+CSpillCache::CSpillCache() :
+	m_state(SPILL_IDLE),
+	m_fp(NULL),
+	m_budget(0),
+	m_compress(false),
+	m_raw(NULL),
+	m_packed(NULL),
+	m_capacity(0),
+	m_hash(NULL)
+{
+	memset( (void *)&m_stats, 0, sizeof(m_stats) );
+}
+
+CSpillCache::~CSpillCache()
+{
+	End();
+}
+
+bool CSpillCache::Begin(FILE *fp, const uint64_t budget_bytes, const bool compress)
+{
+	End();
+	if (!fp)
+		return false;
+
+	m_fp       = fp;
+	m_budget   = budget_bytes;
+	m_compress = compress;
+	m_state    = SPILL_RECORD;
+	memset( (void *)&m_stats, 0, sizeof(m_stats) );
+	return true;
+}
+
+uint32_t CSpillCache::_layout_bytes(const spill_layout_t &layout)
+{
+	uint64_t bytes = 0;
+	for (uint32_t p = 0; p < layout.planes && p < SPILL_CACHE_MAX_PLANES; ++p)
+		bytes += static_cast<uint64_t>(layout.row_bytes[p]) * layout.rows[p];
+	return (bytes < 0x80000000ULL) ? static_cast<uint32_t>(bytes) : 0; // (a frame is a few MB)
+}
+
+uint32_t CSpillCache::_layout_hash(const spill_layout_t &layout)
+{
+	uint32_t h = 2166136261u; // FNV-1a
+	const uint32_t *v = &layout.planes;
+	for (uint32_t i = 0; i < sizeof(layout) / sizeof(uint32_t); ++i)
+		h = (h ^ v[i]) * 16777619u;
+	return h;
+}
+
+// _reserve() - frame buffers for raw_bytes (they only grow)
+bool CSpillCache::_reserve(const uint32_t raw_bytes)
+{
+	if (!m_hash)
+		m_hash = new uint32_t[1 << SPILL_CACHE_HASH_BITS];
+	if (raw_bytes <= m_capacity)
+		return true;
+
+	delete [] m_raw;
+	delete [] m_packed;
+	m_raw      = new uint8_t[raw_bytes];
+	m_packed   = new uint8_t[CompressBound(raw_bytes)];
+	m_capacity = raw_bytes;
+	return true;
+}
+
+bool CSpillCache::Write(const uint8_t * const planes[SPILL_CACHE_MAX_PLANES], const uint32_t pitch, const spill_layout_t &layout)
+{
+	if (m_state != SPILL_RECORD || m_stats.full)
+		return false;
+
+	const double t_start = NvQueryPerformanceMicrosecs();
+	const uint32_t raw_bytes = _layout_bytes(layout);
+	if (!raw_bytes || !_reserve(raw_bytes)) {
+		m_stats.full = true;
+		return false;
+	}
+
+	// pack the planes (drop the surface padding)
+	uint8_t *dst = m_raw;
+	for (uint32_t p = 0; p < layout.planes; ++p) {
+		const uint8_t *src = planes[p];
+		for (uint32_t y = 0; y < layout.rows[p]; ++y, src += pitch, dst += layout.row_bytes[p])
+			memcpy(dst, src, layout.row_bytes[p]);
+	}
+
+	spill_header_t header;
+	header.magic        = SPILL_CACHE_MAGIC;
+	header.layout_hash  = _layout_hash(layout);
+	header.raw_bytes    = raw_bytes;
+	header.stored_bytes = m_compress ? Compress(m_raw, raw_bytes, m_packed) : raw_bytes;
+	if (header.stored_bytes >= raw_bytes)
+		header.stored_bytes = raw_bytes; // (didn't shrink: stored as is)
+	const uint8_t *payload = (header.stored_bytes < raw_bytes) ? m_packed : m_raw;
+
+	// the disk budget: the first frame which doesn't fit ends the recording
+	const uint64_t frame_bytes = sizeof(header) + header.stored_bytes;
+	if (m_budget && m_stats.file_bytes + frame_bytes > m_budget) {
+		m_stats.full = true;
+		return false;
+	}
+
+	if (fwrite(&header, sizeof(header), 1, m_fp) != 1 ||
+		fwrite(payload, header.stored_bytes, 1, m_fp) != 1)
+	{
+		m_stats.full = true; // (disk full: the partial frame is never read back)
+		return false;
+	}
+
+	++m_stats.frames;
+	m_stats.raw_bytes  += raw_bytes;
+	m_stats.file_bytes += frame_bytes;
+	m_stats.write_us   += NvQueryPerformanceMicrosecs() - t_start;
+	return true;
+}
+
+bool CSpillCache::Rewind()
+{
+	if (m_state != SPILL_RECORD)
+		return false;
+
+	if (!m_stats.frames || fflush(m_fp) || fseek(m_fp, 0, SEEK_SET)) {
+		End();
+		return false;
+	}
+
+	m_stats.played = 0;
+	m_state = SPILL_PLAY;
+	return true;
+}
+
+bool CSpillCache::Read(uint8_t * const planes[SPILL_CACHE_MAX_PLANES], const uint32_t pitch, const spill_layout_t &layout)
+{
+	if (m_state != SPILL_PLAY || m_stats.played >= m_stats.frames)
+		return false;
+
+	const double t_start = NvQueryPerformanceMicrosecs();
+	const uint32_t raw_bytes = _layout_bytes(layout);
+	spill_header_t header;
+	bool ok = raw_bytes && _reserve(raw_bytes) &&
+		fread(&header, sizeof(header), 1, m_fp) == 1 &&
+		header.magic == SPILL_CACHE_MAGIC &&
+		header.layout_hash == _layout_hash(layout) &&
+		header.raw_bytes == raw_bytes &&
+		header.stored_bytes <= raw_bytes;
+
+	if (ok && header.stored_bytes == raw_bytes)
+		ok = fread(m_raw, raw_bytes, 1, m_fp) == 1;
+	else if (ok)
+		ok = fread(m_packed, header.stored_bytes, 1, m_fp) == 1 &&
+			Decompress(m_packed, header.stored_bytes, m_raw, raw_bytes) == raw_bytes;
+
+	if (!ok) {
+		m_stats.frames = m_stats.played; // (the rest of the file is unusable: the caller renders it)
+		return false;
+	}
+
+	// unpack into the surface
+	const uint8_t *src = m_raw;
+	for (uint32_t p = 0; p < layout.planes; ++p) {
+		uint8_t *dst = planes[p];
+		for (uint32_t y = 0; y < layout.rows[p]; ++y, dst += pitch, src += layout.row_bytes[p])
+			memcpy(dst, src, layout.row_bytes[p]);
+	}
+
+	++m_stats.played;
+	m_stats.read_us += NvQueryPerformanceMicrosecs() - t_start;
+	return true;
+}
+
+void CSpillCache::End()
+{
+	delete [] m_raw;
+	delete [] m_packed;
+	delete [] m_hash;
+	m_raw      = NULL;
+	m_packed   = NULL;
+	m_hash     = NULL;
+	m_capacity = 0;
+	m_fp       = NULL;
+	m_state    = SPILL_IDLE;
+}
+
+// Compress() - greedy LZ77: hash the 4 bytes at each position, take the last position with the
+//   same hash if those 4 bytes match (within 64 KB), extend the match both ways.  After 2^SKIP_TRIGGER
+//   misses in a row, the search steps over 2 bytes, then 3, ... (noise compresses at memcpy-speed.)
+uint32_t CSpillCache::Compress(const uint8_t *src, const uint32_t size, uint8_t *dst)
+{
+	const uint8_t *ip     = src;
+	const uint8_t *anchor = src;   // first literal not yet emitted
+	const uint8_t *const iend = src + size;
+	uint8_t *op = dst;
+
+	if (!m_hash)
+		m_hash = new uint32_t[1 << SPILL_CACHE_HASH_BITS];
+
+	if (size > SPILL_CACHE_MATCH_LIMIT) {
+		const uint8_t *const mflimit    = iend - SPILL_CACHE_MATCH_LIMIT;   // matches start before this ...
+		const uint8_t *const matchlimit = iend - SPILL_CACHE_LAST_LITERALS; // ... and end before this
+		uint32_t search = 1 << SPILL_CACHE_SKIP_TRIGGER;
+
+		memset(m_hash, 0, sizeof(uint32_t) << SPILL_CACHE_HASH_BITS);
+		while (ip < mflimit) {
+			const uint32_t seq  = _read32(ip);
+			const uint32_t h    = (seq * 2654435761u) >> (32 - SPILL_CACHE_HASH_BITS);
+			const uint32_t pos  = static_cast<uint32_t>(ip - src);
+			const uint32_t cand = m_hash[h];
+			m_hash[h] = pos + 1;
+
+			if (!cand || pos + 1 - cand > SPILL_CACHE_MAX_OFFSET || _read32(src + cand - 1) != seq) {
+				ip += search++ >> SPILL_CACHE_SKIP_TRIGGER;
+				continue;
+			}
+
+			const uint8_t *ref = src + cand - 1;
+			const uint8_t *mend = ip + SPILL_CACHE_MIN_MATCH;
+			const uint8_t *rend = ref + SPILL_CACHE_MIN_MATCH;
+			while (mend < matchlimit && *mend == *rend) {
+				++mend;
+				++rend;
+			}
+			while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+				--ip;
+				--ref;
+			}
+
+			op = _put_sequence(op, anchor, static_cast<uint32_t>(ip - anchor),
+				static_cast<uint32_t>(ip - ref), static_cast<uint32_t>(mend - ip));
+			ip = anchor = mend;
+			search = 1 << SPILL_CACHE_SKIP_TRIGGER;
+		}
+	}
+
+	// the last literals
+	op = _put_sequence(op, anchor, static_cast<uint32_t>(iend - anchor), 0, 0);
+	return static_cast<uint32_t>(op - dst);
+}
+
+uint32_t CSpillCache::Decompress(const uint8_t *src, const uint32_t size, uint8_t *dst, const uint32_t dst_size)
+{
+	const uint8_t *ip = src;
+	const uint8_t *const iend = src + size;
+	uint8_t *op = dst;
+	uint8_t *const oend = dst + dst_size;
+
+	while (ip < iend) {
+		const uint32_t token = *ip++;
+		uint32_t len = token >> 4;
+		if (len == 15) {
+			uint8_t b;
+			do {
+				if (ip >= iend)
+					return 0;
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+		if (len > static_cast<uint32_t>(iend - ip) || len > static_cast<uint32_t>(oend - op))
+			return 0;
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+
+		if (ip == iend)
+			break; // (the last sequence has no match)
+
+		if (iend - ip < 2)
+			return 0;
+		const uint32_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (!offset || offset > static_cast<uint32_t>(op - dst))
+			return 0;
+
+		len = token & 15;
+		if (len == 15) {
+			uint8_t b;
+			do {
+				if (ip >= iend)
+					return 0;
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+		len += SPILL_CACHE_MIN_MATCH;
+		if (len > static_cast<uint32_t>(oend - op))
+			return 0;
+
+		const uint8_t *ref = op - offset;
+		if (offset >= len)
+			memcpy(op, ref, len);
+		else {
+			for (uint32_t i = 0; i < len; ++i) // (overlapping: repeats the last <offset> bytes)
+				op[i] = ref[i];
+		}
+		op += len;
+	}
+
+	return static_cast<uint32_t>(op - dst);
+}
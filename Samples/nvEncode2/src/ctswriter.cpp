@@ -0,0 +1,608 @@
+#include <cstring>   // memcpy(), memset()
+
+#include "ctswriter.h"
+#include "cnalutil.h"
+
+#define TS_PACKET_SIZE        188
+#define TS_PID_PAT            0x0000
+#define TS_PID_PMT            0x0100
+#define TS_PID_VIDEO          0x1011
+#define TS_PID_AUDIO          0x1100
+#define TS_PROGRAM_NUMBER     1
+
+#define TS_CLOCK              27000000ULL           // PCR clock (Hz)
+#define TS_PCR_INTERVAL       (TS_CLOCK * 35 / 1000) // 35msec (the limit is 40msec)
+#define TS_PSI_INTERVAL       (TS_CLOCK / 10)       // 100msec
+#define TS_AUDIO_LEAD         (TS_CLOCK * 6 / 100)  // audio-frames are sent 60msec ahead of their PTS
+#define TS_DEFAULT_VBV_DELAY  (TS_CLOCK / 2)        // (if the VBV isn't known) 500msec, same as TSMUXER's --vbv-len=500
+#define TS_DEFAULT_MUXRATE    80000000ULL           // (if the video bitrate isn't known, i.e. constQP)
+#define TS_MUXRATE_OVERHEAD   500000ULL             // PES/PSI/PCR overhead (bits/sec)
+
+#define TS_STREAM_TYPE_AVC    0x1B
+#define TS_STREAM_TYPE_HEVC   0x24
+#define TS_STREAM_TYPE_AAC    0x0F // ISO/IEC 13818-7 ADTS
+#define TS_STREAM_TYPE_LPCM   0x80 // Blu-ray (HDMV) LPCM
+
+#define TS_TIMESTAMP_MASK     0x1FFFFFFFFULL // 33-bit PTS/DTS
+
+// crc32_mpeg() - CRC32 of the PSI-sections (polynomial 0x04C11DB7, no reflection)
+static uint32_t crc32_mpeg(const uint8_t data[], const size_t size)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	for (size_t i = 0; i < size; ++i) {
+		crc ^= static_cast<uint32_t>(data[i]) << 24;
+		for (unsigned b = 0; b < 8; ++b)
+			crc = (crc & 0x80000000) ? ((crc << 1) ^ 0x04C11DB7) : (crc << 1);
+	}
+	return crc;
+}
+
+// put_timestamp() - 33-bit PTS/DTS in the 5-byte PES-header format
+static void put_timestamp(std::vector<uint8_t> &b, const unsigned prefix, uint64_t ts)
+{
+	ts &= TS_TIMESTAMP_MASK;
+	b.push_back(static_cast<uint8_t>((prefix << 4) | ((ts >> 29) & 0x0E) | 1));
+	b.push_back(static_cast<uint8_t>(ts >> 22));
+	b.push_back(static_cast<uint8_t>(((ts >> 14) & 0xFE) | 1));
+	b.push_back(static_cast<uint8_t>(ts >> 7));
+	b.push_back(static_cast<uint8_t>(((ts << 1) & 0xFE) | 1));
+}
+
+// put_pes_header() - PES-header with PTS (and DTS)
+//   payload_size == 0 : unbounded PES (video only)
+static void put_pes_header(std::vector<uint8_t> &b, const uint8_t stream_id, const uint64_t pts,
+	const uint64_t dts, const bool has_dts, const size_t payload_size)
+{
+	const size_t header_data = has_dts ? 10 : 5;
+	const size_t length = payload_size ? (3 + header_data + payload_size) : 0;
+
+	b.push_back(0); b.push_back(0); b.push_back(1);
+	b.push_back(stream_id);
+	b.push_back(static_cast<uint8_t>(length > 0xFFFF ? 0 : (length >> 8)));
+	b.push_back(static_cast<uint8_t>(length > 0xFFFF ? 0 : length));
+	b.push_back(0x84); // '10', data_alignment_indicator=1
+	b.push_back(has_dts ? 0xC0 : 0x80);
+	b.push_back(static_cast<uint8_t>(header_data));
+	put_timestamp(b, has_dts ? 3 : 2, pts);
+	if (has_dts)
+		put_timestamp(b, 1, dts);
+}
+
+////////////////////
+//
+// CTsWriter
+//
+
+CTsWriter::CTsWriter() :
+	m_fp(NULL), m_codec(TS_VIDEO_NONE), m_io_error(false), m_started(false), m_rate_num(0), m_rate_den(1),
+	m_max_bitrate(0), m_reorder_delay(0), m_vbv_delay(TS_DEFAULT_VBV_DELAY), m_t0(0), m_clock(0),
+	m_packet_ticks(1), m_spacing(1), m_last_pcr(0), m_last_psi(0), m_pcr_sent(false), m_pcr_due(false),
+	m_packets_since_pcr(0), m_psi_sent(false), m_pcr_pid(TS_PID_VIDEO),
+	m_frame_count(0), m_pts_base(0), m_audio_stream_type(0), m_lpcm_frames(0)
+{
+	memset(m_cc, 0, sizeof(m_cc));
+	memset(m_adts, 0, sizeof(m_adts));
+	memset(m_lpcm_hdr, 0, sizeof(m_lpcm_hdr));
+}
+
+CTsWriter::~CTsWriter()
+{
+	// the FILE handles belong to the caller
+}
+
+bool CTsWriter::Open(
+	FILE                  *fp,
+	const ts_video_codec_t codec,
+	const uint32_t         frameRateNum,
+	const uint32_t         frameRateDen,
+	const uint32_t         maxBitRate,
+	const uint32_t         vbvBufferSize,
+	const uint32_t         reorderDelay
+) {
+	if (fp == NULL || (codec != TS_VIDEO_NONE && (frameRateNum == 0 || frameRateDen == 0)))
+		return false;
+
+	m_fp = fp;
+	m_codec = codec;
+	m_rate_num = frameRateNum;
+	m_rate_den = frameRateDen;
+	m_max_bitrate = maxBitRate;
+	m_reorder_delay = (codec != TS_VIDEO_NONE) ? reorderDelay : 0;
+	m_pcr_pid = (codec != TS_VIDEO_NONE) ? TS_PID_VIDEO : TS_PID_AUDIO;
+
+	// The decoder-buffer delay: the time to fill the VBV at the peak bitrate
+	m_vbv_delay = TS_DEFAULT_VBV_DELAY;
+	if (maxBitRate && vbvBufferSize) {
+		m_vbv_delay = static_cast<uint64_t>(vbvBufferSize) * TS_CLOCK / maxBitRate;
+		if (m_vbv_delay < TS_CLOCK / 10)
+			m_vbv_delay = TS_CLOCK / 10;
+		else if (m_vbv_delay > TS_CLOCK)
+			m_vbv_delay = TS_CLOCK;
+	}
+
+	// The first access-unit is decoded once the VBV has filled (the mux-clock starts at 0),
+	// and presented reorderDelay frames later.  The audio starts at the same presentation time.
+	m_t0 = m_vbv_delay / 300 + ((codec != TS_VIDEO_NONE) ? _video_time(m_reorder_delay) : 0);
+
+	m_io_error = false;
+	m_started = false;
+	m_clock = 0;
+	m_pcr_sent = false;
+	m_pcr_due = false;
+	m_packets_since_pcr = 0;
+	m_psi_sent = false;
+	m_frame_count = 0;
+	memset(m_cc, 0, sizeof(m_cc));
+	m_ps.clear();
+	return true;
+}
+
+// _video_time() - duration of 'frames' video-frames (90KHz)
+uint64_t CTsWriter::_video_time(const int64_t frames) const
+{
+	return static_cast<uint64_t>(frames) * 90000 * m_rate_den / m_rate_num;
+}
+
+bool CTsWriter::AddPcmTrack(FILE *wav)
+{
+	if (m_fp == NULL || m_started || !m_audio.OpenWav(wav))
+		return false;
+
+	// Blu-ray LPCM audio-data-header: sampling_frequency, channel_assignment, bits_per_sample
+	uint8_t freq, layout;
+	switch (m_audio.sample_rate) {
+	case 48000:  freq = 1; break;
+	case 96000:  freq = 4; break;
+	case 192000: freq = 5; break;
+	default:     return false;
+	}
+	switch (m_audio.channels) {
+	case 1:  layout = 1; break; // mono   (coded as 2 channels)
+	case 2:  layout = 3; break; // stereo
+	case 6:  layout = 9; break; // 3/2+lfe
+	default: return false;
+	}
+
+	m_lpcm_hdr[2] = static_cast<uint8_t>((layout << 4) | freq);
+	m_lpcm_hdr[3] = 1 << 6; // 16-bit
+	m_lpcm_frames = m_audio.sample_rate / 200; // 5msec per PES
+	m_audio_stream_type = TS_STREAM_TYPE_LPCM;
+	return true;
+}
+
+bool CTsWriter::AddAacTrack(FILE *m4a)
+{
+	if (m_fp == NULL || m_started || !m_audio.OpenM4a(m4a))
+		return false;
+
+	// AudioSpecificConfig -> ADTS fixed-header
+	//   (for explicitly signaled HE-AAC, the ADTS-header describes the AAC-LC core)
+	const CAudioSource::bytes_t &asc = m_audio.asc;
+	unsigned aot = asc[0] >> 3;
+	const unsigned sfi = ((asc[0] & 7) << 1) | (asc[1] >> 7);
+	const unsigned chan = (asc[1] >> 3) & 15;
+	if ((aot == 5 || aot == 29) && asc.size() >= 3) {
+		const unsigned ext_sfi = ((asc[1] & 7) << 1) | (asc[2] >> 7);
+		const unsigned bitpos = (ext_sfi == 15) ? 33 : 9; // (bits into asc[1..])
+		aot = 0;
+		for (unsigned i = 0; i < 5; ++i) {
+			const unsigned bit = 8 + bitpos + i;
+			aot = (aot << 1) | ((bit / 8 < asc.size()) ? ((asc[bit / 8] >> (7 - bit % 8)) & 1) : 0);
+		}
+	}
+	if (aot < 1 || aot > 4 || sfi > 12 || chan == 0 || chan > 7)
+		return false; // not representable in ADTS
+
+	m_adts[0] = 0xFF;
+	m_adts[1] = 0xF1; // MPEG-4, layer 0, no CRC
+	m_adts[2] = static_cast<uint8_t>(((aot - 1) << 6) | (sfi << 2) | (chan >> 2));
+	m_adts[3] = static_cast<uint8_t>((chan & 3) << 6);
+	m_adts[5] = 0x1F; // buffer_fullness = 0x7FF (VBR)
+	m_adts[6] = 0xFC;
+	m_audio_stream_type = TS_STREAM_TYPE_AAC;
+	return true;
+}
+
+// _start() - choose the mux-rate (before the first packet)
+void CTsWriter::_start()
+{
+	uint64_t muxrate = m_max_bitrate ?
+		(static_cast<uint64_t>(m_max_bitrate) * 11 / 10) :
+		((m_codec != TS_VIDEO_NONE) ? TS_DEFAULT_MUXRATE : 0);
+	if (m_audio_stream_type)
+		muxrate += m_audio.GetBitRate() * 11 / 10;
+	muxrate += TS_MUXRATE_OVERHEAD;
+
+	m_packet_ticks = TS_PACKET_SIZE * 8 * TS_CLOCK / muxrate;
+	if (m_packet_ticks == 0)
+		m_packet_ticks = 1;
+	m_spacing = m_packet_ticks;
+	m_started = true;
+}
+
+void CTsWriter::_emit(const uint8_t packet[])
+{
+	if (!m_io_error && fwrite(packet, 1, TS_PACKET_SIZE, m_fp) != TS_PACKET_SIZE)
+		m_io_error = true;
+	m_clock += m_spacing;
+	++m_packets_since_pcr;
+}
+
+// _write_psi() - PAT + PMT (one packet each)
+void CTsWriter::_write_psi()
+{
+	uint8_t pkt[TS_PACKET_SIZE];
+	std::vector<uint8_t> s;
+
+	for (unsigned table = 0; table < 2; ++table) {
+		s.clear();
+		if (table == 0) {
+			// PAT: program 1 -> PMT
+			s.push_back(0x00);
+			s.push_back(0xB0); s.push_back(0); // section_length (patched below)
+			s.push_back(0x00); s.push_back(0x01); // transport_stream_id
+			s.push_back(0xC1); s.push_back(0); s.push_back(0); // version 0, current
+			s.push_back(TS_PROGRAM_NUMBER >> 8); s.push_back(TS_PROGRAM_NUMBER & 0xFF);
+			s.push_back(0xE0 | (TS_PID_PMT >> 8)); s.push_back(TS_PID_PMT & 0xFF);
+		}
+		else {
+			// PMT
+			s.push_back(0x02);
+			s.push_back(0xB0); s.push_back(0);
+			s.push_back(TS_PROGRAM_NUMBER >> 8); s.push_back(TS_PROGRAM_NUMBER & 0xFF);
+			s.push_back(0xC1); s.push_back(0); s.push_back(0);
+			s.push_back(static_cast<uint8_t>(0xE0 | (m_pcr_pid >> 8))); s.push_back(m_pcr_pid & 0xFF);
+			if (m_audio_stream_type == TS_STREAM_TYPE_LPCM) {
+				// registration_descriptor 'HDMV' (identifies the stream_type 0x80 as Blu-ray LPCM)
+				s.push_back(0xF0); s.push_back(6);
+				s.push_back(0x05); s.push_back(4);
+				s.push_back('H'); s.push_back('D'); s.push_back('M'); s.push_back('V');
+			}
+			else {
+				s.push_back(0xF0); s.push_back(0);
+			}
+			if (m_codec != TS_VIDEO_NONE) {
+				s.push_back((m_codec == TS_VIDEO_HEVC) ? TS_STREAM_TYPE_HEVC : TS_STREAM_TYPE_AVC);
+				s.push_back(0xE0 | (TS_PID_VIDEO >> 8)); s.push_back(TS_PID_VIDEO & 0xFF);
+				s.push_back(0xF0); s.push_back(0);
+			}
+			if (m_audio_stream_type) {
+				s.push_back(m_audio_stream_type);
+				s.push_back(0xE0 | (TS_PID_AUDIO >> 8)); s.push_back(TS_PID_AUDIO & 0xFF);
+				s.push_back(0xF0); s.push_back(0);
+			}
+		}
+
+		const size_t section_length = s.size() - 3 + 4; // (incl. CRC)
+		s[1] = static_cast<uint8_t>(0xB0 | (section_length >> 8));
+		s[2] = static_cast<uint8_t>(section_length);
+		const uint32_t crc = crc32_mpeg(&s[0], s.size());
+		s.push_back(static_cast<uint8_t>(crc >> 24));
+		s.push_back(static_cast<uint8_t>(crc >> 16));
+		s.push_back(static_cast<uint8_t>(crc >> 8));
+		s.push_back(static_cast<uint8_t>(crc));
+
+		const uint16_t pid = (table == 0) ? TS_PID_PAT : TS_PID_PMT;
+		memset(pkt, 0xFF, sizeof(pkt));
+		pkt[0] = 0x47;
+		pkt[1] = static_cast<uint8_t>(0x40 | (pid >> 8)); // payload_unit_start
+		pkt[2] = static_cast<uint8_t>(pid);
+		pkt[3] = static_cast<uint8_t>(0x10 | (m_cc[table]++ & 15));
+		pkt[4] = 0; // pointer_field
+		memcpy(pkt + 5, &s[0], s.size());
+		_emit(pkt);
+	}
+	m_last_psi = m_clock;
+	m_psi_sent = true;
+}
+
+// _write_pcr_packet() - adaptation-field-only packet carrying a PCR
+void CTsWriter::_write_pcr_packet()
+{
+	uint8_t pkt[TS_PACKET_SIZE];
+	memset(pkt, 0xFF, sizeof(pkt));
+
+	const uint64_t base = (m_clock / 300) & TS_TIMESTAMP_MASK;
+	const uint32_t ext = static_cast<uint32_t>(m_clock % 300);
+	const uint8_t cc = (m_pcr_pid == TS_PID_VIDEO) ? m_cc[2] : m_cc[3];
+
+	pkt[0] = 0x47;
+	pkt[1] = static_cast<uint8_t>(m_pcr_pid >> 8);
+	pkt[2] = static_cast<uint8_t>(m_pcr_pid);
+	pkt[3] = static_cast<uint8_t>(0x20 | ((cc - 1) & 15)); // no payload: continuity_counter doesn't advance
+	pkt[4] = 183;  // adaptation_field_length
+	pkt[5] = 0x10; // PCR_flag
+	pkt[6]  = static_cast<uint8_t>(base >> 25);
+	pkt[7]  = static_cast<uint8_t>(base >> 17);
+	pkt[8]  = static_cast<uint8_t>(base >> 9);
+	pkt[9]  = static_cast<uint8_t>(base >> 1);
+	pkt[10] = static_cast<uint8_t>(((base & 1) << 7) | 0x7E | (ext >> 8));
+	pkt[11] = static_cast<uint8_t>(ext);
+
+	_emit(pkt);
+	m_last_pcr = m_clock - m_spacing;
+	m_pcr_sent = true;
+	m_pcr_due = false;
+	m_packets_since_pcr = 0;
+}
+
+// _set_clock() - move the mux-clock forward to t (never backwards).
+//
+//   The stream is VBR (no null-packets), so a decoder which interpolates the arrival-time
+//   of a packet from the surrounding PCRs would spread a gap over the packets before it.
+//   A PCR is sent right before and right after every gap (and PCR-only packets while
+//   the stream is quiet for longer than the PCR-interval.)
+void CTsWriter::_set_clock(const uint64_t t)
+{
+	if (t <= m_clock)
+		return;
+	if (t - m_clock < TS_CLOCK / 1000 || !m_pcr_sent) {
+		m_clock = t; // (gaps < 1msec are ignored)
+		return;
+	}
+
+	if (m_packets_since_pcr)
+		_write_pcr_packet();
+	while (t > m_last_pcr + TS_PCR_INTERVAL) {
+		m_clock = m_last_pcr + TS_PCR_INTERVAL;
+		_write_pcr_packet();
+	}
+	if (t > m_clock)
+		m_clock = t;
+	m_pcr_due = true;
+}
+
+// _write_packet() - write one TS-packet of a PES, returns #payload-bytes consumed
+size_t CTsWriter::_write_packet(const uint16_t pid, const bool pusi, const uint8_t payload[], const size_t size, const bool rai)
+{
+	if (!m_started)
+		_start();
+
+	// PAT/PMT and PCR are inserted on schedule
+	if (!m_psi_sent || m_clock - m_last_psi >= TS_PSI_INTERVAL)
+		_write_psi();
+
+	bool pcr = !m_pcr_sent || m_pcr_due || (m_clock - m_last_pcr >= TS_PCR_INTERVAL);
+	if (pcr && pid != m_pcr_pid) {
+		_write_pcr_packet();
+		pcr = false;
+	}
+
+	uint8_t pkt[TS_PACKET_SIZE];
+	uint8_t &cc = (pid == TS_PID_VIDEO) ? m_cc[2] : m_cc[3];
+
+	// adaptation-field: PCR, random_access_indicator, stuffing
+	size_t af = (pcr || rai) ? (2 + (pcr ? 6 : 0)) : 0; // incl. adaptation_field_length
+	size_t n = (size < TS_PACKET_SIZE - 4 - af) ? size : (TS_PACKET_SIZE - 4 - af);
+	if (n < TS_PACKET_SIZE - 4 - af)
+		af = TS_PACKET_SIZE - 4 - n; // stuff the last packet of the PES
+
+	pkt[0] = 0x47;
+	pkt[1] = static_cast<uint8_t>((pusi ? 0x40 : 0) | (pid >> 8));
+	pkt[2] = static_cast<uint8_t>(pid);
+	pkt[3] = static_cast<uint8_t>((af ? 0x30 : 0x10) | (cc++ & 15));
+
+	if (af) {
+		memset(pkt + 4, 0xFF, af);
+		pkt[4] = static_cast<uint8_t>(af - 1);
+		if (af >= 2) {
+			pkt[5] = (rai ? 0x40 : 0) | (pcr ? 0x10 : 0);
+			if (pcr) {
+				const uint64_t base = (m_clock / 300) & TS_TIMESTAMP_MASK;
+				const uint32_t ext = static_cast<uint32_t>(m_clock % 300);
+				pkt[6]  = static_cast<uint8_t>(base >> 25);
+				pkt[7]  = static_cast<uint8_t>(base >> 17);
+				pkt[8]  = static_cast<uint8_t>(base >> 9);
+				pkt[9]  = static_cast<uint8_t>(base >> 1);
+				pkt[10] = static_cast<uint8_t>(((base & 1) << 7) | 0x7E | (ext >> 8));
+				pkt[11] = static_cast<uint8_t>(ext);
+			}
+		}
+	}
+	memcpy(pkt + 4 + af, payload, n);
+	_emit(pkt);
+	if (pcr) {
+		m_last_pcr = m_clock - m_spacing;
+		m_pcr_sent = true;
+		m_pcr_due = false;
+		m_packets_since_pcr = 0;
+	}
+	return n;
+}
+
+// _write_pes() - split a PES-packet into TS-packets
+//   Video packets are interleaved with the audio-frames which fall due meanwhile.
+void CTsWriter::_write_pes(const uint16_t pid, const uint8_t pes[], const size_t size, const bool rai)
+{
+	size_t pos = 0;
+	while (pos < size && !m_io_error) {
+		if (pid == TS_PID_VIDEO)
+			_write_due_audio(m_clock);
+		pos += _write_packet(pid, pos == 0, pes + pos, size - pos, rai && pos == 0);
+	}
+}
+
+// _audio_due() - mux-clock time at which the next audio-frame should be sent
+uint64_t CTsWriter::_audio_due() const
+{
+	if (!m_audio_stream_type || m_audio.Eof())
+		return UINT64_MAX;
+	const uint64_t pts = (m_t0 + m_audio.NextTime() * 90000 / m_audio.timescale) * 300;
+	return (pts > TS_AUDIO_LEAD) ? (pts - TS_AUDIO_LEAD) : 0;
+}
+
+void CTsWriter::_write_due_audio(const uint64_t until)
+{
+	while (!m_io_error && _audio_due() <= until)
+		if (!_write_audio_frame())
+			m_io_error = true;
+}
+
+// _write_audio_frame() - one AAC-frame (ADTS) or 5msec of LPCM, as one PES-packet
+bool CTsWriter::_write_audio_frame()
+{
+	uint64_t time;
+	if (!m_audio.ReadFrame(m_frame, &time, m_lpcm_frames))
+		return false;
+
+	const uint64_t pts = m_t0 + time * 90000 / m_audio.timescale;
+	bytes_t &b = m_audio_pes;
+	b.clear();
+
+	if (m_audio_stream_type == TS_STREAM_TYPE_AAC) {
+		const size_t frame_length = m_frame.size() + sizeof(m_adts);
+		put_pes_header(b, 0xC0, pts, 0, false, frame_length);
+		const size_t adts = b.size();
+		b.insert(b.end(), m_adts, m_adts + sizeof(m_adts));
+		b[adts + 3] |= static_cast<uint8_t>(frame_length >> 11);
+		b[adts + 4] = static_cast<uint8_t>(frame_length >> 3);
+		b[adts + 5] |= static_cast<uint8_t>(frame_length << 5);
+		b.insert(b.end(), m_frame.begin(), m_frame.end());
+	}
+	else {
+		// Blu-ray LPCM: big-endian samples, mono is coded as 2 channels
+		const size_t frames = m_frame.size() / m_audio.block_align;
+		const size_t coded_channels = (m_audio.channels + 1) & ~1;
+		const size_t data_size = frames * coded_channels * 2;
+		put_pes_header(b, 0xBD, pts, 0, false, sizeof(m_lpcm_hdr) + data_size);
+		m_lpcm_hdr[0] = static_cast<uint8_t>(data_size >> 8);
+		m_lpcm_hdr[1] = static_cast<uint8_t>(data_size);
+		b.insert(b.end(), m_lpcm_hdr, m_lpcm_hdr + sizeof(m_lpcm_hdr));
+
+		size_t out = b.size();
+		b.resize(out + data_size, 0);
+		const uint8_t *in = m_frame.empty() ? NULL : &m_frame[0];
+		for (size_t f = 0; f < frames; ++f, out += coded_channels * 2)
+			for (size_t c = 0; c < m_audio.channels; ++c, in += 2) {
+				b[out + c * 2 + 0] = in[1];
+				b[out + c * 2 + 1] = in[0];
+			}
+	}
+
+	_write_pes(TS_PID_AUDIO, &b[0], b.size(), false);
+	return true;
+}
+
+size_t CTsWriter::WriteBitstream(const uint8_t data[], const size_t size, const int64_t pts)
+{
+	if (m_fp == NULL || m_io_error || m_codec == TS_VIDEO_NONE)
+		return 0;
+
+	// Scan the NAL-units of this block
+	const uint8_t *const end = data + size;
+	const uint8_t *aud_end = NULL; // (if the block starts with an access-unit delimiter) end of the AUD
+	bool has_vcl = false, is_sync = false, has_ps = false;
+	for (const uint8_t *p = nal_find_start_code(data, end); p < end; ) {
+		const uint8_t *nal = p + 3;
+		const uint8_t *next = nal_find_start_code(nal, end);
+		if (nal < end) {
+			unsigned type;
+			bool aud;
+			if (m_codec == TS_VIDEO_HEVC) {
+				type = (nal[0] >> 1) & 0x3F;
+				has_vcl |= (type < 32);
+				is_sync |= nal_is_random_access(true, type);
+				has_ps  |= (type == 33); // SPS
+				aud = (type == 35);
+			}
+			else {
+				type = nal[0] & 0x1F;
+				has_vcl |= (type >= 1 && type <= 5);
+				is_sync |= nal_is_random_access(false, type);
+				has_ps  |= (type == 7); // SPS
+				aud = (type == 9);
+			}
+			if (aud && !has_vcl && aud_end == NULL)
+				aud_end = next;
+		}
+		p = next;
+	}
+
+	// Parameter-sets which NVENC writes out on their own (sequence-header):
+	//   keep them, they are sent in front of every IDR
+	if (!has_vcl) {
+		m_ps.assign(data, end);
+		return size;
+	}
+
+	if (m_frame_count == 0)
+		m_pts_base = (pts >= 0) ? pts : 0;
+
+	// decode/presentation time (90KHz)
+	const uint64_t dts = m_t0 - _video_time(m_reorder_delay) + _video_time(m_frame_count);
+	uint64_t pts90 = m_t0 + _video_time(((pts >= 0) ? pts : m_frame_count) - m_pts_base);
+	if (pts90 < dts)
+		pts90 = dts; // (reorderDelay was too small)
+
+	// PES: [AUD] [SPS/PPS] access-unit
+	const size_t split = aud_end ? (aud_end - data) : 0;
+	m_video_pes.clear();
+	put_pes_header(m_video_pes, 0xE0, pts90, dts, pts90 != dts, 0);
+	if (aud_end)
+		m_video_pes.insert(m_video_pes.end(), data, aud_end);
+	else if (m_codec == TS_VIDEO_HEVC) {
+		static const uint8_t aud_hevc[] = { 0, 0, 0, 1, 0x46, 0x01, 0x50 };
+		m_video_pes.insert(m_video_pes.end(), aud_hevc, aud_hevc + sizeof(aud_hevc));
+	}
+	else {
+		static const uint8_t aud_avc[] = { 0, 0, 0, 1, 0x09, 0xF0 };
+		m_video_pes.insert(m_video_pes.end(), aud_avc, aud_avc + sizeof(aud_avc));
+	}
+	if (is_sync && !has_ps)
+		m_video_pes.insert(m_video_pes.end(), m_ps.begin(), m_ps.end());
+	m_video_pes.insert(m_video_pes.end(), data + split, end);
+
+	if (!m_started)
+		_start();
+
+	// VBV-model: the access-unit enters the mux no earlier than vbv_delay before its DTS
+	// (the audio which falls due in the meantime is sent first.)
+	const uint64_t dts27 = dts * 300;
+	const uint64_t arrival = (dts27 > m_vbv_delay) ? (dts27 - m_vbv_delay) : 0;
+	for (uint64_t due = _audio_due(); due <= arrival && !m_io_error; due = _audio_due()) {
+		_set_clock(due);
+		if (!_write_audio_frame())
+			m_io_error = true;
+	}
+	_set_clock(arrival);
+
+	// ...and must arrive completely before its DTS
+	const uint64_t packets = (m_video_pes.size() + 183) / 184 + 1;
+	m_spacing = m_packet_ticks;
+	if (m_clock + packets * m_packet_ticks > dts27) {
+		m_spacing = (dts27 > m_clock + packets) ? ((dts27 - m_clock) / packets) : 1;
+		m_pcr_due = true; // (mux-rate changes)
+	}
+
+	_write_pes(TS_PID_VIDEO, &m_video_pes[0], m_video_pes.size(), is_sync);
+	if (m_spacing != m_packet_ticks) {
+		m_spacing = m_packet_ticks;
+		m_pcr_due = true;
+	}
+
+	++m_frame_count;
+	return m_io_error ? 0 : size;
+}
+
+bool CTsWriter::Close()
+{
+	if (m_fp == NULL)
+		return false;
+
+	if (!m_started)
+		_start();
+
+	// The remaining audio (the video has ended, or there is no video)
+	for (uint64_t due = _audio_due(); due != UINT64_MAX && !m_io_error; due = _audio_due()) {
+		_set_clock(due);
+		if (!_write_audio_frame())
+			m_io_error = true;
+	}
+
+	if (!m_psi_sent)
+		_write_psi(); // empty stream: at least PAT/PMT
+
+	const bool ok = !m_io_error && fflush(m_fp) == 0;
+	m_fp = NULL;
+	return ok;
+}
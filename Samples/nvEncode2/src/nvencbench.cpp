@@ -0,0 +1,766 @@
+//
+// nvencbench - headless throughput benchmark for the CNvEncoder pipeline
+//
+//   Drives CNvEncoderH264/CNvEncoderH265 exactly like the Premiere Pro plugin does
+//   (OpenEncodeSession -> InitializeEncoderCodec -> EncodeFramePPro ... -> flush -> DestroyEncoder),
+//   with the software stand-in for the NVENC driver (cnvencsim.h) in place of the GPU.
+//   So the input-queueing, the pixel-format conversion (crepackyuv), the output-thread and
+//   the fwrite_callback are real, and only the encode itself is emulated (fixed latency per picture).
+//
+//   Reports frames per second, the time spent in EncodeFramePPro(), the per-frame completion
+//   latency (CNvEncoder::GetCompletionStats()), and the per-stage pipeline timing from the stand-in.
+//
+//   usage: nvencbench [options]
+//     -codec   h264|hevc                       (default h264)
+//     -size    <width>x<height>                (default 1920x1080)
+//     -frames  <n>                             (default 600)
+//     -input   yuv420|yuy2|uyvy|yuv444|rgbf|v210|vuya|rgb8|rgb16  Adobe framebuffer format (default yuv420)
+//                                              (vuya: packed 4:4:4 downsampled to a 4:2:0 encode,
+//                                               rgb8/rgb16: BGRA 8u/16u, integer RGB->NV12)
+//     -10bit                                   HEVC Main10 (P010 input-surfaces; -input rgbf or v210)
+//     -latency <usec>                          emulated encode time per picture (default 2500)
+//     -bytes   <n>                             coded size of a P-picture (default: from the bitrate)
+//     -bitrate <bits/sec>                      (default 25000000)
+//     -bframes <n>                             (default 1)
+//     -threads <n>                             crepackyuv threads (0=auto, default 0)
+//     -noavx                                   disable the AVX/AVX2/AVX512 converters
+//     -async                                   async-mode (completion-events) instead of sync-mode
+//     -noread                                  the stand-in doesn't read the input-surfaces
+//     -o       <file>                          write the (non-decodable) bitstream to a file
+//     -syncio                                  -o writes with fwrite() on the output-thread, instead of CFileWriter
+//     -telemetry <file>                        write the per-frame telemetry (CNvEncoder::GetTelemetry()),
+//                                              as JSON if the name ends with .json, otherwise as CSV
+//     -allocs                                  fail (exit code 3) if the steady-state encode loop allocates
+//     -lookahead <n>                           CPU lookahead of n frames (scene-cut IDRs, complexity hints)
+//     -scenes  <n>                             the source picture changes completely every n frames (0 = never)
+//     -twopass                                 two-pass: a constant-QP pass 1 (not measured) plans the bitrate
+//                                              of each segment, which pass 2 sets with ReconfigureEncoder()
+//     -ladder  <n>                             ABR ladder of n rungs (2..6, yuv420 input): each source frame also
+//                                              feeds an encoder per lower rung, through the downscale pyramid (CAbrLadder)
+//     -render  <msec>                          emulate the host's renderer: each frame takes 0.5x..1.5x msec to render,
+//                                              on BENCH_RENDER_THREADS threads, and arrives through CAsyncRender
+//     -renderahead <n>                         frames in flight with the renderer (default 1: render, then encode)
+//     -spill   <MB>                            two-pass: pass 1 writes its converted frames to a spill cache (CSpillCache)
+//                                              of at most MB, pass 2 reads them back instead of converting again
+//     -spillraw                                don't compress the spill cache
+//
+//   Every operator new is counted: after a warm-up (the first IDR and the growth of the
+//   bitstream-buffer pool), the encode loop and the output-thread are expected to allocate
+//   nothing per frame.  e.g.  nvencbench -frames 10000 -allocs
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "CNVEncoderH264.h"
+#include "CNVEncoderH265.h"
+#include "cnvencsim.h"
+#include "cfilewriter.h"
+#include "cabrladder.h"
+#include "casyncrender.h"
+#include "cspillcache.h"
+#include "xcodeutil.h"  // NvQueryPerformanceMicrosecs(), NvSleep()
+
+#if defined __linux || defined __APPLE_ || defined __MACOSX
+#include <threads/NvPthreadABI.h>
+#endif
+
+#define BENCH_WARMUP_FRAMES 60
+#define BENCH_RENDER_THREADS 2
+
+// counting allocator: operator new/delete for the whole process
+static std::atomic<bool>     g_count_allocs(false);
+static std::atomic<uint64_t> g_allocs(0);
+
+static void *bench_alloc(size_t size)
+{
+	if (g_count_allocs.load(std::memory_order_relaxed))
+		g_allocs.fetch_add(1, std::memory_order_relaxed);
+
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new(size_t size)                                     { return bench_alloc(size); }
+void *operator new[](size_t size)                                   { return bench_alloc(size); }
+void *operator new(size_t size, const std::nothrow_t &) throw()     { try { return bench_alloc(size); } catch (...) { return NULL; } }
+void *operator new[](size_t size, const std::nothrow_t &) throw()   { try { return bench_alloc(size); } catch (...) { return NULL; } }
+void operator delete(void *p) throw()                               { free(p); }
+void operator delete[](void *p) throw()                             { free(p); }
+void operator delete(void *p, const std::nothrow_t &) throw()       { free(p); }
+void operator delete[](void *p, const std::nothrow_t &) throw()     { free(p); }
+
+typedef struct {
+	FILE        *fp;     // -syncio
+	CFileWriter *writer;
+	uint64_t  bytes;
+	uint64_t  frames;
+} bench_output_t;
+
+static size_t bench_fwrite_callback(void *_Str, size_t _Size, size_t _Count, FILE *_File, void *privateData)
+{
+	bench_output_t *out = reinterpret_cast<bench_output_t *>(privateData);
+	(void)_File;
+
+	out->bytes += _Size * _Count;
+	out->frames++;
+	if (out->writer)
+		return out->writer->Write(_Str, _Size * _Count);
+	if (out->fp)
+		return fwrite(_Str, _Size, _Count, out->fp);
+	return _Count;
+}
+
+// bench_draw_scene() - a checkerboard of 64x64 blocks over a fine texture, inverted by each new scene
+//   (so the picture changes completely: a scene-cut for the lookahead.)  bpp = bytes per pixel of
+//   the source framebuffer (16 for rgbf: 4 floats; v210 is drawn a 6-pixel group at a time)
+static void bench_draw_scene(const EncodeFrameConfig &frame, const unsigned bpp, const bool is_float, const unsigned scene)
+{
+	for (unsigned y = 0; y < frame.height; ++y) {
+		unsigned char *row = frame.yuv[0] + static_cast<size_t>(y) * frame.stride[0];
+		if (frame.ppro_pixelformat_is_v210) {
+			for (unsigned x = 0; x < frame.width; x += 6) {
+				const bool bright = (((x / 64) + (y / 64) + scene) & 1) != 0;
+				memset(row + (x / 6) * 16, (bright ? 0xC0 : 0x40) + ((x * 7 + y * 3) & 15), 16);
+			}
+			continue;
+		}
+		for (unsigned x = 0; x < frame.width; ++x) {
+			const bool bright = (((x / 64) + (y / 64) + scene) & 1) != 0;
+			const unsigned texture = (x * 7 + y * 3) & 15;
+			if (is_float) {
+				float *p = reinterpret_cast<float *>(row) + x * 4;
+				p[0] = p[1] = p[2] = p[3] = (bright ? 0.75f : 0.25f) + texture / 256.0f;
+			}
+			else if (frame.ppro_pixelformat_is_rgb444_16u) {
+				uint16_t *p = reinterpret_cast<uint16_t *>(row) + x * 4;
+				p[0] = p[1] = p[2] = p[3] = static_cast<uint16_t>(((bright ? 0xC0 : 0x40) + texture) << 7);
+			}
+			else
+				memset(row + x * bpp, (bright ? 0xC0 : 0x40) + texture, bpp);
+		}
+	}
+}
+
+// bench_render_host_t : stand-in for Premiere's sequence-render suite (-render): a pool of
+//   render-threads, each frame takes a different time (so they complete out of order)
+class bench_render_thread_t;
+
+class bench_render_host_t : public IAsyncRenderHost
+{
+public:
+	bench_render_host_t(CAsyncRender *pipeline, const unsigned render_ms);
+	~bench_render_host_t();
+
+	virtual bool QueueRender(const uint32_t frame);
+	virtual void ReleaseFrame(void *handle) { m_released++; };
+
+	bool     PopFrame(uint32_t &frame); // [render-thread]
+	void     Render(const uint32_t frame);
+	uint64_t GetReleased() const { return m_released.load(); };
+
+protected:
+	CAsyncRender          *m_pipeline;
+	unsigned               m_render_ms;
+	CNvMutex               m_lock;
+	uint32_t               m_queue[ASYNCRENDER_MAX_WINDOW]; // (ring: the pipeline has at most a window queued)
+	uint32_t               m_head;
+	uint32_t               m_tail;
+	std::atomic<uint64_t>  m_released;
+	bench_render_thread_t *m_threads[BENCH_RENDER_THREADS];
+};
+
+class bench_render_thread_t : public CNvThread
+{
+public:
+	bench_render_thread_t(bench_render_host_t *host) : CNvThread("bench_render_thread_t"), m_host(host) { };
+
+protected:
+	virtual bool ThreadFunc()
+	{
+		uint32_t frame;
+		if (!m_host->PopFrame(frame))
+			return false; // sleep until QueueRender()
+		m_host->Render(frame);
+		return true;
+	};
+
+	bench_render_host_t *m_host;
+};
+
+bench_render_host_t::bench_render_host_t(CAsyncRender *pipeline, const unsigned render_ms) :
+	m_pipeline(pipeline), m_render_ms(render_ms), m_head(0), m_tail(0), m_released(0)
+{
+	for (unsigned i = 0; i < BENCH_RENDER_THREADS; ++i) {
+		m_threads[i] = new bench_render_thread_t(this);
+		m_threads[i]->ThreadStart(true);
+	}
+}
+
+bench_render_host_t::~bench_render_host_t()
+{
+	for (unsigned i = 0; i < BENCH_RENDER_THREADS; ++i) {
+		m_threads[i]->ThreadQuit();
+		delete m_threads[i];
+	}
+}
+
+bool bench_render_host_t::QueueRender(const uint32_t frame)
+{
+	m_lock.Acquire();
+	m_queue[m_tail++ % ASYNCRENDER_MAX_WINDOW] = frame;
+	m_lock.Release();
+
+	for (unsigned i = 0; i < BENCH_RENDER_THREADS; ++i)
+		m_threads[i]->ThreadTrigger();
+	return true;
+}
+
+bool bench_render_host_t::PopFrame(uint32_t &frame)
+{
+	CNvAutoMutex lock(m_lock);
+	if (m_head == m_tail)
+		return false;
+	frame = m_queue[m_head++ % ASYNCRENDER_MAX_WINDOW];
+	return true;
+}
+
+void bench_render_host_t::Render(const uint32_t frame)
+{
+	// 0.5x, 1.0x, 1.5x the render-time, in turn
+	NvSleep( m_render_ms * (1 + frame % 3) / 2 );
+
+	// (the handle is only a token: the frames all share the source framebuffer)
+	m_pipeline->Complete(frame, reinterpret_cast<void *>(static_cast<uintptr_t>(frame) + 1), 0);
+}
+
+// bench_open() - OpenEncodeSession + InitializeEncoderCodec, like the plugin
+static bool bench_open(CNvEncoder *enc, const EncodeConfig &cfg, const bool hevc)
+{
+	NVENCSTATUS nvencstatus = NV_ENC_SUCCESS;
+	HRESULT hr = enc->OpenEncodeSession(cfg, 0, nvencstatus);
+	if (hr != S_OK) {
+		printf("nvencbench: OpenEncodeSession() failed (NVENCSTATUS %d)\n", static_cast<int>(nvencstatus));
+		return false;
+	}
+
+	NV_ENC_CONFIG_H264_VUI_PARAMETERS vui;
+	NV_ENC_CONFIG_HEVC_VUI_PARAMETERS vui265;
+	memset( (void *)&vui, 0, sizeof(vui) );
+	memset( (void *)&vui265, 0, sizeof(vui265) );
+	hr = enc->InitializeEncoderCodec(hevc ? static_cast<void *>(&vui265) : static_cast<void *>(&vui));
+	if (hr != S_OK) {
+		printf("nvencbench: InitializeEncoderCodec() failed\n");
+		return false;
+	}
+	return true;
+}
+
+static void usage()
+{
+	printf("usage: nvencbench [-codec h264|hevc] [-size WxH] [-frames n]\n"
+		"                  [-input yuv420|yuy2|uyvy|yuv444|rgbf|v210|vuya|rgb8|rgb16]\n"
+		"                  [-10bit] [-latency usec] [-bytes n]\n"
+		"                  [-bitrate bps] [-bframes n] [-threads n] [-noavx] [-async] [-noread] [-o file]\n"
+		"                  [-syncio] [-telemetry file.csv|file.json] [-allocs] [-lookahead n] [-scenes n]\n"
+		"                  [-twopass] [-ladder n] [-render msec] [-renderahead n] [-spill MB] [-spillraw]\n");
+}
+
+int main(int argc, char *argv[])
+{
+	std::string codec     = "h264";
+	std::string input     = "yuv420";
+	std::string out_name;
+	std::string telemetry_name;
+	unsigned    width     = 1920;
+	unsigned    height    = 1080;
+	unsigned    frames    = 600;
+	unsigned    bitrate   = 25 * 1000 * 1000;
+	int         bframes   = 1;
+	unsigned    threads   = 0;
+	bool        avx       = true;
+	bool        async     = false;
+	bool        check_allocs = false;
+	bool        syncio    = false;
+	unsigned    lookahead = 0;
+	unsigned    scenes    = 0;
+	bool        twopass   = false;
+	unsigned    ladder    = 0;
+	unsigned    render_ms = 0;
+	unsigned    renderahead = 1;
+	unsigned    spill_mb  = 0;
+	bool        spill_compress = true;
+	bool        ten_bit   = false;
+
+	nvencsim_config_t sim;
+	NvEncSim_GetConfig(sim);
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string a = argv[i];
+		const bool has_value = (i + 1 < argc);
+
+		if (a == "-codec" && has_value)        codec = argv[++i];
+		else if (a == "-size" && has_value) {
+			if (sscanf(argv[++i], "%ux%u", &width, &height) != 2) {
+				usage();
+				return 1;
+			}
+		}
+		else if (a == "-frames" && has_value)  frames      = static_cast<unsigned>(atoi(argv[++i]));
+		else if (a == "-input" && has_value)   input       = argv[++i];
+		else if (a == "-10bit")                ten_bit     = true;
+		else if (a == "-latency" && has_value) sim.latency_us  = static_cast<uint32_t>(atoi(argv[++i]));
+		else if (a == "-bytes" && has_value)   sim.frame_bytes = static_cast<uint32_t>(atoi(argv[++i]));
+		else if (a == "-bitrate" && has_value) bitrate     = static_cast<unsigned>(atoi(argv[++i]));
+		else if (a == "-bframes" && has_value) bframes     = atoi(argv[++i]);
+		else if (a == "-threads" && has_value) threads     = static_cast<unsigned>(atoi(argv[++i]));
+		else if (a == "-noavx")                avx         = false;
+		else if (a == "-async")                async       = true;
+		else if (a == "-noread")               sim.read_input = false;
+		else if (a == "-o" && has_value)       out_name    = argv[++i];
+		else if (a == "-syncio")               syncio      = true;
+		else if (a == "-telemetry" && has_value) telemetry_name = argv[++i];
+		else if (a == "-allocs")               check_allocs = true;
+		else if (a == "-lookahead" && has_value) lookahead = static_cast<unsigned>(atoi(argv[++i]));
+		else if (a == "-scenes" && has_value)  scenes      = static_cast<unsigned>(atoi(argv[++i]));
+		else if (a == "-twopass")              twopass     = true;
+		else if (a == "-ladder" && has_value)  ladder      = static_cast<unsigned>(atoi(argv[++i]));
+		else if (a == "-render" && has_value)  render_ms   = static_cast<unsigned>(atoi(argv[++i]));
+		else if (a == "-renderahead" && has_value) renderahead = static_cast<unsigned>(atoi(argv[++i]));
+		else if (a == "-spill" && has_value)   spill_mb    = static_cast<unsigned>(atoi(argv[++i]));
+		else if (a == "-spillraw")             spill_compress = false;
+		else {
+			usage();
+			return 1;
+		}
+	}
+
+	const bool hevc         = (codec == "hevc" || codec == "h265");
+	const bool input_yuv420 = (input == "yuv420");
+	const bool input_yuyv   = (input == "yuy2");
+	const bool input_uyvy   = (input == "uyvy");
+	const bool input_yuv444 = (input == "yuv444");
+	const bool input_rgbf   = (input == "rgbf");
+	const bool input_v210   = (input == "v210");
+	const bool input_vuya   = (input == "vuya"); // (VUYA framebuffer, 4:2:0 encode)
+	const bool input_rgb8   = (input == "rgb8");
+	const bool input_rgb16  = (input == "rgb16");
+	if (!(input_yuv420 || input_yuyv || input_uyvy || input_yuv444 || input_rgbf || input_v210 || input_vuya ||
+		input_rgb8 || input_rgb16) || !width || !height || !frames ||
+		(ten_bit && (!hevc || !(input_rgbf || input_v210))) ||
+		(ladder && (!input_yuv420 || ladder < 2 || ladder > ABR_LADDER_MAX_RUNGS)) ||
+		!renderahead || renderahead > ASYNCRENDER_MAX_WINDOW || (spill_mb && (!twopass || ladder))) {
+		usage();
+		return 1;
+	}
+	if (hevc && bframes > 0)
+		bframes = 0; // NVENC HEVC has no B-frames
+
+#if defined __linux || defined __APPLE_ || defined __MACOSX
+	NvPthreadABIInit();
+#endif
+
+	NvEncSim_SetConfig(sim);
+	CNvEncoder::UseSoftwareEncodeAPI(true);
+
+	CNvEncoder *enc = NULL;
+	if (hevc)
+		enc = new CNvEncoderH265();
+	else
+		enc = new CNvEncoderH264();
+
+	EncodeConfig cfg;
+	enc->initEncoderConfig(&cfg);
+
+	bench_output_t out;
+	out.fp     = NULL;
+	out.writer = NULL;
+	out.bytes  = 0;
+	out.frames = 0;
+	if (!out_name.empty()) {
+		bool opened;
+		if (syncio) {
+			out.fp = fopen(out_name.c_str(), "wb");
+			opened = (out.fp != NULL);
+		}
+		else {
+			// preallocate the file for the expected bitrate
+			const double seconds = cfg.frameRateNum ?
+				static_cast<double>(frames) * cfg.frameRateDen / cfg.frameRateNum : 0.0;
+			out.writer = new CFileWriter();
+			opened = out.writer->Open(out_name.c_str(), static_cast<uint64_t>(seconds * bitrate / 8.0 * 1.05));
+		}
+		if (!opened) {
+			printf("nvencbench: unable to open %s\n", out_name.c_str());
+			return 1;
+		}
+	}
+
+	cfg.codec           = hevc ? NV_ENC_H265 : NV_ENC_H264;
+	cfg.width           = width;
+	cfg.height          = height;
+	cfg.maxWidth        = width;
+	cfg.maxHeight       = height;
+	cfg.avgBitRate      = bitrate;
+	cfg.peakBitRate     = bitrate + bitrate / 2;
+	cfg.numBFrames      = static_cast<unsigned>(bframes);
+	cfg.syncMode        = async ? 0 : 1; // (CNvEncoderH264/H265: syncMode==0 selects async-mode)
+	cfg.chromaFormatIDC = input_yuv444 ? cudaVideoChromaFormat_444 : cudaVideoChromaFormat_420;
+	cfg.pixelBitDepthMinus8 = ten_bit ? 2 : 0;
+	cfg.CPU_enableAVX    = avx;
+	cfg.CPU_enableAVX2   = avx;
+	cfg.CPU_enableAVX512 = avx;
+	cfg.CPU_numThreads  = threads;
+	cfg.CPU_lookahead   = lookahead;
+	cfg.fOutput         = out.fp;
+
+	enc->Register_fwrite_callback(bench_fwrite_callback);
+
+	// the source framebuffer (same layout as the frames which Premiere Pro renders)
+	EncodeFrameConfig frame;
+	memset( (void *)&frame, 0, sizeof(frame) );
+	frame.width  = width;
+	frame.height = height;
+	frame.ppro_pixelformat_is_yuv420  = input_yuv420;
+	frame.ppro_pixelformat_is_yuyv422 = input_yuyv;
+	frame.ppro_pixelformat_is_uyvy422 = input_uyvy;
+	frame.ppro_pixelformat_is_yuv444  = input_yuv444 || input_vuya;
+	frame.ppro_pixelformat_is_rgb444f = input_rgbf;
+	frame.ppro_pixelformat_is_rgb444_8u  = input_rgb8;
+	frame.ppro_pixelformat_is_rgb444_16u = input_rgb16;
+	frame.ppro_pixelformat_is_v210    = input_v210;
+
+	std::vector<unsigned char> plane[3];
+	if (input_yuv420) {
+		frame.stride[0] = (width + 63) & ~63;
+		frame.stride[1] = frame.stride[2] = ((width / 2) + 63) & ~63;
+		plane[0].resize(static_cast<size_t>(frame.stride[0]) * height, 0x80);
+		plane[1].resize(static_cast<size_t>(frame.stride[1]) * (height / 2), 0x70);
+		plane[2].resize(static_cast<size_t>(frame.stride[2]) * (height / 2), 0x90);
+	}
+	else {
+		const unsigned bpp = input_rgbf ? 16 : input_rgb16 ? 8 : (input_yuv444 || input_vuya || input_rgb8) ? 4 : 2;
+		frame.stride[0] = input_v210 ?
+			((width + 47) / 48) * 128 : // v210: 6 pixels per 16 bytes, rows padded to 128 bytes
+			width * bpp;
+		plane[0].resize(static_cast<size_t>(frame.stride[0]) * height);
+		if (input_rgbf) {
+			float *p = reinterpret_cast<float *>(&plane[0][0]);
+			for (size_t i = 0; i < plane[0].size() / sizeof(float); ++i)
+				p[i] = static_cast<float>(i % 251) / 251.0f;
+		}
+		else if (input_rgb16) {
+			uint16_t *p = reinterpret_cast<uint16_t *>(&plane[0][0]);
+			for (size_t i = 0; i < plane[0].size() / sizeof(uint16_t); ++i)
+				p[i] = static_cast<uint16_t>((i * 7) % 32769); // (Premiere's 16u range: 0-32768)
+		}
+		else {
+			for (size_t i = 0; i < plane[0].size(); ++i)
+				plane[0][i] = static_cast<unsigned char>(i * 7);
+		}
+	}
+	for (int i = 0; i < 3; ++i)
+		frame.yuv[i] = plane[i].empty() ? NULL : &plane[i][0];
+	const unsigned source_bpp = input_yuv420 ? 1 : input_rgbf ? 16 : input_rgb16 ? 8 :
+		(input_yuv444 || input_vuya || input_rgb8) ? 4 : 2;
+
+	// two-pass: pass 1 encodes the sequence at constant QP (its bitstream is discarded), and
+	//   writes the stats which plan the bitrate of each segment in pass 2 (the measured run)
+	FILE *twopass_stats = NULL;
+	FILE *spill_fp = NULL;
+	CSpillCache spill;
+	if (twopass) {
+		EncodeConfig cfg1 = cfg;
+		CNvEncoder::SetTwoPassAnalysisConfig(cfg1);
+		cfg1.fOutput = NULL;
+
+		bench_output_t discard;
+		memset( (void *)&discard, 0, sizeof(discard) );
+		enc->m_privateData = &discard;
+
+		twopass_stats = tmpfile();
+		if (!twopass_stats || !bench_open(enc, cfg1, hevc) ||
+			!enc->GetTwoPass().BeginPass1(twopass_stats, cfg1.frameRateNum, cfg1.frameRateDen, TWOPASS_PASS1_QP))
+		{
+			printf("nvencbench: two-pass: pass 1 failed to start\n");
+			return 1;
+		}
+		if (spill_mb) {
+			spill_fp = tmpfile();
+			if (!spill_fp || !spill.Begin(spill_fp, static_cast<uint64_t>(spill_mb) << 20, spill_compress)) {
+				printf("nvencbench: spill cache: unable to create the scratch file\n");
+				return 1;
+			}
+			enc->SetSpillCache(&spill);
+		}
+		for (unsigned n = 0; n < frames; ++n) {
+			if (scenes && (n % scenes) == 0)
+				bench_draw_scene(frame, source_bpp, input_rgbf, n / scenes);
+			if (enc->EncodeFramePPro(&frame, false) != S_OK)
+				break;
+		}
+		enc->EncodeFramePPro(NULL, true);
+		enc->DestroyEncoder();
+		const bool stats_ok = enc->GetTwoPass().EndPass1();
+		printf("nvencbench: two-pass: pass 1 %u frames (%llu bytes at QP %u)%s\n", (unsigned)discard.frames,
+			(unsigned long long)discard.bytes, TWOPASS_PASS1_QP, stats_ok ? "" : ", STATS WRITE FAILED");
+	}
+
+	enc->m_privateData = &out;
+	if (!bench_open(enc, cfg, hevc))
+		return 1;
+
+	if (twopass) {
+		if (!enc->GetTwoPass().Plan(twopass_stats, cfg.avgBitRate, cfg.peakBitRate)) {
+			printf("nvencbench: two-pass: the pass 1 stats are unusable\n");
+			return 1;
+		}
+		if (spill_mb)
+			spill.Rewind(); // (pass 2 converts the frames which didn't fit)
+	}
+
+	// ABR ladder: an encoder-session per rung below the source, fed from the downscale pyramid
+	CAbrLadder abr_ladder;
+	abr_rung_t rungs[ABR_LADDER_MAX_RUNGS];
+	const uint32_t rung_count = ladder ?
+		CAbrLadder::Plan(width, height, cfg.avgBitRate, cfg.peakBitRate, ladder, rungs) : 1;
+	std::vector<CNvEncoder *>      rung_enc(rung_count, static_cast<CNvEncoder *>(NULL));
+	std::vector<bench_output_t>    rung_out(rung_count);
+	std::vector<EncodeFrameConfig> rung_frame(rung_count);
+	if (ladder) {
+		if (rung_count < 2 || !abr_ladder.Init(rungs, rung_count)) {
+			printf("nvencbench: ABR ladder: %ux%u is too small for a second rung\n", width, height);
+			return 1;
+		}
+		for (uint32_t r = 1; r < rung_count; ++r) {
+			EncodeConfig rung_cfg = cfg;
+			rung_cfg.width       = rung_cfg.maxWidth  = rungs[r].width;
+			rung_cfg.height      = rung_cfg.maxHeight = rungs[r].height;
+			rung_cfg.avgBitRate  = rungs[r].avg_bps;
+			rung_cfg.peakBitRate = rungs[r].peak_bps;
+			rung_cfg.fOutput     = NULL;
+
+			memset( (void *)&rung_out[r], 0, sizeof(bench_output_t) );
+			rung_enc[r] = hevc ? static_cast<CNvEncoder *>(new CNvEncoderH265()) : static_cast<CNvEncoder *>(new CNvEncoderH264());
+			rung_enc[r]->Register_fwrite_callback(bench_fwrite_callback);
+			rung_enc[r]->m_privateData = &rung_out[r];
+			if (!bench_open(rung_enc[r], rung_cfg, hevc))
+				return 1;
+
+			rung_frame[r] = frame;
+			rung_frame[r].width  = rungs[r].width;
+			rung_frame[r].height = rungs[r].height;
+			for (uint32_t p = 0; p < 3; ++p) {
+				rung_frame[r].yuv[p]    = abr_ladder.GetPlane(r, p);
+				rung_frame[r].stride[p] = abr_ladder.GetStride(r, p);
+			}
+		}
+	}
+
+	printf("nvencbench: %s%s %ux%u, %u frames, input %s, %d B-frames, %s-mode, latency %u usec/picture, repack threads %u%s\n",
+		hevc ? "HEVC" : "H.264", ten_bit ? " Main10" : "", width, height, frames, input.c_str(), bframes, async ? "async" : "sync",
+		sim.latency_us, enc->m_Repackyuv.get_num_threads(), avx ? "" : " (no AVX)");
+
+	// emulated host renderer: the frames arrive through the render-ahead pipeline
+	CAsyncRender render_pipeline;
+	bench_render_host_t *render_host = render_ms ? new bench_render_host_t(&render_pipeline, render_ms) : NULL;
+	unsigned render_order_errors = 0;
+
+	NvEncSim_ResetStats();
+	double encode_call_us = 0.0, encode_call_max_us = 0.0, downscale_us = 0.0;
+	const double t0 = NvQueryPerformanceMicrosecs();
+	if (render_host)
+		render_pipeline.Begin(render_host, 0, frames, renderahead);
+
+	// steady state: after the warm-up, until the last frame is submitted (the output-thread runs concurrently)
+	const unsigned warmup = (frames > 2 * BENCH_WARMUP_FRAMES) ? BENCH_WARMUP_FRAMES : frames / 2;
+	unsigned reconfigures = 0;
+	unsigned spilled = 0;
+	HRESULT hr = S_OK;
+	for (unsigned n = 0; n < frames; ++n) {
+		if (n == warmup)
+			g_count_allocs = true;
+		if (scenes && (n % scenes) == 0)
+			bench_draw_scene(frame, source_bpp, input_rgbf, n / scenes);
+
+		asyncrender_frame_t rendered;
+		if (render_host) {
+			if (!render_pipeline.Next(rendered)) {
+				printf("nvencbench: the renderer lost frame %u\n", n);
+				break;
+			}
+			if (rendered.frame != n || rendered.status != 0)
+				render_order_errors++;
+		}
+
+		const double t = NvQueryPerformanceMicrosecs();
+		twopass_rate_t rate;
+		if (twopass && enc->GetTwoPass().NextFrame(rate)) {
+			EncodeConfig segment = cfg;
+			CNvEncoder::SetTwoPassSegmentConfig(segment, rate);
+			if (enc->ReconfigureEncoder(segment) == S_OK)
+				reconfigures++;
+		}
+		hr = spill.GetRemaining() ? enc->EncodeSpilledFrame(&frame) : S_FALSE;
+		if (hr == S_OK)
+			spilled++;
+		else if (hr == S_FALSE)
+			hr = enc->EncodeFramePPro(&frame, false);
+		if (ladder && hr == S_OK) {
+			const double t_downscale = NvQueryPerformanceMicrosecs();
+			abr_ladder.Downscale(frame.yuv, frame.stride);
+			downscale_us += NvQueryPerformanceMicrosecs() - t_downscale;
+			for (uint32_t r = 1; r < rung_count && hr == S_OK; ++r)
+				hr = rung_enc[r]->EncodeFramePPro(&rung_frame[r], false);
+		}
+		const double dt = NvQueryPerformanceMicrosecs() - t;
+		if (render_host)
+			render_pipeline.Release(rendered); // (the host may now render frame n + renderahead)
+
+		encode_call_us += dt;
+		if (dt > encode_call_max_us)
+			encode_call_max_us = dt;
+		if (hr != S_OK) {
+			printf("nvencbench: EncodeFramePPro() failed at frame %u\n", n);
+			break;
+		}
+	}
+
+	g_count_allocs = false;
+	const uint64_t steady_allocs = g_allocs;
+	const unsigned steady_frames = frames - warmup;
+
+	const double t_submitted = NvQueryPerformanceMicrosecs();
+	render_pipeline.End();
+	enc->EncodeFramePPro(NULL, true); // flush
+	enc->DestroyEncoder();            // waits for the output-thread
+	for (uint32_t r = 1; r < rung_count; ++r) {
+		rung_enc[r]->EncodeFramePPro(NULL, true);
+		rung_enc[r]->DestroyEncoder();
+	}
+	const bool write_ok = out.writer ? out.writer->Close() : true;
+	const double t1 = NvQueryPerformanceMicrosecs();
+
+	EncodeCompletionStats cs;
+	enc->GetCompletionStats(cs);
+	EncodeBitstreamPoolStats ps;
+	enc->GetBitstreamPoolStats(ps);
+
+	nvencsim_stats_t st;
+	NvEncSim_GetStats(st);
+	const double n = st.frames ? static_cast<double>(st.frames) : 1.0;
+	const double elapsed_s = (t1 - t0) / 1000000.0;
+
+	printf("\n");
+	printf("  frames written     %llu (%llu bytes)\n", (unsigned long long)out.frames, (unsigned long long)out.bytes);
+	printf("  elapsed            %.3f sec (submit %.3f sec, drain %.3f sec)\n",
+		elapsed_s, (t_submitted - t0) / 1000000.0, (t1 - t_submitted) / 1000000.0);
+	printf("  throughput         %.2f fps (engine limit %.2f fps)\n",
+		elapsed_s > 0.0 ? static_cast<double>(frames) / elapsed_s : 0.0,
+		sim.latency_us ? 1000000.0 / static_cast<double>(sim.latency_us) : 0.0);
+	printf("  EncodeFramePPro()  avg %.1f usec, max %.1f usec\n", encode_call_us / frames, encode_call_max_us);
+	printf("  completion latency avg %.1f usec, max %.1f usec (%u frames)\n",
+		cs.frames ? cs.total_us / cs.frames : 0.0, cs.max_us, cs.frames);
+	printf("  per picture (avg usec):\n");
+	printf("    convert          %.1f\n", st.convert_us / n);
+	printf("    submit           %.1f\n", st.submit_us / n);
+	printf("    queue            %.1f\n", st.queue_us / n);
+	printf("    encode           %.1f\n", st.encode_us / n);
+	printf("    drain            %.1f\n", st.drain_us / n);
+	printf("    write            %.1f\n", st.write_us / n);
+	printf("  max in flight      %u\n", st.max_in_flight);
+	printf("  bitstream-buffers  %u x %u KB (initial %u KB, grown %u times), %u truncated\n",
+		ps.buffers, ps.buffer_size / 1024, ps.initial_size / 1024, ps.grow_count, st.overflows);
+	printf("    utilization      avg %.1f%%, peak %.1f%% (largest frame %u bytes)\n",
+		ps.frames ? 100.0 * ps.total_utilization / ps.frames : 0.0, 100.0 * ps.peak_utilization, ps.peak_frame_bytes);
+	printf("  heap allocations   %llu in %u steady-state frames (after %u warm-up frames)\n",
+		(unsigned long long)steady_allocs, steady_frames, warmup);
+
+	const CNvEncTelemetry &telemetry = enc->GetTelemetry();
+	nvenc_telemetry_summary_t ts;
+	telemetry.GetSummary(ts);
+	printf("  telemetry          %u records, avg QP %.1f, peak 1-sec bitrate %.0f kbps (frame %u)\n",
+		telemetry.GetRecordCount(), ts.qp_frames ? static_cast<double>(ts.qp_total) / ts.qp_frames : 0.0,
+		ts.max_rolling_bps / 1000.0, ts.max_rolling_frame);
+	printf("    longest gap      %.1f usec (before frame %u)\n", ts.max_interval_us, ts.max_interval_frame);
+	if (lookahead)
+		printf("  lookahead          %u frames, %u scene-cuts (%u scene changes), %u IDR\n",
+			CNvEncoder::CalculateLookaheadDepth(cfg), ts.scene_cuts, scenes ? (frames - 1) / scenes : 0, ts.pic_types[NV_ENC_PIC_TYPE_IDR]);
+	if (twopass) {
+		const CNvEncTwoPass &tp = enc->GetTwoPass();
+		printf("  two-pass           %u segments (%u reconfigured), target %llu bytes, coded %llu bytes (%+.2f%%)\n",
+			tp.GetSegmentCount(), reconfigures, (unsigned long long)tp.GetTargetBytes(), (unsigned long long)tp.GetCodedBytes(),
+			tp.GetTargetBytes() ? 100.0 * (static_cast<double>(tp.GetCodedBytes()) / tp.GetTargetBytes() - 1.0) : 0.0);
+	}
+	if (spill_mb) {
+		const spill_stats_t &ss = spill.GetStats();
+		printf("  spill cache        %u of %u frames read back%s, %llu MB on disk (%llu MB uncompressed)\n",
+			spilled, frames, ss.full ? " (budget exceeded)" : "",
+			(unsigned long long)(ss.file_bytes >> 20), (unsigned long long)(ss.raw_bytes >> 20));
+		printf("                     write avg %.1f usec/frame, read avg %.1f usec/frame\n",
+			ss.frames ? ss.write_us / ss.frames : 0.0, spilled ? ss.read_us / spilled : 0.0);
+	}
+	if (render_host) {
+		const asyncrender_stats_t &rs = render_pipeline.GetStats();
+		printf("  render             %u msec/frame, %u ahead (max %u in flight), waited %u times, %.1f msec%s\n",
+			render_ms, renderahead, rs.max_inflight, rs.waits, rs.wait_us / 1000.0,
+			render_order_errors ? ", OUT OF ORDER" : "");
+		printf("                     %u frames queued, %llu released\n", rs.queued, (unsigned long long)render_host->GetReleased());
+	}
+	if (ladder) {
+		printf("  ABR ladder         %u rungs, downscale avg %.1f usec/frame\n", rung_count, downscale_us / frames);
+		for (uint32_t r = 0; r < rung_count; ++r) {
+			const bench_output_t &o = r ? rung_out[r] : out;
+			printf("    %4ux%-4u        %llu frames, %llu bytes (target %u kbps)\n", rungs[r].width, rungs[r].height,
+				(unsigned long long)o.frames, (unsigned long long)o.bytes, rungs[r].avg_bps / 1000);
+		}
+	}
+	if (!telemetry_name.empty()) {
+		const bool json = telemetry_name.size() >= 5 && telemetry_name.compare(telemetry_name.size() - 5, 5, ".json") == 0;
+		FILE *fp = fopen(telemetry_name.c_str(), "w");
+		const bool ok = fp && (json ? telemetry.WriteJSON(fp) : telemetry.WriteCSV(fp));
+		if (fp)
+			fclose(fp);
+		if (!ok)
+			printf("nvencbench: unable to write %s\n", telemetry_name.c_str());
+	}
+	if (out.writer) {
+		filewriter_stats_t ws;
+		out.writer->GetStats(ws);
+		printf("  file-writer        %llu writes (%s%s), %llu stalls, %.1f msec stalled%s\n",
+			(unsigned long long)ws.writes, ws.unbuffered ? "unbuffered" : "buffered",
+			ws.preallocated ? ", preallocated" : "", (unsigned long long)ws.stalls, ws.stall_us / 1000.0,
+			write_ok ? "" : ", WRITE FAILED");
+	}
+
+	delete render_host;       // (stops the render-threads: no more Complete() calls)
+	render_pipeline.Detach();
+	delete enc;
+	for (uint32_t r = 1; r < rung_count; ++r)
+		delete rung_enc[r];
+	delete out.writer;
+	if (out.fp)
+		fclose(out.fp);
+	if (twopass_stats)
+		fclose(twopass_stats);
+	spill.End();
+	if (spill_fp)
+		fclose(spill_fp);
+
+	if (check_allocs && steady_allocs) {
+		printf("nvencbench: FAILED, the steady-state encode loop allocated %llu times\n", (unsigned long long)steady_allocs);
+		return 3;
+	}
+	if (render_order_errors) {
+		printf("nvencbench: FAILED, %u frames arrived out of order from the renderer\n", render_order_errors);
+		return 4;
+	}
+	return write_ok ? 0 : 1;
+}
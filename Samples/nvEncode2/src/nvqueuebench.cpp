@@ -0,0 +1,181 @@
+//
+// nvqueuebench - micro-benchmark of the queues between the CNvEncoder threads
+//
+//   Compares CNvQueue (mutex + two semaphores per Add/Remove) with CNvRing (lock-free
+//   single-producer/single-consumer ring), with the element type and depth of the
+//   encoder's surface/output-thread queues (MAX_OUTPUT_QUEUE = 32).
+//
+//   Tests:
+//     stream    one thread Add()s, the other Remove(INFINITE)s: throughput of a full
+//               producer/consumer pipeline (like EncodeFramePPro -> output-thread)
+//     pingpong  two queues, one item bounces between two threads: wake-up latency
+//               when the consumer is blocked on an empty queue every time
+//     local     Add() + Remove(0) on the same thread (like m_pEncodeFrameQueue):
+//               uncontended cost of one round-trip through the queue
+//
+//   usage: nvqueuebench [-items <n>] [-depth <n>]
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "xcodeutil.h"  // NvQueryPerformanceMicrosecs()
+
+#if defined __linux || defined __APPLE_ || defined __MACOSX
+#include <threads/NvPthreadABI.h>
+#endif
+
+#define QUEUEBENCH_DEPTH 32 // MAX_OUTPUT_QUEUE
+
+// same size as CNvEncoder's EncoderThreadData
+typedef struct {
+	void *pOutputBfr;
+	void *pInputBfr;
+} bench_item_t;
+
+// Add()s uItems items to m_pQueue (or, in ping-pong mode, echoes every item from m_pQueue into m_pReply)
+template<class Q>
+class CBenchThread : public CNvThread {
+public:
+	CBenchThread(Q *pQueue, Q *pReply, U32 uItems)
+	:	CNvThread("nvqueuebench", INvThreading::NV_THREAD_PRIORITY_NORMAL, true)
+	,	m_pQueue(pQueue)
+	,	m_pReply(pReply)
+	,	m_uItems(uItems)
+	{
+	}
+
+	void Start()	{ ThreadStart(); }
+	void Join()		{ ThreadQuit(); }
+
+protected:
+	virtual bool ThreadFunc()
+	{
+		bench_item_t item;
+		for (U32 i = 0; i < m_uItems; ++i) {
+			if (m_pReply) {
+				m_pQueue->Remove(item, INvThreading::NV_TIMEOUT_INFINITE);
+				m_pReply->Add(item);
+			}
+			else {
+				item.pOutputBfr = reinterpret_cast<void *>(static_cast<size_t>(i));
+				item.pInputBfr = NULL;
+				m_pQueue->Add(item);
+			}
+		}
+		return false;
+	}
+
+	Q *m_pQueue;
+	Q *m_pReply;
+	U32 m_uItems;
+};
+
+template<class Q>
+static double bench_stream(U32 uItems, U32 uDepth)
+{
+	Q queue(uDepth);
+	CBenchThread<Q> producer(&queue, NULL, uItems);
+
+	const double t0 = NvQueryPerformanceMicrosecs();
+	producer.Start();
+
+	bench_item_t item;
+	bool bInOrder = true;
+	for (U32 i = 0; i < uItems; ++i) {
+		queue.Remove(item, INvThreading::NV_TIMEOUT_INFINITE);
+		bInOrder &= item.pOutputBfr == reinterpret_cast<void *>(static_cast<size_t>(i));
+	}
+	const double t1 = NvQueryPerformanceMicrosecs();
+	producer.Join();
+
+	if (!bInOrder)
+		printf("  ERROR: items arrived out of order\n");
+	return (t1 - t0) * 1000.0 / uItems; // ns/item
+}
+
+template<class Q>
+static double bench_pingpong(U32 uItems, U32 uDepth)
+{
+	Q request(uDepth), reply(uDepth);
+	CBenchThread<Q> echo(&request, &reply, uItems);
+
+	echo.Start();
+	const double t0 = NvQueryPerformanceMicrosecs();
+
+	bench_item_t item = { NULL, NULL };
+	for (U32 i = 0; i < uItems; ++i) {
+		request.Add(item);
+		reply.Remove(item, INvThreading::NV_TIMEOUT_INFINITE);
+	}
+	const double t1 = NvQueryPerformanceMicrosecs();
+	echo.Join();
+
+	return (t1 - t0) * 1000.0 / uItems; // ns/round-trip
+}
+
+template<class Q>
+static double bench_local(U32 uItems, U32 uDepth)
+{
+	Q queue(uDepth);
+	bench_item_t item = { NULL, NULL };
+
+	const double t0 = NvQueryPerformanceMicrosecs();
+	for (U32 i = 0; i < uItems; ++i) {
+		queue.Add(item);
+		queue.Remove(item, 0);
+	}
+	const double t1 = NvQueryPerformanceMicrosecs();
+
+	return (t1 - t0) * 1000.0 / uItems; // ns/(Add+Remove)
+}
+
+static void bench_report(const char *test, const char *unit, double queue_ns, double ring_ns)
+{
+	printf("  %-9s %10.1f %10.1f   %5.1fx   (ns/%s)\n", test, queue_ns, ring_ns, ring_ns > 0.0 ? queue_ns / ring_ns : 0.0, unit);
+}
+
+int main(int argc, char *argv[])
+{
+	U32 uItems = 1000000;
+	U32 uDepth = QUEUEBENCH_DEPTH;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-items") && i + 1 < argc)
+			uItems = static_cast<U32>(strtoul(argv[++i], NULL, 10));
+		else if (!strcmp(argv[i], "-depth") && i + 1 < argc)
+			uDepth = static_cast<U32>(strtoul(argv[++i], NULL, 10));
+		else {
+			printf("usage: nvqueuebench [-items n] [-depth n]\n");
+			return 1;
+		}
+	}
+	if (!uItems || !uDepth) {
+		printf("usage: nvqueuebench [-items n] [-depth n]\n");
+		return 1;
+	}
+
+#if defined __linux || defined __APPLE_ || defined __MACOSX
+	NvPthreadABIInit();
+#endif
+
+	typedef CNvQueue<bench_item_t, QUEUEBENCH_DEPTH> queue_t;
+	typedef CNvRing<bench_item_t, QUEUEBENCH_DEPTH>  ring_t;
+
+	printf("nvqueuebench: %u items, depth %u\n", uItems, uDepth);
+	printf("  %-9s %10s %10s   %6s\n", "test", "CNvQueue", "CNvRing", "speedup");
+
+	bench_report("stream", "item",
+		bench_stream<queue_t>(uItems, uDepth), bench_stream<ring_t>(uItems, uDepth));
+
+	// a round-trip blocks twice, so it's 2 orders of magnitude slower: use fewer items
+	const U32 uRoundTrips = uItems / 10 ? uItems / 10 : 1;
+	bench_report("pingpong", "round-trip",
+		bench_pingpong<queue_t>(uRoundTrips, uDepth), bench_pingpong<ring_t>(uRoundTrips, uDepth));
+
+	bench_report("local", "Add+Remove",
+		bench_local<queue_t>(uItems, uDepth), bench_local<ring_t>(uItems, uDepth));
+
+	return 0;
+}
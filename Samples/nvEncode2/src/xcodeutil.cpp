@@ -14,6 +14,7 @@
 #include <threads/NvThreadingWin32.h>
 #elif defined __APPLE__ || defined __MACOSX || defined __linux || defined NV_UNIX
 #include <sys/time.h>
+#include <unistd.h>  // sysconf()
 #endif
 #include <platform/NvStrings.h>
 
@@ -302,7 +303,9 @@ bool XCODEAPI GetCPUBrand(char *pszCPUBrand, int iCPUBrandBytes)
 }
 unsigned int XCODEAPI GetCPUCoreCount()
 {
-    return 0;
+    // no portable physical-core query: report the online logical processors
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? static_cast<unsigned int>(n) : 0;
 }
 
 #endif // if defined(_WIN32)
@@ -535,3 +538,20 @@ bool XCODEAPI NvQueryPerformanceCounter(U64 *counter)
     return true;
 }
 
+// The counter's tick-period (microseconds) is read once, during static initialization,
+// so NvQueryPerformanceMicrosecs() has no lazily-written state for threads to race on.
+static double _query_us_per_tick()
+{
+    U64 freq = 0;
+    return (NvQueryPerformanceFrequency(&freq) && freq) ? (1000000.0 / static_cast<double>(freq)) : 0.0;
+}
+
+static const double g_us_per_tick = _query_us_per_tick();
+
+double XCODEAPI NvQueryPerformanceMicrosecs()
+{
+    U64 counter = 0;
+    NvQueryPerformanceCounter(&counter);
+    return static_cast<double>(counter) * g_us_per_tick;
+}
+
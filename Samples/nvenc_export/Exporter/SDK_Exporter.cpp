@@ -59,6 +59,7 @@
 #include <iostream>
 #include <fstream>
 #include <windows.h> // CreateFile(), CloseHandle()
+#include <process.h> // _beginthreadex()
 
 //
 // fwrite_callback() - CNvEncoder calls this function whenever it wants to write bits to the output file.
@@ -70,7 +71,38 @@ fwrite_callback(_In_count_x_(_Size*_Count) void * _Str, size_t _Size, size_t _Co
 	prSuiteError 				resultS					= malNoError;
 	csSDK_uint32				exID					= exportInfoP->exporterPluginID;
 	ExportSettings				*mySettings = reinterpret_cast<ExportSettings *>(exportInfoP->privateData);
+
+	// Two-pass export: the bitstream of the analysis-pass is discarded (only its stats are kept)
+	if ( mySettings->twopass_pass == 1 )
+		return _Size * _Count;
 	
+	// TS output: the built-in muxer consumes the bitstream (no elementary-stream file)
+	if ( mySettings->p_TsWriter )
+		return mySettings->p_TsWriter->WriteBitstream(
+			reinterpret_cast<const uint8_t *>(_Str),
+			_Size * _Count,
+			mySettings->p_NvEncoder->m_lastOutputTimeStamp // display-order frame# (PTS of B-frames)
+		);
+
+	// MKV output: the built-in muxer consumes the bitstream (no elementary-stream file)
+	if ( mySettings->p_MkvWriter )
+		return mySettings->p_MkvWriter->WriteBitstream(
+			reinterpret_cast<const uint8_t *>(_Str),
+			_Size * _Count,
+			mySettings->p_NvEncoder->m_lastOutputTimeStamp // display-order frame# (block-timestamp of B-frames)
+		);
+
+	// MP4 output: the built-in muxer consumes the bitstream (no elementary-stream file)
+	if ( mySettings->p_Mp4Writer )
+		return mySettings->p_Mp4Writer->WriteBitstream(
+			reinterpret_cast<const uint8_t *>(_Str),
+			_Size * _Count,
+			mySettings->p_NvEncoder->m_lastOutputTimeStamp // display-order frame# (for B-frame reordering)
+		);
+
+	// Elementary-stream output: the writer-thread does the (large, aligned) file-writes
+	if ( mySettings->p_FileWriter )
+		return mySettings->p_FileWriter->Write( _Str, _Size * _Count );
 
 	//return fwrite(_Str, _Size, _Count, mySettings->SDKFileRec.FileRecord_Video.fp );
 /*
@@ -97,6 +129,62 @@ fwrite_callback(_In_count_x_(_Size*_Count) void * _Str, size_t _Size, size_t _Co
 		0; // write-error
 }
 
+//
+// nvenc_estimate_video_bytes() - expected size of the elementary-stream file (for preallocating it)
+//   returns 0 (unknown) for constQP, which has no bitrate
+//
+static uint64_t
+nvenc_estimate_video_bytes( const ExportSettings *mySettings, const PrTime exportDuration )
+{
+	const EncodeConfig &config = mySettings->NvEncodeConfig;
+	PrTime ticksPerSecond = 0;
+	uint32_t bitrate;
+
+	switch( config.rateControl ) {
+		case NV_ENC_PARAMS_RC_CONSTQP:
+			bitrate = 0;
+			break;
+		case NV_ENC_PARAMS_RC_CBR:
+			bitrate = config.avgBitRate;
+			break;
+		default: // VBR-modes: reserve for the peak, Close() releases what's left over
+			bitrate = (config.peakBitRate > config.avgBitRate) ? config.peakBitRate : config.avgBitRate;
+			break;
+	}
+
+	if ( !bitrate || exportDuration <= 0 || !mySettings->timeSuite ||
+		mySettings->timeSuite->GetTicksPerSecond(&ticksPerSecond) != malNoError || ticksPerSecond <= 0 )
+		return 0;
+
+	const double seconds = static_cast<double>(exportDuration) / static_cast<double>(ticksPerSecond);
+	return static_cast<uint64_t>( seconds * bitrate / 8.0 * 1.05 ); // +5% for SPS/PPS/SEI and rate-control overshoot
+}
+
+//
+// nvenc_write_telemetry() - write the encoder's per-frame records (CSV) and the summary/histograms (JSON)
+//   of the last encode-job to <filePath>_telemetry.csv and <filePath>_telemetry.json
+//
+static void
+nvenc_write_telemetry( const CNvEncTelemetry &telemetry, const wstring &filePath )
+{
+	wstring filename;
+	FILE *fp;
+
+	nvenc_make_output_filename( filePath, L"_telemetry", L"csv", filename );
+	fp = _wfopen( filename.c_str(), L"w" );
+	if ( fp ) {
+		telemetry.WriteCSV( fp );
+		fclose( fp );
+	}
+
+	nvenc_make_output_filename( filePath, L"_telemetry", L"json", filename );
+	fp = _wfopen( filename.c_str(), L"w" );
+	if ( fp ) {
+		telemetry.WriteJSON( fp );
+		fclose( fp );
+	}
+}
+
 SECURITY_ATTRIBUTES saAttr; 
 
 DllExport PREMPLUGENTRY xSDKExport (
@@ -436,6 +524,17 @@ prMALError exSDKEndInstance (
 			lRec->p_NvEncoder = NULL;
 		}
 
+		// Release the MP4/TS/MKV muxers (only still allocated if an export was interrupted)
+		NVENC_close_mp4( lRec );
+		NVENC_close_m2t( lRec );
+		NVENC_close_mkv( lRec );
+		NVENC_close_ladder( lRec );
+		if ( lRec->p_FileWriter ) {
+			lRec->p_FileWriter->Close();
+			delete lRec->p_FileWriter;
+			lRec->p_FileWriter = NULL;
+		}
+
 		
 		if (lRec->exportStdParamSuite)
 		{
@@ -844,7 +943,7 @@ prMALError exSDKFileList (  // used by selector exSelQueryOutputFileList()
 				newpath += SDK_FILE_EXTENSION_MP4;
 			}
 			else if (mux_selection.value.intValue == MUX_MODE_MKV) {
-				// MP4Box: single output file (*.mkv)
+				// MKV-muxer: single output file (*.mkv)
 				newpath += SDK_FILE_EXTENSION_MKV;
 			}
 			else if ( (i==0) && (inExportVideo) ) {
@@ -919,6 +1018,249 @@ void HandleOptionalExportSetting(
 	}
 }
 
+//
+// RenderAndWriteAudioFile() - render the audio into its own file:
+//                               *.wav (PCM), or *.m4a (AAC, encoded by neroAacEnc.exe)
+//
+static prMALError
+RenderAndWriteAudioFile(
+	exportStdParms	*stdParmsP,
+	exDoExportRec	*exportInfoP,
+	const prUTF16Char filePath[],  // path of the output-file (from the Adobe-application)
+	const csSDK_int32 audioCodec,
+	const PrTime	exportDuration,
+	const wstring	&postfix_str,     // tempfile postfixes (see exSDKExport)
+	const wstring	&wav_postfix_str,
+	const wstring	&aac_postfix_str
+) {
+	prMALError					result					= malNoError;
+	csSDK_uint32				exID					= exportInfoP->exporterPluginID;
+	ExportSettings				*mySettings				= reinterpret_cast<ExportSettings*>(exportInfoP->privateData);
+
+	// AAC-output: try pipe-mode first, fall back to the WAV tempfile if neroAacEnc can't be spawned
+	bool aac_pipe_mode = exportInfoP->exportAudio && (audioCodec == ADBEAudioCodec_AAC);
+
+	if (exportInfoP->exportAudio )
+	{
+		// AAC-output has two different output-modes:
+		//   These both generate exactly the same AAC-audio file, they only differ in the
+		//   use of an intermediate file or a windows-pipe.
+		//
+		// pipe-mode (default)
+		// ----------
+		// nvenc_export WAVoutput  ---> | pipe | ---> neroAacEnc.exe <stdin> ----> *.m4a file
+		//
+		//   Here nvenc_export inserts the '|pipe|' in between wav-output subssystem, and the
+		//   <stdin> of neroAacEnc.exe.  The neroAacEnc.exe is spawned using createProcess,
+		//   and encodes while the audio is being rendered.  No WAV tempfile is written.
+		//
+		// Non pipe-mode (fallback)
+		// --------------
+		//  nvenc_export WAVoutput  ---> *.wav file 
+		//  ShellExecute:  neroAacEnc.exe *.wav inputfile ----> *.m4a file
+		//
+		//   The whole WAV-file is written to disk, then read back by neroAacEnc.exe.
+
+		// Set FileRecord_Audio.filename to the *actual* outputfile path, which is one of the following:
+		//	  (1) for PCM-audio: *.wav
+		//	  (2) for AAC-audio: *.aac
+		nvenc_make_output_filename( 
+			filePath, 
+			wav_postfix_str,          // string to uniquify this filename (if necessary)
+			SDK_FILE_EXTENSION_WAV,
+			mySettings->SDKFileRec.FileRecord_Audio.filename
+		);
+
+		// AAC-audio output:
+		//   In AAC-mode, we don't create the audio output file directly, 
+		//   because neroAacEnc will do that automatically. Instead,
+		//   create a "logfile" for neroAacEnc.
+		if ( aac_pipe_mode ) {
+
+			// Generate the output-filename (*.aac) by combining the 
+			//   source filePath + ".aac"
+			nvenc_make_output_filename(
+				filePath,
+				aac_postfix_str,          // string to uniquify this filename (if necessary)
+				SDK_FILE_EXTENSION_M4A, // MPEG-4 audio file (AAC wrapped in an MPEG-4 stream)
+				mySettings->SDKFileRec.FileRecord_Audio.filename // generate the output-filename (*.aac)
+			);
+
+			nvenc_make_output_filename( 
+				filePath, 
+				postfix_str, // string to uniquify this filename (if necessary)
+				L"log",
+				mySettings->SDKFileRec.FileRecord_AAClog.filename
+			);
+
+			// Create stdin/stdout pipe.  When we run neroAacEnc.exe, the pipe
+			// will redirect output of nvenc_export's wav-writer into 
+			// the neroAacEnc.exe process.
+			//
+			// Nero-AAC does not write 'raw' AAC (ADTS) files,
+			//   it will wrap the AAC audio-stream in an MPEG-4 container (M4A)
+			aac_pipe_mode = NVENC_create_neroaac_pipe( mySettings ) &&
+				NVENC_spawn_neroaacenc(
+					exID,
+					mySettings,
+					mySettings->SDKFileRec.FileRecord_Audio.filename.c_str() // output filename
+				);
+
+			// Connect the pipe-output to the FileRecord_Audio's file-handle.
+			// When nvenc_export's wav-writer writes to FileRecord_Audio, 
+			// the data will be piped into the neroAacEnc process.
+			if ( aac_pipe_mode )
+				mySettings->SDKFileRec.FileRecord_Audio.hfp = mySettings->SDKFileRec.H_pipe_wavout;
+			else
+				nvenc_make_output_filename( // fallback: back to the *.wav tempfile
+					filePath, 
+					wav_postfix_str,
+					SDK_FILE_EXTENSION_WAV,
+					mySettings->SDKFileRec.FileRecord_Audio.filename
+				);
+		} // AAC
+
+		if ( !aac_pipe_mode ) {
+			DeleteFileW( mySettings->SDKFileRec.FileRecord_Audio.filename.c_str() );
+
+			// PCM-audio output (or the AAC-encoder's WAV input):
+			//   Create the *.wav output-file
+			mySettings->SDKFileRec.FileRecord_Audio.hfp = CreateFileW(
+				mySettings->SDKFileRec.FileRecord_Audio.filename.c_str(),
+				GENERIC_WRITE,
+				0, // don't share
+				NULL,
+				CREATE_ALWAYS,
+				FILE_ATTRIBUTE_NORMAL,
+				NULL
+			);
+
+			// sanity-check: if audiofile-creation failed, then abort the Export!
+			if ( mySettings->SDKFileRec.FileRecord_Audio.hfp == INVALID_HANDLE_VALUE )
+				return exportReturn_ErrInUse;
+		} //  if ( !aac_pipe_mode )
+
+		///////////////////////////////
+		//
+		// Write the audio
+		//
+
+		// (1) First, create the audio-file's WAV-header, 
+		//    which is written to the first 20-30 bytes of file
+		result = NVENC_WriteSDK_WAVHeader(stdParmsP, exportInfoP, exportDuration);
+
+		// (2) Now render the remaining audio
+		//     (If header creation failed, then skip this.)
+		if ( result == malNoError )
+			result = RenderAndWriteAllAudio(exportInfoP, exportDuration);
+
+		//
+		// Write the audio
+		//
+		///////////////////////////////
+
+		if ( aac_pipe_mode ) {
+			// in pipe-mode, NeroAacEnc is already running.  Close the pipe (so it sees the
+			// end of its input), then wait for it to finish writing the *.m4a file.
+			// (On error, it is killed instead.)
+			mySettings->SDKFileRec.FileRecord_Audio.hfp = NULL;
+			bool aac_result = NVENC_wait_neroaacenc(
+				mySettings,
+				mySettings->SDKFileRec.FileRecord_Audio.filename.c_str(), // output filename
+				result != malNoError
+			);
+
+			// If AAC-file doesn't exist, then something went severely wrong
+			if ( !aac_result && (result == malNoError) )
+				result = exportReturn_InternalError;
+		}
+		else
+			CloseHandle( mySettings->SDKFileRec.FileRecord_Audio.hfp );
+	} // exportAudio
+
+	// Verify the exportAudio operation succeeded.  If it failed, then quit now.
+	if ( result != malNoError )
+		return result; // exportAudio encountered an error, abort now
+
+	//
+	// kludge: AAC-audio requires execution of external third-party app: neroAacenc.exe
+	//
+	if (exportInfoP->exportAudio && (audioCodec == ADBEAudioCodec_AAC) && !aac_pipe_mode) {
+		// Generate the input-filename (*.wav) by combining the 
+		//   source filePath + ".wav"
+		wstring wav_infilename;
+		nvenc_make_output_filename(
+			filePath,
+			wav_postfix_str,      // string to uniquify this filename (if necessary)
+			SDK_FILE_EXTENSION_WAV, // MPEG-4 audio file (AAC wrapped in an MPEG-4 stream)
+			wav_infilename			// generate the output-filename (*.aac)
+		);
+
+		// Generate the output-filename (*.aac) by combining the 
+		//   source filePath + ".aac"
+		nvenc_make_output_filename(
+			filePath,
+			aac_postfix_str,      // string to uniquify this filename (if necessary)
+			SDK_FILE_EXTENSION_M4A, // MPEG-4 audio file (AAC wrapped in an MPEG-4 stream)
+			mySettings->SDKFileRec.FileRecord_Audio.filename // generate the output-filename (*.aac)
+		);
+
+		// Nero-AAC does not write 'raw' AAC (ADTS) files,
+		//   it will wrap the AAC audio-stream in an MPEG-4 container (M4A)
+		bool aac_result = NVENC_run_neroaacenc(
+			exID,
+			mySettings,
+			wav_infilename.c_str(), // input filename
+			mySettings->SDKFileRec.FileRecord_Audio.filename.c_str() // output filename
+		);
+
+		// If AAC-file doesn't exist, then something went severely wrong
+		if ( !aac_result )
+			return exportReturn_InternalError;
+		
+		// Once we are done with the WAV input file,
+		// delete it
+		DeleteFileW( wav_infilename.c_str() );
+	} // ADBEAudioCodec_AAC
+
+	return result;
+}
+
+//
+// Concurrent audio-export:  RenderAndWriteAudioFile() runs on its own thread,
+//                           while the calling thread renders/encodes the video.
+//
+//   Only the video-thread reports progress (it folds in mySettings->audio_progress_permille).
+//   If either stream fails, it sets mySettings->export_cancel, and the other stream stops early.
+//
+typedef struct {
+	exportStdParms		*stdParmsP;
+	exDoExportRec		*exportInfoP;
+	const prUTF16Char	*filePath;
+	csSDK_int32			audioCodec;
+	PrTime				exportDuration;
+	const wstring		*postfix_str;
+	const wstring		*wav_postfix_str;
+	const wstring		*aac_postfix_str;
+	prMALError			result; // (output) RenderAndWriteAudioFile() return-code
+} audio_thread_args_t;
+
+static unsigned __stdcall
+audio_thread_proc( void *arg )
+{
+	audio_thread_args_t *args = reinterpret_cast<audio_thread_args_t *>(arg);
+	ExportSettings *mySettings = reinterpret_cast<ExportSettings*>(args->exportInfoP->privateData);
+
+	args->result = RenderAndWriteAudioFile(args->stdParmsP, args->exportInfoP, args->filePath,
+		args->audioCodec, args->exportDuration, *args->postfix_str, *args->wav_postfix_str, *args->aac_postfix_str);
+
+	// audio failed: stop the video too
+	if ( args->result != malNoError )
+		InterlockedExchange( &mySettings->export_cancel, 1 );
+
+	return 0;
+}
+
 // The main export function
 prMALError exSDKExport( // used by selector exSelExport
 	exportStdParms	*stdParmsP,
@@ -936,19 +1278,46 @@ prMALError exSDKExport( // used by selector exSelExport
 	prUTF16Char					filePath[1024];
 	csSDK_int32					filePath_length;
 	csSDK_int32					muxType, audioCodec, videoCodec;
-	exParamValues exParamValues_muxPath;// path to muxer tool (TSMUXER or MP4BOX)
 	exParamValues exParamValue;
+	bool						mp4_fragmented;
+	bool						audio_concurrent_enabled;
+	bool						write_telemetry;
+	bool						two_pass;
+	csSDK_uint32				spill_gb;
+	bool						spill_compress;
+	csSDK_uint32				ladder_rungs;
 
 	// Get some UI-parameter selections
 	paramSuite->GetParamValue( exID, mgroupIndex, ADBEVMCMux_Type, &exParamValue );
 	muxType = exParamValue.value.intValue;
 
+	paramSuite->GetParamValue( exID, mgroupIndex, ParamID_BasicMux_MP4_Fragmented, &exParamValue );
+	mp4_fragmented = exParamValue.value.intValue ? true : false;
+
 	paramSuite->GetParamValue(exID, mgroupIndex, ParamID_NV_ENC_CODEC, &exParamValue);
 	videoCodec = exParamValue.value.intValue; // NV_ENC_H264 | NV_ENC_H265
 
 	paramSuite->GetParamValue(exID, mgroupIndex, ADBEAudioCodec, &exParamValue);
 	audioCodec = exParamValue.value.intValue;
 
+	paramSuite->GetParamValue(exID, mgroupIndex, ParamID_AudioFormat_Concurrent, &exParamValue);
+	audio_concurrent_enabled = exParamValue.value.intValue ? true : false;
+
+	paramSuite->GetParamValue(exID, mgroupIndex, ParamID_VideoCodec_Telemetry, &exParamValue);
+	write_telemetry = exParamValue.value.intValue ? true : false;
+
+	paramSuite->GetParamValue(exID, mgroupIndex, ParamID_VideoCodec_TwoPass, &exParamValue);
+	two_pass = exParamValue.value.intValue ? true : false;
+
+	paramSuite->GetParamValue(exID, mgroupIndex, ParamID_VideoCodec_SpillCache, &exParamValue);
+	spill_gb = exParamValue.value.intValue; // (0 = off)
+
+	paramSuite->GetParamValue(exID, mgroupIndex, ParamID_VideoCodec_SpillCompress, &exParamValue);
+	spill_compress = exParamValue.value.intValue ? true : false;
+
+	paramSuite->GetParamValue(exID, mgroupIndex, ParamID_VideoCodec_ABR_Ladder, &exParamValue);
+	ladder_rungs = exParamValue.value.intValue; // #renditions (1 = no ladder)
+
 	//
 	// During initialization, the export-plugin always constructs an object 
 	// of type CNvEncoderH264.  If necessary, change to the correct object-type.
@@ -1021,263 +1390,194 @@ prMALError exSDKExport( // used by selector exSelExport
 	}
 
 	//
-	// (1) First step: Render and write out the Video
+	// (0) TS/MKV output: render the Audio first.  The built-in TS/MKV muxers interleave
+	//     it with the video, as the encoder produces the video.
 	//
+	const bool audio_first = (muxType == MUX_MODE_M2T || muxType == MUX_MODE_MKV) && exportInfoP->exportAudio;
+	mySettings->audio_concurrent = false;
+	mySettings->audio_progress_permille = 0;
+	mySettings->export_cancel = 0;
+	if ( audio_first ) {
+		result = RenderAndWriteAudioFile(stdParmsP, exportInfoP, filePath, audioCodec, exportDuration,
+			postfix_str, wav_postfix_str, aac_postfix_str);
+		if ( result != malNoError )
+			return result; // exportAudio encountered an error, abort now
+	}
 
-	if (exportInfoP->exportVideo && !result )
-	{
-		// transfer the plugin UI settings to mySettings->NvEncodeConfig
-		NVENC_ExportSettings_to_EncodeConfig( exportInfoP->exporterPluginID, mySettings );
-
-		// Set FileRecord_Video.filename to the *actual* outputfile path:
-		//
-		//   (1) '*.hevc' (if codec==h265)
-		//   (2) '*.264'  (else if Multiplexer == MP4, and codec==h264,  because mp4box requires '.264' extension)
-		//   (3) '*.M4V'  (else all other choices)
-		nvenc_make_output_filename(
-			filePath,
-			v_postfix_str,          // string to uniquify this filename (if necessary)
-			(videoCodec == NV_ENC_H265) ? 
-				SDK_FILE_EXTENSION_HEVC :
-			((muxType == MUX_MODE_MP4) ? 
-				L"264" :				// mp4box requires H264-input file to have extension *.264
-				SDK_FILE_EXTENSION_M4V), // other: use default extension (.m4v)
-			mySettings->SDKFileRec.FileRecord_Video.filename
-		);
-
-		// Delete existing file, just in case it already exists
-		DeleteFileW( mySettings->SDKFileRec.FileRecord_Video.filename.c_str() );
-
-		// Create a new file:  the NVENC-encoder class will write the encoded video to this file
-		/*
-		mySettings->SDKFileRec.FileRecord_Video.fp = _wfopen( 
-			mySettings->SDKFileRec.FileRecord_Video.filename.c_str(),
-			L"wb"
-		);*/
-		mySettings->SDKFileRec.FileRecord_Video.hfp = CreateFileW(
-			mySettings->SDKFileRec.FileRecord_Video.filename.c_str(),
-			GENERIC_WRITE,
-			0, // don't share
-			NULL,
-			CREATE_ALWAYS,
-			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
-			NULL
-		);
-
-		// if videofile-creation failed, then abort the Export!
-		if ( mySettings->SDKFileRec.FileRecord_Video.hfp == NULL )
-			return exportReturn_ErrInUse;
-
-		result = RenderAndWriteAllVideo(exportInfoP, progress, videoProgress, &exportDuration);
-		//fclose( mySettings->SDKFileRec.FileRecord_Video.fp );
-		CloseHandle( mySettings->SDKFileRec.FileRecord_Video.hfp );
-
-		// If the video-encode failed catastrophically, quit out of everything now.
-		if ( mySettings->video_encode_fatalerr )
-			return result;
-	} // exportVideo
+	//
+	// Otherwise (no muxer, or MP4), the audio can be rendered on its own thread
+	// while the video encodes.  (The MP4 muxer appends the audio after the video.)
+	//
+	bool audio_concurrent = audio_concurrent_enabled && !audio_first &&
+		exportInfoP->exportAudio && exportInfoP->exportVideo;
+	HANDLE audio_thread = NULL;
+	audio_thread_args_t audio_args = { stdParmsP, exportInfoP, filePath, audioCodec, exportDuration,
+		&postfix_str, &wav_postfix_str, &aac_postfix_str, malNoError };
 
-	///////////////////////////////////////////////////////////
 	//
-	// (2) Second step: Render and write out the Audio
+	// (1) First step: Render and write out the Video
 	//
-	const bool aac_pipe_mode = false;// didn't get the Windows-pipe to work, keep this false
 
-	// Even if user aborted export during video rendering, we'll just finish the audio to that point since it is really fast
-	// and will make the export complete. How your exporter handles an abort, of course, is up to your implementation
-	if (exportInfoP->exportAudio )
+	if (exportInfoP->exportVideo && !result )
 	{
-		// AAC-output has two different output-modes:
-		//   These both generate exactly the same AAC-audio file, they only differ in the
-		//   use of an intermediate file or a windows-pipe.
-		//
-		// pipe-mode
-		// ----------
-		// nvenc_export WAVoutput  ---> | pipe | ---> neroAacEnc.exe <stdin> ----> *.m4a file
-		//
-		//   Here nvenc_export inserts the '|pipe|' in between wav-output subssystem, and the
-		//   <stdin> of neroAacEnc.exe.  The neroAacEnc.exe is spawned using createProcess.
-		//  Didn't work.
-		//
-		// Non pipe-mode
-		// --------------
-		//  nvenc_export WAVoutput  ---> *.wav file 
-		//  ShellExecute:  neroAacEnc.exe *.wav inputfile ----> *.m4a file
-		//
-		//   Here nvenc_export inserts the '|pipe|' in between wav-output subssystem, and the
-		//   <stdin> of neroAacEnc.exe.  Didn't work.
-
-
-		// Set FileRecord_Audio.filename to the *actual* outputfile path, which is one of the following:
-		//	  (1) for PCM-audio: *.wav
-		//	  (2) for AAC-audio: *.aac
-		nvenc_make_output_filename( 
-			filePath, 
-			wav_postfix_str,          // string to uniquify this filename (if necessary)
-			SDK_FILE_EXTENSION_WAV,
-			mySettings->SDKFileRec.FileRecord_Audio.filename
-		);
-
-		if ( !aac_pipe_mode ) {
-			DeleteFileW( mySettings->SDKFileRec.FileRecord_Audio.filename.c_str() );
-
-			// PCM-audio output:
-			//   Create the *.wav output-file
-			mySettings->SDKFileRec.FileRecord_Audio.hfp = CreateFileW(
-				mySettings->SDKFileRec.FileRecord_Audio.filename.c_str(),
-				GENERIC_WRITE,
-				0, // don't share
-				NULL,
-				CREATE_ALWAYS,
-				FILE_ATTRIBUTE_NORMAL,
-				NULL
-			);
-		} //  if ( !aac_pipe_mode )
+		// transfer the plugin UI settings to mySettings->NvEncodeConfig
+		NVENC_ExportSettings_to_EncodeConfig( exportInfoP->exporterPluginID, mySettings );
 
-		// AAC-audio output:
-		//   In AAC-mode, we don't create the audio output file directly, 
-		//   because neroAacEnc will do that automatically. Instead,
-		//   create a "logfile" for neroAacEnc.
-		if (audioCodec == ADBEAudioCodec_AAC) {
+		BOOL opened;
+		const bool video_tempfile = (muxType != MUX_MODE_M2T && muxType != MUX_MODE_MKV && muxType != MUX_MODE_MP4);
 
-			// Generate the output-filename (*.aac) by combining the 
-			//   source filePath + ".aac"
+		if ( muxType == MUX_MODE_M2T ) {
+			// TS output: create the final *.ts file now, the built-in muxer packetizes
+			// each encoded frame (and the audio which falls due) as it arrives from the encoder.
+			opened = NVENC_open_m2t( filePath, mySettings, audioCodec );
+		}
+		else if ( muxType == MUX_MODE_MKV ) {
+			// MKV output: create the final *.mkv file now, the built-in muxer writes
+			// each encoded frame (and the audio which falls due) as a block into the current cluster.
+			opened = NVENC_open_mkv( filePath, mySettings, audioCodec );
+		}
+		else if ( muxType == MUX_MODE_MP4 ) {
+			// MP4 output: create the final *.mp4 file now, the built-in muxer writes 
+			// each encoded frame into it as it arrives from the encoder.
+			//   (Fragmented-MP4 is video-only, fall back to regular MP4 when audio is exported.)
+			opened = NVENC_open_mp4( filePath, mySettings, mp4_fragmented && !exportInfoP->exportAudio );
+		}
+		else {
+			// Set FileRecord_Video.filename to the *actual* outputfile path:
+			//
+			//   (1) '*.hevc' (if codec==h265)
+			//   (2) '*.M4V'  (else all other choices)
 			nvenc_make_output_filename(
 				filePath,
-				aac_postfix_str,          // string to uniquify this filename (if necessary)
-				SDK_FILE_EXTENSION_M4A, // MPEG-4 audio file (AAC wrapped in an MPEG-4 stream)
-				mySettings->SDKFileRec.FileRecord_Audio.filename // generate the output-filename (*.aac)
+				v_postfix_str,          // string to uniquify this filename (if necessary)
+				(videoCodec == NV_ENC_H265) ? 
+					SDK_FILE_EXTENSION_HEVC :
+					SDK_FILE_EXTENSION_M4V, // H264: use default extension (.m4v)
+				mySettings->SDKFileRec.FileRecord_Video.filename
 			);
 
-			if ( aac_pipe_mode ) {
+			// Delete existing file, just in case it already exists
+			DeleteFileW( mySettings->SDKFileRec.FileRecord_Video.filename.c_str() );
 
-				// Create stdin/stdout pipe.  When we run neroAacEnc.exe, the pipe
-				// will redirect output of nvenc_export's wav-writer into 
-				// the neroAacEnc.exe process.
-				if ( !NVENC_create_neroaac_pipe( mySettings ) )
-					return exportReturn_ErrInUse;// failed to create pipe
+			// Create a new file:  the NVENC-encoder class writes the encoded video to this file,
+			// through the async writer (so the output-thread doesn't wait for the disk.)
+			mySettings->p_FileWriter = new CFileWriter();
+			opened = mySettings->p_FileWriter->Open(
+				mySettings->SDKFileRec.FileRecord_Video.filename.c_str(),
+				nvenc_estimate_video_bytes( mySettings, exportDuration )
+			);
+			if ( !opened ) {
+				delete mySettings->p_FileWriter;
+				mySettings->p_FileWriter = NULL;
+			}
+		}
 
-				nvenc_make_output_filename( 
-					filePath, 
-					postfix_str, // string to uniquify this filename (if necessary)
-					L"log",
-					mySettings->SDKFileRec.FileRecord_AAClog.filename
-				);
+		// if output-file creation failed, then abort the Export!
+		if ( !opened )
+			return exportReturn_ErrInUse;
 
-				// Create the logfile that neroAacEnc.exe will write to 
-				DeleteFileW( mySettings->SDKFileRec.FileRecord_AAClog.filename.c_str() );
-				mySettings->SDKFileRec.FileRecord_AAClog.hfp = CreateFileW(
-					mySettings->SDKFileRec.FileRecord_AAClog.filename.c_str(),
-					GENERIC_WRITE,
-					0, // don't share
-					NULL,
-					CREATE_ALWAYS,
-					FILE_ATTRIBUTE_NORMAL,
-					NULL
-				);
+		// start the audio-thread (if it can't be started, the audio is rendered after the video)
+		if ( audio_concurrent ) {
+			mySettings->audio_concurrent = true;
+			audio_thread = reinterpret_cast<HANDLE>( _beginthreadex(NULL, 0, audio_thread_proc, &audio_args, 0, NULL) );
+			if ( audio_thread == NULL )
+				audio_concurrent = mySettings->audio_concurrent = false;
+		}
 
-				// Connect the pipe-output to the FileRecord_Audio's file-handle.
-				// When nvenc_export's wav-writer writes to FileRecord_Audio, 
-				// the data will be piped into the neroAacEnc process.
-				mySettings->SDKFileRec.FileRecord_Audio.hfp = mySettings->SDKFileRec.H_pipe_wavout;
+		// Two-pass: the stats of pass 1 go next to the output file (and stay there)
+		mySettings->twopass_pass = 0;
+		mySettings->twopass_stats_fp = NULL;
+		if ( two_pass ) {
+			wstring stats_filename;
+			nvenc_make_output_filename( filePath, L"_twopass", L"stats", stats_filename );
+			mySettings->twopass_stats_fp = _wfopen( stats_filename.c_str(), L"w+" );
+		}
 
-				// Nero-AAC does not write 'raw' AAC (ADTS) files,
-				//   it will wrap the AAC audio-stream in an MPEG-4 container (M4A)
-				bool aac_result = NVENC_spawn_neroaacenc(
-					exID,
-					mySettings,
-					mySettings->SDKFileRec.FileRecord_Audio.filename.c_str() // output filename
-				);
+		// Two-pass spill cache: a scratch file next to the output file
+		//   ("D": deleted when it is closed, also if the export is interrupted; "S": sequential access)
+		mySettings->p_SpillCache = NULL;
+		mySettings->spill_fp = NULL;
+		if ( mySettings->twopass_stats_fp && spill_gb ) {
+			wstring spill_filename;
+			nvenc_make_output_filename( filePath, L"_spill", L"tmp", spill_filename );
+			mySettings->spill_fp = _wfopen( spill_filename.c_str(), L"w+bDS" );
+			if ( mySettings->spill_fp ) {
+				mySettings->p_SpillCache = new CSpillCache();
+				mySettings->spill_budget = static_cast<unsigned long long>(spill_gb) << 30;
+				mySettings->spill_compress = spill_compress;
+			}
+		}
 
-				// If AAC-file doesn't exist, then something went severely wrong
-				if ( !aac_result )
-					return exportReturn_InternalError;
-			} //  if ( aac_pipe_mode )
-		} // AAC
+		// ABR ladder: the lower renditions are written next to the output file
+		NVENC_open_ladder( filePath, mySettings, ladder_rungs );
 
-		// sanity-check: if audiofile-creation failed, then abort the Export!
-		if ( mySettings->SDKFileRec.FileRecord_Audio.hfp == NULL )
-			return exportReturn_ErrInUse;
+		result = RenderAndWriteAllVideo(exportInfoP, progress, videoProgress, &exportDuration);
+		NVENC_close_ladder( mySettings );
+		if ( mySettings->twopass_stats_fp ) {
+			fclose( mySettings->twopass_stats_fp );
+			mySettings->twopass_stats_fp = NULL;
+		}
+		if ( mySettings->p_SpillCache ) {
+			delete mySettings->p_SpillCache;
+			mySettings->p_SpillCache = NULL;
+		}
+		if ( mySettings->spill_fp ) {
+			fclose( mySettings->spill_fp ); // (deletes the scratch file)
+			mySettings->spill_fp = NULL;
+		}
+		if ( video_tempfile && mySettings->p_FileWriter ) {
+			// flush the last buffer; a failed write means the file is incomplete
+			if ( !mySettings->p_FileWriter->Close() && result == malNoError )
+				result = exportReturn_InternalError;
+			delete mySettings->p_FileWriter;
+			mySettings->p_FileWriter = NULL;
+		}
 
-		///////////////////////////////
-		//
-		// Write the audio
-		//
+		// (also after a failed or aborted encode: that's when it's needed)
+		if ( write_telemetry && mySettings->p_NvEncoder )
+			nvenc_write_telemetry( mySettings->p_NvEncoder->GetTelemetry(), filePath );
 
-		// (1) First, create the audio-file's WAV-header, 
-		//    which is written to the first 20-30 bytes of file
-		result = NVENC_WriteSDK_WAVHeader(stdParmsP, exportInfoP, exportDuration);
+		// Wait for the audio-thread.  A failed (or user-aborted) video-encode cancels the audio;
+		// if the audio failed first, it cancelled the video, and its error is the one reported.
+		if ( audio_thread ) {
+			const bool cancelled_by_audio = (mySettings->export_cancel != 0);
+			if ( result != malNoError || mySettings->video_encode_fatalerr )
+				InterlockedExchange( &mySettings->export_cancel, 1 );
 
-		// If header creation failed, then quit now.
-		if ( result != malNoError ) {
-			CloseHandle( mySettings->SDKFileRec.FileRecord_Audio.hfp );
-			return result; // exportAudio encountered an error, abort now
-		}
+			WaitForSingleObject( audio_thread, INFINITE );
+			CloseHandle( audio_thread );
+			mySettings->audio_concurrent = false;
 
-		// (2) Now render the remaining audio
-		result = RenderAndWriteAllAudio(exportInfoP, exportDuration);
+			if ( audio_args.result != malNoError && (result == malNoError || cancelled_by_audio) )
+				result = audio_args.result;
+		}
 
-		//
-		// Write the audio
-		//
-		///////////////////////////////
+		// If the video-encode failed catastrophically (or the concurrent export was cancelled), 
+		// quit out of everything now.
+		if ( mySettings->video_encode_fatalerr || (audio_concurrent && result != malNoError) ) {
+			NVENC_close_m2t( mySettings ); // (TS output) release the muxer
+			NVENC_close_mp4( mySettings ); // (MP4 output) release the muxer
+			NVENC_close_mkv( mySettings ); // (MKV output) release the muxer
+			return result;
+		}
+	} // exportVideo
 
-		CloseHandle( mySettings->SDKFileRec.FileRecord_Audio.hfp );
-	} // exportAudio
+	///////////////////////////////////////////////////////////
+	//
+	// (2) Second step: Render and write out the Audio
+	//
+	// Even if user aborted export during video rendering, we'll just finish the audio to that point since it is really fast
+	// and will make the export complete. How your exporter handles an abort, of course, is up to your implementation
+	//   (TS/MKV output: the audio was already rendered, before the video.
+	//    Concurrent export: the audio was rendered alongside the video.)
+	if (exportInfoP->exportAudio && !audio_first && !audio_concurrent)
+		result = RenderAndWriteAudioFile(stdParmsP, exportInfoP, filePath, audioCodec, exportDuration,
+			postfix_str, wav_postfix_str, aac_postfix_str);
 
 	// Verify the exportAudio operation succeeded.  If it failed, then quit now.
 	if ( result != malNoError )
 		return result; // exportAudio encountered an error, abort now
 
-	//
-	// kludge: AAC-audio requires execution of external third-party app: neroAacenc.exe
-	//
-	if (exportInfoP->exportAudio && (audioCodec == ADBEAudioCodec_AAC) && aac_pipe_mode) {
-		// in pipe-mode, NeroAacEnc has already been spawned.  Just need to wait for completion.
-		bool aac_result = NVENC_wait_neroaacenc(
-			mySettings,
-			mySettings->SDKFileRec.FileRecord_Audio.filename.c_str() // output filename
-		);
-	}
-
-	if (exportInfoP->exportAudio && (audioCodec == ADBEAudioCodec_AAC) && !aac_pipe_mode) {
-		// Generate the input-filename (*.wav) by combining the 
-		//   source filePath + ".wav"
-		wstring wav_infilename;
-		nvenc_make_output_filename(
-			filePath,
-			wav_postfix_str,      // string to uniquify this filename (if necessary)
-			SDK_FILE_EXTENSION_WAV, // MPEG-4 audio file (AAC wrapped in an MPEG-4 stream)
-			wav_infilename			// generate the output-filename (*.aac)
-		);
-
-		// Generate the output-filename (*.aac) by combining the 
-		//   source filePath + ".aac"
-		nvenc_make_output_filename(
-			filePath,
-			aac_postfix_str,      // string to uniquify this filename (if necessary)
-			SDK_FILE_EXTENSION_M4A, // MPEG-4 audio file (AAC wrapped in an MPEG-4 stream)
-			mySettings->SDKFileRec.FileRecord_Audio.filename // generate the output-filename (*.aac)
-		);
-
-		// Nero-AAC does not write 'raw' AAC (ADTS) files,
-		//   it will wrap the AAC audio-stream in an MPEG-4 container (M4A)
-		bool aac_result = NVENC_run_neroaacenc(
-			exID,
-			mySettings,
-			wav_infilename.c_str(), // input filename
-			mySettings->SDKFileRec.FileRecord_Audio.filename.c_str() // output filename
-		);
-
-		// If AAC-file doesn't exist, then something went severely wrong
-		if ( !aac_result )
-			return exportReturn_InternalError;
-		
-		// Once we are done with the WAV input file,
-		// delete it
-		DeleteFileW( wav_infilename.c_str() );
-	} // ADBEAudioCodec_AAC
-
 	//
 	// (2) Done with Second step: Render and write out the Audio
 	//
@@ -1292,34 +1592,33 @@ prMALError exSDKExport( // used by selector exSelExport
 	BOOL mux_result = true; // assume muxing succeeded
 	switch( muxType ) {
 		case MUX_MODE_M2T:
-			paramSuite->GetParamValue(exID, mgroupIndex, ParamID_BasicMux_TSMUXER_Path, &exParamValues_muxPath);
-			mux_result = NVENC_mux_m2t(
-				exID, // exporterID (used to generate unique tempfilename)
-				exParamValues_muxPath.paramString, // path to TSMUXER.exe
-				filePath,	// output filepath (*.ts)
-				mySettings,
-				audioCodec	// (if audio is present) audioFormat: *.AAC or *.WAV 
-			);
+			// audio-only export: the TS-file wasn't created during video-export
+			if ( mySettings->p_TsWriter == NULL )
+				mux_result = NVENC_open_m2t( filePath, mySettings, audioCodec );
+
+			if ( mux_result )
+				mux_result = NVENC_mux_m2t( mySettings );
 			break;
 
 		case MUX_MODE_MP4:
-			paramSuite->GetParamValue(exID, mgroupIndex, ParamID_BasicMux_MP4BOX_Path, &exParamValues_muxPath);
-			mux_result = NVENC_mux_mp4(
-				exID, // exporterID (used to generate unique tempfilename)
-				exParamValues_muxPath.paramString, // path to MP4BOX.exe
-				filePath,	// output filepath (*.mp4)
-				mySettings
-			);
+			// audio-only export: the MP4-file wasn't created during video-export
+			if ( mySettings->p_Mp4Writer == NULL )
+				mux_result = NVENC_open_mp4( filePath, mySettings, false );
+
+			if ( mux_result )
+				mux_result = NVENC_mux_mp4(
+					mySettings,
+					audioCodec	// (if audio is present) audioFormat: *.M4A or *.WAV
+				);
 			break;
 
 		case MUX_MODE_MKV:
-			paramSuite->GetParamValue(exID, mgroupIndex, ParamID_BasicMux_MKVMERGE_Path, &exParamValues_muxPath);
-			mux_result = NVENC_mux_mkv(
-				exID, // exporterID (used to generate unique tempfilename)
-				exParamValues_muxPath.paramString, // path to MP4BOX.exe
-				filePath,	// output filepath (*.mp4)
-				mySettings
-				);
+			// audio-only export: the MKV-file wasn't created during video-export
+			if ( mySettings->p_MkvWriter == NULL )
+				mux_result = NVENC_open_mkv( filePath, mySettings, audioCodec );
+
+			if ( mux_result )
+				mux_result = NVENC_mux_mkv( mySettings );
 			break;
 	}
 
@@ -1333,11 +1632,9 @@ prMALError exSDKExport( // used by selector exSelExport
 		HandleOptionalExportSetting(stdParmsP, exportInfoP, mySettings, &result);
 	}
 
-	// Once we are done with muxing the raw audio/video input bitstreams,
-	//    delete them
+	// Once we are done with muxing the raw audio input bitstream,
+	//    delete it  (the built-in muxers take the video directly from the encoder, no video tempfile)
 	if ( muxType != MUX_MODE_NONE ) {
-		if (mySettings->SDKFileRec.hasVideo )
-			DeleteFileW( mySettings->SDKFileRec.FileRecord_Video.filename.c_str() );
 		if (mySettings->SDKFileRec.hasAudio )
 			DeleteFileW( mySettings->SDKFileRec.FileRecord_Audio.filename.c_str() );
 	}
@@ -154,7 +154,11 @@ update_exportParamSuite_GPUSelectGroup_GPUIndex(
 		GUID_ENTRY(NO_GUID, PrPixelFormat_BGRX_4444_8u), // fallback, if YUV-output isn't supported
 		GUID_ENTRY(NO_GUID, PrPixelFormat_BGRA_4444_8u),
 		GUID_ENTRY(NO_GUID, PrPixelFormat_BGRX_4444_32f),
-		GUID_ENTRY(NO_GUID, PrPixelFormat_BGRA_4444_32f)
+		GUID_ENTRY(NO_GUID, PrPixelFormat_BGRA_4444_32f),
+		GUID_ENTRY(NO_GUID, PrPixelFormat_V210_422_10u_709), // v210 packed-pixel (4:2:2 10bpc)
+		GUID_ENTRY(NO_GUID, PrPixelFormat_V210_422_10u_601), //   (appended: presets store the index)
+		GUID_ENTRY(NO_GUID, PrPixelFormat_BGRX_4444_16u),    // 16bpc RGB
+		GUID_ENTRY(NO_GUID, PrPixelFormat_BGRA_4444_16u)
 	};
 
 	const cls_convert_guid desc_PrPixelFormat = cls_convert_guid(
@@ -197,6 +201,20 @@ PrPixelFormat_is_YUV422( const PrPixelFormat p )
 	return false;
 }
 
+bool
+PrPixelFormat_is_V210( const PrPixelFormat p )
+{
+	// returns: true if 'p' is a v210 packed-pixel format (4:2:2 10bpc, 6 pixels per 128 bits)
+	switch( p ) {
+		case PrPixelFormat_V210_422_10u_709:
+		case PrPixelFormat_V210_422_10u_601:
+			return true;
+			break;
+	}
+
+	return false;
+}
+
 bool
 PrPixelFormat_is_YUV444( const PrPixelFormat p )
 {
@@ -213,6 +231,34 @@ PrPixelFormat_is_YUV444( const PrPixelFormat p )
 	return false;
 }
 
+bool
+PrPixelFormat_is_RGB8u(const PrPixelFormat p)
+{
+	// returns: true if 'p' is a BGRA 32bpp (8 bits per channel) format
+	switch (p) {
+	case PrPixelFormat_BGRA_4444_8u:
+	case PrPixelFormat_BGRX_4444_8u:
+		return true;
+		break;
+	}
+
+	return false;
+}
+
+bool
+PrPixelFormat_is_RGB16u(const PrPixelFormat p)
+{
+	// returns: true if 'p' is a BGRA 64bpp (16 bits per channel, 0-32768) format
+	switch (p) {
+	case PrPixelFormat_BGRA_4444_16u:
+	case PrPixelFormat_BGRX_4444_16u:
+		return true;
+		break;
+	}
+
+	return false;
+}
+
 bool
 PrPixelFormat_is_RGB32f(const PrPixelFormat p)
 {
@@ -323,107 +369,6 @@ NVENC_GetEncoderCaps(const NvEncodeCompressionStd codec, const nv_enc_caps_s &ca
 	s = os.str();
 }
 
-uint32_t NVENC_Calculate_H264_MaxKBitRate( 
-	const NV_ENC_LEVEL level, 
-	const enum_NV_ENC_H264_PROFILE profile
-)
-{
-	if ( level == NV_ENC_LEVEL_AUTOSELECT )
-		return 0; // unconstrained
-
-	// workaround -
-	// -----------
-	// NVENC SDK 2.0 Beta, Geforce 314.14 driver
-	//    For some reason, the NVENC's high-profile bitrate-constraints appear 
-	//    to follow the values for baseline/main profile.
-	// Note, this is still true as of NVENC SDK 3 (Geforce 334.89 WHQL driver)
-	//
-	// Updated for NVENC SDK 5.0 (Dec 2014)
-
-
-	if ( (profile >= NV_ENC_H264_PROFILE_BASELINE) &&
-	    (profile < NV_ENC_H264_PROFILE_HIGH) ) 
-		switch( level ) {
-			case NV_ENC_LEVEL_H264_1  : return 64;
-			case NV_ENC_LEVEL_H264_1b : return 128;
-			case NV_ENC_LEVEL_H264_11 : return 192;
-			case NV_ENC_LEVEL_H264_12 : return 384;
-			case NV_ENC_LEVEL_H264_13 : return 768;
-			case NV_ENC_LEVEL_H264_2  : return 2000;
-			case NV_ENC_LEVEL_H264_21 : return 4000;
-			case NV_ENC_LEVEL_H264_22 : return 4000;
-			case NV_ENC_LEVEL_H264_3  : return 10000;
-			case NV_ENC_LEVEL_H264_31 : return 14000;
-			case NV_ENC_LEVEL_H264_32 : return 20000;
-			case NV_ENC_LEVEL_H264_4  : return 20000;
-			case NV_ENC_LEVEL_H264_41 : return 50000;
-			case NV_ENC_LEVEL_H264_42 : return 50000;
-			case NV_ENC_LEVEL_H264_5  : return 135000;
-			case NV_ENC_LEVEL_H264_51 : return 240000;
-			case NV_ENC_LEVEL_H264_52 : return 240000;
-		    default                   : return 0; // unconstrained
-		}
-
-	if ( (profile >= NV_ENC_H264_PROFILE_HIGH) &&
-         (profile <= NV_ENC_H264_PROFILE_CONSTRAINED_HIGH) ) 
-		switch( level ) {
-			case NV_ENC_LEVEL_H264_1  : return 64;
-			case NV_ENC_LEVEL_H264_1b : return 128;
-			case NV_ENC_LEVEL_H264_11 : return 192;
-			case NV_ENC_LEVEL_H264_12 : return 384;
-			case NV_ENC_LEVEL_H264_13 : return 768;  // should be 960
-			case NV_ENC_LEVEL_H264_2  : return 2000; // should be 2500
-			case NV_ENC_LEVEL_H264_21 : return 4000; // should be 5000
-			case NV_ENC_LEVEL_H264_22 : return 4000; // should be 5000
-			case NV_ENC_LEVEL_H264_3  : return 10000;// should be 12500
-			case NV_ENC_LEVEL_H264_31 : return 14000;// should be 17500
-			case NV_ENC_LEVEL_H264_32 : return 20000;// should be 25000
-			case NV_ENC_LEVEL_H264_4  : return 24000;// should be 25000
-			case NV_ENC_LEVEL_H264_41 : return 60000;// should be 62500
-			case NV_ENC_LEVEL_H264_42 : return 60000;// should be 62500
-			case NV_ENC_LEVEL_H264_5  : return 160000;// should be 168750
-			case NV_ENC_LEVEL_H264_51 : return 280000;// should be 300000
-			case NV_ENC_LEVEL_H264_52 : return 280000;// should be 300000
-			default                   : return 0; // unconstrained
-		}
-
-	return 0; // unconstrained
-}
-
-uint32_t NVENC_Calculate_HEVC_MaxKBitRate(
-	const NV_ENC_LEVEL level,
-	const NV_ENC_LEVEL tier
-	)
-{
-	const bool main_tier = (tier == NV_ENC_TIER_HEVC_MAIN);
-
-	switch (level) {
-		case NV_ENC_LEVEL_HEVC_1:  return 128;
-		case NV_ENC_LEVEL_HEVC_2:  return 1500;
-		case NV_ENC_LEVEL_HEVC_21: return 3000;
-		case NV_ENC_LEVEL_HEVC_3:  return 6000;
-		case NV_ENC_LEVEL_HEVC_31: return 10000;
-		case NV_ENC_LEVEL_HEVC_4:  return main_tier ? 
-			                              12000  :  30000;
-		case NV_ENC_LEVEL_HEVC_41: return main_tier ?
-			                              20000  :  50000;
-		case NV_ENC_LEVEL_HEVC_5:  return main_tier ?
-			                              25000  : 100000;
-		case NV_ENC_LEVEL_HEVC_51: return main_tier ?
-			                              40000  : 160000;
-		case NV_ENC_LEVEL_HEVC_52: return main_tier ?
-			                              60000  : 240000;
-		case NV_ENC_LEVEL_HEVC_6:  return main_tier ?
-			                              60000  : 240000;
-		case NV_ENC_LEVEL_HEVC_61: return main_tier ?
-			                              120000 : 480000;
-		case NV_ENC_LEVEL_HEVC_62: return main_tier ?
-			                              240000 : 800000;
-	} // switch (level)
-	
-	return 0; // default : unconstrained
-}
-
 NV_ENC_LEVEL
 NVENC_Convert_HEVC_NV_ENC_CAPS_LEVEL(const uint32_t hevc_nv_enc_caps_level)
 {
@@ -1050,6 +995,9 @@ prMALError exSDKGenerateDefaultParams(
 //    unsigned int              separate_color_plane;// encode pictures as 3 independent color planes?
 	Add_NVENC_Param_bool( GroupID_NVENCCfg, ParamID_separateColourPlaneFlag, false)
 
+//    unsigned int              pixelBitDepthMinus8;// 0=8bit, 2=10bit (H.265 only)
+	Add_NVENC_Param_bool( GroupID_NVENCCfg, ParamID_encode10bit, false)
+
 //    unsigned int              output_sei_BufferPeriod;
 //    NV_ENC_MV_PRECISION       mvPrecision; // 1=FULL_PEL, 2=HALF_PEL, 3= QUARTER_PEL
 	Add_NVENC_Param_int( GroupID_NVENCCfg, ParamID_NV_ENC_MV_PRECISION, 0, MAX_POSITIVE, NV_ENC_MV_PRECISION_QUARTER_PEL)
@@ -1100,8 +1048,10 @@ prMALError exSDKGenerateDefaultParams(
 	const prBool disable_ssse3 = get_cpuinfo_has_ssse3() ? kPrFalse : kPrTrue;
 	const prBool disable_avx   = get_cpuinfo_has_avx()   ? kPrFalse : kPrTrue;
 	const prBool disable_avx2  = get_cpuinfo_has_avx2()  ? kPrFalse : kPrTrue;
+	const prBool disable_avx512= get_cpuinfo_has_avx512()? kPrFalse : kPrTrue;
 	const prBool dflt_avx      = get_cpuinfo_has_avx()   ? kPrTrue  : kPrFalse;
 	const prBool dflt_avx2     = get_cpuinfo_has_avx2()  ? kPrTrue  : kPrFalse;
+	const prBool dflt_avx512   = get_cpuinfo_has_avx512()? kPrTrue  : kPrFalse;
 
 	Add_NVENC_Param_int(ADBEVideoCodecGroup, ParamID_VideoCodec_CPU_Report_CAP, 0, MAX_POSITIVE, 0)
 
@@ -1111,6 +1061,31 @@ prMALError exSDKGenerateDefaultParams(
 	Add_NVENC_Param_bool_dh(ADBEVideoCodecGroup, ParamID_VideoCodec_CPU_EnableAVX2,
 		dflt_avx2, disable_avx2, false
 	)
+	Add_NVENC_Param_bool_dh(ADBEVideoCodecGroup, ParamID_VideoCodec_CPU_EnableAVX512,
+		dflt_avx512, disable_avx512, false
+	)
+
+	// #threads for the RGB->YUV conversion (0 = one per CPU core)
+	Add_NVENC_Param_int(ADBEVideoCodecGroup, ParamID_VideoCodec_CPU_Threads, 0, REPACKYUV_MAX_THREADS, 0)
+
+	// write the encoder's per-frame telemetry next to the output file
+	Add_NVENC_Param_bool_dh(ADBEVideoCodecGroup, ParamID_VideoCodec_Telemetry, false, kPrFalse, kPrFalse)
+
+	// analyze the frames on the CPU, to force IDRs on scene-cuts (0 = off)
+	Add_NVENC_Param_int(ADBEVideoCodecGroup, ParamID_VideoCodec_CPU_Lookahead, 0, LOOKAHEAD_MAX_DEPTH, 0)
+
+	// analyze the whole sequence first, then share the bitrate out over it
+	Add_NVENC_Param_bool_dh(ADBEVideoCodecGroup, ParamID_VideoCodec_TwoPass, false, kPrFalse, kPrFalse)
+
+	// encode lower-resolution renditions of the same render alongside the export (1 = off)
+	Add_NVENC_Param_int(ADBEVideoCodecGroup, ParamID_VideoCodec_ABR_Ladder, 1, ABR_LADDER_MAX_RUNGS, 1)
+
+	// PULL-mode: #frames Adobe renders ahead of the encoder (1 = render, then encode)
+	Add_NVENC_Param_int(ADBEVideoCodecGroup, ParamID_VideoCodec_RenderAhead, 1, ASYNCRENDER_MAX_WINDOW, ASYNCRENDER_DEFAULT_WINDOW)
+
+	// two-pass: disk budget (GB) for pass 1's converted frames, so pass 2 doesn't render again (0 = off)
+	Add_NVENC_Param_int(ADBEVideoCodecGroup, ParamID_VideoCodec_SpillCache, 0, 1024, 0)
+	Add_NVENC_Param_bool(ADBEVideoCodecGroup, ParamID_VideoCodec_SpillCompress, true)
 
 	// Button: 'codec info' 
 	Add_NVENC_Param_button( ADBEVideoCodecGroup, ADBEVideoCodecPrefsButton, exParamFlag_none );
@@ -1196,6 +1171,9 @@ prMALError exSDKGenerateDefaultParams(
 //	Add_NVENC_Param_string_dh(GroupID_AudioFormat, ParamID_AudioFormat_NEROAAC_Path, Default_AudioFormat_NEROAAC_Path, exParamFlag_filePath, kPrTrue, kPrTrue );
 	Add_NVENC_Param_button_dh(GroupID_AudioFormat, ParamID_AudioFormat_NEROAAC_Button, exParamFlag_none, kPrFalse, kPrTrue);
 
+	// render the audio on its own thread, while the video encodes
+	Add_NVENC_Param_bool_dh(GroupID_AudioFormat, ParamID_AudioFormat_Concurrent, false, kPrFalse, kPrFalse);
+
 	////////////////
 	// GroupID_BasicAudio -
 	// 
@@ -1204,14 +1182,6 @@ prMALError exSDKGenerateDefaultParams(
 	Add_NVENC_Param_float( ADBEBasicAudioGroup, ADBEAudioRatePerSecond, 0, 999999, seqSampleRate.mFloat64)
 
 	// Channel type
-
-	// kludge - TODO we don't support 16-channel audio,
-	//          so switch 16-channel to 5.1 audio
-	if ( seqChannelType.mInt32 >= kPrAudioChannelType_16Channel )
-		seqChannelType.mInt32 = kPrAudioChannelType_51;
-	// kludge2 - if we don't support SSSE3, then disable kPrAudioChannelType_51
-	if ( seqChannelType.mInt32 == kPrAudioChannelType_51 && !get_cpuinfo_has_ssse3() )
-		seqChannelType.mInt32 = kPrAudioChannelType_Stereo;
 	Add_NVENC_Param_int( ADBEBasicAudioGroup, ADBEAudioNumChannels, 0, MAX_POSITIVE, seqChannelType.mInt32)
 
 	// for AAC-audio
@@ -1236,24 +1206,14 @@ prMALError exSDKGenerateDefaultParams(
 	Add_NVENC_Param_int( GroupID_NVENCMultiplexer, ADBEVMCMux_Type, 0, MAX_POSITIVE, MUX_MODE_NONE)
 
 	//////////
-	// TSMUXER-path (string parameter)
-	
-	// Hide tsmuxer and mp4box by default because default mux_type == MUX_MODE_NONE
-	Add_NVENC_Param_string_dh(GroupID_NVENCMultiplexer, ParamID_BasicMux_TSMUXER_Path, Default_BasicMux_TSMUXER_Path, exParamFlag_none, kPrTrue, kPrTrue );
-
-	// <Button> TSMUXER path selection
-	// This is a workaround because exParamFlag_filePath doesn't seem to work in (CS6)
-	Add_NVENC_Param_button_dh(GroupID_NVENCMultiplexer, ParamID_BasicMux_TSMUXER_Button, exParamFlag_none, kPrFalse, kPrTrue);
+	// TS is muxed in-process (CTsWriter), it has no options
 
 	//////////
-	// MP4BOX-path (string parameter)
-	Add_NVENC_Param_string_dh(GroupID_NVENCMultiplexer, ParamID_BasicMux_MP4BOX_Path, Default_BasicMux_MP4BOX_Path, exParamFlag_none, kPrTrue, kPrTrue );
-	Add_NVENC_Param_button_dh(GroupID_NVENCMultiplexer, ParamID_BasicMux_MP4BOX_Button, exParamFlag_none, kPrFalse, kPrTrue);
+	// MP4 is muxed in-process (CMp4Writer); the only option is fragmented-MP4 output
+	Add_NVENC_Param_bool_dh(GroupID_NVENCMultiplexer, ParamID_BasicMux_MP4_Fragmented, false, kPrFalse, kPrTrue);
 
 	//////////
-	// MKVMERGE-path (string parameter)
-	Add_NVENC_Param_string_dh(GroupID_NVENCMultiplexer, ParamID_BasicMux_MKVMERGE_Path, Default_BasicMux_MKVMERGE_Path, exParamFlag_none, kPrTrue, kPrTrue);
-	Add_NVENC_Param_button_dh(GroupID_NVENCMultiplexer, ParamID_BasicMux_MKVMERGE_Button, exParamFlag_none, kPrFalse, kPrTrue);
+	// MKV is muxed in-process (CMkvWriter), it has no options
 
 	// [TODO - ZL] Add more params: 8-bit vs 32-bit processing
 
@@ -1753,6 +1713,7 @@ update_exportParamSuite_NVENCCfgGroup(
 		_ClearAndDisableParam( ParamID_sliceModeData );
 		_ClearAndDisableParam( ParamID_vle_entropy_mode );
 		_ClearAndDisableParam( ParamID_separateColourPlaneFlag );
+		_ClearAndDisableParam( ParamID_encode10bit );
 		_ClearAndDisableParam( ParamID_NV_ENC_MV_PRECISION );
 		_ClearAndDisableParam( ParamID_disableDeblock );
 		_ClearAndDisableParam( ParamID_NV_ENC_H264_ADAPTIVE_TRANSFORM );
@@ -2019,6 +1980,15 @@ update_exportParamSuite_NVENCCfgGroup(
 		disable_scp ? kPrTrue : kPrFalse,  kPrFalse
 	);
 
+	// 10-bit encoding is only supported by H.265 (Main10/FREXT), and the
+	//   caps-bit is only reported by the NVENC 7.0 API (always 0 for older SDKs)
+	const bool disable_10bit = (!codec_is_hevc) ||
+		!nv_enc_caps.value_NV_ENC_CAPS_SUPPORT_10BIT_ENCODE;
+
+	_UpdateIntParam( ParamID_encode10bit, 0, disable_10bit ? 0 : 1, 
+		disable_10bit ? kPrTrue : kPrFalse,  kPrFalse
+	);
+
 	////////////////////////////
 
 
@@ -2670,13 +2640,16 @@ update_exportParamSuite_VideoGroup(
 		desc_PrPixelFormat.index2value(i, pp);
 		const PrPixelFormat pf = static_cast<PrPixelFormat>(pp);
 
-		// If user has chosen YUV444, then only allow pixelFormats YUV444 and RGB32f
-		if ( user_444 && !PrPixelFormat_is_YUV444(pf) && !PrPixelFormat_is_RGB32f(pf) )
+		const bool is_rgb = PrPixelFormat_is_RGB32f(pf) || PrPixelFormat_is_RGB8u(pf) || PrPixelFormat_is_RGB16u(pf);
+
+		// If user has chosen YUV444, then only allow pixelFormats YUV444 and RGB (32f, 8u, 16u)
+		if ( user_444 && !PrPixelFormat_is_YUV444(pf) && !is_rgb )
 			continue;
 
-		// If user has chosen YUV420, then only allow YUV420, YUV422, and RGB32f
-		if ( user_420 && !PrPixelFormat_is_RGB32f(pf) &&
-			!(PrPixelFormat_is_YUV420(pf) || PrPixelFormat_is_YUV422(pf)) )
+		// If user has chosen YUV420, then only allow YUV420, YUV422 (8-bit and v210), YUV444 (downsampled), and RGB
+		if ( user_420 && !is_rgb &&
+			!(PrPixelFormat_is_YUV420(pf) || PrPixelFormat_is_YUV422(pf) || PrPixelFormat_is_V210(pf) ||
+			PrPixelFormat_is_YUV444(pf)) )
 			continue;
 		_AddConstrainedIntValuePair(ParamID_forced_PrPixelFormat)
 	}
@@ -2702,32 +2675,17 @@ update_exportParamSuite_NVENCMultiplexerGroup(
 	paramSuite->GetParamValue(exID, mgroupIndex, ADBEVMCMux_Type, &exParamValue_muxType);
 
 
-	// TSMUXER MuxPath & button parameters:
-	// ------------------------------------
-	//  Dynamically hide/unhide (they are only visible when muxtype selection == TS)
-	prBool hidden = (exParamValue_muxType.value.intValue == MUX_MODE_M2T) ?
-		kPrFalse : kPrTrue;
-
-	_UpdateParam_dh(ParamID_BasicMux_TSMUXER_Path, kPrTrue, hidden );
-	_UpdateParam_dh(ParamID_BasicMux_TSMUXER_Button, kPrFalse, hidden );
+	// (TS is muxed by the built-in muxer, it has no parameters)
 
-	// MP4BOX MuxPath & button parameters:
+	// MP4 fragmented-output checkbox:
 	// ------------------------------------
-	//  Dynamically hide/unhide (they are only visible when muxtype selection == TS)
-	hidden = (exParamValue_muxType.value.intValue == MUX_MODE_MP4) ?
+	//  Dynamically hide/unhide (only visible when muxtype selection == MP4)
+	prBool hidden = (exParamValue_muxType.value.intValue == MUX_MODE_MP4) ?
 		kPrFalse : kPrTrue;
 
-	_UpdateParam_dh(ParamID_BasicMux_MP4BOX_Path, kPrTrue, hidden );
-	_UpdateParam_dh(ParamID_BasicMux_MP4BOX_Button, kPrFalse, hidden );
+	_UpdateParam_dh(ParamID_BasicMux_MP4_Fragmented, kPrFalse, hidden );
 
-	// MKVMERGE MuxPath & button parameters:
-	// ------------------------------------
-	//  Dynamically hide/unhide (they are only visible when muxtype selection == TS)
-	hidden = (exParamValue_muxType.value.intValue == MUX_MODE_MKV) ?
-	kPrFalse : kPrTrue;
-
-	_UpdateParam_dh(ParamID_BasicMux_MKVMERGE_Path, kPrTrue, hidden);
-	_UpdateParam_dh(ParamID_BasicMux_MKVMERGE_Button, kPrFalse, hidden);
+	// (MKV is muxed by the built-in muxer, it has no parameters)
 }
 
 void
@@ -2744,22 +2702,10 @@ update_exportParamSuite_AudioFormatGroup(
 	if ( paramSuite == NULL ) // TODO trap error
 		return;
 
-	paramSuite->GetParamValue(exID, mgroupIndex, ADBEVMCMux_Type, &exParamValue_temp);
-	bool is_mp4 = (exParamValue_temp.value.intValue == MUX_MODE_MP4);
-
 	// AudioCodec setting - 
-	// (1) if (Multiplexer-type == MP4), then force the value to 'AAC' ,
-	//     (MP4BOX doesn't support muxing WAV files into *.MP4)
-	// (2)  ... and disable the control (so user can't change it.)
-
-	if ( is_mp4 ) {
-		// disable the parameter and change-value to AAC
-		_UpdateIntParam( ADBEAudioCodec, ADBEAudioCodec_AAC, ADBEAudioCodec_AAC, kPrTrue, kPrFalse );
-	}
-	else {
-		// re-enable the parameter
-		_UpdateParam_dh( ADBEAudioCodec, kPrFalse, kPrFalse );
-	}
+	//   All multiplexer-types accept both PCM and AAC audio.  (The native MP4-muxer
+	//   stores PCM as 'sowt'/'lpcm'), so the control is always enabled.
+	_UpdateParam_dh( ADBEAudioCodec, kPrFalse, kPrFalse );
 
 	paramSuite->GetParamValue(exID, mgroupIndex, ADBEAudioCodec, &exParamValue_temp);
 	audioCodec = exParamValue_temp.value.intValue;
@@ -2838,6 +2784,7 @@ update_exportParamSuite_VideoCodecGroup( // Host CPU capabilities, Codecinfo but
 	const prBool disable_ssse3 = get_cpuinfo_has_ssse3() ? kPrFalse : kPrTrue;
 	const prBool disable_avx = get_cpuinfo_has_avx() ? kPrFalse : kPrTrue;
 	const prBool disable_avx2 = get_cpuinfo_has_avx2() ? kPrFalse : kPrTrue;
+	const prBool disable_avx512 = get_cpuinfo_has_avx512() ? kPrFalse : kPrTrue;
 
 	lRec->exportParamSuite->ClearConstrainedValues(exID,
 		0,
@@ -2851,6 +2798,8 @@ update_exportParamSuite_VideoCodecGroup( // Host CPU capabilities, Codecinfo but
 			oss << "AVX ";
 		if (get_cpuinfo_has_avx2())
 			oss << "AVX2 ";
+		if (get_cpuinfo_has_avx512())
+			oss << "AVX512 ";
 	}
 	else {
 		oss << "SSSE3 is not supprted! (NVENC not supported)";
@@ -2867,6 +2816,7 @@ update_exportParamSuite_VideoCodecGroup( // Host CPU capabilities, Codecinfo but
 
 	_UpdateParam_dh(ParamID_VideoCodec_CPU_EnableAVX, disable_avx, kPrFalse);
 	_UpdateParam_dh(ParamID_VideoCodec_CPU_EnableAVX2, disable_avx2, kPrFalse);
+	_UpdateParam_dh(ParamID_VideoCodec_CPU_EnableAVX512, disable_avx512, kPrFalse);
 }
 /*
 void
@@ -2958,10 +2908,10 @@ const wchar_t * const ADBEVMCMux_TypeStrings[] = {
 	L"MPEG-2",	// (2) not supported by NVENC
 	L"SVCD",	// (3) not supported by NVENC
 	L"DVD",		// (4) not supported by NVENC
-	L"TS",		// (5) Transport stream (requires external application TSMuxer)
+	L"TS",		// (5) Transport stream (built-in muxer)
 	L"None",	// (6) None      (separate audio + video output files)
-	L"MP4",		// (7) MP4 system (requires external application MP4BOX)
-	L"MKV"		// (8) MKV/Matroska (requires external application MKVMERGE)
+	L"MP4",		// (7) MP4 system (built-in muxer)
+	L"MKV"		// (8) MKV/Matroska (built-in muxer)
 };
 
 // Need to give parameters, parameter groups, and constrained values their names here
@@ -3196,6 +3146,12 @@ other format works.\
 " );
 	NVENC_SetParamName(lRec, exID, ParamID_AudioFormat_NEROAAC_Button, 
 		L"neroAac_Button",	L"Click <Button> to specify path to neroAacEnc.EXE" );
+	NVENC_SetParamName(lRec, exID, ParamID_AudioFormat_Concurrent, 
+		L"Concurrent audio export", L"Render (and AAC-encode) the audio on a separate thread, while the video encodes.\n\
+\n\
+Applies when Multiplexing is 'none' or 'MP4'.  (TS and MKV always render\n\
+the audio first, because their muxers interleave it with the video.)\n\
+If either the audio or the video fails, the other one is stopped too." );
 
 	////////////
 	//
@@ -3528,6 +3484,11 @@ CABAC=more compression efficiency (usually)\n\
 planes (Y,U,V), instead of a single one\n\
 (Requires PROFILE_HIGH_444 or above)" );
 
+	NVENC_SetParamName(lRec, exID, ParamID_encode10bit, 
+		LParamID_encode10bit, L"Encode 10-bit video (H.265 Main10 or FREXT)\n\
+Video is rendered as RGB 32f, and converted to P010 or YUV444 10-bit\n\
+(Requires H.265 and NV_ENC_CAPS_SUPPORT_10BIT_ENCODE)" );
+
 	NVENC_SetParamName(lRec, exID, ParamID_NV_ENC_MV_PRECISION, 
 		LParamID_NV_ENC_MV_PRECISION, L"Motion vector precision\n\
 full pixel = least complex, least accurate\n\
@@ -3608,39 +3569,37 @@ none = no multiplexing, elementary bitstream only\n\
 	 (if both audio + video export are enabled, nvenc_export will\n\
 	  generate 2 files.)\n\
 \n\
-TS = MPEG-2 transport stream (must specify location of\n\
-	 third-party program 'TSMuxer')\n\
+TS = MPEG-2 transport stream (built-in muxer, no external\n\
+	 program needed.  The video is packetized directly into the\n\
+	 *.TS file while encoding.)\n\
 \n\
-MP4= MPEG-4 system stream (must specify location of\n\
-	 third-party program 'MP4Box')\n\
+MP4= MPEG-4 system stream (built-in muxer, no external\n\
+	 program needed.  The video is written directly into the\n\
+	 *.MP4 file while encoding.)\n\
 \n\
-MKV= Matroska fie (must specify location of\n\
-	 third-party program 'MKVMERGE')\n\
+MKV= Matroska file (built-in muxer, no external\n\
+	 program needed.  The video is written directly into the\n\
+	 *.MKV file while encoding.)\n\
 \n\
-If encoding HEVC, it is recommended to use MKV, as the other two choices\n\
-appear to have problems (dropped frames, poor random-seeking, etc.)\n\
-If encoding H264, all 3 types of muxers should function properly.\
+All 3 types of muxers accept both H264 and HEVC video.\
 " );
 
-	NVENC_SetParamName(lRec, exID, ParamID_BasicMux_TSMUXER_Path, 
-		L"TSMuxer.exe path", L"Location of external program 'TSMuxer.EXE'");
-	NVENC_SetParamName(lRec, exID, ParamID_BasicMux_TSMUXER_Button,
-		L"TSMUXER_Button", L"Click <Button> to specify path to TSmuxer.EXE" );
-	NVENC_SetParamName(lRec, exID, ParamID_BasicMux_MP4BOX_Path, 
-		L"MP4Box.exe path", L"Location of external program 'MP4Box.EXE'");
-	NVENC_SetParamName(lRec, exID, ParamID_BasicMux_MP4BOX_Button,
-		L"MP4BOX_Button", L"Click <Button> to specify path to MP4Box.EXE" );
-	NVENC_SetParamName(lRec, exID, ParamID_BasicMux_MKVMERGE_Path,
-		L"MKVMERGE.exe path", L"Location of external program 'MKVMERGE.EXE'");
-	NVENC_SetParamName(lRec, exID, ParamID_BasicMux_MKVMERGE_Button,
-		L"MKVMERGE_Button", L"Click <Button> to specify path to MKVMERGE.EXE");
+	NVENC_SetParamName(lRec, exID, ParamID_BasicMux_MP4_Fragmented,
+		L"Fragmented MP4", L"Write a fragmented MP4 (moof/mdat fragments, one per GOP)\n\
+\n\
+The beginning of a fragmented file is complete and playable while the\n\
+export is still running, so it can be uploaded/streamed before the export ends.\n\
+\n\
+Fragmented output is video-only: if audio-export is enabled,\n\
+a regular (non-fragmented) MP4 is written instead.");
 
 	NVENC_SetParamName(lRec, exID, ParamID_VideoCodec_CPU_Report_CAP,
 		LParamID_VideoCodec_CPU_Report_CAP, L"Host CPU capabilities\n\
 Only capabilities used by nvenc_export are reported:\n\
 SSSE3 = baseline (required)\n\
 AVX   = reduces CPU-overhead for RGB->YUV conversion\n\
-AVX2  = reduces CPU-overhead for all format conversion\
+AVX2  = reduces CPU-overhead for all format conversion\n\
+AVX512= (BW+VL) further reduces CPU-overhead for all format conversion\
 ");
 
 	NVENC_SetParamName(lRec, exID, ParamID_VideoCodec_CPU_EnableAVX,
@@ -3653,6 +3612,77 @@ AVX2  = reduces CPU-overhead for all format conversion\
 		LParamID_VideoCodec_CPU_EnableAVX2, L"Allow nvenc_export to use AVX2.\n\
 (This option is only enabled if CPU supports AVX2.)\n\
  Requires: Intel Haswell (2013) or later CPU\
+");
+
+	NVENC_SetParamName(lRec, exID, ParamID_VideoCodec_CPU_EnableAVX512,
+		LParamID_VideoCodec_CPU_EnableAVX512, L"Allow nvenc_export to use AVX512.\n\
+(This option is only enabled if CPU supports AVX512 F+BW+VL.)\n\
+ Requires: Intel Skylake-SP (2017) or later CPU\
+");
+
+	NVENC_SetParamName(lRec, exID, ParamID_VideoCodec_CPU_Threads,
+		LParamID_VideoCodec_CPU_Threads, L"#threads used to convert RGB frames to YUV.\n\
+0 = auto (one thread per physical CPU core)\n\
+1 = single-threaded\n\
+Each thread converts a horizontal band of the frame; the output is\n\
+identical for any thread-count.\
+");
+
+	NVENC_SetParamName(lRec, exID, ParamID_VideoCodec_Telemetry,
+		LParamID_VideoCodec_Telemetry, L"After the export, write the encoder's per-frame statistics\n\
+(picture type, size, QP, queue/convert/submit/lock/write times) to\n\
+<output>_telemetry.csv, and a summary with bitrate, GOP-size and\n\
+throughput histograms to <output>_telemetry.json.\n\
+(Keeps the last 65536 frames.  For finding stalls in long exports.)\
+");
+
+	NVENC_SetParamName(lRec, exID, ParamID_VideoCodec_CPU_Lookahead,
+		LParamID_VideoCodec_CPU_Lookahead, L"#frames the CPU analyzes ahead of the encoder (0 = off).\n\
+Detects scene-cuts (ignoring flashes), and starts each new scene\n\
+with an IDR-frame.  The per-frame complexity estimate is written\n\
+to the telemetry.  Each frame of lookahead holds back one more\n\
+input-surface (GPU memory).\
+");
+
+	NVENC_SetParamName(lRec, exID, ParamID_VideoCodec_TwoPass,
+		LParamID_VideoCodec_TwoPass, L"Render the sequence twice.  Pass 1 encodes it at constant QP\n\
+(the video is discarded) and writes each frame's size to\n\
+<output>_twopass.stats.  Pass 2 shares the average bitrate out\n\
+over the sequence: the complex scenes get more bits, the simple\n\
+ones fewer, and the file still comes out at the target size.\n\
+(Requires a bitrate, and an Adobe-app with PUSH-mode rendering.)\
+");
+
+	NVENC_SetParamName(lRec, exID, ParamID_VideoCodec_ABR_Ladder,
+		LParamID_VideoCodec_ABR_Ladder, L"#renditions of an adaptive-bitrate ladder (1 = off).\n\
+Each frame is rendered once, and downscaled to 2/3, 1/2, 1/3,\n\
+1/4 and 1/6 of the output height, each with its own encoder-session\n\
+and a share of the bitrate.  The extra renditions are written next to\n\
+the output as elementary streams: <output>_<height>p.m4v/.hevc\n\
+(Requires YUV 4:2:0 rendering, and one NVENC session per rendition.)\
+");
+
+	NVENC_SetParamName(lRec, exID, ParamID_VideoCodec_RenderAhead,
+		LParamID_VideoCodec_RenderAhead, L"#frames Adobe renders ahead of the encoder, in PULL-mode\n\
+(1 = render a frame, then encode it.)  The frames are rendered\n\
+asynchronously and encoded in order, so the renderer and NVENC\n\
+work at the same time.  Each frame in flight holds one rendered\n\
+frame in memory.  (PUSH-mode: Adobe schedules the render itself.)\
+");
+
+	NVENC_SetParamName(lRec, exID, ParamID_VideoCodec_SpillCache,
+		LParamID_VideoCodec_SpillCache, L"Two-pass: disk space (GB) for a scratch file of the frames\n\
+rendered in pass 1 (0 = off).  Pass 2 reads the frames back,\n\
+instead of rendering the sequence a second time.  The frames\n\
+which don't fit are rendered again.  The scratch file\n\
+(<output>_spill.tmp) is deleted at the end of the export.\n\
+(1080p 4:2:0: ~3 MB per frame uncompressed.  Not with the ABR ladder.)\
+");
+
+	NVENC_SetParamName(lRec, exID, ParamID_VideoCodec_SpillCompress,
+		LParamID_VideoCodec_SpillCompress, L"Compress the frames in the spill cache (fast LZ).\n\
+Saves disk space and I/O on graphics, titles and letterboxed\n\
+video.  Camera footage hardly shrinks (it is stored as is.)\
 ");
 	//
 	// Update the GroupID_NVENCCfg
@@ -3762,13 +3792,6 @@ AVX2  = reduces CPU-overhead for all format conversion\
 													ADBEAudioNumChannels);
 	for (csSDK_int32 i = 0; i < sizeof(channelTypes) / sizeof (csSDK_int32); i++)
 	{
-		// if CPU doesn't support SSSE3, then don't allow 5.1-audio because the
-		// channel-reordering function uses SSSE3 instructinos
-		if ( channelTypes[i] == kPrAudioChannelType_51 && !get_cpuinfo_has_ssse3() ) 
-			continue;// cpu doesn't support SSSE3, so disable NVENC's support for 5.1-audio
-		else if ( channelTypes[i] > kPrAudioChannelType_51 ) 
-			continue;// NVENC plugin doesn't support more than 6-channel surround
-
 		tempChannelType.intValue = channelTypes[i];
 		copyConvertStringLiteralIntoUTF16(channelTypeStrings[i], tempString);
 		lRec->exportParamSuite->AddConstrainedValuePair(	exID,
@@ -3990,9 +4013,6 @@ prMALError exSDKParamButton(
 
 	enum {
 		button_nvenc_info = 0,
-		button_tsmuxer,
-		button_mp4box,
-		button_mkvmerge,
 		button_neroaac,
 		button_codecprefs,
 		button_other
@@ -4007,15 +4027,6 @@ prMALError exSDKParamButton(
 	if ( strcmp(getFilePrefsRecP->buttonParamIdentifier, ParamID_NVENC_Info_Button ) == 0 ) {
 		select_button = button_nvenc_info;
 		pParamID_filepath = NULL;
-	} else if ( strcmp(getFilePrefsRecP->buttonParamIdentifier, ParamID_BasicMux_TSMUXER_Button ) == 0 ) {
-		select_button = button_tsmuxer;
-		pParamID_filepath = ParamID_BasicMux_TSMUXER_Path;
-	} else if ( strcmp(getFilePrefsRecP->buttonParamIdentifier, ParamID_BasicMux_MP4BOX_Button ) == 0 ) {
-		select_button = button_mp4box;
-		pParamID_filepath = ParamID_BasicMux_MP4BOX_Path;
-	} else if (strcmp(getFilePrefsRecP->buttonParamIdentifier, ParamID_BasicMux_MKVMERGE_Button) == 0) {
-		select_button = button_mkvmerge;
-		pParamID_filepath = ParamID_BasicMux_MKVMERGE_Path;
 	} else if ( strcmp(getFilePrefsRecP->buttonParamIdentifier, ParamID_AudioFormat_NEROAAC_Button ) == 0 ) {
 		select_button = button_neroaac;
 		pParamID_filepath = ParamID_AudioFormat_NEROAAC_Path;
@@ -4049,11 +4060,10 @@ prMALError exSDKParamButton(
 								//| MB_RIGHT );
 		return returnValue;
 	} 
-	else if ( select_button == button_tsmuxer || select_button == button_mp4box ||
-		select_button == button_mkvmerge || select_button == button_neroaac )
+	else if ( select_button == button_neroaac )
 	{
 		//
-		// user pressed the 'TSUMXER Path' button
+		// user pressed the 'NEROAAC Path' button
 		//
 		DWORD err = 0;
 		const wchar_t strFilter[] = {
@@ -4080,9 +4090,6 @@ prMALError exSDKParamButton(
 		ofn.lpstrFileTitle = L"lpstrFileTitle";
 		ofn.lpstrInitialDir = NULL;
 		switch( select_button ) {
-			case button_mkvmerge:	ofn.lpstrTitle = L"Specify Path to MKVMERGE.EXE application"; break;
-			case button_mp4box:		ofn.lpstrTitle = L"Specify Path to Mp4Box.EXE application"; break;
-			case button_tsmuxer:	ofn.lpstrTitle = L"Specify Path to TSMuxer.EXE application"; break;
 			case button_neroaac:	ofn.lpstrTitle = L"Specify Path to neroAacEnc.EXE application"; break;
 			default:				ofn.lpstrTitle = L"?!? INTERNAL ERROR (UNKNOWN) ?!?"; break;
 		}
@@ -4428,22 +4435,18 @@ exSDKValidateParamChanged (
 		// change in audio-channels possibly requires change in AAC AudioBitRate range
 		update_exportParamSuite_BasicAudioGroup(exID, lRec);
 	}
-	else if (strcmp(validateParamChangedRecP->changedParamIdentifier, ADBEVMCMux_Type) == 0 ||
-		strcmp(validateParamChangedRecP->changedParamIdentifier, ParamID_BasicMux_TSMUXER_Path) == 0 ||
-		strcmp(validateParamChangedRecP->changedParamIdentifier, ParamID_BasicMux_MKVMERGE_Path) == 0 ||
-		strcmp(validateParamChangedRecP->changedParamIdentifier, ParamID_BasicMux_MP4BOX_Path) == 0)
+	else if (strcmp(validateParamChangedRecP->changedParamIdentifier, ADBEVMCMux_Type) == 0)
 	{
-		// if Multiplexer-type is changed, need to (hide/unhide) the Path Parameter(s)
+		// if Multiplexer-type is changed, need to (hide/unhide) the muxer's Parameter(s)
 		update_exportParamSuite_NVENCMultiplexerGroup(exID, lRec);
 
-		// also, if necessary, force AudioFormat to AAC (because MP4-muxing doesn't support PCM)
-		if (strcmp(validateParamChangedRecP->changedParamIdentifier, ADBEVMCMux_Type) == 0) {
-			update_exportParamSuite_AudioFormatGroup(exID, lRec);
-			update_exportParamSuite_BasicAudioGroup(exID, lRec);
-		}
+		// also, refresh the AudioFormat group
+		update_exportParamSuite_AudioFormatGroup(exID, lRec);
+		update_exportParamSuite_BasicAudioGroup(exID, lRec);
 	}
 	else if (strcmp(validateParamChangedRecP->changedParamIdentifier, ParamID_VideoCodec_CPU_EnableAVX) == 0 ||
-		strcmp(validateParamChangedRecP->changedParamIdentifier, ParamID_VideoCodec_CPU_EnableAVX2) == 0) {
+		strcmp(validateParamChangedRecP->changedParamIdentifier, ParamID_VideoCodec_CPU_EnableAVX2) == 0 ||
+		strcmp(validateParamChangedRecP->changedParamIdentifier, ParamID_VideoCodec_CPU_EnableAVX512) == 0) {
 		update_exportParamSuite_VideoCodecGroup(exID, lRec);
 	}
 
@@ -4525,94 +4528,6 @@ exSDKValidateOutputSettings( // used by selector exSelValidateOutputSettings
 		return exportReturn_ErrLastErrorSet; // nvenc_export cannot run on this CPU
 	}
 	
-	// if Multiplxer is set to *.TS output (mpeg-2 transport stream), then 
-	//    verify TSMUXER.EXE path is valid
-
-	if ( muxType == MUX_MODE_M2T ) {
-		paramSuite->GetParamValue( exID, mgroupIndex, ParamID_BasicMux_TSMUXER_Path, &exParamValue);
-		wchar_t parent_executable[ MAX_PATH ];
-		HINSTANCE h;
-		
-		h = FindExecutableW( exParamValue.paramString, NULL, parent_executable );
-		if ( reinterpret_cast<int>(h) <= 32) {
-			wostringstream oss; // text scratchpad for messagebox and errormsg 
-
-			// ERROR
-			oss << "!!! NVENC_EXPORT error, can not confirm user settings !!!" << endl << endl;
-			oss << "  Reason: TSMuxer.EXE path is invalid: " << exParamValue.paramString << endl << endl;
-			oss << "Solution: Check the <Multiplexer> tab and confirm path (or change MuxType to NONE)" << endl;
-
-			copyConvertStringLiteralIntoUTF16( L"NVENC-export error", title );
-			copyConvertStringLiteralIntoUTF16( oss.str().c_str(), desc );
-			privateData->errorSuite->SetEventStringUnicode( PrSDKErrorSuite::kEventTypeError, title, desc );
-
-			MessageBoxW( GetLastActivePopup(mainWnd),
-								oss.str().c_str(),
-								EXPORTER_NAME_W,
-								MB_OK | MB_ICONERROR );
-
-			return exportReturn_ErrLastErrorSet; // NVENC is supported
-		}
-	}
-
-	// if Multiplexer is set to *.MP4 output (mpeg-4 system stream), then 
-	//    verify MP4BOX.EXE path is valid
-	if ( muxType == MUX_MODE_MP4 ) {
-		paramSuite->GetParamValue( exID, mgroupIndex, ParamID_BasicMux_MP4BOX_Path, &exParamValue);
-		wchar_t parent_executable[ MAX_PATH ];
-		HINSTANCE h;
-		
-		h = FindExecutableW( exParamValue.paramString, NULL, parent_executable );
-		if ( reinterpret_cast<int>(h) <= 32) {
-			wostringstream oss; // text scratchpad for messagebox and errormsg 
-
-			// ERROR
-			oss << "!!! NVENC_EXPORT error, can not confirm user settings !!!" << endl << endl;
-			oss << "  Reason: MP4BOX.EXE path is invalid: " << exParamValue.paramString << endl << endl;
-			oss << "Solution: Check the <Multiplexer> tab and confirm path (or change MuxType to NONE)" << endl;
-
-			copyConvertStringLiteralIntoUTF16( L"NVENC-export error", title );
-			copyConvertStringLiteralIntoUTF16( oss.str().c_str(), desc );
-			privateData->errorSuite->SetEventStringUnicode( PrSDKErrorSuite::kEventTypeError, title, desc );
-
-			MessageBoxW( GetLastActivePopup(mainWnd),
-								oss.str().c_str(),
-								EXPORTER_NAME_W,
-								MB_OK | MB_ICONERROR );
-
-			return exportReturn_ErrLastErrorSet; // NVENC is supported
-		}
-	}
-
-	// if Multiplexer is set to *.MKV output (Matroska file), then 
-	//    verify MKVMERGE.EXE path is valid
-	if (muxType == MUX_MODE_MKV) {
-		paramSuite->GetParamValue(exID, mgroupIndex, ParamID_BasicMux_MKVMERGE_Path, &exParamValue);
-		wchar_t parent_executable[MAX_PATH];
-		HINSTANCE h;
-
-		h = FindExecutableW(exParamValue.paramString, NULL, parent_executable);
-		if (reinterpret_cast<int>(h) <= 32) {
-			wostringstream oss; // text scratchpad for messagebox and errormsg 
-
-			// ERROR
-			oss << "!!! NVENC_EXPORT error, can not confirm user settings !!!" << endl << endl;
-			oss << "  Reason: MKVMERGE.EXE path is invalid: " << exParamValue.paramString << endl << endl;
-			oss << "Solution: Check the <Multiplexer> tab and confirm path (or change MuxType to NONE)" << endl;
-
-			copyConvertStringLiteralIntoUTF16(L"NVENC-export error", title);
-			copyConvertStringLiteralIntoUTF16(oss.str().c_str(), desc);
-			privateData->errorSuite->SetEventStringUnicode(PrSDKErrorSuite::kEventTypeError, title, desc);
-
-			MessageBoxW(GetLastActivePopup(mainWnd),
-				oss.str().c_str(),
-				EXPORTER_NAME_W,
-				MB_OK | MB_ICONERROR);
-
-			return exportReturn_ErrLastErrorSet; // NVENC is supported
-		}
-	}
-
 	// if AudioCodec is set to *.AAC output, then 
 	//    verify NEROAACENC.EXE path is valid
 
@@ -4651,14 +4566,14 @@ exSDKValidateOutputSettings( // used by selector exSelValidateOutputSettings
 	const bool audio_is_441k = (exParamValue.value.floatValue >= 44099) &&
 		(exParamValue.value.floatValue <= 44101);
 
-	// TSMuxer does not support LPCM 44.1KHz audio
+	// Transport-stream LPCM (Blu-ray format) does not support 44.1KHz audio
 	if ((muxType == MUX_MODE_M2T) && (audio_codec == ADBEAudioCodec_PCM) && 
 		audio_is_441k)  {
 		wostringstream oss; // text scratchpad for messagebox and errormsg 
 
 		// ERROR
 		oss << "!!! NVENC_EXPORT error, can not confirm user settings !!!" << endl << endl;
-		oss << "  Reason: TSMUXER does not support 44.1KHz LPCM audio" << endl << endl;
+		oss << "  Reason: TS-multiplexer does not support 44.1KHz LPCM audio" << endl << endl;
 		oss << "Solution: Either change the audiorate to 48KHz, or audiocodec to AAC" << endl;
 
 		copyConvertStringLiteralIntoUTF16(L"NVENC-export error", title);
@@ -4673,6 +4588,37 @@ exSDKValidateOutputSettings( // used by selector exSelValidateOutputSettings
 		return exportReturn_ErrLastErrorSet; // NVENC is supported
 	}
 
+	// 16-channel audio is only exported as LPCM, into a WAV file (no multiplexer) or MKV:
+	//   Transport-stream LPCM (Blu-ray format) carries at most 6 channels (5.1),
+	//   the MP4-muxer's version-0 'sowt' sample-entry is only defined for mono/stereo,
+	//   and neroAacEnc's 16-channel output is untested.
+	paramSuite->GetParamValue(exID, mgroupIndex, ADBEAudioNumChannels, &exParamValue);
+	const bool mux_supports_16ch = (muxType == MUX_MODE_NONE) || (muxType == MUX_MODE_MKV);
+	if ((exParamValue.value.intValue == kPrAudioChannelType_16Channel) &&
+		((audio_codec != ADBEAudioCodec_PCM) || !mux_supports_16ch))  {
+		wostringstream oss; // text scratchpad for messagebox and errormsg 
+
+		// ERROR
+		oss << "!!! NVENC_EXPORT error, can not confirm user settings !!!" << endl << endl;
+		if (audio_codec != ADBEAudioCodec_PCM)
+			oss << "  Reason: 16-channel audio is only supported with PCM audio (not AAC)" << endl << endl;
+		else
+			oss << "  Reason: " << ((muxType == MUX_MODE_M2T) ? "TS" : "MP4") <<
+				"-multiplexer does not support 16-channel LPCM audio" << endl << endl;
+		oss << "Solution: Either reduce the #channels to 5.1, or select PCM audio with the MKV multiplexer (or no multiplexer)" << endl;
+
+		copyConvertStringLiteralIntoUTF16(L"NVENC-export error", title);
+		copyConvertStringLiteralIntoUTF16(oss.str().c_str(), desc);
+		privateData->errorSuite->SetEventStringUnicode(PrSDKErrorSuite::kEventTypeError, title, desc);
+
+		MessageBoxW(GetLastActivePopup(mainWnd),
+			oss.str().c_str(),
+			EXPORTER_NAME_W,
+			MB_OK | MB_ICONERROR);
+
+		return exportReturn_ErrLastErrorSet;
+	}
+
 	return malNoError; // NVENC is supported
 }
 
@@ -4778,6 +4724,9 @@ NVENC_ExportSettings_to_EncodeConfig(
 
 	_AdobeParamToEncodeConfig( ParamID_separateColourPlaneFlag, intValue, separateColourPlaneFlag, unsigned int );
 
+	lRec->exportParamSuite->GetParamValue(exID, 0, ParamID_encode10bit, &paramValue);
+	config->pixelBitDepthMinus8 = paramValue.value.intValue ? 2 : 0; // 2 = 10-bit
+
 	_AdobeParamToEncodeConfig( ParamID_NV_ENC_MV_PRECISION, intValue, mvPrecision, NV_ENC_MV_PRECISION );
 	_AdobeParamToEncodeConfig( ParamID_disableDeblock, intValue, disableDeblock, unsigned int );
 	_AdobeParamToEncodeConfig( ParamID_NV_ENC_H264_ADAPTIVE_TRANSFORM, intValue, adaptive_transform_mode, NV_ENC_H264_ADAPTIVE_TRANSFORM_MODE );
@@ -4851,6 +4800,9 @@ NVENC_ExportSettings_to_EncodeConfig(
 	//
 	_AdobeParamToEncodeConfig(ParamID_VideoCodec_CPU_EnableAVX, intValue, CPU_enableAVX, int);
 	_AdobeParamToEncodeConfig(ParamID_VideoCodec_CPU_EnableAVX2, intValue, CPU_enableAVX2, int);
+	_AdobeParamToEncodeConfig(ParamID_VideoCodec_CPU_EnableAVX512, intValue, CPU_enableAVX512, int);
+	_AdobeParamToEncodeConfig(ParamID_VideoCodec_CPU_Threads, intValue, CPU_numThreads, unsigned int);
+	_AdobeParamToEncodeConfig(ParamID_VideoCodec_CPU_Lookahead, intValue, CPU_lookahead, unsigned int);
 
 	return S_OK;
 }
\ No newline at end of file
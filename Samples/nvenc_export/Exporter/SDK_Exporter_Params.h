@@ -106,6 +106,8 @@
 	#define	ParamID_AudioFormat_NEROAAC_Path	"ParamID_AudioFormat_NEROAAC_Path"
 	#define	Default_AudioFormat_NEROAAC_Path	L"C:\\TEMP\\NEROAACENC\\win32\\NEROAACENC.EXE"
 
+	#define	ParamID_AudioFormat_Concurrent		"ParamID_AudioFormat_Concurrent" // (bool) render audio alongside the video
+
 	///////////////////////////
 	//
 	// ParamIDs - Identifier-string for user-configurable parameters that
@@ -202,6 +204,8 @@
 		#define LParamID_chromaFormatIDC L"chromaFormatIDC"
 		#define ParamID_separateColourPlaneFlag "separateColourPlaneFlag"
 		#define LParamID_separateColourPlaneFlag L"separateColourPlaneFlag"
+		#define ParamID_encode10bit "encode10bit"
+		#define LParamID_encode10bit L"encode10bit"
 		#define ParamID_NV_ENC_MV_PRECISION "NV_ENC_MV_PRECISION"
 		#define LParamID_NV_ENC_MV_PRECISION L"NV_ENC_MV_PRECISION"
 		#define ParamID_disableDeblock "disableDeblock"
@@ -227,15 +231,8 @@
 
 		//#define L"idr_period" // TODO: CNvEncoder ignores this value
 
-		// workaround for "exParamFlag_filePath" not working correctly,
-		//   A manually-implemented button to select Path of TSMUXER
-		#define ParamID_BasicMux_TSMUXER_Button "TSMUXER_Button" // dialog-button, activates Path-select dialog-box
 		#define ParamID_NVENC_Info_Button "NVENC_Info_Button"
 
-		#define ParamID_BasicMux_MP4BOX_Button "MP4BOX_Button" // dialog-button, activates Path-select dialog-box
-
-		#define ParamID_BasicMux_MKVMERGE_Button "MPVMERGE_Button" // dialog-button, activates Path-select dialog-box
-
 #define		ADBEMPEGCodecBroadcastStandard "ADBEMPEGCodecBroadcastStandard" // ParamID TV-standard
 
 #define		ADBEMultiplexerTabGroup		"ADBEAudienceTabGroup" // top-level Mux group
@@ -243,18 +240,11 @@
 #define		GroupID_NVENCMultiplexer	"GroupID_NVENCMultiplexer" // basic mux tab group
 #define		GroupName_BasicMux			L"Basic Multiplexer param group"
 #define		ADBEVMCMux_Type				"ADBEVMCMux_Type"
-#define		MUX_MODE_M2T				5 // value to select "MPEG-2 TS mode" 
+#define		MUX_MODE_M2T				5 // value to select "MPEG-2 TS mode" (built-in muxer)
 #define		MUX_MODE_NONE				6 // value to select "disable mux" 
-#define		MUX_MODE_MP4				7 // *NVENC-only* value to select "MPEG-4 mode" 
-#define		MUX_MODE_MKV				8 // value to select "MKV mode" 
-#define		ParamID_BasicMux_TSMUXER_Path	"ParamID_BasicMux_TSMUXER_Path"
-#define		Default_BasicMux_TSMUXER_Path	L"C:\\TEMP\\MEGUI\\TOOLS\\TSMUXER\\TSMUXER.EXE"
-
-#define		ParamID_BasicMux_MP4BOX_Path	"ParamID_BasicMux_MP4BOX_Path"
-#define		Default_BasicMux_MP4BOX_Path	L"C:\\TEMP\\MEGUI\\TOOLS\\MP4BOX\\MP4BOX.EXE"
-
-#define		ParamID_BasicMux_MKVMERGE_Path	"ParamID_BasicMux_MKVMERGE_Path"
-#define		Default_BasicMux_MKVMERGE_Path	L"C:\\TEMP\\MEGUI\\TOOLS\\MKVMERGE\\MKVMERGE.EXE"
+#define		MUX_MODE_MP4				7 // *NVENC-only* value to select "MPEG-4 mode" (built-in muxer)
+#define		MUX_MODE_MKV				8 // value to select "MKV mode" (built-in muxer)
+#define		ParamID_BasicMux_MP4_Fragmented	"ParamID_BasicMux_MP4_Fragmented" // (bool) write fragmented MP4
 
 		#define ParamID_VideoCodec_CPU_Report_CAP "CPU capabilities"
 		#define LParamID_VideoCodec_CPU_Report_CAP L"CPU capabilities"
@@ -262,6 +252,24 @@
 		#define LParamID_VideoCodec_CPU_EnableAVX  L"Enable AVX"
 		#define ParamID_VideoCodec_CPU_EnableAVX2  "Enable AVX2"
 		#define LParamID_VideoCodec_CPU_EnableAVX2  L"Enable AVX2"
+		#define ParamID_VideoCodec_CPU_EnableAVX512  "Enable AVX512"
+		#define LParamID_VideoCodec_CPU_EnableAVX512  L"Enable AVX512"
+		#define ParamID_VideoCodec_CPU_Threads  "CPU threads"
+		#define LParamID_VideoCodec_CPU_Threads  L"CPU threads (0 = auto)"
+		#define ParamID_VideoCodec_Telemetry  "Write telemetry"
+		#define LParamID_VideoCodec_Telemetry  L"Write telemetry"
+		#define ParamID_VideoCodec_CPU_Lookahead  "CPU lookahead"
+		#define LParamID_VideoCodec_CPU_Lookahead  L"CPU lookahead (frames)"
+		#define ParamID_VideoCodec_TwoPass  "Two-pass"
+		#define LParamID_VideoCodec_TwoPass  L"Two-pass (whole export)"
+		#define ParamID_VideoCodec_ABR_Ladder  "ABR ladder"
+		#define LParamID_VideoCodec_ABR_Ladder  L"ABR ladder (#renditions)"
+		#define ParamID_VideoCodec_RenderAhead  "Render-ahead"
+		#define LParamID_VideoCodec_RenderAhead  L"Render-ahead (frames)"
+		#define ParamID_VideoCodec_SpillCache  "Spill cache"
+		#define LParamID_VideoCodec_SpillCache  L"Two-pass spill cache (GB)"
+		#define ParamID_VideoCodec_SpillCompress  "Spill compress"
+		#define LParamID_VideoCodec_SpillCompress  L"Compress the spill cache"
 
 prMALError exSDKGenerateDefaultParams(
 	exportStdParms				*stdParms, 
@@ -311,27 +319,24 @@ PrPixelFormat_is_YUV420( const PrPixelFormat p );
 bool
 PrPixelFormat_is_YUV422( const PrPixelFormat p );
 
+bool
+PrPixelFormat_is_V210( const PrPixelFormat p );
+
 bool
 PrPixelFormat_is_YUV444( const PrPixelFormat p );
 
+bool
+PrPixelFormat_is_RGB8u(const PrPixelFormat p);
+
+bool
+PrPixelFormat_is_RGB16u(const PrPixelFormat p);
+
 bool
 PrPixelFormat_is_RGB32f(const PrPixelFormat p);
 
 void
 NVENC_GetEncoderCaps(const NvEncodeCompressionStd codec, const nv_enc_caps_s &caps, string &s);
 
-uint32_t
-NVENC_Calculate_H264_MaxKBitRate( 
-	const NV_ENC_LEVEL level, 
-	const enum_NV_ENC_H264_PROFILE profile
-);
-
-uint32_t
-NVENC_Calculate_HEVC_MaxKBitRate(
-	const NV_ENC_LEVEL level,
-	const NV_ENC_LEVEL tier
-);
-
 uint32_t
 NVENC_Calculate_H264_MaxRefFrames(
 //	NV_ENC_LEVEL level, 
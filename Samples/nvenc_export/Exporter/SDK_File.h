@@ -60,11 +60,18 @@
 
 #include	<cuda.h>
 #include "CNvEncoder.h"
+#include "cmp4writer.h"
+#include "ctswriter.h"
+#include "cmkvwriter.h"
+#include "cfilewriter.h"
+#include "cabrladder.h"
+#include "casyncrender.h"
+#include "cspillcache.h"
 
 #include <MMReg.h> // for GUID KSDATAFORMAT_SUBTYPE_PCM, WAVE_FORMAT_EXTENSIBLE
 
 #ifndef SDK_FILE_CURRENT_VERSION	
-#define SDK_FILE_CURRENT_VERSION	39			// The current file version number. When making a change
+#define SDK_FILE_CURRENT_VERSION	52			// The current file version number. When making a change
 												// to the file structure, increment this value.
 #endif
 
@@ -74,9 +81,6 @@
 #define SDK_FILE_EXTENSION_HEVC		L"hevc"		// file extension for H265 (video) output
 #define SDK_FILE_EXTENSION_WAV		L"wav"		// file extension for pcm (audio) output
 #define SDK_FILE_EXTENSION_M2T		L"ts"		// file extension for muxed (A+V) output
-												//  ^^^ Caution: must be 'ts' or 'm2ts', becauase TSMUXER.EXE
-												//               will analyze this filename-extension to
-												//               choose the proper mux--output type.
 #define SDK_FILE_EXTENSION_MP4		L"mp4"		// file extension for muxed (A+V) output
 #define SDK_FILE_EXTENSION_MKV		L"mkv"		// file extension for muxed (A+V) output
 
@@ -133,7 +137,7 @@ typedef struct {
 	wstring filename;
 	
 	// Only *one* of the following pointers will be used.
-	//FILE *fp;   // legacy C-standard library file-pointer
+	FILE *fp;   // C-standard library file-pointer (native MP4 muxer output)
 	HANDLE hfp; // Win32 file handle (for those routines that use it)
 } FileRecord_t;
 
@@ -177,7 +181,7 @@ typedef struct {
 	// access ourselves (because we need to support writing to multiple files.)
 	FileRecord_t		FileRecord_Audio;// the audio (WAV) file record
 	FileRecord_t		FileRecord_Video;// the video (M4V) file record
-	FileRecord_t		FileRecord_AV;   // muxed file (A+V) not supported yet
+	FileRecord_t		FileRecord_AV;   // muxed file (A+V)
 	FileRecord_t		FileRecord_AAClog;// the logfile written by neroAacEnc.exe (for AAC only)
 	HANDLE				H_pipe_wavout;	 // PIPE input  (nvenc_export wav output)
 	HANDLE				H_pipe_aacin;	 // PIPE output (neroaacenc stdin input)
@@ -211,6 +215,15 @@ typedef struct
 } ImporterLocalRec8, *ImporterLocalRec8Ptr, **ImporterLocalRec8H;
 
 
+// one lower rung of the ABR ladder: its encoder-session writes its own elementary-stream file
+typedef struct NvEncLadderRung {
+	CNvEncoder					*p_NvEncoder;
+	CFileWriter					*p_FileWriter;
+	EncodeConfig				NvEncodeConfig;   // the export's settings, at the rung's size and bitrate
+	bool						opened;           // the encoder-session is open (frames are submitted)
+	prUTF16Char					filename[1024];   // <output>_<height>p.m4v/.hevc
+} NvEncLadderRung;
+
 ///////////////////////////////////////////////////////////////////////////////
 // Exporter local data structure, defined here for convenience
 typedef struct ExportSettings
@@ -243,6 +256,10 @@ typedef struct ExportSettings
 	NvEncoderGPUInfo_s          NvGPUInfo;
 	EncodeConfig				NvEncodeConfig;
 	CNvEncoder					*p_NvEncoder;
+	CMp4Writer					*p_Mp4Writer; // native MP4 muxer (only during an MUX_MODE_MP4 export)
+	CTsWriter					*p_TsWriter;  // native TS muxer  (only during an MUX_MODE_M2T export)
+	CMkvWriter					*p_MkvWriter; // native MKV muxer (only during an MUX_MODE_MKV export)
+	CFileWriter					*p_FileWriter;// async writer of the elementary-stream file (only during an export without a native muxer)
 	
 	// frame#0 PixelFormat advertisement behavior:
 	//   true(forced) = user supplies the PixelFormat to use for frame#0, 
@@ -260,6 +277,30 @@ typedef struct ExportSettings
 	bool                        video_encode_fatalerr;  // status, video-encode operation suffered a fatal
 														// unrecoverable error.  (This causes nvenc_export
 														// to skip subsequent audio-encoding and muxing.)
+
+	// Concurrent audio/video export (the audio renders on its own thread, see exSDKExport)
+	bool                        audio_concurrent;       // the audio-thread is running: it doesn't report progress
+														// itself, the video-render folds in audio_progress_permille
+	volatile LONG               audio_progress_permille;// audio-thread's progress (0..1000)
+	volatile LONG               export_cancel;          // set (by either stream) on error/abort: the other stream stops early
+
+	// Two-pass export (PUSH-mode only: DoMultiPassExportLoop renders the sequence twice)
+	FILE                        *twopass_stats_fp;      // pass-1 stats (<output>_twopass.stats), NULL = single-pass
+	csSDK_uint32                twopass_pass;           // 0 = single-pass, 1 = analysis (the bitstream is discarded), 2 = final
+	EncodeConfig                twopass_NvEncodeConfig; // the user's settings (restored for pass 2)
+
+	// Spill cache (two-pass export): pass 1 writes the converted frames to a scratch file,
+	// pass 2 plays them back instead of rendering the sequence again
+	CSpillCache                 *p_SpillCache;          // NULL = off
+	FILE                        *spill_fp;              // the scratch file (<output>_spill.tmp, deleted on close)
+	unsigned long long          spill_budget;           // bytes (largest scratch file)
+	bool                        spill_compress;         // LZ-compress the frames
+
+	// ABR ladder: rung 0 is the export itself, rungs 1.. encode the downscale pyramid of
+	// the same rendered frame (each into its own elementary-stream file)
+	CAbrLadder                  *p_AbrLadder;           // the downscale pyramid (NULL = single rendition)
+	csSDK_uint32                ladder_rungs;           // #rungs (including rung 0)
+	NvEncLadderRung             ladder[ABR_LADDER_MAX_RUNGS]; // [0] unused
 } ExportSettings;
 
 
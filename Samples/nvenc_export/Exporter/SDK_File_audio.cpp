@@ -4,6 +4,7 @@
 
 #include <Windows.h> // SetFilePointer(), WriteFile()
 #include <sstream>  // ostringstream
+#include <vector>
 #include <cstdio>
 
 typedef struct {
@@ -192,9 +193,17 @@ NVENC_WriteSDK_WAVHeader(exportStdParms *stdParms, exDoExportRec *exportInfoP, P
 	//                               Values other than 1 indicate some 
 	//                               form of compression.
 
-	w.BitsPerSample = 16; w2.BitsPerSample = 16;//34        2   BitsPerSample    8 bits = 8, 16 bits = 16, etc.
+	const wav_channel_layout_t *layout = get_wav_channel_layout(channelType.value.intValue);
+	if (layout == NULL)
+		return exportReturn_IncompatibleAudioChannelType;
+	const bool is_float = (NVENC_WAV_SAMPLE_FORMAT == WAV_SAMPLE_FLOAT32);
+	if (is_float)
+		w.AudioFormat = WAVE_FORMAT_IEEE_FLOAT;
+
+	w.BitsPerSample = get_wav_sample_bytes(NVENC_WAV_SAMPLE_FORMAT) * 8;//34        2   BitsPerSample    8 bits = 8, 16 bits = 16, etc.
+	w2.BitsPerSample = w.BitsPerSample;
 
-	w.NumChannels = GetNumberOfAudioChannels(channelType.value.intValue);//22        2   NumChannels      Mono = 1, Stereo = 2, etc.
+	w.NumChannels = layout->num_channels;//22        2   NumChannels      Mono = 1, Stereo = 2, etc.
 	w2.NumChannels = w.NumChannels;
 	w.SampleRate = sampleRate.value.floatValue;//24        4   SampleRate       8000, 44100, etc.
 	w2.SampleRate = w.SampleRate;
@@ -209,9 +218,9 @@ NVENC_WriteSDK_WAVHeader(exportStdParms *stdParms, exDoExportRec *exportInfoP, P
 	//          X   ExtraParams      space for extra parameters
 	//
 	w2.ExtraParamSize = 22;
-	w2.ValidBitsPerSample = 16;//       2   # valid bits per sample
-	w2.ChannelMask = 0x3F;    //       4   speaker position mask
-	w2.SubFormat.guid = KSDATAFORMAT_SUBTYPE_PCM;
+	w2.ValidBitsPerSample = w2.BitsPerSample;//       2   # valid bits per sample
+	w2.ChannelMask = layout->channel_mask;    //       4   speaker position mask
+	w2.SubFormat.guid = is_float ? KSDATAFORMAT_SUBTYPE_IEEE_FLOAT : KSDATAFORMAT_SUBTYPE_PCM;
 
 	//The "data" subchunk contains the size of the data and the actual sound:
 	//
@@ -239,7 +248,9 @@ NVENC_WriteSDK_WAVHeader(exportStdParms *stdParms, exDoExportRec *exportInfoP, P
 #endif
 
 	// Write out the header
-	bytesToWriteLu = (w.NumChannels > 2) ? sizeof(w2) : sizeof(w);
+	//   (WAVEFORMATEXTENSIBLE is required for multichannel, and for samples wider than 16 bits)
+	const bool use_wavex = (w.NumChannels > 2) || (w.BitsPerSample > 16);
+	bytesToWriteLu = use_wavex ? sizeof(w2) : sizeof(w);
 
 	exportInfoP->privateData = reinterpret_cast<void*>(mySettings);
 
@@ -258,8 +269,8 @@ NVENC_WriteSDK_WAVHeader(exportStdParms *stdParms, exDoExportRec *exportInfoP, P
 	*/
 	void *pHeader;
 
-	if (w.NumChannels > 2)
-		pHeader = reinterpret_cast<void*>(&w2); // 5.1 audio only
+	if (use_wavex)
+		pHeader = reinterpret_cast<void*>(&w2); // 5.1 and 16-channel audio
 	else
 		pHeader = reinterpret_cast<void*>(&w);  // mono, stereo
 
@@ -314,189 +325,196 @@ NVENC_WriteSDK_WAVHeader(exportStdParms *stdParms, exDoExportRec *exportInfoP, P
 }
 
 #include <emmintrin.h> // Visual Studio 2005 MMX/SSE/SSE2 compiler intrinsics
-#include <tmmintrin.h> // Visual Studio 2008 SSSE3 (Tejas New Instr) compiler intrinsics (_mm_shuffle_epi8 or 'PSHUFB')
+
+//
+// WAV channel-layouts:  Adobe channel-type -> RIFF-WAV channel-order and speaker-mask
+//
+// WAVEFORMATEXTENSIBLE									   ADOBE								VST 3
+// ----------------------------------------------	   -----------------------------	---------------------------------------		------------------
+//kPrAudioChannelLabel_FrontLeft				= 100,	// SPEAKER_FRONT_LEFT				kAudioChannelLabel_Left						kSpeakerL
+//kPrAudioChannelLabel_FrontRight				= 101,	// SPEAKER_FRONT_RIGHT				kAudioChannelLabel_Right					kSpeakerR
+//kPrAudioChannelLabel_FrontCenter			= 102,	// SPEAKER_FRONT_CENTER				kAudioChannelLabel_Center					kSpeakerC
+//kPrAudioChannelLabel_LowFrequency			= 103,	// SPEAKER_LOW_FREQUENCY			kAudioChannelLabel_LFEScreen				kSpeakerLfe
+//kPrAudioChannelLabel_BackLeft				= 104,	// SPEAKER_BACK_LEFT				kAudioChannelLabel_LeftSurround				kSpeakerLs
+//kPrAudioChannelLabel_BackRight				= 105,	// SPEAKER_BACK_RIGHT				kAudioChannelLabel_RightSurround			kSpeakerRs	
+//
+// For 5.1 surround audio, Adobe and RIFF(*.WAV) use different channel-order.
+// Adobe                    RIFF WAV
+// -------------		    ---------
+// [0] FrontLeft            (0) FrontLeft           
+// [1] FrontRight           (1) FrontRight          
+// [2] BackLeft             (2) FrontCenter         
+// [3] BackRight            (3) LFE                 
+// [4] FrontCenter          (4) BackLeft            
+// [5] LFE                  (5) BackRight           
+//
+// Adobe's 16-channel audio has no speaker-assignment (kPrAudioChannelLabel_Discrete),
+// so it is written in its original order with a zero ChannelMask.
+
+static const wav_channel_layout_t wav_channel_layouts[] = {
+	{ kPrAudioChannelType_Mono,      1, 0x4,  { 0 } }, // SPEAKER_FRONT_CENTER
+	{ kPrAudioChannelType_Stereo,    2, 0x3,  { 0, 1 } },
+	{ kPrAudioChannelType_51,        6, 0x3F, { 0, 1, 4, 5, 2, 3 } },
+	{ kPrAudioChannelType_16Channel, 16, 0x0, { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 } }
+};
+
+const wav_channel_layout_t *
+get_wav_channel_layout(const csSDK_int32 audioChannelType)
+{
+	for (size_t i = 0; i < sizeof(wav_channel_layouts) / sizeof(wav_channel_layouts[0]); ++i)
+		if (wav_channel_layouts[i].audio_channel_type == audioChannelType)
+			return &wav_channel_layouts[i];
+
+	return NULL; // not supported
+}
+
+uint32_t
+get_wav_sample_bytes(const wav_sample_format_t format)
+{
+	switch (format) {
+	case WAV_SAMPLE_INT16:	return 2;
+	case WAV_SAMPLE_INT24:	return 3;
+	default:				return 4; // WAV_SAMPLE_FLOAT32
+	}
+}
+
+// _adobe2wav_store4() : convert 4 float-samples, and store them to 4 consecutive WAV sample-slots
+static inline void
+_adobe2wav_store4(
+	uint8_t dst[],
+	const __m128 x,
+	const wav_sample_format_t format,
+	const __m128 scale, const __m128 lo, const __m128 hi // integer output: full-scale and clip-limits
+)
+{
+	if (format == WAV_SAMPLE_FLOAT32) {
+		_mm_storeu_ps(reinterpret_cast<float *>(dst), x);
+		return;
+	}
+
+	// scale, clip and round (to nearest)
+	const __m128i v = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(x, scale), lo), hi));
+
+	if (format == WAV_SAMPLE_INT16) {
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(dst), _mm_packs_epi32(v, v));
+	}
+	else { // WAV_SAMPLE_INT24 (little-endian, packed 3 bytes/sample)
+		__declspec(align(16)) int32_t t[4];
+		_mm_store_si128(reinterpret_cast<__m128i *>(t), v);
+		for (int i = 0; i < 4; ++i, dst += 3) {
+			dst[0] = static_cast<uint8_t>(t[i]);
+			dst[1] = static_cast<uint8_t>(t[i] >> 8);
+			dst[2] = static_cast<uint8_t>(t[i] >> 16);
+		}
+	}
+}
+
+// _adobe2wav_store1() : scalar version of _adobe2wav_store4(), for the tail-end of the buffer
+static inline void
+_adobe2wav_store1(
+	uint8_t dst[],
+	const float x,
+	const wav_sample_format_t format,
+	const __m128 scale, const __m128 lo, const __m128 hi
+)
+{
+	if (format == WAV_SAMPLE_FLOAT32) {
+		memcpy(dst, &x, sizeof(x));
+		return;
+	}
+
+	const int32_t v = _mm_cvtss_si32(_mm_min_ss(_mm_max_ss(_mm_mul_ss(_mm_set_ss(x), scale), lo), hi));
+	dst[0] = static_cast<uint8_t>(v);
+	dst[1] = static_cast<uint8_t>(v >> 8);
+	if (format == WAV_SAMPLE_INT24)
+		dst[2] = static_cast<uint8_t>(v >> 16);
+}
+
+//
+// adobe2wav_interleave_sse2() - Adobe planar float audio -> interleaved RIFF-WAV audio
+//
+//    Sample-conversion (float -> int16/int24/float32), interleaving and the channel-reorder
+//    (Adobe -> WAVEFORMATEXTENSIBLE) are fused into a single pass over the audio.
+//
+//    Mono and stereo are interleaved directly.  Other layouts are processed in groups of
+//    4 channels x 4 samples: each group is transposed (4x4), so every store writes
+//    4 adjacent channels of one PCM-frame.  A group with fewer than 4 channels
+//    overruns into the next PCM-frame, which is written (correctly) afterwards;
+//    the last few frames are written by the scalar loop, so nothing is written past
+//    the end of the output-buffer.
+//
+//    Neither the source nor destination buffers need to be aligned.
 
 void
-adobe2wav_audio51_swap_ssse3(
-const uint32_t numSamples, // number of 5.1-audio samples (each 5.1-audioSample is 6+2=12 bytes)
-__m128i audioBuffer[]      // audioBuffer (requirement: 128-bit aligned)
+adobe2wav_interleave_sse2(
+	const float * const src[],          // Adobe planar audio (one buffer per channel, Adobe-order)
+	const wav_channel_layout_t &layout,
+	const wav_sample_format_t format,
+	const uint32_t numSamples,          // #PCM-frames to convert
+	void *dst                           // output: numSamples * layout.num_channels samples
 )
 {
-	__m128i audio51_mask[3] = { 0 };
-	__m128i fixup_mask[4] = { 0 };
-	__m128i read_temp[3] = { 0 };
-	__m128i write_temp[3] = { 0 };
-	__m128i write_fixup[4] = { 0 };
-
-	// m128_u : abstract data-strut to represent a 128-bit SSE2 (XMM) register
-
-	typedef __declspec(align(16)) union {
-		__m128i  xmm;   // the SSE2 register
-		uint8_t  b[16]; // byte arrangement
-		uint16_t w[8];  // word arrangement
-		uint32_t d[4];  // dword arrangement
-		uint64_t q[2];  // qword arrangement
-	} m128_u;
-
-	// _m128u_word(): generate a 16-bit mask-value for 2nd-operand of 'PSHUFB',
-	//                for selecting a 16-bit word from the 128-bit source reg
-	//             bit#127                                 bit#0
-	//                :____ ____ ____ ____ ____ ____ ____ ____:
-	//                | w7 | w6 | w5 | w4 | w3 | w2 | w1 | w0 |   source_reg
-	//
-	//                Each word (w0..w7) is 16-bits wide
-	//
-	//                Let src_word_index = {0..7}  (selects 1 word from #{0..7})
-	//                mask_bit: 0 = copy (copy word[i] from source to dest)
-	//                          1 = zero (zero out the dest field)
-
-#define _m128u_word(src_word_index, mask_bit) ( \
-	(  (mask_bit) ? 0x80 : ( (src_word_index)<<1 ) ) & 0xFF | \
-	( ((mask_bit) ? 0x80 : ( ((src_word_index)<<1)+1)) << 8 ) & 0xFF00 \
-	)
-
-	m128_u * const mask0 = reinterpret_cast<m128_u *>(&audio51_mask[0]);
-	m128_u * const mask1 = reinterpret_cast<m128_u *>(&audio51_mask[1]);
-	m128_u * const mask2 = reinterpret_cast<m128_u *>(&audio51_mask[2]);
-	m128_u * const fmask0_from1 = reinterpret_cast<m128_u *>(&fixup_mask[0]);
-	m128_u * const fmask1_from0 = reinterpret_cast<m128_u *>(&fixup_mask[1]);
-	m128_u * const fmask1_from2 = reinterpret_cast<m128_u *>(&fixup_mask[2]);
-	m128_u * const fmask2_from1 = reinterpret_cast<m128_u *>(&fixup_mask[3]);
-
-	memset(reinterpret_cast<void *>(fmask0_from1), 0x80, sizeof(m128_u));
-	memset(reinterpret_cast<void *>(fmask1_from0), 0x80, sizeof(m128_u));
-	memset(reinterpret_cast<void *>(fmask1_from2), 0x80, sizeof(m128_u));
-	memset(reinterpret_cast<void *>(fmask2_from1), 0x80, sizeof(m128_u));
-
-	// WAVEFORMATEXTENSIBLE									   ADOBE								VST 3
-	// ----------------------------------------------	   -----------------------------	---------------------------------------		------------------
-	//kPrAudioChannelLabel_FrontLeft				= 100,	// SPEAKER_FRONT_LEFT				kAudioChannelLabel_Left						kSpeakerL
-	//kPrAudioChannelLabel_FrontRight				= 101,	// SPEAKER_FRONT_RIGHT				kAudioChannelLabel_Right					kSpeakerR
-	//kPrAudioChannelLabel_FrontCenter			= 102,	// SPEAKER_FRONT_CENTER				kAudioChannelLabel_Center					kSpeakerC
-	//kPrAudioChannelLabel_LowFrequency			= 103,	// SPEAKER_LOW_FREQUENCY			kAudioChannelLabel_LFEScreen				kSpeakerLfe
-	//kPrAudioChannelLabel_BackLeft				= 104,	// SPEAKER_BACK_LEFT				kAudioChannelLabel_LeftSurround				kSpeakerLs
-	//kPrAudioChannelLabel_BackRight				= 105,	// SPEAKER_BACK_RIGHT				kAudioChannelLabel_RightSurround			kSpeakerRs	
-
-	// For 5.1 surround audio, Adobe and RIFF(*.WAV) use different channel-order.
-	// Adobe                    RIFF WAV
-	// -------------		    ---------
-	// [1] FrontLeft            (1) FrontLeft           
-	// [2] FrontRight           (2) FrontRight          
-	// [3] BackLeft             (3) FrontCenter         
-	// [4] BackRight            (4) LFE                 
-	// [5] FrontCenter          (5) BackLeft            
-	// [6] LFE                  (6) BackRight           
-
-	// To convert Adobe -> RIFF, the channels are re-ordered as follows:
-	//
-	// Source                   Destination
-	// -------------            ------------
-	// [1] FrontLeft            [1] FrontLeft           
-	// [2] FrontRight           [2] FrontRight          
-	// [3] BackLeft             [5] FrontCenter         
-	// [4] BackRight            [6] LFE                 
-	// [5] FrontCenter          [3] BackLeft            
-	// [6] LFE                  [4] BackRight             
-
-	// SSE2 (128-bit) performance optimization
-	// (10 operate on 4 blockSamples at a time (i.e. four 5.1-audio samples, or 4 x 12 bytes.)
-	//
-	//    16-bit
-	//    word#		first_output					second_output					third_output
-	//		|<------- 128 bits --------->|	|<-------- 128 bits -------->|	|<------ 128 bits ---------->|
-	// 		w0	w1	w2	w3	w4	w5	w6	w7	x8	x9	x10	x11	x12	x13	x14	x15	y16	y17	y18	y19	y20	y21	y22	y23
-	//	------------------+---------------+---------------+---------------+---------------+---------------+--> time
-	//	src	1	2	3	4	5	6	1	2	3	4	5	6	1	2	3	4	5	6	1	2	3	4	5	6
-	//	dst	1   2   5   6   3   4   1   2   5   6   3   4   1   2   5   6   3   4   1   2   5   6   3   4
-	//	  |		Sample n		  |		Sample n+1		  |		Sample n+2		  |		Sample n+3		 |
-	//
-	//  re-indexed for (0)..(5) instead of (1)..(6)
-	//
-	//	src	a0	a1	a2	a3	a4	a5	b0	b1	b2	b3	b4	b5	c0	c1	c2	c3	c4	c5	d0	d1	d2	d3	d4	d5
-	//	dst	a0	a1	a4	a5	a2	a3	b0	b1	b4	b5	b2	b3	c0	c1	c4	c4	c2	c3	d0	d1	d4	d5	d2	d3	
-	//	  |		Sample n		  |		Sample n+1		  |		Sample n+2		  |		Sample n+3		 |
-	// 		w0	w1	w2	w3	w4	w5	w6	w7	x8	x9	x10	x11	x12	x13	x14	x15	y16	y17	y18	y19	y20	y21	y22	y23
-	//		|<------- 128 bits --------->|	|<-------- 128 bits -------->|	|<------ 128 bits ---------->|
-	//    word#		first_output					second_output					third_output
-
-	///// 
-	// Sample n+0 (first sample)
-	mask0->w[0] = _m128u_word(0, 0);// FrontLeft
-	mask0->w[1] = _m128u_word(1, 0);// FrontRight
-	mask0->w[2] = _m128u_word(4, 0);// FrontCenter
-	mask0->w[3] = _m128u_word(5, 0);// LFE
-	mask0->w[4] = _m128u_word(2, 0);// BackLeft
-	mask0->w[5] = _m128u_word(3, 0);// BackRight
-	//
-	/////
-
-	//////
-	// Sample n+1 (second sample)
-	mask0->w[0 + 6] = _m128u_word(0 + 6, 0);// FrontLeft
-	mask0->w[1 + 6] = _m128u_word(1 + 6, 0);// FrontRight
-	mask1->w[2 - 2] = _m128u_word(4 - 2, 0);// FrontCenter
-	mask1->w[3 - 2] = _m128u_word(5 - 2, 0);// LFE
-	mask1->w[4 - 2] = _m128u_word(2 - 2, 0);// BackLeft
-	mask1->w[5 - 2] = _m128u_word(3 - 2, 0);// BackRight
-
-	// Sample n+1
-	//////
-
-	/////
-	// Sample n+2 (third sample)
-	mask1->w[0 + 4] = _m128u_word(0 + 4, 0); // channel[0]
-	mask1->w[1 + 4] = _m128u_word(1 + 4, 0); // channel[1]
-	mask1->w[2 + 4] = _m128u_word(4 + 4, 1); // ILLEGAL (need fixup)
-	mask1->w[3 + 4] = _m128u_word(5 + 4, 1); // ILLEGAL (need fixup)
-	fmask1_from2->w[2 + 4] = _m128u_word(4 + 4 - 8, 0); // data from previous <mm128>
-	fmask1_from2->w[3 + 4] = _m128u_word(5 + 4 - 8, 0); // data from previous <mm128>
-
-	mask2->w[4 - 4] = _m128u_word(2 - 4, 1); // ILLEGAL (need fixup)
-	mask2->w[5 - 4] = _m128u_word(3 - 4, 1); // ILLEGAL (need fixup)
-
-	fmask2_from1->w[4 - 4] = _m128u_word(2 - 4 + 8, 0); // data from previous <mm128>
-	fmask2_from1->w[5 - 4] = _m128u_word(3 - 4 + 8, 0); // data from previous <mm128>
-
-	// Sample n+2
-	/////
-
-	/////
-	// Sample n+3 (fourth sample)
-	mask2->w[0 + 2] = _m128u_word(0 + 2, 0);
-	mask2->w[1 + 2] = _m128u_word(1 + 2, 0);
-	mask2->w[2 + 2] = _m128u_word(4 + 2, 0);
-	mask2->w[3 + 2] = _m128u_word(5 + 2, 0);
-	mask2->w[4 + 2] = _m128u_word(2 + 2, 0);
-	mask2->w[5 + 2] = _m128u_word(3 + 2, 0);
-	// Sample n+3
-	/////
-
-	// During each loop-iteration,we process four 5.1-audioSamples.  Each 5.1-audioSample is six 16-bit words,
-	// for a total of 48 bytes. This is the smallest unit of work using 128-bit SSE2 data-operations.
-
-	for (uint32_t n = 0, aptr = 0; n < numSamples; n += 4, aptr += 3) {
-		read_temp[0] = audioBuffer[aptr];
-		read_temp[1] = audioBuffer[aptr + 1];
-		read_temp[2] = audioBuffer[aptr + 2];
-
-		// Perform the first-round of word-to-word shuffling.
-		write_temp[0] = _mm_shuffle_epi8(read_temp[0], mask0->xmm);
-		write_temp[1] = _mm_shuffle_epi8(read_temp[1], mask1->xmm);
-		write_temp[2] = _mm_shuffle_epi8(read_temp[2], mask2->xmm);
-
-		// Perform the second-round of word-to-word shuffling (i.e. "fixups")
-
-		// No fixup needed for output[0]
-
-		// fixup for output[1]: need to pull in some sampledata from read_temp[2]
-		write_fixup[1] = _mm_shuffle_epi8(read_temp[2], fmask1_from2->xmm);
-
-		// fixup for output[2]: need to pull in some sampledata from read_temp[1]
-		write_fixup[2] = _mm_shuffle_epi8(read_temp[1], fmask2_from1->xmm);
-
-		audioBuffer[aptr] = write_temp[0];
-		audioBuffer[aptr + 1] = _mm_or_si128(write_temp[1], write_fixup[1]);// w1 | wf1
-		audioBuffer[aptr + 2] = _mm_or_si128(write_temp[2], write_fixup[2]);// w2 | wf2
+	const uint32_t nch = layout.num_channels;
+	const uint32_t sample_bytes = get_wav_sample_bytes(format);
+	const size_t frame_bytes = nch * sample_bytes;
+	uint8_t * const out = reinterpret_cast<uint8_t *>(dst);
+	const float * in[WAV_MAX_CHANNELS];
+	uint32_t n = 0;
+
+	const float full_scale = (format == WAV_SAMPLE_INT24) ? 8388608.0f : 32768.0f;
+	const __m128 scale = _mm_set1_ps(full_scale);
+	const __m128 lo = _mm_set1_ps(-full_scale);
+	const __m128 hi = _mm_set1_ps(full_scale - 1.0f);
+
+	// source-channel for each WAV channel
+	for (uint32_t c = 0; c < nch; ++c)
+		in[c] = src[layout.remap[c]];
+
+	if (nch == 1) {
+		for (; n + 4 <= numSamples; n += 4)
+			_adobe2wav_store4(out + n * frame_bytes, _mm_loadu_ps(in[0] + n), format, scale, lo, hi);
+	}
+	else if (nch == 2) {
+		for (; n + 4 <= numSamples; n += 4) {
+			const __m128 l = _mm_loadu_ps(in[0] + n);
+			const __m128 r = _mm_loadu_ps(in[1] + n);
+			uint8_t * const o = out + n * frame_bytes;
+			_adobe2wav_store4(o, _mm_unpacklo_ps(l, r), format, scale, lo, hi);                // L0 R0 L1 R1
+			_adobe2wav_store4(o + 4 * sample_bytes, _mm_unpackhi_ps(l, r), format, scale, lo, hi); // L2 R2 L3 R3
+		}
+	}
+	else {
+		const uint32_t groups = (nch + 3) >> 2;
+		__m128 t[WAV_MAX_CHANNELS / 4][4]; // [group][sample] : 4 channels of 1 PCM-frame
+
+		// Each store writes 4 sample-slots; a partial group overruns by at most 3 slots,
+		// i.e. into the following PCM-frame (nch >= 3).  Keep that frame in the buffer.
+		for (; n + 4 < numSamples; n += 4) {
+			for (uint32_t g = 0; g < groups; ++g) {
+				const uint32_t c = g << 2;
+				__m128 r0 = _mm_loadu_ps(in[c] + n);
+				__m128 r1 = (c + 1 < nch) ? _mm_loadu_ps(in[c + 1] + n) : _mm_setzero_ps();
+				__m128 r2 = (c + 2 < nch) ? _mm_loadu_ps(in[c + 2] + n) : _mm_setzero_ps();
+				__m128 r3 = (c + 3 < nch) ? _mm_loadu_ps(in[c + 3] + n) : _mm_setzero_ps();
+				_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+				t[g][0] = r0; t[g][1] = r1; t[g][2] = r2; t[g][3] = r3;
+			}
+
+			// PCM-frame order (outer), then channel-group order (inner):
+			//    every overrun is overwritten by a later store.
+			for (uint32_t s = 0; s < 4; ++s) {
+				uint8_t * const o = out + (n + s) * frame_bytes;
+				for (uint32_t g = 0; g < groups; ++g)
+					_adobe2wav_store4(o + (g << 2) * sample_bytes, t[g][s], format, scale, lo, hi);
+			}
+		}
+	}
+
+	// tail-end
+	for (; n < numSamples; ++n) {
+		uint8_t *o = out + n * frame_bytes;
+		for (uint32_t c = 0; c < nch; ++c, o += sample_bytes)
+			_adobe2wav_store1(o, in[c][n], format, scale, lo, hi);
 	}
 }
 
@@ -568,15 +586,17 @@ const wchar_t out_aacfilename[]  // output *.AAC filename
 }
 
 //
-// NVENC_spawn_neroaacenc() - convert NVENC-generated *.WAV file into *.AAC file
+// NVENC_spawn_neroaacenc() - convert NVENC-generated WAV-audio into *.M4A file, without a tempfile
 //     Spawn neroAacEnc.exe as a process which reads from STDIN.
 //     nvenc_export's wav-writer will pass audio-data to STDIN of the neroAacEnc process.
-//    
-//     After calling the spawn process, nvenc_export must write audiodata into the pipe.
-//     (and finally, call NVENC_wait_neroaacenc to wait for neroAacEnc to indicate completion.)
+//
+//     Before calling spawn, NVENC_create_neroaac_pipe() must have created the pipe.
+//     After calling the spawn process, nvenc_export must write audiodata into the pipe
+//     (SDKFileRec.H_pipe_wavout), close the pipe, and finally call NVENC_wait_neroaacenc()
+//     to wait for neroAacEnc to indicate completion.
 //
 //     Returns: true if successful
-//              false otherwise
+//              false otherwise (the pipe is closed, and no process is running)
 
 bool
 NVENC_spawn_neroaacenc(
@@ -587,11 +607,12 @@ const wchar_t out_aacfilename[]  // output *.AAC filename
 {
 	std::wostringstream os;
 	wstring tempdirname;
-	STARTUPINFOW siStartInfo;
-	wchar_t *pwstring = NULL; // pointer to a wchar_t string
+	STARTUPINFOEXW siStartInfo;
+	SECURITY_ATTRIBUTES saAttr;
 	csSDK_int32					mgroupIndex = 0;
 	exParamValues exParamValue_aacpath, exParamValue_temp;
 	int32_t kbitrate; // audio bitrate (Kbps)
+	SDK_File &rec = mySettings->SDKFileRec;
 
 	mySettings->exportParamSuite->GetParamValue(exID, mgroupIndex, ParamID_AudioFormat_NEROAAC_Path, &exParamValue_aacpath);
 	mySettings->exportParamSuite->GetParamValue(exID, mgroupIndex, ADBEAudioBitrate, &exParamValue_temp);
@@ -602,146 +623,235 @@ const wchar_t out_aacfilename[]  // output *.AAC filename
 	// build the command-line to execute neroAAC.
 	// It will look something like this:
 	//
-	//    neroaacenc.exe -br 12340000 -if - -of "out_aacfilename.aac"
-	os << exParamValue_aacpath.paramString; // the execution-path to neroAacEnc.exe
+	//    "neroaacenc.exe" -br 12340000 -ignorelength -if - -of "out_aacfilename.aac"
+	//
+	//  -ignorelength : the WAV-header's length-fields are ignored (they can't be
+	//                  patched after the fact, and overflow beyond 4GB of audio)
+	os << "\"" << exParamValue_aacpath.paramString << "\""; // the execution-path to neroAacEnc.exe
 	os << " -br " << std::dec << (kbitrate * 1024);
-	os << " -if - "; // input-file: stdin
+	os << " -ignorelength";
+	os << " -if -"; // input-file: stdin
 	os << " -of \"" << out_aacfilename << "\"";
-	pwstring = new wchar_t[os.str().size()];
-	lstrcpyW(pwstring, os.str().c_str()); // harden the arguments
+	const wstring cmdline_str = os.str();
+	std::vector<wchar_t> cmdline(cmdline_str.begin(), cmdline_str.end());
+	cmdline.push_back(0); // CreateProcessW() requires a writable, null-terminated string
 
 	// Just in case the output-file already exists, delete it
 	DeleteFileW(out_aacfilename);
 
+	// Create the logfile that neroAacEnc.exe will write its console-output to.
+	// (The child-process needs to inherit this handle, as its stdout/stderr.)
+	saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
+	saAttr.bInheritHandle = TRUE;
+	saAttr.lpSecurityDescriptor = NULL;
+
+	DeleteFileW(rec.FileRecord_AAClog.filename.c_str());
+	rec.FileRecord_AAClog.hfp = CreateFileW(
+		rec.FileRecord_AAClog.filename.c_str(),
+		GENERIC_WRITE,
+		FILE_SHARE_READ,
+		&saAttr,
+		CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL,
+		NULL
+		);
+
+	// Restrict the inherited handles to the pipe's read-end and the logfile.
+	// Otherwise neroAacEnc would inherit every inheritable handle of the host-application,
+	// (including the write-end of another export's pipe, which would then never see EOF.)
+	HANDLE inherit_list[2] = { rec.H_pipe_aacin, rec.FileRecord_AAClog.hfp };
+	SIZE_T attr_size = 0;
+	std::vector<uint8_t> attr_buffer;
+	BOOL bSuccess = (rec.FileRecord_AAClog.hfp != INVALID_HANDLE_VALUE);
+
+	ZeroMemory(&siStartInfo, sizeof(siStartInfo));
+	siStartInfo.StartupInfo.cb = sizeof(siStartInfo);
+
+	if (bSuccess) {
+		InitializeProcThreadAttributeList(NULL, 1, 0, &attr_size);
+		attr_buffer.resize(attr_size);
+		siStartInfo.lpAttributeList = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(&attr_buffer[0]);
+		bSuccess = InitializeProcThreadAttributeList(siStartInfo.lpAttributeList, 1, 0, &attr_size);
+		if (bSuccess)
+			bSuccess = UpdateProcThreadAttribute(siStartInfo.lpAttributeList, 0,
+				PROC_THREAD_ATTRIBUTE_HANDLE_LIST, inherit_list, sizeof(inherit_list), NULL, NULL);
+		else
+			siStartInfo.lpAttributeList = NULL;
+	}
+
 	// Set up members of the PROCESS_INFORMATION structure. 
 
-	ZeroMemory(&(mySettings->SDKFileRec.child_piProcInfo), sizeof(PROCESS_INFORMATION));
+	ZeroMemory(&(rec.child_piProcInfo), sizeof(PROCESS_INFORMATION));
 
 	// Set up members of the STARTUPINFO structure. 
 	// This structure specifies the STDIN and STDOUT handles for redirection.
 
-	ZeroMemory(&siStartInfo, sizeof(STARTUPINFO));
-	siStartInfo.cb = sizeof(STARTUPINFO);
-	siStartInfo.hStdError = mySettings->SDKFileRec.FileRecord_AAClog.hfp;
-	siStartInfo.hStdOutput = mySettings->SDKFileRec.FileRecord_AAClog.hfp;
-	siStartInfo.hStdInput = mySettings->SDKFileRec.H_pipe_aacin; // WAVout
-	siStartInfo.dwFlags |= STARTF_USESTDHANDLES;
+	siStartInfo.StartupInfo.hStdError = rec.FileRecord_AAClog.hfp;
+	siStartInfo.StartupInfo.hStdOutput = rec.FileRecord_AAClog.hfp;
+	siStartInfo.StartupInfo.hStdInput = rec.H_pipe_aacin; // WAVout
+	siStartInfo.StartupInfo.dwFlags |= STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
+	siStartInfo.StartupInfo.wShowWindow = SW_HIDE;
 
 	// Create the child process. 
-	BOOL bSuccess = CreateProcessW(NULL,
-		pwstring,		// command line 
-		NULL,          // process security attributes 
-		NULL,          // primary thread security attributes 
-		TRUE,          // handles are inherited 
-		0,             // creation flags 
-		NULL,          // use parent's environment 
-		tempdirname.c_str(), // use parent's current directory 
-		&siStartInfo,  // STARTUPINFO pointer 
-		&(mySettings->SDKFileRec.child_piProcInfo)
-		);  // receives PROCESS_INFORMATION 
-
-	//delete pwstring;// don't forget to free this manually allocated buffer
+	if (bSuccess)
+		bSuccess = CreateProcessW(NULL,
+			&cmdline[0],   // command line 
+			NULL,          // process security attributes 
+			NULL,          // primary thread security attributes 
+			TRUE,          // handles are inherited (only those in inherit_list)
+			EXTENDED_STARTUPINFO_PRESENT | CREATE_NO_WINDOW, // creation flags 
+			NULL,          // use parent's environment 
+			tempdirname.c_str(), // working directory: the output-directory 
+			&siStartInfo.StartupInfo,  // STARTUPINFO pointer 
+			&(rec.child_piProcInfo)
+			);  // receives PROCESS_INFORMATION 
+
+	if (siStartInfo.lpAttributeList)
+		DeleteProcThreadAttributeList(siStartInfo.lpAttributeList);
+
+	// The child has its own copies of the pipe's read-end and the logfile now.
+	// Close ours: if neroAacEnc exits early, our next WriteFile() to the pipe
+	// fails (ERROR_NO_DATA) instead of blocking forever on a full pipe.
+	CloseHandle(rec.H_pipe_aacin);
+	rec.H_pipe_aacin = NULL;
+	if (rec.FileRecord_AAClog.hfp != INVALID_HANDLE_VALUE)
+		CloseHandle(rec.FileRecord_AAClog.hfp);
+	rec.FileRecord_AAClog.hfp = NULL;
+
+	if (!bSuccess) {
+		CloseHandle(rec.H_pipe_wavout);
+		rec.H_pipe_wavout = NULL;
+		DeleteFileW(rec.FileRecord_AAClog.filename.c_str());
+		ZeroMemory(&(rec.child_piProcInfo), sizeof(PROCESS_INFORMATION));
+	}
 
-	return bSuccess;
+	return bSuccess ? true : false;
 }
 
+//
+// NVENC_wait_neroaacenc() - wait for neroAacEnc.exe to finish encoding.
+//     The caller must have closed the pipe's write-end (H_pipe_wavout) first,
+//     so that neroAacEnc sees the end of its input.
+//
+//     abort : the audio-render failed, kill neroAacEnc instead of waiting for it
+//             (its output-file is incomplete, and is deleted.)
+//
+//     Returns: true if successful
+//              false otherwise
+
 bool
 NVENC_wait_neroaacenc(
 ExportSettings *mySettings,
-const wchar_t out_aacfilename[]  // output *.AAC filename
+const wchar_t out_aacfilename[],  // output *.AAC filename
+const bool abort
 )
 {
 	bool bSuccess = true;
+	SDK_File &rec = mySettings->SDKFileRec;
+
+	if (rec.H_pipe_wavout) {
+		CloseHandle(rec.H_pipe_wavout);
+		rec.H_pipe_wavout = NULL;
+	}
+
+	if (abort)
+		TerminateProcess(rec.child_piProcInfo.hProcess, exportReturn_Abort);
 
 	WaitForSingleObject(
-		mySettings->SDKFileRec.child_piProcInfo.hProcess,
+		rec.child_piProcInfo.hProcess,
 		INFINITE
 		);
 
-	CloseHandle(mySettings->SDKFileRec.H_pipe_aacin);
-	CloseHandle(mySettings->SDKFileRec.H_pipe_wavout);
-	CloseHandle(mySettings->SDKFileRec.FileRecord_AAClog.hfp);
-	mySettings->SDKFileRec.H_pipe_aacin = NULL;
-	mySettings->SDKFileRec.H_pipe_wavout = NULL;
-
-	DWORD dw;
-	GetExitCodeProcess(mySettings->SDKFileRec.child_piProcInfo.hProcess, &dw);
+	DWORD dw = 0;
+	GetExitCodeProcess(rec.child_piProcInfo.hProcess, &dw);
+	CloseHandle(rec.child_piProcInfo.hThread);
+	CloseHandle(rec.child_piProcInfo.hProcess);
+	ZeroMemory(&(rec.child_piProcInfo), sizeof(PROCESS_INFORMATION));
 
-	if (dw == 0) {
+	if (abort) {
+		bSuccess = false;
+		DeleteFileW(out_aacfilename);
+		DeleteFileW(rec.FileRecord_AAClog.filename.c_str());
+	}
+	else if (dw == 0) {
 		// neroAacEnc succeeded: no need to keep the logfile so delete it
-		DeleteFileW(mySettings->SDKFileRec.FileRecord_AAClog.filename.c_str());
+		DeleteFileW(rec.FileRecord_AAClog.filename.c_str());
 	}
 	else {
-		// neroAacEnc failed, append an error message
+		// neroAacEnc failed, append an error message (keep the logfile for the user)
 		bSuccess = false;
 		FILE *fp = _wfopen(
-			mySettings->SDKFileRec.FileRecord_AAClog.filename.c_str(),
-			L"r+"
+			rec.FileRecord_AAClog.filename.c_str(),
+			L"a"
 			);
 
-		fprintf(fp, "nvenc_export ERROR: process exited with %0u (0x%0X)\n",
-			dw, dw);
-		fclose(fp);
+		if (fp) {
+			fprintf(fp, "nvenc_export ERROR: process exited with %0u (0x%0X)\n",
+				dw, dw);
+			fclose(fp);
+		}
 	}
 
 	// now verify the output file really exists
-	FILE *fp = _wfopen(
-		out_aacfilename,
-		L"rb"
-		);
-	if (fp == NULL)
-		bSuccess = false; // can't find the file, something went wrong!
-	else
-		fclose(fp);
+	if (bSuccess) {
+		FILE *fp = _wfopen(
+			out_aacfilename,
+			L"rb"
+			);
+		if (fp == NULL)
+			bSuccess = false; // can't find the file, something went wrong!
+		else
+			fclose(fp);
+	}
 
 	return bSuccess;
 }
 
+//
+// NVENC_create_neroaac_pipe() - create the anonymous pipe between nvenc_export's
+//     WAV-writer (H_pipe_wavout) and the stdin of neroAacEnc (H_pipe_aacin.)
+//
+//     Only the read-end is inheritable (it becomes the child's stdin); the write-end
+//     must stay private, or the child would hold its own input open and never see EOF.
 
 BOOL
 NVENC_create_neroaac_pipe(
 ExportSettings *lRec
 )
 {
-	bool success = true;
+	BOOL success;
 	SECURITY_ATTRIBUTES saAttr;
 
-	printf("\n->Start of parent execution.\n");
-
 	// Set the bInheritHandle flag so pipe handles are inherited. 
 
 	saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
 	saAttr.bInheritHandle = TRUE;
 	saAttr.lpSecurityDescriptor = NULL;
 
-	// Create a pipe for the child process's STDOUT. 
-	lRec->SDKFileRec.H_pipe_aacin = 0;
-	lRec->SDKFileRec.H_pipe_wavout = 0;
+	lRec->SDKFileRec.H_pipe_aacin = NULL;
+	lRec->SDKFileRec.H_pipe_wavout = NULL;
 
 	success = CreatePipe(
 		&(lRec->SDKFileRec.H_pipe_aacin),  // PIPE-output (read by neroAacEnc process)
 		&(lRec->SDKFileRec.H_pipe_wavout), // PIPE-input (written by nvenc_export WAVwriter)
 		&saAttr,
-		0
+		NEROAAC_PIPE_SIZE
 		);
 
+	// Ensure the write handle to the pipe is not inherited.
+	if (success)
+		success = SetHandleInformation(lRec->SDKFileRec.H_pipe_wavout, HANDLE_FLAG_INHERIT, 0);
+
 	if (!success) {
 		if (lRec->SDKFileRec.H_pipe_aacin)
 			CloseHandle(lRec->SDKFileRec.H_pipe_aacin);
 		if (lRec->SDKFileRec.H_pipe_wavout)
 			CloseHandle(lRec->SDKFileRec.H_pipe_wavout);
-
-		return success;
+		lRec->SDKFileRec.H_pipe_aacin = NULL;
+		lRec->SDKFileRec.H_pipe_wavout = NULL;
 	}
 
-	// Ensure the read handle to the pipe for STDOUT is not inherited.
-	if (!SetHandleInformation(lRec->SDKFileRec.H_pipe_wavout, HANDLE_FLAG_INHERIT, 0))
-		return false;
-
-	if (!SetHandleInformation(lRec->SDKFileRec.H_pipe_aacin, HANDLE_FLAG_INHERIT, 0))
-		return false;
-
-	return true;
+	return success;
 }
 
 void calculateAudioRequest(
@@ -946,9 +1056,9 @@ prMALError RenderAndWriteAllAudio(
 	csSDK_int32					audioBufferSizeL = 0,
 		samplesRequestedL = 0,
 		audioChannelsL = 0;
-	float *						audioBufferFloat[6] = { NULL, NULL, NULL, NULL, NULL, NULL };
-	short *						audioBuffer16bit = NULL;
-	__m128i *					audioBuffer16bit_aligned_sse2 = NULL;
+	float *						audioBufferFloat[WAV_MAX_CHANNELS] = { NULL };
+	char *						audioBufferWav = NULL; // interleaved WAV-audio
+	const uint32_t				sampleBytes = get_wav_sample_bytes(NVENC_WAV_SAMPLE_FORMAT);
 	csSDK_uint32				bytesToWriteLu = 0;
 
 	PrSDKMemoryManagerSuite	*memorySuite = mySettings->memorySuite;
@@ -962,15 +1072,12 @@ prMALError RenderAndWriteAllAudio(
 	paramSuite->GetParamValue(exID, 0, ADBEAudioRatePerSecond, &sampleRate);
 	paramSuite->GetParamValue(exID, 0, ADBEAudioNumChannels, &channelType);
 	audioChannelsL = GetNumberOfAudioChannels(channelType.value.intValue);
+	const wav_channel_layout_t *layout = get_wav_channel_layout(channelType.value.intValue);
 
 	// get the #audio-channels from the export-source
 	exportInfoSuite->GetExportSourceInfo(exID,
 		kExportInfo_AudioChannelsType,
 		&srcChannelType);
-	// kludge - TODO we don't support 16-channel audio,
-	//          so switch 16-channel to 5.1 audio
-	if (srcChannelType.mInt32 >= kPrAudioChannelType_16Channel)
-		srcChannelType.mInt32 = kPrAudioChannelType_51;
 
 	//	bool audioformat_incompatible = 
 	//	 ( srcChannelType.mInt32 == kPrAudioChannelType_51 && (audioChannelsL > 6)) ||
@@ -986,7 +1093,7 @@ prMALError RenderAndWriteAllAudio(
 		(float)sampleRate.value.floatValue,
 		&audioRenderID);
 
-	bool audioformat_incompatible = (serr == suiteError_NoError) ? false : true;
+	bool audioformat_incompatible = (serr == suiteError_NoError && layout != NULL) ? false : true;
 
 	totalAudioSamples = exportDuration / ticksPerSample;
 	samplesRemaining = totalAudioSamples;
@@ -1040,12 +1147,7 @@ prMALError RenderAndWriteAllAudio(
 	audioBufferSizeL = samplesRequestedL;
 
 	// Allocate audio buffers
-	audioBuffer16bit = (short *)memorySuite->NewPtr(4 * sizeof(__m128i) + audioChannelsL * audioBufferSizeL * sizeof(short));
-
-	// Align the buffer to a 16-byte boundary (for SSE2/3)
-	audioBuffer16bit_aligned_sse2 = reinterpret_cast<__m128i *>(
-		reinterpret_cast<uint64_t>(audioBuffer16bit + 7) - (reinterpret_cast<uint64_t>(audioBuffer16bit + 7) & 15)
-		);
+	audioBufferWav = memorySuite->NewPtr(audioChannelsL * audioBufferSizeL * sampleBytes);
 
 	for (csSDK_int32 bufferIndexL = 0; bufferIndexL < audioChannelsL; bufferIndexL++)
 	{
@@ -1055,6 +1157,12 @@ prMALError RenderAndWriteAllAudio(
 	uint64_t samples_since_update = 0;
 	while (samplesRemaining && (resultS == malNoError))
 	{
+		// Concurrent export: the video failed (or was aborted), stop now
+		if (mySettings->export_cancel) {
+			resultS = exportReturn_Abort;
+			break;
+		}
+
 		// Fill the buffer with audio
 		resultS = mySettings->sequenceAudioSuite->GetAudio(audioRenderID,
 			(csSDK_uint32)samplesRequestedL,
@@ -1063,27 +1171,24 @@ prMALError RenderAndWriteAllAudio(
 
 		if (resultS == malNoError)
 		{
-			// convert the 32-bit float audio -> 16-bit int audio
-			mySettings->audioSuite->ConvertAndInterleaveTo16BitInteger(
+			// convert the 32-bit float audio -> WAV audio, and
+			// remap the channel-order: Adobe -> RIFF-WAV  (in a single pass)
+			adobe2wav_interleave_sse2(
 				audioBufferFloat,
-				reinterpret_cast<short *>(audioBuffer16bit_aligned_sse2),
-				audioChannelsL,
-				samplesRequestedL
+				*layout,
+				NVENC_WAV_SAMPLE_FORMAT,
+				samplesRequestedL,
+				audioBufferWav
 				);
-
-			// remap the channel-order: Adobe -> RIFF-WAV
-			// (Note, this routine requires processor-support for SSSE3 instructions)
-			if (audioChannelsL > 2)
-				adobe2wav_audio51_swap_ssse3(samplesRequestedL, audioBuffer16bit_aligned_sse2);
-			bytesToWriteLu = audioChannelsL * samplesRequestedL * 2;
+			bytesToWriteLu = audioChannelsL * samplesRequestedL * sampleBytes;
 
 			// Write out the buffer of audio retrieved
 			//resultS = mySettings->exportFileSuite->Write(	exportInfoP->fileObject,
-			//												reinterpret_cast<void*>(audioBuffer16bit),
+			//												reinterpret_cast<void*>(audioBufferWav),
 			//												(csSDK_int32) bytesToWriteLu);
 			/*
 			size_t bytes_written = fwrite(
-			reinterpret_cast<void*>(audioBuffer16bit_aligned_sse2),
+			reinterpret_cast<void*>(audioBufferWav),
 			sizeof(uint8_t),
 			bytesToWriteLu,
 			mySettings->SDKFileRec.FileRecord_Audio.fp
@@ -1092,7 +1197,7 @@ prMALError RenderAndWriteAllAudio(
 			DWORD bytes_written = 0;
 			BOOL wfrc = WriteFile(
 				mySettings->SDKFileRec.FileRecord_Audio.hfp,
-				reinterpret_cast<void*>(audioBuffer16bit_aligned_sse2),
+				reinterpret_cast<void*>(audioBufferWav),
 				bytesToWriteLu,
 				&bytes_written,
 				NULL // not overlapped
@@ -1129,9 +1234,13 @@ prMALError RenderAndWriteAllAudio(
 
 		if (samples_since_update >= 500000) {
 			samples_since_update -= 500000;
-			mySettings->exportProgressSuite->UpdateProgressPercent(exID,
-				static_cast<float>(totalAudioSamples - samplesRemaining) / totalAudioSamples
-				);
+			const float audio_done = static_cast<float>(totalAudioSamples - samplesRemaining) / totalAudioSamples;
+
+			// Concurrent export: the video-thread owns the progress-bar, just post our progress
+			if (mySettings->audio_concurrent)
+				InterlockedExchange(&mySettings->audio_progress_permille, static_cast<LONG>(audio_done * 1000));
+			else
+				mySettings->exportProgressSuite->UpdateProgressPercent(exID, audio_done);
 			/*
 			if (result == suiteError_ExporterSuspended)
 			{
@@ -1150,7 +1259,7 @@ prMALError RenderAndWriteAllAudio(
 	} // while
 
 	// Free up audioBuffers
-	memorySuite->PrDisposePtr((char *)audioBuffer16bit);
+	memorySuite->PrDisposePtr(audioBufferWav);
 	for (csSDK_int32 bufferIndexL = 0; bufferIndexL < audioChannelsL; bufferIndexL++)
 		memorySuite->PrDisposePtr((char *)audioBufferFloat[bufferIndexL]);
 
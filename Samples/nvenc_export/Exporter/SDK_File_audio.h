@@ -20,7 +20,8 @@ bool NVENC_run_neroaacenc(
 	const wchar_t out_aacfilename[]
 );
 
-// for "PIPE-mode": not currently used
+// "PIPE-mode": the WAV-audio is streamed straight into neroAacEnc (no WAV tempfile)
+//
 // NVENC_spawn_neroaacenc() - create's a background process that
 //     executes NeroAacEnc.exe with <stdin> input (from pipe)
 bool NVENC_spawn_neroaacenc(
@@ -29,21 +30,60 @@ bool NVENC_spawn_neroaacenc(
 	const wchar_t out_aacfilename[]  // output *.AAC filename
 );
 
-// for "PIPE-mode": not currently used
 // NVENC_wait_neroaacenc() wait for completion of the process
-// spawned by NVENC_spawn_neroaacenc()
+// spawned by NVENC_spawn_neroaacenc()  (abort: kill it instead)
 bool NVENC_wait_neroaacenc(
 	ExportSettings *mySettings,
-	const wchar_t out_aacfilename[]
+	const wchar_t out_aacfilename[],
+	const bool abort
 );
 
-// for "PIPE-mode": not currently used
+// NVENC_create_neroaac_pipe()
 //    Create the link between the WAV-audio writer (output) and 
 //    stdin of the neroaacenc shell-session. 
 BOOL NVENC_create_neroaac_pipe(ExportSettings *lRec);
 
+// size of the pipe's buffer (bytes): ~2 seconds of 48KHz 5.1 audio, so the
+// audio-renderer and neroAacEnc don't ping-pong on every 4KB (the default size)
+#define NEROAAC_PIPE_SIZE (1 << 20)
+
 csSDK_int32 GetNumberOfAudioChannels(csSDK_int32 audioChannelType);
 
+///////////////////////////////////////////////////////////////////////////////
+// Adobe planar-float audio -> interleaved RIFF-WAV audio
+
+#define WAV_MAX_CHANNELS 16 // kPrAudioChannelType_16Channel
+
+typedef enum _wav_sample_format_t {
+	WAV_SAMPLE_INT16   = 0,
+	WAV_SAMPLE_INT24   = 1,
+	WAV_SAMPLE_FLOAT32 = 2
+} wav_sample_format_t;
+
+// The exported WAV-audio (also read back by the MP4/TS/MKV muxers and neroAacEnc)
+#define NVENC_WAV_SAMPLE_FORMAT WAV_SAMPLE_INT16
+
+typedef struct _wav_channel_layout_t {
+	csSDK_int32 audio_channel_type;      // kPrAudioChannelType_*
+	uint32_t    num_channels;
+	uint32_t    channel_mask;            // WAVEFORMATEXTENSIBLE::dwChannelMask (0 = discrete channels)
+	uint8_t     remap[WAV_MAX_CHANNELS]; // remap[WAV channel#] = Adobe channel#
+} wav_channel_layout_t;
+
+// returns NULL if the channel-type is not supported
+const wav_channel_layout_t *get_wav_channel_layout(const csSDK_int32 audioChannelType);
+
+uint32_t get_wav_sample_bytes(const wav_sample_format_t format);
+
+// convert, interleave and reorder (Adobe -> WAV) in one pass.  (requires SSE2)
+void adobe2wav_interleave_sse2(
+	const float * const src[],
+	const wav_channel_layout_t &layout,
+	const wav_sample_format_t format,
+	const uint32_t numSamples,
+	void *dst
+);
+
 ///////////////////////////////////////////////////////////////////////////////
 // Audio import-related calls
 
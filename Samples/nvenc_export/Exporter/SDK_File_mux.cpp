@@ -8,279 +8,337 @@
 #include <cstdio>
 
 //
-// NVENC_mux_m2t() - multiplex the Audio/Video file(s) into a MPEG-2 
-//                   transport bitstream by calling the third-party
-//                   program "TSMUXER.EXE"
+// NVENC_open_m2t() - create the output *.TS file and attach the built-in transport-stream muxer.
+//                    While mySettings->p_TsWriter is open, fwrite_callback() passes
+//                    the encoded video straight to the muxer (no intermediate *.m4v file.)
+//
+//   The audio must already be rendered (FileRecord_Audio): the muxer reads it back
+//   frame by frame, and interleaves it with the video as the encoder produces it.
 //
 BOOL
-NVENC_mux_m2t(
-	const csSDK_uint32 exporterPluginID, // used to generate a unique tempfilename
-	const prUTF16Char muxpath[], // filepath to TSMUXER.EXE
+NVENC_open_m2t(
 	const prUTF16Char outpath[], // output file path
 	ExportSettings * const mySettings,
 	const csSDK_int32 audioCodec
 ) {
-	//ExportSettings *mySettings = reinterpret_cast<ExportSettings*>(exportInfoP->privateData);
-	wstring metafilename; // name of the control-file (*.meta) to operate TSMUXER.EXE
-	wstring shellargs;    // command-line shell arguments
-	wstring tempdirname;  // temporary-directory
-
-	// Set FileRecord_Audio.filename to the *actual* outputfile path: 'XXX.M2T'
-	//	nvenc_make_output_filename( outpath, SDK_FILE_EXTENSION_M2T, mySettings->SDKFileRec.FileRecord_AV.filename );
+	// Set FileRecord_AV.filename to the *actual* outputfile path: 'XXX.TS'
 	nvenc_make_output_filename(
 		outpath,
-		L"", // no postfix
-		L"ts", // extension
+		L"", // no postfix (since this is the *final* output file)
+		SDK_FILE_EXTENSION_M2T,
 		mySettings->SDKFileRec.FileRecord_AV.filename
 	);
 
-	// create a '.meta' file for controlling TSMUXER
-	{
-		wostringstream postfix; // filename postfix (unique tempID)
-		postfix << "_temp_" << std::dec << exporterPluginID;
-
-		nvenc_make_output_filename(
-			outpath,
-			postfix.str(),
-			L"meta",
-			metafilename
-			);
-		nvenc_make_output_dirname(outpath, tempdirname);
-	}
+	// Just in case the output-file already exists, delete it
+	DeleteFileW(mySettings->SDKFileRec.FileRecord_AV.filename.c_str());
 
-	wofstream metafile;
-	metafile.open(metafilename, ios::out | ios::trunc);
-	metafile << "MUXOPT --no-pcr-on-video-pid --new-audio-pes --vbr --vbv-len=500 ";
-	metafile << endl;
-
-	if (mySettings->SDKFileRec.hasVideo) {
-		double frameRate = mySettings->NvEncodeConfig.frameRateNum;
-		frameRate /= mySettings->NvEncodeConfig.frameRateDen;
-		switch (mySettings->NvEncodeConfig.codec) {
-		case NV_ENC_H264: metafile << "V_MPEG4/ISO/AVC, "; // H.264
-			break;
-		case NV_ENC_H265: metafile << "V_MPEGH/ISO/HEVC, ";// H.265
-			break;
-		default:          metafile << "V_MPEG4/ISO/AVC, "; // assume H.264
-			break;
+	mySettings->SDKFileRec.FileRecord_AV.fp = _wfopen(
+		mySettings->SDKFileRec.FileRecord_AV.filename.c_str(),
+		L"wb"
+	);
+	if ( mySettings->SDKFileRec.FileRecord_AV.fp == NULL )
+		return FALSE;
+
+	// the muxer writes one 188-byte packet at a time, use a bigger stdio buffer
+	setvbuf( mySettings->SDKFileRec.FileRecord_AV.fp, NULL, _IOFBF, 1 << 20 );
+
+	// Peak bitrate of the video (for the PCR-pacing): constQP has none
+	const EncodeConfig &config = mySettings->NvEncodeConfig;
+	uint32_t maxBitRate = 0;
+	if ( mySettings->SDKFileRec.hasVideo ) {
+		switch( config.rateControl ) {
+			case NV_ENC_PARAMS_RC_CONSTQP:
+				maxBitRate = 0;
+				break;
+			case NV_ENC_PARAMS_RC_CBR:
+				maxBitRate = config.avgBitRate;
+				break;
+			default: // VBR-modes
+				maxBitRate = (config.peakBitRate > config.avgBitRate) ? config.peakBitRate : config.avgBitRate;
+				break;
 		}
-		metafile << "\"" << mySettings->SDKFileRec.FileRecord_Video.filename << "\"";
-		metafile << ", fps=";
-
-		// Configure floating-point output to print up to 5-digits after decimal (.1234)
-		metafile.setf(std::ios::fixed, std::ios::floatfield);
-		metafile.precision(4);
-		metafile << frameRate;
-		metafile << L", insertSEI, contSPS, ar=As source ";
-		metafile << endl;
 	}
 
-	if (mySettings->SDKFileRec.hasAudio) {
-		if (audioCodec == ADBEAudioCodec_PCM)
-			metafile << "A_LPCM, ";
-		else if (audioCodec == ADBEAudioCodec_AAC)
-			metafile << "A_AAC, ";
-		else
-			metafile << "A_LPCM, "; // unknown, default
-		metafile << "\"" << mySettings->SDKFileRec.FileRecord_Audio.filename << "\"";
-
-		// For AAC-audio, neroAacEnc gave us an M4A file (AAC-bitstream wrapped in MP4 file)
-		//    select the correct audiotrack, which is assumed to be track#1
-		if (audioCodec == ADBEAudioCodec_AAC)
-			metafile << ", track=1"; // audiotrack#1 of the M4A file
-
-		metafile << endl;
+	mySettings->p_TsWriter = new CTsWriter();
+	BOOL ok = mySettings->p_TsWriter->Open(
+		mySettings->SDKFileRec.FileRecord_AV.fp,
+		!mySettings->SDKFileRec.hasVideo ? TS_VIDEO_NONE :
+			((config.codec == NV_ENC_H265) ? TS_VIDEO_HEVC : TS_VIDEO_AVC),
+		config.frameRateNum,
+		config.frameRateDen,
+		maxBitRate,
+		config.vbvBufferSize,
+		config.numBFrames    // B-frames are sent (at most) numBFrames frames ahead of their display-time
+	);
+
+	// Audio was rendered to a tempfile (*.wav or *.m4a), attach it
+	if ( ok && mySettings->SDKFileRec.hasAudio ) {
+		mySettings->SDKFileRec.FileRecord_Audio.fp = _wfopen( mySettings->SDKFileRec.FileRecord_Audio.filename.c_str(), L"rb" );
+		ok = (mySettings->SDKFileRec.FileRecord_Audio.fp != NULL);
+		if ( ok )
+			ok = (audioCodec == ADBEAudioCodec_AAC) ?
+				mySettings->p_TsWriter->AddAacTrack( mySettings->SDKFileRec.FileRecord_Audio.fp ) :
+				mySettings->p_TsWriter->AddPcmTrack( mySettings->SDKFileRec.FileRecord_Audio.fp );
 	}
 
-	// finalize the metafile
-	metafile.close();
+	if ( !ok )
+		NVENC_close_m2t(mySettings);
 
-	// Just in case the output-file already exists, delete it
-	DeleteFileW(mySettings->SDKFileRec.FileRecord_AV.filename.c_str());
+	return ok;
+}
 
-	shellargs = L"\"";
-	shellargs += metafilename;
-	shellargs += L"\"";
-	shellargs += L" ";
-	shellargs += L"\"";
-	shellargs += mySettings->SDKFileRec.FileRecord_AV.filename;
-	shellargs += L"\"";
-
-	SHELLEXECUTEINFOW ShExecInfo = { 0 };
-	ShExecInfo.cbSize = sizeof(ShExecInfo);
-	ShExecInfo.fMask = SEE_MASK_NOCLOSEPROCESS;
-	ShExecInfo.hwnd = NULL;
-	ShExecInfo.lpVerb = NULL;
-	ShExecInfo.lpFile = muxpath;// TargetFile to execute/open
-	ShExecInfo.lpParameters = shellargs.c_str();
-	ShExecInfo.lpDirectory = tempdirname.c_str();
-	ShExecInfo.nShow = SW_SHOWNORMAL; // SW_SHOW;
-	ShExecInfo.hInstApp = NULL;
-
-	// Now launch the external-program: TSMUXER.EXE
-	BOOL rc = ShellExecuteExW(&ShExecInfo);
-
-	// If shellexec was successful, then 
-	//		wait for TSMUXER.exe to finish (could take a while...)
-	if (rc) {
-		WaitForSingleObject(ShExecInfo.hProcess, INFINITE);
-		DeleteFileW(metafilename.c_str());
-	}
+//
+// NVENC_mux_m2t() - finish the transport stream started by NVENC_open_m2t():
+//                   write out the audio which remains after the end of the video
+//
+BOOL
+NVENC_mux_m2t(
+	ExportSettings * const mySettings
+) {
+	CTsWriter *const ts = mySettings->p_TsWriter;
+	if ( ts == NULL || !ts->IsOpen() )
+		return FALSE;
+
+	const bool ok = ts->Close();
+
+	NVENC_close_m2t(mySettings);
 
 	// done with TS-muxing!
-	return rc;
+	return ok ? TRUE : FALSE;
 }
 
 //
-// NVENC_mux_mp4() - multiplex the Audio/Video file(s) into a MPEG-4 stream by 
-//                   calling an the third-party program "MP4BOX.EXE"
+// NVENC_close_m2t() - detach the built-in TS muxer, close the output file and the audio input-file
+//                     (if the muxer wasn't finished by NVENC_mux_m2t(), the file is left incomplete)
 //
+void
+NVENC_close_m2t(
+	ExportSettings * const mySettings
+) {
+	if ( mySettings->p_TsWriter ) {
+		delete mySettings->p_TsWriter;
+		mySettings->p_TsWriter = NULL;
+	}
+
+	if ( mySettings->SDKFileRec.FileRecord_AV.fp ) {
+		fclose( mySettings->SDKFileRec.FileRecord_AV.fp );
+		mySettings->SDKFileRec.FileRecord_AV.fp = NULL;
+	}
 
+	if ( mySettings->SDKFileRec.FileRecord_Audio.fp ) {
+		fclose( mySettings->SDKFileRec.FileRecord_Audio.fp );
+		mySettings->SDKFileRec.FileRecord_Audio.fp = NULL;
+	}
+}
+
+//
+// NVENC_open_mp4() - create the output *.MP4 file and attach the built-in MP4 muxer.
+//                    While mySettings->p_Mp4Writer is open, fwrite_callback() passes
+//                    the encoded video straight to the muxer (no intermediate *.264 file.)
+//
 BOOL
-NVENC_mux_mp4(
-	const csSDK_uint32 exporterPluginID, // used to generate a unique tempfilename
-	const prUTF16Char muxpath[], // filepath to MP4BOX.EXE
+NVENC_open_mp4(
 	const prUTF16Char outpath[], // output file path
-	ExportSettings * const mySettings
+	ExportSettings * const mySettings,
+	const bool fragmented
 ) {
-	wstring metafilename; // name of the control-file (*.meta) to operate MP4BOX.EXE
-	wstring shellargs;    // command-line shell arguments
-	wstring tempdirname;  // temporary dir for MP4BOX
-
-	// Set FileRecord_Audio.filename to the *actual* outputfile path: 'XXX.MP4'
-	//	nvenc_make_output_filename( outpath, SDK_FILE_EXTENSION_MP4, mySettings->SDKFileRec.FileRecord_AV.filename );
+	// Set FileRecord_AV.filename to the *actual* outputfile path: 'XXX.MP4'
 	nvenc_make_output_filename(
 		outpath,
 		L"",		// no postfix (since this is the *final* output file)
-		L"mp4",		// mpeg-4 extension
+		SDK_FILE_EXTENSION_MP4,
 		mySettings->SDKFileRec.FileRecord_AV.filename
 		);
-	nvenc_make_output_dirname(outpath, tempdirname);
-
-	if (mySettings->SDKFileRec.hasVideo) {
-		shellargs += L" ";
-		shellargs += L"-add \"";
-		shellargs += mySettings->SDKFileRec.FileRecord_Video.filename;
-		shellargs += L"\"";
-		shellargs += L" ";
-	}
 
-	if (mySettings->SDKFileRec.hasAudio) {
-		shellargs += L" ";
-		shellargs += L"-add \"";
-		shellargs += mySettings->SDKFileRec.FileRecord_Audio.filename;
-		shellargs += L"\"";
-		shellargs += L" ";
+	// Just in case the output-file already exists, delete it
+	DeleteFileW(mySettings->SDKFileRec.FileRecord_AV.filename.c_str());
+
+	mySettings->SDKFileRec.FileRecord_AV.fp = _wfopen(
+		mySettings->SDKFileRec.FileRecord_AV.filename.c_str(),
+		L"wb"
+	);
+	if ( mySettings->SDKFileRec.FileRecord_AV.fp == NULL )
+		return FALSE;
+
+	// the muxer writes large sequential blocks (whole access-units), use a bigger stdio buffer
+	setvbuf( mySettings->SDKFileRec.FileRecord_AV.fp, NULL, _IOFBF, 1 << 20 );
+
+	const EncodeConfig &config = mySettings->NvEncodeConfig;
+	mySettings->p_Mp4Writer = new CMp4Writer();
+	if ( !mySettings->p_Mp4Writer->Open(
+			mySettings->SDKFileRec.FileRecord_AV.fp,
+			(config.codec == NV_ENC_H265) ? MP4_VIDEO_HEVC : MP4_VIDEO_AVC,
+			config.width,
+			config.height,
+			config.frameRateNum,
+			config.frameRateDen,
+			fragmented) )
+	{
+		NVENC_close_mp4(mySettings);
+		return FALSE;
 	}
 
-	// Specify a temporary directory (use the output-file's dir)
-	shellargs += L" ";
-	shellargs += L"-tmp \"";
-	shellargs += tempdirname;
-	shellargs += L"\" ";
+	return TRUE;
+}
 
-	// Now add the output filepath
-	shellargs += L" ";
-	shellargs += L"\"";
-	shellargs += mySettings->SDKFileRec.FileRecord_AV.filename;
-	shellargs += L"\"";
+//
+// NVENC_mux_mp4() - finish the MPEG-4 file started by NVENC_open_mp4():
+//                   copy the (optional) audio into the file, then write the 'moov'
+//
+BOOL
+NVENC_mux_mp4(
+	ExportSettings * const mySettings,
+	const csSDK_int32 audioCodec
+) {
+	CMp4Writer *const mp4 = mySettings->p_Mp4Writer;
+	if ( mp4 == NULL || !mp4->IsOpen() )
+		return FALSE;
+
+	bool ok = true;
+
+	// Audio was rendered to a tempfile (*.wav or *.m4a), append it as the 2nd track
+	if (mySettings->SDKFileRec.hasAudio && !mp4->IsFragmented()) {
+		FILE *fp_audio = _wfopen( mySettings->SDKFileRec.FileRecord_Audio.filename.c_str(), L"rb" );
+		ok = (fp_audio != NULL);
+		if ( ok ) {
+			ok = (audioCodec == ADBEAudioCodec_AAC) ?
+				mp4->AddAacTrack( fp_audio ) :
+				mp4->AddPcmTrack( fp_audio );
+			fclose( fp_audio );
+		}
+	}
 
-	// Just in case the output-file already exists, delete it
-	DeleteFileW(mySettings->SDKFileRec.FileRecord_AV.filename.c_str());
+	if ( !mp4->Close() )
+		ok = false;
 
-	SHELLEXECUTEINFOW ShExecInfo = { 0 };
-	ShExecInfo.cbSize = sizeof(ShExecInfo);
-	ShExecInfo.fMask = SEE_MASK_NOCLOSEPROCESS;
-	ShExecInfo.hwnd = NULL;
-	ShExecInfo.lpVerb = NULL;
-	ShExecInfo.lpFile = muxpath;// TargetFile to execute/open
-	ShExecInfo.lpParameters = shellargs.c_str();
-	ShExecInfo.lpDirectory = tempdirname.c_str();
-	ShExecInfo.nShow = SW_SHOWNORMAL; // SW_SHOW;
-	ShExecInfo.hInstApp = NULL;
-
-	// Now launch the external-program: MP4BOX.EXE
-	BOOL rc = ShellExecuteExW(&ShExecInfo);
-
-	// If shellexec was successful, then 
-	//		wait for MP4BOX.exe to finish (could take a while...)
-	if (rc)
-		WaitForSingleObject(ShExecInfo.hProcess, INFINITE);
+	NVENC_close_mp4(mySettings);
 
 	// done with MP4-muxing!
-	return rc;
+	return ok ? TRUE : FALSE;
 }
 
-// NVENC_mux_mkv() - multiplex the Audio/Video file(s) into a Matroska (MKV) file by 
-//                   calling an the third-party program "MKVMERGE.EXE"
+//
+// NVENC_close_mp4() - detach the built-in MP4 muxer and close the output file
+//                     (if the muxer wasn't finished by NVENC_mux_mp4(), the file is left incomplete)
+//
+void
+NVENC_close_mp4(
+	ExportSettings * const mySettings
+) {
+	if ( mySettings->p_Mp4Writer ) {
+		delete mySettings->p_Mp4Writer;
+		mySettings->p_Mp4Writer = NULL;
+	}
+
+	if ( mySettings->SDKFileRec.FileRecord_AV.fp ) {
+		fclose( mySettings->SDKFileRec.FileRecord_AV.fp );
+		mySettings->SDKFileRec.FileRecord_AV.fp = NULL;
+	}
+}
+
+//
+// NVENC_open_mkv() - create the output *.MKV file and attach the built-in Matroska muxer.
+//                    While mySettings->p_MkvWriter is open, fwrite_callback() passes
+//                    the encoded video straight to the muxer (no intermediate *.264 file.)
+//
+//   The audio must already be rendered (FileRecord_Audio): the muxer reads it back
+//   frame by frame, and interleaves it with the video clusters.
+//
 BOOL
-NVENC_mux_mkv(
-	const csSDK_uint32 exporterPluginID, // used to generate a unique tempfilename
-	const prUTF16Char muxpath[], // filepath to MKVMERGE.EXE
+NVENC_open_mkv(
 	const prUTF16Char outpath[], // output file path
-	ExportSettings * const mySettings
-)
-{
-	wstring metafilename; // name of the control-file (*.meta) to operate TSMUXER.EXE
-	wstring shellargs;    // command-line shell arguments
-	wstring tempdirname;  // temporary dir for MKVMERGE
-
-	// Set FileRecord_Audio.filename to the *actual* outputfile path: 'XXX.MP4'
-	//	nvenc_make_output_filename( outpath, SDK_FILE_EXTENSION_MP4, mySettings->SDKFileRec.FileRecord_AV.filename );
+	ExportSettings * const mySettings,
+	const csSDK_int32 audioCodec
+) {
+	// Set FileRecord_AV.filename to the *actual* outputfile path: 'XXX.MKV'
 	nvenc_make_output_filename(
 		outpath,
-		L"",		// no postfix (since this is the *final* output file)
-		L"mkv",		// mpeg-4 extension
+		L"", // no postfix (since this is the *final* output file)
+		SDK_FILE_EXTENSION_MKV,
 		mySettings->SDKFileRec.FileRecord_AV.filename
-		);
-	nvenc_make_output_dirname(outpath, tempdirname);
-
-	// First, add the output filepath
-	shellargs += L" -o ";
-	shellargs += L"\"";
-	shellargs += mySettings->SDKFileRec.FileRecord_AV.filename;
-	shellargs += L"\"";
-
-	// If required, add the video bitstream
-	if (mySettings->SDKFileRec.hasVideo) {
-		shellargs += L" ";
-		shellargs += L"\"";
-		shellargs += mySettings->SDKFileRec.FileRecord_Video.filename;
-		shellargs += L"\"";
-		shellargs += L" ";
-	}
-
-	// If required, add the audio bitstream
-	if (mySettings->SDKFileRec.hasAudio) {
-		shellargs += L" ";
-		shellargs += L"\"";
-		shellargs += mySettings->SDKFileRec.FileRecord_Audio.filename;
-		shellargs += L"\"";
-		shellargs += L" ";
-	}
+	);
 
 	// Just in case the output-file already exists, delete it
 	DeleteFileW(mySettings->SDKFileRec.FileRecord_AV.filename.c_str());
 
-	SHELLEXECUTEINFOW ShExecInfo = { 0 };
-	ShExecInfo.cbSize = sizeof(ShExecInfo);
-	ShExecInfo.fMask = SEE_MASK_NOCLOSEPROCESS;
-	ShExecInfo.hwnd = NULL;
-	ShExecInfo.lpVerb = NULL;
-	ShExecInfo.lpFile = muxpath;// TargetFile to execute/open
-	ShExecInfo.lpParameters = shellargs.c_str();
-	ShExecInfo.lpDirectory = tempdirname.c_str();
-	ShExecInfo.nShow = SW_SHOWNORMAL; // SW_SHOW;
-	ShExecInfo.hInstApp = NULL;
-
-	// Now launch the external-program: MP4BOX.EXE
-	BOOL rc = ShellExecuteExW(&ShExecInfo);
-
-	// If shellexec was successful, then 
-	//		wait for MP4BOX.exe to finish (could take a while...)
-	if (rc)
-		WaitForSingleObject(ShExecInfo.hProcess, INFINITE);
+	mySettings->SDKFileRec.FileRecord_AV.fp = _wfopen(
+		mySettings->SDKFileRec.FileRecord_AV.filename.c_str(),
+		L"wb"
+	);
+	if ( mySettings->SDKFileRec.FileRecord_AV.fp == NULL )
+		return FALSE;
+
+	// the muxer writes one block (access-unit, or audio-frame) at a time, use a bigger stdio buffer
+	setvbuf( mySettings->SDKFileRec.FileRecord_AV.fp, NULL, _IOFBF, 1 << 20 );
+
+	const EncodeConfig &config = mySettings->NvEncodeConfig;
+	mySettings->p_MkvWriter = new CMkvWriter();
+	BOOL ok = mySettings->p_MkvWriter->Open(
+		mySettings->SDKFileRec.FileRecord_AV.fp,
+		!mySettings->SDKFileRec.hasVideo ? MKV_VIDEO_NONE :
+			((config.codec == NV_ENC_H265) ? MKV_VIDEO_HEVC : MKV_VIDEO_AVC),
+		config.width,
+		config.height,
+		config.frameRateNum,
+		config.frameRateDen
+	);
+
+	// Audio was rendered to a tempfile (*.wav or *.m4a), attach it
+	if ( ok && mySettings->SDKFileRec.hasAudio ) {
+		mySettings->SDKFileRec.FileRecord_Audio.fp = _wfopen( mySettings->SDKFileRec.FileRecord_Audio.filename.c_str(), L"rb" );
+		ok = (mySettings->SDKFileRec.FileRecord_Audio.fp != NULL);
+		if ( ok )
+			ok = (audioCodec == ADBEAudioCodec_AAC) ?
+				mySettings->p_MkvWriter->AddAacTrack( mySettings->SDKFileRec.FileRecord_Audio.fp ) :
+				mySettings->p_MkvWriter->AddPcmTrack( mySettings->SDKFileRec.FileRecord_Audio.fp );
+	}
+
+	if ( !ok )
+		NVENC_close_mkv(mySettings);
 
-	// done with MP4-muxing!
-	return rc;
+	return ok;
+}
+
+//
+// NVENC_mux_mkv() - finish the Matroska file started by NVENC_open_mkv():
+//                   write out the remaining audio, the Cues, and patch the SeekHead
+//
+BOOL
+NVENC_mux_mkv(
+	ExportSettings * const mySettings
+) {
+	CMkvWriter *const mkv = mySettings->p_MkvWriter;
+	if ( mkv == NULL || !mkv->IsOpen() )
+		return FALSE;
+
+	const bool ok = mkv->Close();
+
+	NVENC_close_mkv(mySettings);
+
+	// done with MKV-muxing!
+	return ok ? TRUE : FALSE;
+}
+
+//
+// NVENC_close_mkv() - detach the built-in MKV muxer, close the output file and the audio input-file
+//                     (if the muxer wasn't finished by NVENC_mux_mkv(), the file is left incomplete)
+//
+void
+NVENC_close_mkv(
+	ExportSettings * const mySettings
+) {
+	if ( mySettings->p_MkvWriter ) {
+		delete mySettings->p_MkvWriter;
+		mySettings->p_MkvWriter = NULL;
+	}
+
+	if ( mySettings->SDKFileRec.FileRecord_AV.fp ) {
+		fclose( mySettings->SDKFileRec.FileRecord_AV.fp );
+		mySettings->SDKFileRec.FileRecord_AV.fp = NULL;
+	}
+
+	if ( mySettings->SDKFileRec.FileRecord_Audio.fp ) {
+		fclose( mySettings->SDKFileRec.FileRecord_Audio.fp );
+		mySettings->SDKFileRec.FileRecord_Audio.fp = NULL;
+	}
 }
@@ -4,36 +4,73 @@
 #include "SDK_File.h"
 
 
-// NVENC_mux_m2t() - multiplex the Audio/Video file(s) into a MPEG-2 
-//                   transport bitstream by calling the third-party
-//                   program "TSMUXER.EXE"
+// NVENC_open_m2t() - create the output *.TS file and attach the built-in
+//                    TS muxer (mySettings->p_TsWriter) to the video encoder's output
+//                    (the audio, if any, must already be rendered)
 BOOL
-NVENC_mux_m2t( 
-	const csSDK_uint32 exporterPluginID, // used to generate a unique tempfilename
-	const prUTF16Char muxpath[], // filepath to TSMUXER.EXE
+NVENC_open_m2t(
 	const prUTF16Char outpath[], // output file path
 	ExportSettings * const mySettings,
-	const csSDK_int32 audioCodec
+	const csSDK_int32 audioCodec // (if audio is present) audioFormat: *.M4A or *.WAV
 );
 
-// NVENC_mux_mp4() - multiplex the Audio/Video file(s) into a MPEG-4 stream by 
-//                   calling an the third-party program "MP4BOX.EXE"
+// NVENC_mux_m2t() - finish the MPEG-2 transport stream: write the remaining audio
+//                   and close the file
 BOOL
-NVENC_mux_mp4(
-	const csSDK_uint32 exporterPluginID, // used to generate a unique tempfilename
-	const prUTF16Char muxpath[], // filepath to MP4BOX.EXE
+NVENC_mux_m2t(
+	ExportSettings * const mySettings
+);
+
+// NVENC_close_m2t() - release the built-in TS muxer and close the output file
+void
+NVENC_close_m2t(
+	ExportSettings * const mySettings
+);
+
+// NVENC_open_mp4() - create the output *.MP4 file and attach the built-in
+//                    MP4 muxer (mySettings->p_Mp4Writer) to the video encoder's output
+BOOL
+NVENC_open_mp4(
 	const prUTF16Char outpath[], // output file path
+	ExportSettings * const mySettings,
+	const bool fragmented // write fragmented MP4 (video-only)
+);
+
+// NVENC_mux_mp4() - finish the MPEG-4 file: add the audio-track (if any),
+//                   write the 'moov' and close the file
+BOOL
+NVENC_mux_mp4(
+	ExportSettings * const mySettings,
+	const csSDK_int32 audioCodec
+);
+
+// NVENC_close_mp4() - release the built-in MP4 muxer and close the output file
+void
+NVENC_close_mp4(
 	ExportSettings * const mySettings
 );
 
-// NVENC_mux_mkv() - multiplex the Audio/Video file(s) into a Matroska (MKV) file by 
-//                   calling an the third-party program "MKVMERGE.EXE"
+// NVENC_open_mkv() - create the output *.MKV file and attach the built-in
+//                    Matroska muxer (mySettings->p_MkvWriter) to the video encoder's output
+//                    (the audio, if any, must already be rendered)
+BOOL
+NVENC_open_mkv(
+	const prUTF16Char outpath[], // output file path
+	ExportSettings * const mySettings,
+	const csSDK_int32 audioCodec // (if audio is present) audioFormat: *.M4A or *.WAV
+);
+
+// NVENC_mux_mkv() - finish the Matroska file: write the remaining audio, the Cues,
+//                   the SeekHead, and close the file
 BOOL
 NVENC_mux_mkv(
-const csSDK_uint32 exporterPluginID, // used to generate a unique tempfilename
-const prUTF16Char muxpath[], // filepath to MP4BOX.EXE
-const prUTF16Char outpath[], // output file path
-ExportSettings * const mySettings
+	ExportSettings * const mySettings
+);
+
+// NVENC_close_mkv() - release the built-in MKV muxer and close the output file
+void
+NVENC_close_mkv(
+	ExportSettings * const mySettings
 );
 
 #endif // SDK_FILE_MUX_H
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "SDK_Exporter.h" // fwrite_callback()
 #include "CNVEncoderH264.h"
 #include "CNVEncoderH265.h"
+#include "casyncrender.h"
 
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -31,11 +32,29 @@ const PrPixelFormat SupportedPixelFormats420[] = {
 
 // These pixelformats are used for NVENC chromatformatIDC = NV12
 //   (These are only used if YUV420 planar was attempted and failed.)
-const PrPixelFormat SupportedPixelFormats422[] = {
+//   Cheapest first: YUV422 (2 bytes per pixel), v210 (2.67), then packed VUYA 4:4:4 (4 bytes
+//   per pixel, downsampled straight to NV12), all ahead of the RGB 32f fallback (16 bytes per pixel)
+const PrPixelFormat SupportedPixelFormatsPacked[] = {
 	PrPixelFormat_YUYV_422_8u_709, // highest priority
 	PrPixelFormat_UYVY_422_8u_709,
 	PrPixelFormat_YUYV_422_8u_601,
-	PrPixelFormat_UYVY_422_8u_601
+	PrPixelFormat_UYVY_422_8u_601,
+	PrPixelFormat_V210_422_10u_709,
+	PrPixelFormat_V210_422_10u_601,
+	PrPixelFormat_VUYX_4444_8u_709,
+	PrPixelFormat_VUYA_4444_8u_709,
+	PrPixelFormat_VUYX_4444_8u,
+	PrPixelFormat_VUYA_4444_8u
+};
+
+// These pixelformats are used in 10-bit mode for NVENC chromaformatIDC = P010
+//   v210 keeps the 10 bits of a 10-bit 4:2:2 source (ProRes, DNxHR...) at a sixth of the
+//   render bandwidth of RGB 32f.  RGB 32f is the fallback for everything else.
+const PrPixelFormat SupportedPixelFormats10bit420[] = {
+	PrPixelFormat_V210_422_10u_709, // highest priority
+	PrPixelFormat_V210_422_10u_601,
+	PrPixelFormat_BGRX_4444_32f,
+	PrPixelFormat_BGRA_4444_32f
 };
 
 
@@ -51,11 +70,27 @@ const PrPixelFormat SupportedPixelFormats444[] = {
 // These pixelformats are used for NVENC chromaformatIDC = RGB
 //  nvenc_export must convert this RGB to YUV444
 //  (requires NV_ENC_CAPS_SUPPORT_YUV444_ENCODE == 1)
+//
+//  In 10-bit mode (ParamID_encode10bit), these are also used for 4:4:4
+//  (converted to YUV444_10BIT), because the CS6 SDK has no 10-bit YUV 4:4:4 PrPixelFormat.
 const PrPixelFormat SupportedPixelFormatsRGB[] = {
 	PrPixelFormat_BGRX_4444_32f, // highest priority
 	PrPixelFormat_BGRA_4444_32f
 };
 
+// These pixelformats are the RGB fallback in 8-bit mode (NV12 or YUV444)
+//   GPU effects-chains render BGRA 8u natively: asking for it (4 bytes per pixel), or 16u (8),
+//   spares the host from widening each frame to RGB 32f (16 bytes per pixel.)
+//   Converted by the integer RGB converters of CRepackyuv.
+const PrPixelFormat SupportedPixelFormatsRGB8bit[] = {
+	PrPixelFormat_BGRX_4444_8u, // highest priority
+	PrPixelFormat_BGRA_4444_8u,
+	PrPixelFormat_BGRX_4444_16u,
+	PrPixelFormat_BGRA_4444_16u,
+	PrPixelFormat_BGRX_4444_32f,
+	PrPixelFormat_BGRA_4444_32f
+};
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // local functions (for use in this file only)
@@ -67,6 +102,33 @@ NVENC_initialize_h264_session(
 	exDoExportRec * const	exportInfoP
 );
 
+prSuiteError
+NVENC_initialize_session(
+	CNvEncoder * const		p_NvEncoder,  // the export's encoder, or an ABR-ladder rung's
+	const EncodeConfig		&config,
+	void * const			privateData,  // for p_NvEncoder's fwrite_callback
+	const PrPixelFormat		PixelFormat0, // pixelformat used on 1st frame of video
+	exDoExportRec * const	exportInfoP
+);
+
+void
+NVENC_ladder_initialize_sessions(
+	exDoExportRec * const	exportInfoP,
+	std::wostringstream		&os   // (the log message)
+);
+
+HRESULT
+NVENC_ladder_encode(
+	ExportSettings * const	mySettings,
+	const EncodeFrameConfig	&frame // rung 0 (the export's frame)
+);
+
+void
+NVENC_ladder_close_sessions(
+	ExportSettings * const	mySettings,
+	const bool				flush  // the rungs encoded frames: close out their bitstreams
+);
+
 prMALError RenderAndWriteVideoFrame(
 	const bool				isFrame0,  // Is this the 1st frame of the render?
 	const bool				dont_encode, // if true, don't submit frame to CNvEncoderH264
@@ -75,6 +137,16 @@ prMALError RenderAndWriteVideoFrame(
 	);
 
 
+bool
+NVENC_twopass_begin(
+	exDoExportRec * const	exportInfoP
+);
+
+prSuiteError
+NVENC_twopass_begin_pass2(
+	exDoExportRec * const	exportInfoP
+);
+
 prSuiteError
 NVENC_export_FrameCompletionFunction(
 	const csSDK_uint32		inWhichPass,
@@ -88,6 +160,22 @@ NVENC_export_FrameCompletionFunction(
 
 prSuiteError
 NVENC_initialize_h264_session(const PrPixelFormat PixelFormat0, exDoExportRec * const exportInfoP)
+{
+	ExportSettings	*mySettings = reinterpret_cast<ExportSettings *>(exportInfoP->privateData);
+
+	// Store the encoding job's context-info in the p_NvEncoder object,
+	//    so that the fwrite_callback() will write to the correct fileHandle.
+	return NVENC_initialize_session(mySettings->p_NvEncoder, mySettings->NvEncodeConfig,
+		(void *)exportInfoP, PixelFormat0, exportInfoP);
+}
+
+prSuiteError
+NVENC_initialize_session(
+	CNvEncoder * const		p_NvEncoder,
+	const EncodeConfig		&config,
+	void * const			privateData,
+	const PrPixelFormat		PixelFormat0,
+	exDoExportRec * const	exportInfoP)
 {
 	ExportSettings	*mySettings = reinterpret_cast<ExportSettings *>(exportInfoP->privateData);
 	NV_ENC_CONFIG_H264_VUI_PARAMETERS vui;   // Encoder's video-usability struct (for color info)
@@ -178,6 +266,8 @@ NVENC_initialize_h264_session(const PrPixelFormat PixelFormat0, exDoExportRec *
 	case PrPixelFormat_YUYV_422_8u_601:
 	case PrPixelFormat_UYVY_422_8u_601:
 	case PrPixelFormat_V210_422_10u_601:
+	case PrPixelFormat_VUYX_4444_8u:
+	case PrPixelFormat_VUYA_4444_8u:
 	case PrPixelFormat_YUV_420_MPEG4_FIELD_PICTURE_PLANAR_8u_601:
 	case PrPixelFormat_YUV_420_MPEG4_FIELD_PICTURE_PLANAR_8u_601_FullRange:
 	case PrPixelFormat_YUV_420_MPEG2_FIELD_PICTURE_PLANAR_8u_601:
@@ -246,19 +336,17 @@ NVENC_initialize_h264_session(const PrPixelFormat PixelFormat0, exDoExportRec *
 
 	//mySettings->p_NvEncoder = new CNvEncoderH264();
 	//mySettings->p_NvEncoder->Register_fwrite_callback(fwrite_callback);
-	if (mySettings->p_NvEncoder == NULL) {
+	if (p_NvEncoder == NULL) {
 		printf("\nnvEncoder Error: NVENC H.264 encoder == NULL!\n");
 		assert(0); // NVENC H.264 p_NvEncoder is NULL
 		return malUnknownError;
 	}
 
-	// Store the encoding job's context-info in the p_NvEncoder object,
-	//    so that the fwrite_callback() will write to the correct fileHandle.
-	mySettings->p_NvEncoder->m_privateData = (void *)exportInfoP;
+	p_NvEncoder->m_privateData = privateData;
 
 	// Section 2.1 (Opening an Encode Session on nDeviceID)
-	hr = mySettings->p_NvEncoder->OpenEncodeSession(
-		mySettings->NvEncodeConfig,
+	hr = p_NvEncoder->OpenEncodeSession(
+		config,
 		mySettings->NvGPUInfo.device,
 		nvencstatus);
 
@@ -273,14 +361,14 @@ NVENC_initialize_h264_session(const PrPixelFormat PixelFormat0, exDoExportRec *
 	if (hr != S_OK) {
 
 		printf("\nnvEncoder Error: NVENC H.264 encoder OpenEncodeSession failure!\n");
-		assert(0); // NVENC H.264 encoder OpenEncodeSession failure
-		return malUnknownError;
+		assert(p_NvEncoder != mySettings->p_NvEncoder); // NVENC H.264 encoder OpenEncodeSession failure
+		return malUnknownError;                         //   (an ABR-ladder rung may exceed the GPU's #sessions)
 	}
 
 	void * pvui = NULL; // pointer to VUI-struct
 
 	// Select the correct VUI-struct
-	switch (mySettings->NvEncodeConfig.codec) {
+	switch (config.codec) {
 		case NV_ENC_H264 : pvui = &vui;
 			break;
 
@@ -291,18 +379,192 @@ NVENC_initialize_h264_session(const PrPixelFormat PixelFormat0, exDoExportRec *
 			;
 	}
 
-	hr = mySettings->p_NvEncoder->InitializeEncoderCodec( pvui );
+	hr = p_NvEncoder->InitializeEncoderCodec( pvui );
 	if (hr != S_OK) {
 		printf("\nnvEncoder Error: NVENC H.264 encoder initialization failure! Check input params!\n");
 		assert(0); // NVENC H.264 encoder InitializeEncoderH264 failure
 		return malUnknownError;
 	}
 
-	mySettings->p_NvEncoder->set_color_metadata(color_metadata);
+	p_NvEncoder->set_color_metadata(color_metadata);
+
+	return hr;
+}
+
+// NVENC_ladder_initialize_sessions() - frame#0, after the export's session is open: open the
+//   session of each lower rung of the ABR ladder.  A rung whose session can't be opened (the
+//   GPU limits the #sessions) is dropped; without YUV 4:2:0 rendering, the whole ladder is.
+void
+NVENC_ladder_initialize_sessions(exDoExportRec * const exportInfoP, std::wostringstream &os)
+{
+	ExportSettings	*mySettings = reinterpret_cast<ExportSettings *>(exportInfoP->privateData);
+	csSDK_uint32	opened = 1; // (rung 0)
+
+	if (!mySettings->p_AbrLadder)
+		return;
+
+	if (PrPixelFormat_is_YUV420(mySettings->rendered_PixelFormat0)) {
+		for (csSDK_uint32 r = 1; r < mySettings->ladder_rungs; ++r) {
+			NvEncLadderRung &rung = mySettings->ladder[r];
+			rung.opened = (NVENC_initialize_session(rung.p_NvEncoder, rung.NvEncodeConfig, &rung,
+				mySettings->rendered_PixelFormat0, exportInfoP) == malNoError);
+			if (rung.opened)
+				++opened;
+			else
+				rung.p_NvEncoder->DestroyEncoder();
+		}
+	}
+
+	if (opened < 2) {
+		os << "*** ABR ladder: the lower renditions need YUV 4:2:0 rendering and a free NVENC session, "
+			<< "exporting a single rendition" << std::endl;
+		delete mySettings->p_AbrLadder;
+		mySettings->p_AbrLadder = NULL;
+		return;
+	}
+
+	os << "ABR ladder: " << opened << " renditions:";
+	for (csSDK_uint32 r = 0; r < mySettings->ladder_rungs; ++r) {
+		const abr_rung_t &plan = mySettings->p_AbrLadder->GetRung(r);
+		os << " " << plan.width << "x" << plan.height;
+		if (r && !mySettings->ladder[r].opened)
+			os << " (no session)";
+		else if (plan.avg_bps)
+			os << " @ " << plan.avg_bps / 1000 << " kbps";
+	}
+	os << std::endl;
+}
+
+// NVENC_ladder_encode() - downscale the export's frame, and submit each lower rung to its session.
+//   (Two-pass export: the rungs are single-pass, they skip the analysis pass.)
+HRESULT
+NVENC_ladder_encode(ExportSettings * const mySettings, const EncodeFrameConfig &frame)
+{
+	CAbrLadder * const ladder = mySettings->p_AbrLadder;
+	HRESULT hr = S_OK;
+
+	if (!ladder || !frame.ppro_pixelformat_is_yuv420 || mySettings->twopass_pass == 1)
+		return S_OK;
+
+	// each rung is downscaled from the one above it (CPU, on this thread)
+	ladder->Downscale(frame.yuv, frame.stride);
+
+	for (csSDK_uint32 r = 1; r < mySettings->ladder_rungs && hr == S_OK; ++r) {
+		NvEncLadderRung &rung = mySettings->ladder[r];
+		if (!rung.opened)
+			continue;
+
+		EncodeFrameConfig rung_frame = frame; // (same pixelformat, field-mode and timing)
+		rung_frame.width = ladder->GetRung(r).width;
+		rung_frame.height = ladder->GetRung(r).height;
+		for (unsigned p = 0; p < 3; ++p) {
+			rung_frame.yuv[p] = ladder->GetPlane(r, p);
+			rung_frame.stride[p] = ladder->GetStride(r, p);
+		}
+		hr = rung.p_NvEncoder->EncodeFramePPro(&rung_frame, false);
+	}
 
 	return hr;
 }
 
+// NVENC_ladder_close_sessions() - end of the render: flush the lower rungs, and free their
+//   GPU-resources (NVENC_close_ladder() closes the files)
+void
+NVENC_ladder_close_sessions(ExportSettings * const mySettings, const bool flush)
+{
+	for (csSDK_uint32 r = 1; r < mySettings->ladder_rungs; ++r) {
+		NvEncLadderRung &rung = mySettings->ladder[r];
+		if (!rung.opened)
+			continue;
+		if (flush)
+			rung.p_NvEncoder->EncodeFramePPro(NULL, true);
+		rung.p_NvEncoder->DestroyEncoder();
+	}
+}
+
+// NVENC_twopass_begin() - two-pass export, before the session is opened: switch the
+//   encoder to the constant-QP analysis pass (pass 1 of DoMultiPassExportLoop.)
+//   false = the export stays single-pass (no bitrate to plan for.)
+bool
+NVENC_twopass_begin(exDoExportRec * const exportInfoP)
+{
+	ExportSettings	*mySettings = reinterpret_cast<ExportSettings *>(exportInfoP->privateData);
+	EncodeConfig	&config = mySettings->NvEncodeConfig;
+
+	if (!mySettings->twopass_stats_fp || !config.avgBitRate)
+		return false;
+
+	if (!mySettings->p_NvEncoder->GetTwoPass().BeginPass1(
+		mySettings->twopass_stats_fp, config.frameRateNum, config.frameRateDen, TWOPASS_PASS1_QP))
+		return false;
+
+	mySettings->twopass_NvEncodeConfig = config; // (restored for pass 2)
+	CNvEncoder::SetTwoPassAnalysisConfig(config);
+	mySettings->twopass_pass = 1;
+
+	// spill cache: pass 1 keeps its converted frames for pass 2.  (Not with the ABR ladder:
+	// its rungs are downscaled from the rendered frame, which pass 2 then doesn't have.)
+	if (mySettings->p_SpillCache && !mySettings->p_AbrLadder &&
+		mySettings->p_SpillCache->Begin(mySettings->spill_fp, mySettings->spill_budget, mySettings->spill_compress))
+	{
+		mySettings->p_NvEncoder->SetSpillCache(mySettings->p_SpillCache);
+	}
+	return true;
+}
+
+// NVENC_twopass_next_frame() - pass 2, before each frame is submitted: at the start of a
+//   segment of the plan, reconfigure the encoder with the segment's settings
+static void
+NVENC_twopass_next_frame(ExportSettings * const mySettings)
+{
+	twopass_rate_t twopass_rate;
+	if (mySettings->twopass_pass == 2 && mySettings->p_NvEncoder->GetTwoPass().NextFrame(twopass_rate)) {
+		EncodeConfig segment_config = mySettings->NvEncodeConfig;
+		CNvEncoder::SetTwoPassSegmentConfig(segment_config, twopass_rate);
+		mySettings->p_NvEncoder->ReconfigureEncoder(segment_config); // (on failure, the previous segment's settings stay)
+	}
+}
+
+// NVENC_twopass_begin_pass2() - the first frame of pass 2: close the analysis-session,
+//   plan the bitrate from its stats, and open the final session with the user's settings.
+//   (If the stats can't be used, pass 2 is a plain single-pass encode.)
+prSuiteError
+NVENC_twopass_begin_pass2(exDoExportRec * const exportInfoP)
+{
+	ExportSettings	*mySettings = reinterpret_cast<ExportSettings *>(exportInfoP->privateData);
+	CNvEncTwoPass	&twopass = mySettings->p_NvEncoder->GetTwoPass();
+	std::wostringstream os;
+	prUTF16Char eventTitle[256];
+	prUTF16Char eventDesc[512];
+
+	// flush pass 1 (fwrite_callback still discards its bitstream)
+	mySettings->p_NvEncoder->EncodeFramePPro(NULL, true);
+	mySettings->p_NvEncoder->DestroyEncoder();
+	const bool stats_ok = twopass.EndPass1();
+
+	mySettings->NvEncodeConfig = mySettings->twopass_NvEncodeConfig;
+	mySettings->twopass_pass = 2;
+	if (stats_ok && twopass.Plan(mySettings->twopass_stats_fp,
+		mySettings->NvEncodeConfig.avgBitRate, mySettings->NvEncodeConfig.peakBitRate))
+	{
+		os << "Two-pass: pass 1 analyzed " << twopass.GetPass1Frames() << " frames, pass 2 encodes "
+			<< twopass.GetSegmentCount() << " segments" << std::endl;
+	}
+	else {
+		twopass.End();
+		mySettings->twopass_pass = 0;
+		os << "*** Two-pass: the pass-1 stats are unusable, pass 2 is a single-pass encode" << std::endl;
+	}
+
+	copyConvertStringLiteralIntoUTF16(L"Note from NVENC_twopass_begin_pass2()", eventTitle);
+	copyConvertStringLiteralIntoUTF16(os.str().c_str(), eventDesc);
+	mySettings->exporterUtilitySuite->ReportEventA(
+		exportInfoP->exporterPluginID, PrSDKErrorSuite3::kEventTypeWarning, eventTitle, eventDesc
+		);
+
+	return NVENC_initialize_h264_session(mySettings->rendered_PixelFormat0, exportInfoP);
+}
+
 // callback function for DoMultiPassExportLoop
 prSuiteError NVENC_export_FrameCompletionFunction(
 	const csSDK_uint32 inWhichPass,
@@ -329,6 +591,10 @@ prSuiteError NVENC_export_FrameCompletionFunction(
 	nvEncodeFrameConfig.height = height.value.intValue;
 	nvEncodeFrameConfig.width = width.value.intValue;
 
+	// Concurrent export: the audio failed, stop the render-loop
+	if (mySettings->export_cancel)
+		return exportReturn_Abort;
+
 	mySettings->ppixSuite->GetPixelFormat(inRenderedFrame, &rendered_pixelformat);
 	const bool		adobe_yuv420 =      // Adobe is sending Planar YUV420 (instead of packed-pixel 422/444)
 		PrPixelFormat_is_YUV420(rendered_pixelformat);
@@ -351,6 +617,10 @@ prSuiteError NVENC_export_FrameCompletionFunction(
 	nvEncodeFrameConfig.ppro_pixelformat_is_rgb444f = 
 		(rendered_pixelformat == PrPixelFormat_BGRA_4444_32f) ||
 		(rendered_pixelformat == PrPixelFormat_BGRX_4444_32f);
+	nvEncodeFrameConfig.ppro_pixelformat_is_rgb444_8u = PrPixelFormat_is_RGB8u(rendered_pixelformat);
+	nvEncodeFrameConfig.ppro_pixelformat_is_rgb444_16u = PrPixelFormat_is_RGB16u(rendered_pixelformat);
+	nvEncodeFrameConfig.ppro_pixelformat_is_v410 = false; // (no V410 PrPixelFormat in the CS6 SDK)
+	nvEncodeFrameConfig.ppro_pixelformat_is_v210 = PrPixelFormat_is_V210(rendered_pixelformat);
 
 	// NVENC picture-type: Interlaced vs Progressive
 	//
@@ -412,6 +682,14 @@ prSuiteError NVENC_export_FrameCompletionFunction(
 		nvEncodeFrameConfig.yuv[2] = NULL;
 	}
 
+	// Two-pass export: the first frame of pass 2 replaces the analysis-session,
+	//   and each segment of the plan reconfigures the encoder as it begins
+	if (mySettings->twopass_pass == 1 && inWhichPass > 0) {
+		if (NVENC_twopass_begin_pass2(exportInfoP) != malNoError)
+			return malUnknownError;
+	}
+	NVENC_twopass_next_frame(mySettings);
+
 	// Submit the Adobe rendered frame to NVENC:
 	//   (1) If NvEncoder is operating in 'async_mode', then the call will return as soon
 	//       as the frame is placed in the encodeQueue.
@@ -423,12 +701,173 @@ prSuiteError NVENC_export_FrameCompletionFunction(
 		false // flush
 		);
 
+	// ABR ladder: the same frame, downscaled, to the lower rungs' sessions
+	if (hr == S_OK)
+		hr = NVENC_ladder_encode(mySettings, nvEncodeFrameConfig);
+
 	return (hr == S_OK) ? malNoError : // no error
 		malUnknownError;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// NVENC_encode_rendered_frame() - submit a video-frame rendered by Adobe (in rendered_PixelFormat0)
+//   to NVENC, and to the ABR ladder.  The caller disposes of the frame.
+static HRESULT
+NVENC_encode_rendered_frame(PPixHand renderedFrame, exDoExportRec * const exportInfoP)
+{
+	csSDK_uint32				exID = exportInfoP->exporterPluginID;
+	ExportSettings				*mySettings = reinterpret_cast<ExportSettings *>(exportInfoP->privateData);
+	csSDK_int32					rowbytes = 0;
+	exParamValues				width,
+		height,
+		temp_param;
+	char						*frameBufferP = NULL;
+
+	mySettings->exportParamSuite->GetParamValue(exID, 0, ADBEVideoWidth, &width);
+	mySettings->exportParamSuite->GetParamValue(exID, 0, ADBEVideoHeight, &height);
+
+	EncodeFrameConfig nvEncodeFrameConfig = { 0 };
+	nvEncodeFrameConfig.height = height.value.intValue;
+	nvEncodeFrameConfig.width = width.value.intValue;
+
+	// What is the Adobe-app actually sending us? (planar 4:2:0, or a packed-pixel format)
+	const bool adobe_yuv420 = PrPixelFormat_is_YUV420(mySettings->rendered_PixelFormat0);
+
+	// CNvEncoderH264 must know the source-video's pixelformat, in order to
+	//    convert it into an NVENC compatible format (NV12 or YUV444)
+	nvEncodeFrameConfig.ppro_pixelformat = mySettings->rendered_PixelFormat0;
+	nvEncodeFrameConfig.ppro_pixelformat_is_yuv420 = PrPixelFormat_is_YUV420(mySettings->rendered_PixelFormat0);
+	nvEncodeFrameConfig.ppro_pixelformat_is_yuv444 = PrPixelFormat_is_YUV444(mySettings->rendered_PixelFormat0);
+	nvEncodeFrameConfig.ppro_pixelformat_is_uyvy422 =
+		(mySettings->rendered_PixelFormat0 == PrPixelFormat_UYVY_422_8u_601) ||
+		(mySettings->rendered_PixelFormat0 == PrPixelFormat_UYVY_422_8u_709);
+	nvEncodeFrameConfig.ppro_pixelformat_is_yuyv422 =
+		(mySettings->rendered_PixelFormat0 == PrPixelFormat_YUYV_422_8u_601) ||
+		(mySettings->rendered_PixelFormat0 == PrPixelFormat_YUYV_422_8u_709);
+	nvEncodeFrameConfig.ppro_pixelformat_is_rgb444f = PrPixelFormat_is_RGB32f(mySettings->rendered_PixelFormat0);
+	nvEncodeFrameConfig.ppro_pixelformat_is_rgb444_8u = PrPixelFormat_is_RGB8u(mySettings->rendered_PixelFormat0);
+	nvEncodeFrameConfig.ppro_pixelformat_is_rgb444_16u = PrPixelFormat_is_RGB16u(mySettings->rendered_PixelFormat0);
+	nvEncodeFrameConfig.ppro_pixelformat_is_v410 = false; // (no V410 PrPixelFormat in the CS6 SDK)
+	nvEncodeFrameConfig.ppro_pixelformat_is_v210 = PrPixelFormat_is_V210(mySettings->rendered_PixelFormat0);
+
+	// NVENC picture-type: Interlaced vs Progressive
+	//
+	// Note that the picture-type must match the selected encoding-mode.
+	// In interlaced or MBAFF-mode, NVENC still requires all sourceFrames to be tagged as fieldPics
+	// (even if the sourceFrame is truly progressive.)
+	mySettings->exportParamSuite->GetParamValue(exID, 0, ParamID_FieldEncoding, &temp_param);
+	nvEncodeFrameConfig.fieldPicflag = (temp_param.value.intValue == NV_ENC_PARAMS_FRAME_FIELD_MODE_FRAME) ?
+		false :
+		true;
+	nvEncodeFrameConfig.topField = true; // default
+	if (nvEncodeFrameConfig.fieldPicflag) {
+		PrSDKExportInfoSuite	*exportInfoSuite = mySettings->exportInfoSuite;
+		PrParam	seqFieldOrder;  // video-sequence field order (top_first/bottom_first)
+		exportInfoSuite->GetExportSourceInfo(exID,
+			kExportInfo_VideoFieldType,
+			&seqFieldOrder);
+		nvEncodeFrameConfig.topField = (seqFieldOrder.mInt32 == prFieldsLowerFirst) ? false : true;
+	}
+	
+	//
+	// Get critical properties of the Adobe rendered videoframe:
+	//
+	//   Stride  (#bytes per scanline of video)
+	//   Pointer (start-address of the videoframe's pixeldata)
+
+	if ( adobe_yuv420 ) {
+		// Adobe's "Planar420" surface format requires special handling (compared
+		// to the packed-pixel formats)
+		// 
+		// In particular, there are 3 different surface pointers (and 3 stride values)
+		// for Planar-4:2:0.  These are queried through the ppix2Suite.
+
+		size_t       rowsize;
+		csSDK_uint32 stride[3]; // #bytes per row (for each of Y/U/V planes)
+
+		mySettings->ppix2Suite->GetYUV420PlanarBuffers(
+			renderedFrame,
+			PrPPixBufferAccess_ReadOnly,
+			reinterpret_cast<char **>(&nvEncodeFrameConfig.yuv[0]),
+			&stride[0],
+			reinterpret_cast<char **>(&nvEncodeFrameConfig.yuv[1]),
+			&stride[1],
+			reinterpret_cast<char **>(&nvEncodeFrameConfig.yuv[2]),
+			&stride[2]
+			);
+		nvEncodeFrameConfig.stride[0] = stride[0];
+		nvEncodeFrameConfig.stride[1] = stride[1];
+		nvEncodeFrameConfig.stride[2] = stride[2];
+		mySettings->ppix2Suite->GetSize(renderedFrame, &rowsize);
+		rowbytes = rowsize;
+	}
+	else {
+		// The packed-pixel formats that nvenc_export supports (YUV444, YUV422, RGB32)
+		// are queried pretty much the same way (through ppixSuite).
+		//
+		// ...only pointer[0] and stride0 is used, (pointer[1] & [2] aren't used)
+
+		mySettings->ppixSuite->GetPixels(renderedFrame,
+			PrPPixBufferAccess_ReadOnly,
+			&frameBufferP);
+		mySettings->ppixSuite->GetRowBytes(renderedFrame, &rowbytes);
+		nvEncodeFrameConfig.stride[0] = rowbytes; // Y-plane
+
+		nvEncodeFrameConfig.yuv[0] = reinterpret_cast<unsigned char *>(&frameBufferP[0]); // Y-plane
+		nvEncodeFrameConfig.stride[1] = 0; // U-plane not used
+		nvEncodeFrameConfig.stride[2] = 0; // V-plane not used
+		nvEncodeFrameConfig.yuv[1] = NULL;
+		nvEncodeFrameConfig.yuv[2] = NULL;
+	}
+
+	// Submit the Adobe rendered frame to NVENC:
+	//   (1) If NvEncoder is operating in 'async_mode', then the call will return as soon
+	//       as the frame is placed in the encodeQueue.
+	//   (2) if NvEncoder is operating in 'sync_mode', then call will not return until
+	//       NVENC has completed encoding of this frame.
+	HRESULT hr = mySettings->p_NvEncoder->EncodeFramePPro(
+		&nvEncodeFrameConfig,
+		false  // flush?
+		);
+
+	// ABR ladder: the same frame, downscaled, to the lower rungs' sessions
+	if (hr == S_OK)
+		hr = NVENC_ladder_encode(mySettings, nvEncodeFrameConfig);
+
+	return hr;
+}
+
+// NVENC_get_render_params() - the output size, aspect-ratio, field-type and quality to render
+//   (everything except the requested PrPixelFormat(s))
+static void
+NVENC_get_render_params(exDoExportRec * const exportInfoP, SequenceRender_ParamsRec &renderParms)
+{
+	csSDK_uint32				exID = exportInfoP->exporterPluginID;
+	ExportSettings				*mySettings = reinterpret_cast<ExportSettings *>(exportInfoP->privateData);
+	exParamValues				width,
+		height,
+		pixelAspectRatio,
+		fieldType;
+
+	mySettings->exportParamSuite->GetParamValue(exID, 0, ADBEVideoWidth, &width);
+	renderParms.inWidth = width.value.intValue;
+	mySettings->exportParamSuite->GetParamValue(exID, 0, ADBEVideoHeight, &height);
+	renderParms.inHeight = height.value.intValue;
+	mySettings->exportParamSuite->GetParamValue(exID, 0, ADBEVideoAspect, &pixelAspectRatio);
+	renderParms.inPixelAspectRatioNumerator = pixelAspectRatio.value.ratioValue.numerator;
+	renderParms.inPixelAspectRatioDenominator = pixelAspectRatio.value.ratioValue.denominator;
+
+	renderParms.inRenderQuality = kPrRenderQuality_High;
+	mySettings->exportParamSuite->GetParamValue(exID, 0, ADBEVideoFieldType, &fieldType);
+	renderParms.inFieldType = fieldType.value.intValue;
+	// By setting this to false, we basically leave deinterlacing up to the host logic
+	// We could set it to true if we wanted to force deinterlacing
+	renderParms.inDeinterlace = kPrFalse;
+	renderParms.inDeinterlaceQuality = kPrRenderQuality_High;
+	renderParms.inCompositeOnBlack = kPrFalse;
+}
+
 // Returns malNoError if successful, or comp_CompileAbort if user aborted
 prMALError RenderAndWriteVideoFrame(  // export a single frame of video to NVENC encoder
 	const bool					isFrame0,    // are we rendering the first-frame of the session?
@@ -464,6 +903,10 @@ prMALError RenderAndWriteVideoFrame(  // export a single frame of video to NVENC
 	bool adobe_yuv444 = (nvenc_pixelformat == cudaVideoChromaFormat_444);// a 4:4:4 format is in use (instead of 4:2:0)
 	bool adobe_yuv420 = false;// (Adobe is outputing YUV 4:2:0, i.e. 'YV12')
 	bool adobe_yuv422 = false;// (Adobe is outputing YUV 4:2:2, i.e. 'YUYV')
+
+	// 10-bit mode: the NVENC input-surface is P010 or YUV444_10BIT
+	mySettings->exportParamSuite->GetParamValue(exID, 0, ParamID_encode10bit, &temp_param);
+	const bool nvenc_10bit = (temp_param.value.intValue != 0);
 	
 	if (isFrame0) {
 		// First frame of render:
@@ -493,6 +936,17 @@ prMALError RenderAndWriteVideoFrame(  // export a single frame of video to NVENC
 			renderParms.inRequestedPixelFormatArray = &(mySettings->requested_PixelFormat0);
 			renderParms.inRequestedPixelFormatArrayCount = 1;
 		}
+		else if (nvenc_10bit && adobe_yuv444) {
+			// 10-bit 4:4:4: request 32f RGB, the 8-bit YUV formats would lose precision.
+			// (converted to YUV444_10BIT by CRepackyuv)
+			renderParms.inRequestedPixelFormatArray = SupportedPixelFormatsRGB;
+			renderParms.inRequestedPixelFormatArrayCount = sizeof(SupportedPixelFormatsRGB) / sizeof(SupportedPixelFormatsRGB[0]);
+		}
+		else if (nvenc_10bit) {
+			// 10-bit 4:2:0: request v210, then 32f RGB (converted to P010 by CRepackyuv)
+			renderParms.inRequestedPixelFormatArray = SupportedPixelFormats10bit420;
+			renderParms.inRequestedPixelFormatArrayCount = sizeof(SupportedPixelFormats10bit420) / sizeof(SupportedPixelFormats10bit420[0]);
+		}
 		else if (adobe_yuv444) {
 			// Packed Pixel YUV 4:4:4 (24bpp + 8bit alpha, NVENC doesn't use the alpha-channel)
 			//
@@ -517,22 +971,7 @@ prMALError RenderAndWriteVideoFrame(  // export a single frame of video to NVENC
 		renderParms.inRequestedPixelFormatArrayCount = 1;
 	}
 
-	mySettings->exportParamSuite->GetParamValue(exID, 0, ADBEVideoWidth, &width);
-	renderParms.inWidth = width.value.intValue;
-	mySettings->exportParamSuite->GetParamValue(exID, 0, ADBEVideoHeight, &height);
-	renderParms.inHeight = height.value.intValue;
-	mySettings->exportParamSuite->GetParamValue(exID, 0, ADBEVideoAspect, &pixelAspectRatio);
-	renderParms.inPixelAspectRatioNumerator = pixelAspectRatio.value.ratioValue.numerator;
-	renderParms.inPixelAspectRatioDenominator = pixelAspectRatio.value.ratioValue.denominator;
-
-	renderParms.inRenderQuality = kPrRenderQuality_High;
-	mySettings->exportParamSuite->GetParamValue(exID, 0, ADBEVideoFieldType, &fieldType);
-	renderParms.inFieldType = fieldType.value.intValue;
-	// By setting this to false, we basically leave deinterlacing up to the host logic
-	// We could set it to true if we wanted to force deinterlacing
-	renderParms.inDeinterlace = kPrFalse;
-	renderParms.inDeinterlaceQuality = kPrRenderQuality_High;
-	renderParms.inCompositeOnBlack = kPrFalse;
+	NVENC_get_render_params(exportInfoP, renderParms);
 
 	SequenceRender_GetFrameReturnRec renderResult;
 
@@ -546,12 +985,13 @@ prMALError RenderAndWriteVideoFrame(  // export a single frame of video to NVENC
 			kRenderCacheType_None,	// [TODO] Try different settings
 			&renderResult);
 
-		// If YUV420-video failed, make another attempt with YUV422
-		if (PrSuiteErrorFailed(resultS) && !adobe_yuv444) {
+		// If YUV420-video failed, make another attempt with the packed formats (YUV422, v210, VUYA)
+		//   (not in 10-bit mode: v210 was requested already, and the 8-bit formats can't be converted to P010)
+		if (PrSuiteErrorFailed(resultS) && !adobe_yuv444 && !nvenc_10bit) {
 			// We attempted {chromaFormat: YUV420}, but the videorender failed.
-			//    ... so retry the videorender with YUV 4:2:2 packed-pixel instead
-			renderParms.inRequestedPixelFormatArray = SupportedPixelFormats422;
-			renderParms.inRequestedPixelFormatArrayCount = sizeof(SupportedPixelFormats422) / sizeof(SupportedPixelFormats422[0]);
+			//    ... so retry the videorender with packed-pixel YUV instead
+			renderParms.inRequestedPixelFormatArray = SupportedPixelFormatsPacked;
+			renderParms.inRequestedPixelFormatArrayCount = sizeof(SupportedPixelFormatsPacked) / sizeof(SupportedPixelFormatsPacked[0]);
 
 			resultS = mySettings->sequenceRenderSuite->RenderVideoFrame(
 				mySettings->videoRenderID,
@@ -561,15 +1001,21 @@ prMALError RenderAndWriteVideoFrame(  // export a single frame of video to NVENC
 				&renderResult);
 		}
 
-		// If YUV422 or YUV444 failed, make a final attempt with RGBf
-		if (PrSuiteErrorFailed(resultS)) { // 2nd-attempt (RGBf)
+		// If YUV422 or YUV444 failed, make a final attempt with RGB
+		if (PrSuiteErrorFailed(resultS)) { // 2nd-attempt (RGB)
 			ostringstream o;
 			PrParam		hasVideo, seqWidth, seqHeight;
 			// 2nd videorender attempt failed {chromaFormat: YUV422},
-			//   ... retry one last time with RGB32f.
+			//   ... retry one last time with RGB (8-bit mode: 8u/16u before RGB32f)
 
-			renderParms.inRequestedPixelFormatArray = SupportedPixelFormatsRGB;
-			renderParms.inRequestedPixelFormatArrayCount = sizeof(SupportedPixelFormatsRGB) / sizeof(SupportedPixelFormatsRGB[0]);
+			if (nvenc_10bit) {
+				renderParms.inRequestedPixelFormatArray = SupportedPixelFormatsRGB;
+				renderParms.inRequestedPixelFormatArrayCount = sizeof(SupportedPixelFormatsRGB) / sizeof(SupportedPixelFormatsRGB[0]);
+			}
+			else {
+				renderParms.inRequestedPixelFormatArray = SupportedPixelFormatsRGB8bit;
+				renderParms.inRequestedPixelFormatArrayCount = sizeof(SupportedPixelFormatsRGB8bit) / sizeof(SupportedPixelFormatsRGB8bit[0]);
+			}
 
 			resultS = mySettings->sequenceRenderSuite->RenderVideoFrame(
 				mySettings->videoRenderID,
@@ -652,11 +1098,13 @@ prMALError RenderAndWriteVideoFrame(  // export a single frame of video to NVENC
 		mySettings->rendered_PixelFormat0 = renderedPixelFormat;
 
 		// update the chroma-format flags: we're either in 422 or 420 mode
+		//   (packed VUYA rendered for a 4:2:0 encode is downsampled by CRepackyuv, like YUV422)
 		//
 		// 
 		if (PrPixelFormat_is_YUV420(renderedPixelFormat))
 			adobe_yuv420 = true;
-		else if (PrPixelFormat_is_YUV422(renderedPixelFormat))
+		else if (PrPixelFormat_is_YUV422(renderedPixelFormat) || PrPixelFormat_is_V210(renderedPixelFormat) ||
+			(PrPixelFormat_is_YUV444(renderedPixelFormat) && !adobe_yuv444))
 			adobe_yuv422 = true;
 	}
 	else {
@@ -679,111 +1127,11 @@ prMALError RenderAndWriteVideoFrame(  // export a single frame of video to NVENC
 		return resultS;
 	}
 
-	EncodeFrameConfig nvEncodeFrameConfig = { 0 };
-	nvEncodeFrameConfig.height = height.value.intValue;
-	nvEncodeFrameConfig.width = width.value.intValue;
-
-	// Update the PrPixelformat flags (what is the Adobe-app actually sending us?)
-	//bool adobe_rgb32 = PrPixelFormat_is_RGB32f(mySettings->rendered_PixelFormat0);
-	adobe_yuv444 = PrPixelFormat_is_YUV444(mySettings->rendered_PixelFormat0) &&
-		(nvenc_pixelformat == cudaVideoChromaFormat_444);
-	adobe_yuv420 = PrPixelFormat_is_YUV420(mySettings->rendered_PixelFormat0);
-	adobe_yuv422 = PrPixelFormat_is_YUV422(mySettings->rendered_PixelFormat0);
-
-	// CNvEncoderH264 must know the source-video's pixelformat, in order to
-	//    convert it into an NVENC compatible format (NV12 or YUV444)
-	nvEncodeFrameConfig.ppro_pixelformat = mySettings->rendered_PixelFormat0;
-	nvEncodeFrameConfig.ppro_pixelformat_is_yuv420 = PrPixelFormat_is_YUV420(mySettings->rendered_PixelFormat0);
-	nvEncodeFrameConfig.ppro_pixelformat_is_yuv444 = PrPixelFormat_is_YUV444(mySettings->rendered_PixelFormat0);
-	nvEncodeFrameConfig.ppro_pixelformat_is_uyvy422 =
-		(mySettings->rendered_PixelFormat0 == PrPixelFormat_UYVY_422_8u_601) ||
-		(mySettings->rendered_PixelFormat0 == PrPixelFormat_UYVY_422_8u_709);
-	nvEncodeFrameConfig.ppro_pixelformat_is_yuyv422 =
-		(mySettings->rendered_PixelFormat0 == PrPixelFormat_YUYV_422_8u_601) ||
-		(mySettings->rendered_PixelFormat0 == PrPixelFormat_YUYV_422_8u_709);
-	nvEncodeFrameConfig.ppro_pixelformat_is_rgb444f = PrPixelFormat_is_RGB32f(mySettings->rendered_PixelFormat0);
-
-	// NVENC picture-type: Interlaced vs Progressive
-	//
-	// Note that the picture-type must match the selected encoding-mode.
-	// In interlaced or MBAFF-mode, NVENC still requires all sourceFrames to be tagged as fieldPics
-	// (even if the sourceFrame is truly progressive.)
-	mySettings->exportParamSuite->GetParamValue(exID, 0, ParamID_FieldEncoding, &temp_param);
-	nvEncodeFrameConfig.fieldPicflag = (temp_param.value.intValue == NV_ENC_PARAMS_FRAME_FIELD_MODE_FRAME) ?
-		false :
-		true;
-	nvEncodeFrameConfig.topField = true; // default
-	if (nvEncodeFrameConfig.fieldPicflag) {
-		PrSDKExportInfoSuite	*exportInfoSuite = mySettings->exportInfoSuite;
-		PrParam	seqFieldOrder;  // video-sequence field order (top_first/bottom_first)
-		exportInfoSuite->GetExportSourceInfo(exID,
-			kExportInfo_VideoFieldType,
-			&seqFieldOrder);
-		nvEncodeFrameConfig.topField = (seqFieldOrder.mInt32 == prFieldsLowerFirst) ? false : true;
-	}
-	
-	//
-	// Get critical properties of the Adobe rendered videoframe:
-	//
-	//   Stride  (#bytes per scanline of video)
-	//   Pointer (start-address of the videoframe's pixeldata)
-
-	if ( adobe_yuv420 ) {
-		// Adobe's "Planar420" surface format requires special handling (compared
-		// to the packed-pixel formats)
-		// 
-		// In particular, there are 3 different surface pointers (and 3 stride values)
-		// for Planar-4:2:0.  These are queried through the ppix2Suite.
-
-		size_t       rowsize;
-		csSDK_uint32 stride[3]; // #bytes per row (for each of Y/U/V planes)
-
-		mySettings->ppix2Suite->GetYUV420PlanarBuffers(
-			renderResult.outFrame,
-			PrPPixBufferAccess_ReadOnly,
-			reinterpret_cast<char **>(&nvEncodeFrameConfig.yuv[0]),
-			&stride[0],
-			reinterpret_cast<char **>(&nvEncodeFrameConfig.yuv[1]),
-			&stride[1],
-			reinterpret_cast<char **>(&nvEncodeFrameConfig.yuv[2]),
-			&stride[2]
-			);
-		nvEncodeFrameConfig.stride[0] = stride[0];
-		nvEncodeFrameConfig.stride[1] = stride[1];
-		nvEncodeFrameConfig.stride[2] = stride[2];
-		mySettings->ppix2Suite->GetSize(renderResult.outFrame, &rowsize);
-		rowbytes = rowsize;
-	}
-	else {
-		// The packed-pixel formats that nvenc_export supports (YUV444, YUV422, RGB32)
-		// are queried pretty much the same way (through ppixSuite).
-		//
-		// ...only pointer[0] and stride0 is used, (pointer[1] & [2] aren't used)
-
-		mySettings->ppixSuite->GetPixels(renderResult.outFrame,
-			PrPPixBufferAccess_ReadOnly,
-			&frameBufferP);
-		mySettings->ppixSuite->GetRowBytes(renderResult.outFrame, &rowbytes);
-		nvEncodeFrameConfig.stride[0] = rowbytes; // Y-plane
-
-		nvEncodeFrameConfig.yuv[0] = reinterpret_cast<unsigned char *>(&frameBufferP[0]); // Y-plane
-		nvEncodeFrameConfig.stride[1] = 0; // U-plane not used
-		nvEncodeFrameConfig.stride[2] = 0; // V-plane not used
-		nvEncodeFrameConfig.yuv[1] = NULL;
-		nvEncodeFrameConfig.yuv[2] = NULL;
-	}
-
-	// Submit the Adobe rendered frame to NVENC:
-	//   (1) If NvEncoder is operating in 'async_mode', then the call will return as soon
-	//       as the frame is placed in the encodeQueue.
-	//   (2) if NvEncoder is operating in 'sync_mode', then call will not return until
-	//       NVENC has completed encoding of this frame.
+	// Submit the Adobe rendered frame to NVENC
+	//   (for frame#0 of the render, Adobe only selects the PrPixelFormat: it isn't encoded)
 	HRESULT hr = S_OK;
 	if (!dont_encode)
-		hr = mySettings->p_NvEncoder->EncodeFramePPro(
-		&nvEncodeFrameConfig,
-		false  // flush?
-		);
+		hr = NVENC_encode_rendered_frame(renderResult.outFrame, exportInfoP);
 
 	// Now that buffer is written to disk, we can dispose of memory
 	mySettings->ppixSuite->Dispose(renderResult.outFrame);
@@ -829,6 +1177,363 @@ NVENC_switch_codec(ExportSettings *lRec)
 	lRec->p_NvEncoder->QueryEncodeSessionCodec(GPUIndex, lRec->NvEncodeConfig.codec, nv_enc_caps);
 }
 
+// fwrite_callback of an ABR-ladder rung's encoder: its elementary-stream file
+static size_t
+ladder_fwrite_callback(void * _Str, size_t _Size, size_t _Count, FILE * _File, void *privateData)
+{
+	NvEncLadderRung *rung = reinterpret_cast<NvEncLadderRung *>(privateData);
+
+	return rung->p_FileWriter->Write(_Str, _Size * _Count);
+}
+
+bool
+NVENC_open_ladder(const prUTF16Char outpath[], ExportSettings * const mySettings, const csSDK_uint32 rungs)
+{
+	const EncodeConfig &config = mySettings->NvEncodeConfig;
+	abr_rung_t plan[ABR_LADDER_MAX_RUNGS];
+	nv_enc_caps_s nv_enc_caps;
+
+	mySettings->p_AbrLadder = NULL;
+	mySettings->ladder_rungs = 0;
+	if (rungs < 2)
+		return false;
+
+	// (constQP has no bitrate to share out: the lower rungs keep the export's QP)
+	const csSDK_uint32 count = CAbrLadder::Plan(config.width, config.height,
+		config.avgBitRate, config.peakBitRate, rungs, plan);
+	if (count < 2)
+		return false;
+
+	mySettings->p_AbrLadder = new CAbrLadder();
+	mySettings->ladder_rungs = count;
+	for (csSDK_uint32 r = 1; r < count; ++r) {
+		NvEncLadderRung &rung = mySettings->ladder[r];
+		std::wostringstream postfix;
+		wstring filename;
+
+		postfix << L"_" << plan[r].height << L"p";
+		nvenc_make_output_filename(
+			outpath,
+			postfix.str(),
+			(config.codec == NV_ENC_H265) ? SDK_FILE_EXTENSION_HEVC : SDK_FILE_EXTENSION_M4V,
+			filename
+		);
+		copyConvertStringLiteralIntoUTF16(filename.c_str(), rung.filename);
+		DeleteFileW(filename.c_str());
+
+		rung.opened = false;
+		rung.p_FileWriter = new CFileWriter();
+		rung.p_FileWriter->Open(filename.c_str());
+
+		// the export's settings, at the rung's size and share of the bitrate
+		rung.NvEncodeConfig = config;
+		rung.NvEncodeConfig.width = rung.NvEncodeConfig.maxWidth = plan[r].width;
+		rung.NvEncodeConfig.height = rung.NvEncodeConfig.maxHeight = plan[r].height;
+		rung.NvEncodeConfig.avgBitRate = plan[r].avg_bps;
+		rung.NvEncodeConfig.peakBitRate = plan[r].peak_bps;
+
+		if (config.codec == NV_ENC_H265)
+			rung.p_NvEncoder = new CNvEncoderH265();
+		else
+			rung.p_NvEncoder = new CNvEncoderH264();
+		rung.p_NvEncoder->Register_fwrite_callback(ladder_fwrite_callback);
+		rung.p_NvEncoder->QueryEncodeSessionCodec(mySettings->NvGPUInfo.device, config.codec, nv_enc_caps);
+	}
+
+	for (csSDK_uint32 r = 1; r < count; ++r) {
+		if (!mySettings->ladder[r].p_FileWriter->IsOpen()) {
+			NVENC_close_ladder(mySettings);
+			return false;
+		}
+	}
+
+	if (!mySettings->p_AbrLadder->Init(plan, count)) {
+		NVENC_close_ladder(mySettings);
+		return false;
+	}
+
+	return true;
+}
+
+void
+NVENC_close_ladder(ExportSettings * const mySettings)
+{
+	for (csSDK_uint32 r = 1; r < mySettings->ladder_rungs; ++r) {
+		NvEncLadderRung &rung = mySettings->ladder[r];
+
+		if (rung.p_NvEncoder) {
+			rung.p_NvEncoder->DestroyEncoder();
+			delete rung.p_NvEncoder;
+			rung.p_NvEncoder = NULL;
+		}
+		if (rung.p_FileWriter) {
+			rung.p_FileWriter->Close();
+			delete rung.p_FileWriter;
+			rung.p_FileWriter = NULL;
+		}
+
+		// a rung that never had a session leaves no (empty) file behind
+		if (!rung.opened)
+			DeleteFileW(reinterpret_cast<const wchar_t *>(rung.filename));
+		rung.opened = false;
+	}
+
+	delete mySettings->p_AbrLadder;
+	mySettings->p_AbrLadder = NULL;
+	mySettings->ladder_rungs = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// CPrAsyncRenderHost : CAsyncRender's host, over Adobe's sequence-render suite (PULL-mode render-ahead)
+//   frame# n is rendered at startTime + n * ticksPerFrame, in the PrPixelFormat of frame#0
+class CPrAsyncRenderHost : public IAsyncRenderHost
+{
+public:
+	CPrAsyncRenderHost(ExportSettings *mySettings, const SequenceRender_ParamsRec &renderParms,
+		const PrTime startTime, const PrTime ticksPerFrame) :
+		m_mySettings(mySettings), m_renderParms(renderParms), m_startTime(startTime), m_ticksPerFrame(ticksPerFrame)
+	{
+	};
+
+	virtual bool QueueRender(const uint32_t frame)
+	{
+		csSDK_uint32 requestID = 0;
+
+		return !PrSuiteErrorFailed(m_mySettings->sequenceRenderSuite->QueueAsyncVideoFrameRender(
+			m_mySettings->videoRenderID,
+			GetTime(frame),
+			&requestID,
+			&m_renderParms,
+			kRenderCacheType_None,
+			reinterpret_cast<void *>(static_cast<uintptr_t>(frame)) // (returned as asyncCompletionData)
+			));
+	};
+
+	virtual void ReleaseFrame(void *handle)
+	{
+		m_mySettings->ppixSuite->Dispose(reinterpret_cast<PPixHand>(handle));
+	};
+
+	PrTime GetTime(const uint32_t frame) const { return m_startTime + static_cast<PrTime>(frame) * m_ticksPerFrame; };
+
+	// the suite's completion-proc (Adobe's render-thread), inCallbackRef = the CAsyncRender
+	static void CompletionProc(
+		csSDK_uint32 inVideoRenderID,
+		void* inCallbackRef,
+		PrTime inTime,
+		PPixHand inRenderedFrame,
+		SequenceRender_GetFrameReturnRec *inGetFrameReturn)
+	{
+		reinterpret_cast<CAsyncRender *>(inCallbackRef)->Complete(
+			static_cast<uint32_t>(reinterpret_cast<uintptr_t>(inGetFrameReturn->asyncCompletionData)),
+			inRenderedFrame,
+			inGetFrameReturn->returnVal);
+	};
+
+protected:
+	ExportSettings				*m_mySettings;
+	SequenceRender_ParamsRec	m_renderParms;
+	PrTime						m_startTime;
+	PrTime						m_ticksPerFrame;
+};
+
+// RenderAndWriteVideoPipelined() - PULL-mode, after frame#0: Adobe renders up to <window> frames
+//   ahead (CAsyncRender puts them back in order), while this thread converts and encodes the
+//   frame in front, and disposes it.  A frame which Adobe renders in another PrPixelFormat than
+//   frame#0 (or fails to render asynchronously) is rendered again by RenderAndWriteVideoFrame(),
+//   which conforms it.
+static prMALError
+RenderAndWriteVideoPipelined(
+	exDoExportRec	*exportInfoP,
+	const uint32_t	window,
+	const PrTime	ticksPerFrame,
+	const uint32_t	first_frame,  // frame#, counted from exportInfoP->startTime
+	const uint32_t	frame_count,
+	float			videoProgress,
+	PrTime			*exportDuration,
+	uint32_t		&fallbacks)   // out: #frames rendered again (synchronously)
+{
+	csSDK_uint32				exID = exportInfoP->exporterPluginID;
+	ExportSettings				*mySettings = reinterpret_cast<ExportSettings *>(exportInfoP->privateData);
+	prMALError					result = malNoError;
+	SequenceRender_ParamsRec	renderParms;
+	CAsyncRender				pipeline;
+	asyncrender_frame_t			rendered;
+	uint32_t					next_frame = first_frame;
+
+	NVENC_get_render_params(exportInfoP, renderParms);
+	renderParms.inRequestedPixelFormatArray = &mySettings->rendered_PixelFormat0;
+	renderParms.inRequestedPixelFormatArrayCount = 1;
+
+	CPrAsyncRenderHost host(mySettings, renderParms, exportInfoP->startTime, ticksPerFrame);
+	mySettings->sequenceRenderSuite->SetAsyncRenderCompletionProc(
+		mySettings->videoRenderID, CPrAsyncRenderHost::CompletionProc, &pipeline);
+	pipeline.Begin(&host, first_frame, frame_count, window);
+
+	fallbacks = 0;
+	while (pipeline.Next(rendered)) {
+		const PrTime videoTime = host.GetTime(rendered.frame);
+		PrPixelFormat pixelformat = PrPixelFormat_Invalid;
+		++next_frame;
+
+		float progress = static_cast<float>(videoTime - exportInfoP->startTime) / static_cast<float>(*exportDuration) * videoProgress;
+		if (mySettings->audio_concurrent) // (the audio is rendered on its own thread: add its share)
+			progress += (1.0f - videoProgress) * mySettings->audio_progress_permille / 1000.0f;
+		result = mySettings->exportProgressSuite->UpdateProgressPercent(exID, progress);
+		if (result == suiteError_ExporterSuspended)
+		{
+			mySettings->exportProgressSuite->WaitForResume(exID);
+			result = malNoError;
+		}
+		else if (result == exportReturn_Abort)
+		{
+			// Pass back the actual length exported so far
+			*exportDuration = videoTime + ticksPerFrame - exportInfoP->startTime < *exportDuration ?
+				videoTime + ticksPerFrame - exportInfoP->startTime : *exportDuration;
+			pipeline.Release(rendered);
+			break;
+		}
+
+		// Concurrent export: the audio failed, stop the render-loop
+		if (mySettings->export_cancel) {
+			result = exportReturn_Abort;
+			pipeline.Release(rendered);
+			break;
+		}
+
+		if (rendered.status == malNoError && rendered.handle &&
+			!PrSuiteErrorFailed(mySettings->ppixSuite->GetPixelFormat(reinterpret_cast<PPixHand>(rendered.handle), &pixelformat)) &&
+			pixelformat == mySettings->rendered_PixelFormat0)
+		{
+			if (NVENC_encode_rendered_frame(reinterpret_cast<PPixHand>(rendered.handle), exportInfoP) != S_OK)
+				result = malUnknownError;
+		}
+		else {
+			++fallbacks;
+			result = RenderAndWriteVideoFrame(false, false, videoTime, exportInfoP);
+		}
+
+		// the frame is in the encoder's input-surface: dispose it, and queue the next render
+		pipeline.Release(rendered);
+		if (result != malNoError) {
+			mySettings->video_encode_fatalerr = true;// video-encode fatal failure
+			break;
+		}
+	}
+
+	// (Next() gave up on a frame that Adobe never delivered)
+	if (result == malNoError && next_frame < frame_count) {
+		mySettings->video_encode_fatalerr = true;
+		result = malUnknownError;
+	}
+
+	pipeline.End(); // (waits for the frames still being rendered)
+
+	// no completion may reach pipeline (or host) once this function returns: a frame End() gave
+	//   up on is disposed by the pipeline until the callback is gone
+	mySettings->sequenceRenderSuite->SetAsyncRenderCompletionProc(mySettings->videoRenderID, NULL, NULL);
+	pipeline.Detach();
+	return result;
+}
+
+// NVENC_spill_pass2() - two-pass export with the spill cache, after pass 1 (the only render):
+//   pass 2 plays back the frames pass 1 converted, then DoMultiPassExportLoop() renders the
+//   frames which didn't fit the disk budget.  ep = pass 1's render-params.
+static prMALError
+NVENC_spill_pass2(
+	exDoExportRec			*exportInfoP,
+	ExportLoopRenderParams	&ep,
+	const PrTime			ticksPerFrame)
+{
+	csSDK_uint32		exID = exportInfoP->exporterPluginID;
+	ExportSettings		*mySettings = reinterpret_cast<ExportSettings *>(exportInfoP->privateData);
+	CSpillCache			&spill = *mySettings->p_SpillCache;
+	prMALError			result;
+	EncodeFrameConfig	nvEncodeFrameConfig = { 0 };
+	exParamValues		temp_param;
+	std::wostringstream os;
+	prUTF16Char eventTitle[256];
+	prUTF16Char eventDesc[512];
+
+	result = NVENC_twopass_begin_pass2(exportInfoP);
+	if (result != malNoError)
+		return result;
+
+	const uint32_t recorded = spill.GetStats().frames;
+	const uint32_t frame_count = static_cast<uint32_t>((ep.inEndTime - ep.inStartTime) / ticksPerFrame);
+	spill.Rewind(); // (false: nothing was recorded, pass 2 renders everything again)
+
+	// the spilled frames only need the picture structure (frame or field-pair)
+	mySettings->exportParamSuite->GetParamValue(exID, 0, ParamID_FieldEncoding, &temp_param);
+	nvEncodeFrameConfig.fieldPicflag = (temp_param.value.intValue == NV_ENC_PARAMS_FRAME_FIELD_MODE_FRAME) ?
+		false :
+		true;
+	nvEncodeFrameConfig.topField = true;
+	if (nvEncodeFrameConfig.fieldPicflag) {
+		PrParam	seqFieldOrder;  // video-sequence field order (top_first/bottom_first)
+		mySettings->exportInfoSuite->GetExportSourceInfo(exID,
+			kExportInfo_VideoFieldType,
+			&seqFieldOrder);
+		nvEncodeFrameConfig.topField = (seqFieldOrder.mInt32 == prFieldsLowerFirst) ? false : true;
+	}
+
+	uint32_t played = 0;
+	while (spill.GetRemaining()) {
+		// (pass 1 reported the first half of the progress)
+		result = mySettings->exportProgressSuite->UpdateProgressPercent(exID,
+			0.5f + 0.5f * static_cast<float>(played) / static_cast<float>(frame_count ? frame_count : 1));
+		if (result == suiteError_ExporterSuspended) {
+			mySettings->exportProgressSuite->WaitForResume(exID);
+			result = malNoError;
+		}
+		else if (result == exportReturn_Abort)
+			return result;
+
+		// Concurrent export: the audio failed, stop the render-loop
+		if (mySettings->export_cancel)
+			return exportReturn_Abort;
+
+		NVENC_twopass_next_frame(mySettings);
+		const HRESULT hr = mySettings->p_NvEncoder->EncodeSpilledFrame(&nvEncodeFrameConfig);
+		if (hr == S_FALSE)
+			break; // (unreadable: rendered again, from this frame on)
+		if (hr != S_OK)
+			return malUnknownError;
+		++played;
+	}
+
+	const spill_stats_t &stats = spill.GetStats();
+	os << "Spill cache: pass 2 read " << played << " of " << recorded << " frames back ("
+		<< (stats.file_bytes >> 20) << " MB on disk, " << (stats.raw_bytes >> 20) << " MB uncompressed, "
+		<< static_cast<unsigned>(stats.write_us / 1000.0) << " ms to write, "
+		<< static_cast<unsigned>(stats.read_us / 1000.0) << " ms to read)" << std::endl;
+	if (stats.full || played < recorded)
+		os << "*** Spill cache: the frames from #" << played << " on didn't fit (or were unreadable), "
+			<< "and are rendered again" << std::endl;
+	copyConvertStringLiteralIntoUTF16(L"Note from NVENC_spill_pass2()", eventTitle);
+	copyConvertStringLiteralIntoUTF16(os.str().c_str(), eventDesc);
+	mySettings->exporterUtilitySuite->ReportEventA(
+		exID, PrSDKErrorSuite3::kEventTypeWarning, eventTitle, eventDesc
+		);
+
+	// the rest of pass 2 is rendered again
+	if (stats.full || played < recorded) {
+		ep.inStartTime += played * ticksPerFrame;
+		ep.inReservedProgressPreRender = 0.5f + 0.5f * static_cast<float>(played) / static_cast<float>(frame_count ? frame_count : 1);
+		ep.inReservedProgressPostRender = 0;
+		result = mySettings->exporterUtilitySuite->DoMultiPassExportLoop(
+			exID,
+			&ep,
+			1,
+			NVENC_export_FrameCompletionFunction,
+			(void *)exportInfoP
+			);
+	}
+
+	return result;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 prMALError RenderAndWriteAllVideo(
@@ -843,7 +1548,8 @@ prMALError RenderAndWriteAllVideo(
 	exParamValues	ticksPerFrame,
 		width,
 		height,
-		pixelAspectRatio;
+		pixelAspectRatio,
+		renderAhead;
 	PrTime			segmentEnd;
 	prtPlaycode		playcode;
 	//PrClipID		clipID;
@@ -1062,12 +1768,34 @@ prMALError RenderAndWriteAllVideo(
 					);
 			}
 
+			// Two-pass export: the first pass of DoMultiPassExportLoop() analyzes the sequence
+			// at constant QP.  (PULL-mode renders each frame once: single-pass.)
+			if (mySettings->twopass_stats_fp) {
+				if (UsePushMode && NVENC_twopass_begin(exportInfoP))
+					copyConvertStringLiteralIntoUTF16(L"Two-pass: pass 1 analyzes the sequence at constant QP", eventDesc);
+				else
+					copyConvertStringLiteralIntoUTF16(L"*** Two-pass needs PUSH-mode rendering and a bitrate, exporting in a single pass", eventDesc);
+				_SafeReportEvent(
+					exID, PrSDKErrorSuite3::kEventTypeWarning, eventTitle, eventDesc
+					);
+			}
+
 			// attempt to initialize the NVENC-hardware.  Failure could be due to an
 			// invalid/expired license-key.
 			result = NVENC_initialize_h264_session(mySettings->rendered_PixelFormat0, exportInfoP);
 			if (result != malNoError) {
 				break; // halt the render (abort the for-loop)
 			}
+
+			// ABR ladder: open the lower renditions' sessions (fed by every frame from now on)
+			if (mySettings->p_AbrLadder) {
+				os.str(L"");
+				NVENC_ladder_initialize_sessions(exportInfoP, os);
+				copyConvertStringLiteralIntoUTF16(os.str().c_str(), eventDesc);
+				_SafeReportEvent(
+					exID, PrSDKErrorSuite3::kEventTypeWarning, eventTitle, eventDesc
+					);
+			}
 		} // if ( is_frame0 )
 
 		if (is_frame0 && !UsePushMode) {
@@ -1098,6 +1826,45 @@ prMALError RenderAndWriteAllVideo(
 			}
 			else
 				encoded_at_least_1 = true;
+
+			// Render-ahead: Adobe renders the rest of the video asynchronously, several frames
+			// ahead of the encoder.  (With a window of 1, the for-loop renders frame by frame.)
+			mySettings->exportParamSuite->GetParamValue(exID, 0, ParamID_VideoCodec_RenderAhead, &renderAhead);
+			if (renderAhead.value.intValue > 1 && mySettings->sequenceRenderSuite->QueueAsyncVideoFrameRender) {
+				const uint32_t frame_count = static_cast<uint32_t>(
+					(exportInfoP->endTime - exportInfoP->startTime) / ticksPerFrame.value.timeValue);
+				uint32_t fallbacks = 0;
+
+				os.str(L"");
+				os << "Using PULL-mode render-ahead (" << renderAhead.value.intValue << " frames in flight)" << std::endl;
+				copyConvertStringLiteralIntoUTF16(os.str().c_str(), eventDesc);
+				_SafeReportEvent(
+					exID, PrSDKErrorSuite3::kEventTypeWarning, eventTitle, eventDesc
+					);
+
+				result = RenderAndWriteVideoPipelined(
+					exportInfoP,
+					static_cast<uint32_t>(renderAhead.value.intValue),
+					ticksPerFrame.value.timeValue,
+					1,			// (frame#0 is already encoded)
+					frame_count,
+					videoProgress,
+					exportDuration,
+					fallbacks
+					);
+
+				if (fallbacks) {
+					os.str(L"");
+					os << "*** Render-ahead: " << fallbacks << " frames came back in another PrPixelFormat, "
+						<< "and were rendered again (synchronously)" << std::endl;
+					copyConvertStringLiteralIntoUTF16(os.str().c_str(), eventDesc);
+					_SafeReportEvent(
+						exID, PrSDKErrorSuite3::kEventTypeWarning, eventTitle, eventDesc
+						);
+				}
+				is_frame0 = false;
+				break; // the whole video is rendered (or the render was halted)
+			}
 		} // if ( is_frame0 && !UsePushMode)
 
 		if (is_frame0 && UsePushMode) {
@@ -1148,14 +1915,23 @@ prMALError RenderAndWriteAllVideo(
 				exID, PrSDKErrorSuite3::kEventTypeWarning, eventTitle, eventDesc
 				);
 
+			// Two-pass with the spill cache: Adobe renders pass 1 only (the first half of the progress)
+			const bool spill = mySettings->p_SpillCache && mySettings->p_SpillCache->IsRecording();
+			if (spill)
+				ep.inReservedProgressPostRender = 0.5f;
+
 			result = mySettings->exporterUtilitySuite->DoMultiPassExportLoop(
 				exID,
 				&ep,
-				1,
+				(mySettings->twopass_pass && !spill) ? 2 : 1, // #passes (two-pass: analysis + final)
 				NVENC_export_FrameCompletionFunction, // callback to plugin's completion-Fn
 				(void *)exportInfoP
 				);
 
+			// ... and pass 2 reads the frames back from the spill cache
+			if (spill && result == malNoError && mySettings->twopass_pass == 1)
+				result = NVENC_spill_pass2(exportInfoP, ep, ticksPerFrame.value.timeValue);
+
 			// done with encoding the entire video-sequence!  Now break out of the for-loop()
 			encoded_at_least_1 = true;
 			is_frame0 = false;
@@ -1167,6 +1943,8 @@ prMALError RenderAndWriteAllVideo(
 		//  then each frame of the video-sequence executes the code below
 		//
 		progress = static_cast<float>(videoTime - exportInfoP->startTime) / static_cast<float>(*exportDuration) * videoProgress;
+		if (mySettings->audio_concurrent) // (the audio is rendered on its own thread: add its share)
+			progress += (1.0f - videoProgress) * mySettings->audio_progress_permille / 1000.0f;
 		result = mySettings->exportProgressSuite->UpdateProgressPercent(exID, progress);
 		if (result == suiteError_ExporterSuspended)
 		{
@@ -1181,6 +1959,12 @@ prMALError RenderAndWriteAllVideo(
 			break; // abort further video-processing (abort the for-loop)
 		}
 
+		// Concurrent export: the audio failed, stop the render-loop
+		if (mySettings->export_cancel) {
+			result = exportReturn_Abort;
+			break;
+		}
+
 		// clear the 'frame#0 flag' after rendering first frame
 		is_frame0 = false;
 	} // for
@@ -1196,6 +1980,26 @@ prMALError RenderAndWriteAllVideo(
 
 	// Free up GPU-resources allocated by NVENC
 	mySettings->p_NvEncoder->DestroyEncoder();
+	NVENC_ladder_close_sessions(mySettings, encoded_at_least_1);
+
+	// Two-pass export: how close pass 2 came to the planned size
+	if (mySettings->twopass_pass == 2) {
+		const CNvEncTwoPass &twopass = mySettings->p_NvEncoder->GetTwoPass();
+		os.str(L"");
+		os << "Two-pass: " << twopass.GetSegmentCount() << " segments, planned "
+			<< twopass.GetTargetBytes() << " bytes, coded " << twopass.GetCodedBytes() << " bytes" << std::endl;
+		copyConvertStringLiteralIntoUTF16(os.str().c_str(), eventDesc);
+		_SafeReportEvent(
+			exID, PrSDKErrorSuite3::kEventTypeWarning, eventTitle, eventDesc
+			);
+	}
+	else if (mySettings->twopass_pass == 1) // (aborted during pass 1)
+		mySettings->NvEncodeConfig = mySettings->twopass_NvEncodeConfig;
+	mySettings->p_NvEncoder->GetTwoPass().End();
+	mySettings->twopass_pass = 0;
+	mySettings->p_NvEncoder->SetSpillCache(NULL);
+	if (mySettings->p_SpillCache)
+		mySettings->p_SpillCache->End();
 
 	mySettings->sequenceRenderSuite->ReleaseVideoRenderer(exID, mySettings->videoRenderID);
 	return result;
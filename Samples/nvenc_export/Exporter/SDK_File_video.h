@@ -14,4 +14,20 @@ RenderAndWriteAllVideo(
 	PrTime			*exportDuration
 );
 
+// NVENC_open_ladder() - ABR ladder: plan the renditions below the export (rungs = #renditions,
+//   including the export itself), and create an encoder and an elementary-stream file for each.
+//   Their sessions are opened with the export's, on frame#0.  false = single rendition.
+bool
+NVENC_open_ladder(
+	const prUTF16Char outpath[], // output file path
+	ExportSettings * const mySettings,
+	const csSDK_uint32 rungs
+);
+
+// NVENC_close_ladder() - release the lower renditions' encoders and close their files
+void
+NVENC_close_ladder(
+	ExportSettings * const mySettings
+);
+
 #endif // SDK_FILE_VIDEO_H
\ No newline at end of file